@@ -0,0 +1,284 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#include <string.h>
+
+#include "edf_admission.h"
+
+/*-----------------------------------------------------------*/
+
+/* Returns ceil( xNumerator / xDenominator ) in 32.32 fixed point. */
+static uint64_t prvRatio( EDFTime_t xNumerator, EDFTime_t xDenominator )
+{
+    return ( ( xNumerator << 32 ) + xDenominator - 1 ) / xDenominator;
+}
+/*-----------------------------------------------------------*/
+
+static int prvValid( const EDFTask_t * pxTask )
+{
+    return ( pxTask->xC != 0 ) && ( pxTask->xD != 0 ) && ( pxTask->xT != 0 ) &&
+           ( pxTask->xC <= UINT32_MAX ) && ( pxTask->xD <= UINT32_MAX ) && ( pxTask->xT <= UINT32_MAX );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvDensity( const EDFTask_t * pxTask )
+{
+    return prvRatio( pxTask->xC, ( pxTask->xD < pxTask->xT ) ? pxTask->xD : pxTask->xT );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAdd( EDFAdmission_t * pxAdmission, const EDFTask_t * pxTask )
+{
+    pxAdmission->xTasks[ pxAdmission->xCount++ ] = *pxTask;
+    pxAdmission->ullUtilisation += prvRatio( pxTask->xC, pxTask->xT );
+    pxAdmission->ullDensity += prvDensity( pxTask );
+
+    if( pxTask->xD < pxTask->xT )
+    {
+        pxAdmission->xConstrained++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vEDFAdmissionInit( EDFAdmission_t * pxAdmission )
+{
+    memset( pxAdmission, 0, sizeof( *pxAdmission ) );
+}
+/*-----------------------------------------------------------*/
+
+EDFResult_t xEDFAdmissionTest( EDFAdmission_t * pxAdmission,
+                               const EDFTask_t * pxTask,
+                               int xAdd,
+                               EDFAdmissionDecision_t * pxDecision )
+{
+    EDFAnalysis_t xAnalysis;
+    size_t xCount = pxAdmission->xCount + 1;
+    int xConstrained;
+
+    pxDecision->eResult = eEDFSchedulable;
+    pxDecision->eMethod = eEDFAdmitByUtilisation;
+    pxDecision->ullUtilisation = 0;
+    pxDecision->ullDensity = 0;
+
+    if( pxAdmission->xCount == edfADMISSION_MAX_TASKS )
+    {
+        pxDecision->eResult = eEDFInvalidTask;
+        pxDecision->eMethod = eEDFAdmitFull;
+        return pxDecision->eResult;
+    }
+
+    if( prvValid( pxTask ) == 0 )
+    {
+        pxDecision->eResult = eEDFInvalidTask;
+        return pxDecision->eResult;
+    }
+
+    pxDecision->ullUtilisation = pxAdmission->ullUtilisation + prvRatio( pxTask->xC, pxTask->xT );
+    pxDecision->ullDensity = pxAdmission->ullDensity + prvDensity( pxTask );
+    xConstrained = ( pxAdmission->xConstrained != 0 ) || ( pxTask->xD < pxTask->xT );
+
+    /* Each term is rounded up by less than one unit, so a sum more than
+    xCount units over 1 is over 1 exactly. */
+    if( pxDecision->ullUtilisation > edfADMISSION_ONE + xCount )
+    {
+        pxDecision->eResult = eEDFUtilisationExceeded;
+    }
+    else if( ( xConstrained == 0 ) && ( pxDecision->ullUtilisation <= edfADMISSION_ONE ) )
+    {
+        pxDecision->eMethod = eEDFAdmitByUtilisation;
+    }
+    else if( pxDecision->ullDensity <= edfADMISSION_ONE )
+    {
+        pxDecision->eMethod = eEDFAdmitByDensity;
+    }
+    else
+    {
+        /* The spare entry holds the candidate while the set is analysed. */
+        pxDecision->eMethod = eEDFAdmitByDemand;
+        pxAdmission->xTasks[ pxAdmission->xCount ] = *pxTask;
+        pxDecision->eResult = xEDFAnalyse( pxAdmission->xTasks, xCount, &xAnalysis );
+    }
+
+    if( ( pxDecision->eResult == eEDFSchedulable ) && ( xAdd != 0 ) )
+    {
+        prvAdd( pxAdmission, pxTask );
+    }
+
+    return pxDecision->eResult;
+}
+/*-----------------------------------------------------------*/
+
+int lEDFAdmissionForce( EDFAdmission_t * pxAdmission, const EDFTask_t * pxTask )
+{
+    if( ( pxAdmission->xCount == edfADMISSION_MAX_TASKS ) || ( prvValid( pxTask ) == 0 ) )
+    {
+        return -1;
+    }
+
+    prvAdd( pxAdmission, pxTask );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+int lEDFAdmissionRemove( EDFAdmission_t * pxAdmission, const EDFTask_t * pxTask )
+{
+    size_t x;
+
+    for( x = 0; x < pxAdmission->xCount; x++ )
+    {
+        if( ( pxAdmission->xTasks[ x ].xC == pxTask->xC ) &&
+            ( pxAdmission->xTasks[ x ].xD == pxTask->xD ) &&
+            ( pxAdmission->xTasks[ x ].xT == pxTask->xT ) )
+        {
+            /* Each task's terms are computed the same way when added and
+            removed, so the sums return exactly to their earlier values. */
+            pxAdmission->ullUtilisation -= prvRatio( pxTask->xC, pxTask->xT );
+            pxAdmission->ullDensity -= prvDensity( pxTask );
+
+            if( pxTask->xD < pxTask->xT )
+            {
+                pxAdmission->xConstrained--;
+            }
+
+            pxAdmission->xTasks[ x ] = pxAdmission->xTasks[ --pxAdmission->xCount ];
+
+            return 0;
+        }
+    }
+
+    return -1;
+}
+/*-----------------------------------------------------------*/
+
+size_t xEDFAdmissionPartition( EDFAdmission_t * pxCores,
+                               size_t xCores,
+                               const EDFTask_t * pxTasks,
+                               size_t xTaskCount,
+                               int * plCore )
+{
+    uint8_t ucOrder[ edfPARTITION_MAX_TASKS ];
+    EDFAdmissionDecision_t xDecision;
+    size_t xUnplaced = 0, x, y, xCore;
+    uint8_t ucTask;
+
+    /* Tasks beyond the limit are left unplaced. */
+    for( x = edfPARTITION_MAX_TASKS; x < xTaskCount; x++ )
+    {
+        plCore[ x ] = -1;
+        xUnplaced++;
+    }
+
+    if( xTaskCount > edfPARTITION_MAX_TASKS )
+    {
+        xTaskCount = edfPARTITION_MAX_TASKS;
+    }
+
+    /* Insertion sort by decreasing C / T, comparing C1 * T2 with C2 * T1,
+    which cannot overflow for 32 bit values. Equal utilisations keep their
+    order. */
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        ucTask = ( uint8_t ) x;
+
+        for( y = x; y > 0; y-- )
+        {
+            if( pxTasks[ ucOrder[ y - 1 ] ].xC * pxTasks[ ucTask ].xT >= pxTasks[ ucTask ].xC * pxTasks[ ucOrder[ y - 1 ] ].xT )
+            {
+                break;
+            }
+
+            ucOrder[ y ] = ucOrder[ y - 1 ];
+        }
+
+        ucOrder[ y ] = ucTask;
+    }
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        ucTask = ucOrder[ x ];
+        plCore[ ucTask ] = -1;
+
+        for( xCore = 0; xCore < xCores; xCore++ )
+        {
+            if( xEDFAdmissionTest( &pxCores[ xCore ], &pxTasks[ ucTask ], 1, &xDecision ) == eEDFSchedulable )
+            {
+                plCore[ ucTask ] = ( int ) xCore;
+                break;
+            }
+        }
+
+        if( plCore[ ucTask ] < 0 )
+        {
+            xUnplaced++;
+        }
+    }
+
+    return xUnplaced;
+}
+/*-----------------------------------------------------------*/
+
+EDFResult_t xEDFAdmissionGlobalTest( const EDFTask_t * pxTasks,
+                                     size_t xTaskCount,
+                                     size_t xCores )
+{
+    uint64_t ullDensity = 0, ullMaxDensity = 0, ullTaskDensity;
+    size_t x;
+
+    if( xCores == 0 )
+    {
+        return eEDFInvalidTask;
+    }
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( prvValid( &pxTasks[ x ] ) == 0 )
+        {
+            return eEDFInvalidTask;
+        }
+
+        ullTaskDensity = prvDensity( &pxTasks[ x ] );
+        ullDensity += ullTaskDensity;
+
+        if( ullTaskDensity > ullMaxDensity )
+        {
+            ullMaxDensity = ullTaskDensity;
+        }
+    }
+
+    /* A density above 1 can never meet its deadline. */
+    if( ullMaxDensity > edfADMISSION_ONE )
+    {
+        return eEDFDemandExceeded;
+    }
+
+    if( ullDensity + ( ( xCores - 1 ) * ullMaxDensity ) <= ( xCores * edfADMISSION_ONE ) )
+    {
+        return eEDFSchedulable;
+    }
+
+    return eEDFDemandExceeded;
+}
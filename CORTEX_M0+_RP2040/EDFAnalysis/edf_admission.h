@@ -0,0 +1,146 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef EDF_ADMISSION_H
+#define EDF_ADMISSION_H
+
+/*
+ * Online admission control for EDF task sets that change at run time.
+ *
+ * The admitted tasks are kept with running sums of their utilisation C/T
+ * and density C/min(D, T), held as 32.32 fixed point and rounded up so
+ * that they never understate the load. A new task is tested against them
+ * as follows:
+ *
+ *  - if the new utilisation sum is clearly over 1 it is rejected,
+ *  - if every task has D >= T, the set is schedulable exactly when the
+ *    utilisation is at most 1, so the sum decides,
+ *  - otherwise a density sum of at most 1 is enough to admit it,
+ *  - otherwise, or when the sums are too close to 1 for the rounding to
+ *    decide, the exact processor demand test in edf_analysis.c decides.
+ *
+ * Only the last case costs more than a few operations, and it runs in time
+ * bounded by edfMAX_BOUND rather than in constant time. Nothing here
+ * allocates memory or uses stdio, and it does no locking, so callers that
+ * share an EDFAdmission_t between tasks must serialise access.
+ */
+
+#include "edf_analysis.h"
+
+#ifndef edfADMISSION_MAX_TASKS
+    #define edfADMISSION_MAX_TASKS    16
+#endif
+
+/* 1.0 in the 32.32 fixed point used for the sums. */
+#define edfADMISSION_ONE              ( ( uint64_t ) 1 << 32 )
+
+typedef enum
+{
+    eEDFAdmitByUtilisation = 0,     /* D >= T for every task, U <= 1. */
+    eEDFAdmitByDensity,             /* Sum of C / min(D, T) <= 1. */
+    eEDFAdmitByDemand,              /* Exact processor demand test. */
+    eEDFAdmitFull                   /* No room for another task. */
+} EDFAdmissionMethod_t;
+
+typedef struct EDF_ADMISSION
+{
+    EDFTask_t xTasks[ edfADMISSION_MAX_TASKS + 1 ];  /* One spare for the candidate. */
+    size_t xCount;
+    size_t xConstrained;            /* Tasks with D < T. */
+    uint64_t ullUtilisation;        /* 32.32 fixed point, rounded up. */
+    uint64_t ullDensity;            /* 32.32 fixed point, rounded up. */
+} EDFAdmission_t;
+
+typedef struct EDF_ADMISSION_DECISION
+{
+    EDFResult_t eResult;            /* eEDFSchedulable if admitted. */
+    EDFAdmissionMethod_t eMethod;   /* The test that decided. */
+    uint64_t ullUtilisation;        /* Sums including the candidate. */
+    uint64_t ullDensity;
+} EDFAdmissionDecision_t;
+
+/*
+ * Empties pxAdmission.
+ */
+void vEDFAdmissionInit( EDFAdmission_t * pxAdmission );
+
+/*
+ * Tests whether pxTask can join the admitted tasks and, if it can and xAdd
+ * is non-zero, adds it. C, D and T must each fit in 32 bits. Returns
+ * pxDecision->eResult, which is eEDFSchedulable if the task was admitted,
+ * or eEDFInvalidTask with eMethod set to eEDFAdmitFull if the table is
+ * full.
+ */
+EDFResult_t xEDFAdmissionTest( EDFAdmission_t * pxAdmission,
+                               const EDFTask_t * pxTask,
+                               int xAdd,
+                               EDFAdmissionDecision_t * pxDecision );
+
+/*
+ * Adds pxTask without testing it, for example when the caller's policy is
+ * to record overload rather than refuse it. Returns 0, or -1 if the table
+ * is full or the task is invalid.
+ */
+int lEDFAdmissionForce( EDFAdmission_t * pxAdmission, const EDFTask_t * pxTask );
+
+/*
+ * Removes one admitted task with the same C, D and T as pxTask. Returns 0,
+ * or -1 if there is none.
+ */
+int lEDFAdmissionRemove( EDFAdmission_t * pxAdmission, const EDFTask_t * pxTask );
+
+/*
+ * Assigns tasks to cores by first fit decreasing: in order of decreasing
+ * utilisation, each task goes to the lowest numbered core whose admission
+ * test accepts it, and is added to that core's pxCores entry. The entries
+ * may already hold tasks. plCore[ x ] is set to the core of pxTasks[ x ],
+ * or to -1 if no core accepts it. Returns the number of tasks that could
+ * not be placed. At most edfPARTITION_MAX_TASKS tasks may be passed.
+ */
+size_t xEDFAdmissionPartition( EDFAdmission_t * pxCores,
+                               size_t xCores,
+                               const EDFTask_t * pxTasks,
+                               size_t xTaskCount,
+                               int * plCore );
+
+/*
+ * Sufficient test for global EDF on xCores identical cores, the density
+ * bound of Goossens, Funk and Baruah extended to constrained deadlines:
+ * the set is schedulable if the sum of the densities is at most
+ * xCores - (xCores - 1) * the largest density. Unlike the single core
+ * tests it is not exact, so a set it rejects may still be schedulable.
+ * Returns eEDFSchedulable, eEDFDemandExceeded if the bound is not met, or
+ * eEDFInvalidTask.
+ */
+EDFResult_t xEDFAdmissionGlobalTest( const EDFTask_t * pxTasks,
+                                     size_t xTaskCount,
+                                     size_t xCores );
+
+#ifndef edfPARTITION_MAX_TASKS
+    #define edfPARTITION_MAX_TASKS    64
+#endif
+
+#endif /* EDF_ADMISSION_H */
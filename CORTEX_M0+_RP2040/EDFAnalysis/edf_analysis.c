@@ -0,0 +1,290 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#include "edf_analysis.h"
+
+/* Utilisations within this distance of 1 are treated as exactly 1. */
+#define edfUTILISATION_EPSILON      ( 1e-12 )
+
+/* Iteration limit for the busy period calculation. */
+#define edfMAX_BUSY_ITERATIONS      ( 1000000UL )
+
+/*-----------------------------------------------------------*/
+
+EDFTime_t xEDFDemandBound( const EDFTask_t * pxTasks, size_t xTaskCount, EDFTime_t xTime )
+{
+    EDFTime_t xDemand = 0;
+    size_t x;
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( xTime >= pxTasks[ x ].xD )
+        {
+            xDemand += ( ( ( xTime - pxTasks[ x ].xD ) / pxTasks[ x ].xT ) + 1 ) * pxTasks[ x ].xC;
+        }
+    }
+
+    return xDemand;
+}
+/*-----------------------------------------------------------*/
+
+EDFTime_t xEDFBusyPeriod( const EDFTask_t * pxTasks, size_t xTaskCount )
+{
+    EDFTime_t xLength = 0, xNext;
+    uint32_t ulIterations;
+    size_t x;
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        xLength += pxTasks[ x ].xC;
+    }
+
+    for( ulIterations = 0; ulIterations < edfMAX_BUSY_ITERATIONS; ulIterations++ )
+    {
+        xNext = 0;
+
+        for( x = 0; x < xTaskCount; x++ )
+        {
+            xNext += ( ( xLength + pxTasks[ x ].xT - 1 ) / pxTasks[ x ].xT ) * pxTasks[ x ].xC;
+        }
+
+        if( xNext == xLength )
+        {
+            return xLength;
+        }
+
+        if( xNext > edfMAX_BOUND )
+        {
+            break;
+        }
+
+        xLength = xNext;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the latest absolute deadline strictly before xTime, or 0 if
+there is none. */
+static EDFTime_t prvDeadlineBefore( const EDFTask_t * pxTasks, size_t xTaskCount, EDFTime_t xTime )
+{
+    EDFTime_t xLatest = 0, xDeadline;
+    size_t x;
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( xTime > pxTasks[ x ].xD )
+        {
+            xDeadline = pxTasks[ x ].xD + ( ( xTime - pxTasks[ x ].xD - 1 ) / pxTasks[ x ].xT ) * pxTasks[ x ].xT;
+
+            if( xDeadline > xLatest )
+            {
+                xLatest = xDeadline;
+            }
+        }
+    }
+
+    return xLatest;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the earliest absolute deadline strictly after xTime. */
+static EDFTime_t prvDeadlineAfter( const EDFTask_t * pxTasks, size_t xTaskCount, EDFTime_t xTime )
+{
+    EDFTime_t xEarliest = ~( EDFTime_t ) 0, xDeadline;
+    size_t x;
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( xTime < pxTasks[ x ].xD )
+        {
+            xDeadline = pxTasks[ x ].xD;
+        }
+        else
+        {
+            xDeadline = pxTasks[ x ].xD + ( ( ( xTime - pxTasks[ x ].xD ) / pxTasks[ x ].xT ) + 1 ) * pxTasks[ x ].xT;
+        }
+
+        if( xDeadline < xEarliest )
+        {
+            xEarliest = xDeadline;
+        }
+    }
+
+    return xEarliest;
+}
+/*-----------------------------------------------------------*/
+
+EDFResult_t xEDFAnalyse( const EDFTask_t * pxTasks, size_t xTaskCount, EDFAnalysis_t * pxAnalysis )
+{
+    EDFTime_t xDMin = ~( EDFTime_t ) 0, xDMax = 0, xTime, xDemand;
+    double dSlackSum = 0.0, dBound;
+    size_t x;
+
+    pxAnalysis->eResult = eEDFSchedulable;
+    pxAnalysis->dUtilisation = 0.0;
+    pxAnalysis->xBusyPeriod = 0;
+    pxAnalysis->xBound = 0;
+    pxAnalysis->xFailTime = 0;
+    pxAnalysis->xFailDemand = 0;
+    pxAnalysis->ulPointsChecked = 0;
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( ( pxTasks[ x ].xC == 0 ) || ( pxTasks[ x ].xD == 0 ) || ( pxTasks[ x ].xT == 0 ) )
+        {
+            pxAnalysis->eResult = eEDFInvalidTask;
+            return pxAnalysis->eResult;
+        }
+
+        pxAnalysis->dUtilisation += ( double ) pxTasks[ x ].xC / ( double ) pxTasks[ x ].xT;
+        dSlackSum += ( ( double ) pxTasks[ x ].xT - ( double ) pxTasks[ x ].xD ) * ( double ) pxTasks[ x ].xC / ( double ) pxTasks[ x ].xT;
+
+        if( pxTasks[ x ].xD < xDMin )
+        {
+            xDMin = pxTasks[ x ].xD;
+        }
+
+        if( pxTasks[ x ].xD > xDMax )
+        {
+            xDMax = pxTasks[ x ].xD;
+        }
+    }
+
+    if( xTaskCount == 0 )
+    {
+        return pxAnalysis->eResult;
+    }
+
+    if( pxAnalysis->dUtilisation > 1.0 + edfUTILISATION_EPSILON )
+    {
+        pxAnalysis->eResult = eEDFUtilisationExceeded;
+        return pxAnalysis->eResult;
+    }
+
+    /* The busy period bounds L for any U <= 1. */
+    pxAnalysis->xBusyPeriod = xEDFBusyPeriod( pxTasks, xTaskCount );
+
+    if( pxAnalysis->xBusyPeriod == 0 )
+    {
+        pxAnalysis->eResult = eEDFBoundTooLarge;
+        return pxAnalysis->eResult;
+    }
+
+    pxAnalysis->xBound = pxAnalysis->xBusyPeriod;
+
+    /* When U < 1 the bound of Baruah et al. may be tighter. */
+    if( pxAnalysis->dUtilisation < 1.0 - edfUTILISATION_EPSILON )
+    {
+        dBound = dSlackSum / ( 1.0 - pxAnalysis->dUtilisation );
+
+        if( dBound < ( double ) xDMax )
+        {
+            dBound = ( double ) xDMax;
+        }
+
+        /* Rounded up so that the bound is never too small. */
+        if( dBound + 1.0 < ( double ) pxAnalysis->xBound )
+        {
+            pxAnalysis->xBound = ( EDFTime_t ) dBound + 1;
+        }
+    }
+
+    /* Quick Processor-demand Analysis: walk backwards from L, jumping
+    straight to dbf(t) whenever it is below t. */
+    xTime = prvDeadlineBefore( pxTasks, xTaskCount, pxAnalysis->xBound );
+    xDemand = xEDFDemandBound( pxTasks, xTaskCount, xTime );
+    pxAnalysis->ulPointsChecked++;
+
+    while( ( xDemand <= xTime ) && ( xDemand > xDMin ) )
+    {
+        if( xDemand < xTime )
+        {
+            xTime = xDemand;
+        }
+        else
+        {
+            xTime = prvDeadlineBefore( pxTasks, xTaskCount, xTime );
+        }
+
+        xDemand = xEDFDemandBound( pxTasks, xTaskCount, xTime );
+        pxAnalysis->ulPointsChecked++;
+    }
+
+    if( xDemand <= xDMin )
+    {
+        return pxAnalysis->eResult;
+    }
+
+    /* dbf(t) > t at the point QPA stopped. Find the earliest such
+    deadline for the report, which is never after it. */
+    pxAnalysis->eResult = eEDFDemandExceeded;
+    pxAnalysis->xFailTime = xTime;
+    pxAnalysis->xFailDemand = xDemand;
+
+    for( xTime = prvDeadlineAfter( pxTasks, xTaskCount, 0 );
+         xTime < pxAnalysis->xFailTime;
+         xTime = prvDeadlineAfter( pxTasks, xTaskCount, xTime ) )
+    {
+        xDemand = xEDFDemandBound( pxTasks, xTaskCount, xTime );
+        pxAnalysis->ulPointsChecked++;
+
+        if( xDemand > xTime )
+        {
+            pxAnalysis->xFailTime = xTime;
+            pxAnalysis->xFailDemand = xDemand;
+            break;
+        }
+    }
+
+    return pxAnalysis->eResult;
+}
+/*-----------------------------------------------------------*/
+
+const char * pcEDFResultString( EDFResult_t eResult )
+{
+    switch( eResult )
+    {
+        case eEDFSchedulable:
+            return "schedulable";
+
+        case eEDFUtilisationExceeded:
+            return "utilisation exceeds 1";
+
+        case eEDFDemandExceeded:
+            return "processor demand exceeds time available";
+
+        case eEDFInvalidTask:
+            return "task with zero C, D or T";
+
+        case eEDFBoundTooLarge:
+            return "busy period too long to analyse";
+
+        default:
+            return "unknown";
+    }
+}
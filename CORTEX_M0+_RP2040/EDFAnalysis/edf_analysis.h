@@ -0,0 +1,115 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef EDF_ANALYSIS_H
+#define EDF_ANALYSIS_H
+
+/*
+ * Processor demand analysis for sporadic tasks scheduled by preemptive EDF on
+ * one core.
+ *
+ * A task is described the same way xTaskCreateEDF() describes it: a worst
+ * case execution time C, a relative deadline D and a period T. All three are
+ * in the same (arbitrary) time unit. The analysis is exact: a set is reported
+ * schedulable if and only if no job can miss its deadline.
+ *
+ * The demand bound function
+ *
+ *     dbf(t) = sum over tasks of max(0, floor((t - D) / T) + 1) * C
+ *
+ * is checked at absolute deadlines up to a bound L, the smaller of the length
+ * of the synchronous busy period and, when U < 1, the bound
+ * max(Dmax, sum((T - D) * C / T) / (1 - U)). Quick Processor-demand Analysis
+ * (Zhang and Burns, 2009) is used so that only a few points are checked for
+ * most sets.
+ *
+ * Nothing here allocates memory or uses stdio, so it may be built into
+ * firmware as well as host tools.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint64_t EDFTime_t;
+
+typedef struct EDF_TASK
+{
+    EDFTime_t xC;       /* Worst case execution time. */
+    EDFTime_t xD;       /* Relative deadline. */
+    EDFTime_t xT;       /* Period, or minimum inter-arrival time. */
+} EDFTask_t;
+
+typedef enum
+{
+    eEDFSchedulable = 0,
+    eEDFUtilisationExceeded,    /* U > 1. */
+    eEDFDemandExceeded,         /* dbf(t) > t for some t <= L. */
+    eEDFInvalidTask,            /* A task has C, D or T of zero. */
+    eEDFBoundTooLarge           /* The busy period did not converge below the limit. */
+} EDFResult_t;
+
+typedef struct EDF_ANALYSIS
+{
+    EDFResult_t eResult;
+    double dUtilisation;
+    EDFTime_t xBusyPeriod;      /* Length of the synchronous busy period, if computed. */
+    EDFTime_t xBound;           /* L, the last point that needed checking. */
+    EDFTime_t xFailTime;        /* For eEDFDemandExceeded, the earliest t with dbf(t) > t. */
+    EDFTime_t xFailDemand;      /* dbf(xFailTime). */
+    uint32_t ulPointsChecked;   /* Number of dbf evaluations. */
+} EDFAnalysis_t;
+
+/*
+ * Upper limit on the busy period and on L. Sets whose bound would exceed it
+ * are reported as eEDFBoundTooLarge rather than analysed.
+ */
+#ifndef edfMAX_BOUND
+    #define edfMAX_BOUND    ( ( EDFTime_t ) 1 << 48 )
+#endif
+
+/*
+ * Returns the total demand of jobs that are both released and due in [0, t]
+ * when every task releases a job at time 0 and then as often as it may.
+ */
+EDFTime_t xEDFDemandBound( const EDFTask_t * pxTasks, size_t xTaskCount, EDFTime_t xTime );
+
+/*
+ * Returns the length of the synchronous busy period, or 0 if it does not
+ * converge below edfMAX_BOUND.
+ */
+EDFTime_t xEDFBusyPeriod( const EDFTask_t * pxTasks, size_t xTaskCount );
+
+/*
+ * Runs the analysis and fills in pxAnalysis. Returns pxAnalysis->eResult.
+ */
+EDFResult_t xEDFAnalyse( const EDFTask_t * pxTasks, size_t xTaskCount, EDFAnalysis_t * pxAnalysis );
+
+/*
+ * Returns a short description of eResult.
+ */
+const char * pcEDFResultString( EDFResult_t eResult );
+
+#endif /* EDF_ANALYSIS_H */
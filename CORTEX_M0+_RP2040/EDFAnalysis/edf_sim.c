@@ -0,0 +1,558 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#include "edf_sim.h"
+
+#define simNO_TASK    ( ( size_t ) -1 )
+
+typedef struct SIM_TASK_STATE
+{
+    int lActive;                /* A job is released and unfinished. */
+    uint32_t ulJob;             /* Number of the current or next job. */
+    EDFTime_t xNextRelease;     /* Nominal release of the next job. */
+    EDFTime_t xRemaining;       /* Work left in the current job. */
+    EDFSimJob_t xJob;           /* The current job. */
+    int lStarted;
+} SimTaskState_t;
+
+/*-----------------------------------------------------------*/
+
+static void prvRelease( const EDFTask_t * pxTask, SimTaskState_t * pxState, size_t xTask, EDFTime_t xNow )
+{
+    pxState->lActive = 1;
+    pxState->lStarted = 0;
+    pxState->xRemaining = pxTask->xC;
+    pxState->xJob.xTask = xTask;
+    pxState->xJob.ulJob = pxState->ulJob;
+    pxState->xJob.xRelease = pxState->xNextRelease;
+    pxState->xJob.xDeadline = pxState->xNextRelease + pxTask->xD;
+    pxState->xJob.xReady = xNow;
+    pxState->xNextRelease += pxTask->xT;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the task whose job should run. The running task keeps the
+processor unless another job has a strictly earlier deadline. */
+static size_t prvSelect( const SimTaskState_t * pxStates, size_t xTaskCount, size_t xRunning )
+{
+    size_t xBest = simNO_TASK, x;
+
+    if( ( xRunning != simNO_TASK ) && ( pxStates[ xRunning ].lActive != 0 ) )
+    {
+        xBest = xRunning;
+    }
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( pxStates[ x ].lActive == 0 )
+        {
+            continue;
+        }
+
+        if( ( xBest == simNO_TASK ) ||
+            ( pxStates[ x ].xJob.xDeadline < pxStates[ xBest ].xJob.xDeadline ) ||
+            ( ( pxStates[ x ].xJob.xDeadline == pxStates[ xBest ].xJob.xDeadline ) &&
+              ( xBest != xRunning ) &&
+              ( pxStates[ x ].xJob.xRelease < pxStates[ xBest ].xJob.xRelease ) ) )
+        {
+            xBest = x;
+        }
+    }
+
+    return xBest;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecord( const EDFSimJob_t * pxJob,
+                       EDFSimStats_t * pxStats,
+                       EDFSimTaskStats_t * pxTaskStats,
+                       EDFSimJobCallback_t pxCallback,
+                       void * pvContext )
+{
+    pxStats->ulJobs++;
+
+    if( pxJob->lMissed != 0 )
+    {
+        if( ( pxStats->ulMisses == 0 ) || ( pxJob->xDeadline < pxStats->xFirstMiss ) )
+        {
+            pxStats->xFirstMiss = pxJob->xDeadline;
+        }
+
+        pxStats->ulMisses++;
+    }
+
+    if( pxTaskStats != NULL )
+    {
+        pxTaskStats[ pxJob->xTask ].ulJobs++;
+        pxTaskStats[ pxJob->xTask ].xTotalResponse += pxJob->xResponse;
+        pxTaskStats[ pxJob->xTask ].xTotalJitter += pxJob->xReady - pxJob->xRelease;
+
+        if( pxJob->lMissed != 0 )
+        {
+            pxTaskStats[ pxJob->xTask ].ulMisses++;
+        }
+
+        if( pxJob->xResponse > pxTaskStats[ pxJob->xTask ].xWorstResponse )
+        {
+            pxTaskStats[ pxJob->xTask ].xWorstResponse = pxJob->xResponse;
+        }
+
+        if( pxJob->xReady - pxJob->xRelease > pxTaskStats[ pxJob->xTask ].xWorstJitter )
+        {
+            pxTaskStats[ pxJob->xTask ].xWorstJitter = pxJob->xReady - pxJob->xRelease;
+        }
+    }
+
+    if( pxCallback != NULL )
+    {
+        pxCallback( pxJob, pvContext );
+    }
+}
+/*-----------------------------------------------------------*/
+
+int lEDFSimulate( const EDFTask_t * pxTasks,
+                  size_t xTaskCount,
+                  const EDFSimConfig_t * pxConfig,
+                  EDFSimJobCallback_t pxCallback,
+                  void * pvContext,
+                  EDFSimStats_t * pxStats,
+                  EDFSimTaskStats_t * pxTaskStats )
+{
+    SimTaskState_t xStates[ edfSIM_MAX_TASKS ];
+    SimTaskState_t * pxState;
+    EDFTime_t xNow = 0, xNextTick = 0, xNextAlarm, xOverhead = 0, xSlice, xUsed, xWake, xStop;
+    EDFTime_t xTickPeriod = pxConfig->xTickPeriod, xHorizon = pxConfig->xHorizon;
+    size_t xRunning = simNO_TASK, xLoaded = simNO_TASK, xNext, x;
+
+    if( ( xTaskCount > edfSIM_MAX_TASKS ) || ( xTickPeriod == 0 ) ||
+        ( pxConfig->xTickOverhead >= xTickPeriod ) )
+    {
+        return -1;
+    }
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( ( pxTasks[ x ].xC == 0 ) || ( pxTasks[ x ].xD == 0 ) || ( pxTasks[ x ].xT == 0 ) )
+        {
+            return -1;
+        }
+
+        xStates[ x ].lActive = 0;
+        xStates[ x ].ulJob = 0;
+        xStates[ x ].xNextRelease = 0;
+
+        if( pxTaskStats != NULL )
+        {
+            pxTaskStats[ x ].ulJobs = 0;
+            pxTaskStats[ x ].ulMisses = 0;
+            pxTaskStats[ x ].xWorstResponse = 0;
+            pxTaskStats[ x ].xTotalResponse = 0;
+            pxTaskStats[ x ].xWorstJitter = 0;
+            pxTaskStats[ x ].xTotalJitter = 0;
+        }
+    }
+
+    pxStats->ulJobs = 0;
+    pxStats->ulMisses = 0;
+    pxStats->ulSwitches = 0;
+    pxStats->ulTicks = 0;
+    pxStats->xFirstMiss = 0;
+    pxStats->xBusyTime = 0;
+
+    while( xNow < xHorizon )
+    {
+        /* With alarm releases the next release is armed on the timer. */
+        xNextAlarm = ~( EDFTime_t ) 0;
+
+        if( pxConfig->lAlarmReleases != 0 )
+        {
+            for( x = 0; x < xTaskCount; x++ )
+            {
+                if( ( xStates[ x ].lActive == 0 ) && ( xStates[ x ].xNextRelease < xNextAlarm ) )
+                {
+                    xNextAlarm = xStates[ x ].xNextRelease;
+                }
+            }
+
+            if( xNow == xNextAlarm )
+            {
+                xOverhead += pxConfig->xAlarmOverhead;
+
+                for( x = 0; x < xTaskCount; x++ )
+                {
+                    if( ( xStates[ x ].lActive == 0 ) && ( xStates[ x ].xNextRelease <= xNow ) )
+                    {
+                        prvRelease( &pxTasks[ x ], &xStates[ x ], x, xNow );
+                    }
+                }
+
+                xRunning = prvSelect( xStates, xTaskCount, xRunning );
+
+                if( ( xRunning != simNO_TASK ) && ( xRunning != xLoaded ) )
+                {
+                    pxStats->ulSwitches++;
+                    xOverhead += pxConfig->xSwitchOverhead;
+                    xLoaded = xRunning;
+                }
+
+                continue;
+            }
+        }
+
+        if( xNow == xNextTick )
+        {
+            /* The tick interrupt releases every job that is due, then
+            preempts the running job if one of them has an earlier
+            deadline. */
+            pxStats->ulTicks++;
+            xOverhead += pxConfig->xTickOverhead;
+            xNextTick += xTickPeriod;
+
+            for( x = 0; x < xTaskCount; x++ )
+            {
+                if( ( xStates[ x ].lActive == 0 ) && ( xStates[ x ].xNextRelease <= xNow ) )
+                {
+                    prvRelease( &pxTasks[ x ], &xStates[ x ], x, xNow );
+                }
+            }
+
+            xRunning = prvSelect( xStates, xTaskCount, xRunning );
+
+            if( ( xRunning != simNO_TASK ) && ( xRunning != xLoaded ) )
+            {
+                pxStats->ulSwitches++;
+                xOverhead += pxConfig->xSwitchOverhead;
+                xLoaded = xRunning;
+            }
+        }
+
+        if( xRunning == simNO_TASK )
+        {
+            /* Idle until the tick or alarm that notices the next release.
+            Any outstanding overhead is absorbed by the idle time. */
+            xWake = ~( EDFTime_t ) 0;
+
+            for( x = 0; x < xTaskCount; x++ )
+            {
+                if( xStates[ x ].xNextRelease < xWake )
+                {
+                    xWake = xStates[ x ].xNextRelease;
+                }
+            }
+
+            xOverhead = 0;
+            xLoaded = simNO_TASK;
+
+            if( pxConfig->lAlarmReleases != 0 )
+            {
+                /* The ticks before the alarm still happen. */
+                if( xWake > xNextTick )
+                {
+                    xUsed = ( xWake - xNextTick + xTickPeriod - 1 ) / xTickPeriod;
+                    pxStats->ulTicks += ( uint32_t ) xUsed;
+                    xNextTick += xUsed * xTickPeriod;
+                }
+
+                xNow = ( xWake < xHorizon ) ? xWake : xHorizon;
+                continue;
+            }
+
+            xWake = ( ( xWake + xTickPeriod - 1 ) / xTickPeriod ) * xTickPeriod;
+
+            if( xWake > xNextTick )
+            {
+                pxStats->ulTicks += ( uint32_t ) ( ( xWake - xNextTick ) / xTickPeriod );
+                xNextTick = xWake;
+            }
+
+            xNow = ( xNextTick < xHorizon ) ? xNextTick : xHorizon;
+            continue;
+        }
+
+        /* Run until the next tick, alarm or the horizon, whichever is
+        first. */
+        xStop = ( xNextTick < xHorizon ) ? xNextTick : xHorizon;
+        xStop = ( xNextAlarm < xStop ) ? xNextAlarm : xStop;
+        xSlice = xStop - xNow;
+
+        xUsed = ( xOverhead < xSlice ) ? xOverhead : xSlice;
+        xOverhead -= xUsed;
+        xNow += xUsed;
+        xSlice -= xUsed;
+
+        if( xSlice == 0 )
+        {
+            continue;
+        }
+
+        pxState = &xStates[ xRunning ];
+
+        if( pxState->lStarted == 0 )
+        {
+            pxState->lStarted = 1;
+            pxState->xJob.xStart = xNow;
+        }
+
+        xUsed = ( pxState->xRemaining < xSlice ) ? pxState->xRemaining : xSlice;
+        pxState->xRemaining -= xUsed;
+        pxStats->xBusyTime += xUsed;
+        xNow += xUsed;
+
+        if( pxState->xRemaining != 0 )
+        {
+            continue;
+        }
+
+        /* The job calls vTaskDoneEDF(). */
+        pxState->lActive = 0;
+        pxState->xJob.xFinish = xNow;
+        pxState->xJob.xResponse = xNow - pxState->xJob.xRelease;
+        pxState->xJob.lMissed = ( xNow > pxState->xJob.xDeadline );
+        prvRecord( &pxState->xJob, pxStats, pxTaskStats, pxCallback, pvContext );
+        pxState->ulJob++;
+
+        /* If the next release has already passed the task does not
+        block, so the next job is ready without waiting for a tick. */
+        if( pxState->xNextRelease <= xNow )
+        {
+            prvRelease( &pxTasks[ xRunning ], pxState, xRunning, xNow );
+        }
+
+        xNext = prvSelect( xStates, xTaskCount, simNO_TASK );
+
+        if( ( xNext != simNO_TASK ) && ( xNext != xLoaded ) )
+        {
+            pxStats->ulSwitches++;
+            xOverhead += pxConfig->xSwitchOverhead;
+            xLoaded = xNext;
+        }
+
+        xRunning = xNext;
+    }
+
+    /* Jobs still running at the horizon after their deadline. */
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( ( xStates[ x ].lActive != 0 ) && ( xStates[ x ].xJob.xDeadline < xHorizon ) )
+        {
+            if( xStates[ x ].lStarted == 0 )
+            {
+                xStates[ x ].xJob.xStart = xHorizon;
+            }
+
+            xStates[ x ].xJob.xFinish = xHorizon;
+            xStates[ x ].xJob.xResponse = xHorizon - xStates[ x ].xJob.xRelease;
+            xStates[ x ].xJob.lMissed = 1;
+            prvRecord( &xStates[ x ].xJob, pxStats, pxTaskStats, pxCallback, pvContext );
+        }
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+int lEDFSimulateGlobal( const EDFTask_t * pxTasks,
+                        size_t xTaskCount,
+                        size_t xCores,
+                        const EDFSimConfig_t * pxConfig,
+                        EDFSimJobCallback_t pxCallback,
+                        void * pvContext,
+                        EDFSimStats_t * pxStats,
+                        EDFSimTaskStats_t * pxTaskStats )
+{
+    SimTaskState_t xStates[ edfSIM_MAX_TASKS ];
+    int lRunning[ edfSIM_MAX_TASKS ];   /* 1 if chosen to run, 2 if it ran before and is not yet chosen again. */
+    SimTaskState_t * pxState;
+    EDFTime_t xNow = 0, xNext, xHorizon = pxConfig->xHorizon, xStep;
+    size_t xChosen, xBest, x;
+
+    if( ( xTaskCount > edfSIM_MAX_TASKS ) || ( xCores == 0 ) )
+    {
+        return -1;
+    }
+
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( ( pxTasks[ x ].xC == 0 ) || ( pxTasks[ x ].xD == 0 ) || ( pxTasks[ x ].xT == 0 ) )
+        {
+            return -1;
+        }
+
+        xStates[ x ].lActive = 0;
+        xStates[ x ].ulJob = 0;
+        xStates[ x ].xNextRelease = 0;
+        lRunning[ x ] = 0;
+
+        if( pxTaskStats != NULL )
+        {
+            pxTaskStats[ x ].ulJobs = 0;
+            pxTaskStats[ x ].ulMisses = 0;
+            pxTaskStats[ x ].xWorstResponse = 0;
+            pxTaskStats[ x ].xTotalResponse = 0;
+            pxTaskStats[ x ].xWorstJitter = 0;
+            pxTaskStats[ x ].xTotalJitter = 0;
+        }
+    }
+
+    pxStats->ulJobs = 0;
+    pxStats->ulMisses = 0;
+    pxStats->ulSwitches = 0;
+    pxStats->ulTicks = 0;
+    pxStats->xFirstMiss = 0;
+    pxStats->xBusyTime = 0;
+
+    while( xNow < xHorizon )
+    {
+        for( x = 0; x < xTaskCount; x++ )
+        {
+            if( ( xStates[ x ].lActive == 0 ) && ( xStates[ x ].xNextRelease <= xNow ) )
+            {
+                prvRelease( &pxTasks[ x ], &xStates[ x ], x, xNow );
+            }
+
+            lRunning[ x ] = ( lRunning[ x ] != 0 ) ? 2 : 0;
+        }
+
+        /* Choose the xCores earliest deadlines. A job that was already
+        running keeps its place on a tie, as in the single core
+        simulation. */
+        for( xChosen = 0; xChosen < xCores; xChosen++ )
+        {
+            xBest = simNO_TASK;
+
+            for( x = 0; x < xTaskCount; x++ )
+            {
+                if( ( xStates[ x ].lActive == 0 ) || ( lRunning[ x ] == 1 ) )
+                {
+                    continue;
+                }
+
+                if( ( xBest == simNO_TASK ) ||
+                    ( xStates[ x ].xJob.xDeadline < xStates[ xBest ].xJob.xDeadline ) ||
+                    ( ( xStates[ x ].xJob.xDeadline == xStates[ xBest ].xJob.xDeadline ) &&
+                      ( lRunning[ x ] == 2 ) && ( lRunning[ xBest ] != 2 ) ) )
+                {
+                    xBest = x;
+                }
+            }
+
+            if( xBest == simNO_TASK )
+            {
+                break;
+            }
+
+            if( lRunning[ xBest ] != 2 )
+            {
+                pxStats->ulSwitches++;
+            }
+
+            lRunning[ xBest ] = 1;
+        }
+
+        /* Run until the next release or completion. */
+        xNext = xHorizon;
+
+        for( x = 0; x < xTaskCount; x++ )
+        {
+            if( lRunning[ x ] == 2 )
+            {
+                lRunning[ x ] = 0;
+            }
+
+            if( ( xStates[ x ].lActive == 0 ) && ( xStates[ x ].xNextRelease < xNext ) )
+            {
+                xNext = xStates[ x ].xNextRelease;
+            }
+
+            if( ( lRunning[ x ] != 0 ) && ( xNow + xStates[ x ].xRemaining < xNext ) )
+            {
+                xNext = xNow + xStates[ x ].xRemaining;
+            }
+        }
+
+        xStep = xNext - xNow;
+
+        for( x = 0; x < xTaskCount; x++ )
+        {
+            if( lRunning[ x ] == 0 )
+            {
+                continue;
+            }
+
+            pxState = &xStates[ x ];
+
+            if( pxState->lStarted == 0 )
+            {
+                pxState->lStarted = 1;
+                pxState->xJob.xStart = xNow;
+            }
+
+            pxState->xRemaining -= xStep;
+            pxStats->xBusyTime += xStep;
+        }
+
+        xNow = xNext;
+
+        for( x = 0; x < xTaskCount; x++ )
+        {
+            pxState = &xStates[ x ];
+
+            if( ( lRunning[ x ] == 0 ) || ( pxState->xRemaining != 0 ) )
+            {
+                continue;
+            }
+
+            /* The job calls vTaskDoneEDF(). Its core is free for the
+            next choice. */
+            pxState->lActive = 0;
+            pxState->xJob.xFinish = xNow;
+            pxState->xJob.xResponse = xNow - pxState->xJob.xRelease;
+            pxState->xJob.lMissed = ( xNow > pxState->xJob.xDeadline );
+            prvRecord( &pxState->xJob, pxStats, pxTaskStats, pxCallback, pvContext );
+            pxState->ulJob++;
+            lRunning[ x ] = 0;
+        }
+    }
+
+    /* Jobs still running at the horizon after their deadline. */
+    for( x = 0; x < xTaskCount; x++ )
+    {
+        if( ( xStates[ x ].lActive != 0 ) && ( xStates[ x ].xJob.xDeadline < xHorizon ) )
+        {
+            if( xStates[ x ].lStarted == 0 )
+            {
+                xStates[ x ].xJob.xStart = xHorizon;
+            }
+
+            xStates[ x ].xJob.xFinish = xHorizon;
+            xStates[ x ].xJob.xResponse = xHorizon - xStates[ x ].xJob.xRelease;
+            xStates[ x ].xJob.lMissed = 1;
+            prvRecord( &xStates[ x ].xJob, pxStats, pxTaskStats, pxCallback, pvContext );
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef EDF_SIM_H
+#define EDF_SIM_H
+
+/*
+ * Discrete event simulation of a single core running EDF tasks the way the
+ * FreeRTOS EDF scheduler runs them:
+ *
+ *  - Each task loops doing C of work then calling vTaskDoneEDF(), which
+ *    blocks until its next release. Releases are only noticed by the tick
+ *    interrupt, so a release between ticks waits for the next tick, unless
+ *    lAlarmReleases is set, in which case each release is noticed on time
+ *    by a timer alarm interrupt costing xAlarmOverhead. If the release time
+ *    has already passed when the job completes, the next job starts
+ *    straight away.
+ *  - The ready job with the earliest absolute deadline runs. A job released
+ *    by the tick preempts the running job only if its deadline is strictly
+ *    earlier.
+ *  - Every tick interrupt and every switch between tasks costs a fixed
+ *    amount of processor time during which no job makes progress.
+ *  - A job that misses its deadline keeps running until it completes.
+ *
+ * Times are in the same unit as the EDFTask_t values.
+ */
+
+#include "edf_analysis.h"
+
+typedef struct EDF_SIM_CONFIG
+{
+    EDFTime_t xTickPeriod;          /* Time between tick interrupts. */
+    EDFTime_t xTickOverhead;        /* Processor time taken by each tick interrupt. */
+    EDFTime_t xSwitchOverhead;      /* Processor time taken by each context switch. */
+    EDFTime_t xHorizon;             /* The simulation stops at this time. */
+    int lAlarmReleases;             /* Non-zero to release jobs from a timer alarm rather than the tick. */
+    EDFTime_t xAlarmOverhead;       /* Processor time taken by each alarm interrupt. */
+} EDFSimConfig_t;
+
+typedef struct EDF_SIM_JOB
+{
+    size_t xTask;                   /* Index into the task array. */
+    uint32_t ulJob;                 /* Job number within the task, from 0. */
+    EDFTime_t xRelease;             /* Nominal release time, a multiple of T. */
+    EDFTime_t xReady;               /* When the release was noticed. */
+    EDFTime_t xDeadline;            /* Absolute deadline. */
+    EDFTime_t xStart;               /* First time the job ran. */
+    EDFTime_t xFinish;              /* Completion time. */
+    EDFTime_t xResponse;            /* xFinish - xRelease. */
+    int lMissed;                    /* Non-zero if xFinish > xDeadline. */
+} EDFSimJob_t;
+
+typedef struct EDF_SIM_TASK_STATS
+{
+    uint32_t ulJobs;
+    uint32_t ulMisses;
+    EDFTime_t xWorstResponse;
+    EDFTime_t xTotalResponse;
+    EDFTime_t xWorstJitter;         /* Greatest xReady - xRelease. */
+    EDFTime_t xTotalJitter;
+} EDFSimTaskStats_t;
+
+typedef struct EDF_SIM_STATS
+{
+    uint32_t ulJobs;
+    uint32_t ulMisses;              /* Includes jobs still unfinished past their deadline at the horizon. */
+    uint32_t ulSwitches;
+    uint32_t ulTicks;
+    EDFTime_t xFirstMiss;           /* Deadline of the first job to miss, if any. */
+    EDFTime_t xBusyTime;            /* Time spent running jobs. */
+} EDFSimStats_t;
+
+/*
+ * Called for every job that completes within the horizon, in completion
+ * order, and for every job that is unfinished at the horizon with a
+ * deadline before it (with xFinish set to the horizon).
+ */
+typedef void ( * EDFSimJobCallback_t )( const EDFSimJob_t * pxJob, void * pvContext );
+
+/*
+ * Simulates the synchronous release of every task from time 0.
+ * pxTaskStats, if not NULL, must have xTaskCount entries.
+ * pxCallback may be NULL.
+ *
+ * Returns 0 on success or -1 if the configuration or a task is invalid or
+ * there are more than edfSIM_MAX_TASKS tasks.
+ */
+int lEDFSimulate( const EDFTask_t * pxTasks,
+                  size_t xTaskCount,
+                  const EDFSimConfig_t * pxConfig,
+                  EDFSimJobCallback_t pxCallback,
+                  void * pvContext,
+                  EDFSimStats_t * pxStats,
+                  EDFSimTaskStats_t * pxTaskStats );
+
+/*
+ * Simulates the synchronous release of every task from time 0 under global
+ * EDF on xCores identical cores: at every release and completion the
+ * xCores ready jobs with the earliest deadlines run, a job migrating freely
+ * between cores. Releases are not quantised to ticks and there are no
+ * overheads, so with xCores of 1 this is the ideal uniprocessor schedule.
+ * Other arguments are as for lEDFSimulate(); only xHorizon is used from
+ * pxConfig.
+ */
+int lEDFSimulateGlobal( const EDFTask_t * pxTasks,
+                        size_t xTaskCount,
+                        size_t xCores,
+                        const EDFSimConfig_t * pxConfig,
+                        EDFSimJobCallback_t pxCallback,
+                        void * pvContext,
+                        EDFSimStats_t * pxStats,
+                        EDFSimTaskStats_t * pxTaskStats );
+
+#ifndef edfSIM_MAX_TASKS
+    #define edfSIM_MAX_TASKS    64
+#endif
+
+#endif /* EDF_SIM_H */
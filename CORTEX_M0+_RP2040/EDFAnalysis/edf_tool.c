@@ -0,0 +1,1028 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * edf_tool checks whether a set of EDF tasks is schedulable before it is run
+ * on hardware.
+ *
+ *   edf_tool [options] <task file>
+ *
+ * analyses the tasks in the file and then simulates them, printing the
+ * response time of every job and a summary of deadline misses. Each line of
+ * the file describes one task as it would be passed to xTaskCreateEDF():
+ *
+ *   <name> <C> <D> <T>
+ *
+ * with all three values in ticks. C may have up to three decimal places.
+ * Blank lines and anything after a '#' are ignored.
+ *
+ *   edf_tool [options] --random <sets> [--tasks <n>] [--util <U>] [--seed <s>]
+ *
+ * generates task sets with UUniFast and checks that the analysis and the
+ * simulation agree on every one of them. With --cores <n> for n > 1 it
+ * instead compares the deadline miss rates of partitioned and global EDF
+ * on n cores, where U is the total utilisation across all of them.
+ *
+ *   edf_tool --admission <script>
+ *
+ * replays a sequence of task arrivals and departures through the admission
+ * control in edf_admission.c, one per line:
+ *
+ *   + <name> <C> <D> <T> [admit|reject]
+ *   - <name>
+ *
+ * printing each decision and checking it against the expected one if
+ * given.
+ *
+ * Options:
+ *   --cs <ticks>        cost of each context switch (default 0)
+ *   --tick-isr <ticks>  cost of each tick interrupt (default 0)
+ *   --alarm <ticks>     release jobs from a microsecond timer alarm costing
+ *                       <ticks> per interrupt, rather than from the tick
+ *   --horizon <ticks>   simulated time (default: one hyperperiod, or L when
+ *                       that is longer)
+ *   --quiet             do not print the per-job table
+ *
+ * Exit status: 0 if every set is schedulable and met all of its deadlines in
+ * simulation, 1 if not, 2 for usage errors and 3 if the analysis and the
+ * simulation disagree or an admission decision was not the expected one.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "edf_admission.h"
+#include "edf_analysis.h"
+#include "edf_sim.h"
+
+/* Times are held in thousandths of a tick, which at the default
+configTICK_RATE_HZ of 1000 is one microsecond. */
+#define toolUNITS_PER_TICK      ( ( EDFTime_t ) 1000 )
+
+#define toolMAX_NAME            16
+#define toolMAX_HORIZON         ( ( EDFTime_t ) 100000000 * toolUNITS_PER_TICK )
+#define toolMAX_CORES           8
+
+/* Range of generated periods, in ticks. */
+#define toolRANDOM_MIN_PERIOD   10
+#define toolRANDOM_MAX_PERIOD   1000
+
+typedef struct TOOL_OPTIONS
+{
+    EDFTime_t xSwitchOverhead;
+    EDFTime_t xTickOverhead;
+    EDFTime_t xAlarmOverhead;
+    int lAlarmReleases;
+    EDFTime_t xHorizon;
+    int lQuiet;
+    unsigned long ulRandomSets;
+    unsigned long ulRandomTasks;
+    double dRandomUtilisation;
+    unsigned long ulSeed;
+    unsigned long ulCores;
+} ToolOptions_t;
+
+static char pcNames[ edfSIM_MAX_TASKS ][ toolMAX_NAME ];
+
+/*-----------------------------------------------------------*/
+
+static void prvPrintTime( EDFTime_t xTime, int lWidth )
+{
+    char cBuffer[ 32 ];
+
+    snprintf( cBuffer, sizeof( cBuffer ), "%llu.%03llu",
+              ( unsigned long long ) ( xTime / toolUNITS_PER_TICK ),
+              ( unsigned long long ) ( xTime % toolUNITS_PER_TICK ) );
+    printf( "%*s", lWidth, cBuffer );
+}
+/*-----------------------------------------------------------*/
+
+/* Parses a non-negative number of ticks with up to three decimal places. */
+static int prvParseTicks( const char * pcText, EDFTime_t * pxTime )
+{
+    unsigned long long ullWhole = 0, ullFraction = 0, ullScale = toolUNITS_PER_TICK;
+    const char * pc = pcText;
+
+    if( ( *pc < '0' ) || ( *pc > '9' ) )
+    {
+        return -1;
+    }
+
+    while( ( *pc >= '0' ) && ( *pc <= '9' ) )
+    {
+        ullWhole = ( ullWhole * 10 ) + ( unsigned long long ) ( *pc++ - '0' );
+    }
+
+    if( *pc == '.' )
+    {
+        pc++;
+
+        while( ( *pc >= '0' ) && ( *pc <= '9' ) )
+        {
+            if( ullScale == 1 )
+            {
+                return -1;
+            }
+
+            ullScale /= 10;
+            ullFraction += ( unsigned long long ) ( *pc++ - '0' ) * ullScale;
+        }
+    }
+
+    if( *pc != '\0' )
+    {
+        return -1;
+    }
+
+    *pxTime = ( EDFTime_t ) ( ( ullWhole * toolUNITS_PER_TICK ) + ullFraction );
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvLoadTasks( const char * pcPath, EDFTask_t * pxTasks )
+{
+    char cLine[ 256 ], cName[ 64 ], cC[ 32 ], cD[ 32 ], cT[ 32 ];
+    unsigned long ulLine = 0;
+    size_t xCount = 0;
+    char * pcComment;
+    FILE * pxFile;
+
+    pxFile = fopen( pcPath, "r" );
+
+    if( pxFile == NULL )
+    {
+        fprintf( stderr, "edf_tool: %s: %s\n", pcPath, strerror( errno ) );
+        exit( 2 );
+    }
+
+    while( fgets( cLine, sizeof( cLine ), pxFile ) != NULL )
+    {
+        ulLine++;
+        pcComment = strchr( cLine, '#' );
+
+        if( pcComment != NULL )
+        {
+            *pcComment = '\0';
+        }
+
+        if( sscanf( cLine, "%63s", cName ) != 1 )
+        {
+            continue;
+        }
+
+        if( ( sscanf( cLine, "%63s %31s %31s %31s", cName, cC, cD, cT ) != 4 ) ||
+            ( prvParseTicks( cC, &pxTasks[ xCount ].xC ) != 0 ) ||
+            ( prvParseTicks( cD, &pxTasks[ xCount ].xD ) != 0 ) ||
+            ( prvParseTicks( cT, &pxTasks[ xCount ].xT ) != 0 ) )
+        {
+            fprintf( stderr, "edf_tool: %s:%lu: expected <name> <C> <D> <T>\n", pcPath, ulLine );
+            exit( 2 );
+        }
+
+        if( xCount == edfSIM_MAX_TASKS )
+        {
+            fprintf( stderr, "edf_tool: %s: more than %d tasks\n", pcPath, edfSIM_MAX_TASKS );
+            exit( 2 );
+        }
+
+        snprintf( pcNames[ xCount ], toolMAX_NAME, "%.*s", toolMAX_NAME - 1, cName );
+        xCount++;
+    }
+
+    fclose( pxFile );
+
+    return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static EDFTime_t prvGCD( EDFTime_t xA, EDFTime_t xB )
+{
+    EDFTime_t xR;
+
+    while( xB != 0 )
+    {
+        xR = xA % xB;
+        xA = xB;
+        xB = xR;
+    }
+
+    return xA;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the hyperperiod, or 0 if it exceeds toolMAX_HORIZON. */
+static EDFTime_t prvHyperperiod( const EDFTask_t * pxTasks, size_t xCount )
+{
+    EDFTime_t xH = 1;
+    size_t x;
+
+    for( x = 0; x < xCount; x++ )
+    {
+        xH = ( xH / prvGCD( xH, pxTasks[ x ].xT ) ) * pxTasks[ x ].xT;
+
+        if( xH > toolMAX_HORIZON )
+        {
+            return 0;
+        }
+    }
+
+    return xH;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The analysis accounts for the overheads that the simulation models:
+ *  - each job can cause at most one preemption, so it is charged two
+ *    context switches,
+ *  - a release between ticks waits up to a tick to be noticed, which
+ *    shortens the deadline by that much, or with alarm releases each job
+ *    is charged one alarm interrupt instead,
+ *  - the tick interrupt is an extra task due by the next tick.
+ */
+static size_t prvAddOverheads( const EDFTask_t * pxTasks, size_t xCount, const ToolOptions_t * pxOptions, EDFTask_t * pxOut )
+{
+    size_t x;
+
+    for( x = 0; x < xCount; x++ )
+    {
+        pxOut[ x ] = pxTasks[ x ];
+        pxOut[ x ].xC += 2 * pxOptions->xSwitchOverhead;
+
+        if( pxOptions->lAlarmReleases != 0 )
+        {
+            pxOut[ x ].xC += pxOptions->xAlarmOverhead;
+        }
+        else if( ( pxTasks[ x ].xT % toolUNITS_PER_TICK ) != 0 )
+        {
+            pxOut[ x ].xD = ( pxOut[ x ].xD > toolUNITS_PER_TICK ) ? ( pxOut[ x ].xD - ( toolUNITS_PER_TICK - 1 ) ) : 1;
+        }
+    }
+
+    if( pxOptions->xTickOverhead != 0 )
+    {
+        pxOut[ x ].xC = pxOptions->xTickOverhead;
+        pxOut[ x ].xD = toolUNITS_PER_TICK;
+        pxOut[ x ].xT = toolUNITS_PER_TICK;
+        x++;
+    }
+
+    return x;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintJob( const EDFSimJob_t * pxJob, void * pvContext )
+{
+    ( void ) pvContext;
+
+    printf( "%-*s %6lu ", toolMAX_NAME - 1, pcNames[ pxJob->xTask ], ( unsigned long ) pxJob->ulJob );
+    prvPrintTime( pxJob->xRelease, 11 );
+    prvPrintTime( pxJob->xDeadline, 11 );
+    prvPrintTime( pxJob->xStart, 11 );
+    prvPrintTime( pxJob->xFinish, 11 );
+    prvPrintTime( pxJob->xResponse, 11 );
+
+    if( pxJob->lMissed != 0 )
+    {
+        printf( "  MISSED by " );
+        prvPrintTime( pxJob->xFinish - pxJob->xDeadline, 0 );
+        printf( "\n" );
+    }
+    else
+    {
+        prvPrintTime( pxJob->xDeadline - pxJob->xFinish, 11 );
+        printf( "\n" );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintAnalysis( const EDFAnalysis_t * pxAnalysis )
+{
+    printf( "Utilisation     %.4f\n", pxAnalysis->dUtilisation );
+
+    if( pxAnalysis->xBusyPeriod != 0 )
+    {
+        printf( "Busy period     " );
+        prvPrintTime( pxAnalysis->xBusyPeriod, 0 );
+        printf( "\nTest bound L    " );
+        prvPrintTime( pxAnalysis->xBound, 0 );
+        printf( "\nPoints checked  %lu\n", ( unsigned long ) pxAnalysis->ulPointsChecked );
+    }
+
+    printf( "Result          %s\n", pcEDFResultString( pxAnalysis->eResult ) );
+
+    if( pxAnalysis->eResult == eEDFDemandExceeded )
+    {
+        printf( "                demand " );
+        prvPrintTime( pxAnalysis->xFailDemand, 0 );
+        printf( " in [0, " );
+        prvPrintTime( pxAnalysis->xFailTime, 0 );
+        printf( "]\n" );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int prvRunFile( const char * pcPath, const ToolOptions_t * pxOptions )
+{
+    EDFTask_t xTasks[ edfSIM_MAX_TASKS ], xAnalysed[ edfSIM_MAX_TASKS + 1 ];
+    EDFSimTaskStats_t xTaskStats[ edfSIM_MAX_TASKS ];
+    EDFAnalysis_t xAnalysis;
+    EDFSimConfig_t xConfig;
+    EDFSimStats_t xStats;
+    size_t xCount, xAnalysedCount, x;
+
+    xCount = prvLoadTasks( pcPath, xTasks );
+    xAnalysedCount = prvAddOverheads( xTasks, xCount, pxOptions, xAnalysed );
+    xEDFAnalyse( xAnalysed, xAnalysedCount, &xAnalysis );
+
+    printf( "%-*s %10s %10s %10s\n", toolMAX_NAME - 1, "Task", "C", "D", "T" );
+
+    for( x = 0; x < xCount; x++ )
+    {
+        printf( "%-*s ", toolMAX_NAME - 1, pcNames[ x ] );
+        prvPrintTime( xTasks[ x ].xC, 10 );
+        prvPrintTime( xTasks[ x ].xD, 11 );
+        prvPrintTime( xTasks[ x ].xT, 11 );
+        printf( "\n" );
+    }
+
+    printf( "\n" );
+    prvPrintAnalysis( &xAnalysis );
+
+    xConfig.xTickPeriod = toolUNITS_PER_TICK;
+    xConfig.xTickOverhead = pxOptions->xTickOverhead;
+    xConfig.xSwitchOverhead = pxOptions->xSwitchOverhead;
+    xConfig.xHorizon = pxOptions->xHorizon;
+    xConfig.lAlarmReleases = pxOptions->lAlarmReleases;
+    xConfig.xAlarmOverhead = pxOptions->xAlarmOverhead;
+
+    if( xConfig.xHorizon == 0 )
+    {
+        xConfig.xHorizon = prvHyperperiod( xTasks, xCount );
+
+        if( xConfig.xHorizon < xAnalysis.xBound )
+        {
+            xConfig.xHorizon = xAnalysis.xBound;
+        }
+
+        if( ( xConfig.xHorizon == 0 ) || ( xConfig.xHorizon > toolMAX_HORIZON ) )
+        {
+            xConfig.xHorizon = toolMAX_HORIZON;
+        }
+    }
+
+    printf( "\nSimulating " );
+    prvPrintTime( xConfig.xHorizon, 0 );
+    printf( " ticks\n\n" );
+
+    if( pxOptions->lQuiet == 0 )
+    {
+        printf( "%-*s %6s %10s %10s %10s %10s %10s %10s\n", toolMAX_NAME - 1,
+                "Task", "Job", "Release", "Deadline", "Start", "Finish", "Response", "Slack" );
+    }
+
+    if( lEDFSimulate( xTasks, xCount, &xConfig, ( pxOptions->lQuiet == 0 ) ? prvPrintJob : NULL, NULL, &xStats, xTaskStats ) != 0 )
+    {
+        fprintf( stderr, "edf_tool: invalid task set or overheads\n" );
+        return 2;
+    }
+
+    printf( "\n%-*s %8s %8s %12s %12s %12s %12s\n", toolMAX_NAME - 1, "Task", "Jobs", "Misses", "Worst resp", "Avg resp", "Worst jitter", "Avg jitter" );
+
+    for( x = 0; x < xCount; x++ )
+    {
+        printf( "%-*s %8lu %8lu ", toolMAX_NAME - 1, pcNames[ x ],
+                ( unsigned long ) xTaskStats[ x ].ulJobs, ( unsigned long ) xTaskStats[ x ].ulMisses );
+        prvPrintTime( xTaskStats[ x ].xWorstResponse, 12 );
+        prvPrintTime( ( xTaskStats[ x ].ulJobs != 0 ) ? ( xTaskStats[ x ].xTotalResponse / xTaskStats[ x ].ulJobs ) : 0, 13 );
+        prvPrintTime( xTaskStats[ x ].xWorstJitter, 13 );
+        prvPrintTime( ( xTaskStats[ x ].ulJobs != 0 ) ? ( xTaskStats[ x ].xTotalJitter / xTaskStats[ x ].ulJobs ) : 0, 13 );
+        printf( "\n" );
+    }
+
+    printf( "\n%lu jobs, %lu deadline misses, %lu context switches, %lu ticks, %.1f%% busy\n",
+            ( unsigned long ) xStats.ulJobs, ( unsigned long ) xStats.ulMisses,
+            ( unsigned long ) xStats.ulSwitches, ( unsigned long ) xStats.ulTicks,
+            100.0 * ( double ) xStats.xBusyTime / ( double ) xConfig.xHorizon );
+
+    if( xStats.ulMisses != 0 )
+    {
+        printf( "First miss at deadline " );
+        prvPrintTime( xStats.xFirstMiss, 0 );
+        printf( "\n" );
+    }
+
+    if( ( xAnalysis.eResult == eEDFSchedulable ) && ( xStats.ulMisses != 0 ) )
+    {
+        printf( "ERROR: analysis says schedulable but the simulation missed deadlines\n" );
+        return 3;
+    }
+
+    return ( ( xAnalysis.eResult == eEDFSchedulable ) && ( xStats.ulMisses == 0 ) ) ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
+
+static double prvRandom( void )
+{
+    return ( ( double ) rand() + 1.0 ) / ( ( double ) RAND_MAX + 2.0 );
+}
+/*-----------------------------------------------------------*/
+
+/* UUniFast (Bini and Buttazzo, 2005) with log-uniform periods and
+deadlines drawn uniformly between C and T. Utilisations over 1 are only
+useful for multiple cores, and sets with any task over 1 are discarded and
+drawn again. */
+static void prvGenerate( EDFTask_t * pxTasks, size_t xCount, double dUtilisation )
+{
+    double dUtilisations[ edfSIM_MAX_TASKS ];
+    double dRemaining, dNext, dLogMin, dLogMax;
+    EDFTime_t xTicks, xMinD;
+    size_t x;
+    int lDiscard;
+
+    dLogMin = log( ( double ) toolRANDOM_MIN_PERIOD );
+    dLogMax = log( ( double ) toolRANDOM_MAX_PERIOD + 1.0 );
+
+    do
+    {
+        dRemaining = dUtilisation;
+        lDiscard = 0;
+
+        for( x = 0; x < xCount; x++ )
+        {
+            if( x + 1 < xCount )
+            {
+                dNext = dRemaining * pow( prvRandom(), 1.0 / ( double ) ( xCount - x - 1 ) );
+                dUtilisations[ x ] = dRemaining - dNext;
+                dRemaining = dNext;
+            }
+            else
+            {
+                dUtilisations[ x ] = dRemaining;
+            }
+
+            if( dUtilisations[ x ] > 1.0 )
+            {
+                lDiscard = 1;
+            }
+        }
+    } while( lDiscard != 0 );
+
+    for( x = 0; x < xCount; x++ )
+    {
+        xTicks = ( EDFTime_t ) exp( dLogMin + ( prvRandom() * ( dLogMax - dLogMin ) ) );
+        pxTasks[ x ].xT = xTicks * toolUNITS_PER_TICK;
+        pxTasks[ x ].xC = ( EDFTime_t ) ( dUtilisations[ x ] * ( double ) pxTasks[ x ].xT + 0.5 );
+
+        if( pxTasks[ x ].xC == 0 )
+        {
+            pxTasks[ x ].xC = 1;
+        }
+
+        /* Whole ticks, as xTaskCreateEDF() takes them. */
+        xMinD = ( pxTasks[ x ].xC + toolUNITS_PER_TICK - 1 ) / toolUNITS_PER_TICK;
+        pxTasks[ x ].xD = ( xMinD + ( EDFTime_t ) ( prvRandom() * ( double ) ( xTicks - xMinD + 1 ) ) ) * toolUNITS_PER_TICK;
+
+        if( pxTasks[ x ].xD > pxTasks[ x ].xT )
+        {
+            pxTasks[ x ].xD = pxTasks[ x ].xT;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Without overheads the analysis is exact, so a set is schedulable if and
+ * only if the synchronous schedule meets every deadline up to L. With
+ * overheads the analysis is only checked to be safe.
+ */
+static int prvRunRandom( const ToolOptions_t * pxOptions )
+{
+    EDFTask_t xTasks[ edfSIM_MAX_TASKS ], xAnalysed[ edfSIM_MAX_TASKS + 1 ];
+    unsigned long ulSet, ulSchedulable = 0, ulUnschedulable = 0, ulSkipped = 0, ulDisagree = 0;
+    int lExact = ( pxOptions->xSwitchOverhead == 0 ) && ( pxOptions->xTickOverhead == 0 ) && ( pxOptions->xAlarmOverhead == 0 );
+    EDFAdmissionDecision_t xDecision;
+    EDFAdmission_t xAdmission;
+    EDFAnalysis_t xAnalysis;
+    EDFSimConfig_t xConfig;
+    EDFSimStats_t xStats;
+    size_t xCount = pxOptions->ulRandomTasks, xAnalysedCount, x;
+    int lAgree;
+
+    srand( ( unsigned int ) pxOptions->ulSeed );
+
+    for( ulSet = 0; ulSet < pxOptions->ulRandomSets; ulSet++ )
+    {
+        prvGenerate( xTasks, xCount, pxOptions->dRandomUtilisation );
+        xAnalysedCount = prvAddOverheads( xTasks, xCount, pxOptions, xAnalysed );
+        xEDFAnalyse( xAnalysed, xAnalysedCount, &xAnalysis );
+
+        /* Every subset of a schedulable set is schedulable, so admitting
+        the tasks one at a time must accept them all exactly when the
+        analysis accepts the whole set. */
+        if( ( xAnalysis.eResult != eEDFBoundTooLarge ) && ( xAnalysedCount <= edfADMISSION_MAX_TASKS ) )
+        {
+            vEDFAdmissionInit( &xAdmission );
+
+            for( x = 0; x < xAnalysedCount; x++ )
+            {
+                if( xEDFAdmissionTest( &xAdmission, &xAnalysed[ x ], 1, &xDecision ) != eEDFSchedulable )
+                {
+                    break;
+                }
+            }
+
+            if( ( x == xAnalysedCount ) != ( xAnalysis.eResult == eEDFSchedulable ) )
+            {
+                ulDisagree++;
+                printf( "Set %lu: analysis %s, admission control %s task %lu\n", ulSet,
+                        pcEDFResultString( xAnalysis.eResult ),
+                        ( x == xAnalysedCount ) ? "admitted every" : "rejected", ( unsigned long ) x );
+            }
+        }
+
+        if( ( xAnalysis.eResult != eEDFSchedulable ) && ( xAnalysis.eResult != eEDFDemandExceeded ) )
+        {
+            ulSkipped++;
+            continue;
+        }
+
+        xConfig.xTickPeriod = toolUNITS_PER_TICK;
+        xConfig.xTickOverhead = pxOptions->xTickOverhead;
+        xConfig.xSwitchOverhead = pxOptions->xSwitchOverhead;
+        xConfig.lAlarmReleases = pxOptions->lAlarmReleases;
+        xConfig.xAlarmOverhead = pxOptions->xAlarmOverhead;
+        xConfig.xHorizon = ( pxOptions->xHorizon != 0 ) ? pxOptions->xHorizon : xAnalysis.xBound;
+
+        if( xConfig.xHorizon > toolMAX_HORIZON )
+        {
+            ulSkipped++;
+            continue;
+        }
+
+        lEDFSimulate( xTasks, xCount, &xConfig, NULL, NULL, &xStats, NULL );
+
+        if( xAnalysis.eResult == eEDFSchedulable )
+        {
+            ulSchedulable++;
+            lAgree = ( xStats.ulMisses == 0 );
+        }
+        else
+        {
+            ulUnschedulable++;
+            lAgree = ( lExact == 0 ) || ( xStats.ulMisses != 0 );
+        }
+
+        if( lAgree == 0 )
+        {
+            ulDisagree++;
+            printf( "Set %lu: analysis %s, simulation %lu misses\n", ulSet,
+                    pcEDFResultString( xAnalysis.eResult ), ( unsigned long ) xStats.ulMisses );
+
+            for( x = 0; x < xCount; x++ )
+            {
+                printf( "  T%lu ", ( unsigned long ) x );
+                prvPrintTime( xTasks[ x ].xC, 0 );
+                printf( " " );
+                prvPrintTime( xTasks[ x ].xD, 0 );
+                printf( " " );
+                prvPrintTime( xTasks[ x ].xT, 0 );
+                printf( "\n" );
+            }
+        }
+    }
+
+    printf( "%lu sets of %lu tasks at U=%.3f: %lu schedulable, %lu not, %lu skipped, %lu disagreements\n",
+            pxOptions->ulRandomSets, ( unsigned long ) xCount, pxOptions->dRandomUtilisation,
+            ulSchedulable, ulUnschedulable, ulSkipped, ulDisagree );
+
+    return ( ulDisagree != 0 ) ? 3 : 0;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Compares partitioned and global EDF on xCores cores over generated sets.
+ * Both are simulated without overheads by lEDFSimulateGlobal(), the
+ * partitioned schedule one core at a time. Tasks that the first fit
+ * decreasing packer cannot place go to the least utilised core, so that
+ * their misses are counted too. A core whose tasks were all admitted must
+ * not miss, and neither may the global schedule of a set that passes
+ * xEDFAdmissionGlobalTest(); both are checked.
+ */
+static int prvRunSmp( const ToolOptions_t * pxOptions )
+{
+    EDFTask_t xTasks[ edfSIM_MAX_TASKS ], xCoreTasks[ edfSIM_MAX_TASKS ];
+    EDFAdmission_t xCores[ toolMAX_CORES ];
+    int lCore[ edfSIM_MAX_TASKS ], lCoreForced[ toolMAX_CORES ];
+    unsigned long ulSet, ulPlaced = 0, ulPartitionedMissSets = 0, ulGlobalMissSets = 0, ulGlobalAdmitted = 0, ulDisagree = 0;
+    unsigned long long ullPartitionedJobs = 0, ullPartitionedMisses = 0, ullGlobalJobs = 0, ullGlobalMisses = 0;
+    size_t xCount = pxOptions->ulRandomTasks, xCoreCount = pxOptions->ulCores, xUnplaced, xCoreTaskCount, x, xCore, xLeast;
+    EDFSimConfig_t xConfig;
+    EDFSimStats_t xStats;
+    uint32_t ulMisses;
+
+    srand( ( unsigned int ) pxOptions->ulSeed );
+    memset( &xConfig, 0, sizeof( xConfig ) );
+
+    for( ulSet = 0; ulSet < pxOptions->ulRandomSets; ulSet++ )
+    {
+        prvGenerate( xTasks, xCount, pxOptions->dRandomUtilisation );
+
+        xConfig.xHorizon = pxOptions->xHorizon;
+
+        if( xConfig.xHorizon == 0 )
+        {
+            xConfig.xHorizon = 20 * toolRANDOM_MAX_PERIOD * toolUNITS_PER_TICK;
+        }
+
+        /* Partitioned. */
+        for( xCore = 0; xCore < xCoreCount; xCore++ )
+        {
+            vEDFAdmissionInit( &xCores[ xCore ] );
+            lCoreForced[ xCore ] = 0;
+        }
+
+        xUnplaced = xEDFAdmissionPartition( xCores, xCoreCount, xTasks, xCount, lCore );
+
+        if( xUnplaced == 0 )
+        {
+            ulPlaced++;
+        }
+
+        for( x = 0; x < xCount; x++ )
+        {
+            if( lCore[ x ] < 0 )
+            {
+                xLeast = 0;
+
+                for( xCore = 1; xCore < xCoreCount; xCore++ )
+                {
+                    if( xCores[ xCore ].ullUtilisation < xCores[ xLeast ].ullUtilisation )
+                    {
+                        xLeast = xCore;
+                    }
+                }
+
+                ( void ) lEDFAdmissionForce( &xCores[ xLeast ], &xTasks[ x ] );
+                lCore[ x ] = ( int ) xLeast;
+                lCoreForced[ xLeast ] = 1;
+            }
+        }
+
+        ulMisses = 0;
+
+        for( xCore = 0; xCore < xCoreCount; xCore++ )
+        {
+            xCoreTaskCount = 0;
+
+            for( x = 0; x < xCount; x++ )
+            {
+                if( lCore[ x ] == ( int ) xCore )
+                {
+                    xCoreTasks[ xCoreTaskCount++ ] = xTasks[ x ];
+                }
+            }
+
+            if( xCoreTaskCount == 0 )
+            {
+                continue;
+            }
+
+            lEDFSimulateGlobal( xCoreTasks, xCoreTaskCount, 1, &xConfig, NULL, NULL, &xStats, NULL );
+            ullPartitionedJobs += xStats.ulJobs;
+            ullPartitionedMisses += xStats.ulMisses;
+            ulMisses += xStats.ulMisses;
+
+            if( ( lCoreForced[ xCore ] == 0 ) && ( xStats.ulMisses != 0 ) )
+            {
+                ulDisagree++;
+                printf( "Set %lu: core %lu was admitted but missed %lu deadlines\n",
+                        ulSet, ( unsigned long ) xCore, ( unsigned long ) xStats.ulMisses );
+            }
+        }
+
+        if( ulMisses != 0 )
+        {
+            ulPartitionedMissSets++;
+        }
+
+        /* Global. */
+        lEDFSimulateGlobal( xTasks, xCount, xCoreCount, &xConfig, NULL, NULL, &xStats, NULL );
+        ullGlobalJobs += xStats.ulJobs;
+        ullGlobalMisses += xStats.ulMisses;
+
+        if( xStats.ulMisses != 0 )
+        {
+            ulGlobalMissSets++;
+        }
+
+        if( xEDFAdmissionGlobalTest( xTasks, xCount, xCoreCount ) == eEDFSchedulable )
+        {
+            ulGlobalAdmitted++;
+
+            if( xStats.ulMisses != 0 )
+            {
+                ulDisagree++;
+                printf( "Set %lu: passed the global density test but missed %lu deadlines\n",
+                        ulSet, ( unsigned long ) xStats.ulMisses );
+            }
+        }
+    }
+
+    printf( "%lu sets of %lu tasks at U=%.3f on %lu cores\n",
+            pxOptions->ulRandomSets, ( unsigned long ) xCount, pxOptions->dRandomUtilisation, ( unsigned long ) xCoreCount );
+    printf( "  partitioned: %lu sets placed, %lu sets with misses, %.3f%% of jobs missed\n",
+            ulPlaced, ulPartitionedMissSets,
+            ( ullPartitionedJobs != 0 ) ? ( 100.0 * ( double ) ullPartitionedMisses / ( double ) ullPartitionedJobs ) : 0.0 );
+    printf( "  global:      %lu sets admitted, %lu sets with misses, %.3f%% of jobs missed\n",
+            ulGlobalAdmitted, ulGlobalMissSets,
+            ( ullGlobalJobs != 0 ) ? ( 100.0 * ( double ) ullGlobalMisses / ( double ) ullGlobalJobs ) : 0.0 );
+    printf( "%lu disagreements\n", ulDisagree );
+
+    return ( ulDisagree != 0 ) ? 3 : 0;
+}
+/*-----------------------------------------------------------*/
+
+static const char * prvMethodString( EDFAdmissionMethod_t eMethod )
+{
+    switch( eMethod )
+    {
+        case eEDFAdmitByUtilisation:
+            return "utilisation";
+
+        case eEDFAdmitByDensity:
+            return "density";
+
+        case eEDFAdmitByDemand:
+            return "demand";
+
+        default:
+            return "full";
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int prvRunAdmission( const char * pcPath )
+{
+    char cLine[ 256 ], cOp[ 4 ], cName[ 64 ], cC[ 32 ], cD[ 32 ], cT[ 32 ], cExpect[ 16 ];
+    char cAdmitted[ edfADMISSION_MAX_TASKS ][ toolMAX_NAME ];
+    EDFTask_t xAdmittedTasks[ edfADMISSION_MAX_TASKS ], xTask;
+    unsigned long ulLine = 0, ulMismatches = 0;
+    EDFAdmissionDecision_t xDecision;
+    EDFAdmission_t xAdmission;
+    size_t xAdmitted = 0, x;
+    char * pcComment;
+    FILE * pxFile;
+    int lFields;
+
+    pxFile = fopen( pcPath, "r" );
+
+    if( pxFile == NULL )
+    {
+        fprintf( stderr, "edf_tool: %s: %s\n", pcPath, strerror( errno ) );
+        return 2;
+    }
+
+    vEDFAdmissionInit( &xAdmission );
+
+    while( fgets( cLine, sizeof( cLine ), pxFile ) != NULL )
+    {
+        ulLine++;
+        pcComment = strchr( cLine, '#' );
+
+        if( pcComment != NULL )
+        {
+            *pcComment = '\0';
+        }
+
+        lFields = sscanf( cLine, "%3s %63s %31s %31s %31s %15s", cOp, cName, cC, cD, cT, cExpect );
+
+        if( lFields <= 0 )
+        {
+            continue;
+        }
+
+        if( ( strcmp( cOp, "-" ) == 0 ) && ( lFields == 2 ) )
+        {
+            for( x = 0; x < xAdmitted; x++ )
+            {
+                if( strncmp( cAdmitted[ x ], cName, toolMAX_NAME - 1 ) == 0 )
+                {
+                    break;
+                }
+            }
+
+            if( ( x == xAdmitted ) || ( lEDFAdmissionRemove( &xAdmission, &xAdmittedTasks[ x ] ) != 0 ) )
+            {
+                fprintf( stderr, "edf_tool: %s:%lu: %s is not admitted\n", pcPath, ulLine, cName );
+                fclose( pxFile );
+                return 2;
+            }
+
+            xAdmitted--;
+            xAdmittedTasks[ x ] = xAdmittedTasks[ xAdmitted ];
+            memcpy( cAdmitted[ x ], cAdmitted[ xAdmitted ], toolMAX_NAME );
+
+            printf( "- %-12s U=%.4f density=%.4f\n", cName,
+                    ( double ) xAdmission.ullUtilisation / ( double ) edfADMISSION_ONE,
+                    ( double ) xAdmission.ullDensity / ( double ) edfADMISSION_ONE );
+            continue;
+        }
+
+        if( ( strcmp( cOp, "+" ) != 0 ) || ( lFields < 5 ) ||
+            ( prvParseTicks( cC, &xTask.xC ) != 0 ) ||
+            ( prvParseTicks( cD, &xTask.xD ) != 0 ) ||
+            ( prvParseTicks( cT, &xTask.xT ) != 0 ) ||
+            ( ( lFields == 6 ) && ( strcmp( cExpect, "admit" ) != 0 ) && ( strcmp( cExpect, "reject" ) != 0 ) ) )
+        {
+            fprintf( stderr, "edf_tool: %s:%lu: expected + <name> <C> <D> <T> [admit|reject] or - <name>\n", pcPath, ulLine );
+            fclose( pxFile );
+            return 2;
+        }
+
+        xEDFAdmissionTest( &xAdmission, &xTask, 1, &xDecision );
+
+        printf( "+ %-12s U=%.4f density=%.4f %s by %s", cName,
+                ( double ) xDecision.ullUtilisation / ( double ) edfADMISSION_ONE,
+                ( double ) xDecision.ullDensity / ( double ) edfADMISSION_ONE,
+                ( xDecision.eResult == eEDFSchedulable ) ? "admitted" : "rejected",
+                prvMethodString( xDecision.eMethod ) );
+
+        if( xDecision.eResult != eEDFSchedulable )
+        {
+            printf( " (%s)", pcEDFResultString( xDecision.eResult ) );
+        }
+        else
+        {
+            xAdmittedTasks[ xAdmitted ] = xTask;
+            snprintf( cAdmitted[ xAdmitted ], toolMAX_NAME, "%.*s", toolMAX_NAME - 1, cName );
+            xAdmitted++;
+        }
+
+        if( ( lFields == 6 ) && ( ( strcmp( cExpect, "admit" ) == 0 ) != ( xDecision.eResult == eEDFSchedulable ) ) )
+        {
+            printf( "  EXPECTED %s", cExpect );
+            ulMismatches++;
+        }
+
+        printf( "\n" );
+    }
+
+    fclose( pxFile );
+
+    printf( "%lu unexpected decisions\n", ulMismatches );
+
+    return ( ulMismatches != 0 ) ? 3 : 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvUsage( void )
+{
+    fprintf( stderr,
+             "usage: edf_tool [options] <task file>\n"
+             "       edf_tool [options] --random <sets> [--tasks <n>] [--util <U>] [--seed <s>] [--cores <n>]\n"
+             "       edf_tool --admission <script>\n"
+             "options: --cs <ticks> --tick-isr <ticks> --alarm <ticks> --horizon <ticks> --quiet\n" );
+    exit( 2 );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    ToolOptions_t xOptions;
+    const char * pcPath = NULL;
+    int i;
+
+    memset( &xOptions, 0, sizeof( xOptions ) );
+    xOptions.ulRandomTasks = 5;
+    xOptions.dRandomUtilisation = 0.9;
+    xOptions.ulSeed = 1;
+    xOptions.ulCores = 1;
+
+    for( i = 1; i < argc; i++ )
+    {
+        if( strcmp( argv[ i ], "--quiet" ) == 0 )
+        {
+            xOptions.lQuiet = 1;
+        }
+        else if( i + 1 == argc )
+        {
+            if( argv[ i ][ 0 ] == '-' )
+            {
+                prvUsage();
+            }
+
+            pcPath = argv[ i ];
+        }
+        else if( strcmp( argv[ i ], "--cs" ) == 0 )
+        {
+            if( prvParseTicks( argv[ ++i ], &xOptions.xSwitchOverhead ) != 0 )
+            {
+                prvUsage();
+            }
+        }
+        else if( strcmp( argv[ i ], "--alarm" ) == 0 )
+        {
+            xOptions.lAlarmReleases = 1;
+
+            if( prvParseTicks( argv[ ++i ], &xOptions.xAlarmOverhead ) != 0 )
+            {
+                prvUsage();
+            }
+        }
+        else if( strcmp( argv[ i ], "--tick-isr" ) == 0 )
+        {
+            if( prvParseTicks( argv[ ++i ], &xOptions.xTickOverhead ) != 0 )
+            {
+                prvUsage();
+            }
+        }
+        else if( strcmp( argv[ i ], "--horizon" ) == 0 )
+        {
+            if( prvParseTicks( argv[ ++i ], &xOptions.xHorizon ) != 0 )
+            {
+                prvUsage();
+            }
+        }
+        else if( strcmp( argv[ i ], "--admission" ) == 0 )
+        {
+            return prvRunAdmission( argv[ ++i ] );
+        }
+        else if( strcmp( argv[ i ], "--random" ) == 0 )
+        {
+            xOptions.ulRandomSets = strtoul( argv[ ++i ], NULL, 0 );
+        }
+        else if( strcmp( argv[ i ], "--tasks" ) == 0 )
+        {
+            xOptions.ulRandomTasks = strtoul( argv[ ++i ], NULL, 0 );
+        }
+        else if( strcmp( argv[ i ], "--util" ) == 0 )
+        {
+            xOptions.dRandomUtilisation = strtod( argv[ ++i ], NULL );
+        }
+        else if( strcmp( argv[ i ], "--cores" ) == 0 )
+        {
+            xOptions.ulCores = strtoul( argv[ ++i ], NULL, 0 );
+
+            if( ( xOptions.ulCores == 0 ) || ( xOptions.ulCores > toolMAX_CORES ) )
+            {
+                prvUsage();
+            }
+        }
+        else if( strcmp( argv[ i ], "--seed" ) == 0 )
+        {
+            xOptions.ulSeed = strtoul( argv[ ++i ], NULL, 0 );
+        }
+        else
+        {
+            prvUsage();
+        }
+    }
+
+    if( xOptions.ulRandomSets != 0 )
+    {
+        if( ( pcPath != NULL ) || ( xOptions.ulRandomTasks == 0 ) || ( xOptions.ulRandomTasks > edfSIM_MAX_TASKS ) )
+        {
+            prvUsage();
+        }
+
+        if( xOptions.ulCores > 1 )
+        {
+            return prvRunSmp( &xOptions );
+        }
+
+        return prvRunRandom( &xOptions );
+    }
+
+    if( pcPath == NULL )
+    {
+        prvUsage();
+    }
+
+    return prvRunFile( pcPath, &xOptions );
+}
@@ -0,0 +1,168 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * Heap call recorder. See heap_record.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "heap_record.h"
+
+typedef struct HEAP_RECORD_ENTRY
+{
+    void * pv;
+    size_t xSize;                   /* 0 for a free. */
+} HeapRecordEntry_t;
+
+void * __real_pvPortMalloc( size_t xWantedSize );
+void __real_vPortFree( void * pv );
+void * __wrap_pvPortMalloc( size_t xWantedSize );
+void __wrap_vPortFree( void * pv );
+
+/*
+ * Appends a call, or counts it as dropped. Called with the scheduler
+ * suspended.
+ */
+static void prvRecord( void * pv,
+                       size_t xSize );
+
+static void prvRecordTask( void * pvParameters );
+
+/*-----------------------------------------------------------*/
+
+static HeapRecordEntry_t xEntries[ configHEAP_RECORD_LENGTH ];
+static size_t xEntryCount = 0;
+static uint32_t ulDropped = 0;
+static BaseType_t xStopped = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static void prvRecord( void * pv,
+                       size_t xSize )
+{
+    if( ( xStopped == pdFALSE ) && ( xEntryCount < configHEAP_RECORD_LENGTH ) )
+    {
+        xEntries[ xEntryCount ].pv = pv;
+        xEntries[ xEntryCount ].xSize = xSize;
+        xEntryCount++;
+    }
+    else
+    {
+        ulDropped++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void * __wrap_pvPortMalloc( size_t xWantedSize )
+{
+    void * pv;
+
+    /* The call and its record must not be separated by another call, or the
+    replay could free a block before allocating it. */
+    vTaskSuspendAll();
+    {
+        pv = __real_pvPortMalloc( xWantedSize );
+
+        if( pv != NULL )
+        {
+            prvRecord( pv, xWantedSize );
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return pv;
+}
+/*-----------------------------------------------------------*/
+
+void __wrap_vPortFree( void * pv )
+{
+    if( pv != NULL )
+    {
+        vTaskSuspendAll();
+        {
+            prvRecord( pv, 0 );
+            __real_vPortFree( pv );
+        }
+        ( void ) xTaskResumeAll();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vHeapRecordPrint( void )
+{
+    size_t x;
+
+    vTaskSuspendAll();
+    {
+        xStopped = pdTRUE;
+    }
+    ( void ) xTaskResumeAll();
+
+    /* Nothing is added once stopped, so the entries can be read without
+    holding off the other tasks. */
+    printf( "heaprecord begin\n" );
+
+    for( x = 0; x < xEntryCount; x++ )
+    {
+        if( xEntries[ x ].xSize != 0 )
+        {
+            printf( "m %08lx %lu\n", ( unsigned long ) ( uintptr_t ) xEntries[ x ].pv, ( unsigned long ) xEntries[ x ].xSize );
+        }
+        else
+        {
+            printf( "f %08lx\n", ( unsigned long ) ( uintptr_t ) xEntries[ x ].pv );
+        }
+    }
+
+    printf( "heaprecord end %lu calls, %lu dropped\n", ( unsigned long ) xEntryCount, ( unsigned long ) ulDropped );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordTask( void * pvParameters )
+{
+    vTaskDelay( ( TickType_t ) ( uintptr_t ) pvParameters );
+    vHeapRecordPrint();
+
+    /* Deleting the task would free its stack, which is not worth a record. */
+    for( ;; )
+    {
+        vTaskDelay( portMAX_DELAY );
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xHeapRecordTaskCreate( UBaseType_t uxPriority,
+                                  TickType_t xDelay )
+{
+    return xTaskCreate( prvRecordTask, "HeapRec", configMINIMAL_STACK_SIZE * 2, ( void * ) ( uintptr_t ) xDelay, uxPriority, NULL );
+}
+/*-----------------------------------------------------------*/
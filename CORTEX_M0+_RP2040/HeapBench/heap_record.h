@@ -0,0 +1,70 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef HEAP_RECORD_H
+#define HEAP_RECORD_H
+
+/*
+ * Records the pvPortMalloc() and vPortFree() calls made by a demo, so that
+ * they can be replayed by heapbench_tool on the host, or built into
+ * main_heapbench, against each of the kernel's heap implementations.
+ *
+ * The calls are intercepted by linking with
+ *     -Wl,--wrap=pvPortMalloc,--wrap=vPortFree
+ * which routes every call made from outside the heap's own source file
+ * through __wrap_pvPortMalloc() and __wrap_vPortFree() below. The first
+ * configHEAP_RECORD_LENGTH calls from boot are kept in a static buffer;
+ * calls after it fills, or after recording stops, are counted but not
+ * kept, so the trace is always a consistent prefix of the demo's calls.
+ *
+ * vHeapRecordPrint() stops recording and prints the trace, one call per
+ * line, as
+ *     m <address> <bytes>
+ *     f <address>
+ * between heaprecord begin and end lines. heapbench_tool reads these lines
+ * out of a serial log and ignores everything else.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef configHEAP_RECORD_LENGTH
+    #define configHEAP_RECORD_LENGTH    1024
+#endif
+
+/*
+ * Stops recording, then prints the calls recorded so far.
+ */
+void vHeapRecordPrint( void );
+
+/*
+ * Creates a task at uxPriority that prints the trace xDelay ticks after the
+ * scheduler starts, and then does nothing.
+ */
+BaseType_t xHeapRecordTaskCreate( UBaseType_t uxPriority,
+                                  TickType_t xDelay );
+
+#endif /* HEAP_RECORD_H */
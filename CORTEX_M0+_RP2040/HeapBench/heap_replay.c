@@ -0,0 +1,480 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#include "heap_replay.h"
+
+/* Largest slot table xHeapBenchGenerate() can track. */
+#define heapbenchMAX_GENERATED_SLOTS    1024
+
+/* The random patterns keep about this many percent of the heap in use. */
+#define heapbenchTARGET_PERCENT         60
+
+/* Block size left as holes by eHeapBenchFragment. */
+#define heapbenchHOLE_SIZE              64
+
+/*-----------------------------------------------------------*/
+
+/* Size of the block held in each slot while generating, 0 if free. */
+static uint32_t ulSlotSize[ heapbenchMAX_GENERATED_SLOTS ];
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRand( uint32_t * pulState )
+{
+    uint32_t ulX = *pulState;
+
+    /* xorshift32. */
+    ulX ^= ulX << 13;
+    ulX ^= ulX >> 17;
+    ulX ^= ulX << 5;
+    *pulState = ulX;
+
+    return ulX;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns a slot whose block is live if xLive is non-zero, or free if not,
+starting the search at a random slot. There must be one. */
+static uint32_t prvPickSlot( uint32_t * pulState, size_t xSlots, int xLive )
+{
+    uint32_t ulSlot = prvRand( pulState ) % xSlots;
+
+    while( ( ulSlotSize[ ulSlot ] != 0 ) != ( xLive != 0 ) )
+    {
+        ulSlot = ( ulSlot + 1 ) % xSlots;
+    }
+
+    return ulSlot;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPickSize( HeapBenchPattern_t ePattern, uint32_t * pulState, size_t xHeapSize )
+{
+    static const uint32_t ulFixedSizes[] = { 16, 32, 64, 96, 128 };
+    uint32_t ulSize, ulScale;
+
+    if( ePattern == eHeapBenchFixed )
+    {
+        ulSize = ulFixedSizes[ prvRand( pulState ) % ( sizeof( ulFixedSizes ) / sizeof( ulFixedSizes[ 0 ] ) ) ];
+    }
+    else
+    {
+        /* Roughly as many small blocks as large ones on a log scale. */
+        ulScale = 8u << ( prvRand( pulState ) % 8 );
+        ulSize = ulScale + ( prvRand( pulState ) % ulScale );
+    }
+
+    if( ulSize > xHeapSize / 8 )
+    {
+        ulSize = ( uint32_t ) ( xHeapSize / 8 );
+    }
+
+    return ( ulSize != 0 ) ? ulSize : 1;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvGenerateRandom( HeapBenchPattern_t ePattern,
+                                 uint32_t * pulState,
+                                 size_t xHeapSize,
+                                 size_t xSlots,
+                                 HeapBenchOp_t * pxOps,
+                                 size_t xMaxOps )
+{
+    const size_t xTarget = xHeapSize * heapbenchTARGET_PERCENT / 100;
+    size_t xCount = 0, xLive = 0, xLiveBytes = 0;
+    uint32_t ulSlot, ulDraw;
+    int lAllocate;
+
+    /* Leave room to free every block at the end. */
+    while( xCount + xLive + 1 < xMaxOps )
+    {
+        ulDraw = prvRand( pulState ) % 4;
+
+        if( xLive == 0 )
+        {
+            lAllocate = 1;
+        }
+        else if( xLive == xSlots )
+        {
+            lAllocate = 0;
+        }
+        else if( xLiveBytes < xTarget )
+        {
+            lAllocate = ( ulDraw != 0 );
+        }
+        else
+        {
+            lAllocate = ( ulDraw == 0 );
+        }
+
+        if( lAllocate != 0 )
+        {
+            ulSlot = prvPickSlot( pulState, xSlots, 0 );
+            ulSlotSize[ ulSlot ] = prvPickSize( ePattern, pulState, xHeapSize );
+            pxOps[ xCount ].ulSize = ulSlotSize[ ulSlot ];
+            xLiveBytes += ulSlotSize[ ulSlot ];
+            xLive++;
+        }
+        else
+        {
+            ulSlot = prvPickSlot( pulState, xSlots, 1 );
+            pxOps[ xCount ].ulSize = 0;
+            xLiveBytes -= ulSlotSize[ ulSlot ];
+            ulSlotSize[ ulSlot ] = 0;
+            xLive--;
+        }
+
+        pxOps[ xCount++ ].ulSlot = ulSlot;
+    }
+
+    for( ulSlot = 0; ulSlot < xSlots; ulSlot++ )
+    {
+        if( ulSlotSize[ ulSlot ] != 0 )
+        {
+            pxOps[ xCount ].ulSlot = ulSlot;
+            pxOps[ xCount++ ].ulSize = 0;
+        }
+    }
+
+    return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvGenerateFragment( size_t xHeapSize,
+                                   size_t xSlots,
+                                   HeapBenchOp_t * pxOps,
+                                   size_t xMaxOps )
+{
+    size_t xBlocks, xCount = 0, x;
+
+    /* Fill nine tenths of the heap with small blocks, allowing 16 bytes of
+    overhead for each, then free every other one. Each request that follows
+    is too big for any hole, so it is only satisfied from what is left at
+    the end of the heap, and once that is used it fails after searching
+    every hole. */
+    xBlocks = ( xHeapSize * 9 / 10 ) / ( heapbenchHOLE_SIZE + 16 );
+
+    if( xBlocks > xSlots )
+    {
+        xBlocks = xSlots;
+    }
+
+    if( xBlocks > xMaxOps / 3 )
+    {
+        xBlocks = xMaxOps / 3;
+    }
+
+    xBlocks &= ~( size_t ) 1;
+
+    for( x = 0; x < xBlocks; x++ )
+    {
+        pxOps[ xCount ].ulSlot = ( uint32_t ) x;
+        pxOps[ xCount++ ].ulSize = heapbenchHOLE_SIZE;
+    }
+
+    for( x = 0; x < xBlocks; x += 2 )
+    {
+        pxOps[ xCount ].ulSlot = ( uint32_t ) x;
+        pxOps[ xCount++ ].ulSize = 0;
+    }
+
+    for( x = 0; x < xBlocks; x += 2 )
+    {
+        pxOps[ xCount ].ulSlot = ( uint32_t ) x;
+        pxOps[ xCount++ ].ulSize = heapbenchHOLE_SIZE * 3;
+    }
+
+    for( x = 0; x < xBlocks; x++ )
+    {
+        pxOps[ xCount ].ulSlot = ( uint32_t ) x;
+        pxOps[ xCount++ ].ulSize = 0;
+    }
+
+    return xCount;
+}
+/*-----------------------------------------------------------*/
+
+size_t xHeapBenchGenerate( HeapBenchPattern_t ePattern,
+                           uint32_t ulSeed,
+                           size_t xHeapSize,
+                           size_t xSlots,
+                           HeapBenchOp_t * pxOps,
+                           size_t xMaxOps )
+{
+    uint32_t ulState = ( ulSeed != 0 ) ? ulSeed : 0x9E3779B9UL;
+    size_t x;
+
+    if( ( xSlots == 0 ) || ( xSlots > heapbenchMAX_GENERATED_SLOTS ) || ( xMaxOps < 4 ) )
+    {
+        return 0;
+    }
+
+    for( x = 0; x < xSlots; x++ )
+    {
+        ulSlotSize[ x ] = 0;
+    }
+
+    switch( ePattern )
+    {
+        case eHeapBenchFixed:
+        case eHeapBenchRandom:
+            return prvGenerateRandom( ePattern, &ulState, xHeapSize, xSlots, pxOps, xMaxOps );
+
+        case eHeapBenchFragment:
+            return prvGenerateFragment( xHeapSize, xSlots, pxOps, xMaxOps );
+
+        default:
+            return 0;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTime( const HeapBenchTimer_t * pxTimer, uint32_t ulStart, uint32_t ulOverhead )
+{
+    uint32_t ulTime = pxTimer->ulElapsed( ulStart );
+
+    return ( ulTime > ulOverhead ) ? ( ulTime - ulOverhead ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+/* Updates the free space figures, and returns the fragmentation now. */
+static uint32_t prvSample( const HeapBenchHeap_t * pxHeap,
+                           HeapBenchStats_t * pxStats,
+                           size_t * pxFreeBytes,
+                           size_t * pxLargestBlock )
+{
+    uint32_t ulFragmentation = 0;
+
+    *pxFreeBytes = ( pxHeap->xFreeBytes != NULL ) ? pxHeap->xFreeBytes() : SIZE_MAX;
+    *pxLargestBlock = ( pxHeap->xLargestBlock != NULL ) ? pxHeap->xLargestBlock() : SIZE_MAX;
+
+    if( *pxFreeBytes < pxStats->xMinFreeBytes )
+    {
+        pxStats->xMinFreeBytes = *pxFreeBytes;
+    }
+
+    if( *pxLargestBlock < pxStats->xMinLargestBlock )
+    {
+        pxStats->xMinLargestBlock = *pxLargestBlock;
+    }
+
+    if( ( *pxFreeBytes != SIZE_MAX ) && ( *pxLargestBlock != SIZE_MAX ) && ( *pxLargestBlock < *pxFreeBytes ) )
+    {
+        ulFragmentation = ( uint32_t ) ( 100 - ( ( uint64_t ) *pxLargestBlock * 100 ) / *pxFreeBytes );
+
+        if( ulFragmentation > pxStats->ulWorstFragmentation )
+        {
+            pxStats->ulWorstFragmentation = ulFragmentation;
+        }
+    }
+
+    return ulFragmentation;
+}
+/*-----------------------------------------------------------*/
+
+int lHeapBenchReplay( const HeapBenchHeap_t * pxHeap,
+                      const HeapBenchTimer_t * pxTimer,
+                      const HeapBenchOp_t * pxOps,
+                      size_t xOpCount,
+                      void ** ppvSlots,
+                      size_t xSlots,
+                      size_t xSampleInterval,
+                      HeapBenchSampleCallback_t pxCallback,
+                      void * pvContext,
+                      HeapBenchStats_t * pxStats )
+{
+    const HeapBenchOp_t * pxOp;
+    size_t x, xFreeBytes, xLargestBlock;
+    uint32_t ulStart, ulTime, ulFragmentation = 0;
+    void * pv;
+    HeapBenchStats_t xZero = { 0 };
+
+    *pxStats = xZero;
+    pxStats->ulAllocMin = UINT32_MAX;
+    pxStats->ulFreeMin = UINT32_MAX;
+    pxStats->xMinFreeBytes = SIZE_MAX;
+    pxStats->xMinLargestBlock = SIZE_MAX;
+
+    /* The cost of reading the clock, taken off every measurement. */
+    pxStats->ulTimerOverhead = UINT32_MAX;
+
+    for( x = 0; x < 8; x++ )
+    {
+        ulStart = pxTimer->ulStart();
+        ulTime = pxTimer->ulElapsed( ulStart );
+
+        if( ulTime < pxStats->ulTimerOverhead )
+        {
+            pxStats->ulTimerOverhead = ulTime;
+        }
+    }
+
+    if( pxHeap->vInit != NULL )
+    {
+        pxHeap->vInit();
+    }
+
+    for( x = 0; x < xSlots; x++ )
+    {
+        ppvSlots[ x ] = NULL;
+    }
+
+    for( x = 0; x < xOpCount; x++ )
+    {
+        pxOp = &pxOps[ x ];
+
+        if( pxOp->ulSlot >= xSlots )
+        {
+            return -1;
+        }
+
+        if( pxOp->ulSize != 0 )
+        {
+            ulStart = pxTimer->ulStart();
+            pv = pxHeap->pvMalloc( pxOp->ulSize );
+            ulTime = prvTime( pxTimer, ulStart, pxStats->ulTimerOverhead );
+
+            if( pv == NULL )
+            {
+                pxStats->ulFailures++;
+
+                if( ulTime > pxStats->ulFailMax )
+                {
+                    pxStats->ulFailMax = ulTime;
+                }
+            }
+            else
+            {
+                pxStats->ulAllocs++;
+                pxStats->ullAllocTotal += ulTime;
+
+                if( ulTime < pxStats->ulAllocMin )
+                {
+                    pxStats->ulAllocMin = ulTime;
+                }
+
+                if( ulTime > pxStats->ulAllocMax )
+                {
+                    pxStats->ulAllocMax = ulTime;
+                }
+
+                if( ulFragmentation >= heapbenchFRAGMENTED_PERCENT )
+                {
+                    pxStats->ulFragmentedAllocs++;
+
+                    if( ulTime > pxStats->ulFragmentedAllocMax )
+                    {
+                        pxStats->ulFragmentedAllocMax = ulTime;
+                    }
+                }
+            }
+
+            /* A block left in the slot by a trace that lost its free. */
+            if( ( ppvSlots[ pxOp->ulSlot ] != NULL ) && ( pxHeap->vFree != NULL ) )
+            {
+                pxHeap->vFree( ppvSlots[ pxOp->ulSlot ] );
+            }
+
+            ppvSlots[ pxOp->ulSlot ] = pv;
+        }
+        else if( ( ppvSlots[ pxOp->ulSlot ] == NULL ) || ( pxHeap->vFree == NULL ) )
+        {
+            pxStats->ulSkippedFrees++;
+            ppvSlots[ pxOp->ulSlot ] = NULL;
+        }
+        else
+        {
+            ulStart = pxTimer->ulStart();
+            pxHeap->vFree( ppvSlots[ pxOp->ulSlot ] );
+            ulTime = prvTime( pxTimer, ulStart, pxStats->ulTimerOverhead );
+            ppvSlots[ pxOp->ulSlot ] = NULL;
+
+            pxStats->ulFrees++;
+            pxStats->ullFreeTotal += ulTime;
+
+            if( ulTime < pxStats->ulFreeMin )
+            {
+                pxStats->ulFreeMin = ulTime;
+            }
+
+            if( ulTime > pxStats->ulFreeMax )
+            {
+                pxStats->ulFreeMax = ulTime;
+            }
+        }
+
+        ulFragmentation = prvSample( pxHeap, pxStats, &xFreeBytes, &xLargestBlock );
+
+        if( ( pxCallback != NULL ) && ( xSampleInterval != 0 ) &&
+            ( ( ( x + 1 ) % xSampleInterval == 0 ) || ( x + 1 == xOpCount ) ) )
+        {
+            pxCallback( x + 1, xFreeBytes, xLargestBlock, pvContext );
+        }
+    }
+
+    if( pxHeap->vFree != NULL )
+    {
+        for( x = 0; x < xSlots; x++ )
+        {
+            if( ppvSlots[ x ] != NULL )
+            {
+                pxHeap->vFree( ppvSlots[ x ] );
+                ppvSlots[ x ] = NULL;
+            }
+        }
+    }
+
+    if( pxStats->ulAllocs == 0 )
+    {
+        pxStats->ulAllocMin = 0;
+    }
+
+    if( pxStats->ulFrees == 0 )
+    {
+        pxStats->ulFreeMin = 0;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+const char * pcHeapBenchPatternName( HeapBenchPattern_t ePattern )
+{
+    switch( ePattern )
+    {
+        case eHeapBenchFixed:
+            return "fixed";
+
+        case eHeapBenchRandom:
+            return "random";
+
+        case eHeapBenchFragment:
+            return "fragment";
+
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef HEAP_REPLAY_H
+#define HEAP_REPLAY_H
+
+/*
+ * Replays allocation traces against a FreeRTOS heap implementation and
+ * measures the time taken by every pvPortMalloc() and vPortFree() call.
+ *
+ * A trace is a list of operations on numbered slots: allocate a given
+ * number of bytes into a slot, or free the block held in a slot. Traces are
+ * either generated here, from a seed, so that the host and the target
+ * replay exactly the same operations, or recorded from a running demo by
+ * heap_record.c and converted by heapbench_tool.
+ *
+ * The heap is reached through a table of functions, so that one image can
+ * hold several heap implementations side by side (see heapbench_heaps.h),
+ * and the clock through another, so that the target can count processor
+ * cycles while the host counts nanoseconds.
+ *
+ * Fragmentation is 100 - 100 * largest allocatable block / free bytes, in
+ * percent, and is sampled after every operation when the heap can report
+ * both figures. Allocations made while it is at or above
+ * heapbenchFRAGMENTED_PERCENT are also counted separately, as are failed
+ * allocations, which are usually the slowest because the whole free list
+ * is searched.
+ *
+ * Nothing here allocates memory or uses stdio, so it may be built into
+ * firmware as well as host tools.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef heapbenchFRAGMENTED_PERCENT
+    #define heapbenchFRAGMENTED_PERCENT    50
+#endif
+
+typedef struct HEAP_BENCH_OP
+{
+    uint32_t ulSlot;                /* Index into the slot table. */
+    uint32_t ulSize;                /* Bytes to allocate into the slot, or 0 to free it. */
+} HeapBenchOp_t;
+
+typedef enum
+{
+    eHeapBenchFixed = 0,            /* A few small sizes, as used by kernel objects. */
+    eHeapBenchRandom,               /* Sizes from 8 to 2047 bytes with random lifetimes. */
+    eHeapBenchFragment              /* Holes of one size, then requests that do not fit them. */
+} HeapBenchPattern_t;
+
+typedef struct HEAP_BENCH_HEAP
+{
+    const char * pcName;
+    void ( * vInit )( void );                   /* Called before the first allocation. May be NULL. */
+    void * ( * pvMalloc )( size_t xSize );
+    void ( * vFree )( void * pv );              /* NULL if the heap cannot free. */
+    size_t ( * xFreeBytes )( void );            /* NULL if unknown. */
+    size_t ( * xLargestBlock )( void );         /* Largest allocation that would succeed. NULL if unknown. */
+} HeapBenchHeap_t;
+
+typedef struct HEAP_BENCH_TIMER
+{
+    uint32_t ( * ulStart )( void );
+    uint32_t ( * ulElapsed )( uint32_t ulStart );   /* Time since ulStart() returned ulStart. */
+} HeapBenchTimer_t;
+
+typedef struct HEAP_BENCH_STATS
+{
+    uint32_t ulAllocs;              /* Allocations that succeeded. */
+    uint32_t ulFailures;            /* Allocations that returned NULL. */
+    uint32_t ulFrees;
+    uint32_t ulSkippedFrees;        /* Frees of failed allocations, or on a heap that cannot free. */
+    uint32_t ulAllocMin;
+    uint32_t ulAllocMax;
+    uint64_t ullAllocTotal;
+    uint32_t ulFreeMin;
+    uint32_t ulFreeMax;
+    uint64_t ullFreeTotal;
+    uint32_t ulFailMax;             /* Slowest failed allocation. */
+    uint32_t ulFragmentedAllocs;    /* Allocations made while fragmented. */
+    uint32_t ulFragmentedAllocMax;  /* Slowest of those. */
+    uint32_t ulWorstFragmentation;  /* Percent. */
+    size_t xMinFreeBytes;           /* SIZE_MAX if the heap cannot report it. */
+    size_t xMinLargestBlock;        /* SIZE_MAX if the heap cannot report it. */
+    uint32_t ulTimerOverhead;       /* Subtracted from every time above. */
+} HeapBenchStats_t;
+
+/*
+ * Called every xSampleInterval operations, and after the last one, with
+ * the free bytes and largest allocatable block, each SIZE_MAX if unknown.
+ */
+typedef void ( * HeapBenchSampleCallback_t )( size_t xOp,
+                                              size_t xFreeBytes,
+                                              size_t xLargestBlock,
+                                              void * pvContext );
+
+/*
+ * Generates a trace of at most xMaxOps operations on xSlots slots into
+ * pxOps, sized for a heap of xHeapSize bytes. Every block is freed by the
+ * end of the trace. Returns the number of operations, or 0 if xSlots or
+ * xMaxOps is too small.
+ */
+size_t xHeapBenchGenerate( HeapBenchPattern_t ePattern,
+                           uint32_t ulSeed,
+                           size_t xHeapSize,
+                           size_t xSlots,
+                           HeapBenchOp_t * pxOps,
+                           size_t xMaxOps );
+
+/*
+ * Replays xOpCount operations against pxHeap, using ppvSlots, which has
+ * xSlots entries, to hold the live blocks. Blocks still allocated at the
+ * end are freed without being timed. pxCallback may be NULL.
+ *
+ * Returns 0 on success or -1 if an operation names a slot beyond xSlots.
+ */
+int lHeapBenchReplay( const HeapBenchHeap_t * pxHeap,
+                      const HeapBenchTimer_t * pxTimer,
+                      const HeapBenchOp_t * pxOps,
+                      size_t xOpCount,
+                      void ** ppvSlots,
+                      size_t xSlots,
+                      size_t xSampleInterval,
+                      HeapBenchSampleCallback_t pxCallback,
+                      void * pvContext,
+                      HeapBenchStats_t * pxStats );
+
+/*
+ * Returns a short name for ePattern.
+ */
+const char * pcHeapBenchPatternName( HeapBenchPattern_t ePattern );
+
+#endif /* HEAP_REPLAY_H */
@@ -0,0 +1,74 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * heap_1.c from the kernel, renamed so that it can be linked alongside the
+ * heap the kernel uses. See heapbench_heaps.h.
+ */
+
+#define pvPortMalloc                        pvHeapBench1Malloc
+#define pvPortCalloc                        pvHeapBench1Calloc
+#define vPortFree                           vHeapBench1Free
+#define xPortGetFreeHeapSize                xHeapBench1GetFreeHeapSize
+#define xPortGetMinimumEverFreeHeapSize     xHeapBench1GetMinimumEverFreeHeapSize
+#define vPortInitialiseBlocks               vHeapBench1InitialiseBlocks
+#define vPortGetHeapStats                   vHeapBench1GetHeapStats
+#define vPortHeapResetState                 vHeapBench1HeapResetState
+#define vPortDefineHeapRegions              vHeapBench1DefineHeapRegions
+
+#include "FreeRTOS.h"
+#include "heapbench_heaps.h"
+
+/* A failed allocation is a result here, not an error. */
+#undef configUSE_MALLOC_FAILED_HOOK
+#define configUSE_MALLOC_FAILED_HOOK        0
+
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE               heapbenchHEAP_SIZE
+#undef configAPPLICATION_ALLOCATED_HEAP
+#define configAPPLICATION_ALLOCATED_HEAP    0
+
+#include "portable/MemMang/heap_1.c"
+
+/*-----------------------------------------------------------*/
+
+static size_t prvLargestBlock( void )
+{
+    /* The free space is one block, and sizes are rounded up to the
+    alignment. */
+    return xHeapBench1GetFreeHeapSize() & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+}
+/*-----------------------------------------------------------*/
+
+const HeapBenchHeap_t xHeapBenchHeap1 =
+{
+    .pcName = "heap_1",
+    .vInit = NULL,
+    .pvMalloc = pvHeapBench1Malloc,
+    .vFree = NULL,
+    .xFreeBytes = xHeapBench1GetFreeHeapSize,
+    .xLargestBlock = prvLargestBlock
+};
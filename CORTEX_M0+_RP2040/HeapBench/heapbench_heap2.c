@@ -0,0 +1,91 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * heap_2.c from the kernel, renamed so that it can be linked alongside the
+ * heap the kernel uses. See heapbench_heaps.h.
+ */
+
+#define pvPortMalloc                        pvHeapBench2Malloc
+#define pvPortCalloc                        pvHeapBench2Calloc
+#define vPortFree                           vHeapBench2Free
+#define xPortGetFreeHeapSize                xHeapBench2GetFreeHeapSize
+#define xPortGetMinimumEverFreeHeapSize     xHeapBench2GetMinimumEverFreeHeapSize
+#define vPortInitialiseBlocks               vHeapBench2InitialiseBlocks
+#define vPortGetHeapStats                   vHeapBench2GetHeapStats
+#define vPortHeapResetState                 vHeapBench2HeapResetState
+#define vPortDefineHeapRegions              vHeapBench2DefineHeapRegions
+
+#include "FreeRTOS.h"
+#include "heapbench_heaps.h"
+
+/* A failed allocation is a result here, not an error. */
+#undef configUSE_MALLOC_FAILED_HOOK
+#define configUSE_MALLOC_FAILED_HOOK        0
+
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE               heapbenchHEAP_SIZE
+#undef configAPPLICATION_ALLOCATED_HEAP
+#define configAPPLICATION_ALLOCATED_HEAP    0
+
+#include "portable/MemMang/heap_2.c"
+
+/*-----------------------------------------------------------*/
+
+static size_t prvLargestBlock( void )
+{
+    BlockLink_t * pxBlock;
+    size_t xLargest = 0;
+
+    /* heap_2 keeps no statistics, so walk its free list, which ends at
+    xEnd and is empty until the first allocation. */
+    vTaskSuspendAll();
+    {
+        for( pxBlock = xStart.pxNextFreeBlock;
+             ( pxBlock != NULL ) && ( pxBlock != &xEnd );
+             pxBlock = pxBlock->pxNextFreeBlock )
+        {
+            if( pxBlock->xBlockSize > xLargest )
+            {
+                xLargest = pxBlock->xBlockSize;
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return ( xLargest > heapSTRUCT_SIZE ) ? ( xLargest - heapSTRUCT_SIZE ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+const HeapBenchHeap_t xHeapBenchHeap2 =
+{
+    .pcName = "heap_2",
+    .vInit = NULL,
+    .pvMalloc = pvHeapBench2Malloc,
+    .vFree = vHeapBench2Free,
+    .xFreeBytes = xHeapBench2GetFreeHeapSize,
+    .xLargestBlock = prvLargestBlock
+};
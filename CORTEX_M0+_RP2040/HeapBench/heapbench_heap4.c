@@ -0,0 +1,77 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * heap_4.c from the kernel, renamed so that it can be linked alongside the
+ * heap the kernel uses. See heapbench_heaps.h.
+ */
+
+#define pvPortMalloc                        pvHeapBench4Malloc
+#define pvPortCalloc                        pvHeapBench4Calloc
+#define vPortFree                           vHeapBench4Free
+#define xPortGetFreeHeapSize                xHeapBench4GetFreeHeapSize
+#define xPortGetMinimumEverFreeHeapSize     xHeapBench4GetMinimumEverFreeHeapSize
+#define vPortInitialiseBlocks               vHeapBench4InitialiseBlocks
+#define vPortGetHeapStats                   vHeapBench4GetHeapStats
+#define vPortHeapResetState                 vHeapBench4HeapResetState
+#define vPortDefineHeapRegions              vHeapBench4DefineHeapRegions
+
+#include "FreeRTOS.h"
+#include "heapbench_heaps.h"
+
+/* A failed allocation is a result here, not an error. */
+#undef configUSE_MALLOC_FAILED_HOOK
+#define configUSE_MALLOC_FAILED_HOOK        0
+
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE               heapbenchHEAP_SIZE
+#undef configAPPLICATION_ALLOCATED_HEAP
+#define configAPPLICATION_ALLOCATED_HEAP    0
+
+#include "portable/MemMang/heap_4.c"
+
+/*-----------------------------------------------------------*/
+
+static size_t prvLargestBlock( void )
+{
+    HeapStats_t xStats;
+
+    vHeapBench4GetHeapStats( &xStats );
+
+    return ( xStats.xSizeOfLargestFreeBlockInBytes > xHeapStructSize ) ?
+           ( xStats.xSizeOfLargestFreeBlockInBytes - xHeapStructSize ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+const HeapBenchHeap_t xHeapBenchHeap4 =
+{
+    .pcName = "heap_4",
+    .vInit = NULL,
+    .pvMalloc = pvHeapBench4Malloc,
+    .vFree = vHeapBench4Free,
+    .xFreeBytes = xHeapBench4GetFreeHeapSize,
+    .xLargestBlock = prvLargestBlock
+};
@@ -0,0 +1,103 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * heap_5.c from the kernel, renamed so that it can be linked alongside the
+ * heap the kernel uses. See heapbench_heaps.h.
+ */
+
+#define pvPortMalloc                        pvHeapBench5Malloc
+#define pvPortCalloc                        pvHeapBench5Calloc
+#define vPortFree                           vHeapBench5Free
+#define xPortGetFreeHeapSize                xHeapBench5GetFreeHeapSize
+#define xPortGetMinimumEverFreeHeapSize     xHeapBench5GetMinimumEverFreeHeapSize
+#define vPortInitialiseBlocks               vHeapBench5InitialiseBlocks
+#define vPortGetHeapStats                   vHeapBench5GetHeapStats
+#define vPortHeapResetState                 vHeapBench5HeapResetState
+#define vPortDefineHeapRegions              vHeapBench5DefineHeapRegions
+
+#include "FreeRTOS.h"
+#include "heapbench_heaps.h"
+
+/* A failed allocation is a result here, not an error. */
+#undef configUSE_MALLOC_FAILED_HOOK
+#define configUSE_MALLOC_FAILED_HOOK        0
+
+#include "portable/MemMang/heap_5.c"
+
+/*-----------------------------------------------------------*/
+
+static size_t prvLargestBlock( void )
+{
+    HeapStats_t xStats;
+
+    vHeapBench5GetHeapStats( &xStats );
+
+    return ( xStats.xSizeOfLargestFreeBlockInBytes > xHeapStructSize ) ?
+           ( xStats.xSizeOfLargestFreeBlockInBytes - xHeapStructSize ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t ucRegion1[ heapbenchHEAP_SIZE / 2 ] __attribute__( ( aligned( portBYTE_ALIGNMENT ) ) );
+static uint8_t ucRegion2[ heapbenchHEAP_SIZE / 2 ] __attribute__( ( aligned( portBYTE_ALIGNMENT ) ) );
+
+static void prvInit( void )
+{
+    static BaseType_t xDefined = pdFALSE;
+    HeapRegion_t xRegions[ 3 ];
+    uint8_t * pucLow = ucRegion1, * pucHigh = ucRegion2;
+
+    if( xDefined == pdFALSE )
+    {
+        /* heap_5 needs the regions in address order. */
+        if( pucHigh < pucLow )
+        {
+            pucLow = ucRegion2;
+            pucHigh = ucRegion1;
+        }
+
+        xRegions[ 0 ].pucStartAddress = pucLow;
+        xRegions[ 0 ].xSizeInBytes = sizeof( ucRegion1 );
+        xRegions[ 1 ].pucStartAddress = pucHigh;
+        xRegions[ 1 ].xSizeInBytes = sizeof( ucRegion2 );
+        xRegions[ 2 ].pucStartAddress = NULL;
+        xRegions[ 2 ].xSizeInBytes = 0;
+
+        vHeapBench5DefineHeapRegions( xRegions );
+        xDefined = pdTRUE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+const HeapBenchHeap_t xHeapBenchHeap5 =
+{
+    .pcName = "heap_5",
+    .vInit = prvInit,
+    .pvMalloc = pvHeapBench5Malloc,
+    .vFree = vHeapBench5Free,
+    .xFreeBytes = xHeapBench5GetFreeHeapSize,
+    .xLargestBlock = prvLargestBlock
+};
@@ -0,0 +1,56 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef HEAPBENCH_HEAPS_H
+#define HEAPBENCH_HEAPS_H
+
+/*
+ * The kernel's heap_1, heap_2, heap_4 and heap_5, each built from
+ * portable/MemMang in the kernel by a heapbench_heapN.c file that renames
+ * its functions first, so that all four can be linked into one image
+ * alongside the heap the kernel itself uses. Each has its own
+ * heapbenchHEAP_SIZE bytes, heap_5 as two regions of half that size.
+ *
+ * The heaps cannot be reset, so each may be replayed against only once.
+ * A second replay would start from whatever state the first left behind:
+ * heap_1 cannot free, so once it is full every later allocation fails, and
+ * heap_2 never merges free blocks, so its fragmentation would carry over.
+ * main_heapbench is built once per trace for this reason, and
+ * heapbench_tool runs every replay in a child process.
+ */
+
+#include "heap_replay.h"
+
+#ifndef heapbenchHEAP_SIZE
+    #define heapbenchHEAP_SIZE    ( 16 * 1024 )
+#endif
+
+extern const HeapBenchHeap_t xHeapBenchHeap1;
+extern const HeapBenchHeap_t xHeapBenchHeap2;
+extern const HeapBenchHeap_t xHeapBenchHeap4;
+extern const HeapBenchHeap_t xHeapBenchHeap5;
+
+#endif /* HEAPBENCH_HEAPS_H */
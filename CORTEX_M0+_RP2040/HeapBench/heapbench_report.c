@@ -0,0 +1,142 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * Result printing for the heap benchmark. See heapbench_report.h.
+ */
+
+#include <stdio.h>
+
+#include "heapbench_report.h"
+
+/*-----------------------------------------------------------*/
+
+static void prvPrintSize( size_t xSize, int lWidth )
+{
+    if( xSize == SIZE_MAX )
+    {
+        printf( " %*s", lWidth, "-" );
+    }
+    else
+    {
+        printf( " %*lu", lWidth, ( unsigned long ) xSize );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long prvAverage( uint64_t ullTotal, uint32_t ulCount )
+{
+    return ( ulCount != 0 ) ? ( unsigned long ) ( ( ullTotal + ( ulCount / 2 ) ) / ulCount ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+size_t xHeapBenchSamplesInit( HeapBenchSamples_t * pxSamples,
+                              size_t xOpCount )
+{
+    pxSamples->xCount = 0;
+
+    /* The last operation is always sampled as well, so leave room for it. */
+    pxSamples->xInterval = ( xOpCount + heapbenchMAX_SAMPLES - 2 ) / ( heapbenchMAX_SAMPLES - 1 );
+
+    if( pxSamples->xInterval == 0 )
+    {
+        pxSamples->xInterval = 1;
+    }
+
+    return pxSamples->xInterval;
+}
+/*-----------------------------------------------------------*/
+
+void vHeapBenchSample( size_t xOp,
+                       size_t xFreeBytes,
+                       size_t xLargestBlock,
+                       void * pvContext )
+{
+    HeapBenchSamples_t * pxSamples = ( HeapBenchSamples_t * ) pvContext;
+
+    ( void ) xOp;
+    ( void ) xFreeBytes;
+
+    if( pxSamples->xCount < heapbenchMAX_SAMPLES )
+    {
+        pxSamples->xLargestBlock[ pxSamples->xCount++ ] = xLargestBlock;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vHeapBenchPrintHeading( const char * pcUnits )
+{
+    printf( "%-8s %6s %5s %22s %22s %8s %16s %8s %8s %5s\n",
+            "heap", "allocs", "fails", "alloc min/avg/max", "free min/avg/max",
+            "fail max", "fragmented n/max", "min free", "min big", "frag%" );
+    printf( "(times in %s, less the timer overhead)\n", pcUnits );
+}
+/*-----------------------------------------------------------*/
+
+void vHeapBenchPrintStats( const char * pcHeapName,
+                           const HeapBenchStats_t * pxStats,
+                           const HeapBenchSamples_t * pxSamples )
+{
+    char cAlloc[ 40 ], cFree[ 40 ], cFragmented[ 24 ];
+    size_t x;
+
+    snprintf( cAlloc, sizeof( cAlloc ), "%lu/%lu/%lu",
+              ( unsigned long ) pxStats->ulAllocMin,
+              prvAverage( pxStats->ullAllocTotal, pxStats->ulAllocs ),
+              ( unsigned long ) pxStats->ulAllocMax );
+    snprintf( cFree, sizeof( cFree ), "%lu/%lu/%lu",
+              ( unsigned long ) pxStats->ulFreeMin,
+              prvAverage( pxStats->ullFreeTotal, pxStats->ulFrees ),
+              ( unsigned long ) pxStats->ulFreeMax );
+    snprintf( cFragmented, sizeof( cFragmented ), "%lu/%lu",
+              ( unsigned long ) pxStats->ulFragmentedAllocs,
+              ( unsigned long ) pxStats->ulFragmentedAllocMax );
+
+    printf( "%-8s %6lu %5lu %22s %22s %8lu %16s",
+            pcHeapName,
+            ( unsigned long ) pxStats->ulAllocs,
+            ( unsigned long ) pxStats->ulFailures,
+            cAlloc,
+            cFree,
+            ( unsigned long ) pxStats->ulFailMax,
+            cFragmented );
+    prvPrintSize( pxStats->xMinFreeBytes, 8 );
+    prvPrintSize( pxStats->xMinLargestBlock, 8 );
+    printf( " %5lu\n", ( unsigned long ) pxStats->ulWorstFragmentation );
+
+    if( ( pxSamples != NULL ) && ( pxSamples->xCount != 0 ) && ( pxSamples->xLargestBlock[ 0 ] != SIZE_MAX ) )
+    {
+        printf( "         largest block every %lu operations:", ( unsigned long ) pxSamples->xInterval );
+
+        for( x = 0; x < pxSamples->xCount; x++ )
+        {
+            prvPrintSize( pxSamples->xLargestBlock[ x ], 0 );
+        }
+
+        printf( "\n" );
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,78 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef HEAPBENCH_REPORT_H
+#define HEAPBENCH_REPORT_H
+
+/*
+ * Prints the results of lHeapBenchReplay() with printf(), in the same
+ * format on the host and the target, one table row per heap followed by
+ * the largest allocatable block at each sample.
+ */
+
+#include "heap_replay.h"
+
+/* Maximum number of samples kept for one replay. */
+#ifndef heapbenchMAX_SAMPLES
+    #define heapbenchMAX_SAMPLES    16
+#endif
+
+typedef struct HEAP_BENCH_SAMPLES
+{
+    size_t xCount;
+    size_t xInterval;
+    size_t xLargestBlock[ heapbenchMAX_SAMPLES ];
+} HeapBenchSamples_t;
+
+/*
+ * Returns the sample interval that gives heapbenchMAX_SAMPLES samples over
+ * xOpCount operations, and empties pxSamples.
+ */
+size_t xHeapBenchSamplesInit( HeapBenchSamples_t * pxSamples,
+                              size_t xOpCount );
+
+/*
+ * A HeapBenchSampleCallback_t that appends to the HeapBenchSamples_t passed
+ * as pvContext.
+ */
+void vHeapBenchSample( size_t xOp,
+                       size_t xFreeBytes,
+                       size_t xLargestBlock,
+                       void * pvContext );
+
+/*
+ * Prints the table heading, with times in pcUnits.
+ */
+void vHeapBenchPrintHeading( const char * pcUnits );
+
+/*
+ * Prints one heap's row and, if pxSamples is not NULL, its samples.
+ */
+void vHeapBenchPrintStats( const char * pcHeapName,
+                           const HeapBenchStats_t * pxStats,
+                           const HeapBenchSamples_t * pxSamples );
+
+#endif /* HEAPBENCH_REPORT_H */
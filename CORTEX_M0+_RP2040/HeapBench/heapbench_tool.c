@@ -0,0 +1,539 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * heapbench_tool replays allocation traces against heap implementations on
+ * the host, using the same replay engine as the main_heapbench images on
+ * the target.
+ *
+ *   heapbench_tool [options]
+ *
+ * generates the fixed, random and fragment traces from the seed and
+ * replays each of them against every heap.
+ *
+ *   heapbench_tool [options] <log>
+ *
+ * replays a trace recorded by heap_record.c instead. The log may be the
+ * whole serial output of the demo; only the lines
+ *
+ *   m <address> <bytes>
+ *   f <address>
+ *
+ * are read. Each address is given the lowest free slot when allocated.
+ *
+ *   heapbench_tool --emit-c <log>
+ *
+ * writes the recorded trace to standard output as a C header, which
+ * main_heapbench_recorded replays if it is saved as
+ * HeapBench/recorded_trace.h.
+ *
+ * Every replay of a trace against a heap runs in a child process of its
+ * own, so that it starts from the heap's initial state. None of the
+ * kernel's heaps can be reset, and heap_1 in particular cannot free.
+ *
+ * The C library's malloc() is always measured. heap_1, heap_2, heap_4 and
+ * heap_5 are measured as well when the tool is built with
+ * FREERTOS_KERNEL_PATH set. Times are in nanoseconds from
+ * CLOCK_MONOTONIC, so only their relative sizes are comparable with the
+ * cycle counts printed by the target.
+ *
+ * Options:
+ *   --heap <name>     replay against this heap only
+ *   --seed <s>        seed for the generated traces (default 1)
+ *   --ops <n>         operations in each generated trace (default 4000)
+ *   --slots <n>       blocks live at once in generated traces (default 256)
+ *   --repeat <n>      replay each trace n times, each against a fresh heap,
+ *                     keeping the fastest average, to reduce noise from
+ *                     the host (default 1)
+ *
+ * Exit status: 0 on success, 1 if a trace could not be replayed and 2 for
+ * usage errors.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "heap_replay.h"
+#include "heapbench_report.h"
+
+#ifndef HEAPBENCH_FREERTOS_HEAPS
+    #define HEAPBENCH_FREERTOS_HEAPS    0
+#endif
+
+#if ( HEAPBENCH_FREERTOS_HEAPS == 1 )
+    #include "heapbench_heaps.h"
+#else
+    #define heapbenchHEAP_SIZE    ( 16 * 1024 )
+#endif
+
+#define toolMAX_OPS             65536
+#define toolMAX_SLOTS           1024
+
+typedef struct TOOL_OPTIONS
+{
+    const char * pcHeap;
+    unsigned long ulSeed;
+    unsigned long ulOps;
+    unsigned long ulSlots;
+    unsigned long ulRepeat;
+} ToolOptions_t;
+
+static HeapBenchOp_t xOps[ toolMAX_OPS ];
+static void * pvSlots[ toolMAX_SLOTS ];
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimerStart( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( uint32_t ) ( ( uint64_t ) xNow.tv_sec * 1000000000ULL + ( uint64_t ) xNow.tv_nsec );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimerElapsed( uint32_t ulStart )
+{
+    return prvTimerStart() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static const HeapBenchTimer_t xTimer = { prvTimerStart, prvTimerElapsed };
+
+/*-----------------------------------------------------------*/
+
+/* malloc() reports neither the free space nor the largest block. */
+static const HeapBenchHeap_t xMallocHeap =
+{
+    .pcName = "malloc",
+    .vInit = NULL,
+    .pvMalloc = malloc,
+    .vFree = free,
+    .xFreeBytes = NULL,
+    .xLargestBlock = NULL
+};
+
+static const HeapBenchHeap_t * const pxHeaps[] =
+{
+#if ( HEAPBENCH_FREERTOS_HEAPS == 1 )
+    &xHeapBenchHeap1,
+    &xHeapBenchHeap2,
+    &xHeapBenchHeap4,
+    &xHeapBenchHeap5,
+#endif
+    &xMallocHeap
+};
+
+#define toolHEAP_COUNT          ( sizeof( pxHeaps ) / sizeof( pxHeaps[ 0 ] ) )
+
+/*-----------------------------------------------------------*/
+
+/* Reads a recorded trace into xOps, and returns the number of operations.
+Sets *pxSlots to the number of slots used. */
+static size_t prvLoadTrace( const char * pcPath, size_t * pxSlots )
+{
+    static uintptr_t uxSlotAddress[ toolMAX_SLOTS ];
+    static uint8_t ucSlotLive[ toolMAX_SLOTS ];
+    char cLine[ 256 ], cOp[ 4 ];
+    unsigned long ulLine = 0, ulAddress, ulSize, ulUnknownFrees = 0;
+    size_t xCount = 0, xSlot, xUsed = 0;
+    int lFields;
+    FILE * pxFile;
+
+    pxFile = fopen( pcPath, "r" );
+
+    if( pxFile == NULL )
+    {
+        fprintf( stderr, "heapbench_tool: %s: %s\n", pcPath, strerror( errno ) );
+        exit( 2 );
+    }
+
+    while( fgets( cLine, sizeof( cLine ), pxFile ) != NULL )
+    {
+        ulLine++;
+        lFields = sscanf( cLine, "%3s %lx %lu", cOp, &ulAddress, &ulSize );
+
+        if( ( lFields < 2 ) || ( ( strcmp( cOp, "m" ) != 0 ) && ( strcmp( cOp, "f" ) != 0 ) ) )
+        {
+            continue;
+        }
+
+        if( xCount == toolMAX_OPS )
+        {
+            fprintf( stderr, "heapbench_tool: %s: more than %d operations\n", pcPath, toolMAX_OPS );
+            exit( 2 );
+        }
+
+        for( xSlot = 0; xSlot < xUsed; xSlot++ )
+        {
+            if( ( ucSlotLive[ xSlot ] != 0 ) && ( uxSlotAddress[ xSlot ] == ( uintptr_t ) ulAddress ) )
+            {
+                break;
+            }
+        }
+
+        if( cOp[ 0 ] == 'f' )
+        {
+            if( xSlot == xUsed )
+            {
+                /* Allocated before recording started. */
+                ulUnknownFrees++;
+                continue;
+            }
+
+            ucSlotLive[ xSlot ] = 0;
+            xOps[ xCount ].ulSize = 0;
+        }
+        else
+        {
+            if( ( lFields != 3 ) || ( ulSize == 0 ) || ( ulSize > UINT32_MAX ) )
+            {
+                fprintf( stderr, "heapbench_tool: %s:%lu: expected m <address> <bytes>\n", pcPath, ulLine );
+                exit( 2 );
+            }
+
+            if( xSlot != xUsed )
+            {
+                fprintf( stderr, "heapbench_tool: %s:%lu: %lx allocated twice\n", pcPath, ulLine, ulAddress );
+                exit( 2 );
+            }
+
+            for( xSlot = 0; ( xSlot < xUsed ) && ( ucSlotLive[ xSlot ] != 0 ); xSlot++ )
+            {
+            }
+
+            if( xSlot == toolMAX_SLOTS )
+            {
+                fprintf( stderr, "heapbench_tool: %s: more than %d blocks live at once\n", pcPath, toolMAX_SLOTS );
+                exit( 2 );
+            }
+
+            if( xSlot == xUsed )
+            {
+                xUsed++;
+            }
+
+            ucSlotLive[ xSlot ] = 1;
+            uxSlotAddress[ xSlot ] = ( uintptr_t ) ulAddress;
+            xOps[ xCount ].ulSize = ( uint32_t ) ulSize;
+        }
+
+        xOps[ xCount++ ].ulSlot = ( uint32_t ) xSlot;
+    }
+
+    fclose( pxFile );
+
+    if( ulUnknownFrees != 0 )
+    {
+        fprintf( stderr, "heapbench_tool: %s: ignored %lu frees of unknown blocks\n", pcPath, ulUnknownFrees );
+    }
+
+    *pxSlots = xUsed;
+
+    return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static int prvEmitC( const char * pcPath )
+{
+    size_t xCount, xSlots, x;
+
+    xCount = prvLoadTrace( pcPath, &xSlots );
+
+    if( xCount == 0 )
+    {
+        fprintf( stderr, "heapbench_tool: %s: no heap trace found\n", pcPath );
+        return 1;
+    }
+
+    printf( "/* Generated by heapbench_tool --emit-c from %s. */\n\n", pcPath );
+    printf( "#define heapbenchRECORDED_SLOTS    %lu\n\n", ( unsigned long ) xSlots );
+    printf( "static const HeapBenchOp_t xHeapBenchRecordedTrace[] =\n{\n" );
+
+    for( x = 0; x < xCount; x++ )
+    {
+        printf( "    { %lu, %lu },\n", ( unsigned long ) xOps[ x ].ulSlot, ( unsigned long ) xOps[ x ].ulSize );
+    }
+
+    printf( "};\n" );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+/* Replays xOps against pxHeap in a child process, which passes back the
+results through a pipe. The parent never touches the heaps itself, so every
+child starts with them as they were when the tool was started. Returns the
+result of lHeapBenchReplay(). */
+static int prvReplayInChild( const HeapBenchHeap_t * pxHeap,
+                             size_t xCount,
+                             size_t xSlots,
+                             HeapBenchStats_t * pxStats,
+                             HeapBenchSamples_t * pxSamples )
+{
+    struct
+    {
+        int lResult;
+        HeapBenchStats_t xStats;
+        HeapBenchSamples_t xSamples;
+    } xResult;
+    uint8_t * pucResult = ( uint8_t * ) &xResult;
+    size_t xInterval, xRead = 0;
+    ssize_t xBytes;
+    int lPipe[ 2 ], lStatus;
+    pid_t xChild;
+
+    if( pipe( lPipe ) != 0 )
+    {
+        fprintf( stderr, "heapbench_tool: pipe: %s\n", strerror( errno ) );
+        exit( 1 );
+    }
+
+    /* Otherwise the child would print the parent's buffered output again. */
+    fflush( stdout );
+
+    xChild = fork();
+
+    if( xChild < 0 )
+    {
+        fprintf( stderr, "heapbench_tool: fork: %s\n", strerror( errno ) );
+        exit( 1 );
+    }
+
+    if( xChild == 0 )
+    {
+        close( lPipe[ 0 ] );
+
+        memset( &xResult, 0, sizeof( xResult ) );
+        xInterval = xHeapBenchSamplesInit( &xResult.xSamples, xCount );
+        xResult.lResult = lHeapBenchReplay( pxHeap, &xTimer, xOps, xCount, pvSlots, xSlots,
+                                            xInterval, vHeapBenchSample, &xResult.xSamples, &xResult.xStats );
+
+        while( xRead < sizeof( xResult ) )
+        {
+            xBytes = write( lPipe[ 1 ], pucResult + xRead, sizeof( xResult ) - xRead );
+
+            if( xBytes <= 0 )
+            {
+                _exit( 1 );
+            }
+
+            xRead += ( size_t ) xBytes;
+        }
+
+        _exit( 0 );
+    }
+
+    close( lPipe[ 1 ] );
+
+    while( xRead < sizeof( xResult ) )
+    {
+        xBytes = read( lPipe[ 0 ], pucResult + xRead, sizeof( xResult ) - xRead );
+
+        if( xBytes <= 0 )
+        {
+            break;
+        }
+
+        xRead += ( size_t ) xBytes;
+    }
+
+    close( lPipe[ 0 ] );
+
+    if( ( waitpid( xChild, &lStatus, 0 ) != xChild ) || !WIFEXITED( lStatus ) ||
+        ( WEXITSTATUS( lStatus ) != 0 ) || ( xRead != sizeof( xResult ) ) )
+    {
+        fprintf( stderr, "heapbench_tool: replay against %s did not complete\n", pxHeap->pcName );
+        exit( 1 );
+    }
+
+    *pxStats = xResult.xStats;
+    *pxSamples = xResult.xSamples;
+
+    return xResult.lResult;
+}
+/*-----------------------------------------------------------*/
+
+static int prvReplay( const char * pcTrace,
+                      size_t xCount,
+                      size_t xSlots,
+                      const ToolOptions_t * pxOptions )
+{
+    HeapBenchStats_t xStats, xBest;
+    HeapBenchSamples_t xSamples;
+    size_t x;
+    unsigned long ulRun;
+    int lReplayed = 0;
+
+    printf( "\nTrace %s: %lu operations on %lu slots\n", pcTrace, ( unsigned long ) xCount, ( unsigned long ) xSlots );
+    vHeapBenchPrintHeading( "ns" );
+
+    for( x = 0; x < toolHEAP_COUNT; x++ )
+    {
+        if( ( pxOptions->pcHeap != NULL ) && ( strcmp( pxOptions->pcHeap, pxHeaps[ x ]->pcName ) != 0 ) )
+        {
+            continue;
+        }
+
+        for( ulRun = 0; ulRun < pxOptions->ulRepeat; ulRun++ )
+        {
+            if( prvReplayInChild( pxHeaps[ x ], xCount, xSlots, &xStats, &xSamples ) != 0 )
+            {
+                fprintf( stderr, "heapbench_tool: trace %s names a slot beyond %lu\n", pcTrace, ( unsigned long ) xSlots );
+                return 1;
+            }
+
+            if( ( ulRun == 0 ) || ( xStats.ullAllocTotal + xStats.ullFreeTotal < xBest.ullAllocTotal + xBest.ullFreeTotal ) )
+            {
+                xBest = xStats;
+            }
+        }
+
+        vHeapBenchPrintStats( pxHeaps[ x ]->pcName, &xBest, &xSamples );
+        lReplayed = 1;
+    }
+
+    if( lReplayed == 0 )
+    {
+        fprintf( stderr, "heapbench_tool: no heap named %s\n", pxOptions->pcHeap );
+        exit( 2 );
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvUsage( void )
+{
+    fprintf( stderr,
+             "usage: heapbench_tool [options] [<log>]\n"
+             "       heapbench_tool --emit-c <log>\n"
+             "options: --heap <name> --seed <s> --ops <n> --slots <n> --repeat <n>\n" );
+    exit( 2 );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char ** argv )
+{
+    static const HeapBenchPattern_t xPatterns[] = { eHeapBenchFixed, eHeapBenchRandom, eHeapBenchFragment };
+    ToolOptions_t xOptions;
+    const char * pcPath = NULL;
+    size_t xCount, xSlots, x;
+    int lResult = 0, i;
+
+    memset( &xOptions, 0, sizeof( xOptions ) );
+    xOptions.ulSeed = 1;
+    xOptions.ulOps = 4000;
+    xOptions.ulSlots = 256;
+    xOptions.ulRepeat = 1;
+
+    for( i = 1; i < argc; i++ )
+    {
+        if( i + 1 == argc )
+        {
+            if( argv[ i ][ 0 ] == '-' )
+            {
+                prvUsage();
+            }
+
+            pcPath = argv[ i ];
+        }
+        else if( strcmp( argv[ i ], "--emit-c" ) == 0 )
+        {
+            if( i + 2 != argc )
+            {
+                prvUsage();
+            }
+
+            return prvEmitC( argv[ ++i ] );
+        }
+        else if( strcmp( argv[ i ], "--heap" ) == 0 )
+        {
+            xOptions.pcHeap = argv[ ++i ];
+        }
+        else if( strcmp( argv[ i ], "--seed" ) == 0 )
+        {
+            xOptions.ulSeed = strtoul( argv[ ++i ], NULL, 0 );
+        }
+        else if( strcmp( argv[ i ], "--ops" ) == 0 )
+        {
+            xOptions.ulOps = strtoul( argv[ ++i ], NULL, 0 );
+        }
+        else if( strcmp( argv[ i ], "--slots" ) == 0 )
+        {
+            xOptions.ulSlots = strtoul( argv[ ++i ], NULL, 0 );
+        }
+        else if( strcmp( argv[ i ], "--repeat" ) == 0 )
+        {
+            xOptions.ulRepeat = strtoul( argv[ ++i ], NULL, 0 );
+        }
+        else
+        {
+            prvUsage();
+        }
+    }
+
+    if( ( xOptions.ulOps < 4 ) || ( xOptions.ulOps > toolMAX_OPS ) ||
+        ( xOptions.ulSlots == 0 ) || ( xOptions.ulSlots > toolMAX_SLOTS ) ||
+        ( xOptions.ulRepeat == 0 ) )
+    {
+        prvUsage();
+    }
+
+    printf( "Heaps of %lu bytes\n", ( unsigned long ) heapbenchHEAP_SIZE );
+
+    if( pcPath != NULL )
+    {
+        xCount = prvLoadTrace( pcPath, &xSlots );
+
+        if( xCount == 0 )
+        {
+            fprintf( stderr, "heapbench_tool: %s: no heap trace found\n", pcPath );
+            return 1;
+        }
+
+        return prvReplay( pcPath, xCount, xSlots, &xOptions );
+    }
+
+    for( x = 0; x < sizeof( xPatterns ) / sizeof( xPatterns[ 0 ] ); x++ )
+    {
+        xCount = xHeapBenchGenerate( xPatterns[ x ], ( uint32_t ) xOptions.ulSeed, heapbenchHEAP_SIZE,
+                                     xOptions.ulSlots, xOps, xOptions.ulOps );
+
+        if( ( xCount == 0 ) || ( prvReplay( pcHeapBenchPatternName( xPatterns[ x ] ), xCount, xOptions.ulSlots, &xOptions ) != 0 ) )
+        {
+            lResult = 1;
+        }
+    }
+
+    return lResult;
+}
@@ -0,0 +1,272 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * vChannelBenchCreateTasks() creates one task on the FreeRTOS core, and
+ * vChannelBenchSDKCore() serves it from the other core. Two channels
+ * connect them, one each way. Every five seconds the task runs:
+ *
+ *  - SDK core to task: the SDK core sends benchWORDS sequence numbers as
+ *    fast as the ring accepts them, and the task takes them with the
+ *    blocking xIntercoreChannelReceive(). Doorbells are only rung when the
+ *    task has emptied the ring and blocked.
+ *  - Task to SDK core: the same the other way, with the SDK core polling.
+ *  - Round trips: the task sends a word that the SDK core echoes, benchECHOES
+ *    times, first blocking for each reply, so that every reply is a doorbell
+ *    interrupt and a task notification, and then polling for it.
+ *
+ * Throughput is printed in thousands of words a second, and any word that
+ * arrives out of sequence is counted as an error.
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "IntercoreChannel.h"
+#include "ChannelBench.h"
+
+/* Library includes. */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#define benchTASK_PRIORITY          ( configMAX_PRIORITIES - 2 )
+#define benchRING_LENGTH            ( 64 )
+#define benchWORDS                  ( 1000000UL )
+#define benchECHOES                 ( 10000UL )
+#define benchPERIOD_MS              ( 5000 )
+
+/* Commands from the task to the SDK core. */
+#define benchCMD_STREAM             ( 1UL )
+#define benchCMD_SINK               ( 2UL )
+#define benchCMD_ECHO               ( 3UL )
+
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void * pvParameters );
+static void prvStream( void );
+static void prvSink( void );
+static void prvEcho( BaseType_t xBlock );
+static void prvSendSpin( IntercoreChannel_t * pxChannel, uint32_t ulValue );
+static uint32_t prvReceiveSpin( IntercoreChannel_t * pxChannel );
+
+/*-----------------------------------------------------------*/
+
+static IntercoreChannel_t xToTask;
+static IntercoreChannel_t xToSDK;
+static uint32_t ulToTaskBuffer[ benchRING_LENGTH ];
+static uint32_t ulToSDKBuffer[ benchRING_LENGTH ];
+
+/*-----------------------------------------------------------*/
+
+void vChannelBenchCreateTasks( void )
+{
+    vIntercoreChannelInit( &xToTask, ulToTaskBuffer, benchRING_LENGTH );
+    vIntercoreChannelInit( &xToSDK, ulToSDKBuffer, benchRING_LENGTH );
+
+    xTaskCreate( prvBenchTask, "Bench", configMINIMAL_STACK_SIZE * 2, NULL, benchTASK_PRIORITY, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vChannelBenchSDKCore( void )
+{
+    uint32_t ulCommand, ulErrors, x;
+
+    printf("Core %d: Serving the channel benchmark\n", get_core_num());
+
+    for( ;; )
+    {
+        while( xIntercoreChannelTryReceive( &xToSDK, &ulCommand ) == pdFAIL )
+        {
+            __wfe();
+        }
+
+        switch( ulCommand )
+        {
+            case benchCMD_STREAM:
+                for( x = 0; x < benchWORDS; x++ )
+                {
+                    prvSendSpin( &xToTask, x );
+                }
+                break;
+
+            case benchCMD_SINK:
+                ulErrors = 0;
+
+                for( x = 0; x < benchWORDS; x++ )
+                {
+                    if( prvReceiveSpin( &xToSDK ) != x )
+                    {
+                        ulErrors++;
+                    }
+                }
+
+                prvSendSpin( &xToTask, ulErrors );
+                break;
+
+            case benchCMD_ECHO:
+                for( x = 0; x < benchECHOES; x++ )
+                {
+                    prvSendSpin( &xToTask, prvReceiveSpin( &xToSDK ) );
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    /* The scheduler has installed its FIFO handler by now. */
+    vIntercoreChannelStart();
+
+    for( ;; )
+    {
+        prvStream();
+        prvSink();
+        prvEcho( pdTRUE );
+        prvEcho( pdFALSE );
+
+        vTaskDelay( pdMS_TO_TICKS( benchPERIOD_MS ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvStream( void )
+{
+    uint32_t ulValue, ulErrors = 0, ulDoorbells, x;
+    uint64_t ullStart, ullTime;
+
+    ulDoorbells = xToTask.ulDoorbells;
+    ullStart = time_us_64();
+    prvSendSpin( &xToSDK, benchCMD_STREAM );
+
+    for( x = 0; x < benchWORDS; x++ )
+    {
+        ( void ) xIntercoreChannelReceive( &xToTask, &ulValue, portMAX_DELAY );
+
+        if( ulValue != x )
+        {
+            ulErrors++;
+        }
+    }
+
+    ullTime = time_us_64() - ullStart;
+    printf("Channel SDK core -> task: %lu words in %lu us, %lu k/s, %lu doorbells, %lu errors\n",
+           benchWORDS, ( unsigned long ) ullTime, ( unsigned long ) ( ( uint64_t ) benchWORDS * 1000u / ullTime ),
+           ( unsigned long ) ( xToTask.ulDoorbells - ulDoorbells ), ( unsigned long ) ulErrors);
+}
+/*-----------------------------------------------------------*/
+
+static void prvSink( void )
+{
+    uint32_t ulErrors, x;
+    uint64_t ullStart, ullTime;
+
+    ullStart = time_us_64();
+    prvSendSpin( &xToSDK, benchCMD_SINK );
+
+    for( x = 0; x < benchWORDS; x++ )
+    {
+        prvSendSpin( &xToSDK, x );
+    }
+
+    ( void ) xIntercoreChannelReceive( &xToTask, &ulErrors, portMAX_DELAY );
+
+    ullTime = time_us_64() - ullStart;
+    printf("Channel task -> SDK core: %lu words in %lu us, %lu k/s, %lu errors\n",
+           benchWORDS, ( unsigned long ) ullTime, ( unsigned long ) ( ( uint64_t ) benchWORDS * 1000u / ullTime ),
+           ( unsigned long ) ulErrors);
+}
+/*-----------------------------------------------------------*/
+
+static void prvEcho( BaseType_t xBlock )
+{
+    uint32_t ulValue, ulStart, ulTime, ulWorst = 0, ulErrors = 0, x;
+    uint64_t ullTotal = 0;
+
+    prvSendSpin( &xToSDK, benchCMD_ECHO );
+
+    for( x = 0; x < benchECHOES; x++ )
+    {
+        ulStart = time_us_32();
+        prvSendSpin( &xToSDK, x );
+
+        if( xBlock != pdFALSE )
+        {
+            ( void ) xIntercoreChannelReceive( &xToTask, &ulValue, portMAX_DELAY );
+        }
+        else
+        {
+            ulValue = prvReceiveSpin( &xToTask );
+        }
+
+        ulTime = time_us_32() - ulStart;
+        ullTotal += ulTime;
+
+        if( ulTime > ulWorst )
+        {
+            ulWorst = ulTime;
+        }
+
+        if( ulValue != x )
+        {
+            ulErrors++;
+        }
+    }
+
+    printf("Channel round trip, %s: average %lu ns, worst %lu us, %lu errors\n",
+           ( xBlock != pdFALSE ) ? "blocking" : "polling",
+           ( unsigned long ) ( ullTotal * 1000u / benchECHOES ), ( unsigned long ) ulWorst,
+           ( unsigned long ) ulErrors);
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendSpin( IntercoreChannel_t * pxChannel, uint32_t ulValue )
+{
+    while( xIntercoreChannelSend( pxChannel, ulValue ) == pdFAIL )
+    {
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvReceiveSpin( IntercoreChannel_t * pxChannel )
+{
+    uint32_t ulValue;
+
+    while( xIntercoreChannelTryReceive( pxChannel, &ulValue ) == pdFAIL )
+    {
+    }
+
+    return ulValue;
+}
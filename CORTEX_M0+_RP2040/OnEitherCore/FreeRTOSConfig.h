@@ -83,6 +83,14 @@
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+/* The run time counter is the low word of the 1 MHz system timer, read by
+RunTimeStats.c as the difference between samples so that it may wrap. */
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+    #include "hardware/timer.h"
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+    #define portGET_RUN_TIME_COUNTER_VALUE()    time_us_32()
+#endif
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         1
@@ -0,0 +1,246 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "IntercoreChannel.h"
+
+/* Library includes. */
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/structs/sio.h"
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The FIFO interrupt handler on the FreeRTOS core. Runs the handler it
+ * replaced, which drains the FIFO, then notifies every task waiting on a
+ * channel that is no longer empty.
+ */
+static void prvDoorbellHandler( void );
+
+/*-----------------------------------------------------------*/
+
+static IntercoreChannel_t * pxChannels[ configINTERCORE_CHANNEL_MAX ];
+static volatile UBaseType_t uxChannelCount = 0;
+
+/* The handler installed on the FIFO interrupt before prvDoorbellHandler(),
+if any. */
+static irq_handler_t pxChainedHandler = NULL;
+
+/*-----------------------------------------------------------*/
+
+void vIntercoreChannelInit( IntercoreChannel_t * pxChannel,
+                            uint32_t * pulBuffer,
+                            uint32_t ulLength )
+{
+    configASSERT( ( ulLength != 0 ) && ( ( ulLength & ( ulLength - 1 ) ) == 0 ) );
+    configASSERT( uxChannelCount < configINTERCORE_CHANNEL_MAX );
+
+    pxChannel->ulHead = 0;
+    pxChannel->ulTail = 0;
+    pxChannel->xWaitingTask = NULL;
+    pxChannel->pulBuffer = pulBuffer;
+    pxChannel->ulMask = ulLength - 1;
+    pxChannel->ulDoorbells = 0;
+
+    /* The channel is complete before the interrupt can see it. */
+    pxChannels[ uxChannelCount ] = pxChannel;
+    __dmb();
+    uxChannelCount++;
+}
+/*-----------------------------------------------------------*/
+
+void vIntercoreChannelStart( void )
+{
+    const uint32_t ulIRQ = SIO_IRQ_PROC0 + get_core_num();
+    irq_handler_t pxHandler;
+
+    irq_set_enabled( ulIRQ, false );
+
+    pxHandler = irq_get_exclusive_handler( ulIRQ );
+
+    if( pxHandler != prvDoorbellHandler )
+    {
+        if( pxHandler != NULL )
+        {
+            irq_remove_handler( ulIRQ, pxHandler );
+        }
+
+        pxChainedHandler = pxHandler;
+        irq_set_exclusive_handler( ulIRQ, prvDoorbellHandler );
+    }
+
+    if( pxChainedHandler == NULL )
+    {
+        /* Nothing else uses the FIFO, so discard anything already in it. */
+        multicore_fifo_drain();
+        multicore_fifo_clear_irq();
+    }
+
+    irq_set_enabled( ulIRQ, true );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDoorbellHandler( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    IntercoreChannel_t * pxChannel;
+    TaskHandle_t xTask;
+    UBaseType_t x;
+
+    if( pxChainedHandler != NULL )
+    {
+        pxChainedHandler();
+    }
+    else
+    {
+        multicore_fifo_drain();
+        multicore_fifo_clear_irq();
+    }
+
+    for( x = 0; x < uxChannelCount; x++ )
+    {
+        pxChannel = pxChannels[ x ];
+        xTask = pxChannel->xWaitingTask;
+
+        if( ( xTask != NULL ) && ( pxChannel->ulHead != pxChannel->ulTail ) )
+        {
+            pxChannel->xWaitingTask = NULL;
+            vTaskNotifyGiveFromISR( xTask, &xHigherPriorityTaskWoken );
+        }
+    }
+
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIntercoreChannelSend( IntercoreChannel_t * pxChannel,
+                                  uint32_t ulValue )
+{
+    const uint32_t ulHead = pxChannel->ulHead;
+
+    if( ( ulHead - pxChannel->ulTail ) > pxChannel->ulMask )
+    {
+        return pdFAIL;
+    }
+
+    pxChannel->pulBuffer[ ulHead & pxChannel->ulMask ] = ulValue;
+
+    /* The word is written before the head moves past it, and the head
+    moves before the waiting task is read, pairing with the barrier in
+    xIntercoreChannelReceive(). */
+    __dmb();
+    pxChannel->ulHead = ulHead + 1;
+    __dmb();
+
+    if( pxChannel->xWaitingTask != NULL )
+    {
+        /* A full FIFO already holds a doorbell that has not been taken. */
+        if( multicore_fifo_wready() )
+        {
+            sio_hw->fifo_wr = ulHead;
+            pxChannel->ulDoorbells++;
+        }
+    }
+
+    /* Wake the SDK core if it is waiting in __wfe(). */
+    __sev();
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIntercoreChannelTryReceive( IntercoreChannel_t * pxChannel,
+                                        uint32_t * pulValue )
+{
+    const uint32_t ulTail = pxChannel->ulTail;
+
+    if( pxChannel->ulHead == ulTail )
+    {
+        return pdFAIL;
+    }
+
+    /* The head is read before the word it covers, and the word is read
+    before its slot is handed back. */
+    __dmb();
+    *pulValue = pxChannel->pulBuffer[ ulTail & pxChannel->ulMask ];
+    __dmb();
+    pxChannel->ulTail = ulTail + 1;
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIntercoreChannelReceive( IntercoreChannel_t * pxChannel,
+                                     uint32_t * pulValue,
+                                     TickType_t xTicksToWait )
+{
+    TimeOut_t xTimeOut;
+
+    vTaskSetTimeOutState( &xTimeOut );
+
+    for( ;; )
+    {
+        if( xIntercoreChannelTryReceive( pxChannel, pulValue ) == pdPASS )
+        {
+            return pdPASS;
+        }
+
+        /* Publish the task, then look again, so that a word sent in
+        between either is seen here or rings the doorbell. */
+        pxChannel->xWaitingTask = xTaskGetCurrentTaskHandle();
+        __dmb();
+
+        if( pxChannel->ulHead != pxChannel->ulTail )
+        {
+            pxChannel->xWaitingTask = NULL;
+            continue;
+        }
+
+        if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+        {
+            pxChannel->xWaitingTask = NULL;
+            return xIntercoreChannelTryReceive( pxChannel, pulValue );
+        }
+
+        /* A notification left over from an earlier wait only causes
+        another pass round the loop. */
+        ( void ) ulTaskNotifyTake( pdTRUE, xTicksToWait );
+        pxChannel->xWaitingTask = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulIntercoreChannelCount( const IntercoreChannel_t * pxChannel )
+{
+    return pxChannel->ulHead - pxChannel->ulTail;
+}
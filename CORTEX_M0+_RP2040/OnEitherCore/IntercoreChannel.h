@@ -0,0 +1,123 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef INTERCORE_CHANNEL_H
+#define INTERCORE_CHANNEL_H
+
+/*
+ * A single producer, single consumer channel of 32-bit words between the
+ * core running FreeRTOS and the core running plain SDK code.
+ *
+ * The words are passed through a ring buffer in shared RAM. The producer
+ * writes the slot and then advances the head, and the consumer reads the
+ * slot and then advances the tail, so neither side takes a lock. A word too
+ * big for 32 bits can be passed as a pointer to a buffer that the consumer
+ * hands back over a second channel.
+ *
+ * The SIO inter-core FIFO is only used as a doorbell. When a FreeRTOS task
+ * blocks in xIntercoreChannelReceive() it publishes its handle in the
+ * channel, and the next word sent from the other core pushes one entry into
+ * the FIFO. The FIFO interrupt on the FreeRTOS core then notifies the task.
+ * While the consumer keeps up no doorbell is rung at all, so the cost of a
+ * word is a few loads and stores on each side.
+ *
+ * The FreeRTOS RP2040 port already owns the FIFO interrupt on its core when
+ * configSUPPORT_PICO_SYNC_INTEROP is 1, and drains the FIFO there to wake
+ * tasks blocked on SDK mutexes and semaphores. vIntercoreChannelStart()
+ * therefore chains to the port's handler rather than replacing it, and the
+ * value pushed into the FIFO is ignored by both.
+ *
+ * The other direction needs no doorbell: the SDK core polls with
+ * xIntercoreChannelTryReceive(), and may sleep in __wfe() between polls
+ * because every send executes __sev().
+ *
+ * Each channel has exactly one producer and one consumer, each of which may
+ * be a task or code on the SDK core, but only a FreeRTOS task may block.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Maximum number of channels the doorbell interrupt checks. */
+#ifndef configINTERCORE_CHANNEL_MAX
+    #define configINTERCORE_CHANNEL_MAX     4
+#endif
+
+typedef struct INTERCORE_CHANNEL
+{
+    volatile uint32_t ulHead;               /* Words sent. Written only by the producer. */
+    volatile uint32_t ulTail;               /* Words received. Written only by the consumer. */
+    TaskHandle_t volatile xWaitingTask;     /* Task blocked on an empty ring, or NULL. */
+    uint32_t * pulBuffer;
+    uint32_t ulMask;                        /* Ring length - 1. */
+    uint32_t ulDoorbells;                   /* Doorbells rung by the producer. */
+} IntercoreChannel_t;
+
+/*
+ * Initialises pxChannel to pass words through pulBuffer, which has
+ * ulLength entries, ulLength being a power of two. Must be called before
+ * the other core uses the channel.
+ */
+void vIntercoreChannelInit( IntercoreChannel_t * pxChannel,
+                            uint32_t * pulBuffer,
+                            uint32_t ulLength );
+
+/*
+ * Installs the doorbell interrupt handler on the calling core. Must be
+ * called from a task, after the scheduler has installed its own FIFO
+ * handler, and before any task blocks in xIntercoreChannelReceive().
+ */
+void vIntercoreChannelStart( void );
+
+/*
+ * Sends ulValue without blocking, from either core. Returns pdPASS, or
+ * pdFAIL if the ring is full.
+ */
+BaseType_t xIntercoreChannelSend( IntercoreChannel_t * pxChannel,
+                                  uint32_t ulValue );
+
+/*
+ * Receives a word into pulValue without blocking, from either core. Returns
+ * pdPASS, or pdFAIL if the ring is empty.
+ */
+BaseType_t xIntercoreChannelTryReceive( IntercoreChannel_t * pxChannel,
+                                        uint32_t * pulValue );
+
+/*
+ * Receives a word into pulValue, blocking the calling task for up to
+ * xTicksToWait while the ring is empty. Returns pdPASS, or pdFAIL on
+ * timeout. Uses the calling task's notification value at index 0.
+ */
+BaseType_t xIntercoreChannelReceive( IntercoreChannel_t * pxChannel,
+                                     uint32_t * pulValue,
+                                     TickType_t xTicksToWait );
+
+/*
+ * Returns the number of words waiting in the ring.
+ */
+uint32_t ulIntercoreChannelCount( const IntercoreChannel_t * pxChannel );
+
+#endif /* INTERCORE_CHANNEL_H */
@@ -7,11 +7,19 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include "pico/multicore.h"
+#include "RunTimeStats.h"
+#include "ChannelBench.h"
 
 #ifndef mainRUN_FREE_RTOS_ON_CORE
 #define mainRUN_FREE_RTOS_ON_CORE 0
 #endif
 
+/* Set to 1 to run the inter-core channel benchmark in ChannelBench.c in
+place of the demo tasks below. */
+#ifndef mainCREATE_CHANNEL_BENCHMARK
+#define mainCREATE_CHANNEL_BENCHMARK 0
+#endif
+
 /* Priorities at which the tasks are created.  The event semaphore task is
 given the maximum priority of ( configMAX_PRIORITIES - 1 ) to ensure it runs as
 soon as the semaphore is given. */
@@ -103,6 +111,9 @@ auto_init_mutex(xSDKMutex);
 static semaphore_t xSDKSemaphore;
 
 static void prvNonRTOSWorker() {
+#if ( mainCREATE_CHANNEL_BENCHMARK == 1 )
+    vChannelBenchSDKCore();
+#endif
     printf("Core %d: Doing regular SDK stuff\n", get_core_num());
     uint32_t counter = 0;
     while (true) {
@@ -159,6 +170,10 @@ int main(void) {
     xEventSemaphore = xSemaphoreCreateBinary();
 
 
+#if ( mainCREATE_CHANNEL_BENCHMARK == 1 )
+    /* Create the benchmark task, and the channels the other core uses. */
+    vChannelBenchCreateTasks();
+#else
     /* Create the queue receive task as described in the comments at the top
     of this file. */
     xTaskCreate(     /* The function that implements the task. */
@@ -217,6 +232,12 @@ int main(void) {
                 NULL,
                 mainSDK_SEMAPHORE_USE_TASK_PRIORITY,
                 NULL);
+#endif /* mainCREATE_CHANNEL_BENCHMARK */
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+    /* Create the task that prints the CPU load of each task. */
+    xRunTimeStatsTaskCreate(tskIDLE_PRIORITY + 1);
+#endif
 
     /* Create the software timer as described in the comments at the top of
     this file. */
@@ -0,0 +1,300 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "RunTimeStats.h"
+
+/* Library includes. */
+#include <stdio.h>
+#include <string.h>
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+/* One more snapshot than the window, so that the window has two ends. */
+#define rtsSLOTS    ( configRUN_TIME_STATS_WINDOW + 1 )
+
+/*-----------------------------------------------------------*/
+
+typedef struct RUN_TIME_STATS_RECORD
+{
+    RunTimeStatsTask_t xTask;
+    UBaseType_t uxTaskNumber;
+    uint32_t ulFirstSample;         /* The sample in which the task was first seen. */
+    uint32_t ulLastSample;          /* The sample in which the task was last seen. */
+    configRUN_TIME_COUNTER_TYPE xCounters[ rtsSLOTS ];
+} RunTimeStatsRecord_t;
+
+/*
+ * Returns the record for the task with uxTaskNumber, claiming a free one if
+ * there is none, or NULL if there is no room.
+ */
+static RunTimeStatsRecord_t * prvFindRecord( UBaseType_t uxTaskNumber );
+
+/*
+ * Samples and prints, as described in RunTimeStats.h.
+ */
+static void prvRunTimeStatsTask( void * pvParameters );
+
+/*-----------------------------------------------------------*/
+
+/* The snapshot buffer passed to uxTaskGetSystemState(). */
+static TaskStatus_t xSnapshot[ configRUN_TIME_STATS_MAX_TASKS ];
+
+static RunTimeStatsRecord_t xRecords[ configRUN_TIME_STATS_MAX_TASKS ];
+static configRUN_TIME_COUNTER_TYPE xTotals[ rtsSLOTS ];
+static uint32_t ulCoreLoad[ configNUMBER_OF_CORES ];
+static uint32_t ulSamples = 0;
+
+/*-----------------------------------------------------------*/
+
+static RunTimeStatsRecord_t * prvFindRecord( UBaseType_t uxTaskNumber )
+{
+    RunTimeStatsRecord_t * pxFree = NULL;
+    UBaseType_t x;
+
+    for( x = 0; x < configRUN_TIME_STATS_MAX_TASKS; x++ )
+    {
+        if( xRecords[ x ].xTask.xHandle == NULL )
+        {
+            if( pxFree == NULL )
+            {
+                pxFree = &xRecords[ x ];
+            }
+        }
+        else if( xRecords[ x ].uxTaskNumber == uxTaskNumber )
+        {
+            return &xRecords[ x ];
+        }
+    }
+
+    if( pxFree != NULL )
+    {
+        memset( pxFree, 0, sizeof( *pxFree ) );
+        pxFree->uxTaskNumber = uxTaskNumber;
+        pxFree->ulFirstSample = ulSamples;
+    }
+
+    return pxFree;
+}
+/*-----------------------------------------------------------*/
+
+void vRunTimeStatsSample( void )
+{
+    RunTimeStatsRecord_t * pxRecord;
+    configRUN_TIME_COUNTER_TYPE xTotal, xElapsed, xStart;
+    TaskHandle_t xIdle;
+    UBaseType_t uxCount, x, uxSlot, uxOldest;
+    uint32_t ulOldestSample;
+    BaseType_t xCore;
+
+    uxCount = uxTaskGetSystemState( xSnapshot, configRUN_TIME_STATS_MAX_TASKS, &xTotal );
+
+    if( uxCount == 0 )
+    {
+        /* More tasks than the buffer holds. */
+        return;
+    }
+
+    uxSlot = ulSamples % rtsSLOTS;
+    xTotals[ uxSlot ] = xTotal;
+
+    for( x = 0; x < uxCount; x++ )
+    {
+        pxRecord = prvFindRecord( xSnapshot[ x ].xTaskNumber );
+
+        if( pxRecord != NULL )
+        {
+            pxRecord->xTask.xHandle = xSnapshot[ x ].xHandle;
+            pxRecord->xTask.pcName = xSnapshot[ x ].pcTaskName;
+            pxRecord->xTask.uxCurrentPriority = xSnapshot[ x ].uxCurrentPriority;
+            #if ( configNUMBER_OF_CORES > 1 ) && ( configUSE_CORE_AFFINITY == 1 )
+                pxRecord->xTask.uxCoreAffinityMask = xSnapshot[ x ].uxCoreAffinityMask;
+            #endif
+            pxRecord->ulLastSample = ulSamples;
+            pxRecord->xCounters[ uxSlot ] = xSnapshot[ x ].ulRunTimeCounter;
+        }
+    }
+
+    /* The window runs from the oldest snapshot still held to this one. */
+    ulOldestSample = ( ulSamples > configRUN_TIME_STATS_WINDOW ) ? ( ulSamples - configRUN_TIME_STATS_WINDOW ) : 0;
+    uxOldest = ulOldestSample % rtsSLOTS;
+    xElapsed = xTotal - xTotals[ uxOldest ];
+
+    for( x = 0; x < configRUN_TIME_STATS_MAX_TASKS; x++ )
+    {
+        pxRecord = &xRecords[ x ];
+
+        if( pxRecord->xTask.xHandle == NULL )
+        {
+            continue;
+        }
+
+        if( pxRecord->ulLastSample != ulSamples )
+        {
+            /* The task has been deleted. */
+            pxRecord->xTask.xHandle = NULL;
+            continue;
+        }
+
+        /* A task created within the window started from zero. */
+        xStart = ( pxRecord->ulFirstSample > ulOldestSample ) ? 0 : pxRecord->xCounters[ uxOldest ];
+
+        if( xElapsed != 0 )
+        {
+            pxRecord->xTask.ulLoad = ( uint32_t ) ( ( ( uint64_t ) ( pxRecord->xCounters[ uxSlot ] - xStart ) * 10000u ) / xElapsed );
+        }
+    }
+
+    for( xCore = 0; xCore < configNUMBER_OF_CORES; xCore++ )
+    {
+        #if ( configNUMBER_OF_CORES > 1 )
+            xIdle = xTaskGetIdleTaskHandleForCore( xCore );
+        #else
+            xIdle = xTaskGetIdleTaskHandle();
+        #endif
+
+        ulCoreLoad[ xCore ] = 10000u;
+
+        for( x = 0; x < configRUN_TIME_STATS_MAX_TASKS; x++ )
+        {
+            if( xRecords[ x ].xTask.xHandle == xIdle )
+            {
+                ulCoreLoad[ xCore ] = ( xRecords[ x ].xTask.ulLoad < 10000u ) ? ( 10000u - xRecords[ x ].xTask.ulLoad ) : 0;
+                break;
+            }
+        }
+    }
+
+    ulSamples++;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxRunTimeStatsGetTasks( RunTimeStatsTask_t * pxTasks,
+                                    UBaseType_t uxMaxTasks )
+{
+    UBaseType_t uxCount = 0, x;
+
+    if( ulSamples < 2 )
+    {
+        return 0;
+    }
+
+    for( x = 0; ( x < configRUN_TIME_STATS_MAX_TASKS ) && ( uxCount < uxMaxTasks ); x++ )
+    {
+        if( xRecords[ x ].xTask.xHandle != NULL )
+        {
+            pxTasks[ uxCount++ ] = xRecords[ x ].xTask;
+        }
+    }
+
+    return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulRunTimeStatsGetCoreLoad( BaseType_t xCore )
+{
+    configASSERT( ( xCore >= 0 ) && ( xCore < configNUMBER_OF_CORES ) );
+
+    return ulCoreLoad[ xCore ];
+}
+/*-----------------------------------------------------------*/
+
+void vRunTimeStatsPrint( void )
+{
+    RunTimeStatsTask_t * pxTask;
+    BaseType_t xCore;
+    UBaseType_t x;
+
+    if( ulSamples < 2 )
+    {
+        return;
+    }
+
+    printf( "CPU load over %u sample periods:", ( unsigned ) ( ( ulSamples > configRUN_TIME_STATS_WINDOW ) ? configRUN_TIME_STATS_WINDOW : ( ulSamples - 1 ) ) );
+
+    for( xCore = 0; xCore < configNUMBER_OF_CORES; xCore++ )
+    {
+        printf( " core %ld %lu.%02lu%%", ( long ) xCore,
+                ( unsigned long ) ( ulCoreLoad[ xCore ] / 100u ), ( unsigned long ) ( ulCoreLoad[ xCore ] % 100u ) );
+    }
+
+    printf( "\n" );
+
+    for( x = 0; x < configRUN_TIME_STATS_MAX_TASKS; x++ )
+    {
+        pxTask = &xRecords[ x ].xTask;
+
+        if( pxTask->xHandle == NULL )
+        {
+            continue;
+        }
+
+        printf( "  %-*s %2lu %3lu.%02lu%%", configMAX_TASK_NAME_LEN, pxTask->pcName, ( unsigned long ) pxTask->uxCurrentPriority,
+                ( unsigned long ) ( pxTask->ulLoad / 100u ), ( unsigned long ) ( pxTask->ulLoad % 100u ) );
+
+        #if ( configNUMBER_OF_CORES > 1 ) && ( configUSE_CORE_AFFINITY == 1 )
+            if( pxTask->uxCoreAffinityMask != tskNO_AFFINITY )
+            {
+                printf( " cores 0x%lx", ( unsigned long ) pxTask->uxCoreAffinityMask );
+            }
+        #endif
+
+        printf( "\n" );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunTimeStatsTask( void * pvParameters )
+{
+    TickType_t xWakeTime = xTaskGetTickCount();
+    uint32_t ulCount = 0;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xWakeTime, pdMS_TO_TICKS( configRUN_TIME_STATS_PERIOD_MS ) );
+        vRunTimeStatsSample();
+
+        if( ++ulCount == configRUN_TIME_STATS_WINDOW )
+        {
+            ulCount = 0;
+            vRunTimeStatsPrint();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRunTimeStatsTaskCreate( UBaseType_t uxPriority )
+{
+    return xTaskCreate( prvRunTimeStatsTask, "Stats", configRUN_TIME_STATS_STACK_SIZE, NULL, uxPriority, NULL );
+}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
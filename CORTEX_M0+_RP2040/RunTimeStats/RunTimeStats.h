@@ -0,0 +1,123 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef RUN_TIME_STATS_H
+#define RUN_TIME_STATS_H
+
+/*
+ * CPU load monitoring from the kernel's run time counters, for any of the
+ * RP2040 demos. The demos build RunTimeStats.c in every configuration, but
+ * it is empty unless configGENERATE_RUN_TIME_STATS is set to 1.
+ *
+ * vRunTimeStatsSample() takes a snapshot of every task's run time counter
+ * with uxTaskGetSystemState() into a static buffer, so nothing is allocated
+ * after start up. The last configRUN_TIME_STATS_WINDOW snapshots are kept,
+ * and each task's load is the growth of its counter between the oldest and
+ * the newest of them divided by the time between them, so the figures
+ * cover a sliding window rather than the time since boot. Loads are in
+ * hundredths of a percent of one core, so on the SMP port the loads of all
+ * the tasks add up to configNUMBER_OF_CORES * 10000. Each core's load is
+ * 10000 less the load of its idle task.
+ *
+ * Sampling only copies counters. Formatting, in vRunTimeStatsPrint(), is
+ * left to the caller, which should be a low priority task such as the one
+ * created by xRunTimeStatsTaskCreate(), so that printing never delays the
+ * tasks being measured.
+ *
+ * configRUN_TIME_STATS_MAX_TASKS must be at least the number of tasks,
+ * idle and timer tasks included, or uxTaskGetSystemState() returns nothing
+ * and the sample is skipped. Sampling and printing must be done from one
+ * task at a time.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 ) && ( configUSE_TRACE_FACILITY != 1 )
+    #error RunTimeStats needs configUSE_TRACE_FACILITY set to 1.
+#endif
+
+/* Maximum number of tasks that can exist while sampling. */
+#ifndef configRUN_TIME_STATS_MAX_TASKS
+    #define configRUN_TIME_STATS_MAX_TASKS      16
+#endif
+
+/* Number of sample periods the load is averaged over. */
+#ifndef configRUN_TIME_STATS_WINDOW
+    #define configRUN_TIME_STATS_WINDOW         4
+#endif
+
+/* Sample period of the task created by xRunTimeStatsTaskCreate(). */
+#ifndef configRUN_TIME_STATS_PERIOD_MS
+    #define configRUN_TIME_STATS_PERIOD_MS      250
+#endif
+
+#ifndef configRUN_TIME_STATS_STACK_SIZE
+    #define configRUN_TIME_STATS_STACK_SIZE     ( configMINIMAL_STACK_SIZE * 2 )
+#endif
+
+typedef struct RUN_TIME_STATS_TASK
+{
+    TaskHandle_t xHandle;
+    const char * pcName;
+    UBaseType_t uxCurrentPriority;
+    #if ( configNUMBER_OF_CORES > 1 ) && ( configUSE_CORE_AFFINITY == 1 )
+        UBaseType_t uxCoreAffinityMask;
+    #endif
+    uint32_t ulLoad;                /* Hundredths of a percent of one core. */
+} RunTimeStatsTask_t;
+
+/*
+ * Takes a snapshot of the run time counters and updates the loads.
+ */
+void vRunTimeStatsSample( void );
+
+/*
+ * Copies the loads from the last sample into pxTasks, which has room for
+ * uxMaxTasks entries, and returns the number copied. Returns 0 until two
+ * samples have been taken.
+ */
+UBaseType_t uxRunTimeStatsGetTasks( RunTimeStatsTask_t * pxTasks,
+                                    UBaseType_t uxMaxTasks );
+
+/*
+ * Returns the load of core xCore, in hundredths of a percent, over the
+ * last window.
+ */
+uint32_t ulRunTimeStatsGetCoreLoad( BaseType_t xCore );
+
+/*
+ * Prints the core and task loads from the last sample.
+ */
+void vRunTimeStatsPrint( void );
+
+/*
+ * Creates a task at uxPriority that samples every
+ * configRUN_TIME_STATS_PERIOD_MS and prints once per window.
+ */
+BaseType_t xRunTimeStatsTaskCreate( UBaseType_t uxPriority );
+
+#endif /* RUN_TIME_STATS_H */
@@ -0,0 +1,416 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * Host test of RunTimeStats.c. uxTaskGetSystemState() is faked from a table
+ * of tasks whose run time counters the test advances by hand, one sample
+ * period of rtsPERIOD counts at a time, and every load is checked against
+ * the value worked out from the table. The counters start just below the
+ * 32-bit limit, so they wrap during the first window. The test goes
+ * through a full window, a task created part way through one, the window
+ * sliding past a change of load, a task deleted, and a sample skipped
+ * because there are more tasks than configRUN_TIME_STATS_MAX_TASKS.
+ *
+ * The exit status is the number of failed checks.
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "RunTimeStats.h"
+
+/* Library includes. */
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Run time counter counts per sample period. */
+#define rtsPERIOD           1000u
+
+/* Where the total and the task counters start. */
+#define rtsSTART            0xFFFFF000u
+
+#define rtsNUM_FAKE_TASKS   8
+
+/*-----------------------------------------------------------*/
+
+typedef struct FAKE_TASK
+{
+    const char * pcName;
+    uint32_t ulPerPeriod;           /* Counter growth per sample period. */
+    configRUN_TIME_COUNTER_TYPE ulCounter;
+    BaseType_t xExists;
+    char cTcb;                      /* Gives the task a handle. */
+} FakeTask_t;
+
+enum
+{
+    rtsIDLE0,
+    rtsIDLE1,
+    rtsWORK,
+    rtsNEW,
+    rtsEXTRA
+};
+
+static FakeTask_t xFakeTasks[ rtsNUM_FAKE_TASKS ] =
+{
+    { .pcName = "IDLE0", .ulPerPeriod = 250 },
+    { .pcName = "IDLE1", .ulPerPeriod = 1000 },
+    { .pcName = "Work", .ulPerPeriod = 750 },
+    { .pcName = "New", .ulPerPeriod = 500 },
+    { .pcName = "X1", .ulPerPeriod = 0 },
+    { .pcName = "X2", .ulPerPeriod = 0 },
+    { .pcName = "X3", .ulPerPeriod = 0 },
+    { .pcName = "X4", .ulPerPeriod = 0 },
+};
+
+static configRUN_TIME_COUNTER_TYPE ulTotal = rtsSTART;
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+static TaskHandle_t prvHandle( int iTask )
+{
+    return ( TaskHandle_t ) &xFakeTasks[ iTask ].cTcb;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray,
+                                  const UBaseType_t uxArraySize,
+                                  configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime )
+{
+    UBaseType_t uxCount = 0;
+    int i;
+
+    for( i = 0; i < rtsNUM_FAKE_TASKS; i++ )
+    {
+        uxCount += ( xFakeTasks[ i ].xExists != pdFALSE );
+    }
+
+    if( uxCount > uxArraySize )
+    {
+        return 0;
+    }
+
+    /* Listed newest first, as the kernel does not promise any order. */
+    uxCount = 0;
+
+    for( i = rtsNUM_FAKE_TASKS - 1; i >= 0; i-- )
+    {
+        if( xFakeTasks[ i ].xExists != pdFALSE )
+        {
+            memset( &pxTaskStatusArray[ uxCount ], 0, sizeof( TaskStatus_t ) );
+            pxTaskStatusArray[ uxCount ].xHandle = prvHandle( i );
+            pxTaskStatusArray[ uxCount ].pcTaskName = xFakeTasks[ i ].pcName;
+            pxTaskStatusArray[ uxCount ].xTaskNumber = ( UBaseType_t ) i + 1;
+            pxTaskStatusArray[ uxCount ].uxCurrentPriority = ( UBaseType_t ) i;
+            pxTaskStatusArray[ uxCount ].ulRunTimeCounter = xFakeTasks[ i ].ulCounter;
+            #if ( configNUMBER_OF_CORES > 1 ) && ( configUSE_CORE_AFFINITY == 1 )
+                pxTaskStatusArray[ uxCount ].uxCoreAffinityMask = ( i == rtsWORK ) ? 1 : tskNO_AFFINITY;
+            #endif
+            uxCount++;
+        }
+    }
+
+    *pulTotalRunTime = ulTotal;
+
+    return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+#if ( configNUMBER_OF_CORES > 1 )
+    TaskHandle_t xTaskGetIdleTaskHandleForCore( BaseType_t xCoreID )
+    {
+        return prvHandle( ( xCoreID == 0 ) ? rtsIDLE0 : rtsIDLE1 );
+    }
+#else
+    TaskHandle_t xTaskGetIdleTaskHandle( void )
+    {
+        return prvHandle( rtsIDLE0 );
+    }
+#endif
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+                        const char * const pcName,
+                        const configSTACK_DEPTH_TYPE uxStackDepth,
+                        void * const pvParameters,
+                        UBaseType_t uxPriority,
+                        TaskHandle_t * const pxCreatedTask )
+{
+    ( void ) pxTaskCode;
+    ( void ) pcName;
+    ( void ) uxStackDepth;
+    ( void ) pvParameters;
+    ( void ) uxPriority;
+    ( void ) pxCreatedTask;
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
+                      const TickType_t xTimeIncrement )
+{
+    ( void ) pxPreviousWakeTime;
+    ( void ) xTimeIncrement;
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( int iOk,
+                      const char * pcFormat,
+                      ... )
+{
+    va_list xArgs;
+
+    va_start( xArgs, pcFormat );
+    printf( "%s ", iOk ? "ok  " : "FAIL" );
+    vprintf( pcFormat, xArgs );
+    printf( "\n" );
+    va_end( xArgs );
+
+    iFailures += !iOk;
+}
+/*-----------------------------------------------------------*/
+
+/* Runs every existing task for a period and then samples. */
+static void prvPeriod( void )
+{
+    int i;
+
+    ulTotal += rtsPERIOD;
+
+    for( i = 0; i < rtsNUM_FAKE_TASKS; i++ )
+    {
+        if( xFakeTasks[ i ].xExists != pdFALSE )
+        {
+            xFakeTasks[ i ].ulCounter += xFakeTasks[ i ].ulPerPeriod;
+        }
+    }
+
+    vRunTimeStatsSample();
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the load of a task from uxRunTimeStatsGetTasks(), or -1 if it
+ * is not listed. */
+static long prvLoad( int iTask )
+{
+    RunTimeStatsTask_t xTasks[ configRUN_TIME_STATS_MAX_TASKS ];
+    UBaseType_t uxCount, x;
+
+    uxCount = uxRunTimeStatsGetTasks( xTasks, configRUN_TIME_STATS_MAX_TASKS );
+
+    for( x = 0; x < uxCount; x++ )
+    {
+        if( xTasks[ x ].xHandle == prvHandle( iTask ) )
+        {
+            return ( long ) xTasks[ x ].ulLoad;
+        }
+    }
+
+    return -1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckLoad( int iTask,
+                          long lExpected,
+                          const char * pcWhen )
+{
+    long lLoad = prvLoad( iTask );
+
+    prvCheck( lLoad == lExpected, "%s: %s load %ld, expected %ld", pcWhen, xFakeTasks[ iTask ].pcName, lLoad, lExpected );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckCore( BaseType_t xCore,
+                          uint32_t ulExpected,
+                          const char * pcWhen )
+{
+    uint32_t ulLoad = ulRunTimeStatsGetCoreLoad( xCore );
+
+    prvCheck( ulLoad == ulExpected, "%s: core %ld load %lu, expected %lu", pcWhen, ( long ) xCore,
+              ( unsigned long ) ulLoad, ( unsigned long ) ulExpected );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFirstSamples( void )
+{
+    RunTimeStatsTask_t xTasks[ configRUN_TIME_STATS_MAX_TASKS ];
+
+    xFakeTasks[ rtsIDLE0 ].xExists = pdTRUE;
+    xFakeTasks[ rtsIDLE1 ].xExists = pdTRUE;
+    xFakeTasks[ rtsWORK ].xExists = pdTRUE;
+    xFakeTasks[ rtsIDLE0 ].ulCounter = rtsSTART;
+    xFakeTasks[ rtsIDLE1 ].ulCounter = rtsSTART + 100u;
+    xFakeTasks[ rtsWORK ].ulCounter = rtsSTART + 200u;
+
+    vRunTimeStatsSample();
+    prvCheck( uxRunTimeStatsGetTasks( xTasks, configRUN_TIME_STATS_MAX_TASKS ) == 0, "no tasks listed after one sample" );
+
+    /* Half a window, so the loads are over the periods seen so far. */
+    prvPeriod();
+    prvPeriod();
+    prvCheck( uxRunTimeStatsGetTasks( xTasks, configRUN_TIME_STATS_MAX_TASKS ) == 3, "three tasks listed after three samples" );
+    prvCheckLoad( rtsWORK, 7500, "half window" );
+    prvCheckLoad( rtsIDLE0, 2500, "half window" );
+    prvCheckCore( 0, 7500, "half window" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestWrap( void )
+{
+    int i;
+
+    /* By the end of the window both the total and every counter have
+     * wrapped. */
+    for( i = 0; i < configRUN_TIME_STATS_WINDOW; i++ )
+    {
+        prvPeriod();
+    }
+
+    prvCheck( ulTotal < rtsSTART, "total wrapped" );
+    prvCheck( xFakeTasks[ rtsWORK ].ulCounter < rtsSTART, "counters wrapped" );
+    prvCheckLoad( rtsWORK, 7500, "after wrap" );
+    prvCheckLoad( rtsIDLE0, 2500, "after wrap" );
+    prvCheckLoad( rtsIDLE1, 10000, "after wrap" );
+    prvCheckCore( 0, 7500, "after wrap" );
+
+    #if ( configNUMBER_OF_CORES > 1 )
+        prvCheckCore( 1, 0, "after wrap" );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestCreatedInWindow( void )
+{
+    int i;
+
+    /* New is created at the start of the next period, and Work gives it
+     * most of its time. */
+    xFakeTasks[ rtsNEW ].xExists = pdTRUE;
+    xFakeTasks[ rtsNEW ].ulCounter = 0;
+    xFakeTasks[ rtsWORK ].ulPerPeriod = 250;
+    prvPeriod();
+
+    /* New's counter started from zero within the window. */
+    prvCheckLoad( rtsNEW, ( 500 * 10000 ) / ( configRUN_TIME_STATS_WINDOW * rtsPERIOD ), "created in window" );
+    prvCheckLoad( rtsWORK, ( ( ( configRUN_TIME_STATS_WINDOW - 1 ) * 750 + 250 ) * 10000 ) / ( configRUN_TIME_STATS_WINDOW * rtsPERIOD ),
+                  "created in window" );
+
+    for( i = 1; i < configRUN_TIME_STATS_WINDOW; i++ )
+    {
+        prvPeriod();
+    }
+
+    /* The window now starts just before New was created. */
+    prvCheckLoad( rtsNEW, 5000, "window since creation" );
+    prvCheckLoad( rtsWORK, 2500, "window since creation" );
+
+    /* And then starts at the first sample that saw it. */
+    prvPeriod();
+    prvCheckLoad( rtsNEW, 5000, "window after creation" );
+    prvCheckLoad( rtsWORK, 2500, "window after creation" );
+    prvCheckCore( 0, 7500, "window after creation" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestDeleted( void )
+{
+    xFakeTasks[ rtsWORK ].xExists = pdFALSE;
+    xFakeTasks[ rtsNEW ].ulPerPeriod = 750;
+    prvPeriod();
+
+    prvCheckLoad( rtsWORK, -1, "deleted" );
+    prvCheckLoad( rtsNEW, ( ( ( configRUN_TIME_STATS_WINDOW - 1 ) * 500 + 750 ) * 10000 ) / ( configRUN_TIME_STATS_WINDOW * rtsPERIOD ),
+                  "deleted" );
+
+    /* Its record is free for the next task created. */
+    xFakeTasks[ rtsEXTRA ].xExists = pdTRUE;
+    xFakeTasks[ rtsEXTRA ].ulPerPeriod = 100;
+    prvPeriod();
+    prvCheckLoad( rtsEXTRA, ( 100 * 10000 ) / ( configRUN_TIME_STATS_WINDOW * rtsPERIOD ), "record reused" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTooManyTasks( void )
+{
+    long lNew = prvLoad( rtsNEW );
+    int i;
+
+    for( i = rtsEXTRA; i < rtsNUM_FAKE_TASKS; i++ )
+    {
+        xFakeTasks[ i ].xExists = pdTRUE;
+    }
+
+    /* Seven tasks do not fit in six records, so the sample is skipped and
+     * the loads from the last one are kept. */
+    xFakeTasks[ rtsWORK ].xExists = pdTRUE;
+    prvPeriod();
+    prvCheckLoad( rtsNEW, lNew, "skipped sample" );
+    prvCheckLoad( rtsWORK, -1, "skipped sample" );
+
+    for( i = rtsEXTRA; i < rtsNUM_FAKE_TASKS; i++ )
+    {
+        xFakeTasks[ i ].xExists = pdFALSE;
+    }
+
+    xFakeTasks[ rtsWORK ].xExists = pdFALSE;
+
+    /* Once sampling resumes the window covers the skipped period too, and
+     * steady loads come out unchanged. */
+    for( i = 0; i < configRUN_TIME_STATS_WINDOW; i++ )
+    {
+        prvPeriod();
+    }
+
+    prvCheckLoad( rtsNEW, 7500, "after skipped sample" );
+    prvCheckLoad( rtsIDLE0, 2500, "after skipped sample" );
+    prvCheckCore( 0, 7500, "after skipped sample" );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestFirstSamples();
+    prvTestWrap();
+    prvTestCreatedInWindow();
+    prvTestDeleted();
+    prvTestTooManyTasks();
+
+    vRunTimeStatsPrint();
+    printf( "%d failure%s\n", iFailures, ( iFailures == 1 ) ? "" : "s" );
+
+    return iFailures;
+}
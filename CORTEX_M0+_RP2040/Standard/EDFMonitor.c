@@ -0,0 +1,466 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * Deadline and response time monitoring for EDF tasks. See EDFMonitor.h.
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include <stdio.h>
+#include <string.h>
+
+#include "EDFMonitor.h"
+
+#if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+    #include "edf_admission.h"
+#endif
+
+#if ( configUSE_EDF != 1 )
+    #error EDFMonitor.c requires configUSE_EDF to be 1
+#endif
+
+#if ( configEDF_MONITOR_TLS_INDEX >= configNUM_THREAD_LOCAL_STORAGE_POINTERS )
+    #error configEDF_MONITOR_TLS_INDEX must be less than configNUM_THREAD_LOCAL_STORAGE_POINTERS
+#endif
+
+typedef struct EDF_MONITOR_RECORD
+{
+    BaseType_t xInUse;
+    TaskHandle_t xTask;     /* NULL until the task has been created. */
+    EDFMonitorStats_t xStats;
+    #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+        BaseType_t xAdmitted;           /* Whether xAdmittedTask is in xAdmission. */
+        EDFTask_t xAdmittedTask;
+    #endif
+} EDFMonitorRecord_t;
+
+#if ( configUSE_EDF_DEADLINE_MISS_HOOK == 1 )
+    extern void vApplicationEDFDeadlineMissHook( TaskHandle_t xTask, TickType_t xLateness );
+#endif
+
+/*-----------------------------------------------------------*/
+
+static EDFMonitorRecord_t xRecords[ configEDF_MONITOR_MAX_TASKS ];
+
+#if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+    /* Only accessed with the scheduler suspended. */
+    static EDFAdmission_t xAdmission;
+#endif
+
+/*-----------------------------------------------------------*/
+
+static EDFMonitorRecord_t * prvFindRecord( TaskHandle_t xTask )
+{
+    UBaseType_t x;
+
+    for( x = 0; x < configEDF_MONITOR_MAX_TASKS; x++ )
+    {
+        if( ( xTask != NULL ) && ( xRecords[ x ].xTask == xTask ) )
+        {
+            return &xRecords[ x ];
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvHistogramBucket( TickType_t xResponse )
+{
+    UBaseType_t uxBucket;
+
+    if( xResponse == 0 )
+    {
+        return 0;
+    }
+
+    /* One more than the index of the most significant set bit. */
+    uxBucket = ( UBaseType_t ) ( 32 - __builtin_clz( ( uint32_t ) xResponse ) );
+
+    return ( uxBucket < edfmonHISTOGRAM_BUCKETS ) ? uxBucket : ( edfmonHISTOGRAM_BUCKETS - 1 );
+}
+/*-----------------------------------------------------------*/
+
+static EDFMonitorRecord_t * prvTaskCreate( TaskFunction_t pxTaskCode,
+                                           const char * const pcName,
+                                           const configSTACK_DEPTH_TYPE usStackDepth,
+                                           void * const pvParameters,
+                                           TaskHandle_t * const pxCreatedTask,
+                                           TickType_t xExecutionTime,
+                                           TickType_t xDeadline,
+                                           TickType_t xPeriod )
+{
+    EDFMonitorRecord_t * pxRecord = NULL;
+    TaskHandle_t xHandle = NULL;
+    UBaseType_t x;
+
+    /* Claim a slot before creating the task so that a full table does not
+    leave an unmonitored task behind. */
+    taskENTER_CRITICAL();
+    {
+        for( x = 0; x < configEDF_MONITOR_MAX_TASKS; x++ )
+        {
+            if( xRecords[ x ].xInUse == pdFALSE )
+            {
+                pxRecord = &xRecords[ x ];
+                pxRecord->xInUse = pdTRUE;
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( pxRecord == NULL )
+    {
+        return NULL;
+    }
+
+    memset( &pxRecord->xStats, 0, sizeof( pxRecord->xStats ) );
+    pxRecord->xStats.xExecutionTime = xExecutionTime;
+    pxRecord->xStats.xDeadline = xDeadline;
+    pxRecord->xStats.xPeriod = xPeriod;
+
+    #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+    {
+        /* Set before the task exists so that it is always removed from the
+        admitted set when deleted. */
+        pxRecord->xAdmittedTask.xC = xExecutionTime;
+        pxRecord->xAdmittedTask.xD = xDeadline;
+        pxRecord->xAdmittedTask.xT = xPeriod;
+        pxRecord->xAdmitted = ( xExecutionTime != 0 ) ? pdTRUE : pdFALSE;
+    }
+    #endif
+
+    xTaskCreateEDF( pxTaskCode, pcName, usStackDepth, pvParameters, &xHandle, xDeadline, xPeriod );
+
+    if( xHandle == NULL )
+    {
+        pxRecord->xInUse = pdFALSE;
+        return NULL;
+    }
+
+    /* A job that completes before this point is not recorded. */
+    vTaskSetThreadLocalStoragePointer( xHandle, configEDF_MONITOR_TLS_INDEX, pxRecord );
+    pxRecord->xTask = xHandle;
+
+    if( pxCreatedTask != NULL )
+    {
+        *pxCreatedTask = xHandle;
+    }
+
+    return pxRecord;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEDFMonitorTaskCreate( TaskFunction_t pxTaskCode,
+                                  const char * const pcName,
+                                  const configSTACK_DEPTH_TYPE usStackDepth,
+                                  void * const pvParameters,
+                                  TaskHandle_t * const pxCreatedTask,
+                                  TickType_t xDeadline,
+                                  TickType_t xPeriod )
+{
+    EDFMonitorRecord_t * pxRecord;
+
+    pxRecord = prvTaskCreate( pxTaskCode, pcName, usStackDepth, pvParameters, pxCreatedTask, 0, xDeadline, xPeriod );
+
+    return ( pxRecord != NULL ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void vEDFMonitorTaskDelete( TaskHandle_t xTask )
+{
+    EDFMonitorRecord_t * pxRecord;
+
+    if( xTask == NULL )
+    {
+        xTask = xTaskGetCurrentTaskHandle();
+    }
+
+    /* Detach the record first so that the task's jobs stop being recorded. */
+    vTaskSetThreadLocalStoragePointer( xTask, configEDF_MONITOR_TLS_INDEX, NULL );
+
+    vTaskSuspendAll();
+    {
+        pxRecord = prvFindRecord( xTask );
+
+        if( pxRecord != NULL )
+        {
+            #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+            {
+                if( pxRecord->xAdmitted != pdFALSE )
+                {
+                    ( void ) lEDFAdmissionRemove( &xAdmission, &pxRecord->xAdmittedTask );
+                    pxRecord->xAdmitted = pdFALSE;
+                }
+            }
+            #endif
+
+            taskENTER_CRITICAL();
+            {
+                pxRecord->xTask = NULL;
+                pxRecord->xInUse = pdFALSE;
+            }
+            taskEXIT_CRITICAL();
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    vTaskDelete( xTask );
+}
+/*-----------------------------------------------------------*/
+
+void vEDFMonitorJobDone( TickType_t * const pxInitialWakeTime )
+{
+    EDFMonitorRecord_t * pxRecord;
+    EDFMonitorStats_t * pxStats;
+    TickType_t xResponse;
+    BaseType_t xMissed;
+
+    pxRecord = ( EDFMonitorRecord_t * ) pvTaskGetThreadLocalStoragePointer( NULL, configEDF_MONITOR_TLS_INDEX );
+
+    if( pxRecord != NULL )
+    {
+        pxStats = &pxRecord->xStats;
+        xResponse = xTaskGetTickCount() - *pxInitialWakeTime;
+        xMissed = ( xResponse > pxStats->xDeadline ) ? pdTRUE : pdFALSE;
+
+        /* Only this task writes its record, but readers must not see it
+        half updated. */
+        taskENTER_CRITICAL();
+        {
+            pxStats->ulJobs++;
+            pxStats->ullTotalResponse += xResponse;
+            pxStats->ulHistogram[ prvHistogramBucket( xResponse ) ]++;
+
+            if( xResponse > pxStats->xWorstResponse )
+            {
+                pxStats->xWorstResponse = xResponse;
+            }
+
+            if( xMissed != pdFALSE )
+            {
+                pxStats->ulMisses++;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        #if ( configUSE_EDF_DEADLINE_MISS_HOOK == 1 )
+        {
+            if( xMissed != pdFALSE )
+            {
+                vApplicationEDFDeadlineMissHook( pxRecord->xTask, xResponse - pxStats->xDeadline );
+            }
+        }
+        #endif
+    }
+
+    vTaskDoneEDF( pxInitialWakeTime );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEDFMonitorGetStats( TaskHandle_t xTask, EDFMonitorStats_t * pxStats )
+{
+    EDFMonitorRecord_t * pxRecord;
+    BaseType_t xReturn = pdFAIL;
+
+    taskENTER_CRITICAL();
+    {
+        pxRecord = prvFindRecord( xTask );
+
+        if( pxRecord != NULL )
+        {
+            *pxStats = pxRecord->xStats;
+            xReturn = pdPASS;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vEDFMonitorGetTotals( uint32_t * pulJobs, uint32_t * pulMisses )
+{
+    uint32_t ulJobs = 0, ulMisses = 0;
+    UBaseType_t x;
+
+    taskENTER_CRITICAL();
+    {
+        for( x = 0; x < configEDF_MONITOR_MAX_TASKS; x++ )
+        {
+            ulJobs += xRecords[ x ].xStats.ulJobs;
+            ulMisses += xRecords[ x ].xStats.ulMisses;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    *pulJobs = ulJobs;
+    *pulMisses = ulMisses;
+}
+/*-----------------------------------------------------------*/
+
+void vEDFMonitorReset( TaskHandle_t xTask )
+{
+    EDFMonitorStats_t * pxStats;
+    UBaseType_t x;
+
+    taskENTER_CRITICAL();
+    {
+        for( x = 0; x < configEDF_MONITOR_MAX_TASKS; x++ )
+        {
+            if( ( xRecords[ x ].xTask != NULL ) && ( ( xTask == NULL ) || ( xRecords[ x ].xTask == xTask ) ) )
+            {
+                pxStats = &xRecords[ x ].xStats;
+                pxStats->ulJobs = 0;
+                pxStats->ulMisses = 0;
+                pxStats->xWorstResponse = 0;
+                pxStats->ullTotalResponse = 0;
+                memset( pxStats->ulHistogram, 0, sizeof( pxStats->ulHistogram ) );
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vEDFMonitorPrint( void )
+{
+    EDFMonitorStats_t xStats;
+    UBaseType_t x, uxBucket;
+
+    printf( "%-10s %8s %8s %8s %8s  histogram (log2 ticks)\n", "Task", "Jobs", "Misses", "Worst", "Average" );
+
+    for( x = 0; x < configEDF_MONITOR_MAX_TASKS; x++ )
+    {
+        if( xEDFMonitorGetStats( xRecords[ x ].xTask, &xStats ) != pdPASS )
+        {
+            continue;
+        }
+
+        printf( "%-10s %8lu %8lu %8lu %8lu ",
+                pcTaskGetName( xRecords[ x ].xTask ),
+                ( unsigned long ) xStats.ulJobs,
+                ( unsigned long ) xStats.ulMisses,
+                ( unsigned long ) xStats.xWorstResponse,
+                ( unsigned long ) ( ( xStats.ulJobs != 0 ) ? ( xStats.ullTotalResponse / xStats.ulJobs ) : 0 ) );
+
+        for( uxBucket = 0; uxBucket < edfmonHISTOGRAM_BUCKETS; uxBucket++ )
+        {
+            printf( " %lu", ( unsigned long ) xStats.ulHistogram[ uxBucket ] );
+        }
+
+        printf( "\n" );
+    }
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+
+    BaseType_t xEDFMonitorTaskCreateAdmitted( TaskFunction_t pxTaskCode,
+                                              const char * const pcName,
+                                              const configSTACK_DEPTH_TYPE usStackDepth,
+                                              void * const pvParameters,
+                                              TaskHandle_t * const pxCreatedTask,
+                                              TickType_t xExecutionTime,
+                                              TickType_t xDeadline,
+                                              TickType_t xPeriod )
+    {
+        EDFAdmissionDecision_t xDecision;
+        EDFMonitorRecord_t * pxRecord;
+        BaseType_t xOverloaded = pdFALSE;
+        EDFTask_t xTask;
+
+        xTask.xC = xExecutionTime;
+        xTask.xD = xDeadline;
+        xTask.xT = xPeriod;
+
+        /* The exact test can take a while, so the scheduler is suspended
+        rather than interrupts disabled. The task is added before it is
+        created so that a concurrent admission sees it. */
+        vTaskSuspendAll();
+        {
+            if( xEDFAdmissionTest( &xAdmission, &xTask, pdTRUE, &xDecision ) != eEDFSchedulable )
+            {
+                #if ( configEDF_ADMISSION_REJECT == 1 )
+                {
+                    ( void ) xTaskResumeAll();
+                    return edfmonNOT_SCHEDULABLE;
+                }
+                #else
+                {
+                    if( lEDFAdmissionForce( &xAdmission, &xTask ) != 0 )
+                    {
+                        ( void ) xTaskResumeAll();
+                        return pdFAIL;
+                    }
+
+                    xOverloaded = pdTRUE;
+                }
+                #endif
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        pxRecord = prvTaskCreate( pxTaskCode, pcName, usStackDepth, pvParameters, pxCreatedTask, xExecutionTime, xDeadline, xPeriod );
+
+        if( pxRecord == NULL )
+        {
+            vTaskSuspendAll();
+            ( void ) lEDFAdmissionRemove( &xAdmission, &xTask );
+            ( void ) xTaskResumeAll();
+        }
+        else
+        {
+            pxRecord->xStats.xOverloaded = xOverloaded;
+        }
+
+        return ( pxRecord != NULL ) ? pdPASS : pdFAIL;
+    }
+/*-----------------------------------------------------------*/
+
+    void vEDFMonitorGetAdmittedLoad( uint64_t * pullUtilisation, uint64_t * pullDensity )
+    {
+        vTaskSuspendAll();
+        {
+            if( pullUtilisation != NULL )
+            {
+                *pullUtilisation = xAdmission.ullUtilisation;
+            }
+
+            if( pullDensity != NULL )
+            {
+                *pullDensity = xAdmission.ullDensity;
+            }
+        }
+        ( void ) xTaskResumeAll();
+    }
+
+#endif /* configUSE_EDF_ADMISSION_CONTROL */
@@ -0,0 +1,183 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef EDF_MONITOR_H
+#define EDF_MONITOR_H
+
+/*
+ * Deadline and response time monitoring for tasks created with
+ * xTaskCreateEDF().
+ *
+ * Create the task with xEDFMonitorTaskCreate() and end each job with
+ * vEDFMonitorJobDone() in place of vTaskDoneEDF(). On entry to
+ * vTaskDoneEDF() the wake time passed in is still the release time of the
+ * job that has just finished, so the job's response time is the current
+ * tick count less that value, and it missed its deadline if the response
+ * time is greater than the relative deadline.
+ *
+ * For each task the monitor keeps the number of jobs, the number of
+ * deadline misses, the worst and total response times, and a histogram of
+ * response times in which bucket 0 counts responses of 0 ticks and bucket n
+ * counts responses from 2^(n-1) to 2^n - 1 ticks. The last bucket also
+ * counts anything longer.
+ *
+ * If configUSE_EDF_DEADLINE_MISS_HOOK is 1, the application must provide
+ *
+ *     void vApplicationEDFDeadlineMissHook( TaskHandle_t xTask, TickType_t xLateness );
+ *
+ * which is called from the task that missed, before it blocks for its next
+ * release.
+ *
+ * If configUSE_EDF_ADMISSION_CONTROL is 1, xEDFMonitorTaskCreateAdmitted()
+ * takes the task's worst case execution time as well and creates it only if
+ * the tasks admitted so far, plus the new one, remain schedulable, using the
+ * tests in EDFAnalysis/edf_admission.c. With configEDF_ADMISSION_REJECT set
+ * to 0 a task that fails the test is created anyway and marked with
+ * xOverloaded, so that the overload is recorded rather than refused. Tasks
+ * are removed from the admitted set by vEDFMonitorTaskDelete().
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef configUSE_EDF_DEADLINE_MISS_HOOK
+    #define configUSE_EDF_DEADLINE_MISS_HOOK    0
+#endif
+
+#ifndef configUSE_EDF_ADMISSION_CONTROL
+    #define configUSE_EDF_ADMISSION_CONTROL     0
+#endif
+
+#ifndef configEDF_ADMISSION_REJECT
+    #define configEDF_ADMISSION_REJECT          1
+#endif
+
+/* Maximum number of monitored tasks. */
+#ifndef configEDF_MONITOR_MAX_TASKS
+    #define configEDF_MONITOR_MAX_TASKS         8
+#endif
+
+/* Thread local storage slot used to find a task's statistics. */
+#ifndef configEDF_MONITOR_TLS_INDEX
+    #define configEDF_MONITOR_TLS_INDEX         ( configNUM_THREAD_LOCAL_STORAGE_POINTERS - 1 )
+#endif
+
+#define edfmonHISTOGRAM_BUCKETS                 16
+
+/* Returned by xEDFMonitorTaskCreateAdmitted() when admission control
+refuses the task. */
+#define edfmonNOT_SCHEDULABLE                   ( -2 )
+
+typedef struct EDF_MONITOR_STATS
+{
+    TickType_t xDeadline;       /* Relative deadline the task was created with. */
+    TickType_t xPeriod;         /* Period the task was created with. */
+    uint32_t ulJobs;            /* Jobs completed. */
+    uint32_t ulMisses;          /* Jobs that completed after their deadline. */
+    TickType_t xWorstResponse;
+    uint64_t ullTotalResponse;
+    uint32_t ulHistogram[ edfmonHISTOGRAM_BUCKETS ];
+    TickType_t xExecutionTime;  /* Worst case execution time given at admission, or 0. */
+    BaseType_t xOverloaded;     /* Created despite failing admission control. */
+} EDFMonitorStats_t;
+
+/*
+ * Creates an EDF task as xTaskCreateEDF() does and starts monitoring it.
+ * Returns pdFAIL if the task could not be created or if
+ * configEDF_MONITOR_MAX_TASKS tasks are already monitored, in which case no
+ * task is created.
+ */
+BaseType_t xEDFMonitorTaskCreate( TaskFunction_t pxTaskCode,
+                                  const char * const pcName,
+                                  const configSTACK_DEPTH_TYPE usStackDepth,
+                                  void * const pvParameters,
+                                  TaskHandle_t * const pxCreatedTask,
+                                  TickType_t xDeadline,
+                                  TickType_t xPeriod );
+
+/*
+ * Stops monitoring xTask, removes it from the admitted set if it was
+ * admitted, and deletes it. xTask may be NULL to delete the calling task.
+ * Tasks created with xEDFMonitorTaskCreate() or
+ * xEDFMonitorTaskCreateAdmitted() must be deleted this way.
+ */
+void vEDFMonitorTaskDelete( TaskHandle_t xTask );
+
+/*
+ * Records the job that has just finished and then calls
+ * vTaskDoneEDF( pxInitialWakeTime ). Tasks that were not created with
+ * xEDFMonitorTaskCreate() are passed straight through.
+ */
+void vEDFMonitorJobDone( TickType_t * const pxInitialWakeTime );
+
+/*
+ * Copies the statistics of xTask into pxStats. Returns pdFAIL if xTask is
+ * not monitored.
+ */
+BaseType_t xEDFMonitorGetStats( TaskHandle_t xTask, EDFMonitorStats_t * pxStats );
+
+/*
+ * Sums the job and miss counts of every monitored task.
+ */
+void vEDFMonitorGetTotals( uint32_t * pulJobs, uint32_t * pulMisses );
+
+/*
+ * Clears the counters and histogram of xTask, or of every monitored task if
+ * xTask is NULL.
+ */
+void vEDFMonitorReset( TaskHandle_t xTask );
+
+/*
+ * Prints one line per monitored task with printf().
+ */
+void vEDFMonitorPrint( void );
+
+#if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+
+/*
+ * As xEDFMonitorTaskCreate(), but first tests whether a task needing
+ * xExecutionTime ticks every xPeriod within xDeadline can be added to the
+ * tasks already admitted. Returns edfmonNOT_SCHEDULABLE, without creating
+ * the task, if it cannot and configEDF_ADMISSION_REJECT is 1.
+ */
+    BaseType_t xEDFMonitorTaskCreateAdmitted( TaskFunction_t pxTaskCode,
+                                              const char * const pcName,
+                                              const configSTACK_DEPTH_TYPE usStackDepth,
+                                              void * const pvParameters,
+                                              TaskHandle_t * const pxCreatedTask,
+                                              TickType_t xExecutionTime,
+                                              TickType_t xDeadline,
+                                              TickType_t xPeriod );
+
+/*
+ * Returns the utilisation and density of the admitted tasks in 32.32 fixed
+ * point, so that 1 << 32 is a fully loaded core. Either pointer may be NULL.
+ */
+    void vEDFMonitorGetAdmittedLoad( uint64_t * pullUtilisation, uint64_t * pullDensity );
+
+#endif /* configUSE_EDF_ADMISSION_CONTROL */
+
+#endif /* EDF_MONITOR_H */
@@ -49,6 +49,7 @@
 #define configMINIMAL_STACK_SIZE                ( configSTACK_DEPTH_TYPE ) 256
 #define configUSE_16_BIT_TICKS                  0
 #define configUSE_EDF                           1
+#define configUSE_EDF_ADMISSION_CONTROL         1
 
 #define configIDLE_SHOULD_YIELD                 1
 
@@ -79,12 +80,21 @@
 #define configCHECK_FOR_STACK_OVERFLOW          2
 #define configUSE_MALLOC_FAILED_HOOK            1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
+#define configUSE_EDF_DEADLINE_MISS_HOOK        1
 
 /* Run time and task stats gathering related definitions. */
 #define configGENERATE_RUN_TIME_STATS           0
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+/* The run time counter is the low word of the 1 MHz system timer, read by
+RunTimeStats.c as the difference between samples so that it may wrap. */
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+    #include "hardware/timer.h"
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+    #define portGET_RUN_TIME_COUNTER_VALUE()    time_us_32()
+#endif
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         1
@@ -64,6 +64,12 @@
 
 #define mainEXTERNAL_LED                    ( 14 )
 
+/* Set mainCREATE_HEAPBENCH_ONLY to 1 to run the heap benchmark in
+main_heapbench.c instead of the full demo. */
+#ifndef mainCREATE_HEAPBENCH_ONLY
+    #define mainCREATE_HEAPBENCH_ONLY           0
+#endif
+
 /* Set mainCREATE_SIMPLE_BLINKY_DEMO_ONLY to one to run the simple blinky demo,
 or 0 to run the more comprehensive test and demo application. */
 
@@ -78,13 +84,17 @@ static void prvSetupHardware( void );
  * main_EDF() is used when mainCREATE_SIMPLE_EDF_DEMO_ONLY is set to 1.
  * main_blinky() is used when mainCREATE_SIMPLE_EDF_DEMO_ONLY is set to 0 AND
  *              mainCREATE_SIMPLE_BLINKY_DEMO_ONLY is set to 1.
- * main_full() is used when mainCREATE_SIMPLE_EDF_DEMO_ONLY AND
- *              mainCREATE_SIMPLE_BLINKY_DEMO_ONLY are set to 0.
+ * main_heapbench() is used when mainCREATE_HEAPBENCH_ONLY is set to 1.
+ * main_full() is used when mainCREATE_SIMPLE_EDF_DEMO_ONLY,
+ *              mainCREATE_SIMPLE_BLINKY_DEMO_ONLY AND
+ *              mainCREATE_HEAPBENCH_ONLY are set to 0.
  */
 #if mainCREATE_SIMPLE_EDF_DEMO_ONLY == 1
 extern void main_EDF( uint16_t led );
 #elif mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 1
 extern void main_blinky( void );
+#elif mainCREATE_HEAPBENCH_ONLY == 1
+extern void main_heapbench( void );
 #else
 extern void main_full( void );
 #endif
@@ -108,6 +118,10 @@ void vLaunch( void)
     {
         main_blinky();
     }
+#elif( mainCREATE_HEAPBENCH_ONLY == 1 )
+    {
+        main_heapbench();
+    }
 #else
     {
         main_full();
@@ -205,7 +219,7 @@ void vApplicationIdleHook( void )
 
 void vApplicationTickHook( void )
 {
-#if ((mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 0) && (mainCREATE_SIMPLE_EDF_DEMO_ONLY == 0))
+#if ((mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 0) && (mainCREATE_SIMPLE_EDF_DEMO_ONLY == 0) && (mainCREATE_HEAPBENCH_ONLY == 0))
     {
         /* The full demo includes a software timer demo/test that requires
         prodding periodically from the tick interrupt. */
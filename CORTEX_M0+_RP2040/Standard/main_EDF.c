@@ -26,7 +26,18 @@
 
 /*
  *
- * main_EDF() creates two EDF tasks. It then starts the scheduler.
+ * main_EDF() creates three EDF tasks. It then starts the scheduler.
+ *
+ * The tasks are monitored by EDFMonitor.c. Once mainEDF_CHECK_TICKS have
+ * passed the first task to finish a job prints the response time statistics
+ * and checks that they are consistent.
+ *
+ * With mainEDF_OVERLOAD set to 1 Task3 takes one tick in every nine more
+ * than the set can afford, so its utilisation takes the total above 1 and
+ * deadlines must be missed. The check then also asserts that the misses
+ * were counted and reported through the deadline miss hook, which pulses
+ * LOGIC_GPIO_3. Admission control refuses the overloaded Task3, so it is
+ * created without it.
  *
  */
 
@@ -35,6 +46,9 @@
 #include "task.h"
 #include "semphr.h"
 
+/* Demo includes. */
+#include "EDFMonitor.h"
+
 /* Library includes. */
 #include <stdio.h>
 #include <string.h>
@@ -45,6 +59,15 @@
 #define mainON_BOARD_LED					( PICO_DEFAULT_LED_PIN )
 #define TIME_SCALE                          (1000)
 
+#ifndef mainEDF_OVERLOAD
+    #define mainEDF_OVERLOAD                0
+#endif
+
+/* Long enough for the first deadline miss when overloaded, which the
+schedulability test puts at 7 * TIME_SCALE. */
+#define mainEDF_CHECK_TICKS                 ( 18 * TIME_SCALE )
+#define mainEDF_TASK_COUNT                  ( 3 )
+
 /*-----------------------------------------------------------*/
 
 typedef enum
@@ -71,12 +94,16 @@ void prvTask( void *pvParameters );
 static __noinline void ns_delay(uint32_t ns);
 void delay_ms(uint32_t ms);
 void initLogicGPIO(void);
-void vTaskGetRunTimeStatsPrint( void );
+void vApplicationEDFDeadlineMissHook( TaskHandle_t xTask, TickType_t xLateness );
+static void prvCheckMonitor( void );
 
 /*-----------------------------------------------------------*/
 
 static uint16_t externalLED = mainON_BOARD_LED;
-char buffer[configSTATS_BUFFER_MAX_LENGTH];
+
+static TaskHandle_t xEDFTasks[ mainEDF_TASK_COUNT ];
+static volatile uint32_t ulMissHookCalls = 0;
+static volatile BaseType_t xMonitorChecked = pdFALSE;
 
 /*-----------------------------------------------------------*/
 
@@ -89,17 +116,30 @@ void main_EDF( uint16_t led )
 
     uint32_t const task1C = 2 * TIME_SCALE;
     uint32_t const task2C = 2 * TIME_SCALE;
+#if ( mainEDF_OVERLOAD == 1 )
+    uint32_t const task3C = 4 * TIME_SCALE;
+#else
     uint32_t const task3C = 3 * TIME_SCALE;
+#endif
 
     TaskHandle_t pxCreatedTask;
-    xTaskCreateEDF( prvTask, "Task1", configMINIMAL_STACK_SIZE, (void*)&task1C, &pxCreatedTask, 4 * TIME_SCALE, 6 * TIME_SCALE);
+    configASSERT( xEDFMonitorTaskCreateAdmitted( prvTask, "Task1", configMINIMAL_STACK_SIZE, (void*)&task1C, &pxCreatedTask, task1C, 4 * TIME_SCALE, 6 * TIME_SCALE) == pdPASS );
     vTaskSetApplicationTaskTag(pxCreatedTask, ( void * ) (1u << LOGIC_GPIO_0));
+    xEDFTasks[ 0 ] = pxCreatedTask;
 
-    xTaskCreateEDF( prvTask, "Task2", configMINIMAL_STACK_SIZE, (void*)&task2C, &pxCreatedTask, 5 * TIME_SCALE, 8 * TIME_SCALE);
+    configASSERT( xEDFMonitorTaskCreateAdmitted( prvTask, "Task2", configMINIMAL_STACK_SIZE, (void*)&task2C, &pxCreatedTask, task2C, 5 * TIME_SCALE, 8 * TIME_SCALE) == pdPASS );
     vTaskSetApplicationTaskTag(pxCreatedTask, ( void * ) (1u << LOGIC_GPIO_1));
-
-    xTaskCreateEDF( prvTask, "Task3", configMINIMAL_STACK_SIZE, (void*)&task3C, &pxCreatedTask, 7 * TIME_SCALE, 9 * TIME_SCALE);
+    xEDFTasks[ 1 ] = pxCreatedTask;
+
+#if ( mainEDF_OVERLOAD == 1 )
+    /* Admission control refuses the longer Task3, so bypass it. */
+    configASSERT( xEDFMonitorTaskCreateAdmitted( prvTask, "Task3", configMINIMAL_STACK_SIZE, (void*)&task3C, &pxCreatedTask, task3C, 7 * TIME_SCALE, 9 * TIME_SCALE) == edfmonNOT_SCHEDULABLE );
+    configASSERT( xEDFMonitorTaskCreate( prvTask, "Task3", configMINIMAL_STACK_SIZE, (void*)&task3C, &pxCreatedTask, 7 * TIME_SCALE, 9 * TIME_SCALE) == pdPASS );
+#else
+    configASSERT( xEDFMonitorTaskCreateAdmitted( prvTask, "Task3", configMINIMAL_STACK_SIZE, (void*)&task3C, &pxCreatedTask, task3C, 7 * TIME_SCALE, 9 * TIME_SCALE) == pdPASS );
+#endif
     vTaskSetApplicationTaskTag(pxCreatedTask, ( void * ) (1u << LOGIC_GPIO_2));
+    xEDFTasks[ 2 ] = pxCreatedTask;
 
     /* Start the tasks and timer running. */
     vTaskStartScheduler();
@@ -116,13 +156,85 @@ void prvTask( void *pvParameters )
 	for( ;; )
 	{
         delay_ms(num);
-        //vTaskGetRunTimeStatsPrint();
-        vTaskDoneEDF(&xInitialWakeTime);
+        vEDFMonitorJobDone(&xInitialWakeTime);
+
+        if( ( xMonitorChecked == pdFALSE ) && ( xTaskGetTickCount() >= mainEDF_CHECK_TICKS ) )
+        {
+            prvCheckMonitor();
+        }
 	}
 }
 
 /*-----------------------------------------------------------*/
 
+static void prvCheckMonitor( void )
+{
+    EDFMonitorStats_t xStats;
+    uint32_t ulJobs, ulMisses, ulBucketTotal;
+    UBaseType_t x, uxBucket;
+
+    taskENTER_CRITICAL();
+    {
+        if( xMonitorChecked != pdFALSE )
+        {
+            taskEXIT_CRITICAL();
+            return;
+        }
+
+        xMonitorChecked = pdTRUE;
+    }
+    taskEXIT_CRITICAL();
+
+    vEDFMonitorPrint();
+
+    for( x = 0; x < mainEDF_TASK_COUNT; x++ )
+    {
+        configASSERT( xEDFMonitorGetStats( xEDFTasks[ x ], &xStats ) == pdPASS );
+        configASSERT( xStats.ulJobs > 0 );
+        configASSERT( xStats.ulMisses <= xStats.ulJobs );
+        configASSERT( ( uint64_t ) xStats.xWorstResponse * xStats.ulJobs >= xStats.ullTotalResponse );
+
+        ulBucketTotal = 0;
+        for( uxBucket = 0; uxBucket < edfmonHISTOGRAM_BUCKETS; uxBucket++ )
+        {
+            ulBucketTotal += xStats.ulHistogram[ uxBucket ];
+        }
+        configASSERT( ulBucketTotal == xStats.ulJobs );
+    }
+
+    vEDFMonitorGetTotals( &ulJobs, &ulMisses );
+    printf("%lu jobs, %lu deadline misses, %lu miss hook calls\n",
+           ( unsigned long ) ulJobs, ( unsigned long ) ulMisses, ( unsigned long ) ulMissHookCalls);
+
+    /* A task can be preempted between counting its miss and calling the
+    hook, so the hook may lag the count. */
+    configASSERT( ulMissHookCalls <= ulMisses );
+
+#if ( mainEDF_OVERLOAD == 1 )
+    configASSERT( ulMisses > 0 );
+    configASSERT( ulMissHookCalls > 0 );
+    printf("main_EDF overload: deadline misses detected as expected.\n");
+#endif
+}
+
+/*-----------------------------------------------------------*/
+
+void vApplicationEDFDeadlineMissHook( TaskHandle_t xTask, TickType_t xLateness )
+{
+    ( void ) xTask;
+    ( void ) xLateness;
+
+    taskENTER_CRITICAL();
+    ulMissHookCalls++;
+    taskEXIT_CRITICAL();
+
+    /* Pulse a logic analyser channel so misses line up with the task traces. */
+    gpio_put(LOGIC_GPIO_3, 1);
+    gpio_put(LOGIC_GPIO_3, 0);
+}
+
+/*-----------------------------------------------------------*/
+
 void delay_ms(uint32_t ms) 
 {
     for (int k = 0; k < ms; k++)
@@ -166,75 +278,5 @@ void initLogicGPIO(void)
     gpio_put(LOGIC_GPIO_6, 0);
 }
 
-/*-----------------------------------------------------------*/
-
-/* This example demonstrates how a human readable table of run time stats
-   information is generated from raw data provided by uxTaskGetSystemState().
-   The human readable table is written to pcWriteBuffer. (see the vTaskList()
-   API function which actually does just this). */
-void vTaskGetRunTimeStatsPrint( void )
-{
-    char * pcWriteBuffer = buffer;
-    TaskStatus_t *pxTaskStatusArray;
-    volatile UBaseType_t uxArraySize, x;
-    unsigned long ulTotalRunTime, ulStatsAsPercentage;
-
-   /* Make sure the write buffer does not contain a string. */
-   *pcWriteBuffer = 0x00;
-
-   /* Take a snapshot of the number of tasks in case it changes while this
-      function is executing. */
-   uxArraySize = uxTaskGetNumberOfTasks();
-   printf("uxArraySize: %lu", uxArraySize);
-
-   /* Allocate a TaskStatus_t structure for each task. An array could be
-      allocated statically at compile time. */
-   pxTaskStatusArray = pvPortMalloc( uxArraySize * sizeof( TaskStatus_t ) );
-
-   if( pxTaskStatusArray != NULL )
-   {
-      /* Generate raw status information about each task. */
-      uxArraySize = uxTaskGetSystemState( pxTaskStatusArray,
-                                 uxArraySize,
-                                 &ulTotalRunTime );
-
-      /* For percentage calculations. */
-      ulTotalRunTime /= 100UL;
-
-      /* Avoid divide by zero errors. */
-      if( ulTotalRunTime > 0 )
-      {
-         /* For each populated position in the pxTaskStatusArray array,
-            format the raw data as human readable ASCII data. */
-         for( x = 0; x < uxArraySize; x++ )
-         {
-            /* What percentage of the total run time has the task used?
-               This will always be rounded down to the nearest integer.
-               ulTotalRunTimeDiv100 has already been divided by 100. */
-            ulStatsAsPercentage =
-                  pxTaskStatusArray[ x ].ulRunTimeCounter / ulTotalRunTime;
-
-            if( ulStatsAsPercentage > 0UL )
-            {
-                printf("%stt%lutt%lu%%rn \n",
-                                 pxTaskStatusArray[ x ].pcTaskName,
-                                 pxTaskStatusArray[ x ].ulRunTimeCounter,
-                                 ulStatsAsPercentage );
-            }
-            else
-            {
-               /* If the percentage is zero here then the task has
-                  consumed less than 1% of the total run time. */
-               printf("%stt%lutt<1%%rn \n",
-                                 pxTaskStatusArray[ x ].pcTaskName,
-                                 pxTaskStatusArray[ x ].ulRunTimeCounter );
-            }
-         }
-      }
-
-      /* The array is no longer needed, free the memory it consumes. */
-      //vPortFree( pxTaskStatusArray );
-   }
-}
 
 
@@ -97,6 +97,21 @@
 #include "TaskNotify.h"
 
 #include "main.h"
+#include "RunTimeStats.h"
+
+/* Set to 1 by the main_full_heaptrace target, which records the heap calls
+made by the demo for HeapBench. */
+#ifndef mainRECORD_HEAP_TRACE
+    #define mainRECORD_HEAP_TRACE               0
+#endif
+
+#if ( mainRECORD_HEAP_TRACE == 1 )
+    #include "heap_record.h"
+
+    /* Long enough for the demo tasks to have been created and for the death
+    tasks to have created and deleted a few tasks. */
+    #define mainHEAP_RECORD_DELAY               pdMS_TO_TICKS( 10000UL )
+#endif
 
 /* Priorities for the demo application tasks. */
 #define mainSEM_TEST_PRIORITY				( tskIDLE_PRIORITY + 1UL )
@@ -245,6 +260,16 @@ void main_full( void )
 	the top of this file. */
 	xTaskCreate( prvCheckTask, "Check", configMINIMAL_STACK_SIZE, NULL, mainCHECK_TASK_PRIORITY, NULL );
 
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+	/* Print the CPU load of each task and core from a low priority task. */
+	xRunTimeStatsTaskCreate( tskIDLE_PRIORITY + 1 );
+#endif
+
+#if ( mainRECORD_HEAP_TRACE == 1 )
+	/* Print the recorded heap calls from a low priority task. */
+	xHeapRecordTaskCreate( tskIDLE_PRIORITY + 1, mainHEAP_RECORD_DELAY );
+#endif
+
 	/* The set of tasks created by the following function call have to be
 	created last as they keep account of the number of tasks they expect to see
 	running. */
@@ -0,0 +1,219 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * main_heapbench() creates one task that measures the kernel's heap_1,
+ * heap_2, heap_4 and heap_5 side by side, then starts the scheduler. The
+ * kernel itself allocates from heap_3, so the heaps being measured hold only
+ * the benchmark's blocks.
+ *
+ * The task generates one of the fixed, random and fragment traces
+ * described in HeapBench/heap_replay.h, chosen by mainHEAPBENCH_PATTERN,
+ * and replays it against every heap, printing the minimum, average and
+ * maximum cycles taken by pvPortMalloc() and vPortFree(), the slowest
+ * allocation made while the heap was fragmented, and the largest
+ * allocatable block over the course of the trace. heapbench_tool on the
+ * host generates the same traces from the same seed.
+ *
+ * None of the heaps can be reset, so each image replays only one trace,
+ * and every heap starts empty. CMake builds main_heapbench_fixed,
+ * main_heapbench_random and main_heapbench_fragment, one per pattern.
+ *
+ * If HeapBench/recorded_trace.h exists main_heapbench_recorded is built as
+ * well, and replays that instead. It is made from the serial output of
+ * main_full_heaptrace, which records the heap calls made by the full demo,
+ * by
+ *     heapbench_tool --emit-c <log> > HeapBench/recorded_trace.h
+ *
+ * Each call is timed with the SysTick counter, which counts processor
+ * cycles, in a critical section so that the tick interrupt cannot add to
+ * it.
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "heap_replay.h"
+#include "heapbench_heaps.h"
+#include "heapbench_report.h"
+
+/* Set by CMake to replay HeapBench/recorded_trace.h rather than a
+generated trace. */
+#ifndef mainHEAPBENCH_RECORDED
+    #define mainHEAPBENCH_RECORDED          0
+#endif
+
+/* The generated trace to replay otherwise. */
+#ifndef mainHEAPBENCH_PATTERN
+    #define mainHEAPBENCH_PATTERN           eHeapBenchRandom
+#endif
+
+#if ( mainHEAPBENCH_RECORDED == 1 )
+    #include "recorded_trace.h"
+#endif
+
+/* Library includes. */
+#include <stdio.h>
+#include "hardware/structs/systick.h"
+
+#define mainHEAPBENCH_TASK_PRIORITY         ( tskIDLE_PRIORITY + 1 )
+#define mainHEAPBENCH_SEED                  ( 1 )
+#define mainHEAPBENCH_OPS                   ( 4000 )
+
+#if ( mainHEAPBENCH_RECORDED == 1 ) && ( heapbenchRECORDED_SLOTS > 256 )
+    #define mainHEAPBENCH_SLOTS             heapbenchRECORDED_SLOTS
+#else
+    #define mainHEAPBENCH_SLOTS             ( 256 )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called by main when mainCREATE_HEAPBENCH_ONLY is set to 1 in main.c.
+ */
+void main_heapbench( void );
+
+/*
+ * The task that runs the benchmark, as described at the top of this file.
+ */
+static void prvHeapBenchTask( void *pvParameters );
+
+/*
+ * Replays one trace against every heap and prints the results. Each heap
+ * may only be replayed against once.
+ */
+static void prvReplayTrace( const char *pcName, const HeapBenchOp_t *pxOps, size_t xCount );
+
+/*
+ * The SysTick timer given to the replay engine.
+ */
+static uint32_t prvTimerStart( void );
+static uint32_t prvTimerElapsed( uint32_t ulStart );
+
+/*-----------------------------------------------------------*/
+
+static const HeapBenchHeap_t * const pxHeaps[] =
+{
+    &xHeapBenchHeap1,
+    &xHeapBenchHeap2,
+    &xHeapBenchHeap4,
+    &xHeapBenchHeap5
+};
+
+static const HeapBenchTimer_t xTimer = { prvTimerStart, prvTimerElapsed };
+
+#if ( mainHEAPBENCH_RECORDED == 0 )
+    static HeapBenchOp_t xOps[ mainHEAPBENCH_OPS ];
+#endif
+static void *pvSlots[ mainHEAPBENCH_SLOTS ];
+
+/*-----------------------------------------------------------*/
+
+void main_heapbench( void )
+{
+    printf(" Starting main_heapbench.\n");
+
+    xTaskCreate( prvHeapBenchTask, "HeapBench", configMINIMAL_STACK_SIZE * 2, NULL, mainHEAPBENCH_TASK_PRIORITY, NULL );
+
+    /* Start the tasks and timer running. */
+    vTaskStartScheduler();
+
+    for( ;; );
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapBenchTask( void *pvParameters )
+{
+#if ( mainHEAPBENCH_RECORDED == 0 )
+    size_t xCount;
+#endif
+
+    ( void ) pvParameters;
+
+    printf( "Heaps of %lu bytes\n", ( unsigned long ) heapbenchHEAP_SIZE );
+
+#if ( mainHEAPBENCH_RECORDED == 1 )
+    prvReplayTrace( "recorded", xHeapBenchRecordedTrace, sizeof( xHeapBenchRecordedTrace ) / sizeof( xHeapBenchRecordedTrace[ 0 ] ) );
+#else
+    xCount = xHeapBenchGenerate( mainHEAPBENCH_PATTERN, mainHEAPBENCH_SEED, heapbenchHEAP_SIZE, 256, xOps, mainHEAPBENCH_OPS );
+    configASSERT( xCount != 0 );
+    prvReplayTrace( pcHeapBenchPatternName( mainHEAPBENCH_PATTERN ), xOps, xCount );
+#endif
+
+    printf( "main_heapbench done.\n" );
+
+    for( ;; )
+    {
+        vTaskDelay( portMAX_DELAY );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvReplayTrace( const char *pcName, const HeapBenchOp_t *pxOps, size_t xCount )
+{
+    HeapBenchStats_t xStats;
+    HeapBenchSamples_t xSamples;
+    size_t x, xInterval;
+    int lResult;
+
+    printf( "\nTrace %s: %lu operations\n", pcName, ( unsigned long ) xCount );
+    vHeapBenchPrintHeading( "cycles" );
+
+    for( x = 0; x < sizeof( pxHeaps ) / sizeof( pxHeaps[ 0 ] ); x++ )
+    {
+        xInterval = xHeapBenchSamplesInit( &xSamples, xCount );
+        lResult = lHeapBenchReplay( pxHeaps[ x ], &xTimer, pxOps, xCount, pvSlots, mainHEAPBENCH_SLOTS,
+                                    xInterval, vHeapBenchSample, &xSamples, &xStats );
+        configASSERT( lResult == 0 );
+        ( void ) lResult;
+
+        vHeapBenchPrintStats( pxHeaps[ x ]->pcName, &xStats, &xSamples );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimerStart( void )
+{
+    /* Left by prvTimerElapsed(). */
+    taskENTER_CRITICAL();
+
+    return systick_hw->cvr;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimerElapsed( uint32_t ulStart )
+{
+    uint32_t ulNow = systick_hw->cvr;
+    uint32_t ulReload = systick_hw->rvr + 1;
+
+    taskEXIT_CRITICAL();
+
+    /* SysTick counts down, and may have reloaded once. */
+    return ( ulStart >= ulNow ) ? ( ulStart - ulNow ) : ( ulStart + ulReload - ulNow );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,751 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "EDFSmp.h"
+#include "edf_admission.h"
+
+/* Library includes. */
+#include <string.h>
+#include "hardware/timer.h"
+
+#if ( configRUN_MULTIPLE_PRIORITIES != 1 )
+    #error EDFSmp needs configRUN_MULTIPLE_PRIORITIES set to 1.
+#endif
+
+#if ( configEDF_SMP_GLOBAL == 0 ) && ( configUSE_CORE_AFFINITY != 1 )
+    #error Partitioned EDFSmp needs configUSE_CORE_AFFINITY set to 1.
+#endif
+
+#if ( configEDF_SMP_MAX_TASKS > edfADMISSION_MAX_TASKS )
+    #error configEDF_SMP_MAX_TASKS must not exceed edfADMISSION_MAX_TASKS.
+#endif
+
+/* Length of a period in microseconds, for the jitter statistics, and the
+execution a tick charges to a budget. */
+#if ( configEDF_SMP_USE_US_TIMER == 1 )
+    typedef uint64_t EDFSmpTime_t;
+    #define edfsmpPERIOD_US( xPeriod )    ( ( int64_t ) ( xPeriod ) )
+    #define edfsmpTICK_CHARGE             ( ( TickType_t ) ( portTICK_PERIOD_MS * 1000 ) )
+#else
+    typedef TickType_t EDFSmpTime_t;
+    #define edfsmpPERIOD_US( xPeriod )    ( ( int64_t ) ( xPeriod ) * portTICK_PERIOD_MS * 1000 )
+    #define edfsmpTICK_CHARGE             ( ( TickType_t ) 1 )
+#endif
+
+/*-----------------------------------------------------------*/
+
+typedef struct EDF_SMP_RECORD
+{
+    TaskHandle_t xHandle;
+    EDFTask_t xTask;                /* C, D and T, for the admission tests. */
+    EDFSmpStats_t xStats;
+    EDFSmpTime_t xRelease;          /* Release time of the current job. */
+    EDFSmpTime_t xAbsoluteDeadline; /* Deadline of the current job. */
+    UBaseType_t uxPriority;
+    volatile BaseType_t xWaiting;   /* Blocked until xRelease, for the alarm. */
+    uint64_t ullFirstStart;         /* Start of the second job, in microseconds. */
+    int64_t llEarliestStart;        /* Range of later starts about the ideal period. */
+    int64_t llLatestStart;
+    #if ( configEDF_SMP_BUDGETS == 1 )
+        volatile TickType_t xRemaining; /* Budget left before the deadline is postponed. */
+        volatile BaseType_t xExhausted; /* Waiting for the supervisor to postpone it. */
+    #endif
+} EDFSmpRecord_t;
+
+/*
+ * Sets the priorities of the tasks that share core xCore, or of every task
+ * if xCore is -1, from their deadlines. Must be called with the scheduler
+ * suspended.
+ */
+static void prvRank( BaseType_t xCore );
+
+/*
+ * Returns non-zero if time xA is before time xB.
+ */
+static BaseType_t prvBefore( EDFSmpTime_t xA, EDFSmpTime_t xB );
+
+/*
+ * Returns non-zero if pxA's deadline is before pxB's.
+ */
+static BaseType_t prvEarlier( const EDFSmpRecord_t * pxA, const EDFSmpRecord_t * pxB );
+
+/*
+ * Updates the release jitter statistics as a job starts.
+ */
+static void prvRecordStart( EDFSmpRecord_t * pxRecord );
+
+#if ( configEDF_SMP_USE_US_TIMER == 1 )
+
+/*
+ * Sets the alarm for the earliest release that a task is waiting for. Must
+ * be called with interrupts masked.
+ */
+    static void prvArmAlarm( void );
+
+/*
+ * Wakes the tasks whose releases have passed.
+ */
+    static void prvAlarmCallback( uint uxAlarmNum );
+
+#endif
+
+#if ( configEDF_SMP_BUDGETS == 1 )
+
+/*
+ * Postpones the deadlines of the tasks whose budgets the tick hook found
+ * used up, recharges their budgets and ranks the tasks again.
+ */
+    static void prvSupervisorTask( void * pvParameters );
+
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Records are never freed, so their order is the order of creation. */
+static EDFSmpRecord_t xRecords[ configEDF_SMP_MAX_TASKS ];
+static size_t xRecordCount = 0;
+static BaseType_t xStarted = pdFALSE;
+
+#if ( configEDF_SMP_GLOBAL == 0 )
+    static EDFAdmission_t xCores[ configNUMBER_OF_CORES ];
+#endif
+
+#if ( configEDF_SMP_USE_US_TIMER == 1 )
+    static uint uxAlarm;
+#endif
+
+#if ( configEDF_SMP_BUDGETS == 1 )
+    static TaskHandle_t xSupervisor = NULL;
+#endif
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvBefore( EDFSmpTime_t xA, EDFSmpTime_t xB )
+{
+    #if ( configEDF_SMP_USE_US_TIMER == 1 )
+    {
+        /* The microsecond timer does not wrap. */
+        return xA < xB;
+    }
+    #else
+    {
+        /* Deadlines are within half the tick range of each other, so the
+        difference tells their order even when the tick count wraps. */
+        return ( TickType_t ) ( xA - xB ) > ( portMAX_DELAY >> 1 );
+    }
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvEarlier( const EDFSmpRecord_t * pxA, const EDFSmpRecord_t * pxB )
+{
+    return prvBefore( pxA->xAbsoluteDeadline, pxB->xAbsoluteDeadline );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordStart( EDFSmpRecord_t * pxRecord )
+{
+    uint64_t ullNow = time_us_64();
+    int64_t llStart;
+
+    /* The first job's start is not seen, so the second is the reference
+    and each later job should start a whole number of periods after it. */
+    if( pxRecord->xStats.ulJobs == 1 )
+    {
+        pxRecord->ullFirstStart = ullNow;
+        return;
+    }
+
+    llStart = ( int64_t ) ( ullNow - pxRecord->ullFirstStart ) -
+              ( ( int64_t ) ( pxRecord->xStats.ulJobs - 1 ) * edfsmpPERIOD_US( pxRecord->xStats.xPeriod ) );
+
+    if( ( pxRecord->xStats.ulJobs == 2 ) || ( llStart < pxRecord->llEarliestStart ) )
+    {
+        pxRecord->llEarliestStart = llStart;
+    }
+
+    if( ( pxRecord->xStats.ulJobs == 2 ) || ( llStart > pxRecord->llLatestStart ) )
+    {
+        pxRecord->llLatestStart = llStart;
+    }
+
+    pxRecord->xStats.ulReleaseJitterUs = ( uint32_t ) ( pxRecord->llLatestStart - pxRecord->llEarliestStart );
+}
+/*-----------------------------------------------------------*/
+
+#if ( configEDF_SMP_USE_US_TIMER == 1 )
+
+    static void prvArmAlarm( void )
+    {
+        uint64_t ullNext = UINT64_MAX;
+        size_t x;
+
+        for( x = 0; x < xRecordCount; x++ )
+        {
+            if( ( xRecords[ x ].xWaiting != pdFALSE ) && ( xRecords[ x ].xRelease < ullNext ) )
+            {
+                ullNext = xRecords[ x ].xRelease;
+            }
+        }
+
+        if( ullNext != UINT64_MAX )
+        {
+            /* If the release has already passed the alarm would not fire,
+            so raise its interrupt instead. */
+            if( hardware_alarm_set_target( uxAlarm, from_us_since_boot( ullNext ) ) )
+            {
+                hardware_alarm_force_irq( uxAlarm );
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvAlarmCallback( uint uxAlarmNum )
+    {
+        UBaseType_t uxSavedInterruptState;
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        uint64_t ullNow;
+        size_t x;
+
+        ( void ) uxAlarmNum;
+
+        uxSavedInterruptState = taskENTER_CRITICAL_FROM_ISR();
+        {
+            ullNow = time_us_64();
+
+            for( x = 0; x < xRecordCount; x++ )
+            {
+                if( ( xRecords[ x ].xWaiting != pdFALSE ) && ( xRecords[ x ].xRelease <= ullNow ) )
+                {
+                    xRecords[ x ].xWaiting = pdFALSE;
+                    vTaskNotifyGiveFromISR( xRecords[ x ].xHandle, &xHigherPriorityTaskWoken );
+                }
+            }
+
+            prvArmAlarm();
+        }
+        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptState );
+
+        portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+    }
+
+#endif /* configEDF_SMP_USE_US_TIMER */
+/*-----------------------------------------------------------*/
+
+static void prvRank( BaseType_t xCore )
+{
+    size_t xOrder[ configEDF_SMP_MAX_TASKS ];
+    size_t xCount = 0, x, y;
+    EDFSmpRecord_t * pxRecord;
+    UBaseType_t uxPriority;
+
+    /* Insertion sort, which keeps equal deadlines in creation order. */
+    for( x = 0; x < xRecordCount; x++ )
+    {
+        if( ( xCore < 0 ) || ( xRecords[ x ].xStats.xCore == xCore ) )
+        {
+            for( y = xCount; ( y > 0 ) && prvEarlier( &xRecords[ x ], &xRecords[ xOrder[ y - 1 ] ] ); y-- )
+            {
+                xOrder[ y ] = xOrder[ y - 1 ];
+            }
+
+            xOrder[ y ] = x;
+            xCount++;
+        }
+    }
+
+    for( x = 0; x < xCount; x++ )
+    {
+        pxRecord = &xRecords[ xOrder[ x ] ];
+        uxPriority = configEDF_SMP_BASE_PRIORITY + ( UBaseType_t ) ( xCount - x );
+
+        if( pxRecord->uxPriority != uxPriority )
+        {
+            pxRecord->uxPriority = uxPriority;
+            vTaskPrioritySet( pxRecord->xHandle, uxPriority );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEDFSmpTaskCreate( TaskFunction_t pxTaskCode,
+                              const char * const pcName,
+                              const configSTACK_DEPTH_TYPE usStackDepth,
+                              void * const pvParameters,
+                              TaskHandle_t * const pxCreatedTask,
+                              TickType_t xExecutionTime,
+                              TickType_t xDeadline,
+                              TickType_t xPeriod )
+{
+    EDFSmpRecord_t * pxRecord;
+    EDFTask_t xTask;
+    TaskHandle_t xHandle = NULL;
+    BaseType_t xReturn = pdFAIL, xCore = -1;
+    #if ( configEDF_SMP_GLOBAL == 1 )
+        EDFTask_t xTasks[ configEDF_SMP_MAX_TASKS ];
+        size_t x;
+    #else
+        EDFAdmissionDecision_t xDecision;
+    #endif
+
+    configASSERT( ( configEDF_SMP_BASE_PRIORITY + configEDF_SMP_MAX_TASKS ) < configMAX_PRIORITIES );
+    configASSERT( ( xExecutionTime != 0 ) && ( xDeadline != 0 ) && ( xPeriod != 0 ) );
+
+    xTask.xC = xExecutionTime;
+    xTask.xD = xDeadline;
+    xTask.xT = xPeriod;
+
+    vTaskSuspendAll();
+    {
+        if( xRecordCount < configEDF_SMP_MAX_TASKS )
+        {
+            xReturn = pdPASS;
+
+            /* Before the scheduler starts the whole set is placed and tested
+            by xEDFSmpStartScheduler(). */
+            if( xStarted != pdFALSE )
+            {
+                #if ( configEDF_SMP_GLOBAL == 1 )
+                {
+                    for( x = 0; x < xRecordCount; x++ )
+                    {
+                        xTasks[ x ] = xRecords[ x ].xTask;
+                    }
+
+                    xTasks[ xRecordCount ] = xTask;
+
+                    if( xEDFAdmissionGlobalTest( xTasks, xRecordCount + 1, configNUMBER_OF_CORES ) != eEDFSchedulable )
+                    {
+                        xReturn = edfsmpNOT_SCHEDULABLE;
+                    }
+                }
+                #else
+                {
+                    /* First fit. */
+                    for( xCore = 0; xCore < configNUMBER_OF_CORES; xCore++ )
+                    {
+                        if( xEDFAdmissionTest( &xCores[ xCore ], &xTask, 1, &xDecision ) == eEDFSchedulable )
+                        {
+                            break;
+                        }
+                    }
+
+                    if( xCore == configNUMBER_OF_CORES )
+                    {
+                        xReturn = edfsmpNOT_SCHEDULABLE;
+                    }
+                }
+                #endif
+            }
+        }
+
+        if( xReturn == pdPASS )
+        {
+            #if ( configEDF_SMP_GLOBAL == 1 )
+                xReturn = xTaskCreate( pxTaskCode, pcName, usStackDepth, pvParameters, configEDF_SMP_BASE_PRIORITY, &xHandle );
+            #else
+                xReturn = xTaskCreateAffinitySet( pxTaskCode, pcName, usStackDepth, pvParameters, configEDF_SMP_BASE_PRIORITY,
+                                                  ( xCore < 0 ) ? tskNO_AFFINITY : ( ( UBaseType_t ) 1 << xCore ), &xHandle );
+            #endif
+
+            if( xReturn == pdPASS )
+            {
+                pxRecord = &xRecords[ xRecordCount++ ];
+                memset( pxRecord, 0, sizeof( *pxRecord ) );
+                pxRecord->xHandle = xHandle;
+                pxRecord->xTask = xTask;
+                pxRecord->xStats.xExecutionTime = xExecutionTime;
+                pxRecord->xStats.xDeadline = xDeadline;
+                pxRecord->xStats.xPeriod = xPeriod;
+                pxRecord->xStats.xCore = xCore;
+                #if ( configEDF_SMP_USE_US_TIMER == 1 )
+                    pxRecord->xRelease = time_us_64();
+                #else
+                    pxRecord->xRelease = xTaskGetTickCount();
+                #endif
+                pxRecord->xAbsoluteDeadline = pxRecord->xRelease + xDeadline;
+                pxRecord->uxPriority = configEDF_SMP_BASE_PRIORITY;
+                vTaskSetThreadLocalStoragePointer( xHandle, configEDF_SMP_TLS_INDEX, pxRecord );
+
+                if( xStarted != pdFALSE )
+                {
+                    prvRank( xCore );
+                }
+            }
+            else
+            {
+                xReturn = pdFAIL;
+
+                #if ( configEDF_SMP_GLOBAL == 0 )
+                    if( xCore >= 0 )
+                    {
+                        ( void ) lEDFAdmissionRemove( &xCores[ xCore ], &xTask );
+                    }
+                #endif
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    if( ( xReturn == pdPASS ) && ( pxCreatedTask != NULL ) )
+    {
+        *pxCreatedTask = xHandle;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEDFSmpStartScheduler( void )
+{
+    EDFTask_t xTasks[ configEDF_SMP_MAX_TASKS ];
+    size_t x;
+    #if ( configEDF_SMP_GLOBAL == 0 )
+        int lCore[ configEDF_SMP_MAX_TASKS ];
+        BaseType_t xCore;
+    #endif
+    #if ( configEDF_SMP_USE_US_TIMER == 1 )
+        uint64_t ullStart;
+    #endif
+
+    for( x = 0; x < xRecordCount; x++ )
+    {
+        xTasks[ x ] = xRecords[ x ].xTask;
+    }
+
+    #if ( configEDF_SMP_USE_US_TIMER == 1 )
+    {
+        uxAlarm = ( uint ) hardware_alarm_claim_unused( true );
+        hardware_alarm_set_callback( uxAlarm, prvAlarmCallback );
+
+        /* Every task created so far is released as the scheduler starts. */
+        ullStart = time_us_64();
+
+        for( x = 0; x < xRecordCount; x++ )
+        {
+            xRecords[ x ].xRelease = ullStart;
+            xRecords[ x ].xAbsoluteDeadline = ullStart + xRecords[ x ].xStats.xDeadline;
+        }
+    }
+    #endif
+
+    #if ( configEDF_SMP_GLOBAL == 1 )
+    {
+        if( xEDFAdmissionGlobalTest( xTasks, xRecordCount, configNUMBER_OF_CORES ) != eEDFSchedulable )
+        {
+            return edfsmpNOT_SCHEDULABLE;
+        }
+
+        prvRank( -1 );
+    }
+    #else
+    {
+        for( xCore = 0; xCore < configNUMBER_OF_CORES; xCore++ )
+        {
+            vEDFAdmissionInit( &xCores[ xCore ] );
+        }
+
+        if( xEDFAdmissionPartition( xCores, configNUMBER_OF_CORES, xTasks, xRecordCount, lCore ) != 0 )
+        {
+            return edfsmpNOT_SCHEDULABLE;
+        }
+
+        for( x = 0; x < xRecordCount; x++ )
+        {
+            xRecords[ x ].xStats.xCore = ( BaseType_t ) lCore[ x ];
+            vTaskCoreAffinitySet( xRecords[ x ].xHandle, ( UBaseType_t ) 1 << lCore[ x ] );
+        }
+
+        for( xCore = 0; xCore < configNUMBER_OF_CORES; xCore++ )
+        {
+            prvRank( xCore );
+        }
+    }
+    #endif
+
+    #if ( configEDF_SMP_BUDGETS == 1 )
+    {
+        configASSERT( configEDF_SMP_SUPERVISOR_PRIORITY > ( configEDF_SMP_BASE_PRIORITY + configEDF_SMP_MAX_TASKS ) );
+
+        if( xTaskCreate( prvSupervisorTask, "EDFSup", configMINIMAL_STACK_SIZE, NULL, configEDF_SMP_SUPERVISOR_PRIORITY, &xSupervisor ) != pdPASS )
+        {
+            return pdFAIL;
+        }
+    }
+    #endif
+
+    xStarted = pdTRUE;
+    vTaskStartScheduler();
+
+    /* Only reached if there was not enough heap to start the scheduler. */
+    return pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void vEDFSmpTaskDone( TickType_t * const pxPreviousWakeTime )
+{
+    EDFSmpRecord_t * pxRecord;
+    EDFSmpTime_t xResponse, xDeadline;
+    BaseType_t xWait = pdFALSE;
+
+    pxRecord = ( EDFSmpRecord_t * ) pvTaskGetThreadLocalStoragePointer( NULL, configEDF_SMP_TLS_INDEX );
+    configASSERT( pxRecord != NULL );
+
+    vTaskSuspendAll();
+    {
+        #if ( configEDF_SMP_USE_US_TIMER == 1 )
+            xResponse = time_us_64() - pxRecord->xRelease;
+        #else
+            xResponse = xTaskGetTickCount() - pxRecord->xRelease;
+        #endif
+
+        pxRecord->xStats.ulJobs++;
+
+        if( xResponse > pxRecord->xStats.xDeadline )
+        {
+            pxRecord->xStats.ulMisses++;
+        }
+
+        if( xResponse > pxRecord->xStats.xWorstResponse )
+        {
+            pxRecord->xStats.xWorstResponse = ( TickType_t ) xResponse;
+        }
+
+        /* The task now waits for its next job, so it takes that job's
+        deadline, which may move it below tasks it was ahead of. */
+        *pxPreviousWakeTime = ( TickType_t ) pxRecord->xRelease;
+        pxRecord->xRelease += pxRecord->xStats.xPeriod;
+        xDeadline = pxRecord->xRelease + pxRecord->xStats.xDeadline;
+
+        #if ( configEDF_SMP_BUDGETS == 1 )
+        {
+            /* A deadline the budget has postponed to or past the next job's
+            stays with what is left of its budget, so that the backlog is
+            only served at the budget's rate. Otherwise the next job starts
+            afresh. */
+            if( ( pxRecord->xStats.xBudget == 0 ) || prvBefore( pxRecord->xAbsoluteDeadline, xDeadline ) )
+            {
+                taskENTER_CRITICAL();
+                {
+                    pxRecord->xRemaining = pxRecord->xStats.xBudget;
+                    pxRecord->xExhausted = pdFALSE;
+                }
+                taskEXIT_CRITICAL();
+            }
+            else
+            {
+                xDeadline = pxRecord->xAbsoluteDeadline;
+            }
+        }
+        #endif
+
+        pxRecord->xAbsoluteDeadline = xDeadline;
+        prvRank( pxRecord->xStats.xCore );
+
+        #if ( configEDF_SMP_USE_US_TIMER == 1 )
+        {
+            /* Wait on the alarm unless the release has already passed. */
+            taskENTER_CRITICAL();
+            {
+                if( pxRecord->xRelease > time_us_64() )
+                {
+                    pxRecord->xWaiting = pdTRUE;
+                    xWait = pdTRUE;
+                    prvArmAlarm();
+                }
+            }
+            taskEXIT_CRITICAL();
+        }
+        #endif
+    }
+    ( void ) xTaskResumeAll();
+
+    #if ( configEDF_SMP_USE_US_TIMER == 1 )
+    {
+        /* The alarm may already have given the notification. */
+        if( xWait != pdFALSE )
+        {
+            ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        }
+
+        *pxPreviousWakeTime = ( TickType_t ) pxRecord->xRelease;
+    }
+    #else
+    {
+        /* Returns at once if the next release has already passed. */
+        ( void ) xWait;
+        vTaskDelayUntil( pxPreviousWakeTime, pxRecord->xStats.xPeriod );
+    }
+    #endif
+
+    vTaskSuspendAll();
+    {
+        prvRecordStart( pxRecord );
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEDFSmpGetStats( TaskHandle_t xTask,
+                            EDFSmpStats_t * pxStats )
+{
+    EDFSmpRecord_t * pxRecord;
+
+    pxRecord = ( EDFSmpRecord_t * ) pvTaskGetThreadLocalStoragePointer( xTask, configEDF_SMP_TLS_INDEX );
+
+    if( pxRecord == NULL )
+    {
+        return pdFAIL;
+    }
+
+    vTaskSuspendAll();
+    {
+        *pxStats = pxRecord->xStats;
+    }
+    ( void ) xTaskResumeAll();
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+#if ( configEDF_SMP_BUDGETS == 1 )
+
+    BaseType_t xEDFSmpSetBudget( TaskHandle_t xTask,
+                                 TickType_t xBudget )
+    {
+        EDFSmpRecord_t * pxRecord;
+
+        pxRecord = ( EDFSmpRecord_t * ) pvTaskGetThreadLocalStoragePointer( xTask, configEDF_SMP_TLS_INDEX );
+
+        if( ( pxRecord == NULL ) || ( xBudget > pxRecord->xStats.xExecutionTime ) )
+        {
+            return pdFAIL;
+        }
+
+        taskENTER_CRITICAL();
+        {
+            pxRecord->xStats.xBudget = xBudget;
+            pxRecord->xRemaining = xBudget;
+            pxRecord->xExhausted = pdFALSE;
+        }
+        taskEXIT_CRITICAL();
+
+        return pdPASS;
+    }
+/*-----------------------------------------------------------*/
+
+    void vEDFSmpTickHook( void )
+    {
+        UBaseType_t uxSavedInterruptState;
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE, xCore;
+        TaskHandle_t xRunning;
+        EDFSmpRecord_t * pxRecord;
+        size_t x;
+
+        uxSavedInterruptState = taskENTER_CRITICAL_FROM_ISR();
+        {
+            for( xCore = 0; xCore < configNUMBER_OF_CORES; xCore++ )
+            {
+                xRunning = xTaskGetCurrentTaskHandleForCore( xCore );
+
+                for( x = 0; x < xRecordCount; x++ )
+                {
+                    pxRecord = &xRecords[ x ];
+
+                    /* An exhausted task is not charged again until the
+                    supervisor has recharged it. */
+                    if( ( pxRecord->xHandle == xRunning ) && ( pxRecord->xStats.xBudget != 0 ) && ( pxRecord->xExhausted == pdFALSE ) )
+                    {
+                        if( pxRecord->xRemaining > edfsmpTICK_CHARGE )
+                        {
+                            pxRecord->xRemaining -= edfsmpTICK_CHARGE;
+                        }
+                        else
+                        {
+                            pxRecord->xRemaining = 0;
+                            pxRecord->xExhausted = pdTRUE;
+                            vTaskNotifyGiveFromISR( xSupervisor, &xHigherPriorityTaskWoken );
+                        }
+                    }
+                }
+            }
+        }
+        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptState );
+
+        portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvSupervisorTask( void * pvParameters )
+    {
+        EDFSmpRecord_t * pxRecord;
+        BaseType_t xPostpone;
+        size_t x;
+
+        ( void ) pvParameters;
+
+        for( ;; )
+        {
+            ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+            vTaskSuspendAll();
+            {
+                for( x = 0; x < xRecordCount; x++ )
+                {
+                    pxRecord = &xRecords[ x ];
+
+                    taskENTER_CRITICAL();
+                    {
+                        xPostpone = pxRecord->xExhausted;
+
+                        if( xPostpone != pdFALSE )
+                        {
+                            pxRecord->xRemaining = pxRecord->xStats.xBudget;
+                            pxRecord->xExhausted = pdFALSE;
+                        }
+                    }
+                    taskEXIT_CRITICAL();
+
+                    /* The job keeps running, but from behind every job with
+                    an earlier deadline than its next period's. */
+                    if( xPostpone != pdFALSE )
+                    {
+                        pxRecord->xAbsoluteDeadline += pxRecord->xStats.xPeriod;
+                        pxRecord->xStats.ulPostponed++;
+                        prvRank( pxRecord->xStats.xCore );
+                    }
+                }
+            }
+            ( void ) xTaskResumeAll();
+        }
+    }
+
+#endif /* configEDF_SMP_BUDGETS */
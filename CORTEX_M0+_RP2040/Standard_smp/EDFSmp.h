@@ -0,0 +1,216 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef EDF_SMP_H
+#define EDF_SMP_H
+
+/*
+ * EDF scheduling of periodic tasks on the SMP kernel, which itself only
+ * schedules by fixed priority.
+ *
+ * Each task's priority is set from its current absolute deadline: among
+ * the tasks that may share a core, the one with the earliest deadline has
+ * the highest priority, ties going to the task created first. Budgets
+ * aside, a task's deadline only changes when it completes a job, so the
+ * priorities are recalculated then, in vEDFSmpTaskDone(), which otherwise
+ * behaves as vTaskDoneEDF() does: the job's deadline becomes that of the
+ * next release, and the task blocks until the release, or carries straight
+ * on if the release has already passed. Released jobs are therefore always
+ * ordered correctly without the tick having to do anything. Priorities
+ * configEDF_SMP_BASE_PRIORITY + 1 upwards are used, one per task.
+ *
+ * Two modes are provided, selected by configEDF_SMP_GLOBAL:
+ *
+ *  - Partitioned (0). Each task is pinned to one core and tasks are only
+ *    ranked against others on the same core, so every core runs
+ *    uniprocessor EDF. Tasks created before xEDFSmpStartScheduler() are
+ *    assigned to cores there by first fit decreasing utilisation
+ *    (xEDFAdmissionPartition()), and tasks created later go to the first
+ *    core that admits them. Each core's share is tested exactly, by the
+ *    tests in EDFAnalysis/edf_admission.c.
+ *
+ *  - Global (1). Tasks may run on either core and are ranked against each
+ *    other, so with configRUN_MULTIPLE_PRIORITIES set to 1 the
+ *    configNUMBER_OF_CORES earliest deadlines run. Sets are tested with
+ *    the density bound in xEDFAdmissionGlobalTest(), which is sufficient
+ *    but not exact.
+ *
+ * Both modes need configRUN_MULTIPLE_PRIORITIES and, for the partitioned
+ * mode, configUSE_CORE_AFFINITY set to 1. EDFAnalysis/edf_tool --cores
+ * compares the deadline miss rates of the two modes on generated sets.
+ *
+ * Releases and deadlines are normally kept in ticks, so a release can only
+ * happen on a tick and periods must be whole ticks. With
+ * configEDF_SMP_USE_US_TIMER set to 1 they are kept in microseconds of the
+ * 64-bit hardware timer instead, and a task waiting for its next release
+ * is woken by a hardware alarm set for the earliest pending release, so
+ * releases are accurate to the alarm interrupt latency whatever the tick
+ * rate. The tick is then only used for time slicing and timeouts. C, D and
+ * T are given in microseconds in this mode, and the tasks must not use
+ * their task notifications, which wake them.
+ *
+ * Each task's release jitter is measured as the range of its jobs' start
+ * times about the ideal period, taking the second job's start as the
+ * reference. EDFAnalysis/edf_tool --alarm simulates alarm releases for
+ * comparison with tick releases.
+ *
+ * With configEDF_SMP_BUDGETS set to 1 a task may be given an execution
+ * budget per period with xEDFSmpSetBudget(), in the units of its execution
+ * time, which is enforced by a constant bandwidth server.
+ * vEDFSmpTickHook() must be called from vApplicationTickHook(). It charges
+ * each tick to the EDF task running on each core, and when a task's budget
+ * runs out it notifies a supervisor task, created by
+ * xEDFSmpStartScheduler() at configEDF_SMP_SUPERVISOR_PRIORITY, which
+ * postpones the task's deadline by its period, recharges the budget and
+ * ranks the tasks again. The job carries on at once, but now behind every
+ * job with an earlier deadline, so a task that overruns can take no more
+ * than its budget in each period from the others, and they keep the
+ * guarantees of the admission test even if the task never gives way. A job
+ * that completes with its deadline postponed into the next period leaves
+ * that deadline and what is left of the budget to the next job, so the
+ * task's backlog is served at the same rate. The task's misses are still
+ * counted against the relative deadline it was created with. Jobs are
+ * charged whole ticks, so a budget is overrun by up to a tick plus the
+ * supervisor's response.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef configEDF_SMP_GLOBAL
+    #define configEDF_SMP_GLOBAL            0
+#endif
+
+#ifndef configEDF_SMP_USE_US_TIMER
+    #define configEDF_SMP_USE_US_TIMER      0
+#endif
+
+/* Maximum number of EDF tasks. */
+#ifndef configEDF_SMP_MAX_TASKS
+    #define configEDF_SMP_MAX_TASKS         8
+#endif
+
+/* EDF tasks run at priorities above this one. */
+#ifndef configEDF_SMP_BASE_PRIORITY
+    #define configEDF_SMP_BASE_PRIORITY     ( tskIDLE_PRIORITY + 1 )
+#endif
+
+#ifndef configEDF_SMP_BUDGETS
+    #define configEDF_SMP_BUDGETS           0
+#endif
+
+/* Priority of the budget supervisor, which must be above every EDF task. */
+#ifndef configEDF_SMP_SUPERVISOR_PRIORITY
+    #define configEDF_SMP_SUPERVISOR_PRIORITY    ( configMAX_PRIORITIES - 1 )
+#endif
+
+/* Thread local storage slot used to find a task's record. */
+#ifndef configEDF_SMP_TLS_INDEX
+    #define configEDF_SMP_TLS_INDEX         ( configNUM_THREAD_LOCAL_STORAGE_POINTERS - 1 )
+#endif
+
+/* Returned when the admission test refuses a task or task set. */
+#define edfsmpNOT_SCHEDULABLE               ( -2 )
+
+/* Times are in ticks, or in microseconds when configEDF_SMP_USE_US_TIMER
+is 1. */
+typedef struct EDF_SMP_STATS
+{
+    TickType_t xExecutionTime;  /* Worst case execution time given at creation. */
+    TickType_t xDeadline;       /* Relative deadline. */
+    TickType_t xPeriod;
+    BaseType_t xCore;           /* Core the task is pinned to, or -1 if global. */
+    uint32_t ulJobs;            /* Jobs completed. */
+    uint32_t ulMisses;          /* Jobs that completed after their deadline. */
+    TickType_t xWorstResponse;
+    uint32_t ulReleaseJitterUs; /* Range of job start times about the ideal period. */
+    TickType_t xBudget;         /* Execution per period, or 0 for no budget. */
+    uint32_t ulPostponed;       /* Times the budget ran out and the deadline was postponed. */
+} EDFSmpStats_t;
+
+/*
+ * Creates a task that must call vEDFSmpTaskDone() at the end of each job.
+ * Before the scheduler is started the task is only recorded, and is
+ * assigned a core and tested by xEDFSmpStartScheduler(). After that it is
+ * tested straight away and created only if it is admitted. Returns pdPASS,
+ * edfsmpNOT_SCHEDULABLE, or pdFAIL if configEDF_SMP_MAX_TASKS tasks exist
+ * or the task could not be created.
+ */
+BaseType_t xEDFSmpTaskCreate( TaskFunction_t pxTaskCode,
+                              const char * const pcName,
+                              const configSTACK_DEPTH_TYPE usStackDepth,
+                              void * const pvParameters,
+                              TaskHandle_t * const pxCreatedTask,
+                              TickType_t xExecutionTime,
+                              TickType_t xDeadline,
+                              TickType_t xPeriod );
+
+/*
+ * Assigns the tasks created so far to cores, tests them, and starts the
+ * scheduler. Returns edfsmpNOT_SCHEDULABLE without starting it if the set
+ * cannot be admitted.
+ */
+BaseType_t xEDFSmpStartScheduler( void );
+
+/*
+ * Ends the calling task's current job, as vTaskDoneEDF() does. The first
+ * job of a task is released when the scheduler starts or, for a task
+ * created later, when it is created. The release times are kept in the
+ * task's record rather than taken from *pxPreviousWakeTime, which is set
+ * to the release of the next job (the low bits of it, in microseconds,
+ * with configEDF_SMP_USE_US_TIMER), so a task that first runs some time
+ * after its release is still given the right deadlines.
+ */
+void vEDFSmpTaskDone( TickType_t * const pxPreviousWakeTime );
+
+/*
+ * Copies the statistics for xTask into pxStats. Returns pdFAIL if xTask was
+ * not created by xEDFSmpTaskCreate().
+ */
+BaseType_t xEDFSmpGetStats( TaskHandle_t xTask,
+                            EDFSmpStats_t * pxStats );
+
+#if ( configEDF_SMP_BUDGETS == 1 )
+
+/*
+ * Gives xTask a budget of xBudget of execution per period, or removes it if
+ * xBudget is 0. The admission test assumed the execution time xTask was
+ * created with, so the budget must be no greater. Returns pdFAIL if xTask
+ * was not created by xEDFSmpTaskCreate() or the budget is too large.
+ */
+    BaseType_t xEDFSmpSetBudget( TaskHandle_t xTask,
+                                 TickType_t xBudget );
+
+/*
+ * Charges the current tick to the EDF task running on each core, and wakes
+ * the supervisor for any whose budget that uses up. Call from
+ * vApplicationTickHook().
+ */
+    void vEDFSmpTickHook( void );
+
+#endif /* configEDF_SMP_BUDGETS */
+
+#endif /* EDF_SMP_H */
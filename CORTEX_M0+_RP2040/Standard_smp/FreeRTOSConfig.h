@@ -79,10 +79,21 @@
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+/* The run time counter is the low word of the 1 MHz system timer, read by
+RunTimeStats.c as the difference between samples so that it may wrap. */
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+    #include "hardware/timer.h"
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+    #define portGET_RUN_TIME_COUNTER_VALUE()    time_us_32()
+#endif
+
+/* The full demo creates more tasks than the RunTimeStats.c default. */
+#define configRUN_TIME_STATS_MAX_TASKS          64
+
 /* Software timer related definitions. */
 #define configUSE_TIMERS                        1
 #define configTIMER_TASK_PRIORITY               ( configMAX_PRIORITIES - 1 )
@@ -99,7 +110,15 @@
 /* SMP port only */
 #define configNUMBER_OF_CORES                   2
 #define configTICK_CORE                         0
-#define configRUN_MULTIPLE_PRIORITIES           0
+/* main_EDF_smp sets both of these to 1 for EDFSmp.c, and
+main_full_smp_intq_stress sets configUSE_CORE_AFFINITY to 1 to take a timer
+interrupt on core 1. */
+#ifndef configRUN_MULTIPLE_PRIORITIES
+    #define configRUN_MULTIPLE_PRIORITIES       0
+#endif
+#ifndef configUSE_CORE_AFFINITY
+    #define configUSE_CORE_AFFINITY             0
+#endif
 
 /* RP2040 specific */
 #define configSUPPORT_PICO_SYNC_INTEROP         1
@@ -29,6 +29,7 @@
 #include "task.h"
 
 /* Demo includes. */
+#include "main.h"
 #include "IntQueueTimer.h"
 #include "IntQueue.h"
 
@@ -36,6 +37,15 @@
 #include "pico/time.h"
 #include "hardware/irq.h"
 
+#if ( mainINT_QUEUE_STRESS == 1 )
+    #include <stdio.h>
+    #include "hardware/timer.h"
+
+    #if ( configUSE_CORE_AFFINITY != 1 )
+        #error The IntQueue stress mode needs configUSE_CORE_AFFINITY set to 1.
+    #endif
+#endif
+
 /* The priorities for the two timers.  Note that a priority of 0 is the highest
 possible on Cortex-M devices. */
 #define tmrMAX_PRIORITY				( 0UL )
@@ -44,8 +54,53 @@ possible on Cortex-M devices. */
 #define FIRST_TIMER_PERIOD_US 500
 #define SECOND_TIMER_PERIOD_US 487
 
+#if ( mainINT_QUEUE_STRESS == 1 )
+
+/* Each step of the sweep runs for this long, which must be long enough for
+the IntQueue tasks to cycle at every rate that passes. */
+#define tmrSTRESS_STEP_MS           ( 2000UL )
+
+/* Time for the demo tasks to start before the first step. */
+#define tmrSTRESS_SETTLE_MS         ( 3000UL )
+
+/* Each step shortens the periods to 7/8 of the last, down to this. */
+#define tmrSTRESS_MIN_PERIOD_US     ( 5UL )
+
+#define tmrSTRESS_TASK_PRIORITY     ( configMAX_PRIORITIES - 2 )
+
+typedef struct TMR_STRESS_ALARM
+{
+    uint32_t ulPeriod;          /* Microseconds. 0 stops the alarm. */
+    uint64_t ullTarget;         /* Time the alarm was last set to fire. */
+    uint32_t ulCount;
+    uint32_t ulOverruns;        /* Periods skipped because the handler ran too late to keep them. */
+    uint32_t ulLatencyMax;      /* Microseconds from ullTarget to handler entry, since the last snapshot. */
+    uint64_t ullLatencyTotal;
+} TmrStressAlarm_t;
+
+/* Alarm 0 interrupts core 0 and alarm 1 interrupts core 1. Both are only
+written with the kernel's ISR lock held. */
+static TmrStressAlarm_t xStressAlarms[ 2 ];
+
+/*
+ * Records the entry latency of alarm uxAlarm and sets it for the next
+ * period that has not already passed. Called with the ISR lock held.
+ */
+static void prvStressAlarm( uint uxAlarm, uint64_t ullEntry );
+
+/*
+ * The task that sweeps the alarm periods, as described in IntQueueTimer.h.
+ */
+static void prvStressTask( void *pvParameters );
+
+#endif /* mainINT_QUEUE_STRESS */
+
 void prvAlarm0Callback( uint timer )
 {
+#if ( mainINT_QUEUE_STRESS == 1 )
+    /* Read first, so that the latency covers only the interrupt entry. */
+    uint64_t ullEntry = time_us_64();
+#endif
     UBaseType_t uxSavedInterruptState;
     BaseType_t xHigherPriorityTaskWoken;
 
@@ -54,7 +109,11 @@ void prvAlarm0Callback( uint timer )
     uxSavedInterruptState = taskENTER_CRITICAL_FROM_ISR();
     {
         xHigherPriorityTaskWoken = xFirstTimerHandler();
+#if ( mainINT_QUEUE_STRESS == 1 )
+        prvStressAlarm(0, ullEntry);
+#else
         hardware_alarm_set_target(0, make_timeout_time_us( FIRST_TIMER_PERIOD_US) );
+#endif
     }
     taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptState );
 
@@ -63,6 +122,10 @@ void prvAlarm0Callback( uint timer )
 
 void prvAlarm1Callback( uint timer )
 {
+#if ( mainINT_QUEUE_STRESS == 1 )
+    /* Read first, so that the latency covers only the interrupt entry. */
+    uint64_t ullEntry = time_us_64();
+#endif
     UBaseType_t uxSavedInterruptState;
     BaseType_t xHigherPriorityTaskWoken;
 
@@ -71,7 +134,11 @@ void prvAlarm1Callback( uint timer )
     uxSavedInterruptState = taskENTER_CRITICAL_FROM_ISR();
     {
         xHigherPriorityTaskWoken = xSecondTimerHandler();
+#if ( mainINT_QUEUE_STRESS == 1 )
+        prvStressAlarm(1, ullEntry);
+#else
         hardware_alarm_set_target(1, make_timeout_time_us( SECOND_TIMER_PERIOD_US) );
+#endif
     }
     taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptState );
 
@@ -97,6 +164,189 @@ void vInitialiseTimerForIntQueueTest( void )
     irq_set_priority(TIMER_IRQ_1, trmSECOND_HIGHEST_PRIORITY);
     hardware_alarm_set_callback(0, prvAlarm0Callback);
     hardware_alarm_set_callback(1, prvAlarm1Callback);
+#if ( mainINT_QUEUE_STRESS == 1 )
+    /* The stress task moves alarm 1 to core 1 and sets both alarms. */
+    irq_set_enabled(TIMER_IRQ_1, false);
+#else
     hardware_alarm_set_target(0, make_timeout_time_us( FIRST_TIMER_PERIOD_US) );
     hardware_alarm_set_target(1, make_timeout_time_us( SECOND_TIMER_PERIOD_US) );
+#endif
 }
+
+#if ( mainINT_QUEUE_STRESS == 1 )
+
+static void prvStressAlarm( uint uxAlarm, uint64_t ullEntry )
+{
+    TmrStressAlarm_t *pxAlarm = &xStressAlarms[ uxAlarm ];
+    uint32_t ulLatency = ( uint32_t ) ( ullEntry - pxAlarm->ullTarget );
+
+    pxAlarm->ulCount++;
+    pxAlarm->ullLatencyTotal += ulLatency;
+
+    if( ulLatency > pxAlarm->ulLatencyMax )
+    {
+        pxAlarm->ulLatencyMax = ulLatency;
+    }
+
+    if( pxAlarm->ulPeriod != 0 )
+    {
+        /* Keep to the original schedule, rather than timing the next period
+        from now, so that late handlers cannot lower the rate unnoticed. The
+        SDK returns true, without setting the alarm, if the time has passed. */
+        pxAlarm->ullTarget += pxAlarm->ulPeriod;
+
+        while( hardware_alarm_set_target( uxAlarm, from_us_since_boot( pxAlarm->ullTarget ) ) )
+        {
+            pxAlarm->ulOverruns++;
+            pxAlarm->ullTarget += pxAlarm->ulPeriod;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Copies both alarms' figures and starts a new latency maximum. */
+static void prvStressSnapshot( TmrStressAlarm_t *pxAlarms )
+{
+    UBaseType_t x;
+
+    taskENTER_CRITICAL();
+    {
+        for( x = 0; x < 2; x++ )
+        {
+            pxAlarms[ x ] = xStressAlarms[ x ];
+            xStressAlarms[ x ].ulLatencyMax = 0;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvStressTask( void *pvParameters )
+{
+    TmrStressAlarm_t xBefore[ 2 ], xAfter[ 2 ];
+    uint32_t ulPeriods[ 2 ] = { FIRST_TIMER_PERIOD_US, SECOND_TIMER_PERIOD_US };
+    uint32_t ulRate[ 2 ], ulBestRate[ 2 ] = { 0, 0 }, ulBestPeriod[ 2 ] = { 0, 0 };
+    uint32_t ulOverruns[ 2 ], ulCount;
+    BaseType_t xPassed, xStop = pdFALSE;
+    uint64_t ullNow;
+    UBaseType_t x;
+
+    ( void ) pvParameters;
+
+    /* NVIC enables and priorities are per core, so TIMER_IRQ_1 has to be
+    enabled from core 1 to be taken there. */
+    vTaskCoreAffinitySet( NULL, 1UL << 1 );
+    configASSERT( portGET_CORE_ID() == 1 );
+    irq_set_priority( TIMER_IRQ_1, trmSECOND_HIGHEST_PRIORITY );
+    irq_set_enabled( TIMER_IRQ_1, true );
+    vTaskCoreAffinitySet( NULL, tskNO_AFFINITY );
+
+    vTaskDelay( pdMS_TO_TICKS( tmrSTRESS_SETTLE_MS ) );
+
+    taskENTER_CRITICAL();
+    {
+        ullNow = time_us_64();
+
+        for( x = 0; x < 2; x++ )
+        {
+            xStressAlarms[ x ].ulPeriod = ulPeriods[ x ];
+            xStressAlarms[ x ].ullTarget = ullNow + ulPeriods[ x ];
+            hardware_alarm_set_target( x, from_us_since_boot( xStressAlarms[ x ].ullTarget ) );
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    /* The first call only records the IntQueue tasks' loop counts. */
+    vTaskDelay( pdMS_TO_TICKS( tmrSTRESS_STEP_MS ) );
+    ( void ) xAreIntQueueTasksStillRunning();
+
+    printf( "IntQueue stress: alarm 0 on core 0, alarm 1 on core 1, %lu ms per step\n", ( unsigned long ) tmrSTRESS_STEP_MS );
+    printf( "  period us   core 0: irq/s lat avg/max us overruns   core 1: irq/s lat avg/max us overruns   IntQueue\n" );
+
+    while( xStop == pdFALSE )
+    {
+        prvStressSnapshot( xBefore );
+        vTaskDelay( pdMS_TO_TICKS( tmrSTRESS_STEP_MS ) );
+        prvStressSnapshot( xAfter );
+        xPassed = xAreIntQueueTasksStillRunning();
+
+        printf( "  %4lu/%-4lu", ( unsigned long ) ulPeriods[ 0 ], ( unsigned long ) ulPeriods[ 1 ] );
+
+        for( x = 0; x < 2; x++ )
+        {
+            ulCount = xAfter[ x ].ulCount - xBefore[ x ].ulCount;
+            ulOverruns[ x ] = xAfter[ x ].ulOverruns - xBefore[ x ].ulOverruns;
+            ulRate[ x ] = ( uint32_t ) ( ( ( uint64_t ) ulCount * 1000UL ) / tmrSTRESS_STEP_MS );
+
+            printf( "   %13lu %7lu/%-6lu %8lu",
+                    ( unsigned long ) ulRate[ x ],
+                    ( unsigned long ) ( ( ulCount != 0 ) ? ( ( xAfter[ x ].ullLatencyTotal - xBefore[ x ].ullLatencyTotal ) / ulCount ) : 0 ),
+                    ( unsigned long ) xAfter[ x ].ulLatencyMax,
+                    ( unsigned long ) ulOverruns[ x ] );
+
+            /* A rate is sustained if every period was kept and the tasks
+            receiving from the queues kept up. */
+            if( ( xPassed == pdPASS ) && ( ulOverruns[ x ] == 0 ) && ( ulRate[ x ] > ulBestRate[ x ] ) )
+            {
+                ulBestRate[ x ] = ulRate[ x ];
+                ulBestPeriod[ x ] = ulPeriods[ x ];
+            }
+        }
+
+        printf( "   %s\n", ( xPassed == pdPASS ) ? "pass" : "FAIL" );
+
+        /* IntQueue latches its errors, so nothing after a failure counts. */
+        if( ( xPassed != pdPASS ) || ( ( ulOverruns[ 0 ] != 0 ) && ( ulOverruns[ 1 ] != 0 ) ) )
+        {
+            xStop = pdTRUE;
+        }
+        else if( ( ulPeriods[ 1 ] * 7 ) / 8 < tmrSTRESS_MIN_PERIOD_US )
+        {
+            printf( "IntQueue stress: reached the minimum period\n" );
+            xStop = pdTRUE;
+        }
+        else
+        {
+            taskENTER_CRITICAL();
+            {
+                for( x = 0; x < 2; x++ )
+                {
+                    ulPeriods[ x ] = ( ulPeriods[ x ] * 7 ) / 8;
+                    xStressAlarms[ x ].ulPeriod = ulPeriods[ x ];
+                }
+            }
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    /* Each alarm fires once more and is then left unset. */
+    taskENTER_CRITICAL();
+    {
+        xStressAlarms[ 0 ].ulPeriod = 0;
+        xStressAlarms[ 1 ].ulPeriod = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    for( x = 0; x < 2; x++ )
+    {
+        if( ulBestRate[ x ] != 0 )
+        {
+            printf( "IntQueue stress: core %lu sustained %lu interrupts/s, period %lu us\n",
+                    ( unsigned long ) x, ( unsigned long ) ulBestRate[ x ], ( unsigned long ) ulBestPeriod[ x ] );
+        }
+        else
+        {
+            printf( "IntQueue stress: core %lu sustained none of the rates tried\n", ( unsigned long ) x );
+        }
+    }
+
+    vTaskSuspend( NULL );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStartIntQueueTimerStress( void )
+{
+    return xTaskCreate( prvStressTask, "IntQStress", configMINIMAL_STACK_SIZE * 2, NULL, tmrSTRESS_TASK_PRIORITY, NULL );
+}
+
+#endif /* mainINT_QUEUE_STRESS */
@@ -31,5 +31,24 @@ void vInitialiseTimerForIntQueueTest( void );
 portBASE_TYPE xTimer0Handler( void );
 portBASE_TYPE xTimer1Handler( void );
 
+#if ( mainINT_QUEUE_STRESS == 1 )
+
+/*
+ * Creates a task that measures how many IntQueue interrupts each core can
+ * take. Alarm 0 is taken on core 0 and alarm 1 on core 1, both starting at
+ * their normal periods, which are shortened step by step until the
+ * IntQueue tasks fail or both alarms overrun. Each step prints the rate
+ * each core took, the latency from the alarm's target time to its handler,
+ * and the periods lost because a handler ran after the next target. The
+ * highest rate each core took without overrunning, while the IntQueue
+ * tasks still passed, is printed at the end.
+ *
+ * The alarms are not started until this task runs, and nothing else may
+ * call xAreIntQueueTasksStillRunning().
+ */
+BaseType_t xStartIntQueueTimerStress( void );
+
+#endif
+
 #endif
 
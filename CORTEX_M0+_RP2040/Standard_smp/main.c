@@ -55,6 +55,10 @@
 
 #include "main.h"
 
+#if ( mainCREATE_SIMPLE_EDF_DEMO_ONLY == 1 )
+#include "EDFSmp.h"
+#endif
+
 /* Library includes. */
 #include <stdio.h>
 #include "pico/stdlib.h"
@@ -73,14 +77,19 @@ or 0 to run the more comprehensive test and demo application. */
 static void prvSetupHardware( void );
 
 /*
- * main_blinky() is used when mainCREATE_SIMPLE_BLINKY_DEMO_ONLY is set to 1.
- * main_full() is used when mainCREATE_SIMPLE_BLINKY_DEMO_ONLY is set to 0.
+ * main_EDF_smp() is used when mainCREATE_SIMPLE_EDF_DEMO_ONLY is set to 1.
+ * main_blinky() is used when mainCREATE_SIMPLE_EDF_DEMO_ONLY is set to 0 AND
+ *              mainCREATE_SIMPLE_BLINKY_DEMO_ONLY is set to 1.
+ * main_full() is used when mainCREATE_SIMPLE_EDF_DEMO_ONLY AND
+ *              mainCREATE_SIMPLE_BLINKY_DEMO_ONLY are set to 0.
  */
-#if mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 1
+#if mainCREATE_SIMPLE_EDF_DEMO_ONLY == 1
+extern void main_EDF_smp( uint16_t led );
+#elif mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 1
 extern void main_blinky( void );
 #else
 extern void main_full( void );
-#endif /* #if mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 1 */
+#endif
 
 /* Prototypes for the standard FreeRTOS callback/hook functions implemented
 within this file. */
@@ -95,7 +104,11 @@ void vLaunch( void)
 {
     /* The mainCREATE_SIMPLE_BLINKY_DEMO_ONLY setting is described at the top
 of this file. */
-#if( mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 1 )
+#if( mainCREATE_SIMPLE_EDF_DEMO_ONLY == 1 )
+    {
+        main_EDF_smp( PICO_DEFAULT_LED_PIN );
+    }
+#elif( mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 1 )
     {
         main_blinky();
     }
@@ -191,7 +204,14 @@ void vApplicationIdleHook( void )
 
 void vApplicationTickHook( void )
 {
-#if mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 0
+#if ( mainCREATE_SIMPLE_EDF_DEMO_ONLY == 1 ) && ( configEDF_SMP_BUDGETS == 1 )
+    {
+        /* Charge the tick to the running EDF tasks' budgets. */
+        vEDFSmpTickHook();
+    }
+#endif
+
+#if ((mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 0) && (mainCREATE_SIMPLE_EDF_DEMO_ONLY == 0))
     {
         /* The full demo includes a software timer demo/test that requires
         prodding periodically from the tick interrupt. */
@@ -29,6 +29,12 @@
 
 #define mainRUN_ON_CORE 0
 
+/* Set to 1 by the main_full_smp_intq_stress target, which replaces the
+IntQueue check with the sweep in IntQueueTimer.c. */
+#ifndef mainINT_QUEUE_STRESS
+    #define mainINT_QUEUE_STRESS 0
+#endif
+
 
 /* These tests should work in all modes */
 #define mainENABLE_COUNTING_SEMAPHORE 1
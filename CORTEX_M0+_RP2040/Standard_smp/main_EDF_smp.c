@@ -0,0 +1,253 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ *
+ * main_EDF_smp() creates five EDF tasks with EDFSmp.c and starts the
+ * scheduler on both cores.
+ *
+ * With configEDF_SMP_GLOBAL set to 0 the tasks are packed onto the two cores
+ * by first fit decreasing utilisation, which puts Task1 to Task3 on core 0
+ * and Task4 and Task5 on core 1, and each core runs its own tasks by EDF.
+ * With configEDF_SMP_GLOBAL set to 1 the two earliest deadlines run, on
+ * whichever core is free. The set passes the admission test in both modes,
+ * so once mainEDF_SMP_CHECK_TICKS have passed the first task to finish a
+ * job prints each task's statistics and asserts that no deadline was
+ * missed.
+ *
+ * With configEDF_SMP_USE_US_TIMER set to 1 releases come from a hardware
+ * alarm rather than the tick, and a sixth task, Loop1k, runs a 1 kHz
+ * control loop with a 150 microsecond job on core 1. Each task's release
+ * jitter is printed with its statistics for comparison with the
+ * tick-based build.
+ *
+ * Each task drives a logic analyser channel while it runs, and the core
+ * it ran on last is shown on LOGIC_GPIO_5.
+ *
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "EDFSmp.h"
+#include "RunTimeStats.h"
+
+/* Library includes. */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+
+
+#define TIME_SCALE                          (1000)
+
+/* Demo task times are in microseconds, converted to ticks unless the
+microsecond timer is used. */
+#define mainUS_PER_TICK                     ( portTICK_PERIOD_MS * 1000u )
+#define mainTICKS_US( x )                   ( ( x ) * mainUS_PER_TICK )
+
+#if ( configEDF_SMP_USE_US_TIMER == 1 )
+    #define mainEDF_SMP_TIME( ulUs )        ( ulUs )
+    #define mainEDF_SMP_TASK_COUNT          ( 6 )
+#else
+    #define mainEDF_SMP_TIME( ulUs )        ( ( ulUs ) / mainUS_PER_TICK )
+    #define mainEDF_SMP_TASK_COUNT          ( 5 )
+#endif
+
+#define mainEDF_SMP_CHECK_TICKS             ( 20 * TIME_SCALE )
+
+/*-----------------------------------------------------------*/
+
+typedef enum
+{
+    LOGIC_GPIO_0 =  20,
+    LOGIC_GPIO_1 =  21,
+    LOGIC_GPIO_2 =  22,
+    LOGIC_GPIO_3 =  26,
+    LOGIC_GPIO_4 =  27,
+    LOGIC_GPIO_5 =  28,
+    LOGIC_GPIO_6 =  2,
+} LogicAnalyzerGPIOS;
+
+typedef struct EDF_SMP_DEMO_TASK
+{
+    const char * pcName;
+    uint32_t ulExecutionTimeUs;
+    uint32_t ulDeadlineUs;
+    uint32_t ulPeriodUs;
+    uint32_t ulGPIO;
+} EDFSmpDemoTask_t;
+
+/*
+ * Called by main when mainCREATE_SIMPLE_EDF_DEMO_ONLY is set to 1 in
+ * main.c.
+ */
+void main_EDF_smp( uint16_t led );
+
+/*
+ * The tasks as described in the comments at the top of this file.
+ */
+static void prvTask( void *pvParameters );
+static void prvBusyWait( uint32_t ulUs );
+static void prvCheckStats( void );
+static void prvInitLogicGPIO( void );
+
+/*-----------------------------------------------------------*/
+
+/* Execution time, deadline and period in microseconds. */
+static const EDFSmpDemoTask_t xDemoTasks[ mainEDF_SMP_TASK_COUNT ] =
+{
+    { "Task1", mainTICKS_US( 2 * TIME_SCALE ), mainTICKS_US( 5 * TIME_SCALE ),  mainTICKS_US( 6 * TIME_SCALE ),  LOGIC_GPIO_0 },
+    { "Task2", mainTICKS_US( 2 * TIME_SCALE ), mainTICKS_US( 8 * TIME_SCALE ),  mainTICKS_US( 8 * TIME_SCALE ),  LOGIC_GPIO_1 },
+    { "Task3", mainTICKS_US( 3 * TIME_SCALE ), mainTICKS_US( 9 * TIME_SCALE ),  mainTICKS_US( 9 * TIME_SCALE ),  LOGIC_GPIO_2 },
+    { "Task4", mainTICKS_US( 2 * TIME_SCALE ), mainTICKS_US( 10 * TIME_SCALE ), mainTICKS_US( 10 * TIME_SCALE ), LOGIC_GPIO_3 },
+    { "Task5", mainTICKS_US( 3 * TIME_SCALE ), mainTICKS_US( 12 * TIME_SCALE ), mainTICKS_US( 12 * TIME_SCALE ), LOGIC_GPIO_4 },
+#if ( configEDF_SMP_USE_US_TIMER == 1 )
+    { "Loop1k", 150, 1000, 1000, LOGIC_GPIO_6 },
+#endif
+};
+
+static uint16_t externalLED;
+static TaskHandle_t xEDFTasks[ mainEDF_SMP_TASK_COUNT ];
+static volatile BaseType_t xStatsChecked = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+void main_EDF_smp( uint16_t led )
+{
+    UBaseType_t x;
+
+#if ( configEDF_SMP_GLOBAL == 1 )
+    printf(" Starting main_EDF_smp, global EDF");
+#else
+    printf(" Starting main_EDF_smp, partitioned EDF");
+#endif
+#if ( configEDF_SMP_USE_US_TIMER == 1 )
+    printf(", microsecond releases.\n");
+#else
+    printf(", tick releases.\n");
+#endif
+    externalLED = led;
+
+    prvInitLogicGPIO();
+
+    for( x = 0; x < mainEDF_SMP_TASK_COUNT; x++ )
+    {
+        configASSERT( xEDFSmpTaskCreate( prvTask, xDemoTasks[ x ].pcName, configMINIMAL_STACK_SIZE, ( void * ) &xDemoTasks[ x ], &xEDFTasks[ x ],
+                                         mainEDF_SMP_TIME( xDemoTasks[ x ].ulExecutionTimeUs ), mainEDF_SMP_TIME( xDemoTasks[ x ].ulDeadlineUs ),
+                                         mainEDF_SMP_TIME( xDemoTasks[ x ].ulPeriodUs ) ) == pdPASS );
+    }
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+    /* Below every EDF task, so printing the loads never delays a job. */
+    configASSERT( xRunTimeStatsTaskCreate( configEDF_SMP_BASE_PRIORITY ) == pdPASS );
+#endif
+
+    /* Place the tasks and start the scheduler running. */
+    configASSERT( xEDFSmpStartScheduler() != edfsmpNOT_SCHEDULABLE );
+
+	for( ;; );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTask( void *pvParameters )
+{
+    const EDFSmpDemoTask_t * pxDemoTask = ( const EDFSmpDemoTask_t * ) pvParameters;
+    TickType_t xWakeTime = xTaskGetTickCount();
+
+	for( ;; )
+	{
+        gpio_put( pxDemoTask->ulGPIO, 1 );
+        gpio_put( LOGIC_GPIO_5, get_core_num() );
+        prvBusyWait( pxDemoTask->ulExecutionTimeUs );
+        gpio_put( pxDemoTask->ulGPIO, 0 );
+
+        vEDFSmpTaskDone( &xWakeTime );
+
+        if( ( xStatsChecked == pdFALSE ) && ( xTaskGetTickCount() >= mainEDF_SMP_CHECK_TICKS ) )
+        {
+            prvCheckStats();
+        }
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckStats( void )
+{
+    EDFSmpStats_t xStats;
+    UBaseType_t x;
+
+    taskENTER_CRITICAL();
+    {
+        if( xStatsChecked != pdFALSE )
+        {
+            taskEXIT_CRITICAL();
+            return;
+        }
+
+        xStatsChecked = pdTRUE;
+    }
+    taskEXIT_CRITICAL();
+
+    for( x = 0; x < mainEDF_SMP_TASK_COUNT; x++ )
+    {
+        configASSERT( xEDFSmpGetStats( xEDFTasks[ x ], &xStats ) == pdPASS );
+        printf("%s: core %ld, %lu jobs, %lu misses, worst response %lu, release jitter %lu us\n",
+               xDemoTasks[ x ].pcName, ( long ) xStats.xCore, ( unsigned long ) xStats.ulJobs,
+               ( unsigned long ) xStats.ulMisses, ( unsigned long ) xStats.xWorstResponse,
+               ( unsigned long ) xStats.ulReleaseJitterUs);
+
+        configASSERT( xStats.ulJobs > 0 );
+        configASSERT( xStats.ulMisses == 0 );
+        configASSERT( xStats.xWorstResponse <= xStats.xDeadline );
+    }
+
+    gpio_put( externalLED, 1 );
+    printf("main_EDF_smp: no deadline misses.\n");
+}
+/*-----------------------------------------------------------*/
+
+static void prvBusyWait( uint32_t ulUs )
+{
+    /* Wall clock time rather than processor time, so a job that is
+    preempted finishes early, never late. */
+    busy_wait_us( ulUs );
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitLogicGPIO( void )
+{
+    static const uint32_t ulPins[] = { LOGIC_GPIO_0, LOGIC_GPIO_1, LOGIC_GPIO_2, LOGIC_GPIO_3, LOGIC_GPIO_4, LOGIC_GPIO_5, LOGIC_GPIO_6 };
+    size_t x;
+
+    for( x = 0; x < sizeof( ulPins ) / sizeof( ulPins[ 0 ] ); x++ )
+    {
+        gpio_init( ulPins[ x ] );
+        gpio_set_dir( ulPins[ x ], 1 );
+        gpio_put( ulPins[ x ], 0 );
+    }
+}
@@ -0,0 +1,248 @@
+/*
+ * FreeRTOS V202212.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ *
+ * main_EDF_smp() in this file shows the budgets of EDFSmp.c keeping the
+ * other tasks' deadlines when one EDF task misbehaves.
+ *
+ * Task1 and Task2 are the first two tasks of Standard/main_EDF.c. Task3 is
+ * admitted with, and given a budget of, 2 * TIME_SCALE ticks in every
+ * 9 * TIME_SCALE, but every third job it runs for three times that. Without
+ * a budget that job would hold the earliest deadline for 6 * TIME_SCALE
+ * ticks and Task1 and Task2 would miss.
+ *
+ * Task3 never checks its budget. Each time it uses it up the tick hook
+ * wakes the EDFSmp supervisor, which postpones Task3's deadline by its
+ * period, so the overrunning job carries on behind Task1 and Task2 and they
+ * meet every deadline. Task3 misses instead.
+ *
+ * A fourth, monitoring, EDF task with a long period prints the statistics
+ * and asserts that Task1 and Task2 have not missed and that Task3 was
+ * postponed. First fit decreasing places all four tasks on core 0, which
+ * it also asserts, so this is uniprocessor EDF on that core.
+ *
+ * The set, with Task3 at its budget, has U = 0.807 and passes the EDF
+ * schedulability test in EDFAnalysis/ with room for a tick of accounting
+ * error and the scheduling overheads.
+ *
+ */
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "EDFSmp.h"
+#include "RunTimeStats.h"
+
+/* Library includes. */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/clocks.h"
+
+#if ( configEDF_SMP_BUDGETS != 1 )
+    #error main_EDF_smp_budget.c requires configEDF_SMP_BUDGETS to be 1
+#endif
+
+#if ( configEDF_SMP_USE_US_TIMER == 1 )
+    #error main_EDF_smp_budget.c gives its times in ticks
+#endif
+
+#define TIME_SCALE                          (1000)
+
+/* Every mainBUDGET_OVERRUN_EVERY'th job of Task3 runs for
+mainBUDGET_OVERRUN_FACTOR times its budget. */
+#define mainBUDGET_OVERRUN_EVERY               ( 3 )
+#define mainBUDGET_OVERRUN_FACTOR              ( 3 )
+
+#define mainBUDGET_CHECK_TIME                  ( 50 )
+#define mainBUDGET_CHECK_PERIOD                ( 36 * TIME_SCALE )
+#define mainBUDGET_CHECK_DEADLINE              ( 36 * TIME_SCALE )
+
+/*-----------------------------------------------------------*/
+
+typedef enum
+{
+    LOGIC_GPIO_0 =  20,
+    LOGIC_GPIO_1 =  21,
+    LOGIC_GPIO_2 =  22,
+} LogicAnalyzerGPIOS;
+
+typedef struct BUDGET_TASK_PARAMS
+{
+    uint32_t ulExecutionTicks;      /* Nominal execution time of a job. */
+    BaseType_t xMisbehave;          /* Whether some jobs overrun. */
+    uint32_t ulGPIO;
+} BudgetTaskParams_t;
+
+/*
+ * Called by main when mainCREATE_SIMPLE_EDF_DEMO_ONLY is set to 1 in
+ * main.c.
+ */
+void main_EDF_smp( uint16_t led );
+
+/*
+ * The tasks as described in the comments at the top of this file.
+ */
+static void prvTask( void *pvParameters );
+static void prvCheckTask( void *pvParameters );
+static __noinline void prvSpinOneMs( void );
+static void prvInitLogicGPIO( void );
+
+/*-----------------------------------------------------------*/
+
+static uint16_t externalLED;
+static TaskHandle_t xTask1, xTask2, xTask3;
+static const BudgetTaskParams_t xTask1Params = { 2 * TIME_SCALE, pdFALSE, LOGIC_GPIO_0 };
+static const BudgetTaskParams_t xTask2Params = { 2 * TIME_SCALE, pdFALSE, LOGIC_GPIO_1 };
+static const BudgetTaskParams_t xTask3Params = { 2 * TIME_SCALE, pdTRUE, LOGIC_GPIO_2 };
+
+/*-----------------------------------------------------------*/
+
+void main_EDF_smp( uint16_t led )
+{
+    printf(" Starting main_EDF_smp, enforced budget.\n");
+    externalLED = led;
+
+    prvInitLogicGPIO();
+
+    configASSERT( xEDFSmpTaskCreate( prvTask, "Task1", configMINIMAL_STACK_SIZE, ( void * ) &xTask1Params, &xTask1,
+                                     xTask1Params.ulExecutionTicks, 4 * TIME_SCALE, 6 * TIME_SCALE ) == pdPASS );
+    configASSERT( xEDFSmpTaskCreate( prvTask, "Task2", configMINIMAL_STACK_SIZE, ( void * ) &xTask2Params, &xTask2,
+                                     xTask2Params.ulExecutionTicks, 5 * TIME_SCALE, 8 * TIME_SCALE ) == pdPASS );
+    configASSERT( xEDFSmpTaskCreate( prvTask, "Task3", configMINIMAL_STACK_SIZE, ( void * ) &xTask3Params, &xTask3,
+                                     xTask3Params.ulExecutionTicks, 7 * TIME_SCALE, 9 * TIME_SCALE ) == pdPASS );
+    configASSERT( xEDFSmpSetBudget( xTask3, xTask3Params.ulExecutionTicks ) == pdPASS );
+
+    configASSERT( xEDFSmpTaskCreate( prvCheckTask, "Check", configMINIMAL_STACK_SIZE * 2, NULL, NULL,
+                                     mainBUDGET_CHECK_TIME, mainBUDGET_CHECK_DEADLINE, mainBUDGET_CHECK_PERIOD ) == pdPASS );
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+    /* Below every EDF task, so printing the loads never delays a job. */
+    configASSERT( xRunTimeStatsTaskCreate( configEDF_SMP_BASE_PRIORITY ) == pdPASS );
+#endif
+
+    /* Place the tasks and start the scheduler running. */
+    configASSERT( xEDFSmpStartScheduler() != edfsmpNOT_SCHEDULABLE );
+
+    for( ;; );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTask( void *pvParameters )
+{
+    const BudgetTaskParams_t *pxParams = ( const BudgetTaskParams_t * ) pvParameters;
+    TickType_t xWakeTime = xTaskGetTickCount();
+    uint32_t ulJob = 0;
+    uint32_t ulTicks, ulTick;
+
+    for( ;; )
+    {
+        ulTicks = pxParams->ulExecutionTicks;
+
+        if( ( pxParams->xMisbehave != pdFALSE ) && ( ( ulJob % mainBUDGET_OVERRUN_EVERY ) == 0 ) )
+        {
+            ulTicks *= mainBUDGET_OVERRUN_FACTOR;
+        }
+
+        gpio_put( pxParams->ulGPIO, 1 );
+
+        for( ulTick = 0; ulTick < ulTicks; ulTick++ )
+        {
+            prvSpinOneMs();
+        }
+
+        gpio_put( pxParams->ulGPIO, 0 );
+        ulJob++;
+
+        vEDFSmpTaskDone( &xWakeTime );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckTask( void *pvParameters )
+{
+    TickType_t xWakeTime = xTaskGetTickCount();
+    const TaskHandle_t xTasks[] = { xTask1, xTask2, xTask3 };
+    EDFSmpStats_t xStats;
+    size_t x;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        /* Nothing has run yet on the first release. */
+        vEDFSmpTaskDone( &xWakeTime );
+
+        for( x = 0; x < sizeof( xTasks ) / sizeof( xTasks[ 0 ] ); x++ )
+        {
+            configASSERT( xEDFSmpGetStats( xTasks[ x ], &xStats ) == pdPASS );
+            printf("%s: core %ld, %lu jobs, %lu misses, worst response %lu, budget %lu, postponed %lu\n",
+                   pcTaskGetName( xTasks[ x ] ), ( long ) xStats.xCore, ( unsigned long ) xStats.ulJobs,
+                   ( unsigned long ) xStats.ulMisses, ( unsigned long ) xStats.xWorstResponse,
+                   ( unsigned long ) xStats.xBudget, ( unsigned long ) xStats.ulPostponed );
+
+            /* The tasks only contend if they share a core. */
+            configASSERT( xStats.xCore == 0 );
+            configASSERT( xStats.ulJobs > 0 );
+
+            if( xTasks[ x ] == xTask3 )
+            {
+                configASSERT( xStats.ulPostponed > 0 );
+            }
+            else
+            {
+                configASSERT( xStats.ulMisses == 0 );
+            }
+        }
+
+        gpio_put( externalLED, 1 );
+        printf( "main_EDF_smp budget: Task1 and Task2 met every deadline while Task3 overran.\n" );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static __noinline void prvSpinOneMs( void )
+{
+    // cycles = clk_sys_hz / 1000
+    busy_wait_at_least_cycles( clock_get_hz( clk_sys ) / 1000u );
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitLogicGPIO( void )
+{
+    const uint32_t ulPins[] = { LOGIC_GPIO_0, LOGIC_GPIO_1, LOGIC_GPIO_2 };
+    size_t x;
+
+    for( x = 0; x < sizeof( ulPins ) / sizeof( ulPins[ 0 ] ); x++ )
+    {
+        gpio_init( ulPins[ x ] );
+        gpio_set_dir( ulPins[ x ], 1 );
+        gpio_put( ulPins[ x ], 0 );
+    }
+}
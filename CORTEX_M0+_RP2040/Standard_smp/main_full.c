@@ -97,6 +97,8 @@
 #include "TaskNotify.h"
 
 #include "main.h"
+#include "IntQueueTimer.h"
+#include "RunTimeStats.h"
 
 /* Priorities for the demo application tasks. */
 #define mainSEM_TEST_PRIORITY				( tskIDLE_PRIORITY + 1UL )
@@ -181,6 +183,10 @@ void main_full( void )
     puts("  - Interrupt Queue");
 	vStartInterruptQueueTasks();
 #endif
+#if (mainENABLE_INTERRUPT_QUEUE == 1) && (mainINT_QUEUE_STRESS == 1)
+    puts("  - Interrupt Queue stress");
+	xStartIntQueueTimerStress();
+#endif
 #if (mainENABLE_DYNAMIC_PRIORITY == 1)
     puts("  - Dynamic Priority");
 	vStartDynamicPriorityTasks();
@@ -245,6 +251,11 @@ void main_full( void )
 	the top of this file. */
 	xTaskCreate( prvCheckTask, "Check", configMINIMAL_STACK_SIZE, NULL, mainCHECK_TASK_PRIORITY, NULL );
 
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+	/* Print the CPU load of each task and core from a low priority task. */
+	xRunTimeStatsTaskCreate( tskIDLE_PRIORITY + 1 );
+#endif
+
 	/* The set of tasks created by the following function call have to be
 	created last as they keep account of the number of tasks they expect to see
 	running. */
@@ -292,7 +303,7 @@ unsigned long ulIterations = 0;
 		/* Delay until it is time to execute again. */
 		vTaskDelayUntil( &xLastExecutionTime, xDelayPeriod );
 
-        #if (mainENABLE_INTERRUPT_QUEUE == 1)
+        #if (mainENABLE_INTERRUPT_QUEUE == 1) && (mainINT_QUEUE_STRESS == 0)
 		/* Check all the demo tasks (other than the flash tasks) to ensure
 		that they are all still running, and that none have detected an error. */
 		if( xAreIntQueueTasksStillRunning() != pdTRUE )
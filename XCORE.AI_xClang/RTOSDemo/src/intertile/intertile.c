@@ -0,0 +1,456 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+
+/* Standard includes. */
+#include <string.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include <xcore/chanend.h>
+#include <xcore/triggerable.h>
+
+#include "intertile.h"
+
+/*
+ * Every transaction starts with a header word holding the packet type in the
+ * top byte and a length or credit count in the low 24 bits, and ends with an
+ * END control token.
+ */
+#define intertileTYPE_SHIFT			24
+#define intertileLENGTH_MASK		0x00FFFFFFUL
+
+#define intertileTYPE_ITEM			0x01	/* sender -> receiver, an item for the ring */
+#define intertileTYPE_BULK			0x02	/* sender -> receiver, fills the posted bulk buffer */
+#define intertileTYPE_ITEM_CREDIT	0x81	/* receiver -> sender, ring slots freed */
+#define intertileTYPE_BULK_CREDIT	0x82	/* receiver -> sender, capacity of a posted bulk buffer */
+
+#define intertileHEADER( type, len )	( ( ( uint32_t ) ( type ) << intertileTYPE_SHIFT ) | ( ( uint32_t ) ( len ) & intertileLENGTH_MASK ) )
+
+typedef struct xINTERTILE_QUEUE
+{
+	chanend_t xChanend;				/* Local end, its destination is the other tile's end. */
+	BaseType_t xIsSender;
+	UBaseType_t uxLength;
+	UBaseType_t uxItemSize;
+	SemaphoreHandle_t xTxMutex;		/* Serialises transactions started on this tile. */
+
+	/* Sender end state. */
+	UBaseType_t uxItemCredits;
+	size_t xBulkCredit;				/* Capacity of the posted remote buffer, 0 when none. */
+
+	/* Receiver end state. */
+	uint8_t *pucRing;
+	UBaseType_t uxHead;
+	UBaseType_t uxCount;
+	UBaseType_t uxCreditsToReturn;
+	uint8_t *pucBulkBuffer;			/* Posted buffer, owned by the ISR until filled. */
+	size_t xBulkReceived;
+
+	/* Task blocked on this end, notified from the ISR. */
+	TaskHandle_t xWaitingTask;
+} IntertileQueue_t;
+
+/*-----------------------------------------------------------*/
+
+static void prvChanendOutBuf( chanend_t xChanend, const uint8_t *pucData, size_t xLength )
+{
+	uint32_t ulWord;
+
+	while( xLength >= sizeof( uint32_t ) )
+	{
+		memcpy( &ulWord, pucData, sizeof( uint32_t ) );
+		chanend_out_word( xChanend, ulWord );
+		pucData += sizeof( uint32_t );
+		xLength -= sizeof( uint32_t );
+	}
+
+	while( xLength-- > 0 )
+	{
+		chanend_out_byte( xChanend, *pucData++ );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvChanendInBuf( chanend_t xChanend, uint8_t *pucData, size_t xLength )
+{
+	uint32_t ulWord;
+
+	while( xLength >= sizeof( uint32_t ) )
+	{
+		ulWord = chanend_in_word( xChanend );
+		memcpy( pucData, &ulWord, sizeof( uint32_t ) );
+		pucData += sizeof( uint32_t );
+		xLength -= sizeof( uint32_t );
+	}
+
+	while( xLength-- > 0 )
+	{
+		*pucData++ = chanend_in_byte( xChanend );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendPacket( IntertileQueue_t *pxQueue, uint32_t ulHeader, const uint8_t *pucData, size_t xLength )
+{
+	xSemaphoreTake( pxQueue->xTxMutex, portMAX_DELAY );
+	{
+		chanend_out_word( pxQueue->xChanend, ulHeader );
+		prvChanendOutBuf( pxQueue->xChanend, pucData, xLength );
+		chanend_out_end_token( pxQueue->xChanend );
+	}
+	xSemaphoreGive( pxQueue->xTxMutex );
+}
+/*-----------------------------------------------------------*/
+
+typedef enum
+{
+	eWaitItemCredit,
+	eWaitBulkCredit,
+	eWaitItem,
+	eWaitBulk
+} IntertileWait_t;
+
+/* A switch rather than function pointers keeps the task stack depth
+calculable by the xcore tools. */
+static BaseType_t prvReady( IntertileQueue_t *pxQueue, IntertileWait_t eWait )
+{
+	switch( eWait )
+	{
+		case eWaitItemCredit:	return pxQueue->uxItemCredits > 0;
+		case eWaitBulkCredit:	return pxQueue->xBulkCredit > 0;
+		case eWaitItem:			return pxQueue->uxCount > 0;
+		case eWaitBulk:			return pxQueue->xBulkReceived > 0;
+		default:				return pdFALSE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Blocks the calling task until the condition selected by eWait holds or the
+ * timeout expires. Must be called from inside a critical section, which it
+ * returns from still held.
+ */
+static BaseType_t prvWait( IntertileQueue_t *pxQueue,
+						   IntertileWait_t eWait,
+						   TimeOut_t *pxTimeOut,
+						   TickType_t *pxTicksToWait )
+{
+	while( prvReady( pxQueue, eWait ) == pdFALSE )
+	{
+		if( xTaskCheckForTimeOut( pxTimeOut, pxTicksToWait ) != pdFALSE )
+		{
+			return pdFAIL;
+		}
+
+		configASSERT( pxQueue->xWaitingTask == NULL );
+		pxQueue->xWaitingTask = xTaskGetCurrentTaskHandle();
+		taskEXIT_CRITICAL();
+
+		ulTaskNotifyTake( pdTRUE, *pxTicksToWait );
+
+		taskENTER_CRITICAL();
+		pxQueue->xWaitingTask = NULL;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+DEFINE_RTOS_INTERRUPT_CALLBACK( prvIntertileISR, pvData )
+{
+	IntertileQueue_t *pxQueue = ( IntertileQueue_t * ) pvData;
+	BaseType_t xYieldRequired = pdFALSE;
+	UBaseType_t uxSavedInterruptStatus;
+	uint32_t ulHeader;
+	size_t xLength;
+	UBaseType_t uxTail;
+
+	ulHeader = chanend_in_word( pxQueue->xChanend );
+	xLength = ulHeader & intertileLENGTH_MASK;
+
+	switch( ulHeader >> intertileTYPE_SHIFT )
+	{
+		case intertileTYPE_ITEM:
+			/* The sender only sends with a credit in hand so there is
+			always a free slot. The tail slot is not visible to the task
+			until uxCount is incremented below. */
+			configASSERT( xLength == pxQueue->uxItemSize );
+			configASSERT( pxQueue->uxCount < pxQueue->uxLength );
+			uxTail = ( pxQueue->uxHead + pxQueue->uxCount ) % pxQueue->uxLength;
+			prvChanendInBuf( pxQueue->xChanend, &pxQueue->pucRing[ uxTail * pxQueue->uxItemSize ], xLength );
+			chanend_check_end_token( pxQueue->xChanend );
+
+			uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+			pxQueue->uxCount++;
+			break;
+
+		case intertileTYPE_BULK:
+			configASSERT( pxQueue->pucBulkBuffer != NULL );
+			prvChanendInBuf( pxQueue->xChanend, pxQueue->pucBulkBuffer, xLength );
+			chanend_check_end_token( pxQueue->xChanend );
+
+			uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+			pxQueue->xBulkReceived = xLength;
+			break;
+
+		case intertileTYPE_ITEM_CREDIT:
+			chanend_check_end_token( pxQueue->xChanend );
+
+			uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+			pxQueue->uxItemCredits += xLength;
+			break;
+
+		case intertileTYPE_BULK_CREDIT:
+			chanend_check_end_token( pxQueue->xChanend );
+
+			uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+			pxQueue->xBulkCredit = xLength;
+			break;
+
+		default:
+			configASSERT( 0 );
+			return;
+	}
+
+	if( pxQueue->xWaitingTask != NULL )
+	{
+		vTaskNotifyGiveFromISR( pxQueue->xWaitingTask, &xYieldRequired );
+	}
+	taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+
+	portYIELD_FROM_ISR( xYieldRequired );
+}
+/*-----------------------------------------------------------*/
+
+IntertileQueueHandle_t xIntertileQueueCreate( chanend_t xOtherTileChan,
+											  BaseType_t xIsSender,
+											  UBaseType_t uxQueueLength,
+											  UBaseType_t uxItemSize )
+{
+IntertileQueue_t *pxQueue;
+chanend_t xRemote;
+uint32_t ulState;
+
+	configASSERT( uxQueueLength > 0 && uxQueueLength <= intertileLENGTH_MASK );
+	configASSERT( uxItemSize > 0 && uxItemSize <= intertileLENGTH_MASK );
+
+	pxQueue = pvPortMalloc( sizeof( IntertileQueue_t ) );
+	configASSERT( pxQueue != NULL );
+	memset( pxQueue, 0, sizeof( IntertileQueue_t ) );
+
+	pxQueue->xIsSender = xIsSender;
+	pxQueue->uxLength = uxQueueLength;
+	pxQueue->uxItemSize = uxItemSize;
+	pxQueue->xTxMutex = xSemaphoreCreateMutex();
+	configASSERT( pxQueue->xTxMutex != NULL );
+
+	if( xIsSender != pdFALSE )
+	{
+		/* The whole receive ring starts out as credit. */
+		pxQueue->uxItemCredits = uxQueueLength;
+	}
+	else
+	{
+		pxQueue->pucRing = pvPortMalloc( uxQueueLength * uxItemSize );
+		configASSERT( pxQueue->pucRing != NULL );
+	}
+
+	pxQueue->xChanend = chanend_alloc();
+
+	/* Exchange channel end IDs. The sender talks first so that both
+	tiles agree on the order without any further handshake. */
+	if( xIsSender != pdFALSE )
+	{
+		chanend_out_word( xOtherTileChan, pxQueue->xChanend );
+		chanend_out_end_token( xOtherTileChan );
+		xRemote = chanend_in_word( xOtherTileChan );
+		chanend_check_end_token( xOtherTileChan );
+	}
+	else
+	{
+		xRemote = chanend_in_word( xOtherTileChan );
+		chanend_check_end_token( xOtherTileChan );
+		chanend_out_word( xOtherTileChan, pxQueue->xChanend );
+		chanend_out_end_token( xOtherTileChan );
+	}
+	chanend_set_dest( pxQueue->xChanend, xRemote );
+
+	/*
+	 * Disable interrupts here so the interrupt is set up
+	 * on the same core that enables it.
+	 */
+	ulState = portDISABLE_INTERRUPTS();
+	{
+		triggerable_setup_interrupt_callback( pxQueue->xChanend, pxQueue, RTOS_INTERRUPT_CALLBACK( prvIntertileISR ) );
+		triggerable_enable_trigger( pxQueue->xChanend );
+	}
+	portRESTORE_INTERRUPTS( ulState );
+
+	return pxQueue;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIntertileQueueSend( IntertileQueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait )
+{
+IntertileQueue_t *pxQueue = xQueue;
+TimeOut_t xTimeOut;
+BaseType_t xReturn;
+
+	configASSERT( pxQueue->xIsSender != pdFALSE );
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = prvWait( pxQueue, eWaitItemCredit, &xTimeOut, &xTicksToWait );
+		if( xReturn == pdPASS )
+		{
+			pxQueue->uxItemCredits--;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( xReturn == pdPASS )
+	{
+		prvSendPacket( pxQueue, intertileHEADER( intertileTYPE_ITEM, pxQueue->uxItemSize ), pvItemToQueue, pxQueue->uxItemSize );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIntertileQueueReceive( IntertileQueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait )
+{
+IntertileQueue_t *pxQueue = xQueue;
+TimeOut_t xTimeOut;
+BaseType_t xReturn;
+UBaseType_t uxCredits = 0;
+
+	configASSERT( pxQueue->xIsSender == pdFALSE );
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = prvWait( pxQueue, eWaitItem, &xTimeOut, &xTicksToWait );
+	}
+	taskEXIT_CRITICAL();
+
+	if( xReturn == pdPASS )
+	{
+		/* The head slot cannot be written by the ISR until its credit
+		has been returned, so it is safe to copy out of the ring here. */
+		memcpy( pvBuffer, &pxQueue->pucRing[ pxQueue->uxHead * pxQueue->uxItemSize ], pxQueue->uxItemSize );
+
+		taskENTER_CRITICAL();
+		{
+			pxQueue->uxHead = ( pxQueue->uxHead + 1 ) % pxQueue->uxLength;
+			pxQueue->uxCount--;
+
+			/* Return credits in batches of half the ring to keep the
+			reverse channel traffic down. */
+			if( ++pxQueue->uxCreditsToReturn >= ( pxQueue->uxLength + 1 ) / 2 )
+			{
+				uxCredits = pxQueue->uxCreditsToReturn;
+				pxQueue->uxCreditsToReturn = 0;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( uxCredits > 0 )
+		{
+			prvSendPacket( pxQueue, intertileHEADER( intertileTYPE_ITEM_CREDIT, uxCredits ), NULL, 0 );
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIntertileBulkSend( IntertileQueueHandle_t xQueue, const void *pvData, size_t xLength, TickType_t xTicksToWait )
+{
+IntertileQueue_t *pxQueue = xQueue;
+TimeOut_t xTimeOut;
+BaseType_t xReturn;
+
+	configASSERT( pxQueue->xIsSender != pdFALSE );
+	configASSERT( xLength > 0 && xLength <= intertileLENGTH_MASK );
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = prvWait( pxQueue, eWaitBulkCredit, &xTimeOut, &xTicksToWait );
+		if( xReturn == pdPASS )
+		{
+			if( pxQueue->xBulkCredit >= xLength )
+			{
+				pxQueue->xBulkCredit = 0;
+			}
+			else
+			{
+				/* Leave the credit for a send that fits. */
+				xReturn = pdFAIL;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( xReturn == pdPASS )
+	{
+		prvSendPacket( pxQueue, intertileHEADER( intertileTYPE_BULK, xLength ), pvData, xLength );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xIntertileBulkReceive( IntertileQueueHandle_t xQueue, void *pvBuffer, size_t xBufferLength, TickType_t xTicksToWait )
+{
+IntertileQueue_t *pxQueue = xQueue;
+TimeOut_t xTimeOut;
+BaseType_t xPost = pdFALSE;
+size_t xReceived = 0;
+
+	configASSERT( pxQueue->xIsSender == pdFALSE );
+	configASSERT( xBufferLength > 0 && xBufferLength <= intertileLENGTH_MASK );
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	taskENTER_CRITICAL();
+	{
+		if( pxQueue->pucBulkBuffer == NULL )
+		{
+			/* Hand the buffer over to the ISR. */
+			pxQueue->pucBulkBuffer = pvBuffer;
+			xPost = pdTRUE;
+		}
+		else
+		{
+			/* Still posted from a call that timed out. */
+			configASSERT( pxQueue->pucBulkBuffer == pvBuffer );
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( xPost != pdFALSE )
+	{
+		prvSendPacket( pxQueue, intertileHEADER( intertileTYPE_BULK_CREDIT, xBufferLength ), NULL, 0 );
+	}
+
+	taskENTER_CRITICAL();
+	{
+		if( prvWait( pxQueue, eWaitBulk, &xTimeOut, &xTicksToWait ) == pdPASS )
+		{
+			/* Ownership of the buffer returns to the caller. */
+			xReceived = pxQueue->xBulkReceived;
+			pxQueue->xBulkReceived = 0;
+			pxQueue->pucBulkBuffer = NULL;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReceived;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+
+#ifndef INTERTILE_H_
+#define INTERTILE_H_
+
+#include <xcore/chanend.h>
+
+/*
+ * Inter-tile queues connect one FreeRTOS instance to the FreeRTOS instance
+ * running on another tile. Each queue is unidirectional and is created on both
+ * tiles, once as the sending end and once as the receiving end.
+ *
+ * Small fixed size items are streamed over the channel into a ring on the
+ * receiving tile. The sender holds one credit per free slot of that ring and
+ * never starts a transaction the receiver cannot drain immediately. Credits
+ * are returned in batches as the receiving task consumes items.
+ *
+ * Bulk buffers are moved without staging copies. The receiving task posts its
+ * own buffer, which hands a single bulk credit (the buffer capacity) to the
+ * sender. The sender then streams straight from its buffer into the posted
+ * one and ownership of the buffer returns to the receiving task.
+ *
+ * Both ends are serviced from chanend interrupts on the core that created the
+ * queue. Blocked tasks are woken with task notifications from those ISRs so
+ * that tasks running on other cores are rescheduled through rtos_irq().
+ */
+
+typedef struct xINTERTILE_QUEUE * IntertileQueueHandle_t;
+
+/*
+ * Creates one end of an inter-tile queue. Must be called with matching
+ * parameters on both tiles, in the same order relative to any other use of
+ * xOtherTileChan, before the scheduler is started.
+ *
+ * xOtherTileChan is the channel end connected to the other tile (as passed to
+ * c_main()). xIsSender selects which end is created on this tile.
+ * uxQueueLength and uxItemSize size the receive ring of small items.
+ */
+IntertileQueueHandle_t xIntertileQueueCreate( chanend_t xOtherTileChan,
+											  BaseType_t xIsSender,
+											  UBaseType_t uxQueueLength,
+											  UBaseType_t uxItemSize );
+
+/*
+ * Sends one item of the size given at creation. Blocks for up to
+ * xTicksToWait while the receiving ring is full.
+ */
+BaseType_t xIntertileQueueSend( IntertileQueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait );
+
+/*
+ * Receives one item of the size given at creation. Blocks for up to
+ * xTicksToWait while the queue is empty.
+ */
+BaseType_t xIntertileQueueReceive( IntertileQueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait );
+
+/*
+ * Streams xLength bytes from pvData directly into the buffer posted by the
+ * receiving task. Blocks for up to xTicksToWait for a buffer to be posted.
+ * Returns pdFAIL if the posted buffer is smaller than xLength.
+ */
+BaseType_t xIntertileBulkSend( IntertileQueueHandle_t xQueue, const void *pvData, size_t xLength, TickType_t xTicksToWait );
+
+/*
+ * Posts pvBuffer to the sender and blocks for up to xTicksToWait for it to be
+ * filled. Returns the number of bytes received, or 0 on timeout. After a
+ * timeout the buffer remains posted and will be filled by the next bulk send,
+ * so it must not be reused until a subsequent call returns non-zero.
+ */
+size_t xIntertileBulkReceive( IntertileQueueHandle_t xQueue, void *pvBuffer, size_t xBufferLength, TickType_t xTicksToWait );
+
+#endif /* INTERTILE_H_ */
@@ -0,0 +1,214 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+
+/*
+ * Inter-tile queue benchmark. Tile 0 sends and times, tile 1 echoes.
+ *
+ * For each message size the item path (for sizes that fit an item queue) and
+ * the bulk path are measured in two ways:
+ *  - Throughput: tile 0 sends benchNUM_MESSAGES messages back to back, tile 1
+ *    acknowledges once it has received the last of them.
+ *  - Latency: tile 0 sends one message at a time and waits for tile 1 to
+ *    acknowledge it. The reported figure is the average round trip of the
+ *    message out and a 4 byte acknowledgement back.
+ *
+ * Times are taken from the 100MHz reference clock.
+ */
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <xcore/hwtimer.h>
+
+#include "intertile.h"
+#include "intertile_bench.h"
+
+#define benchNUM_MESSAGES		256
+#define benchNUM_ROUND_TRIPS	64
+#define benchITEM_QUEUE_LENGTH	4
+#define benchNUM_ITEM_SIZES		( sizeof( uxItemSizes ) / sizeof( uxItemSizes[ 0 ] ) )
+#define benchNUM_BULK_SIZES		( sizeof( uxBulkSizes ) / sizeof( uxBulkSizes[ 0 ] ) )
+#define benchMAX_MESSAGE_SIZE	4096
+#define benchREF_CLOCK_HZ		100000000UL
+
+static const UBaseType_t uxItemSizes[] = { 4, 16, 64, 256 };
+static const UBaseType_t uxBulkSizes[] = { 4, 16, 64, 256, 1024, 4096 };
+
+static IntertileQueueHandle_t xItemQueues[ sizeof( uxItemSizes ) / sizeof( uxItemSizes[ 0 ] ) ];
+static IntertileQueueHandle_t xBulkQueue;
+static IntertileQueueHandle_t xAckQueue;
+
+/* Word aligned so the bulk path streams whole words. */
+static uint32_t ulMessage[ benchMAX_MESSAGE_SIZE / sizeof( uint32_t ) ];
+
+static void prvBenchSenderTask( void *pvParameters );
+static void prvBenchEchoTask( void *pvParameters );
+
+/*-----------------------------------------------------------*/
+
+void vStartIntertileBenchmark( int tile, chanend_t xOtherTileChan, UBaseType_t uxPriority )
+{
+BaseType_t xIsSender = ( tile == 0 ) ? pdTRUE : pdFALSE;
+size_t i;
+
+	/* Both tiles create the queues in the same order. */
+	for( i = 0; i < benchNUM_ITEM_SIZES; i++ )
+	{
+		xItemQueues[ i ] = xIntertileQueueCreate( xOtherTileChan, xIsSender, benchITEM_QUEUE_LENGTH, uxItemSizes[ i ] );
+	}
+	xBulkQueue = xIntertileQueueCreate( xOtherTileChan, xIsSender, 1, sizeof( uint32_t ) );
+	xAckQueue = xIntertileQueueCreate( xOtherTileChan, !xIsSender, 1, sizeof( uint32_t ) );
+
+	if( xIsSender != pdFALSE )
+	{
+		xTaskCreate( prvBenchSenderTask, "BenchTx", portTASK_STACK_DEPTH( prvBenchSenderTask ), NULL, uxPriority, NULL );
+	}
+	else
+	{
+		xTaskCreate( prvBenchEchoTask, "BenchRx", portTASK_STACK_DEPTH( prvBenchEchoTask ), NULL, uxPriority, NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvReport( const char *pcPath, UBaseType_t uxSize, uint32_t ulThroughputTicks, uint32_t ulRoundTripTicks )
+{
+uint64_t ullBytes = ( uint64_t ) uxSize * benchNUM_MESSAGES;
+uint32_t ulKBps;
+uint32_t ulMsgps;
+
+	ulKBps = ( uint32_t ) ( ( ullBytes * ( benchREF_CLOCK_HZ / 1000 ) ) / ulThroughputTicks );
+	ulMsgps = ( uint32_t ) ( ( ( uint64_t ) benchNUM_MESSAGES * benchREF_CLOCK_HZ ) / ulThroughputTicks );
+
+	rtos_printf( "%s %4u B: %6u KB/s %7u msg/s, round trip %6u ns\n",
+				 pcPath,
+				 uxSize,
+				 ulKBps,
+				 ulMsgps,
+				 ( ulRoundTripTicks / benchNUM_ROUND_TRIPS ) * ( 1000000000UL / benchREF_CLOCK_HZ ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWaitAck( void )
+{
+uint32_t ulAck;
+
+	xIntertileQueueReceive( xAckQueue, &ulAck, portMAX_DELAY );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendAck( void )
+{
+uint32_t ulAck = 0;
+
+	xIntertileQueueSend( xAckQueue, &ulAck, portMAX_DELAY );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchSenderTask( void *pvParameters )
+{
+uint32_t ulStart, ulThroughput, ulRoundTrip;
+size_t i, j;
+
+	( void ) pvParameters;
+
+	for( i = 0; i < benchMAX_MESSAGE_SIZE / sizeof( uint32_t ); i++ )
+	{
+		ulMessage[ i ] = i;
+	}
+
+	/* Let the rest of the demo get going first. */
+	vTaskDelay( pdMS_TO_TICKS( 1000 ) );
+
+	for( ;; )
+	{
+		rtos_printf( "Inter-tile benchmark, %u messages, %u round trips\n", benchNUM_MESSAGES, benchNUM_ROUND_TRIPS );
+
+		for( i = 0; i < benchNUM_ITEM_SIZES; i++ )
+		{
+			ulStart = get_reference_time();
+			for( j = 0; j < benchNUM_MESSAGES; j++ )
+			{
+				xIntertileQueueSend( xItemQueues[ i ], ulMessage, portMAX_DELAY );
+			}
+			prvWaitAck();
+			ulThroughput = get_reference_time() - ulStart;
+
+			ulStart = get_reference_time();
+			for( j = 0; j < benchNUM_ROUND_TRIPS; j++ )
+			{
+				xIntertileQueueSend( xItemQueues[ i ], ulMessage, portMAX_DELAY );
+				prvWaitAck();
+			}
+			ulRoundTrip = get_reference_time() - ulStart;
+
+			prvReport( "item", uxItemSizes[ i ], ulThroughput, ulRoundTrip );
+		}
+
+		for( i = 0; i < benchNUM_BULK_SIZES; i++ )
+		{
+			ulStart = get_reference_time();
+			for( j = 0; j < benchNUM_MESSAGES; j++ )
+			{
+				xIntertileBulkSend( xBulkQueue, ulMessage, uxBulkSizes[ i ], portMAX_DELAY );
+			}
+			prvWaitAck();
+			ulThroughput = get_reference_time() - ulStart;
+
+			ulStart = get_reference_time();
+			for( j = 0; j < benchNUM_ROUND_TRIPS; j++ )
+			{
+				xIntertileBulkSend( xBulkQueue, ulMessage, uxBulkSizes[ i ], portMAX_DELAY );
+				prvWaitAck();
+			}
+			ulRoundTrip = get_reference_time() - ulStart;
+
+			prvReport( "bulk", uxBulkSizes[ i ], ulThroughput, ulRoundTrip );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 10000 ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchEchoTask( void *pvParameters )
+{
+size_t xReceived;
+size_t i, j;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		for( i = 0; i < benchNUM_ITEM_SIZES; i++ )
+		{
+			for( j = 0; j < benchNUM_MESSAGES; j++ )
+			{
+				xIntertileQueueReceive( xItemQueues[ i ], ulMessage, portMAX_DELAY );
+			}
+			prvSendAck();
+
+			for( j = 0; j < benchNUM_ROUND_TRIPS; j++ )
+			{
+				xIntertileQueueReceive( xItemQueues[ i ], ulMessage, portMAX_DELAY );
+				prvSendAck();
+			}
+		}
+
+		for( i = 0; i < benchNUM_BULK_SIZES; i++ )
+		{
+			for( j = 0; j < benchNUM_MESSAGES; j++ )
+			{
+				xReceived = xIntertileBulkReceive( xBulkQueue, ulMessage, sizeof( ulMessage ), portMAX_DELAY );
+				configASSERT( xReceived == uxBulkSizes[ i ] );
+			}
+			prvSendAck();
+
+			for( j = 0; j < benchNUM_ROUND_TRIPS; j++ )
+			{
+				xReceived = xIntertileBulkReceive( xBulkQueue, ulMessage, sizeof( ulMessage ), portMAX_DELAY );
+				configASSERT( xReceived == uxBulkSizes[ i ] );
+				prvSendAck();
+			}
+		}
+	}
+}
@@ -0,0 +1,12 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+
+#ifndef INTERTILE_BENCH_H_
+#define INTERTILE_BENCH_H_
+
+/*
+ * Creates the benchmark queues and task on this tile. Must be called on both
+ * tiles before the scheduler is started.
+ */
+void vStartIntertileBenchmark( int tile, chanend_t xOtherTileChan, UBaseType_t uxPriority );
+
+#endif /* INTERTILE_BENCH_H_ */
@@ -1,14 +1,49 @@
 // Copyright (c) 2020, XMOS Ltd, All rights reserved
 
+/*
+ * LED commands are recorded in per-core state owned by the calling core and
+ * the caller returns straight away. The only work done with interrupts
+ * masked is one word read and one word store, which keeps tasks on the same
+ * core from interleaving. Nothing is shared with other cores on the write
+ * side, so no cross-core lock or channel transaction is held by the caller.
+ *
+ * Each core keeps one word per LED that only it writes, so a command is
+ * never dropped however far the reader falls behind: the word always holds
+ * everything the reader needs to apply all the commands since it last
+ * looked. A service task on each tile reads every core's words, folding the
+ * changes into a single set/clear/toggle batch. On tile 0 the batch is
+ * applied to the LED bitmap with one port write. On the other tile it is
+ * sent to tile 0 as one channel transaction.
+ */
+
 /* Scheduler include files. */
 #include "FreeRTOS.h"
+#include "task.h"
 #include "portable.h"
 #include <xcore/chanend.h>
 #include <xcore/triggerable.h>
+#include <xcore/hwtimer.h>
 
 /* Demo application include files. */
 #include "partest.h"
 
+/* One bit of led_bitmap per LED. */
+#define partestLED_COUNT				16
+
+#ifndef partestSERVICE_TASK_PRIORITY
+#define partestSERVICE_TASK_PRIORITY	( tskIDLE_PRIORITY + 1 )
+#endif
+
+#ifndef partestSERVICE_PERIOD
+#define partestSERVICE_PERIOD			pdMS_TO_TICKS( 10 )
+#endif
+
+/* Set to 1 to record the longest time, in reference clock ticks, that
+vParTestSetLED() keeps interrupts masked. */
+#ifndef partestTRACE_MASKED_TIME
+#define partestTRACE_MASKED_TIME		0
+#endif
+
 void led_driver(uint16_t led_value);
 
 static chanend_t c_write;
@@ -22,44 +57,156 @@ typedef enum {
 	LED_TOGGLE
 } led_value_t;
 
-typedef union {
-	struct {
-		uint32_t tile : 8;
-		uint32_t led : 8;
-		led_value_t value : 8;
-		uint32_t reserved : 8;
-	};
-	uint32_t raw;
-} led_cmd_t;
+/*
+ * Any sequence of LED commands folds into one of these. It is applied as
+ * ( ( bitmap & ~clear ) | set ) ^ toggle.
+ */
+typedef struct {
+	uint16_t set;
+	uint16_t clear;
+	uint16_t toggle;
+} led_batch_t;
+
+/*
+ * The commands one core has posted to one LED. Only that core writes it,
+ * with a single store, so the service task always reads a consistent word.
+ *   bits 31..2  number of LED_ON and LED_OFF commands, modulo 2^30
+ *   bit 1       the value of the latest of them, XOR every toggle since
+ *   bit 0       the parity of every toggle
+ * If the count has moved since the service task last looked, the LED takes
+ * bit 1. Otherwise it is toggled if bit 0 has changed.
+ */
+#define partestSTATE_VALUE				( 1U << 1 )
+#define partestSTATE_TOGGLE				( 1U << 0 )
+#define partestSTATE_ASSIGN				( 1U << 2 )
+
+static volatile uint32_t led_state[ configNUMBER_OF_CORES ][ partestLED_COUNT ];
+
+#if ( partestTRACE_MASKED_TIME == 1 )
+	volatile uint32_t ulParTestMaxMaskedTicks;
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Called with the LED bitmap protected by a critical section. */
+static void prvBatchApply( const led_batch_t *pxBatch )
+{
+	uint16_t new_bitmap;
+
+	new_bitmap = ( ( led_bitmap & ~pxBatch->clear ) | pxBatch->set ) ^ pxBatch->toggle;
+
+	if( new_bitmap != led_bitmap )
+	{
+		led_bitmap = new_bitmap;
+		led_driver( led_bitmap );
+	}
+}
+/*-----------------------------------------------------------*/
 
 DEFINE_RTOS_INTERRUPT_CALLBACK( pxLEDUpdateISR, pvData )
 {
-	led_cmd_t xCmd;
-	uint16_t mask;
+	led_batch_t xBatch;
+	uint32_t ulWord;
+	UBaseType_t uxSavedInterruptStatus;
 
 	(void) pvData;
 
-	//debug_printf("led isr\n");
-	xCmd.raw = chanend_in_word( c_read );
+	ulWord = chanend_in_word( c_read );
+	xBatch.set = ulWord & 0xFFFF;
+	xBatch.clear = ulWord >> 16;
+	xBatch.toggle = chanend_in_word( c_read );
 	chanend_check_end_token( c_read );
 
-	//debug_printf("Received LED update from tile %x\n", xCmd.tile);
+	uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+	prvBatchApply( &xBatch );
+	taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+}
+/*-----------------------------------------------------------*/
 
-	mask = 1 << xCmd.led;
-	if (xCmd.value == LED_ON)
-	{
-		led_bitmap |= mask;
-	}
-	else if (xCmd.value == LED_OFF)
-	{
-		led_bitmap &= mask;
-	}
-	else if (xCmd.value == LED_TOGGLE)
+static void prvLEDServiceTask( void *pvParameters )
+{
+	/* The state words as this task last read them. */
+	static uint32_t seen[ configNUMBER_OF_CORES ][ partestLED_COUNT ];
+	TickType_t xLastWakeTime;
+	led_batch_t xBatch;
+	BaseType_t xPending;
+	uint32_t state;
+	uint16_t mask;
+	int core;
+	int led;
+
+	(void) pvParameters;
+
+	xLastWakeTime = xTaskGetTickCount();
+
+	for( ;; )
 	{
-		led_bitmap ^= mask;
-	}
+		vTaskDelayUntil( &xLastWakeTime, partestSERVICE_PERIOD );
+
+		xBatch.set = 0;
+		xBatch.clear = 0;
+		xBatch.toggle = 0;
+		xPending = pdFALSE;
+
+		/* Commands from different cores are unordered with respect to
+		each other, so the cores are simply taken one after another. */
+		for( core = 0; core < configNUMBER_OF_CORES; core++ )
+		{
+			for( led = 0; led < partestLED_COUNT; led++ )
+			{
+				state = led_state[ core ][ led ];
+				if( state == seen[ core ][ led ] )
+				{
+					continue;
+				}
+
+				mask = 1 << led;
+				if( ( state ^ seen[ core ][ led ] ) & ~( partestSTATE_VALUE | partestSTATE_TOGGLE ) )
+				{
+					/* Set or cleared since last time, then perhaps
+					toggled; bit 1 is where that leaves it. */
+					if( state & partestSTATE_VALUE )
+					{
+						xBatch.set |= mask;
+						xBatch.clear &= ~mask;
+					}
+					else
+					{
+						xBatch.clear |= mask;
+						xBatch.set &= ~mask;
+					}
+					xBatch.toggle &= ~mask;
+				}
+				else if( ( state ^ seen[ core ][ led ] ) & partestSTATE_TOGGLE )
+				{
+					xBatch.toggle ^= mask;
+				}
+
+				seen[ core ][ led ] = state;
+				xPending = pdTRUE;
+			}
+		}
 
-	led_driver( led_bitmap );
+		if( xPending == pdFALSE )
+		{
+			continue;
+		}
+
+		if( this_tile == 0 )
+		{
+			taskENTER_CRITICAL();
+			prvBatchApply( &xBatch );
+			taskEXIT_CRITICAL();
+		}
+		else
+		{
+			/* Only this task writes to c_write, so nothing needs to be
+			masked while the transaction is in progress. */
+			chanend_out_word( c_write, xBatch.set | ( ( uint32_t ) xBatch.clear << 16 ) );
+			chanend_out_word( c_write, xBatch.toggle );
+			chanend_out_end_token( c_write );
+		}
+	}
 }
 
 /* ParTest contains FreeRTOS standard parallel port IO routines. */
@@ -85,6 +232,8 @@ void vParTestInitialiseXCORE( int tile, chanend_t xTile0Chan, chanend_t xTile1Ch
 	}
 
 	chanend_set_dest(c_write, c_read);
+
+	xTaskCreate( prvLEDServiceTask, "LEDSvc", portTASK_STACK_DEPTH( prvLEDServiceTask ), NULL, partestSERVICE_TASK_PRIORITY, NULL );
 }
 
 /*-----------------------------------------------------------*/
@@ -92,18 +241,53 @@ void vParTestInitialiseXCORE( int tile, chanend_t xTile0Chan, chanend_t xTile1Ch
 void vParTestSetLED( UBaseType_t uxLED, BaseType_t xValue )
 {
 	uint32_t ulState;
+	volatile uint32_t *pulLED;
+	uint32_t state;
 
-	//debug_printf("tile %d sending led\n", this_tile);
+	if( uxLED >= partestLED_COUNT )
+	{
+		return;
+	}
 
-	led_cmd_t xCmd;
+	/* Masking interrupts keeps this task on its core and stops other
+	tasks on the same core from updating the word until this one is
+	done. */
+	ulState = portDISABLE_INTERRUPTS();
+	{
+		#if ( partestTRACE_MASKED_TIME == 1 )
+			uint32_t ulStart = get_reference_time();
+		#endif
 
-	xCmd.led = uxLED;
-	xCmd.value = xValue;
-	xCmd.tile = this_tile;
+		pulLED = &led_state[ portGET_CORE_ID() ][ uxLED ];
+		state = *pulLED;
 
-	ulState = portDISABLE_INTERRUPTS();
-	chanend_out_word( c_write, xCmd.raw );
-	chanend_out_end_token( c_write );
+		if( xValue == LED_TOGGLE )
+		{
+			state ^= partestSTATE_VALUE | partestSTATE_TOGGLE;
+		}
+		else
+		{
+			state += partestSTATE_ASSIGN;
+			state &= ~partestSTATE_VALUE;
+			if( xValue == LED_ON )
+			{
+				state |= partestSTATE_VALUE;
+			}
+		}
+
+		/* The single store that publishes the command. */
+		*pulLED = state;
+
+		#if ( partestTRACE_MASKED_TIME == 1 )
+		{
+			uint32_t ulElapsed = get_reference_time() - ulStart;
+			if( ulElapsed > ulParTestMaxMaskedTicks )
+			{
+				ulParTestMaxMaskedTicks = ulElapsed;
+			}
+		}
+		#endif
+	}
 	portRESTORE_INTERRUPTS(ulState);
 }
 
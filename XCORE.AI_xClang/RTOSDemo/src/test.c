@@ -37,6 +37,7 @@
 #include "TaskNotifyArray.h"
 #include "TimerDemo.h"
 #include "regtest.h"
+#include "intertile_bench.h"
 
 void vParTestInitialiseXCORE( int tile, chanend_t xTile0Chan, chanend_t xTile1Chan, chanend_t xTile2Chan, chanend_t xTile3Chan );
 #define vParTestInitialise vParTestInitialiseXCORE
@@ -377,6 +378,13 @@ int c_main( int tile, chanend_t xTile0Chan, chanend_t xTile1Chan, chanend_t xTil
 static void prvSetupHardware( int tile, chanend_t xTile0Chan, chanend_t xTile1Chan, chanend_t xTile2Chan, chanend_t xTile3Chan )
 {
 	vParTestInitialise( tile, xTile0Chan, xTile1Chan, xTile2Chan, xTile3Chan );
+
+	#if( ( testingmainENABLE_INTERTILE_BENCHMARK == 1 ) && ( testingmainNUM_TILES > 1 ) )
+	{
+		/* Shares the bootstrap channel with ParTest, so must follow it. */
+		vStartIntertileBenchmark( tile, ( tile == 0 ) ? xTile1Chan : xTile0Chan, mainINTERTILE_BENCHMARK_PRIORITY );
+	}
+	#endif
 }
 
 /*-----------------------------------------------------------*/
@@ -22,6 +22,10 @@
 /* Death cannot be run with any demo that creates or destroys tasks */
 #define testingmainENABLE_DEATH_TASKS					1
 
+/* Tile 0 sends to tile 1 and reports inter-tile queue throughput and latency.
+Requires testingmainNUM_TILES > 1. */
+#define testingmainENABLE_INTERTILE_BENCHMARK			0
+
 /*** These tests run on tile 0 ***/
 #define testingmainENABLE_ABORT_DELAY_TASKS				1
 #define testingmainENABLE_BLOCKING_QUEUE_TASKS			1
@@ -58,6 +62,7 @@
 
 /* Priorities assigned to demo application tasks. */
 #define mainCHECK_TASK_PRIORITY 			( configMAX_PRIORITIES - 1 )
+#define mainINTERTILE_BENCHMARK_PRIORITY	( configMAX_PRIORITIES - 2 )
 
 /*** These tests run on tile 0 ***/
 #define mainBLOCKING_Q_TASKS_PRIORITY 		( tskIDLE_PRIORITY + 2 )
@@ -129,6 +129,10 @@
 #define RTOS_INTERRUPT_CALLBACK(intrpt) _XCORE_INTERRUPT_CALLBACK(intrpt)
 
 
+#ifndef RTOS_SUPPORT_HOST
+/* The host build (see host/) provides its own versions of these
+   in its rtos_interrupt_impl.h. */
+
 /**
  * This function gets the current interrupt mask.
  * A non-zero mask value means that interrupts are enabled.
@@ -222,4 +226,6 @@ inline uint32_t rtos_isr_running(void)
     return kernel_mode;
 }
 
+#endif /* RTOS_SUPPORT_HOST */
+
 #endif /* RTOS_INTERRUPT_H_ */
@@ -26,17 +26,91 @@
 #error XCORE does not support more than 4 hardware locks
 #endif
 
+#ifndef RTOS_LOCKS_INSTRUMENT
+#define RTOS_LOCKS_INSTRUMENT 0
+#endif
+
+#if RTOS_LOCKS_INSTRUMENT
+#include <stdint.h>
+#include <xs1.h>
+#include <xcore/hwtimer.h>
+#include "rtos_cores.h"
+
+/**
+ * Per lock, per logical core statistics recorded when
+ * RTOS_LOCKS_INSTRUMENT is 1. All times are in reference
+ * clock ticks.
+ *
+ * Each entry is only written by the core it belongs to,
+ * so no locking is needed to update it.
+ */
+typedef struct {
+    uint32_t acquire_count;    /**< Outermost acquires. Recursive acquires are not counted. */
+    uint32_t recursive_count;  /**< Acquires of a lock already held by the calling core. */
+    uint64_t spin_ticks;       /**< Total time spent waiting for the hardware lock. */
+    uint32_t spin_ticks_max;   /**< Longest single wait for the hardware lock. */
+    uint32_t hold_ticks_max;   /**< Longest time from outermost acquire to final release. */
+} rtos_lock_stats_t;
+#endif
+
 void rtos_locks_initialize(void);
 
+#if RTOS_LOCKS_INSTRUMENT
+/**
+ * Copies the statistics for one lock as seen by one logical core.
+ *
+ * \param lock_id  The lock to query.
+ * \param core_id  The logical "xcore" core ID, as returned by get_logical_core_id().
+ * \param stats    Filled in with the statistics.
+ */
+void rtos_locks_stats_get(int lock_id, int core_id, rtos_lock_stats_t *stats);
+
+/**
+ * Clears the statistics for all locks and cores.
+ */
+void rtos_locks_stats_reset(void);
+
+/**
+ * Prints a table of the statistics for every lock and every
+ * logical core that has acquired it, using rtos_printf().
+ */
+void rtos_locks_stats_dump(void);
+#endif
+
 inline int rtos_lock_acquire(int lock_id)
 {
     extern lock_t rtos_locks[RTOS_LOCK_COUNT];
     extern int rtos_lock_counters[RTOS_LOCK_COUNT];
+#if RTOS_LOCKS_INSTRUMENT
+    extern rtos_lock_stats_t rtos_lock_stats[RTOS_LOCK_COUNT][RTOS_MAX_CORE_COUNT];
+    extern uint32_t rtos_lock_hold_start[RTOS_LOCK_COUNT];
+    rtos_lock_stats_t *stats;
+    uint32_t start;
+    uint32_t spin;
+#endif
 
     xassert(lock_id >= 0 && lock_id < RTOS_LOCK_COUNT);
     if (rtos_locks[lock_id] != -1) {
+#if RTOS_LOCKS_INSTRUMENT
+        start = get_reference_time();
+        lock_acquire(rtos_locks[lock_id]);
+        spin = get_reference_time() - start;
+
+        stats = &rtos_lock_stats[lock_id][get_logical_core_id()];
+        if (rtos_lock_counters[lock_id]++ == 0) {
+            rtos_lock_hold_start[lock_id] = start + spin;
+            stats->acquire_count++;
+            stats->spin_ticks += spin;
+            if (spin > stats->spin_ticks_max) {
+                stats->spin_ticks_max = spin;
+            }
+        } else {
+            stats->recursive_count++;
+        }
+#else
         lock_acquire(rtos_locks[lock_id]);
         rtos_lock_counters[lock_id]++;
+#endif
     }
 
     return rtos_lock_counters[lock_id];
@@ -54,6 +128,12 @@ inline int rtos_lock_release(int lock_id)
 {
     extern lock_t rtos_locks[RTOS_LOCK_COUNT];
     extern int rtos_lock_counters[RTOS_LOCK_COUNT];
+#if RTOS_LOCKS_INSTRUMENT
+    extern rtos_lock_stats_t rtos_lock_stats[RTOS_LOCK_COUNT][RTOS_MAX_CORE_COUNT];
+    extern uint32_t rtos_lock_hold_start[RTOS_LOCK_COUNT];
+    rtos_lock_stats_t *stats;
+    uint32_t hold;
+#endif
     int counter = 0;
 
     xassert(lock_id >= 0 && lock_id < RTOS_LOCK_COUNT);
@@ -64,6 +144,15 @@ inline int rtos_lock_release(int lock_id)
         #endif
         counter = --rtos_lock_counters[lock_id];
         if (counter == 0) {
+#if RTOS_LOCKS_INSTRUMENT
+            /* Measured while still holding the lock so that
+               rtos_lock_hold_start cannot be overwritten. */
+            hold = get_reference_time() - rtos_lock_hold_start[lock_id];
+            stats = &rtos_lock_stats[lock_id][get_logical_core_id()];
+            if (hold > stats->hold_ticks_max) {
+                stats->hold_ticks_max = hold;
+            }
+#endif
             lock_release(rtos_locks[lock_id]);
         }
     }
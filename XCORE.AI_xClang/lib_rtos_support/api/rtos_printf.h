@@ -87,6 +87,14 @@ extern "C" {
  */
 int rtos_snprintf(char *str, size_t size, const char *fmt, ...);
 
+/**
+ * Just like vsnprintf, but not all of the
+ * standard C format control are supported.
+ */
+#ifndef __XC__
+int rtos_vsnprintf(char *str, size_t size, const char *fmt, va_list ap);
+#endif
+
 /**
  * Just like sprintf, but not all of the
  * standard C format control are supported.
@@ -0,0 +1,411 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Exercises lib_rtos_support on the host simulation and reports:
+ *  - lock acquire/release cost and contention with every core competing
+ *    for the same lock,
+ *  - rtos_irq() post rate between RTOS cores and from a peripheral, and
+ *    how many interrupts those posts coalesce into,
+ *  - rtos_time consistency with one writer and several readers,
+ *  - rtos_snprintf() and rtos_printf() latency, and rtos_snprintf()
+ *    against the C library's snprintf() for each kind of conversion.
+ *
+ * Each phase also checks the result it measured, and the program exits
+ * non-zero if any check fails.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rtos_support.h"
+#include "xcore_host.h"
+
+/* Measured regardless of the debug print settings. */
+#undef rtos_printf
+
+#define BENCH_CORES          4
+#define BENCH_LOCK_ITERS     200000
+#define BENCH_IRQ_POSTS      100000
+#define BENCH_TIME_TICKS     100000
+#define BENCH_PRINTF_ITERS   20000
+#define BENCH_PERIPHERAL_CORE (XCORE_HOST_MAX_LOGICAL_CORES - 1)
+
+/* The lock not used by the IRQ system and rtos_time. */
+#define BENCH_LOCK 1
+
+static pthread_barrier_t barrier;
+static int failures;
+
+static uint32_t shared_counter;
+static atomic_uint intercore_irqs[RTOS_MAX_CORE_COUNT];
+static atomic_uint peripheral_irqs;
+static atomic_int peripheral_done;
+static int peripheral_source_id;
+static chanend_t peripheral_chanend;
+
+static uint64_t lock_ns;
+static uint64_t irq_ns;
+static atomic_uint time_errors;
+static uint64_t snprintf_ns;
+static uint64_t printf_ns;
+
+/*
+ * One conversion of each kind, with the argument type it takes:
+ * 'i' int, 'l' long long, 's' string and 'f' double.
+ */
+static const struct {
+    const char *fmt;
+    char type;
+} printf_formats[] = {
+    { "%d",      'i' },
+    { "%08x",    'i' },
+    { "%lld",    'l' },
+    { "%-12s",   's' },
+    { "%f",      'f' },
+    { "%.3f",    'f' },
+    { "%e",      'f' },
+    { "%g",      'f' },
+};
+
+#define PRINTF_FORMAT_COUNT (sizeof(printf_formats) / sizeof(printf_formats[0]))
+
+static uint64_t format_rtos_ns[PRINTF_FORMAT_COUNT];
+static uint64_t format_libc_ns[PRINTF_FORMAT_COUNT];
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+void xcore_host_intercore_isr(void)
+{
+    atomic_fetch_add(&intercore_irqs[rtos_core_id_get()], 1);
+}
+
+DEFINE_RTOS_INTERRUPT_CALLBACK(peripheral_isr, data)
+{
+    (void) data;
+    atomic_fetch_add(&peripheral_irqs, 1);
+}
+
+/*-----------------------------------------------------------*/
+
+static void bench_locks(int core_id)
+{
+    uint64_t start = 0;
+    int i;
+
+    pthread_barrier_wait(&barrier);
+    if (core_id == 0) {
+        start = now_ns();
+    }
+
+    for (i = 0; i < BENCH_LOCK_ITERS; i++) {
+        rtos_lock_acquire(BENCH_LOCK);
+        shared_counter++;
+        rtos_lock_release(BENCH_LOCK);
+    }
+
+    pthread_barrier_wait(&barrier);
+    if (core_id == 0) {
+        lock_ns = now_ns() - start;
+    }
+}
+
+static void bench_irq(int core_id)
+{
+    uint64_t start = 0;
+    int target = (core_id + 1) % BENCH_CORES;
+    int i;
+
+    pthread_barrier_wait(&barrier);
+    if (core_id == 0) {
+        start = now_ns();
+    }
+
+    for (i = 0; i < BENCH_IRQ_POSTS; i++) {
+        rtos_irq(target, core_id);
+    }
+
+    pthread_barrier_wait(&barrier);
+    if (core_id == 0) {
+        irq_ns = now_ns() - start;
+    }
+}
+
+static void bench_time(int core_id)
+{
+    rtos_time_t t;
+    rtos_time_t last = {0, 0};
+    int i;
+
+    pthread_barrier_wait(&barrier);
+
+    if (core_id == 0) {
+        for (i = 0; i < BENCH_TIME_TICKS; i++) {
+            rtos_time_increment(RTOS_TICK_PERIOD_1000_HZ);
+        }
+    } else {
+        for (i = 0; i < BENCH_TIME_TICKS; i++) {
+            t = rtos_time_get();
+            if (t.microseconds >= 1000000 ||
+                t.seconds < last.seconds ||
+                (t.seconds == last.seconds && t.microseconds < last.microseconds)) {
+                atomic_fetch_add(&time_errors, 1);
+            }
+            last = t;
+        }
+    }
+
+    pthread_barrier_wait(&barrier);
+}
+
+/*
+ * Times one of printf_formats with rtos_snprintf(), or with snprintf(),
+ * and checks the last result of the former against the latter.
+ */
+static uint64_t bench_format(int f, int rtos)
+{
+    static char rtos_buf[64];
+    char buf[64];
+    const char *fmt = printf_formats[f].fmt;
+    uint64_t start;
+    int i;
+
+#define BENCH_FORMAT(...) do {                                              \
+        if (rtos) {                                                         \
+            for (i = 0; i < BENCH_PRINTF_ITERS; i++) {                      \
+                rtos_snprintf(buf, sizeof(buf), fmt, __VA_ARGS__);          \
+            }                                                               \
+        } else {                                                            \
+            for (i = 0; i < BENCH_PRINTF_ITERS; i++) {                      \
+                snprintf(buf, sizeof(buf), fmt, __VA_ARGS__);               \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+    start = now_ns();
+    switch (printf_formats[f].type) {
+    case 'i':
+        BENCH_FORMAT(-123456789 + i);
+        break;
+    case 'l':
+        BENCH_FORMAT(-123456789012LL + i);
+        break;
+    case 's':
+        BENCH_FORMAT("lib_rtos");
+        break;
+    default:
+        BENCH_FORMAT(3.14159265358979 * (i + 1));
+        break;
+    }
+    start = now_ns() - start;
+
+#undef BENCH_FORMAT
+
+    if (rtos) {
+        strcpy(rtos_buf, buf);
+    } else {
+        check(strcmp(rtos_buf, buf) == 0, "rtos_snprintf differs from snprintf");
+    }
+
+    return start;
+}
+
+static void bench_printf(int core_id)
+{
+    char buf[128];
+    uint64_t start;
+    int i;
+
+    pthread_barrier_wait(&barrier);
+
+    if (core_id == 0) {
+        start = now_ns();
+        for (i = 0; i < BENCH_PRINTF_ITERS; i++) {
+            rtos_snprintf(buf, sizeof(buf), "core %d tick %u value %08x %s %lld\n",
+                          core_id, (unsigned) i, 0xC0FFEEu, "ok", -123456789012LL);
+        }
+        snprintf_ns = now_ns() - start;
+
+        start = now_ns();
+        for (i = 0; i < BENCH_PRINTF_ITERS; i++) {
+            rtos_printf("core %d tick %u value %08x %s %lld\n",
+                        core_id, (unsigned) i, 0xC0FFEEu, "ok", -123456789012LL);
+        }
+        printf_ns = now_ns() - start;
+
+        for (i = 0; i < (int) PRINTF_FORMAT_COUNT; i++) {
+            format_rtos_ns[i] = bench_format(i, 1);
+            format_libc_ns[i] = bench_format(i, 0);
+        }
+    }
+
+    pthread_barrier_wait(&barrier);
+}
+
+/*-----------------------------------------------------------*/
+
+static void rtos_core(void *arg)
+{
+    int core_id;
+
+    (void) arg;
+
+    core_id = rtos_core_register();
+    rtos_irq_enable(BENCH_CORES);
+    while (!rtos_irq_ready()) {
+        sched_yield();
+    }
+
+    bench_locks(core_id);
+    bench_irq(core_id);
+    bench_time(core_id);
+    bench_printf(core_id);
+}
+
+static void peripheral_core(void *arg)
+{
+    int i;
+
+    (void) arg;
+
+    for (i = 0; i < BENCH_IRQ_POSTS; i++) {
+        rtos_irq(0, peripheral_source_id);
+    }
+
+    atomic_store(&peripheral_done, 1);
+}
+
+static void peripheral_alloc(void *arg)
+{
+    (void) arg;
+
+    /* Allocated from the peripheral's logical core so that it
+       owns the channel end it sends from. */
+    peripheral_chanend = chanend_alloc();
+}
+
+/*-----------------------------------------------------------*/
+
+static int wait_quiet(void)
+{
+    uint64_t deadline = now_ns() + 1000000000u;
+    int pending;
+    int i;
+
+    do {
+        pending = 0;
+        for (i = 0; i < BENCH_CORES; i++) {
+            pending += xcore_host_tokens_pending(i);
+        }
+        if (pending == 0) {
+            return 1;
+        }
+        sched_yield();
+    } while (now_ns() < deadline);
+
+    return 0;
+}
+
+int main(void)
+{
+    rtos_time_t t;
+    rtos_lock_stats_t stats;
+    unsigned irqs = 0;
+    int devnull;
+    int i;
+
+    rtos_locks_initialize();
+
+    xcore_host_core_start(BENCH_PERIPHERAL_CORE, peripheral_alloc, NULL);
+    xcore_host_core_join_all();
+    peripheral_source_id = rtos_irq_register(RTOS_INTERRUPT_CALLBACK(peripheral_isr), NULL, peripheral_chanend);
+
+    devnull = open("/dev/null", O_WRONLY);
+    xcore_host_stdout_fd = devnull;
+
+    pthread_barrier_init(&barrier, NULL, BENCH_CORES);
+    for (i = 0; i < BENCH_CORES; i++) {
+        xcore_host_core_start(i, rtos_core, NULL);
+    }
+    xcore_host_core_join_all();
+    pthread_barrier_destroy(&barrier);
+
+    /* The interrupt threads outlive the RTOS cores, so the
+       peripheral can still interrupt core 0. */
+    xcore_host_core_start(BENCH_PERIPHERAL_CORE, peripheral_core, NULL);
+    xcore_host_core_join_all();
+
+    check(wait_quiet(), "IRQ tokens still pending after posting stopped");
+    xcore_host_shutdown();
+    xcore_host_stdout_fd = 1;
+    close(devnull);
+
+    check(shared_counter == (uint32_t) BENCH_CORES * BENCH_LOCK_ITERS, "lock lost updates");
+    printf("locks:   %d cores x %d acquires, %.1f ns per acquire/release\n",
+           BENCH_CORES, BENCH_LOCK_ITERS,
+           (double) lock_ns / BENCH_LOCK_ITERS);
+
+#if RTOS_LOCKS_INSTRUMENT
+    for (i = 0; i < BENCH_CORES; i++) {
+        rtos_locks_stats_get(BENCH_LOCK, i, &stats);
+        check(stats.acquire_count == BENCH_LOCK_ITERS, "lock statistics acquire count");
+    }
+    rtos_locks_stats_dump();
+#else
+    (void) stats;
+#endif
+
+    for (i = 0; i < BENCH_CORES; i++) {
+        check(atomic_load(&intercore_irqs[i]) > 0, "RTOS core received no IRQs");
+        irqs += atomic_load(&intercore_irqs[i]);
+    }
+    check(irqs <= (unsigned) BENCH_CORES * BENCH_IRQ_POSTS, "more IRQs taken than posted");
+    printf("irq:     %d posts/s per core, %u of %d posts taken as interrupts\n",
+           (int) ((uint64_t) BENCH_IRQ_POSTS * 1000000000u / irq_ns),
+           irqs, BENCH_CORES * BENCH_IRQ_POSTS);
+
+    check(atomic_load(&peripheral_done) && atomic_load(&peripheral_irqs) > 0,
+          "peripheral IRQs not received");
+    printf("periph:  %u of %d posts taken as interrupts\n",
+           atomic_load(&peripheral_irqs), BENCH_IRQ_POSTS);
+
+    t = rtos_time_get();
+    check(t.seconds == BENCH_TIME_TICKS / 1000 && t.microseconds == 0, "rtos_time final value");
+    check(atomic_load(&time_errors) == 0, "rtos_time went backwards or was torn");
+    printf("time:    %llu.%06u s after %d ticks, %u read errors\n",
+           (unsigned long long) t.seconds, (unsigned) t.microseconds,
+           BENCH_TIME_TICKS, atomic_load(&time_errors));
+
+    printf("printf:  rtos_snprintf %.1f ns, rtos_printf %.1f ns per call\n",
+           (double) snprintf_ns / BENCH_PRINTF_ITERS,
+           (double) printf_ns / BENCH_PRINTF_ITERS);
+    for (i = 0; i < (int) PRINTF_FORMAT_COUNT; i++) {
+        printf("         %-6s rtos_snprintf %6.1f ns, snprintf %6.1f ns per call\n",
+               printf_formats[i].fmt,
+               (double) format_rtos_ns[i] / BENCH_PRINTF_ITERS,
+               (double) format_libc_ns[i] / BENCH_PRINTF_ITERS);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+
+    return failures != 0;
+}
@@ -0,0 +1,55 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Host replacement for src/rtos_interrupt_impl.h. It is found first
+ * because host/include precedes src in the include path.
+ *
+ * Interrupt callbacks are ordinary functions taking the data pointer,
+ * and the interrupt mask is emulated per logical core by xcore_host.c.
+ */
+
+#ifndef RTOS_INTERRUPT_IMPL_H_
+#define RTOS_INTERRUPT_IMPL_H_
+
+#include "rtos_support_rtos_config.h"
+#include <xcore/interrupt_wrappers.h>
+#include "xcore_host.h"
+
+#define _DEFINE_RTOS_KERNEL_ENTRY(ret, root_function, ...) \
+    _XCORE_DECLARE_INTERRUPT_PERMITTED(ret, root_function, __VA_ARGS__)
+
+#define _DECLARE_RTOS_INTERRUPT_CALLBACK(intrpt, data) \
+    void intrpt(void *data)
+
+#define _DEFINE_RTOS_INTERRUPT_CALLBACK(intrpt, data) \
+    _DECLARE_RTOS_INTERRUPT_CALLBACK(intrpt, data)
+
+inline uint32_t rtos_interrupt_mask_get(void)
+{
+    return xcore_host_interrupt_mask_get();
+}
+
+inline uint32_t rtos_interrupt_mask_all(void)
+{
+    return xcore_host_interrupt_mask_all();
+}
+
+inline void rtos_interrupt_unmask_all(void)
+{
+    xcore_host_interrupt_unmask_all();
+}
+
+inline void rtos_interrupt_mask_set(uint32_t mask)
+{
+   if (mask != 0) {
+       rtos_interrupt_unmask_all();
+   }
+}
+
+inline uint32_t rtos_isr_running(void)
+{
+    return xcore_host_isr_running();
+}
+
+#endif /* RTOS_INTERRUPT_IMPL_H_ */
@@ -0,0 +1,29 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef RTOS_SUPPORT_RTOS_CONFIG_H_
+#define RTOS_SUPPORT_RTOS_CONFIG_H_
+
+/*
+ * RTOS configuration for the host simulation. Plays the part of the
+ * file normally provided by the RTOS port.
+ */
+
+#define RTOS_SUPPORT_HOST 1
+
+#ifndef RTOS_LOCK_COUNT
+#define RTOS_LOCK_COUNT 2
+#endif
+
+/* Not used on the host, but must be defined. */
+#define RTOS_SUPPORT_INTERRUPT_STACK_GROWTH 0
+
+/*
+ * Called from the IRQ handler when another RTOS core has sent an IRQ.
+ * The port would enter its scheduler here; the host calls a hook
+ * supplied by the program under test.
+ */
+void xcore_host_intercore_isr(void);
+#define RTOS_INTERCORE_INTERRUPT_ISR() xcore_host_intercore_isr()
+
+#endif /* RTOS_SUPPORT_RTOS_CONFIG_H_ */
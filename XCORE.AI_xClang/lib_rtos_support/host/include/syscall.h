@@ -0,0 +1,14 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef SYSCALL_H_
+#define SYSCALL_H_
+
+#include <stddef.h>
+
+#define FD_STDOUT 1
+
+/* Writes to xcore_host_stdout_fd. */
+int _write(int fd, const char *buf, size_t len);
+
+#endif /* SYSCALL_H_ */
@@ -0,0 +1,22 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XCORE_CHANEND_H_
+#define XCORE_CHANEND_H_
+
+#include "xcore_host.h"
+
+typedef resource_t chanend_t;
+
+/* The channel end is owned by the logical core that allocates it. */
+chanend_t chanend_alloc(void);
+void chanend_free(chanend_t c);
+void chanend_set_dest(chanend_t c, chanend_t dst);
+
+/* Adds a token to the destination and rings its owner's doorbell. */
+void chanend_out_end_token(chanend_t c);
+
+/* Blocks until a token has arrived and consumes it. */
+void chanend_check_end_token(chanend_t c);
+
+#endif /* XCORE_CHANEND_H_ */
@@ -0,0 +1,12 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XCORE_HWTIMER_H_
+#define XCORE_HWTIMER_H_
+
+#include <stdint.h>
+
+/* The 100MHz reference clock, derived from CLOCK_MONOTONIC. */
+uint32_t get_reference_time(void);
+
+#endif /* XCORE_HWTIMER_H_ */
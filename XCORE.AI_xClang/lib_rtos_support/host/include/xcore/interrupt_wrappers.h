@@ -0,0 +1,18 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XCORE_INTERRUPT_WRAPPERS_H_
+#define XCORE_INTERRUPT_WRAPPERS_H_
+
+/*
+ * On the host an interrupt callback is the handler itself, which is
+ * passed the data pointer given when it was set up.
+ */
+typedef void (*interrupt_callback_t)(void *data);
+
+#define _XCORE_INTERRUPT_CALLBACK(intrpt) intrpt
+#define _XCORE_INTERRUPT_PERMITTED(root_function) root_function
+#define _XCORE_DECLARE_INTERRUPT_PERMITTED(ret, root_function, ...) \
+    ret root_function(__VA_ARGS__)
+
+#endif /* XCORE_INTERRUPT_WRAPPERS_H_ */
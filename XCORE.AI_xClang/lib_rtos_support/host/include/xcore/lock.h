@@ -0,0 +1,19 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XCORE_LOCK_H_
+#define XCORE_LOCK_H_
+
+#include "xcore_host.h"
+
+typedef resource_t lock_t;
+
+/* Returns 0 when no more locks are available. */
+lock_t lock_alloc(void);
+void lock_free(lock_t l);
+
+/* Spins until the lock is free or already owned by the calling thread. */
+void lock_acquire(lock_t l);
+void lock_release(lock_t l);
+
+#endif /* XCORE_LOCK_H_ */
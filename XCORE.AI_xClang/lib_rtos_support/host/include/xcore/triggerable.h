@@ -0,0 +1,15 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XCORE_TRIGGERABLE_H_
+#define XCORE_TRIGGERABLE_H_
+
+#include "xcore_host.h"
+#include "interrupt_wrappers.h"
+
+/* Only channel ends may be triggerables on the host. */
+void triggerable_setup_interrupt_callback(resource_t res, void *data, interrupt_callback_t intrpt);
+void triggerable_enable_trigger(resource_t res);
+void triggerable_disable_trigger(resource_t res);
+
+#endif /* XCORE_TRIGGERABLE_H_ */
@@ -0,0 +1,80 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XCORE_HOST_H_
+#define XCORE_HOST_H_
+
+/*
+ * Host simulation of the xcore resources used by lib_rtos_support.
+ *
+ * Logical cores are pthreads. Hardware locks are spin locks that the
+ * owning thread may re-acquire, as an xcore thread may re-acquire a lock
+ * it already holds. Channel ends only carry end tokens, which is all the
+ * RTOS IRQ system sends.
+ *
+ * Each logical core that enables a trigger on one of its channel ends
+ * gets a companion interrupt thread. It sleeps on a condition variable
+ * (the core's "doorbell") that is signalled when a token arrives, and
+ * runs the registered callback with the same logical core ID as the core
+ * it belongs to. Callbacks are serialised with the owning core's masked
+ * sections, but unlike hardware they may otherwise run concurrently with
+ * it, so this is a somewhat harsher environment than the real one.
+ */
+
+#include <stdint.h>
+
+#define XCORE_HOST_MAX_LOGICAL_CORES 8
+#define XCORE_HOST_MAX_CHANENDS      32
+#define XCORE_HOST_MAX_LOCKS         4
+
+typedef uint32_t resource_t;
+
+/**
+ * Starts a thread that runs \p entry as logical core \p logical_core_id.
+ * The calling thread is logical core 0 unless it is itself started by
+ * this function.
+ */
+void xcore_host_core_start(int logical_core_id, void (*entry)(void *), void *arg);
+
+/**
+ * Waits for every thread started by xcore_host_core_start() to return.
+ */
+void xcore_host_core_join_all(void);
+
+/**
+ * Stops and joins the interrupt threads. The library keeps its own
+ * static state, so the simulation cannot be restarted afterwards.
+ */
+void xcore_host_shutdown(void);
+
+/**
+ * Returns the number of tokens sent to channel ends owned by
+ * \p logical_core_id that have not yet been consumed.
+ */
+int xcore_host_tokens_pending(int logical_core_id);
+
+/**
+ * Stops the reference clock at \p start. From then on get_reference_time()
+ * only moves when xcore_host_reference_time_advance() is called, so that
+ * tests can check times exactly.
+ */
+void xcore_host_reference_time_manual(uint32_t start);
+
+/**
+ * Moves the stopped reference clock on by \p ticks.
+ */
+void xcore_host_reference_time_advance(uint32_t ticks);
+
+/**
+ * File descriptor that _write() sends FD_STDOUT output to.
+ * Defaults to 1.
+ */
+extern int xcore_host_stdout_fd;
+
+/* Used by the host rtos_interrupt_impl.h */
+uint32_t xcore_host_interrupt_mask_get(void);
+uint32_t xcore_host_interrupt_mask_all(void);
+void xcore_host_interrupt_unmask_all(void);
+uint32_t xcore_host_isr_running(void);
+
+#endif /* XCORE_HOST_H_ */
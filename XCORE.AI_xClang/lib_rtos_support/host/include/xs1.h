@@ -0,0 +1,14 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef XS1_H_
+#define XS1_H_
+
+/* The subset of xs1.h used by lib_rtos_support, for the host simulation. */
+
+#define XS1_SR_IEBLE_MASK 0x2
+#define XS1_SR_INK_MASK   0x4
+
+unsigned get_logical_core_id(void);
+
+#endif /* XS1_H_ */
@@ -0,0 +1,482 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <syscall.h>
+#include <xs1.h>
+#include <xcore/assert.h>
+#include <xcore/chanend.h>
+#include <xcore/hwtimer.h>
+#include <xcore/lock.h>
+#include <xcore/triggerable.h>
+
+#include "xcore_host.h"
+
+/* Spins this many times before yielding, so that an oversubscribed
+   host still makes progress. */
+#define LOCK_SPINS_BEFORE_YIELD 100
+
+typedef struct {
+    int allocated;
+    int owner;              /* logical core that allocated it */
+    int dest;               /* index of the destination, or -1 */
+    unsigned tokens;        /* tokens received and not yet consumed */
+    int trigger_enabled;
+    interrupt_callback_t callback;
+    void *data;
+} host_chanend_t;
+
+typedef struct {
+    /* Held by the core while it has interrupts masked and by its
+       interrupt thread while a callback runs. */
+    pthread_mutex_t cpu;
+    pthread_cond_t doorbell;
+    pthread_t isr_thread;
+    int isr_started;
+} host_core_t;
+
+typedef struct {
+    int logical_core_id;
+    void (*entry)(void *);
+    void *arg;
+} core_start_t;
+
+int xcore_host_stdout_fd = 1;
+
+static host_core_t cores[XCORE_HOST_MAX_LOGICAL_CORES];
+static host_chanend_t chanends[XCORE_HOST_MAX_CHANENDS];
+static atomic_int lock_owner[XCORE_HOST_MAX_LOCKS];
+static int lock_allocated[XCORE_HOST_MAX_LOCKS];
+
+/* Protects the channel end table and the core bookkeeping. */
+static pthread_mutex_t chan_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Broadcast whenever a token arrives, for chanend_check_end_token(). */
+static pthread_cond_t token_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t core_threads[XCORE_HOST_MAX_LOGICAL_CORES];
+static int core_thread_count;
+static int stopping;
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static atomic_int next_thread_token = 1;
+
+static __thread int this_logical_core;
+static __thread int this_interrupts_enabled = 1;
+static __thread int this_in_isr;
+static __thread int this_thread_token;
+
+static void host_init(void)
+{
+    int i;
+
+    for (i = 0; i < XCORE_HOST_MAX_LOGICAL_CORES; i++) {
+        pthread_mutex_init(&cores[i].cpu, NULL);
+        pthread_cond_init(&cores[i].doorbell, NULL);
+    }
+}
+
+static int thread_token(void)
+{
+    if (this_thread_token == 0) {
+        this_thread_token = atomic_fetch_add(&next_thread_token, 1);
+    }
+    return this_thread_token;
+}
+
+/*-----------------------------------------------------------*/
+/* Cores                                                     */
+
+unsigned get_logical_core_id(void)
+{
+    return this_logical_core;
+}
+
+static void *core_thread(void *param)
+{
+    core_start_t start = *(core_start_t *) param;
+
+    free(param);
+    this_logical_core = start.logical_core_id;
+    start.entry(start.arg);
+
+    /* Leave the core with interrupts enabled so its interrupt
+       thread is not locked out. */
+    xcore_host_interrupt_unmask_all();
+
+    return NULL;
+}
+
+void xcore_host_core_start(int logical_core_id, void (*entry)(void *), void *arg)
+{
+    core_start_t *start;
+
+    xassert(logical_core_id >= 0 && logical_core_id < XCORE_HOST_MAX_LOGICAL_CORES);
+    xassert(core_thread_count < XCORE_HOST_MAX_LOGICAL_CORES);
+    pthread_once(&init_once, host_init);
+
+    start = malloc(sizeof(*start));
+    xassert(start != NULL);
+    start->logical_core_id = logical_core_id;
+    start->entry = entry;
+    start->arg = arg;
+
+    pthread_create(&core_threads[core_thread_count++], NULL, core_thread, start);
+}
+
+void xcore_host_core_join_all(void)
+{
+    int i;
+
+    for (i = 0; i < core_thread_count; i++) {
+        pthread_join(core_threads[i], NULL);
+    }
+    core_thread_count = 0;
+}
+
+/*-----------------------------------------------------------*/
+/* Interrupt masking                                         */
+
+uint32_t xcore_host_interrupt_mask_get(void)
+{
+    return this_interrupts_enabled ? XS1_SR_IEBLE_MASK : 0;
+}
+
+uint32_t xcore_host_interrupt_mask_all(void)
+{
+    pthread_once(&init_once, host_init);
+
+    if (!this_interrupts_enabled) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&cores[this_logical_core].cpu);
+    this_interrupts_enabled = 0;
+
+    return XS1_SR_IEBLE_MASK;
+}
+
+void xcore_host_interrupt_unmask_all(void)
+{
+    /* Interrupt threads always run masked. */
+    if (this_interrupts_enabled || this_in_isr) {
+        return;
+    }
+
+    this_interrupts_enabled = 1;
+    pthread_mutex_unlock(&cores[this_logical_core].cpu);
+}
+
+uint32_t xcore_host_isr_running(void)
+{
+    return this_in_isr ? XS1_SR_INK_MASK : 0;
+}
+
+/*-----------------------------------------------------------*/
+/* Reference clock                                           */
+
+static atomic_int manual_time_enabled;
+static atomic_uint manual_time;
+
+void xcore_host_reference_time_manual(uint32_t start)
+{
+    atomic_store(&manual_time, start);
+    atomic_store(&manual_time_enabled, 1);
+}
+
+void xcore_host_reference_time_advance(uint32_t ticks)
+{
+    atomic_fetch_add(&manual_time, ticks);
+}
+
+uint32_t get_reference_time(void)
+{
+    struct timespec ts;
+
+    if (atomic_load(&manual_time_enabled)) {
+        return atomic_load(&manual_time);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t) ((uint64_t) ts.tv_sec * 100000000u + (uint64_t) ts.tv_nsec / 10);
+}
+
+/*-----------------------------------------------------------*/
+/* Locks                                                     */
+
+lock_t lock_alloc(void)
+{
+    lock_t l = 0;
+    int i;
+
+    pthread_mutex_lock(&chan_mutex);
+    for (i = 0; i < XCORE_HOST_MAX_LOCKS; i++) {
+        if (!lock_allocated[i]) {
+            lock_allocated[i] = 1;
+            atomic_store(&lock_owner[i], 0);
+            l = i + 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&chan_mutex);
+
+    return l;
+}
+
+void lock_free(lock_t l)
+{
+    xassert(l >= 1 && l <= XCORE_HOST_MAX_LOCKS);
+
+    pthread_mutex_lock(&chan_mutex);
+    lock_allocated[l - 1] = 0;
+    pthread_mutex_unlock(&chan_mutex);
+}
+
+void lock_acquire(lock_t l)
+{
+    int me = thread_token();
+    int expected;
+    int spins = 0;
+
+    xassert(l >= 1 && l <= XCORE_HOST_MAX_LOCKS);
+
+    if (atomic_load_explicit(&lock_owner[l - 1], memory_order_relaxed) == me) {
+        return;
+    }
+
+    for (;;) {
+        expected = 0;
+        if (atomic_compare_exchange_weak_explicit(&lock_owner[l - 1], &expected, me,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            return;
+        }
+        if (++spins == LOCK_SPINS_BEFORE_YIELD) {
+            spins = 0;
+            sched_yield();
+        }
+    }
+}
+
+void lock_release(lock_t l)
+{
+    xassert(l >= 1 && l <= XCORE_HOST_MAX_LOCKS);
+    xassert(atomic_load_explicit(&lock_owner[l - 1], memory_order_relaxed) == thread_token());
+
+    atomic_store_explicit(&lock_owner[l - 1], 0, memory_order_release);
+}
+
+/*-----------------------------------------------------------*/
+/* Channel ends                                              */
+
+static host_chanend_t *chanend_get(resource_t c)
+{
+    xassert(c >= 1 && c <= XCORE_HOST_MAX_CHANENDS);
+    xassert(chanends[c - 1].allocated);
+
+    return &chanends[c - 1];
+}
+
+chanend_t chanend_alloc(void)
+{
+    chanend_t c = 0;
+    int i;
+
+    pthread_once(&init_once, host_init);
+
+    pthread_mutex_lock(&chan_mutex);
+    for (i = 0; i < XCORE_HOST_MAX_CHANENDS; i++) {
+        if (!chanends[i].allocated) {
+            memset(&chanends[i], 0, sizeof(chanends[i]));
+            chanends[i].allocated = 1;
+            chanends[i].owner = this_logical_core;
+            chanends[i].dest = -1;
+            c = i + 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&chan_mutex);
+
+    return c;
+}
+
+void chanend_free(chanend_t c)
+{
+    pthread_mutex_lock(&chan_mutex);
+    chanend_get(c)->allocated = 0;
+    pthread_mutex_unlock(&chan_mutex);
+}
+
+void chanend_set_dest(chanend_t c, chanend_t dst)
+{
+    pthread_mutex_lock(&chan_mutex);
+    chanend_get(dst);
+    chanend_get(c)->dest = dst - 1;
+    pthread_mutex_unlock(&chan_mutex);
+}
+
+void chanend_out_end_token(chanend_t c)
+{
+    host_chanend_t *dst;
+
+    pthread_mutex_lock(&chan_mutex);
+    xassert(chanend_get(c)->dest >= 0);
+    dst = &chanends[chanend_get(c)->dest];
+    dst->tokens++;
+    pthread_cond_signal(&cores[dst->owner].doorbell);
+    pthread_cond_broadcast(&token_cond);
+    pthread_mutex_unlock(&chan_mutex);
+}
+
+void chanend_check_end_token(chanend_t c)
+{
+    host_chanend_t *ch;
+
+    pthread_mutex_lock(&chan_mutex);
+    ch = chanend_get(c);
+    while (ch->tokens == 0) {
+        pthread_cond_wait(&token_cond, &chan_mutex);
+    }
+    ch->tokens--;
+    pthread_mutex_unlock(&chan_mutex);
+}
+
+int xcore_host_tokens_pending(int logical_core_id)
+{
+    int pending = 0;
+    int i;
+
+    pthread_mutex_lock(&chan_mutex);
+    for (i = 0; i < XCORE_HOST_MAX_CHANENDS; i++) {
+        if (chanends[i].allocated && chanends[i].owner == logical_core_id) {
+            pending += chanends[i].tokens;
+        }
+    }
+    pthread_mutex_unlock(&chan_mutex);
+
+    return pending;
+}
+
+/*-----------------------------------------------------------*/
+/* Interrupts                                                */
+
+/* Called with chan_mutex held. */
+static host_chanend_t *find_triggered(int core)
+{
+    int i;
+
+    for (i = 0; i < XCORE_HOST_MAX_CHANENDS; i++) {
+        if (chanends[i].allocated && chanends[i].owner == core &&
+            chanends[i].trigger_enabled && chanends[i].tokens != 0) {
+            return &chanends[i];
+        }
+    }
+    return NULL;
+}
+
+static void *isr_thread(void *param)
+{
+    int core = (int) (intptr_t) param;
+    host_chanend_t *ch;
+    interrupt_callback_t callback;
+    void *data;
+
+    this_logical_core = core;
+    this_interrupts_enabled = 0;
+    this_in_isr = 1;
+
+    pthread_mutex_lock(&chan_mutex);
+    while (!stopping) {
+        ch = find_triggered(core);
+        if (ch == NULL) {
+            pthread_cond_wait(&cores[core].doorbell, &chan_mutex);
+            continue;
+        }
+        callback = ch->callback;
+        data = ch->data;
+        pthread_mutex_unlock(&chan_mutex);
+
+        /* The callback must consume the token, as on hardware, or it
+           will be called again straight away. */
+        pthread_mutex_lock(&cores[core].cpu);
+        callback(data);
+        pthread_mutex_unlock(&cores[core].cpu);
+
+        pthread_mutex_lock(&chan_mutex);
+    }
+    pthread_mutex_unlock(&chan_mutex);
+
+    return NULL;
+}
+
+void triggerable_setup_interrupt_callback(resource_t res, void *data, interrupt_callback_t intrpt)
+{
+    host_chanend_t *ch;
+
+    pthread_mutex_lock(&chan_mutex);
+    ch = chanend_get(res);
+    ch->callback = intrpt;
+    ch->data = data;
+    pthread_mutex_unlock(&chan_mutex);
+}
+
+void triggerable_enable_trigger(resource_t res)
+{
+    host_chanend_t *ch;
+    host_core_t *core;
+
+    pthread_mutex_lock(&chan_mutex);
+    ch = chanend_get(res);
+    xassert(ch->callback != NULL);
+    ch->trigger_enabled = 1;
+
+    core = &cores[ch->owner];
+    if (!core->isr_started) {
+        core->isr_started = 1;
+        pthread_create(&core->isr_thread, NULL, isr_thread, (void *) (intptr_t) ch->owner);
+    }
+    pthread_cond_signal(&core->doorbell);
+    pthread_mutex_unlock(&chan_mutex);
+}
+
+void triggerable_disable_trigger(resource_t res)
+{
+    pthread_mutex_lock(&chan_mutex);
+    chanend_get(res)->trigger_enabled = 0;
+    pthread_mutex_unlock(&chan_mutex);
+}
+
+void xcore_host_shutdown(void)
+{
+    int i;
+
+    pthread_mutex_lock(&chan_mutex);
+    stopping = 1;
+    for (i = 0; i < XCORE_HOST_MAX_LOGICAL_CORES; i++) {
+        pthread_cond_signal(&cores[i].doorbell);
+    }
+    pthread_mutex_unlock(&chan_mutex);
+
+    for (i = 0; i < XCORE_HOST_MAX_LOGICAL_CORES; i++) {
+        if (cores[i].isr_started) {
+            pthread_join(cores[i].isr_thread, NULL);
+            cores[i].isr_started = 0;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Console                                                   */
+
+int _write(int fd, const char *buf, size_t len)
+{
+    (void) fd;
+
+    return (int) write(xcore_host_stdout_fd, buf, len);
+}
@@ -0,0 +1,262 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Checks the recursion and the RTOS_LOCKS_INSTRUMENT statistics of
+ * rtos_lock_acquire() and rtos_lock_release() on the host simulation.
+ *
+ * The reference clock is stopped and only moved on by the test, so the
+ * spin and hold times it expects are exact:
+ *  - a nested acquire and release on one core counts once, and the hold
+ *    time runs from the outermost acquire to the outermost release,
+ *  - a core that waits for another records exactly the time it waited,
+ *  - several cores nesting on the same lock count every acquire and
+ *    never see a hold time from an inner release,
+ *  - rtos_locks_stats_reset() clears every core, and may be called by
+ *    a core that already holds the lock.
+ *
+ * Exits non-zero if any check fails.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rtos_support.h"
+#include "xcore_host.h"
+
+#define TEST_LOCK   1
+#define TEST_CORES  4
+#define TEST_ITERS  20000
+#define TEST_DEPTH  3
+
+static int failures;
+
+static uint32_t shared_counter;
+static atomic_int holder_ready;
+static atomic_uint waiter_start;
+
+static void check(int ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void stats_get(int core_id, rtos_lock_stats_t *stats)
+{
+    rtos_locks_stats_get(TEST_LOCK, core_id, stats);
+}
+
+static int stats_clear(int core_id)
+{
+    rtos_lock_stats_t stats;
+    rtos_lock_stats_t zero;
+
+    memset(&zero, 0, sizeof(zero));
+    stats_get(core_id, &stats);
+    return memcmp(&stats, &zero, sizeof(stats)) == 0;
+}
+
+/* No IRQs are posted by this test. */
+void xcore_host_intercore_isr(void)
+{
+}
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The inner release happens 20 ticks after the outer acquire and the
+ * outer release 1020 ticks after it. Only the latter is a hold time.
+ */
+static void nested_core(void *arg)
+{
+    (void) arg;
+
+    check(rtos_lock_acquire(TEST_LOCK) == 1, "outer acquire count");
+    xcore_host_reference_time_advance(10);
+    check(rtos_lock_acquire(TEST_LOCK) == 2, "inner acquire count");
+    xcore_host_reference_time_advance(10);
+    check(rtos_lock_release(TEST_LOCK) == 1, "inner release count");
+    xcore_host_reference_time_advance(1000);
+    check(rtos_lock_release(TEST_LOCK) == 0, "outer release count");
+}
+
+static void test_nested(void)
+{
+    rtos_lock_stats_t stats;
+
+    xcore_host_core_start(1, nested_core, NULL);
+    xcore_host_core_join_all();
+
+    stats_get(1, &stats);
+    check(stats.acquire_count == 1, "nested: acquire count");
+    check(stats.recursive_count == 1, "nested: recursive count");
+    check(stats.spin_ticks == 0 && stats.spin_ticks_max == 0, "nested: spin without contention");
+    check(stats.hold_ticks_max == 1020, "nested: hold time is not outermost acquire to release");
+}
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Core 2 holds the lock while core 3 waits for it, and moves the clock
+ * on by 500 ticks before letting go.
+ */
+static void holder_core(void *arg)
+{
+    (void) arg;
+
+    rtos_lock_acquire(TEST_LOCK);
+    atomic_store(&holder_ready, 1);
+    while (atomic_load(&waiter_start) == 0) {
+        usleep(100);
+    }
+    /* Give the waiter time to reach the hardware lock. */
+    usleep(20000);
+    xcore_host_reference_time_advance(500);
+    rtos_lock_release(TEST_LOCK);
+}
+
+static void waiter_core(void *arg)
+{
+    (void) arg;
+
+    while (atomic_load(&holder_ready) == 0) {
+        usleep(100);
+    }
+    atomic_store(&waiter_start, 1);
+    rtos_lock_acquire(TEST_LOCK);
+    rtos_lock_release(TEST_LOCK);
+}
+
+static void test_spin(void)
+{
+    rtos_lock_stats_t stats;
+
+    xcore_host_core_start(2, holder_core, NULL);
+    xcore_host_core_start(3, waiter_core, NULL);
+    xcore_host_core_join_all();
+
+    stats_get(3, &stats);
+    check(stats.acquire_count == 1, "spin: acquire count");
+    check(stats.spin_ticks == 500, "spin: total spin time");
+    check(stats.spin_ticks_max == 500, "spin: longest spin time");
+    check(stats.hold_ticks_max == 0, "spin: waiter hold time");
+
+    stats_get(2, &stats);
+    check(stats.spin_ticks == 0, "spin: holder spin time");
+    check(stats.hold_ticks_max == 500, "spin: holder hold time");
+}
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Starts from cleared statistics. Every core nests TEST_DEPTH deep,
+ * moving the clock on by one tick at each level. Another core may also move it while this one holds the
+ * lock, but only before the outermost acquire returns, so each hold is
+ * exactly TEST_DEPTH ticks.
+ */
+static void contended_core(void *arg)
+{
+    int i;
+    int j;
+
+    (void) arg;
+
+    for (i = 0; i < TEST_ITERS; i++) {
+        for (j = 0; j < TEST_DEPTH; j++) {
+            rtos_lock_acquire(TEST_LOCK);
+            xcore_host_reference_time_advance(1);
+        }
+        shared_counter++;
+        for (j = 0; j < TEST_DEPTH; j++) {
+            rtos_lock_release(TEST_LOCK);
+        }
+    }
+}
+
+static void test_contended(void)
+{
+    rtos_lock_stats_t stats;
+    int i;
+
+    rtos_locks_stats_reset();
+    for (i = 0; i < TEST_CORES; i++) {
+        xcore_host_core_start(i, contended_core, NULL);
+    }
+    xcore_host_core_join_all();
+
+    check(shared_counter == (uint32_t) TEST_CORES * TEST_ITERS, "contended: lost updates");
+    for (i = 0; i < TEST_CORES; i++) {
+        stats_get(i, &stats);
+        check(stats.acquire_count == TEST_ITERS, "contended: acquire count");
+        check(stats.recursive_count == (TEST_DEPTH - 1) * TEST_ITERS, "contended: recursive count");
+        check(stats.hold_ticks_max == TEST_DEPTH, "contended: hold time");
+        check(stats.spin_ticks >= stats.spin_ticks_max, "contended: total spin less than longest");
+        check(stats.spin_ticks <= (uint64_t) TEST_CORES * TEST_ITERS * TEST_DEPTH,
+              "contended: spin longer than the clock ran");
+    }
+    for (; i < RTOS_MAX_CORE_COUNT; i++) {
+        check(stats_clear(i), "contended: statistics for a core that never ran");
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Resets while holding the lock. The reset must not deadlock and must
+ * clear every core, and the hold that was in progress is still recorded
+ * by the release that follows it.
+ */
+static void reset_core(void *arg)
+{
+    (void) arg;
+
+    rtos_lock_acquire(TEST_LOCK);
+    xcore_host_reference_time_advance(7);
+    rtos_locks_stats_reset();
+    xcore_host_reference_time_advance(7);
+    rtos_lock_release(TEST_LOCK);
+}
+
+static void test_reset(void)
+{
+    rtos_lock_stats_t stats;
+    int i;
+
+    xcore_host_core_start(0, reset_core, NULL);
+    xcore_host_core_join_all();
+
+    stats_get(0, &stats);
+    check(stats.acquire_count == 0, "reset: acquire count");
+    check(stats.recursive_count == 0, "reset: recursive count");
+    check(stats.spin_ticks == 0 && stats.spin_ticks_max == 0, "reset: spin time");
+    check(stats.hold_ticks_max == 14, "reset: hold in progress not recorded");
+    for (i = 1; i < RTOS_MAX_CORE_COUNT; i++) {
+        check(stats_clear(i), "reset: statistics not cleared");
+    }
+
+    rtos_locks_stats_reset();
+    for (i = 0; i < RTOS_MAX_CORE_COUNT; i++) {
+        check(stats_clear(i), "reset: statistics not cleared");
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+int main(void)
+{
+    rtos_locks_initialize();
+    xcore_host_reference_time_manual(1000);
+
+    test_nested();
+    test_spin();
+    test_contended();
+    test_reset();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+
+    return failures != 0;
+}
@@ -0,0 +1,212 @@
+// Copyright 2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Checks rtos_snprintf() against the host C library's snprintf() for
+ * the integer, string, %f, %e and %g conversions it supports.
+ *
+ * Each case is formatted into buffers of several sizes, including 0, 1
+ * and sizes that cut the output short, and both the return value and
+ * every byte of the buffer must match. Bytes past the size given must
+ * be left alone.
+ *
+ * Exits non-zero if any check fails.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rtos_support.h"
+
+#define TEST_BUF_SIZE 400
+#define TEST_FILL     0x7E
+
+static int failures;
+static int cases;
+
+/* No IRQs are posted by this test. */
+void xcore_host_intercore_isr(void)
+{
+}
+
+static void compare(const char *fmt, size_t size,
+                    const char *expect, int expect_len,
+                    const char *got, int got_len)
+{
+    if (expect_len != got_len || memcmp(expect, got, TEST_BUF_SIZE) != 0) {
+        printf("FAIL: \"%s\" size %u: expected %d \"%.*s\", got %d \"%.*s\"\n",
+               fmt, (unsigned) size,
+               expect_len, (int) strnlen(expect, size), expect,
+               got_len, (int) strnlen(got, size), got);
+        failures++;
+    }
+}
+
+/*
+ * Formats with both at every size of interest. The untruncated length
+ * is only known after the first call, so sizes around it are added then.
+ */
+#define CHECK(fmt, ...) do {                                                    \
+    char expect[TEST_BUF_SIZE];                                                 \
+    char got[TEST_BUF_SIZE];                                                    \
+    int len = snprintf(NULL, 0, fmt, __VA_ARGS__);                              \
+    size_t sizes[] = {0, 1, 2, 5, (size_t) len / 2, (size_t) len,               \
+                      (size_t) len + 1, TEST_BUF_SIZE};                         \
+    int expect_len;                                                             \
+    int got_len;                                                                \
+    size_t i;                                                                   \
+                                                                                \
+    cases++;                                                                    \
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {                    \
+        memset(expect, TEST_FILL, sizeof(expect));                              \
+        memset(got, TEST_FILL, sizeof(got));                                    \
+        expect_len = snprintf(expect, sizes[i], fmt, __VA_ARGS__);              \
+        got_len = rtos_snprintf(got, sizes[i], fmt, __VA_ARGS__);               \
+        compare(fmt, sizes[i], expect, expect_len, got, got_len);               \
+    }                                                                           \
+} while (0)
+
+static void test_integers(void)
+{
+    CHECK("%d", 0);
+    CHECK("%d", -1);
+    CHECK("%d", INT32_MIN);
+    CHECK("%d", INT32_MAX);
+    CHECK("%i", 1234567);
+    CHECK("%u", UINT32_MAX);
+    CHECK("%x", 0xDEADBEEFu);
+    CHECK("%X", 0xDEADBEEFu);
+    CHECK("%08x", 0xC0FFEEu);
+    CHECK("%5d|%-5d|", 42, 42);
+    CHECK("%05d", -42);
+    CHECK("%+d % d %+d", 7, 7, -7);
+    CHECK("%+06d", 7);
+    CHECK("%3d", 123456);
+    CHECK("%ld", -1234567890123L);
+    CHECK("%lu", 18446744073709551615UL);
+    CHECK("%lld", (long long) INT64_MIN);
+    CHECK("%llu", (unsigned long long) UINT64_MAX);
+    CHECK("%llx", 0x0123456789ABCDEFULL);
+    CHECK("%016llX", 0xABCDEFULL);
+    CHECK("core %d tick %u value %08x %s %lld\n", 3, 99u, 0xC0FFEEu, "ok", -123456789012LL);
+}
+
+static void test_strings(void)
+{
+    CHECK("%s", "hello");
+    CHECK("%s", "");
+    CHECK("[%8s]", "hello");
+    CHECK("[%-8s]", "hello");
+    CHECK("[%3s]", "hello");
+    CHECK("[%.3s]", "hello");
+    CHECK("[%5.1s]", "hello");
+    CHECK("[%-5.1s]", "hello");
+    CHECK("[%5.0s]", "hello");
+    CHECK("[%.*s]", 2, "hello");
+    CHECK("[%8.10s]", "hello");
+    CHECK("%c%c%c", 'a', 'b', 'c');
+    CHECK("100%% %s", "done");
+}
+
+static void test_floats(void)
+{
+    CHECK("%f", 0.0);
+    CHECK("%f", -0.0);
+    CHECK("%f", 1.5);
+    CHECK("%f", 0.1);
+    CHECK("%f", -123.456);
+    CHECK("%.0f %.0f %.0f %.0f", 0.5, 1.5, 2.5, 3.5);
+    CHECK("%.3f", 1.0005);
+    CHECK("%.2f", 0.125);
+    CHECK("%.20f", 0.1);
+    CHECK("%.30f", 1e-20);
+    CHECK("%f", 1e20);
+    CHECK("%f", 1e-10);
+    CHECK("%.0f", DBL_MAX);
+    CHECK("%f", 4294967296.75);
+    CHECK("%10.2f|%-10.2f|", 3.14159, 3.14159);
+    CHECK("%010.3f", -3.14159);
+    CHECK("%+f % f", 2.0, 2.0);
+    CHECK("%f %F", INFINITY, -INFINITY);
+    CHECK("%f %F", NAN, NAN);
+    CHECK("%8f|%-8f|%08f", INFINITY, INFINITY, INFINITY);
+
+    CHECK("%e", 0.0);
+    CHECK("%e", 12345.678);
+    CHECK("%E", -0.000123);
+    CHECK("%.0e", 5e10);
+    CHECK("%.0e", 2.5);
+    CHECK("%.3e", 9.9996);
+    CHECK("%.10e", 1.0 / 3.0);
+    CHECK("%e", DBL_MAX);
+    CHECK("%e", DBL_MIN);
+    CHECK("%e", 4.9406564584124654e-324);
+    CHECK("%.20e", 4.9406564584124654e-324);
+    CHECK("%e", 1e100);
+    CHECK("%15.4e|%-15.4e|%015.4e", -6.02214076e23, 6.02214076e23, 6.02214076e23);
+
+    CHECK("%g", 0.0);
+    CHECK("%g", 100000.0);
+    CHECK("%g", 1000000.0);
+    CHECK("%g", 0.0001);
+    CHECK("%g", 0.00001);
+    CHECK("%g", 123.456);
+    CHECK("%G", 1.5e-7);
+    CHECK("%.3g", 99950.0);
+    CHECK("%.0g", 0.5);
+    CHECK("%.10g", 1.0 / 3.0);
+}
+
+/*
+ * rtos_sprintf() takes no size, and rtos_vsnprintf() shares the
+ * formatter with rtos_snprintf(), so one check of each is enough.
+ */
+static int vsnprintf_check(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = rtos_vsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+
+    return len;
+}
+
+static void test_other_entry_points(void)
+{
+    char buf[16];
+    int len;
+
+    memset(buf, TEST_FILL, sizeof(buf));
+    len = vsnprintf_check(buf, 5, "%d", 123456);
+    cases++;
+    if (len != 6 || strcmp(buf, "1234") != 0) {
+        printf("FAIL: rtos_vsnprintf truncation\n");
+        failures++;
+    }
+
+    memset(buf, TEST_FILL, sizeof(buf));
+    len = rtos_sprintf(buf, "%s=%d", "x", -5);
+    cases++;
+    if (len != 4 || strcmp(buf, "x=-5") != 0) {
+        printf("FAIL: rtos_sprintf\n");
+        failures++;
+    }
+}
+
+int main(void)
+{
+    test_integers();
+    test_strings();
+    test_floats();
+    test_other_entry_points();
+
+    printf("%d cases\n", cases);
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+
+    return failures != 0;
+}
@@ -1,6 +1,8 @@
 // Copyright 2019-2021 XMOS LIMITED.
 // This Software is subject to the terms of the XMOS Public Licence: Version 1.
 
+#include <string.h>
+
 #include "rtos_support.h"
 
 lock_t rtos_locks[RTOS_LOCK_COUNT] = {
@@ -20,6 +22,16 @@ lock_t rtos_locks[RTOS_LOCK_COUNT] = {
 
 int rtos_lock_counters[RTOS_LOCK_COUNT] = {0};
 
+#if RTOS_LOCKS_INSTRUMENT
+rtos_lock_stats_t rtos_lock_stats[RTOS_LOCK_COUNT][RTOS_MAX_CORE_COUNT];
+
+/*
+ * The time the current owner of each lock acquired it.
+ * Only written by the owner while it holds the lock.
+ */
+uint32_t rtos_lock_hold_start[RTOS_LOCK_COUNT];
+#endif
+
 void rtos_locks_initialize(void)
 {
     int i;
@@ -30,6 +42,62 @@ void rtos_locks_initialize(void)
     }
 }
 
+#if RTOS_LOCKS_INSTRUMENT
+
+/* The dump is always wanted when it is asked for, regardless
+   of the debug print settings of this unit. */
+#undef rtos_printf
+
+void rtos_locks_stats_get(int lock_id, int core_id, rtos_lock_stats_t *stats)
+{
+    xassert(lock_id >= 0 && lock_id < RTOS_LOCK_COUNT);
+    xassert(core_id >= 0 && core_id < RTOS_MAX_CORE_COUNT);
+
+    /* Not atomic with respect to the owning core. Each field is
+       only increased between resets, so at worst it is stale. */
+    *stats = rtos_lock_stats[lock_id][core_id];
+}
+
+void rtos_locks_stats_reset(void)
+{
+    int i;
+
+    for (i = 0; i < RTOS_LOCK_COUNT; i++) {
+        rtos_lock_acquire(i);
+        memset(rtos_lock_stats[i], 0, sizeof(rtos_lock_stats[i]));
+        rtos_lock_release(i);
+    }
+}
+
+void rtos_locks_stats_dump(void)
+{
+    rtos_lock_stats_t stats;
+    uint32_t spin_avg;
+    int i;
+    int j;
+
+    rtos_printf("lock core  acquires recursive  spin avg  spin max  hold max\n");
+
+    for (i = 0; i < RTOS_LOCK_COUNT; i++) {
+        for (j = 0; j < RTOS_MAX_CORE_COUNT; j++) {
+            rtos_locks_stats_get(i, j, &stats);
+            if (stats.acquire_count == 0) {
+                continue;
+            }
+            spin_avg = (uint32_t) (stats.spin_ticks / stats.acquire_count);
+            rtos_printf("%4d %4d %9u %9u %9u %9u %9u\n",
+                        i, j,
+                        stats.acquire_count,
+                        stats.recursive_count,
+                        spin_avg,
+                        stats.spin_ticks_max,
+                        stats.hold_ticks_max);
+        }
+    }
+}
+
+#endif /* RTOS_LOCKS_INSTRUMENT */
+
 /*
  * Ensure that these normally inline functions exist
  * when compiler optimizations are disabled.
@@ -24,6 +24,17 @@
 #define LONG64 (LONG_MAX == 9223372036854775807L)
 #define POINTER64 (INTPTR_MAX == 9223372036854775807L)
 
+/* Set to 0 to leave out %f, %e and %g. */
+#ifndef RTOS_PRINTF_ENABLE_FLOAT
+#define RTOS_PRINTF_ENABLE_FLOAT 1
+#endif
+
+/* Larger precisions are clamped to this. Bounds the */
+/* stack used by the float conversion.               */
+#ifndef RTOS_PRINTF_FLOAT_MAX_PRECISION
+#define RTOS_PRINTF_FLOAT_MAX_PRECISION 30
+#endif
+
 typedef struct {
     size_t size;
     size_t pos;
@@ -35,7 +46,9 @@ typedef struct {
     int32_t do_padding;
     int32_t left_flag;
     int32_t unsigned_flag;
+    int32_t upper_flag;
     char pad_character;
+    char sign_character;
 } params_t;
 
 static void outbyte(char b, params_t *par)
@@ -84,9 +97,13 @@ static void padding(const int32_t l_flag, params_t *par)
 /*                                                   */
 static void outs(const char *lp, params_t *par)
 {
-    /* pad on left if needed                         */
+    /* pad on left if needed. A precision limits the */
+    /* characters moved, and so also the padding.    */
     if(lp != NULL) {
         par->len = (int32_t) strlen(lp);
+        if (par->num2 >= 0 && par->len > par->num2) {
+            par->len = par->num2;
+        }
     }
     padding(!(par->left_flag), par);
 
@@ -100,114 +117,456 @@ static void outs(const char *lp, params_t *par)
     padding(par->left_flag, par);
 }
 
+/*---------------------------------------------------*/
+/*                                                   */
+/* Two decimal digits at a time, so that a number    */
+/* needs half as many divisions to convert.          */
+/*                                                   */
+static const char digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const uint32_t pow10_table[10] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000,
+    10000000, 100000000, 1000000000
+};
+
+/*---------------------------------------------------*/
+/*                                                   */
+/* This routine converts a number to text, writing   */
+/* it backwards so that it ends just before end.     */
+/* Returns a pointer to the first character.         */
+/* 64-bit division is only used while the value      */
+/* does not fit in 32 bits.                          */
+/*                                                   */
+static char *utoa_rev(uint64_t num, const int32_t base, const int32_t upper, char *end)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char *p = end;
+    uint32_t num32;
+    uint32_t q;
+
+    if (base == 10) {
+        while (num > UINT32_MAX) {
+            uint64_t q64 = num / 100;
+            uint32_t r = (uint32_t)(num - q64 * 100);
+            p -= 2;
+            memcpy(p, &digit_pairs[r * 2], 2);
+            num = q64;
+        }
+        num32 = (uint32_t)num;
+        while (num32 >= 100) {
+            q = num32 / 100;
+            p -= 2;
+            memcpy(p, &digit_pairs[(num32 - q * 100) * 2], 2);
+            num32 = q;
+        }
+        if (num32 >= 10) {
+            p -= 2;
+            memcpy(p, &digit_pairs[num32 * 2], 2);
+        } else {
+            *--p = (char)('0' + num32);
+        }
+    } else {
+        do {
+            *--p = digits[num & 0xF];
+            num >>= 4;
+        } while (num != 0);
+    }
+
+    return p;
+}
+
+/*---------------------------------------------------*/
+/*                                                   */
+/* This routine moves a converted number, with an    */
+/* optional sign character, to the output buffer as  */
+/* directed by the padding and positioning flags.    */
+/* With zero padding the sign goes before the zeros. */
+/*                                                   */
+static void outdigits(const char sign, const char *digits, const int32_t len, params_t *par)
+{
+    int32_t i;
+
+    par->len = len + (sign != 0);
+
+    if (sign != 0 && par->pad_character == '0') {
+        outbyte(sign, par);
+    }
+    padding(!(par->left_flag), par);
+    if (sign != 0 && par->pad_character != '0') {
+        outbyte(sign, par);
+    }
+    for (i = 0; i < len; i++) {
+        outbyte(digits[i], par);
+    }
+    padding(par->left_flag, par);
+}
+
 /*---------------------------------------------------*/
 /*                                                   */
 /* This routine moves a number to the output buffer  */
 /* as directed by the padding and positioning flags. */
 /*                                                   */
+static void outnum(const int64_t n, const int32_t base, params_t *par)
+{
+    char outbuf[24];
+    char *end = &outbuf[sizeof(outbuf)];
+    char *start;
+    char sign = 0;
+    uint64_t num;
+
+    /* Check if number is negative                   */
+    if ((par->unsigned_flag == 0) && (base == 10) && (n < 0)) {
+        sign = '-';
+        num = -(uint64_t)n;
+    } else {
+        if ((par->unsigned_flag == 0) && (base == 10)) {
+            sign = par->sign_character;
+        }
+        num = (uint64_t)n;
+    }
+
+    start = utoa_rev(num, base, par->upper_flag, end);
+    outdigits(sign, start, (int32_t)(end - start), par);
+}
+
+#if RTOS_PRINTF_ENABLE_FLOAT
+/*---------------------------------------------------*/
+/*                                                   */
+/* Floating point conversion.                        */
+/*                                                   */
+/* The value is converted exactly into base 10^9     */
+/* "chunks" using multi-word integer arithmetic, the */
+/* way musl's printf does, then rounded half to even */
+/* at the requested precision. Nothing from the C    */
+/* library or the soft float routines is needed      */
+/* other than reading the bits of the double.        */
+/*                                                   */
+
+/* Enough 32-bit words for the 1024 integer bits or  */
+/* the 1074 + 53 fraction bits of a double.          */
+#define FLOAT_BIG_WORDS 36
+#define FLOAT_CHUNK 1000000000u
+#define FLOAT_MAX_CHUNKS (FLOAT_BIG_WORDS + (RTOS_PRINTF_FLOAT_MAX_PRECISION + 8) / 9 + 2)
+
+typedef struct {
+    /* Base 10^9 digits, most significant first. Digit */
+    /* k counts from the top of chunk[0] with leading  */
+    /* zeros and has weight 10^(point - 1 - k).        */
+    uint32_t chunk[FLOAT_MAX_CHUNKS];
+    int32_t nchunks;
+    int32_t point;
+} decimal_t;
+
+static int32_t chunk_width(uint32_t c)
+{
+    int32_t n = 1;
+
+    while (n < 9 && c >= pow10_table[n]) {
+        n++;
+    }
+    return n;
+}
 
-static void outnum(const int32_t n, const int32_t base, params_t *par)
+static uint32_t decimal_digit(const decimal_t *dec, int32_t k)
 {
-    int32_t negative;
+    if (k / 9 >= dec->nchunks) {
+        return 0;
+    }
+    return (dec->chunk[k / 9] / pow10_table[8 - k % 9]) % 10;
+}
+
+/* Loads m << shift into little-endian words and     */
+/* returns the number of significant words.          */
+static int32_t big_load(uint32_t *w, uint64_t m, int32_t shift)
+{
+    int32_t idx = shift / 32;
+    int32_t s = shift % 32;
+    uint64_t lo = m << s;
+    uint32_t hi = s ? (uint32_t)(m >> (64 - s)) : 0;
+    int32_t n;
+
+    memset(w, 0, (FLOAT_BIG_WORDS + 2) * sizeof(uint32_t));
+    w[idx] = (uint32_t)lo;
+    w[idx + 1] = (uint32_t)(lo >> 32);
+    w[idx + 2] = hi;
+
+    n = idx + 3;
+    while (n > 0 && w[n - 1] == 0) {
+        n--;
+    }
+    return n;
+}
+
+/* Divides in place, returning the remainder.        */
+static uint32_t big_divmod(uint32_t *w, int32_t *n, uint32_t d)
+{
+    uint64_t r = 0;
+    uint64_t cur;
     int32_t i;
-    char outbuf[32];
-    const char digits[] = "0123456789ABCDEF";
-    uint32_t num;
-    for(i = 0; i<32; i++) {
-        outbuf[i] = '0';
+
+    for (i = *n - 1; i >= 0; i--) {
+        cur = (r << 32) | w[i];
+        w[i] = (uint32_t)(cur / d);
+        r = cur - (uint64_t)w[i] * d;
+    }
+    while (*n > 0 && w[*n - 1] == 0) {
+        (*n)--;
     }
+    return (uint32_t)r;
+}
 
-    /* Check if number is negative                   */
-    if ((par->unsigned_flag == 0) && (base == 10) && (n < 0L)) {
-        negative = 1;
-        num =(-(n));
+/* Multiplies the fraction held in words lo..n-1 by  */
+/* m, returning the integer part that carries out.   */
+static uint32_t big_mul_frac(uint32_t *w, int32_t *lo, int32_t n, uint32_t m)
+{
+    uint64_t carry = 0;
+    uint64_t cur;
+    int32_t i;
+
+    for (i = *lo; i < n; i++) {
+        cur = (uint64_t)w[i] * m + carry;
+        w[i] = (uint32_t)cur;
+        carry = cur >> 32;
     }
-    else{
-        num = n;
-        negative = 0;
+    /* Low words become zero for good once they are. */
+    while (*lo < n && w[*lo] == 0) {
+        (*lo)++;
     }
+    return (uint32_t)carry;
+}
 
-    /* Build number (backwards) in outbuf            */
-    i = 0;
-    do {
-        outbuf[i] = digits[(num % base)];
-        i++;
-        num /= base;
-    } while (num > 0);
+/*---------------------------------------------------*/
+/*                                                   */
+/* Converts m * 2^e to decimal, rounded to prec      */
+/* digits after the point for 'f', or to prec + 1    */
+/* significant digits for 'e'.                       */
+/*                                                   */
+static void float_to_decimal(uint64_t m, int32_t e, int32_t prec, char mode, decimal_t *dec)
+{
+    uint32_t big[FLOAT_BIG_WORDS + 2];
+    int32_t n = 0;
+    int32_t lo = 0;
+    int32_t round_at;
+    int32_t i;
+    uint32_t rd;
+    uint32_t c;
+    int32_t sticky;
+    int32_t up;
+
+    dec->nchunks = 0;
+
+    /* Integer part, least significant chunk first.  */
+    if (e >= 0) {
+        n = big_load(big, m, e);
+    } else if (e > -64) {
+        n = big_load(big, m >> -e, 0);
+    }
+    while (n > 0) {
+        dec->chunk[dec->nchunks++] = big_divmod(big, &n, FLOAT_CHUNK);
+    }
+    for (i = 0; i < dec->nchunks / 2; i++) {
+        c = dec->chunk[i];
+        dec->chunk[i] = dec->chunk[dec->nchunks - 1 - i];
+        dec->chunk[dec->nchunks - 1 - i] = c;
+    }
+    dec->point = 9 * dec->nchunks;
+
+    /* Fraction part, left aligned to a word boundary. */
+    if (e < 0) {
+        uint64_t f = (-e >= 64) ? m : (m & ((1ULL << -e) - 1));
+        n = (-e + 31) / 32;
+        big_load(big, f, 32 * n + e);
+        while (lo < n && big[lo] == 0) {
+            lo++;
+        }
+    }
 
-    if (negative != 0) {
-        outbuf[i] = '-';
-        i++;
+    if (dec->nchunks == 0) {
+        if (mode == 'f' || m == 0) {
+            dec->chunk[dec->nchunks++] = 0;
+            dec->point = 9;
+        } else {
+            /* Skip whole chunks of leading zeros.       */
+            while ((c = big_mul_frac(big, &lo, n, FLOAT_CHUNK)) == 0) {
+                dec->point -= 9;
+            }
+            dec->chunk[dec->nchunks++] = c;
+        }
     }
 
-    outbuf[i] = '\0';
-    i--;
+    if (mode == 'f') {
+        round_at = dec->point + prec;
+    } else {
+        round_at = (9 - chunk_width(dec->chunk[0])) + prec + 1;
+    }
 
-    /* Move the converted number to the buffer and   */
-    /* add in the padding where needed.              */
-    par->len = (int32_t)strlen(outbuf);
-    padding(!(par->left_flag), par);
-    while (&outbuf[i] >= outbuf) {
-        outbyte(outbuf[i], par);
-        i--;
+    /* Generate the fraction up to the rounding digit. */
+    while (9 * dec->nchunks <= round_at) {
+        dec->chunk[dec->nchunks++] = (lo < n) ? big_mul_frac(big, &lo, n, FLOAT_CHUNK) : 0;
+    }
+
+    /* Round half to even on the exact value.        */
+    rd = decimal_digit(dec, round_at);
+    sticky = (lo < n) || (dec->chunk[round_at / 9] % pow10_table[8 - round_at % 9]) != 0;
+    for (i = round_at / 9 + 1; !sticky && i < dec->nchunks; i++) {
+        sticky = dec->chunk[i] != 0;
+    }
+    up = rd > 5 || (rd == 5 && (sticky || (decimal_digit(dec, round_at - 1) & 1)));
+
+    dec->chunk[round_at / 9] -= dec->chunk[round_at / 9] % pow10_table[9 - round_at % 9];
+    dec->nchunks = round_at / 9 + 1;
+
+    if (up) {
+        i = (round_at - 1) / 9;
+        dec->chunk[i] += pow10_table[8 - (round_at - 1) % 9];
+        while (i > 0 && dec->chunk[i] >= FLOAT_CHUNK) {
+            dec->chunk[i] -= FLOAT_CHUNK;
+            dec->chunk[--i]++;
+        }
+        if (dec->chunk[0] >= FLOAT_CHUNK) {
+            dec->chunk[0] -= FLOAT_CHUNK;
+            memmove(&dec->chunk[1], &dec->chunk[0], dec->nchunks * sizeof(uint32_t));
+            dec->chunk[0] = 1;
+            dec->nchunks++;
+            dec->point += 9;
+        }
     }
-    padding(par->left_flag, par);
 }
+
 /*---------------------------------------------------*/
 /*                                                   */
-/* This routine moves a 64-bit number to the output  */
-/* buffer as directed by the padding and positioning */
-/* flags.                                            */
+/* This routine moves a floating point number to the */
+/* output buffer for %f, %e and %g, as directed by   */
+/* the padding and positioning flags.                */
 /*                                                   */
-#if LONG64
-static void outnum1(const int64_t n, const int32_t base, params_t *par)
+static void outfloat(const double value, const char conv, int32_t prec, params_t *par)
 {
-    int32_t negative;
+    decimal_t dec;
+    union { double d; uint64_t u; } bits;
+    char sign;
+    char expbuf[8];
+    char *expstart;
+    uint64_t m;
+    int32_t e;
+    int32_t first;
+    int32_t exp10 = 0;
+    int32_t frac_digits;
+    int32_t len;
     int32_t i;
-    char outbuf[64];
-    const char digits[] = "0123456789ABCDEF";
-    uint64_t num;
-    for(i = 0; i<64; i++) {
-        outbuf[i] = '0';
+    char mode = conv;
+
+    bits.d = value;
+    sign = (bits.u >> 63) ? '-' : par->sign_character;
+    e = (int32_t)((bits.u >> 52) & 0x7FF);
+    m = bits.u & ((1ULL << 52) - 1);
+
+    if (e == 0x7FF) {
+        const char *s = (m != 0) ? (par->upper_flag ? "NAN" : "nan")
+                                 : (par->upper_flag ? "INF" : "inf");
+        par->pad_character = ' ';
+        outdigits(sign, s, 3, par);
+        return;
     }
 
-    /* Check if number is negative                   */
-    if ((par->unsigned_flag == 0) && (base == 10) && (n < 0L)) {
-        negative = 1;
-        num =(-(n));
+    if (e == 0) {
+        e = -1074;
+    } else {
+        m |= 1ULL << 52;
+        e -= 1075;
     }
-    else{
-        num = (n);
-        negative = 0;
+
+    if (prec > RTOS_PRINTF_FLOAT_MAX_PRECISION) {
+        prec = RTOS_PRINTF_FLOAT_MAX_PRECISION;
     }
 
-    /* Build number (backwards) in outbuf            */
-    i = 0;
-    do {
-        outbuf[i] = digits[(num % base)];
-        i++;
-        num /= base;
-    } while (num > 0);
+    if (conv == 'g') {
+        /* The exponent after rounding to the          */
+        /* requested significant digits picks between  */
+        /* the two styles.                             */
+        if (prec == 0) {
+            prec = 1;
+        }
+        float_to_decimal(m, e, prec - 1, 'e', &dec);
+        exp10 = (m == 0) ? 0 : dec.point - 1 - (9 - chunk_width(dec.chunk[0]));
+        if (exp10 < -4 || exp10 >= prec) {
+            mode = 'e';
+            prec = prec - 1;
+        } else {
+            mode = 'f';
+            prec = prec - 1 - exp10;
+            float_to_decimal(m, e, prec, 'f', &dec);
+        }
+    } else {
+        float_to_decimal(m, e, prec, mode, &dec);
+    }
 
-    if (negative != 0) {
-        outbuf[i] = '-';
-        i++;
+    if (mode == 'f') {
+        first = 9 - chunk_width(dec.chunk[0]);
+    } else {
+        first = (m == 0) ? 8 : 9 - chunk_width(dec.chunk[0]);
+        exp10 = (m == 0) ? 0 : dec.point - 1 - first;
     }
 
-    outbuf[i] = '\0';
-    i--;
+    /* %g drops trailing zeros from the fraction.    */
+    frac_digits = prec;
+    if (conv == 'g') {
+        i = (mode == 'f') ? dec.point : first + 1;
+        while (frac_digits > 0 && decimal_digit(&dec, i + frac_digits - 1) == 0) {
+            frac_digits--;
+        }
+    }
 
-    /* Move the converted number to the buffer and   */
-    /* add in the padding where needed.              */
-    par->len = (int32_t)strlen(outbuf);
+    expstart = &expbuf[sizeof(expbuf)];
+    if (mode == 'e') {
+        expstart = utoa_rev((uint64_t)(exp10 < 0 ? -exp10 : exp10), 10, 0, expstart);
+        if (expstart > &expbuf[sizeof(expbuf) - 2]) {
+            *--expstart = '0';
+        }
+        *--expstart = exp10 < 0 ? '-' : '+';
+        *--expstart = par->upper_flag ? 'E' : 'e';
+        len = 1;
+    } else {
+        len = dec.point - first;
+    }
+    len += (frac_digits > 0 ? 1 + frac_digits : 0) + (int32_t)(&expbuf[sizeof(expbuf)] - expstart);
+
+    par->len = len + (sign != 0);
+    if (sign != 0 && par->pad_character == '0') {
+        outbyte(sign, par);
+    }
     padding(!(par->left_flag), par);
-    while (&outbuf[i] >= outbuf) {
-        outbyte(outbuf[i], par);
-        i--;
+    if (sign != 0 && par->pad_character != '0') {
+        outbyte(sign, par);
     }
+
+    if (mode == 'f') {
+        for (i = first; i < dec.point; i++) {
+            outbyte((char)('0' + decimal_digit(&dec, i)), par);
+        }
+        i = dec.point;
+    } else {
+        outbyte((char)('0' + decimal_digit(&dec, first)), par);
+        i = first + 1;
+    }
+    if (frac_digits > 0) {
+        outbyte('.', par);
+        for (; frac_digits > 0; frac_digits--, i++) {
+            outbyte((char)('0' + decimal_digit(&dec, i)), par);
+        }
+    }
+    while (expstart < &expbuf[sizeof(expbuf)]) {
+        outbyte(*expstart++, par);
+    }
+
     padding(par->left_flag, par);
 }
-#endif
+#endif /* RTOS_PRINTF_ENABLE_FLOAT */
+
 /*---------------------------------------------------*/
 /*                                                   */
 /* This routine gets a number from the format        */
@@ -244,19 +603,18 @@ static int32_t getnum(char **linep)
 /* control of a formatting string. Not all of the    */
 /* standard C format control are supported. The ones */
 /* provided are primarily those needed for embedded  */
-/* systems work. Primarily the floating point        */
-/* routines are omitted. Other formats could be      */
-/* added easily by following the examples shown for  */
-/* the supported formats.                            */
+/* systems work. Floating point may be left out by   */
+/* defining RTOS_PRINTF_ENABLE_FLOAT to 0. Other     */
+/* formats could be added easily by following the    */
+/* examples shown for the supported formats.         */
 /*                                                   */
 
 static int rtos_vsnwprintf(char *str, size_t size, int writeout, const char *fmt, va_list ap)
 {
     int32_t Check;
-#if LONG64
     int32_t long_flag;
-#endif
     int32_t dot_flag;
+    int64_t n;
 
     params_t par;
 
@@ -280,10 +638,10 @@ static int rtos_vsnwprintf(char *str, size_t size, int writeout, const char *fmt
 
         /* initialize all the flags for this format.   */
         dot_flag = 0;
-#if LONG64
         long_flag = 0;
-#endif
         par.unsigned_flag = 0;
+        par.upper_flag = 0;
+        par.sign_character = 0;
         par.left_flag = 0;
         par.do_padding = 0;
         par.pad_character = ' ';
@@ -339,13 +697,24 @@ static int rtos_vsnwprintf(char *str, size_t size, int writeout, const char *fmt
 
             case '.':
                 dot_flag = 1;
+                par.num2 = 0;
+                Check = 0;
+                break;
+
+            case '+':
+                par.sign_character = '+';
+                Check = 0;
+                break;
+
+            case ' ':
+                if (par.sign_character == 0) {
+                    par.sign_character = ' ';
+                }
                 Check = 0;
                 break;
 
             case 'l':
-            #if LONG64
-                long_flag = 1;
-            #endif
+                long_flag++;
                 Check = 0;
                 break;
 
@@ -354,40 +723,46 @@ static int rtos_vsnwprintf(char *str, size_t size, int writeout, const char *fmt
                 /* fall through */
             case 'i':
             case 'd':
-                #if LONG64
-                if (long_flag != 0){
-                    outnum1((int64_t)va_arg(ap, int64_t), 10L, &par);
-                }
-                else {
-                    outnum(va_arg(ap, int32_t), 10L, &par);
+                /* %ll is always 64 bits, %l only where long is. */
+                if (long_flag >= 2 || (LONG64 && long_flag != 0)) {
+                    n = va_arg(ap, int64_t);
+                } else if (par.unsigned_flag) {
+                    n = va_arg(ap, uint32_t);
+                } else {
+                    n = va_arg(ap, int32_t);
                 }
-                #else
-                outnum(va_arg(ap, int32_t), 10L, &par);
-                #endif
+                outnum(n, 10L, &par);
                 Check = 1;
                 break;
             case 'p':
                 #if POINTER64
                 par.unsigned_flag = 1;
-                outnum1((int64_t)va_arg(ap, int64_t), 16L, &par);
+                outnum((int64_t)va_arg(ap, int64_t), 16L, &par);
                 Check = 1;
                 break;
                 #endif
-            case 'X':
             case 'x':
                 par.unsigned_flag = 1;
-                #if LONG64
-                if (long_flag != 0) {
-                    outnum1((int64_t)va_arg(ap, int64_t), 16L, &par);
-                }
-                else {
-                    outnum((int32_t)va_arg(ap, int32_t), 16L, &par);
+                par.upper_flag = (ch == 'X');
+                if (long_flag >= 2 || (LONG64 && long_flag != 0)) {
+                    n = va_arg(ap, int64_t);
+                } else {
+                    n = va_arg(ap, uint32_t);
                 }
-                #else
-                outnum((int32_t)va_arg(ap, int32_t), 16L, &par);
-                #endif
+                outnum(n, 16L, &par);
+                Check = 1;
+                break;
+
+#if RTOS_PRINTF_ENABLE_FLOAT
+            case 'f':
+            case 'e':
+            case 'g':
+                par.upper_flag = (ch != tolower((int32_t)ch));
+                outfloat(va_arg(ap, double), (char)tolower((int32_t)ch),
+                         dot_flag ? par.num2 : 6, &par);
                 Check = 1;
                 break;
+#endif
 
             case 's':
                 outs(va_arg(ap, char *), &par);
@@ -435,8 +810,9 @@ static int rtos_vsnwprintf(char *str, size_t size, int writeout, const char *fmt
         goto try_next;
     }
 
-    if (par.pos < par.size) {
-        par.str[par.pos] = '\0';
+    /* Terminated even when truncated, as vsnprintf. */
+    if (par.size > 0) {
+        par.str[par.pos < par.size ? par.pos : par.size - 1] = '\0';
     }
 
     return par.pos;
@@ -455,6 +831,11 @@ int rtos_snprintf(char *str, size_t size, const char *fmt, ...)
     return len;
 }
 
+int rtos_vsnprintf(char *str, size_t size, const char *fmt, va_list ap)
+{
+    return rtos_vsnwprintf(str, size, 0, fmt, ap);
+}
+
 int rtos_sprintf(char *str, const char *fmt, ...)
 {
     int len;
@@ -43,13 +43,13 @@ unsigned int extract_ie_code(unsigned int num)
 {
 	unsigned int exception_code;
 
-	log_trace("\nextract_ie_code entered\n");
+	log_isr_trace("\nextract_ie_code entered\n");
 
 	exception_code = (num & 0X7FFFFFFF);
 
-	log_debug("exception code = %x\n",exception_code);
+	log_isr_debug("exception code = %x\n",exception_code);
 
-	log_trace("extract_ie_code exited\n");
+	log_isr_trace("extract_ie_code exited\n");
 
 	return exception_code;
 }
@@ -81,7 +81,7 @@ uintptr_t handle_trap(uintptr_t mcause, uintptr_t epc)
 	unsigned int ie_entry = 0;;
 	uint32_t shift_length = 0;
 
-	log_trace("\nhandle_trap entered\n");
+	log_isr_trace("\nhandle_trap entered\n");
 
 	/*
 	   risc v priv spec v1.10 section 3.1.20 Machine Cause Register (mcause)
@@ -97,31 +97,31 @@ uintptr_t handle_trap(uintptr_t mcause, uintptr_t epc)
 	   Otherwise, mcause is never written by the implementation, though it may be explicitly written by software.
 	 */
 
-	log_info("mcause = %x, epc = %x\n", mcause, epc);
+	log_isr_info("mcause = %x, epc = %x\n", mcause, epc);
 
 	/*
 	   The Interrupt bit in the mcause register is set if the trap was caused by an interrupt.
 	   The Exception Code field contains a code identifying the last exception
 	 */
 
-	log_debug("sizeof(uintptr)  = %d \n",sizeof(uintptr_t));
+	log_isr_debug("sizeof(uintptr)  = %d \n",sizeof(uintptr_t));
 	shift_length = __riscv_xlen - 1;
 
 	if (mcause & (1 << (shift_length))){
 
 		ie_entry = extract_ie_code(mcause);
 
-		log_debug("Source of Trap: Interrupt\n");
+		log_isr_debug("Source of Trap: Interrupt\n");
 
 		mcause_interrupt_table[ie_entry](mcause, epc);
 	}
 	else{
-		log_debug("Source of Trap: Software\n");
+		log_isr_debug("Source of Trap: Software\n");
 
 		mcause_trap_table[mcause](mcause, epc);
 	}
 
-	log_trace("handle_trap exited\n");
+	log_isr_trace("handle_trap exited\n");
 
 return epc;
 }
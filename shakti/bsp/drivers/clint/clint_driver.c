@@ -41,7 +41,7 @@ uint32_t* mtimecmp = 0x02004000;
  */
 static unsigned long mtime_low(void)
 {
-  return *(volatile unsigned long *)(CLINT_BASE + MTIME);
+  return *(volatile unsigned long *)(MTIME);
 }
 
 /*
@@ -56,12 +56,12 @@ Get each 32 bit and append for full timer value
  */
 static uint32_t mtime_high(void)
 {
-  return *(volatile uint32_t *)(CLINT_BASE + MTIME + 4);
+  return *(volatile uint32_t *)(MTIME + 4);
 }
 
 /** @fn uint64_t get_timer_value()
  * @brief return the mtime value for a 32 bit or 64 bit machine
- * @details return the mtime value based on the __riscv_xlen. Incase of 64 bit, this joins the upper
+ * @details return the mtime value based on the __riscv_xlen. Incase of 32 bit, this joins the upper
  *          and lower 32 bits of mtime and return
  * @return unsigned 64bit int
  */
@@ -69,7 +69,17 @@ uint64_t get_timer_value()
 {
 
 #if __riscv_xlen == 32
-   return ( ((uint64_t)mtime_high() << 32) | mtime_low());
+  uint32_t high;
+  unsigned long low;
+
+  /* read again if the low word carried into the high one in between */
+  do
+  {
+    high = mtime_high();
+    low = mtime_low();
+  } while (high != mtime_high());
+
+  return ( ((uint64_t)high << 32) | low);
 #else
   return mtime_low();
 #endif
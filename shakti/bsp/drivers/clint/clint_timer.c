@@ -0,0 +1,470 @@
+/***************************************************************************
+ * Project                               :  shakti devt board
+ * Name of the file                      :  clint_timer.c
+ * Brief Description of file             :  Delays, sleeps and alarms timed by the clint's mtime.
+ * Name of Author                        :
+ * Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+ * @file clint_timer.c
+ * @brief Delays, sleeps and alarms timed by the clint's mtime.
+ * @detail waitfor() and delay_loop() count loop turns, whose length changes
+ * with the core clock, the caches and the optimisation level. mtime counts
+ * at CLINT_MTIME_HZ on every build. Delays of more than CLINT_TIMER_SPIN_US
+ * wait for mtime to reach a deadline. Shorter ones count mcycle, for a
+ * resolution finer than an mtime tick, at the core clock timer_init()
+ * measured against mtime; before timer_init() they take CLOCK_FREQUENCY.
+ *
+ * Without CLINT_TIMER_FREERTOS the alarms own mtimecmp: it holds the
+ * deadline of the first alarm, and the machine timer interrupt calls the
+ * alarms that are due. With CLINT_TIMER_FREERTOS the kernel's tick owns
+ * mtimecmp; timer_alarm_tick(), called from vApplicationTickHook(), calls
+ * the alarms instead, at the first tick at or after their deadline, and
+ * timer_sleep_us() gives the whole ticks of a sleep to other tasks.
+ */
+
+#include "clint_timer.h"
+#include "defines.h"
+#include "traps.h"
+#ifdef CLINT_TIMER_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
+/* mtime and mtimecmp. A platform may define its own accessors. */
+#ifndef clint_read32
+#define clint_read32(addr)		(*(volatile uint32_t *) (uintptr_t) (addr))
+#define clint_write32(addr, value)	(*(volatile uint32_t *) (uintptr_t) (addr) = (value))
+#define clint_read64(addr)		(*(volatile uint64_t *) (uintptr_t) (addr))
+#define clint_write64(addr, value)	(*(volatile uint64_t *) (uintptr_t) (addr) = (value))
+#endif
+
+/* mtime ticks per us, and core cycles per ns rounded up, in Q32 */
+#define US_TO_TICKS_Q32		((((uint64_t) CLINT_MTIME_HZ) << 32) / 1000000)
+#define NS_TO_CYCLES_Q32(hz)	((uint32_t) (((((uint64_t) (hz)) << 32) + 999999999) / 1000000000))
+
+#ifdef CLINT_TIMER_FREERTOS
+#define TICKS_PER_KERNEL_TICK	(CLINT_MTIME_HZ / configTICK_RATE_HZ)
+#endif
+
+static uint32_t cpu_hz = CLOCK_FREQUENCY;
+static uint32_t ns_to_cycles = NS_TO_CYCLES_Q32(CLOCK_FREQUENCY);
+static timer_alarm_t *alarm_head;	/* pending alarms, the first due first */
+static timer_stats_t timer_stats;
+
+/** @fn static uintptr_t timer_irq_save(void)
+ * @brief disables interrupts
+ * @return nonzero if they were enabled
+ */
+static uintptr_t timer_irq_save(void)
+{
+	uintptr_t state = read_csr(mstatus) & MSTATUS_MIE;
+
+	clear_csr(mstatus, MSTATUS_MIE);
+
+	return state;
+}
+
+/** @fn static void timer_irq_restore(uintptr_t state)
+ * @brief enables interrupts again if timer_irq_save found them enabled
+ */
+static void timer_irq_restore(uintptr_t state)
+{
+	if (state)
+		set_csr(mstatus, MSTATUS_MIE);
+}
+
+/** @fn uint64_t timer_now(void)
+ * @brief reads mtime
+ * @details On rv32 the high word is read again after the low word, and
+ *          the pair read again if it changed, as the low word carried into
+ *          it in between.
+ * @return mtime
+ */
+uint64_t timer_now(void)
+{
+#if __riscv_xlen == 32
+	uint32_t hi, lo;
+
+	do
+	{
+		hi = clint_read32(MTIME + 4);
+		lo = clint_read32(MTIME);
+	} while (hi != clint_read32(MTIME + 4));
+
+	return ((uint64_t) hi << 32) | lo;
+#else
+	return clint_read64(MTIME);
+#endif
+}
+
+#ifndef CLINT_TIMER_FREERTOS
+/** @fn static void timer_set_mtimecmp(uint64_t value)
+ * @brief sets mtimecmp
+ * @details On rv32 the low word is set to all ones first, so that no
+ *          value between the old and the new one raises the interrupt.
+ */
+static void timer_set_mtimecmp(uint64_t value)
+{
+#if __riscv_xlen == 32
+	clint_write32(MTIMECMP, 0xFFFFFFFFU);
+	clint_write32(MTIMECMP + 4, (uint32_t) (value >> 32));
+	clint_write32(MTIMECMP, (uint32_t) value);
+#else
+	clint_write64(MTIMECMP, value);
+#endif
+}
+#endif
+
+/** @fn static void timer_alarm_run(void)
+ * @brief calls the alarms that are due
+ * @details Runs with interrupts disabled. An alarm may start itself again
+ *          from its function.
+ */
+static void timer_alarm_run(void)
+{
+	timer_alarm_t *alarm;
+	uint64_t now = timer_now();
+	uint64_t late;
+
+	while ((alarm = alarm_head) != NULL && (int64_t) (now - alarm->deadline) >= 0)
+	{
+		alarm_head = alarm->next;
+		alarm->next = NULL;
+		alarm->pending = 0;
+
+		late = now - alarm->deadline;
+		if (late > timer_stats.max_late)
+			timer_stats.max_late = late > UINT32_MAX ? UINT32_MAX : (uint32_t) late;
+		timer_stats.fired++;
+
+		alarm->fn(alarm->arg);
+		now = timer_now();
+	}
+
+#ifndef CLINT_TIMER_FREERTOS
+	timer_set_mtimecmp(alarm_head ? alarm_head->deadline : UINT64_MAX);
+#endif
+}
+
+#ifndef CLINT_TIMER_FREERTOS
+/** @fn static void timer_mach_handler(uintptr_t int_id, uintptr_t epc)
+ * @brief handler for the machine timer interrupt
+ */
+static void timer_mach_handler(__attribute__((unused)) uintptr_t int_id,
+			       __attribute__((unused)) uintptr_t epc)
+{
+	timer_alarm_run();
+}
+#endif
+
+/** @fn void timer_init(void)
+ * @brief measures the core clock against mtime
+ * @details Counts mcycle over CLINT_TIMER_CALIBRATE_TICKS of mtime, from
+ *          one tick edge to another, with interrupts disabled. Without
+ *          CLINT_TIMER_FREERTOS it also takes the machine timer interrupt
+ *          for the alarms. Call it once, before the scheduler starts.
+ */
+void timer_init(void)
+{
+	uintptr_t irq = timer_irq_save();
+	uint64_t start, now;
+	uintptr_t c0, c1, read;
+
+	start = timer_now();
+	while ((now = timer_now()) == start)
+		;
+
+	c0 = read_csr(mcycle);
+	start = now;
+	while (timer_now() - start < CLINT_TIMER_CALIBRATE_TICKS)
+		;
+	c1 = read_csr(mcycle);
+
+	/* Either edge may be seen up to one read of mtime late. Count one read
+	 * more, so that the clock, and so ndelay(), is never short. */
+	timer_now();
+	read = read_csr(mcycle) - c1;
+
+	cpu_hz = (uint32_t) (((uint64_t) (uint32_t) (c1 - c0 + read) * CLINT_MTIME_HZ +
+			      CLINT_TIMER_CALIBRATE_TICKS - 1) / CLINT_TIMER_CALIBRATE_TICKS);
+	ns_to_cycles = NS_TO_CYCLES_Q32(cpu_hz);
+
+#ifndef CLINT_TIMER_FREERTOS
+	timer_set_mtimecmp(alarm_head ? alarm_head->deadline : UINT64_MAX);
+	mcause_interrupt_table[MACH_TIMER_INTERRUPT] = timer_mach_handler;
+	set_csr(mie, MIE_MTIE);
+#endif
+
+	timer_irq_restore(irq);
+}
+
+/** @fn uint32_t timer_cpu_hz(void)
+ * @brief returns the core clock timer_init() measured
+ */
+uint32_t timer_cpu_hz(void)
+{
+	return cpu_hz;
+}
+
+/** @fn uint64_t timer_us_to_ticks(uint32_t us)
+ * @brief converts microseconds to mtime ticks, rounding up
+ */
+uint64_t timer_us_to_ticks(uint32_t us)
+{
+	return (uint64_t) us * (US_TO_TICKS_Q32 >> 32) +
+	       (((uint64_t) us * (uint32_t) US_TO_TICKS_Q32 + 0xFFFFFFFFU) >> 32);
+}
+
+/** @fn static void timer_wait_until(uint64_t deadline)
+ * @brief spins until mtime reaches deadline
+ */
+static void timer_wait_until(uint64_t deadline)
+{
+	while ((int64_t) (timer_now() - deadline) < 0)
+		;
+}
+
+/** @fn void ndelay(uint32_t ns)
+ * @brief spins for at least ns nanoseconds, counting mcycle
+ * @details On rv32 mcycle is read 32 bits wide, which covers delays up
+ *          to 2^32 cycles, the whole range of ns below 1 GHz.
+ */
+void ndelay(uint32_t ns)
+{
+	uintptr_t start = read_csr(mcycle);
+	uintptr_t cycles = (uintptr_t) (((uint64_t) ns * ns_to_cycles + 0xFFFFFFFFU) >> 32);
+
+	while (read_csr(mcycle) - start < cycles)
+		;
+}
+
+/** @fn void udelay(uint32_t us)
+ * @brief spins for at least us microseconds
+ * @details Up to CLINT_TIMER_SPIN_US counts mcycle, longer waits for mtime.
+ *          A wait for mtime takes up to a tick more, as the first tick may
+ *          be a part of one.
+ */
+void udelay(uint32_t us)
+{
+	if (us <= CLINT_TIMER_SPIN_US)
+	{
+		ndelay(us * 1000);
+		return;
+	}
+
+	timer_wait_until(timer_now() + timer_us_to_ticks(us) + 1);
+}
+
+/** @fn void mdelay(uint32_t ms)
+ * @brief spins for at least ms milliseconds, waiting for mtime
+ */
+void mdelay(uint32_t ms)
+{
+	timer_wait_until(timer_now() + (uint64_t) ms * timer_us_to_ticks(1000) + 1);
+}
+
+#ifdef CLINT_TIMER_FREERTOS
+/** @fn static int timer_can_block(void)
+ * @brief tells whether the caller is a task that may sleep
+ */
+static int timer_can_block(void)
+{
+	return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING &&
+	       (read_csr(mstatus) & MSTATUS_MIE);
+}
+#endif
+
+/** @fn static void timer_sleep_until(uint64_t deadline)
+ * @brief sleeps until mtime reaches deadline
+ * @details With CLINT_TIMER_FREERTOS a task sleeps in vTaskDelay() for
+ *          each whole tick left, which can wake it no later than the
+ *          deadline, and spins for the rest. Before the scheduler starts,
+ *          with interrupts disabled, or in a bare metal build, it spins.
+ */
+static void timer_sleep_until(uint64_t deadline)
+{
+#ifdef CLINT_TIMER_FREERTOS
+	uint64_t left;
+
+	if (timer_can_block())
+	{
+		for (;;)
+		{
+			left = deadline - timer_now();
+			if ((int64_t) left < (int64_t) TICKS_PER_KERNEL_TICK)
+				break;
+			if (left > UINT32_MAX)
+				left = UINT32_MAX;
+
+			timer_stats.yields++;
+			vTaskDelay((TickType_t) ((uint32_t) left / TICKS_PER_KERNEL_TICK));
+		}
+	}
+#endif
+
+	timer_wait_until(deadline);
+}
+
+/** @fn void timer_sleep_us(uint32_t us)
+ * @brief sleeps for at least us microseconds
+ * @details Up to CLINT_TIMER_SPIN_US it is a udelay().
+ */
+void timer_sleep_us(uint32_t us)
+{
+	if (us <= CLINT_TIMER_SPIN_US)
+	{
+		udelay(us);
+		return;
+	}
+
+	timer_sleep_until(timer_now() + timer_us_to_ticks(us) + 1);
+}
+
+/** @fn void timer_sleep_ms(uint32_t ms)
+ * @brief sleeps for at least ms milliseconds
+ */
+void timer_sleep_ms(uint32_t ms)
+{
+	timer_sleep_until(timer_now() + (uint64_t) ms * timer_us_to_ticks(1000) + 1);
+}
+
+/** @fn void timer_alarm_init(timer_alarm_t *alarm, timer_alarm_fn fn, void *arg)
+ * @brief sets up an alarm to call fn(arg)
+ * @details fn is called from an interrupt: the machine timer's, or with
+ *          CLINT_TIMER_FREERTOS the tick's, so it may only use the
+ *          FromISR calls.
+ */
+void timer_alarm_init(timer_alarm_t *alarm, timer_alarm_fn fn, void *arg)
+{
+	alarm->deadline = 0;
+	alarm->fn = fn;
+	alarm->arg = arg;
+	alarm->next = NULL;
+	alarm->pending = 0;
+}
+
+/** @fn static int timer_alarm_unlink(timer_alarm_t *alarm)
+ * @brief takes an alarm off the pending list, with interrupts disabled
+ * @return 1 if it was pending
+ */
+static int timer_alarm_unlink(timer_alarm_t *alarm)
+{
+	timer_alarm_t **link;
+
+	if (!alarm->pending)
+		return 0;
+
+	for (link = &alarm_head; *link != NULL; link = &(*link)->next)
+	{
+		if (*link == alarm)
+		{
+			*link = alarm->next;
+			break;
+		}
+	}
+
+	alarm->next = NULL;
+	alarm->pending = 0;
+
+	return 1;
+}
+
+/** @fn void timer_alarm_start_at(timer_alarm_t *alarm, uint64_t deadline)
+ * @brief calls the alarm once mtime reaches deadline
+ * @details An alarm that is pending is moved. A deadline that has passed
+ *          calls it as soon as interrupts are enabled. For a periodic
+ *          alarm, start it again from its function at its last deadline
+ *          and the period, which does not drift.
+ */
+void timer_alarm_start_at(timer_alarm_t *alarm, uint64_t deadline)
+{
+	uintptr_t irq = timer_irq_save();
+	timer_alarm_t **link;
+
+	timer_alarm_unlink(alarm);
+	alarm->deadline = deadline;
+
+	/* after the alarms due at the same time, so they run in the order set */
+	for (link = &alarm_head; *link != NULL && (int64_t) ((*link)->deadline - deadline) <= 0;
+	     link = &(*link)->next)
+		;
+
+	alarm->next = *link;
+	*link = alarm;
+	alarm->pending = 1;
+
+#ifndef CLINT_TIMER_FREERTOS
+	timer_set_mtimecmp(alarm_head->deadline);
+#endif
+
+	timer_irq_restore(irq);
+}
+
+/** @fn void timer_alarm_start(timer_alarm_t *alarm, uint32_t us)
+ * @brief calls the alarm at least us microseconds from now
+ */
+void timer_alarm_start(timer_alarm_t *alarm, uint32_t us)
+{
+	timer_alarm_start_at(alarm, timer_now() + timer_us_to_ticks(us) + 1);
+}
+
+/** @fn int timer_alarm_cancel(timer_alarm_t *alarm)
+ * @brief stops an alarm that has not been called
+ * @return 1 if it was pending, 0 if it had been called or never started
+ */
+int timer_alarm_cancel(timer_alarm_t *alarm)
+{
+	uintptr_t irq = timer_irq_save();
+	int pending = timer_alarm_unlink(alarm);
+
+#ifndef CLINT_TIMER_FREERTOS
+	if (pending)
+		timer_set_mtimecmp(alarm_head ? alarm_head->deadline : UINT64_MAX);
+#endif
+
+	timer_irq_restore(irq);
+
+	return pending;
+}
+
+/** @fn void timer_alarm_tick(void)
+ * @brief calls the alarms that are due, from vApplicationTickHook()
+ * @details Needed with CLINT_TIMER_FREERTOS only, where the alarms are
+ *          called at the tick.
+ */
+void timer_alarm_tick(void)
+{
+	uintptr_t irq = timer_irq_save();
+
+	timer_alarm_run();
+
+	timer_irq_restore(irq);
+}
+
+/** @fn void timer_get_stats(timer_stats_t *stats)
+ * @brief copies the alarm and sleep counts
+ */
+void timer_get_stats(timer_stats_t *stats)
+{
+	uintptr_t irq = timer_irq_save();
+
+	*stats = timer_stats;
+
+	timer_irq_restore(irq);
+}
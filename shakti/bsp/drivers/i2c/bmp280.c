@@ -0,0 +1,402 @@
+/***************************************************************************
+ * Project                               :  shakti devt board
+ * Name of the file                      :  bmp280.c
+ * Brief Description of file             :  Driver and sampling task for the bmp280 sensor.
+ * Name of Author                        :
+ * Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+ * @file bmp280.c
+ * @brief Driver and sampling task for the bmp280 sensor.
+ * @detail Register reads are one transaction for any number of consecutive
+ * registers: i2c_transfer with I2C_ASYNC, or the polled sequence of the
+ * demos otherwise. bmp280_init() checks the chip id, resets the sensor,
+ * reads its calibration and programs the oversampling, filter and mode.
+ * bmp280_read_sample() reads the 6 adc bytes and compensates them with
+ * bmp280_compensate.c.
+ *
+ * With BMP280_FREERTOS, bmp280_start_task() creates a task that takes a
+ * sample every period and sends it to a queue without blocking. In forced
+ * mode the task starts each measurement and sleeps for the datasheet's
+ * longest measurement time before reading it; in normal mode the sensor
+ * measures on its own and the task reads the latest result.
+ */
+
+#include "i2c.h"
+#include "bmp280.h"
+#include "utils.h"
+#include "log.h"
+#if defined(BMP280_FREERTOS) || defined(I2C_FREERTOS)
+#include "FreeRTOS.h"
+#endif
+#ifdef BMP280_FREERTOS
+#include "task.h"
+#include "queue.h"
+#endif
+
+#ifdef I2C_ASYNC
+/* Ticks an i2c_transfer may wait, queued and running */
+#ifndef BMP280_I2C_TIMEOUT
+#ifdef I2C_FREERTOS
+#define BMP280_I2C_TIMEOUT	pdMS_TO_TICKS(100)
+#else
+#define BMP280_I2C_TIMEOUT	I2C_WAIT_FOREVER
+#endif
+#endif
+#else
+/* waitfor() delay the polled calls take, as in the demos */
+#define BMP280_I2C_DELAY	100
+#endif
+
+/**
+ * @fn static int bmp280_read_regs(bmp280_t *dev, uint8_t reg, uint8_t *buf, unsigned int len)
+ * @brief reads len consecutive registers from reg on in one transaction
+ * @return zero on success, else the error of the i2c driver
+ */
+static int bmp280_read_regs(bmp280_t *dev, uint8_t reg, uint8_t *buf, unsigned int len)
+{
+	i2c_struct *instance = (i2c_struct *) dev->i2c;
+#ifdef I2C_ASYNC
+	i2c_xfer_t xfer = { 0 };
+
+	xfer.slave_address = dev->address;
+	xfer.reg = reg;
+	xfer.read_data = buf;
+	xfer.read_len = len;
+
+	return i2c_transfer(instance, &xfer, BMP280_I2C_TIMEOUT);
+#else
+	unsigned char dummy;
+	unsigned int i;
+	int ret;
+
+	ret = i2c_send_slave_address(instance, dev->address, I2C_WRITE, 800);
+	if (ret)
+		return ret;
+
+	ret = i2c_write_data(instance, reg, BMP280_I2C_DELAY);
+	if (ret)
+		return ret;
+
+	i2c_set_reg(instance, control, I2C_STOP);
+
+	ret = i2c_send_slave_address(instance, dev->address, I2C_READ, 800);
+	if (ret)
+		return ret;
+
+	/* Make a dummy read as per spec of the I2C controller */
+	i2c_read_data(instance, &dummy, BMP280_I2C_DELAY);
+
+	for (i = 0; i < len; i++)
+	{
+		if (i == len - 1)
+			i2c_set_reg(instance, control, I2C_NACK);
+
+		i2c_read_data(instance, &buf[i], BMP280_I2C_DELAY);
+	}
+
+	i2c_set_reg(instance, control, I2C_STOP);
+
+	return I2C_SUCCESS;
+#endif
+}
+
+/**
+ * @fn static int bmp280_write_reg(bmp280_t *dev, uint8_t reg, uint8_t value)
+ * @brief writes one register
+ * @return zero on success, else the error of the i2c driver
+ */
+static int bmp280_write_reg(bmp280_t *dev, uint8_t reg, uint8_t value)
+{
+	i2c_struct *instance = (i2c_struct *) dev->i2c;
+#ifdef I2C_ASYNC
+	i2c_xfer_t xfer = { 0 };
+
+	xfer.slave_address = dev->address;
+	xfer.reg = reg;
+	xfer.write_data = &value;
+	xfer.write_len = 1;
+
+	return i2c_transfer(instance, &xfer, BMP280_I2C_TIMEOUT);
+#else
+	int ret;
+
+	ret = i2c_send_slave_address(instance, dev->address, I2C_WRITE, BMP280_I2C_DELAY);
+	if (ret)
+		return ret;
+
+	ret = i2c_write_data(instance, reg, BMP280_I2C_DELAY);
+	if (ret == I2C_SUCCESS)
+		ret = i2c_write_data(instance, value, BMP280_I2C_DELAY);
+
+	i2c_set_reg(instance, control, I2C_STOP);
+
+	return ret;
+#endif
+}
+
+/**
+ * @fn static uint8_t bmp280_ctrl_meas(const bmp280_config_t *config, uint8_t mode)
+ * @brief returns the ctrl_meas value for a config and a mode
+ */
+static uint8_t bmp280_ctrl_meas(const bmp280_config_t *config, uint8_t mode)
+{
+	return (uint8_t) ((config->osrs_t << 5) | (config->osrs_p << 2) | mode);
+}
+
+/**
+ * @fn uint32_t bmp280_measure_time_us(const bmp280_config_t *config)
+ * @brief returns the longest time a measurement takes, from section 3.8.1
+ *        of the datasheet
+ */
+uint32_t bmp280_measure_time_us(const bmp280_config_t *config)
+{
+	uint32_t t_os = config->osrs_t ? 1U << (config->osrs_t - 1) : 0;
+	uint32_t p_os = config->osrs_p ? 1U << (config->osrs_p - 1) : 0;
+	uint32_t us = 1250 + 2300 * t_os;
+
+	if (p_os)
+		us += 2300 * p_os + 575;
+
+	return us;
+}
+
+/**
+ * @fn int bmp280_init(bmp280_t *dev, void *i2c, const bmp280_config_t *config)
+ * @brief finds, resets and configures a bmp280
+ * @details The i2c controller must already be configured, and made
+ *          asynchronous if the driver was built with I2C_ASYNC. Both
+ *          oversampling rates must be at least BMP280_OSRS_X1. In normal
+ *          mode the sensor starts measuring before this returns; in forced
+ *          mode it sleeps until bmp280_start_measurement().
+ * @param bmp280_t* dev
+ * @param void* i2c --- i2c_struct of the bus
+ * @param const bmp280_config_t* config
+ * @return BMP280_SUCCESS, EBMP280_CONFIG, EBMP280_NO_DEVICE if the chip id
+ *         is wrong, EBMP280_BUSY if the calibration never loaded, or the
+ *         error of the i2c driver
+ */
+int bmp280_init(bmp280_t *dev, void *i2c, const bmp280_config_t *config)
+{
+	uint8_t calib[BMP280_CALIB_LEN];
+	uint8_t value = 0;
+	int polls;
+	int ret;
+
+	if (config->osrs_t == BMP280_OSRS_SKIP || config->osrs_t > BMP280_OSRS_X16 ||
+	    config->osrs_p == BMP280_OSRS_SKIP || config->osrs_p > BMP280_OSRS_X16 ||
+	    config->filter > BMP280_FILTER_16 || config->standby > BMP280_STANDBY_4000_MS ||
+	    (config->mode != BMP280_MODE_FORCED && config->mode != BMP280_MODE_NORMAL))
+		return EBMP280_CONFIG;
+
+	dev->i2c = i2c;
+	dev->address = BMP280_I2C_ADDRESS;
+	dev->config = *config;
+	dev->stats.samples = dev->stats.errors = dev->stats.not_ready = dev->stats.dropped = 0;
+	dev->queue = dev->task = 0;
+
+	ret = bmp280_read_regs(dev, BMP280_REG_ID, &value, 1);
+	if (ret)
+		return ret;
+
+	if (value != BMP280_CHIP_ID)
+	{
+		log_error("bmp280: chip id 0x%x\n", value);
+		return EBMP280_NO_DEVICE;
+	}
+
+	ret = bmp280_write_reg(dev, BMP280_REG_RESET, BMP280_RESET_VALUE);
+	if (ret)
+		return ret;
+
+	/* im_update is set while the calibration is copied from the NVM */
+	for (polls = 0; ; polls++)
+	{
+		if (polls == BMP280_STATUS_POLLS)
+			return EBMP280_BUSY;
+
+		ret = bmp280_read_regs(dev, BMP280_REG_STATUS, &value, 1);
+		if (ret)
+			return ret;
+
+		if (!(value & BMP280_STATUS_IM_UPDATE))
+			break;
+	}
+
+	ret = bmp280_read_regs(dev, BMP280_REG_CALIB, calib, BMP280_CALIB_LEN);
+	if (ret)
+		return ret;
+
+	bmp280_parse_calib(&dev->calib, calib);
+
+	/* config is only taken in sleep mode, which the reset left */
+	ret = bmp280_write_reg(dev, BMP280_REG_CONFIG,
+			       (uint8_t) ((config->standby << 5) | (config->filter << 2)));
+	if (ret)
+		return ret;
+
+	return bmp280_write_reg(dev, BMP280_REG_CTRL_MEAS,
+				bmp280_ctrl_meas(config, config->mode == BMP280_MODE_NORMAL ?
+						 BMP280_MODE_NORMAL : BMP280_MODE_SLEEP));
+}
+
+/**
+ * @fn int bmp280_start_measurement(bmp280_t *dev)
+ * @brief starts a forced mode measurement
+ * @details Does nothing in normal mode. The result can be read after
+ *          bmp280_measure_time_us().
+ * @return zero on success, else the error of the i2c driver
+ */
+int bmp280_start_measurement(bmp280_t *dev)
+{
+	int ret;
+
+	if (dev->config.mode != BMP280_MODE_FORCED)
+		return BMP280_SUCCESS;
+
+	ret = bmp280_write_reg(dev, BMP280_REG_CTRL_MEAS,
+			       bmp280_ctrl_meas(&dev->config, BMP280_MODE_FORCED));
+	if (ret)
+		dev->stats.errors++;
+
+	return ret;
+}
+
+/**
+ * @fn int bmp280_read_sample(bmp280_t *dev, bmp280_sample_t *sample)
+ * @brief reads and compensates the latest measurement
+ * @details The pressure and temperature registers are read together, so
+ *          the sensor's shadowing keeps them from the same measurement.
+ * @return BMP280_SUCCESS, EBMP280_NO_DATA if no measurement has completed
+ *         since the reset, or the error of the i2c driver
+ */
+int bmp280_read_sample(bmp280_t *dev, bmp280_sample_t *sample)
+{
+	uint8_t raw[BMP280_DATA_LEN];
+	int ret;
+
+	ret = bmp280_read_regs(dev, BMP280_REG_DATA, raw, BMP280_DATA_LEN);
+	if (ret)
+	{
+		dev->stats.errors++;
+		return ret;
+	}
+
+	ret = bmp280_compensate(&dev->calib, raw, sample);
+	if (ret)
+	{
+		dev->stats.not_ready++;
+		return ret;
+	}
+
+	dev->stats.samples++;
+
+	return BMP280_SUCCESS;
+}
+
+#ifdef BMP280_FREERTOS
+/* Normal mode standby times in us, by t_sb */
+static const uint32_t bmp280_standby_us[8] =
+{
+	500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000
+};
+
+/**
+ * @fn static TickType_t bmp280_us_to_ticks(uint32_t us)
+ * @brief converts a time to ticks, rounding up, and at least one
+ */
+static TickType_t bmp280_us_to_ticks(uint32_t us)
+{
+	uint64_t ticks = ((uint64_t) us * configTICK_RATE_HZ + 999999) / 1000000;
+
+	return ticks ? (TickType_t) ticks : 1;
+}
+
+/**
+ * @fn static void bmp280_task(void *param)
+ * @brief takes samples of a bmp280 every period and sends them to its queue
+ */
+static void bmp280_task(void *param)
+{
+	bmp280_t *dev = (bmp280_t *) param;
+	uint32_t measure_us = bmp280_measure_time_us(&dev->config);
+	TickType_t measure = bmp280_us_to_ticks(measure_us);
+	TickType_t period;
+	TickType_t last_wake;
+	bmp280_sample_t sample;
+
+	if (dev->config.period_ms)
+		period = bmp280_us_to_ticks(dev->config.period_ms * 1000);
+	else if (dev->config.mode == BMP280_MODE_NORMAL)
+		period = bmp280_us_to_ticks(measure_us + bmp280_standby_us[dev->config.standby]);
+	else
+		period = measure + 1;
+
+	last_wake = xTaskGetTickCount();
+
+	for (;;)
+	{
+		if (dev->config.mode == BMP280_MODE_FORCED)
+		{
+			if (bmp280_start_measurement(dev) == BMP280_SUCCESS)
+			{
+				/* A delay of n ticks can end up to a tick early */
+				vTaskDelay(measure + 1);
+			}
+		}
+
+		if (bmp280_read_sample(dev, &sample) == BMP280_SUCCESS)
+		{
+			sample.tick = (uint32_t) xTaskGetTickCount();
+
+			if (xQueueSend((QueueHandle_t) dev->queue, &sample, 0) != pdPASS)
+				dev->stats.dropped++;
+		}
+
+		vTaskDelayUntil(&last_wake, period);
+	}
+}
+
+/**
+ * @fn int bmp280_start_task(bmp280_t *dev, void *queue, unsigned long priority, unsigned short stack_depth)
+ * @brief creates the task that samples an initialised bmp280
+ * @details Samples go to the queue, whose items must be bmp280_sample_t,
+ *          and are dropped and counted when it is full. A period_ms of zero
+ *          samples as often as the mode allows: once per longest
+ *          measurement time in forced mode, once per measurement and
+ *          standby time in normal mode.
+ * @param bmp280_t* dev
+ * @param void* queue --- QueueHandle_t
+ * @param unsigned long priority
+ * @param unsigned short stack_depth --- in words
+ * @return BMP280_SUCCESS, or EBMP280_CONFIG if the task was not created
+ */
+int bmp280_start_task(bmp280_t *dev, void *queue, unsigned long priority, unsigned short stack_depth)
+{
+	TaskHandle_t task;
+
+	dev->queue = queue;
+
+	if (xTaskCreate(bmp280_task, "bmp280", stack_depth, dev, (UBaseType_t) priority, &task) != pdPASS)
+		return EBMP280_CONFIG;
+
+	dev->task = task;
+
+	return BMP280_SUCCESS;
+}
+#endif
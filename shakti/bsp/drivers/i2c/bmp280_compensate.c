@@ -0,0 +1,176 @@
+/***************************************************************************
+ * Project                               :  shakti devt board
+ * Name of the file                      :  bmp280_compensate.c
+ * Brief Description of file             :  Integer compensation of bmp280 readings.
+ * Name of Author                        :
+ * Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+ * @file bmp280_compensate.c
+ * @brief Integer compensation of bmp280 readings.
+ * @detail The formulas of section 8.2 of the BMP280 datasheet: temperature
+ * in 32 bit integers, pressure in 64 bit integers, or in 32 bit integers
+ * for harts without a 64 bit divide. The E class cores have no FPU, so the
+ * datasheet's floating point formulas would run in soft float. Left shifts
+ * of values that can be negative are written as multiplications, which
+ * give the same result without being undefined in C. Right shifts are
+ * arithmetic, as with gcc.
+ */
+
+#include "bmp280.h"
+
+/**
+ * @fn void bmp280_parse_calib(bmp280_calib_t *calib, const uint8_t raw[BMP280_CALIB_LEN])
+ * @brief decodes the trimming values read from 0x88 to 0x9F
+ * @details Each value is 16 bits, least significant byte first.
+ */
+void bmp280_parse_calib(bmp280_calib_t *calib, const uint8_t raw[BMP280_CALIB_LEN])
+{
+	calib->dig_T1 = (uint16_t) ((raw[1] << 8) | raw[0]);
+	calib->dig_T2 = (int16_t) ((raw[3] << 8) | raw[2]);
+	calib->dig_T3 = (int16_t) ((raw[5] << 8) | raw[4]);
+	calib->dig_P1 = (uint16_t) ((raw[7] << 8) | raw[6]);
+	calib->dig_P2 = (int16_t) ((raw[9] << 8) | raw[8]);
+	calib->dig_P3 = (int16_t) ((raw[11] << 8) | raw[10]);
+	calib->dig_P4 = (int16_t) ((raw[13] << 8) | raw[12]);
+	calib->dig_P5 = (int16_t) ((raw[15] << 8) | raw[14]);
+	calib->dig_P6 = (int16_t) ((raw[17] << 8) | raw[16]);
+	calib->dig_P7 = (int16_t) ((raw[19] << 8) | raw[18]);
+	calib->dig_P8 = (int16_t) ((raw[21] << 8) | raw[20]);
+	calib->dig_P9 = (int16_t) ((raw[23] << 8) | raw[22]);
+}
+
+/**
+ * @fn int32_t bmp280_compensate_temperature(const bmp280_calib_t *calib, int32_t adc_T, int32_t *t_fine)
+ * @brief compensates a temperature reading
+ * @param int32_t adc_T --- 20 bit reading
+ * @param int32_t* t_fine --- set to the fine temperature the pressure
+ *        formulas take
+ * @return the temperature in 0.01 degree Celsius
+ */
+int32_t bmp280_compensate_temperature(const bmp280_calib_t *calib, int32_t adc_T, int32_t *t_fine)
+{
+	int32_t var1, var2, t;
+
+	var1 = ((((adc_T >> 3) - ((int32_t) calib->dig_T1 << 1))) * ((int32_t) calib->dig_T2)) >> 11;
+	var2 = (((((adc_T >> 4) - ((int32_t) calib->dig_T1)) *
+		  ((adc_T >> 4) - ((int32_t) calib->dig_T1))) >> 12) * ((int32_t) calib->dig_T3)) >> 14;
+	t = var1 + var2;
+	*t_fine = t;
+
+	return (t * 5 + 128) >> 8;
+}
+
+/**
+ * @fn uint32_t bmp280_compensate_pressure(const bmp280_calib_t *calib, int32_t adc_P, int32_t t_fine)
+ * @brief compensates a pressure reading in 64 bit integers
+ * @param int32_t adc_P --- 20 bit reading
+ * @param int32_t t_fine --- from bmp280_compensate_temperature
+ * @return the pressure in Pa, Q24.8, or 0 for a calibration that would
+ *         divide by zero
+ */
+uint32_t bmp280_compensate_pressure(const bmp280_calib_t *calib, int32_t adc_P, int32_t t_fine)
+{
+	int64_t var1, var2, p;
+
+	var1 = ((int64_t) t_fine) - 128000;
+	var2 = var1 * var1 * (int64_t) calib->dig_P6;
+	var2 = var2 + ((var1 * (int64_t) calib->dig_P5) * ((int64_t) 1 << 17));
+	var2 = var2 + (((int64_t) calib->dig_P4) * ((int64_t) 1 << 35));
+	var1 = ((var1 * var1 * (int64_t) calib->dig_P3) >> 8) +
+	       ((var1 * (int64_t) calib->dig_P2) * ((int64_t) 1 << 12));
+	var1 = ((((int64_t) 1 << 47) + var1) * ((int64_t) calib->dig_P1)) >> 33;
+
+	if (var1 == 0)
+		return 0;
+
+	p = 1048576 - adc_P;
+	p = ((p * ((int64_t) 1 << 31) - var2) * 3125) / var1;
+	var1 = (((int64_t) calib->dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+	var2 = (((int64_t) calib->dig_P8) * p) >> 19;
+	p = ((p + var1 + var2) >> 8) + (((int64_t) calib->dig_P7) * 16);
+
+	return (uint32_t) p;
+}
+
+/**
+ * @fn uint32_t bmp280_compensate_pressure32(const bmp280_calib_t *calib, int32_t adc_P, int32_t t_fine)
+ * @brief compensates a pressure reading in 32 bit integers
+ * @details Coarser than bmp280_compensate_pressure, by about a Pa, but
+ *          needs no 64 bit divide, which rv32 harts call libgcc for.
+ * @param int32_t adc_P --- 20 bit reading
+ * @param int32_t t_fine --- from bmp280_compensate_temperature
+ * @return the pressure in Pa, or 0 for a calibration that would divide by
+ *         zero
+ */
+uint32_t bmp280_compensate_pressure32(const bmp280_calib_t *calib, int32_t adc_P, int32_t t_fine)
+{
+	int32_t var1, var2;
+	uint32_t p;
+
+	var1 = (t_fine >> 1) - (int32_t) 64000;
+	var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t) calib->dig_P6);
+	var2 = var2 + ((var1 * ((int32_t) calib->dig_P5)) * 2);
+	var2 = (var2 >> 2) + (((int32_t) calib->dig_P4) * 65536);
+	var1 = (((calib->dig_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) +
+		((((int32_t) calib->dig_P2) * var1) >> 1)) >> 18;
+	var1 = ((32768 + var1) * ((int32_t) calib->dig_P1)) >> 15;
+
+	if (var1 == 0)
+		return 0;
+
+	p = (((uint32_t) (((int32_t) 1048576) - adc_P) - (uint32_t) (var2 >> 12))) * 3125;
+
+	if (p < 0x80000000U)
+		p = (p << 1) / ((uint32_t) var1);
+	else
+		p = (p / (uint32_t) var1) * 2;
+
+	var1 = (((int32_t) calib->dig_P9) * ((int32_t) (((p >> 3) * (p >> 3)) >> 13))) >> 12;
+	var2 = (((int32_t) (p >> 2)) * ((int32_t) calib->dig_P8)) >> 13;
+
+	return (uint32_t) ((int32_t) p + ((var1 + var2 + calib->dig_P7) >> 4));
+}
+
+/**
+ * @fn int bmp280_compensate(const bmp280_calib_t *calib, const uint8_t raw[BMP280_DATA_LEN], bmp280_sample_t *sample)
+ * @brief compensates the 6 bytes read from 0xF7 to 0xFC
+ * @details The pressure is in Q24.8 either way; with BMP280_PRESSURE_32BIT
+ *          it comes from bmp280_compensate_pressure32, with its fraction
+ *          zero.
+ * @return BMP280_SUCCESS, or EBMP280_NO_DATA if either reading is still
+ *         the reset value, as when the measurement has not run
+ */
+int bmp280_compensate(const bmp280_calib_t *calib, const uint8_t raw[BMP280_DATA_LEN], bmp280_sample_t *sample)
+{
+	int32_t adc_P = (int32_t) (((uint32_t) raw[0] << 12) | ((uint32_t) raw[1] << 4) | (raw[2] >> 4));
+	int32_t adc_T = (int32_t) (((uint32_t) raw[3] << 12) | ((uint32_t) raw[4] << 4) | (raw[5] >> 4));
+	int32_t t_fine;
+
+	if (adc_P == BMP280_ADC_NONE || adc_T == BMP280_ADC_NONE)
+		return EBMP280_NO_DATA;
+
+	sample->temperature = bmp280_compensate_temperature(calib, adc_T, &t_fine);
+#ifdef BMP280_PRESSURE_32BIT
+	sample->pressure = bmp280_compensate_pressure32(calib, adc_P, t_fine) << 8;
+#else
+	sample->pressure = bmp280_compensate_pressure(calib, adc_P, t_fine);
+#endif
+
+	return BMP280_SUCCESS;
+}
@@ -24,19 +24,28 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 @file gpio_i2c.c
 @brief Contains the driver routines for i2c driver using gpio pins.
 @detail The gpio_i2c module driver supports i2c driver routines
-using gpio pins.
+using gpio pins. Built with CLINT_TIMER, delay is the time in microseconds
+each half of an scl period is held for, timed by udelay(); 5 gives the
+100 kHz of standard mode. Without it delay stays the delay_loop() count it
+always was.
 */
 
 #include "platform.h"
 #include "gpio.h"
 #include "gpio_i2c.h"
 
+#ifdef CLINT_TIMER
+#include "clint_timer.h"
+#define GPIO_I2C_DELAY(delay)	udelay(delay)
+#else
 /** @fn extern void delay_loop(unsigned long , unsigned long)
  * @brief Maintains the required delay to perform an operation
  * @param unsigned long 
  * @param unsigned long
  */
 extern void delay_loop(unsigned long , unsigned long);
+#define GPIO_I2C_DELAY(delay)	delay_loop(delay, delay)
+#endif
 
 /** @fn static void SetSCLAsOutput()
  * @brief Function for configure GPIO 0 as SCL output.
@@ -87,19 +96,19 @@ static void start(unsigned char delay)
 
 //	sda=1;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SDA | I2C_SCL) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 //		scl=1;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SCL) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 //		sda=0;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SDA)) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 //		scl=0;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SCL) ) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 	printf("\n\tI2C: I2C Start condition sent\n");
 }
@@ -116,15 +125,15 @@ static void stop(unsigned char delay)
 	readData = read_word(GPIO_DATA_REG);
 //	sda=0;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SDA)) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 //	scl=1;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SCL) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 //	sda=1;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SDA) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 	printf("\n\tI2C: I2C Start condition sent\n");
 
 }
@@ -150,20 +159,20 @@ void I2cWriteByte(unsigned char writeData, unsigned char delay)
 //		sda=CY;
 		if (k == 0) {
 			write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SDA)) );
-			delay_loop(delay, delay);
+			GPIO_I2C_DELAY(delay);
 		}
 		else {
 			write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SDA) );
-			delay_loop(delay, delay);
+			GPIO_I2C_DELAY(delay);
 		}
 
 	//	scl=1;
 		write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SCL) );
-		delay_loop(delay, delay);
+		GPIO_I2C_DELAY(delay);
 
 	//	scl=0;
 		write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SCL) ) );
-		delay_loop(delay, delay);
+		GPIO_I2C_DELAY(delay);
 		++j;
 	}
 }
@@ -189,7 +198,7 @@ unsigned char I2cReadByte(unsigned char delay)
 	while (j < 8) {
 	//	scl=1;
 		write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SCL) );
-		delay_loop(delay, delay);
+		GPIO_I2C_DELAY(delay);
 
 //		d1 = sda;
 		readGpioData = read_word(GPIO_DATA_REG)  & I2C_SDA;
@@ -199,11 +208,11 @@ unsigned char I2cReadByte(unsigned char delay)
 			bitValue = 0;
 	    readData = readData << 1;
 		readData = readData | bitValue;
-		delay_loop(delay, delay);
+		GPIO_I2C_DELAY(delay);
 
 	//	scl=0;
 		write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SCL) ) );
-		delay_loop(delay, delay);
+		GPIO_I2C_DELAY(delay);
 
 		++j;
 	}
@@ -225,11 +234,11 @@ void ReadAckForWrite(unsigned char delay)
 	unsigned long readData = 0;
 	printf("\n\tI2C: I2C Read\n");
 	readData = read_word(GPIO_DATA_REG);
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 //	scl=1;delay
 	printf("\n\tI2C: I2C Write\n");
 	write_word(GPIO_DATA_REG, (readData | I2C_SCL) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 		printf("\n\tI2C: I2C Write\n");
 		readData = read_word(GPIO_DATA_REG)  & I2C_SDA;
@@ -237,7 +246,7 @@ void ReadAckForWrite(unsigned char delay)
 //	scl=0;
 	printf("\n\tI2C: I2C Write\n");
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SCL) ) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 	printf("\n\tI2C: I2C ReadNackForWrite sent\n");
 
 }
@@ -260,15 +269,15 @@ void SendAckForRead(unsigned char delay)
 
 //	sda=0;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SDA)) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 //	scl=1;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SCL) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
 //	scl=0;
 	write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SCL) ) );
-	delay_loop(delay, delay);
+	GPIO_I2C_DELAY(delay);
 
   SetSdaDirection(GPIOD_IS_IN);
 }
@@ -291,15 +300,15 @@ void SendNackForRead(unsigned char delay)
 
  //	sda=0;
   write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG)  | (I2C_SDA)) );
-  delay_loop(delay, delay);
+  GPIO_I2C_DELAY(delay);
 
  //	scl=1;
   write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SCL) );
-  delay_loop(delay, delay);
+  GPIO_I2C_DELAY(delay);
 
  //	scl=0;
   write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(I2C_SCL) ) );
-  delay_loop(delay, delay);
+  GPIO_I2C_DELAY(delay);
 
   SetSdaDirection(GPIOD_IS_IN);
  }
@@ -346,7 +355,7 @@ void I2cSendSlaveAddress(unsigned char slaveAddress, unsigned char rdWrCntrl, un
 	}
   //	sda=1;
   write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SDA) );
-  delay_loop(delay, delay);
+  GPIO_I2C_DELAY(delay);
 
   printf("\n\tI2C: I2C Write Ack\n");
   SetSdaDirection(GPIOD_IS_IN);
@@ -369,7 +378,7 @@ void I2cWriteData(unsigned char writeData, unsigned char delay)
   I2cWriteByte( writeData, delay);
   //	sda=1;
   write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | I2C_SDA) );
-  delay_loop(delay, delay);
+  GPIO_I2C_DELAY(delay);
 
   printf("\n\tI2C: I2C Write Ack\n");
   SetSdaDirection(GPIOD_IS_IN);
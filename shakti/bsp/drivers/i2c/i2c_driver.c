@@ -32,6 +32,16 @@
 #include "log.h"
 #include "utils.h"
 
+#ifdef I2C_ASYNC
+#include "defines.h"
+#include "traps.h"
+#include "plic_driver.h"
+#ifdef I2C_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+#endif
+
 /* Enable these bits only when corresponding interrupt is needed.*/
 
 //#define USE_SA_WRITE_I2C_INTERRUPT 1
@@ -39,6 +49,8 @@
 //#define USE_READ_I2C_INTERRUPT 1
 
 i2c_struct *i2c_instance[MAX_I2C_COUNT];
+unsigned char i2c_complete_flag;
+unsigned int i2c_read_value;
 
 /**
  * @fn void i2c_init()
@@ -70,15 +82,15 @@ int config_i2c(i2c_struct * instance, unsigned char prescale_div, unsigned char
 	unsigned char temp = 0;
 	log_debug("\tI2C: Initializing the Controller\n");
 
-	if(prescale_div  != instance->prescale )
+	if(prescale_div  != i2c_get_reg(instance, prescale) )
 	{
-		instance->prescale = prescale_div;
+		i2c_set_reg(instance, prescale, prescale_div);
 #ifdef DEBUG 
-		temp = instance->prescale;
+		temp = i2c_get_reg(instance, prescale);
 
 		if((temp | 0x00) != prescale_div)
 		{
-			log_error("\t Failed to write Prescale division Written Value: 0x%x; read Value: 0x%x\n", prescale_div, instance->prescale);
+			log_error("\t Failed to write Prescale division Written Value: 0x%x; read Value: 0x%x\n", prescale_div, i2c_get_reg(instance, prescale));
 			return -ENXIO;
 		}
 		else
@@ -88,13 +100,13 @@ int config_i2c(i2c_struct * instance, unsigned char prescale_div, unsigned char
 #endif
 	}
 
-	if(scl_div != instance->scl )
+	if(scl_div != i2c_get_reg(instance, scl) )
 	{
-		instance->scl = scl_div;  //Setting the I2C clock value to be 1, which will set the clock for module and prescaler clock
+		i2c_set_reg(instance, scl, scl_div);  //Setting the I2C clock value to be 1, which will set the clock for module and prescaler clock
 
 
 #ifdef DEBUG 
-		temp = instance->scl;
+		temp = i2c_get_reg(instance, scl);
 
 		/* Just reading the written value to see if all is well -- Compiler should not optimize this load!!! Compiler can just optimize the store to pointer address followed by load pointer to a register to just an immediate load to the register since clock register is not used anywhere -- but the purpose is lost. Don't give compiler optimizations */
 		if((temp | 0x00) != scl_div)
@@ -111,11 +123,11 @@ int config_i2c(i2c_struct * instance, unsigned char prescale_div, unsigned char
 
 	/* S1=0x80 S0 selected, serial interface off */
 	log_debug("\tClearing the status register. \n");
-	instance->control = I2C_PIN;
+	i2c_set_reg(instance, control, I2C_PIN);
 
 	// Reading set control Register Value to ensure sanctity
 	log_debug("\tReading Status Register \n");
-	temp = instance->control;
+	temp = i2c_get_reg(instance, control);
 
 	//Check whether the status register is cleared or not.
 	if((temp & 0x7f) != 0){
@@ -126,12 +138,12 @@ int config_i2c(i2c_struct * instance, unsigned char prescale_div, unsigned char
 	log_debug("\tWaiting for a specified time\n ");
 	waitfor(900); //1 Second software wait -- Should be 900000 but setting to 900 now since simulation is already slow
 	log_debug("\tDone Waiting \n ");
-	log_info("\nControl: %x; Status: %x", instance->control, instance->status);
+	log_info("\nControl: %x; Status: %x", i2c_get_reg(instance, control), i2c_get_reg(instance, status));
 	/* Enable Serial Interface */
-	instance->control = I2C_IDLE;
+	i2c_set_reg(instance, control, I2C_IDLE);
 	waitfor(900); //1 Second software wait -- Should be 900000 but setting to 900 now since simulation is already slow
 
-	temp = instance->status;
+	temp = i2c_get_reg(instance, status);
 
 	/* Check to see if I2C is really in Idle and see if we can access the status register -- If not something wrong in initialization. This also verifies if Control is properly written since zero bit will be initialized to zero*/
 	if(temp != (I2C_PIN | I2C_BB)){
@@ -158,11 +170,11 @@ int wait_till_I2c_bus_free(i2c_struct * instance)
 	int timeout = DEF_TIMEOUT;
 	int status;
 
-	status = instance->status;
+	status = i2c_get_reg(instance, status);
 
 	while (!(status & I2C_BB) && --timeout) {
 		waitfor(20000); /* wait for 100 us */
-		status = instance->status;
+		status = i2c_get_reg(instance, status);
 	}
 
 	if (timeout == 0) {
@@ -187,11 +199,11 @@ int wait_till_txrx_operation_Completes(i2c_struct * instance, int *status)
 
 	int timeout = DEF_TIMEOUT;
 
-	*status = instance->status;
+	*status = i2c_get_reg(instance, status);
 
 	while ((*status & I2C_PIN) && --timeout) {
 		waitfor(10000); /* wait for 100 us */
-		*status = instance->status;
+		*status = i2c_get_reg(instance, status);
 	}
 
 	if (timeout == 0){
@@ -220,30 +232,30 @@ int sendbytes(i2c_struct * instance, const char *buf, int count, int last, int e
 	int wrcount, status, timeout;
 	printf("\tStarting Write Transaction -- Did you create tri1 nets for SDA and SCL in verilog?\n");
 	for (wrcount=0; wrcount<count; ++wrcount) {
-		instance->data = buf[wrcount];
+		i2c_set_reg(instance, data, buf[wrcount]);
 		timeout = wait_till_txrx_operation_Completes(instance, &status);
 		if (timeout) {
 			printf("\tTimeout happened - Write did not go through the BFM -- Diagnose\n");
-			instance->control = I2C_STOP;
+			i2c_set_reg(instance, control, I2C_STOP);
 			return EREMOTEIO;
 		}
 		if (status & I2C_LRB) { // What error is this?
-			instance->control = I2C_STOP;//~
+			i2c_set_reg(instance, control, I2C_STOP);//~
 			printf("\tSome status check failing\n");
 			return EREMOTEIO;
 		}
 	}
 	if (last){
 		printf("\tLast byte sent : Issue a stop\n");
-		instance->control = I2C_STOP;
+		i2c_set_reg(instance, control, I2C_STOP);
 	}
 	else{
 		printf("\tSending Rep Start and doing some other R/W transaction\n");
 
 		if(!eni)
-			instance->control = I2C_REPSTART;
+			i2c_set_reg(instance, control, I2C_REPSTART);
 		else
-			instance->control = I2C_REPSTART_ENI;
+			i2c_set_reg(instance, control, I2C_REPSTART_ENI);
 	}
 
 	return wrcount;
@@ -269,31 +281,31 @@ int readbytes(i2c_struct * instance, char *buf, int count, int last)
 	for (i = 0; i <= count; i++) {
 		wfp = wait_till_txrx_operation_Completes(instance, &status);
 		if (wfp) {
-			instance->control = I2C_STOP;
+			i2c_set_reg(instance, control, I2C_STOP);
 			return -1;
 		}
 
 		if ((status & I2C_LRB) && (i != count)) {
-			instance->control = I2C_STOP;
+			i2c_set_reg(instance, control, I2C_STOP);
 			printf("\tNo ack\n");
 			return -1;
 		}
 
 		if (i)
 		{
-			buf[i - 1] = instance->data;
+			buf[i - 1] = i2c_get_reg(instance, data);
 			printf("\n Read Value: %x", buf[i - 1]);
 		}
 		else
-			instance->data = !instance->data; /* dummy read */
+			i2c_set_reg(instance, data, !i2c_get_reg(instance, data)); /* dummy read */
 
 		if (i == count - 1) {
-			instance->control = I2C_ESO;
+			i2c_set_reg(instance, control, I2C_ESO);
 		} else if (i == count) {
 			if (last)
-				instance->control = I2C_STOP;
+				i2c_set_reg(instance, control, I2C_STOP);
 			else
-				instance->control = I2C_REPSTART_ENI;
+				i2c_set_reg(instance, control, I2C_REPSTART_ENI);
 		}
 
 	}
@@ -325,11 +337,11 @@ int i2c_send_slave_address(i2c_struct * instance, unsigned char slaveAddress, un
 		slaveAddress |= I2C_READ;
 
 	//Writing the slave address that needs to be written into data register.
-	instance->data = slaveAddress;
+	i2c_set_reg(instance, data, slaveAddress);
 	log_debug("\tSlave Address 0x%x written into data register\n", slaveAddress);
 
 	//Reads back the data register to confirm
-	temp = instance->data; //Reads the slave address from I2C controller
+	temp = i2c_get_reg(instance, data); //Reads the slave address from I2C controller
 
 	if(slaveAddress != (int)temp)
 	{
@@ -348,18 +360,18 @@ int i2c_send_slave_address(i2c_struct * instance, unsigned char slaveAddress, un
 
 	//Send the start condition and slave address to slave
 #ifndef USE_SA_WRITE_I2C_INTERRUPT
-	instance->control = I2C_START; //Sending the slave address to the I2C slave
+	i2c_set_reg(instance, control, I2C_START); //Sending the slave address to the I2C slave
 	waitfor(90000);
 	//Wait for PIN to become low.
 	timeout = wait_till_txrx_operation_Completes(instance, &status);
 	if (timeout) {//Asking the controller to send a start signal to initiate the transaction
 		printf("\tTimeout happened - Write did not go through the BFM -- Diagnose\n");
-		instance->control = I2C_STOP; //~
+		i2c_set_reg(instance, control, I2C_STOP); //~
 		return EI2C_PIN_ERROR;
 	}
 
 	if (status & I2C_LRB) {
-		instance->control = I2C_STOP; //~
+		i2c_set_reg(instance, control, I2C_STOP); //~
 		printf("\tSome status check failing\n");
 		return EI2C_LRB_ERROR;
 	}
@@ -367,7 +379,7 @@ int i2c_send_slave_address(i2c_struct * instance, unsigned char slaveAddress, un
 #else
 	i2c_complete_flag = 0;
 
-	instance->control = I2C_START_ENI; //Sending the slave address to the I2C slave
+	i2c_set_reg(instance, control, I2C_START_ENI); //Sending the slave address to the I2C slave
 	while(!i2c_complete_flag);
 	log_info("\n Slave Address Write Operation is complete.");
 	i2c_complete_flag = 0;
@@ -391,25 +403,25 @@ int i2c_write_data(i2c_struct * instance, unsigned char writeData, unsigned char
 	int status = 0;
 	delay = delay;
 
-	instance->data= writeData;
+	i2c_set_reg(instance, data, writeData);
 
 #ifndef USE_WRITE_I2C_INTERRUPT
 	timeout = wait_till_txrx_operation_Completes(instance, &status);
 	if (timeout) {
 		printf("\tTimeout happened - Write did not go through the BFM -- Diagnose\n");
-		instance->control = I2C_STOP; //~
+		i2c_set_reg(instance, control, I2C_STOP); //~
 		return EREMOTEIO;
 	}
 
 	if (status & I2C_LRB)
 	{ // What error is this?
-		instance->control = I2C_STOP; //~
+		i2c_set_reg(instance, control, I2C_STOP); //~
 		printf("\tSome status check failing\n");
 		return EI2C_LRB_ERROR;
 	}
 #else
 	i2c_complete_flag = 0;
-	instance->control = I2C_STOP_ENI; //Sending the sslave address to the I2C slave
+	i2c_set_reg(instance, control, I2C_STOP_ENI); //Sending the sslave address to the I2C slave
 
 	while(!i2c_complete_flag);
 	log_info("\n Write Operation is complete.");
@@ -435,14 +447,14 @@ int i2c_read_data(i2c_struct * instance, unsigned char *read_data, unsigned char
 
 	/* Make a dummy read as per spec of the I2C controller */
 
-	*read_data = instance->data; //~
+	*read_data = i2c_get_reg(instance, data); //~
 
 #ifdef USE_WRITE_I2C_INTERRUPT	
 	i2c_complete_flag = 0;
-	instance->control = I2C_REPSTART_ENI; //~
+	i2c_set_reg(instance, control, I2C_REPSTART_ENI); //~
 
 	while(!i2c_complete_flag);
-	*read_data = instance->data;
+	*read_data = i2c_get_reg(instance, data);
 
 	printf("\n I2C Read Data = %x", i2c_read_data);
 #else
@@ -479,11 +491,11 @@ int i2c_send_interrupt_slave_address(i2c_struct * instance, unsigned char slaveA
 
 	log_debug("\n\tSetting Slave Address : 0x%x\n", slaveAddress);/* Writes the slave address to I2C controller */
 	//Writing the slave address that needs to be written into data register.
-	instance->data = slaveAddress;
+	i2c_set_reg(instance, data, slaveAddress);
 	log_debug("\tSlave Address is written into data register\n");
 
 	//Reads back the data register to confirm
-	temp = instance->data; //Reads the slave address from I2C controller
+	temp = i2c_get_reg(instance, data); //Reads the slave address from I2C controller
 	log_debug("\tSet slave address read again, which is 0x%x\n",temp);
 
 	if(slaveAddress != (int)temp)
@@ -502,23 +514,23 @@ int i2c_send_interrupt_slave_address(i2c_struct * instance, unsigned char slaveA
 
 	//Send the start condition and slave address to slave
 #ifndef USE_SA_WRITE_I2C_INTERRUPT
-	instance->control = I2C_START;; //Sending the slave address to the I2C slave
+	i2c_set_reg(instance, control, I2C_START);; //Sending the slave address to the I2C slave
 	//Wait for PIN to become low.
 	timeout = wait_till_txrx_operation_Completes(instance, &status);
 	if (timeout) {//Asking the controller to send a start signal to initiate the transaction
 		printf("\tTimeout happened - Write did not go through the BFM -- Diagnose\n");
-		instance->control = I2C_STOP; //~
+		i2c_set_reg(instance, control, I2C_STOP); //~
 		return EI2C_PIN_ERROR;
 	}
 
 	if (status & I2C_LRB) {
-		instance->control = I2C_STOP; //~
+		i2c_set_reg(instance, control, I2C_STOP); //~
 		printf("\tSome status check failing\n");
 		return EI2C_LRB_ERROR;
 	}
 #else
 	i2c_complete_flag = 0;
-	instance->control = I2C_REPSTART_ENI; //Sending the slave address to the I2C slave
+	i2c_set_reg(instance, control, I2C_REPSTART_ENI); //Sending the slave address to the I2C slave
 	while(!i2c_complete_flag);
 	log_info("\n Slave Address Write Operation is complete.");
 	i2c_complete_flag = 0;
@@ -542,20 +554,20 @@ int i2c_read_interrupt_data(i2c_struct * instance, unsigned char *read_data, uns
 	int status = 0;
 
 	/* Make a dummy read as per spec of the I2C controller */
-	*read_data = instance->data;
+	*read_data = i2c_get_reg(instance, data);
 
 #ifdef USE_READ_I2C_INTERRUPT	
 	i2c_complete_flag = 0;
 
 	if(last)
 	{
-		instance->control = I2C_STOP_ENI; //~
+		i2c_set_reg(instance, control, I2C_STOP_ENI); //~
 		while(!i2c_complete_flag);
 	}
 	else
 	{
 		/* Needs to be tested */
-		//			instance->control = I2C_REPSTART_ENI;
+		//			i2c_set_reg(instance, control, I2C_REPSTART_ENI);
 		//			printf("\n Call I2C rep. start eni");
 		//			while(!i2c_complete_flag);
 	}
@@ -569,12 +581,12 @@ int i2c_read_interrupt_data(i2c_struct * instance, unsigned char *read_data, uns
 	if(!last)
 	{
 		printf("\n Rep Start");				
-		//				instance->control = I2C_REPSTART;
+		//				i2c_set_reg(instance, control, I2C_REPSTART);
 	}
 	else
 	{
 		printf("\nCall I2C Stop");
-		instance->control = I2C_STOP;
+		i2c_set_reg(instance, control, I2C_STOP);
 	}
 #endif
 	return I2C_SUCCESS;
@@ -596,26 +608,26 @@ int i2c_write_interrupt_data(i2c_struct * instance, unsigned char writeData, uns
 	int status = 0;
 	delay = delay;
 
-	instance->data = writeData;
+	i2c_set_reg(instance, data, writeData);
 
 #ifndef USE_WRITE_I2C_INTERRUPT
 	timeout = wait_till_txrx_operation_Completes(instance, &status);
 	if (timeout) {
 		printf("\tTimeout happened - Write did not go through the BFM -- Diagnose\n");
-		instance->control = I2C_STOP; //~
+		i2c_set_reg(instance, control, I2C_STOP); //~
 		return EREMOTEIO;
 	}
 
 	if (status & I2C_LRB)
 	{ // What error is this?
-		instance->control = I2C_STOP;//~
+		i2c_set_reg(instance, control, I2C_STOP);//~
 		printf("\tSome status check failing\n");
 		return EI2C_LRB_ERROR;
 	}
 
 	if(1 == last)
 	{
-		instance->control = I2C_STOP;;
+		i2c_set_reg(instance, control, I2C_STOP);;
 		printf("\tI2C Write Success and completes\n");
 	}
 #else
@@ -623,13 +635,13 @@ int i2c_write_interrupt_data(i2c_struct * instance, unsigned char writeData, uns
 
 	if(last)
 	{
-		instance->control = I2C_STOP_ENI; //Sending the sslave address to the I2C slave
+		i2c_set_reg(instance, control, I2C_STOP_ENI); //Sending the sslave address to the I2C slave
 		printf("\n Calling stop eni write");
 		while(!i2c_complete_flag);
 	}
 	else
 	{
-		//			instance->control = I2C_REPSTART_ENI;
+		//			i2c_set_reg(instance, control, I2C_REPSTART_ENI);
 		//			printf("\n Calling repstart eni write");
 		//		while(!i2c_complete_flag);
 	}
@@ -638,3 +650,574 @@ int i2c_write_interrupt_data(i2c_struct * instance, unsigned char writeData, uns
 #endif
 	return I2C_SUCCESS;
 }
+
+#ifdef I2C_ASYNC
+/*
+   Interrupt driven transactions.
+
+   i2c_transfer queues a write then read transaction on the controller and
+   i2c_async_isr carries it out one byte per interrupt: the controller
+   raises its interrupt when PIN falls at the end of each byte, while ENI
+   is set. A transaction is sent as
+
+	START, address+W, reg, write_data..., STOP
+
+   or, when it reads,
+
+	START, address+W, reg, write_data..., repeated START, address+R,
+	read_data... with a nack on the last byte, STOP
+
+   The queue keeps one transaction per waiting caller. The one at its head
+   is started by its own caller, which first waits for the bus to be free,
+   as that takes polling after the previous STOP; everything after the
+   start happens in the isr. A nack ends the transaction with EREMOTEIO. A
+   bus error or lost arbitration, a bus that stays busy, or a transaction
+   that outlives its timeout resets the controller. The controller cannot
+   clock a slave that holds SDA low out of a byte, so a bus that is still
+   busy after the reset fails the transaction with EI2C_BUS_ERROR.
+
+   With I2C_FREERTOS the caller waits on its task notification. When it
+   cannot block, because there is no scheduler running, or interrupts are
+   disabled, or the build is bare metal, the transaction is carried out by
+   polling PIN with interrupts disabled, provided that no other one is
+   queued.
+ */
+
+enum
+{
+	I2C_XFER_WRITE,		/* address+W, reg or a write_data byte is out */
+	I2C_XFER_ADDR_READ,	/* address+R is out after a repeated start */
+	I2C_XFER_READ		/* a read_data byte is coming in */
+};
+
+typedef struct
+{
+	i2c_xfer_t *head;	/* transaction running, or next to start */
+	i2c_xfer_t *tail;
+	uint8_t running;
+	uint8_t enabled;
+	i2c_async_stats_t stats;
+} i2c_queue_t;
+
+static i2c_queue_t i2c_queue[MAX_I2C_COUNT];
+
+/** @fn static i2c_queue_t *i2c_queue_of(i2c_struct *instance)
+ * @brief returns the transaction queue of an i2c instance
+ * @param i2c_struct* instance
+ * @return the queue, or NULL if the instance is not asynchronous
+ */
+static i2c_queue_t *i2c_queue_of(i2c_struct *instance)
+{
+	uint32_t i;
+
+	for (i = 0; i < MAX_I2C_COUNT; i++)
+	{
+		if (i2c_instance[i] == instance)
+			return i2c_queue[i].enabled ? &i2c_queue[i] : NULL;
+	}
+
+	return NULL;
+}
+
+/** @fn static uintptr_t i2c_irq_save(void)
+ * @brief disables interrupts
+ * @return nonzero if they were enabled
+ */
+static uintptr_t i2c_irq_save(void)
+{
+	uintptr_t state = read_csr(mstatus) & MSTATUS_MIE;
+
+	clear_csr(mstatus, MSTATUS_MIE);
+
+	return state;
+}
+
+/** @fn static void i2c_irq_restore(uintptr_t state)
+ * @brief enables interrupts again if i2c_irq_save found them enabled
+ * @param uintptr_t state
+ */
+static void i2c_irq_restore(uintptr_t state)
+{
+	if (state)
+		set_csr(mstatus, MSTATUS_MIE);
+}
+
+/** @fn static int i2c_can_block(void)
+ * @brief tells whether the caller is a task that may wait
+ * @return nonzero if the caller can wait on its task notification
+ */
+static int i2c_can_block(void)
+{
+#ifdef I2C_FREERTOS
+	return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING &&
+	       (read_csr(mstatus) & MSTATUS_MIE);
+#else
+	return 0;
+#endif
+}
+
+/** @fn static void *i2c_async_finish(i2c_queue_t *q, i2c_xfer_t *xfer, int result)
+ * @brief takes a transaction off the queue with its result
+ * @details Call with interrupts disabled.
+ * @param i2c_queue_t* q
+ * @param i2c_xfer_t* xfer
+ * @param int result
+ * @return the task of the transaction now at the head, which is to start
+ *         it, if xfer was at the head; else NULL
+ */
+static void *i2c_async_finish(i2c_queue_t *q, i2c_xfer_t *xfer, int result)
+{
+	i2c_xfer_t **link = &q->head;
+	i2c_xfer_t *prev = NULL;
+
+	while (*link != NULL && *link != xfer)
+	{
+		prev = *link;
+		link = &prev->next;
+	}
+
+	if (*link == NULL)
+		return NULL;
+
+	*link = xfer->next;
+	if (q->tail == xfer)
+		q->tail = prev;
+
+	q->stats.transfers++;
+	xfer->result = result;
+	xfer->done = 1;
+
+	if (prev != NULL)
+		return NULL;
+
+	q->running = 0;
+
+	return q->head != NULL ? q->head->waiter : NULL;
+}
+
+/** @fn static void i2c_async_complete(i2c_queue_t *q, i2c_xfer_t *xfer, int result, int from_isr)
+ * @brief ends the running transaction
+ * @details From the isr, wakes the transaction's task and the task of the
+ *          next one. Otherwise the caller is the only one queued.
+ * @param i2c_queue_t* q
+ * @param i2c_xfer_t* xfer
+ * @param int result
+ * @param int from_isr
+ */
+static void i2c_async_complete(i2c_queue_t *q, i2c_xfer_t *xfer, int result, int from_isr)
+{
+	void *waiter = xfer->waiter;
+	void *next = i2c_async_finish(q, xfer, result);
+#ifdef I2C_FREERTOS
+	BaseType_t woken = pdFALSE;
+
+	if (!from_isr)
+		return;
+
+	if (waiter != NULL)
+		vTaskNotifyGiveFromISR((TaskHandle_t) waiter, &woken);
+	if (next != NULL)
+		vTaskNotifyGiveFromISR((TaskHandle_t) next, &woken);
+
+	portYIELD_FROM_ISR(woken);
+#else
+	(void) waiter;
+	(void) next;
+	(void) from_isr;
+#endif
+}
+
+/** @fn static void i2c_async_reset(i2c_struct *instance, i2c_queue_t *q)
+ * @brief sends a STOP and resets the controller, as config_i2c does
+ * @param i2c_struct* instance
+ * @param i2c_queue_t* q
+ */
+static void i2c_async_reset(i2c_struct *instance, i2c_queue_t *q)
+{
+	q->stats.recoveries++;
+	i2c_set_reg(instance, control, I2C_STOP);
+	i2c_set_reg(instance, control, I2C_PIN);
+	i2c_set_reg(instance, control, I2C_IDLE);
+}
+
+/** @fn static int i2c_async_bus_free(i2c_struct *instance, i2c_queue_t *q)
+ * @brief waits for the bus to be free before a START
+ * @details Polls BB for up to I2C_POLL_LIMIT status reads. If the bus stays
+ *          busy the controller is reset and BB polled again.
+ * @param i2c_struct* instance
+ * @param i2c_queue_t* q
+ * @return nonzero if the bus is free
+ */
+static int i2c_async_bus_free(i2c_struct *instance, i2c_queue_t *q)
+{
+	uint32_t polls;
+	int attempt;
+
+	for (attempt = 0; attempt < 2; attempt++)
+	{
+		for (polls = 0; polls < I2C_POLL_LIMIT; polls++)
+		{
+			if (i2c_get_reg(instance, status) & I2C_BB)
+				return 1;
+		}
+
+		if (attempt == 0)
+			i2c_async_reset(instance, q);
+	}
+
+	return 0;
+}
+
+/** @fn static void i2c_async_start(i2c_struct *instance, i2c_queue_t *q)
+ * @brief sends the START and address of the transaction at the head
+ * @details The bus must have been found free. Call with interrupts
+ *          disabled.
+ * @param i2c_struct* instance
+ * @param i2c_queue_t* q
+ */
+static void i2c_async_start(i2c_struct *instance, i2c_queue_t *q)
+{
+	i2c_xfer_t *xfer = q->head;
+
+	xfer->state = I2C_XFER_WRITE;
+	xfer->count = 0;
+	q->running = 1;
+
+	i2c_set_reg(instance, data, xfer->slave_address | I2C_WRITE);
+	i2c_set_reg(instance, control, I2C_START_ENI);
+}
+
+/** @fn static void i2c_async_step(i2c_struct *instance, i2c_queue_t *q, int from_isr)
+ * @brief moves the running transaction on by one byte
+ * @details Does nothing unless a transaction is running and PIN is low.
+ *          Call with interrupts disabled.
+ * @param i2c_struct* instance
+ * @param i2c_queue_t* q
+ * @param int from_isr
+ */
+static void i2c_async_step(i2c_struct *instance, i2c_queue_t *q, int from_isr)
+{
+	i2c_xfer_t *xfer = q->head;
+	unsigned int status;
+
+	if (!q->running)
+		return;
+
+	status = i2c_get_reg(instance, status);
+	if (status & I2C_PIN)
+		return;
+
+	if (status & (I2C_BER | I2C_LAB))
+	{
+		i2c_async_reset(instance, q);
+		i2c_async_complete(q, xfer, EI2C_BUS_ERROR, from_isr);
+		return;
+	}
+
+	switch (xfer->state)
+	{
+	case I2C_XFER_WRITE:
+		if (status & I2C_LRB)
+		{
+			i2c_set_reg(instance, control, I2C_STOP);
+			q->stats.nacks++;
+			i2c_async_complete(q, xfer, EREMOTEIO, from_isr);
+			return;
+		}
+
+		/* count is the number of bytes acked, the address first */
+		if (xfer->count != 0)
+			q->stats.bytes++;
+
+		if (xfer->count == 0)
+			i2c_set_reg(instance, data, xfer->reg);
+		else if (xfer->count <= xfer->write_len)
+			i2c_set_reg(instance, data, xfer->write_data[xfer->count - 1]);
+		else if (xfer->read_len != 0)
+		{
+			i2c_set_reg(instance, control, I2C_REPSTART_ENI);
+			i2c_set_reg(instance, data, xfer->slave_address | I2C_READ);
+			xfer->state = I2C_XFER_ADDR_READ;
+			return;
+		}
+		else
+		{
+			i2c_set_reg(instance, control, I2C_STOP);
+			i2c_async_complete(q, xfer, I2C_SUCCESS, from_isr);
+			return;
+		}
+
+		xfer->count++;
+		break;
+
+	case I2C_XFER_ADDR_READ:
+		if (status & I2C_LRB)
+		{
+			i2c_set_reg(instance, control, I2C_STOP);
+			q->stats.nacks++;
+			i2c_async_complete(q, xfer, EREMOTEIO, from_isr);
+			return;
+		}
+
+		/* The first read of data returns the address and clocks in
+		   the first byte, which is also the last if read_len is 1. */
+		if (xfer->read_len == 1)
+			i2c_set_reg(instance, control, I2C_NACK_ENI);
+		(void) i2c_get_reg(instance, data);
+		xfer->state = I2C_XFER_READ;
+		xfer->count = 0;
+		break;
+
+	case I2C_XFER_READ:
+		q->stats.bytes++;
+
+		/* Each read of data clocks in the next byte, so the STOP goes
+		   out before the last byte is read, and the nack is set
+		   before reading the byte ahead of it. */
+		if (xfer->count == xfer->read_len - 1)
+		{
+			i2c_set_reg(instance, control, I2C_STOP);
+			xfer->read_data[xfer->count++] = i2c_get_reg(instance, data);
+			i2c_async_complete(q, xfer, I2C_SUCCESS, from_isr);
+			return;
+		}
+
+		if (xfer->count == xfer->read_len - 2)
+			i2c_set_reg(instance, control, I2C_NACK_ENI);
+		xfer->read_data[xfer->count++] = i2c_get_reg(instance, data);
+		break;
+	}
+}
+
+/** @fn static void *i2c_async_abort(i2c_struct *instance, i2c_queue_t *q, i2c_xfer_t *xfer)
+ * @brief ends a transaction that timed out, queued or running
+ * @details A running transaction is cut short by resetting the controller.
+ *          Call with interrupts disabled.
+ * @param i2c_struct* instance
+ * @param i2c_queue_t* q
+ * @param i2c_xfer_t* xfer
+ * @return the task to wake, as for i2c_async_finish
+ */
+static void *i2c_async_abort(i2c_struct *instance, i2c_queue_t *q, i2c_xfer_t *xfer)
+{
+	if (q->head == xfer && q->running)
+		i2c_async_reset(instance, q);
+
+	q->stats.timeouts++;
+
+	return i2c_async_finish(q, xfer, ETIMEDOUT);
+}
+
+/** @fn int i2c_enable_async(i2c_struct * instance)
+ * @brief Function to make an i2c controller interrupt driven.
+ * @details Empties the controller's transaction queue, installs
+ *          i2c_async_isr for its PLIC source and enables the source.
+ *          plic_init and config_i2c must have been called. From then on
+ *          i2c_transfer can be used on the controller; the polled calls
+ *          must not be used on it while a transaction is queued.
+ * @param i2c_struct* instance
+ * @return Zero, or ENXIO if the instance is not an i2c controller
+ */
+int i2c_enable_async(i2c_struct * instance)
+{
+	i2c_queue_t *q;
+	uint32_t interrupt_id;
+	uintptr_t state;
+	uint32_t i;
+
+	for (i = 0; i < MAX_I2C_COUNT; i++)
+	{
+		if (i2c_instance[i] == instance)
+			break;
+	}
+
+	if (i == MAX_I2C_COUNT)
+		return ENXIO;
+
+	q = &i2c_queue[i];
+	interrupt_id = PLIC_INTERRUPT_23 + i;
+
+	state = i2c_irq_save();
+
+	q->head = q->tail = NULL;
+	q->running = 0;
+	q->stats = (i2c_async_stats_t) { 0 };
+	q->enabled = 1;
+
+	isr_table[interrupt_id] = i2c_async_isr;
+	interrupt_enable(interrupt_id);
+
+	i2c_irq_restore(state);
+
+	return 0;
+}
+
+/** @fn int i2c_transfer(i2c_struct * instance, i2c_xfer_t * xfer, unsigned int timeout)
+ * @brief Function to carry out a write then read transaction.
+ * @details Queues the transaction behind those of other tasks and returns
+ *          once it is over. A task waits on its notification for at most
+ *          timeout ticks in all, or for ever with I2C_WAIT_FOREVER, and
+ *          the controller is reset if the transaction was running when the
+ *          time ran out. If the caller cannot block, the transaction is
+ *          carried out by polling, which needs the queue to be empty, and
+ *          timeout is not used.
+ * @param i2c_struct* instance
+ * @param i2c_xfer_t* xfer --- transaction, which must stay in place until
+ *        the call returns
+ * @param unsigned int timeout --- in ticks
+ * @return I2C_SUCCESS, EREMOTEIO on a nack, ETIMEDOUT, EI2C_BUS_ERROR if
+ *         the bus was stuck, EI2C_BUSY if a caller that cannot block finds
+ *         other transactions queued, or ENXIO if the instance is not
+ *         asynchronous
+ */
+int i2c_transfer(i2c_struct * instance, i2c_xfer_t * xfer, unsigned int timeout)
+{
+	i2c_queue_t *q = i2c_queue_of(instance);
+	int can_block = i2c_can_block();
+	void *wake = NULL;
+	uintptr_t state;
+	uint32_t polls = 0;
+#ifdef I2C_FREERTOS
+	TickType_t ticks = (timeout == I2C_WAIT_FOREVER) ? portMAX_DELAY : (TickType_t) timeout;
+	TimeOut_t time_out;
+	int timed_out;
+#else
+	(void) timeout;
+#endif
+
+	if (q == NULL)
+		return ENXIO;
+
+	if ((xfer->read_len != 0 && xfer->read_data == NULL) ||
+	    (xfer->write_len != 0 && xfer->write_data == NULL))
+		return EREMOTEIO;
+
+	xfer->next = NULL;
+	xfer->waiter = NULL;
+	xfer->done = 0;
+	xfer->result = I2C_SUCCESS;
+#ifdef I2C_FREERTOS
+	if (can_block)
+		xfer->waiter = xTaskGetCurrentTaskHandle();
+	vTaskSetTimeOutState(&time_out);
+#endif
+
+	state = i2c_irq_save();
+
+	if (!can_block)
+	{
+		if (q->head != NULL)
+		{
+			i2c_irq_restore(state);
+			return EI2C_BUSY;
+		}
+		q->stats.polled++;
+	}
+
+	if (q->tail != NULL)
+		q->tail->next = xfer;
+	else
+		q->head = xfer;
+	q->tail = xfer;
+
+	while (!xfer->done)
+	{
+		if (q->head == xfer && !q->running)
+		{
+			/* The controller is not touched by the isr while no
+			   transaction runs, so the bus can be polled with
+			   interrupts enabled. */
+			i2c_irq_restore(state);
+			if (!i2c_async_bus_free(instance, q))
+			{
+				state = i2c_irq_save();
+				q->stats.bus_errors++;
+				wake = i2c_async_finish(q, xfer, EI2C_BUS_ERROR);
+				break;
+			}
+			state = i2c_irq_save();
+			i2c_async_start(instance, q);
+			polls = 0;
+			continue;
+		}
+
+		if (!can_block)
+		{
+			if (i2c_get_reg(instance, status) & I2C_PIN)
+			{
+				if (++polls == I2C_POLL_LIMIT)
+					wake = i2c_async_abort(instance, q, xfer);
+				continue;
+			}
+			i2c_async_step(instance, q, 0);
+			polls = 0;
+			continue;
+		}
+
+#ifdef I2C_FREERTOS
+		/* The kernel calls may leave a critical section, which
+		   enables interrupts, so they are made with them enabled. */
+		i2c_irq_restore(state);
+
+		timed_out = (xTaskCheckForTimeOut(&time_out, &ticks) != pdFALSE);
+		if (!timed_out)
+			ulTaskNotifyTake(pdTRUE, ticks);
+
+		state = i2c_irq_save();
+
+		if (timed_out && !xfer->done)
+			wake = i2c_async_abort(instance, q, xfer);
+#endif
+	}
+
+	i2c_irq_restore(state);
+
+#ifdef I2C_FREERTOS
+	if (wake != NULL)
+		xTaskNotifyGive((TaskHandle_t) wake);
+#else
+	(void) wake;
+#endif
+
+	return xfer->result;
+}
+
+/** @fn void i2c_get_async_stats(i2c_struct * instance, i2c_async_stats_t * stats)
+ * @brief Function to read the counters of an asynchronous i2c controller.
+ * @param i2c_struct* instance
+ * @param i2c_async_stats_t* stats --- copy of the counters, zeroed if the
+ *        instance is not asynchronous
+ */
+void i2c_get_async_stats(i2c_struct * instance, i2c_async_stats_t * stats)
+{
+	i2c_queue_t *q = i2c_queue_of(instance);
+	uintptr_t state;
+
+	if (q == NULL)
+	{
+		*stats = (i2c_async_stats_t) { 0 };
+		return;
+	}
+
+	state = i2c_irq_save();
+	*stats = q->stats;
+	i2c_irq_restore(state);
+}
+
+/** @fn void i2c_async_isr(uint32_t interrupt_id)
+ * @brief Function to service an asynchronous i2c controller's interrupt.
+ * @details Installed in isr_table by i2c_enable_async. Moves the running
+ *          transaction on by one byte and wakes its task when it is over.
+ * @param uint32_t interrupt_id
+ */
+void i2c_async_isr(uint32_t interrupt_id)
+{
+	uint32_t i = interrupt_id - PLIC_INTERRUPT_23;
+
+	if (i >= MAX_I2C_COUNT || !i2c_queue[i].enabled)
+		return;
+
+	i2c_queue[i].stats.interrupts++;
+	i2c_async_step(i2c_instance[i], &i2c_queue[i], 1);
+}
+#endif
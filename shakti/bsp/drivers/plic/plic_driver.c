@@ -30,6 +30,7 @@
 #include "pwm_driver.h"
 #include "plic_driver.h"
 #include "platform.h"
+#include "defines.h"
 #include "log.h"
 #include "stddef.h"
 #include "gpio.h"
@@ -49,26 +50,23 @@ interrupt_data_t hart0_interrupt_matrix[PLIC_MAX_INTERRUPT_SRC];
  */
 void interrupt_complete(uint32_t interrupt_id)
 {
-	log_trace("\ninterrupt_complete entered\n");
+	log_isr_trace("\ninterrupt_complete entered\n");
 
-	uint32_t *claim_addr =  (uint32_t *) (PLIC_BASE_ADDRESS +
-						      PLIC_CLAIM_OFFSET);
-
-	*claim_addr = interrupt_id;
+	plic_claim_write(interrupt_id);
 	hart0_interrupt_matrix[interrupt_id].state = SERVICED;
 	hart0_interrupt_matrix[interrupt_id].count++;
 
-	log_debug("interrupt id %d, state changed to %d\n", interrupt_id,
+	log_isr_debug("interrupt id %d, state changed to %d\n", interrupt_id,
 		 hart0_interrupt_matrix[interrupt_id].state);
 
-	log_debug("interrupt id = %x \n reset to default values state = %x \
+	log_isr_debug("interrupt id = %x \n reset to default values state = %x \
 		  \n priority = %x\n count = %x\n", \
 		  hart0_interrupt_matrix[interrupt_id].id, \
 		  hart0_interrupt_matrix[interrupt_id].state, \
 		  hart0_interrupt_matrix[interrupt_id].priority, \
 		  hart0_interrupt_matrix[interrupt_id].count);
 
-	log_trace("interrupt_complete exited\n");
+	log_isr_trace("interrupt_complete exited\n");
 }
 
 /** @fn uint32_t interrupt_claim_request()
@@ -79,10 +77,9 @@ void interrupt_complete(uint32_t interrupt_id)
  */
 uint32_t interrupt_claim_request()
 {
-	uint32_t *interrupt_claim_address = NULL;
 	uint32_t interrupt_id;
 
-	log_trace("\ninterrupt_claim_request entered\n");
+	log_isr_trace("\ninterrupt_claim_request entered\n");
 
 	/*
 	   return the interrupt id. This will be used to index into the plic isr table.
@@ -91,64 +88,105 @@ uint32_t interrupt_claim_request()
 	   refer https://gitlab.com/shaktiproject/uncore/devices/blob/master/plic/plic.bsv as on 26/8/2019
 	 */
 
-	interrupt_claim_address = (uint32_t *)(PLIC_BASE_ADDRESS + PLIC_CLAIM_OFFSET);
-
-	interrupt_id = *interrupt_claim_address;
+	interrupt_id = plic_claim_read();
 
-	log_debug("interrupt id [%x] claimed  at address %x\n", interrupt_id,
-		 interrupt_claim_address );
+	log_isr_debug("interrupt id [%x] claimed\n", interrupt_id);
 
-	log_trace("interrupt_claim_request exited\n");
+	log_isr_trace("interrupt_claim_request exited\n");
 
 	return interrupt_id;
 }
 
+#if PLIC_NESTING
+/** @fn static void dispatch_nested(uint32_t interrupt_id)
+ * @brief run an isr that higher priority interrupts may preempt
+ * @details Raises the threshold to the priority of the source, so that only
+ *          sources above it are taken, and enables interrupts around the isr.
+ *          mepc and mstatus are saved since a nested trap overwrites them.
+ * @param uint32_t interrupt_id
+ */
+static void dispatch_nested(uint32_t interrupt_id)
+{
+	volatile uint32_t *threshold = (volatile uint32_t *) (PLIC_BASE_ADDRESS +
+							      PLIC_THRESHOLD_OFFSET);
+	uint32_t saved_threshold = *threshold;
+	uintptr_t saved_mepc = read_csr(mepc);
+	uintptr_t saved_mstatus = read_csr(mstatus);
+
+	*threshold = hart0_interrupt_matrix[interrupt_id].priority;
+	set_csr(mstatus, MSTATUS_MIE);
+
+	isr_table[interrupt_id](interrupt_id);
+
+	clear_csr(mstatus, MSTATUS_MIE);
+	*threshold = saved_threshold;
+	write_csr(mepc, saved_mepc);
+	write_csr(mstatus, saved_mstatus);
+}
+#endif
+
 /** @fn void mach_plic_handler(uintptr_t int_id, uintptr_t epc)
  * @brief handle machine mode plic interrupts
- * @details find the int id that caused of interrupt, 
- *	    process it and complete the interrupt.
+ * @details Claims, services and completes interrupts until the claim
+ *          register reads zero, so interrupts that arrive back to back are
+ *          served without another trap. The PLIC hands out the highest
+ *          priority pending source first. The mcycle counts spent in each isr
+ *          are added to the source's entry in hart0_interrupt_matrix.
  * @param uintptr_t int_id
  * @param uintptr_t epc
  */
 void mach_plic_handler( __attribute__((unused)) uintptr_t int_id, __attribute__((unused)) uintptr_t epc)
 {
 	uint32_t  interrupt_id;
+	uint32_t cycles;
+	uintptr_t start;
 
-	log_trace("\nmach_plic_handler entered\n");
+	log_isr_trace("\nmach_plic_handler entered\n");
 
-	interrupt_id = interrupt_claim_request();
+	while ((interrupt_id = interrupt_claim_request()) != 0)
+	{
+		log_isr_debug("interrupt id claimed = %x\n", interrupt_id);
 
-	log_debug("interrupt id claimed = %x\n", interrupt_id);
+		if (interrupt_id >= PLIC_MAX_INTERRUPT_SRC)
+		{
+			log_fatal("Fatal error, interrupt id [%x] claimed is wrong\n", interrupt_id);
+		}
 
-	if (interrupt_id <= 0 || interrupt_id > PLIC_MAX_INTERRUPT_SRC)
-	{
-		log_fatal("Fatal error, interrupt id [%x] claimed is wrong\n", interrupt_id);
-	}
+		/*
+		   clear IP bit ?
 
-	/*
-	   clear IP bit ?
+		   After the highest-priority pending interrupt is claimed by a target and the corresponding
+		   IP bit is cleared, other lower-priority pending interrupts might then become visible to
+		   the target, and so the PLIC EIP bit might not be cleared after a claim
 
-	   After the highest-priority pending interrupt is claimed by a target and the corresponding
-	   IP bit is cleared, other lower-priority pending interrupts might then become visible to
-	   the target, and so the PLIC EIP bit might not be cleared after a claim
+		   reference - risc v priv spec v1.10 section 7.10 Interrupt Claims
+		 */
 
-	   reference - risc v priv spec v1.10 section 7.10 Interrupt Claims
-	 */
+		/*change state to active*/
+		hart0_interrupt_matrix[interrupt_id].state = ACTIVE;
 
-	/*change state to active*/
-	hart0_interrupt_matrix[interrupt_id].state = ACTIVE;
+		log_isr_debug("interrupt id %d, state changed to %d\n",
+			 interrupt_id,hart0_interrupt_matrix[interrupt_id].state);
 
-	log_debug("interrupt id %d, state changed to %d\n",
-		 interrupt_id,hart0_interrupt_matrix[interrupt_id].state);
+		/*call relevant interrupt service routine*/
+		start = read_csr(mcycle);
+#if PLIC_NESTING
+		dispatch_nested(interrupt_id);
+#else
+		isr_table[interrupt_id](interrupt_id);
+#endif
+		cycles = (uint32_t) (read_csr(mcycle) - start);
 
-	/*call relevant interrupt service routine*/
-	isr_table[interrupt_id](interrupt_id);
+		interrupt_complete(interrupt_id);
 
-	interrupt_complete(interrupt_id);
+		hart0_interrupt_matrix[interrupt_id].total_cycles += cycles;
+		if (cycles > hart0_interrupt_matrix[interrupt_id].max_cycles)
+			hart0_interrupt_matrix[interrupt_id].max_cycles = cycles;
 
-	log_debug("interrupt id %d complete \n", interrupt_id);
+		log_isr_debug("interrupt id %d complete \n", interrupt_id);
+	}
 
-	log_trace("\nmach_plic_handler exited\n");
+	log_isr_trace("\nmach_plic_handler exited\n");
 }
 
 /** @fn uint32_t isr_default(uint32_t interrupt_id) 
@@ -159,7 +197,7 @@ void mach_plic_handler( __attribute__((unused)) uintptr_t int_id, __attribute__(
  */
 void isr_default(uint32_t interrupt_id)
 {
-	log_trace("\nisr_default entered\n");
+	log_isr_trace("\nisr_default entered\n");
 
 	if( interrupt_id > 0 && interrupt_id < 7 )  //PWM Interrupts
 	{
@@ -173,9 +211,9 @@ void isr_default(uint32_t interrupt_id)
 		}
 	}
 
-	log_info("interrupt [%d] serviced\n",interrupt_id);
+	log_isr_info("interrupt [%d] serviced\n",interrupt_id);
 
-	log_trace("\nisr_default exited\n");
+	log_isr_trace("\nisr_default exited\n");
 }
 
 /** @fn void interrupt_enable(uint32_t interrupt_id)
@@ -307,6 +345,7 @@ void set_interrupt_priority(uint32_t priority_value, uint32_t int_id)
 	log_debug("current data at interrupt_priority_address = %x\n", *interrupt_priority_address);
 
 	*interrupt_priority_address = priority_value;
+	hart0_interrupt_matrix[int_id].priority = priority_value;
 
 	log_debug(" new data at interrupt_priority_address = %x\n", *interrupt_priority_address);
 
@@ -376,6 +415,8 @@ void plic_init()
 	hart0_interrupt_matrix[0].id = 0;
 	hart0_interrupt_matrix[0].priority = 0;
 	hart0_interrupt_matrix[0].count = 0;
+	hart0_interrupt_matrix[0].max_cycles = 0;
+	hart0_interrupt_matrix[0].total_cycles = 0;
 
 	interrupt_disable(int_id);
 
@@ -385,6 +426,8 @@ void plic_init()
 		hart0_interrupt_matrix[int_id].id = int_id;
 		hart0_interrupt_matrix[int_id].priority = PLIC_PRIORITY_3;
 		hart0_interrupt_matrix[int_id].count = 0;
+		hart0_interrupt_matrix[int_id].max_cycles = 0;
+		hart0_interrupt_matrix[int_id].total_cycles = 0;
 
 		log_debug("\n*************************************************");
 
@@ -438,3 +481,27 @@ void configure_interrupt(uint32_t int_id)
 
 	log_trace("configure_interrupt exited \n");
 }
+
+/** @fn void plic_print_stats(void)
+ * @brief print the count and isr cycles of each source
+ * @details Prints one line for each source that has been serviced, with its
+ *          count and the average and longest mcycle counts of its isr.
+ *          Call it from a task, not from an interrupt.
+ */
+void plic_print_stats(void)
+{
+	uint32_t int_id;
+
+	printf("\nid\tpriority\tcount\tavg cycles\tmax cycles\n");
+
+	for (int_id = 1; int_id < PLIC_MAX_INTERRUPT_SRC; int_id++)
+	{
+		interrupt_data_t *data = &hart0_interrupt_matrix[int_id];
+
+		if (data->count == 0)
+			continue;
+
+		printf("%u\t%u\t\t%u\t%u\t\t%u\n", int_id, data->priority, data->count,
+		       (uint32_t) (data->total_cycles / data->count), data->max_cycles);
+	}
+}
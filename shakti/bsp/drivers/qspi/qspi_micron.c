@@ -49,6 +49,9 @@ int* lprt     =  (int*) LPRT; /*! Low power Time Register */
 int* startmm  =  (int*) STARTMM; /*! Start Memory Map Register */
 int* endmm    =  (int*) ENDMM; /*! End Memory Map Register */
 
+/* Build with QSPI_EXTERNAL_REGS to supply the four register accessors
+   below from elsewhere, such as a model of the controller. */
+#ifndef QSPI_EXTERNAL_REGS
 /** @fn void set_qspi_shakti32(int* addr, int val)
  * @brief Writes 32 bit value into QSPI register.
  * @details Writes 32 bit value into passed address QSPI register.
@@ -92,6 +95,7 @@ int get_qspi_shakti(int* addr)
 {
 	return *addr;
 }
+#endif
 
 /** @fn void qspi_init(int fsize, int csht, int prescaler, int enable_interrupts, int fthreshold, int ck_mode)
  * @brief Initialises the qspi
@@ -789,3 +793,349 @@ int micron_read_configuration_register(int status, int value){
 	log_debug("Configuration Register Value: %08x",value);
 	return ret;
 }
+
+/*
+   Bulk program, erase and read.
+
+   The routines below move whole pages through the controller's fifo, and
+   poll the controller and the flash without the delays and prints of the
+   single word routines above. The fifo is filled or emptied a threshold at
+   a time, as told by SR_FTF, with the threshold that qspi_init set in CR.
+ */
+
+typedef struct
+{
+	int tag;	/* flash address of the line, or -1 */
+	uint8_t data[QSPI_CACHE_LINE_SIZE];
+} flash_cache_line_t;
+
+static flash_cache_line_t flash_cache[QSPI_CACHE_LINES] = {
+	[0 ... QSPI_CACHE_LINES - 1] = { .tag = -1 }
+};
+static flash_cache_stats_t flash_cache_stats;
+
+/** @fn static int qspi_fifo_threshold(void)
+ * @brief Returns the fifo threshold in bytes.
+ * @return FTHRES + 1 from the control register.
+ */
+static int qspi_fifo_threshold(void)
+{
+	return ((get_qspi_shakti(cr) >> 8) & 0x1F) + 1;
+}
+
+/** @fn static int qspi_wait_flag(int flag)
+ * @brief Waits for a status register flag without delays.
+ * @param int flag --- SR bit to wait for.
+ * @return Zero on success else -1
+ */
+static int qspi_wait_flag(int flag)
+{
+	int polls = QSPI_POLL_LIMIT;
+
+	while(!(get_qspi_shakti(sr) & flag)){
+		if(--polls == 0){
+			log_error("QSPI: timed out waiting for status %x\n", flag);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/** @fn static int flash_command(int instruction)
+ * @brief Sends an instruction that has no address or data.
+ * @param int instruction --- Instruction to send.
+ * @return Zero on success else -1
+ */
+static int flash_command(int instruction)
+{
+	int ret;
+
+	set_qspi_shakti32(ccr,(CCR_IMODE(SINGLE)|CCR_INSTRUCTION(instruction)));
+	ret = qspi_wait_flag(SR_TCF);
+	reset_interrupt_flags();
+	return ret;
+}
+
+/** @fn static int flash_wait_ready(void)
+ * @brief Waits for the flash to finish a program or erase.
+ * @details Reads the flash status register until WIP clears.
+ * @return Zero on success else -1
+ */
+static int flash_wait_ready(void)
+{
+	int polls = QSPI_POLL_LIMIT;
+	int value;
+
+	do{
+		set_qspi_shakti32(dlr,DL(1));
+		set_qspi_shakti32(ccr,(CCR_FMODE(CCR_FMODE_INDRD)|CCR_IMODE(SINGLE)|CCR_INSTRUCTION(0x05)|CCR_DMODE(SINGLE)));
+		if(qspi_wait_flag(SR_TCF))
+			return -1;
+		value = get_qspi_shakti(dr);
+		reset_interrupt_flags();
+		if(--polls == 0){
+			log_error("QSPI: flash stayed busy\n");
+			return -1;
+		}
+	}while(value & 0x01);
+	return 0;
+}
+
+/** @fn static int flash_erase_subsector(int address)
+ * @brief Erases the 4 KB subsector at address.
+ * @param int address --- Address of the subsector.
+ * @return Zero on success else -1
+ */
+static int flash_erase_subsector(int address)
+{
+	if(flash_command(0x06))
+		return -1;
+	set_qspi_shakti32(ccr,(CCR_FMODE(CCR_FMODE_INDWR)|CCR_ADSIZE(FOURBYTE)|CCR_ADMODE(SINGLE)|CCR_IMODE(SINGLE)|CCR_INSTRUCTION(0x21)));
+	set_qspi_shakti32(ar,address);
+	if(qspi_wait_flag(SR_TCF))
+		return -1;
+	reset_interrupt_flags();
+	flashCacheInvalidate(address, FLASH_SUBSECTOR_SIZE);
+	return flash_wait_ready();
+}
+
+/** @fn int flashXipActive()
+ * @brief Tells whether the controller is in memory mapped (XIP) mode.
+ * @details In XIP mode the flash is read through the STARTMM window, and
+ *          indirect commands would disturb it, so the bulk routines read
+ *          through the window and refuse to program or erase.
+ * @return One if XIP is active, else zero
+ */
+int flashXipActive(void)
+{
+	return ((get_qspi_shakti(ccr) >> 26) & 0x3) == CCR_FMODE_MMAPD;
+}
+
+/** @fn int flashPageProgramQuadSPI(int address, const uint8_t* data, int len)
+ * @brief Programs up to a page over quad SPI.
+ * @details Programs len bytes with one page program command and waits for
+ *          the flash to finish. The bytes must not cross a page boundary,
+ *          as the flash would wrap them to the start of the page. The flash
+ *          must have been erased.
+ * @param int address --- Address where data needs to be written.
+ * @param const uint8_t* data --- Bytes to write.
+ * @param int len --- Number of bytes, 1 to FLASH_PAGE_SIZE.
+ * @return Zero on success else -1
+ */
+int flashPageProgramQuadSPI(int address, const uint8_t* data, int len){
+	int threshold = qspi_fifo_threshold();
+	int done = 0;
+
+	if(len <= 0 || (address % FLASH_PAGE_SIZE) + len > FLASH_PAGE_SIZE || flashXipActive()){
+		log_error("QSPI: cannot program %d bytes at %x\n", len, address);
+		return -1;
+	}
+
+	if(flash_command(0x06))
+		return -1;
+
+	set_qspi_shakti32(dlr,DL(len));
+	set_qspi_shakti32(ccr,(CCR_FMODE(CCR_FMODE_INDWR)|CCR_DMODE(QUAD)|CCR_ADSIZE(FOURBYTE)|CCR_ADMODE(SINGLE)|CCR_IMODE(SINGLE)|CCR_INSTRUCTION(0x34)));
+	set_qspi_shakti32(ar,address);
+
+	while(done < len){
+		int chunk = (len - done < threshold) ? len - done : threshold;
+
+		if(qspi_wait_flag(SR_FTF))
+			return -1;
+
+		for(; chunk >= 4; chunk -= 4, done += 4)
+			set_qspi_shakti32(dr,(int) ((uint32_t) data[done] |
+					((uint32_t) data[done + 1] << 8) |
+					((uint32_t) data[done + 2] << 16) |
+					((uint32_t) data[done + 3] << 24)));
+		for(; chunk > 0; chunk--, done++)
+			set_qspi_shakti8((char*) dr,(char) data[done]);
+	}
+
+	if(qspi_wait_flag(SR_TCF))
+		return -1;
+	reset_interrupt_flags();
+	flashCacheInvalidate(address, len);
+	return flash_wait_ready();
+}
+
+/** @fn int flashWriteQuadSPI(int address, const uint8_t* data, int len, int erase)
+ * @brief Writes a buffer of any length over quad SPI.
+ * @details Splits the buffer at page boundaries and programs it a page at
+ *          a time. With erase set, each 4 KB subsector is erased when the
+ *          write reaches its start, so a write that starts part way into a
+ *          subsector leaves that subsector unerased. Nothing is written
+ *          while the controller is in XIP mode.
+ * @param int address --- Address where data needs to be written.
+ * @param const uint8_t* data --- Bytes to write.
+ * @param int len --- Number of bytes.
+ * @param int erase --- Nonzero to erase ahead of the write.
+ * @return Zero on success else -1
+ */
+int flashWriteQuadSPI(int address, const uint8_t* data, int len, int erase){
+	int done = 0;
+
+	if(flashXipActive())
+		return -1;
+
+	while(done < len){
+		int at = address + done;
+		int chunk = FLASH_PAGE_SIZE - (at % FLASH_PAGE_SIZE);
+
+		if(chunk > len - done)
+			chunk = len - done;
+
+		if(erase && (at % FLASH_SUBSECTOR_SIZE) == 0 && flash_erase_subsector(at))
+			return -1;
+
+		if(flashPageProgramQuadSPI(at, data + done, chunk))
+			return -1;
+
+		done += chunk;
+	}
+	return 0;
+}
+
+/** @fn int flashReadQuadSPIBuffer(int address, uint8_t* data, int len, int ddr)
+ * @brief Reads a buffer of any length over quad SPI.
+ * @details Reads len bytes with one quad I/O fast read command (0xEC), or
+ *          its DDR form (0xEE). In XIP mode the bytes are read through the
+ *          memory mapped window instead.
+ * @param int address --- Address from where data needs to be read.
+ * @param uint8_t* data --- Buffer for the bytes.
+ * @param int len --- Number of bytes.
+ * @param int ddr --- Nonzero to use the DDR read.
+ * @return Zero on success else -1
+ */
+int flashReadQuadSPIBuffer(int address, uint8_t* data, int len, int ddr){
+	int threshold;
+	int done = 0;
+
+	if(len <= 0)
+		return 0;
+
+	if(flashXipActive()){
+		for(; done < len; done++){
+			int at = address + done;
+			uint32_t word = (uint32_t) get_qspi_shakti((int*) (uintptr_t) (STARTMM + (at & ~3)));
+
+			data[done] = (uint8_t) (word >> ((at & 3) * 8));
+		}
+		return 0;
+	}
+
+	threshold = qspi_fifo_threshold();
+
+	set_qspi_shakti32(dlr,DL(len));
+	if(ddr)
+		set_qspi_shakti32(ccr,(CCR_DDRM|CCR_FMODE(CCR_FMODE_INDRD)|CCR_DMODE(QUAD)|CCR_DCYC(QSPI_DDR_READ_DUMMY)|CCR_ADSIZE(FOURBYTE)|CCR_ADMODE(QUAD)|CCR_IMODE(SINGLE)|CCR_INSTRUCTION(0xEE)));
+	else
+		set_qspi_shakti32(ccr,(CCR_FMODE(CCR_FMODE_INDRD)|CCR_DMODE(QUAD)|CCR_DCYC(QSPI_QUAD_READ_DUMMY)|CCR_ADSIZE(FOURBYTE)|CCR_ADMODE(QUAD)|CCR_IMODE(SINGLE)|CCR_INSTRUCTION(0xEC)));
+	set_qspi_shakti32(ar,address);
+
+	while(done < len){
+		int polls = QSPI_POLL_LIMIT;
+		int chunk;
+		int value;
+
+		/* A threshold's worth of bytes, or the rest once the transfer
+		   has completed */
+		for(;;){
+			value = get_qspi_shakti(sr);
+			if(value & (SR_FTF|SR_TCF))
+				break;
+			if(--polls == 0){
+				log_error("QSPI: read timed out at %x\n", address + done);
+				reset_interrupt_flags();
+				return -1;
+			}
+		}
+
+		chunk = (value & SR_FTF) ? threshold : len - done;
+		if(chunk > len - done)
+			chunk = len - done;
+
+		while(chunk > 0){
+			uint32_t word = (uint32_t) get_qspi_shakti(dr);
+			int i;
+
+			for(i = 0; i < 4 && chunk > 0; i++, chunk--)
+				data[done++] = (uint8_t) (word >> (i * 8));
+		}
+	}
+
+	if(qspi_wait_flag(SR_TCF))
+		return -1;
+	reset_interrupt_flags();
+	return 0;
+}
+
+/** @fn int flashCachedRead(int address, uint8_t* data, int len)
+ * @brief Reads through the read cache.
+ * @details Serves the bytes from the cache where it holds their line, and
+ *          otherwise reads the whole line with flashReadQuadSPIBuffer.
+ *          Programming and erasing through this file drop the lines they
+ *          change; call flashCacheInvalidate after writing the flash any
+ *          other way.
+ * @param int address --- Address from where data needs to be read.
+ * @param uint8_t* data --- Buffer for the bytes.
+ * @param int len --- Number of bytes.
+ * @return Zero on success else -1
+ */
+int flashCachedRead(int address, uint8_t* data, int len){
+	int done = 0;
+
+	while(done < len){
+		int at = address + done;
+		int tag = at & ~(QSPI_CACHE_LINE_SIZE - 1);
+		int offset = at - tag;
+		int chunk = QSPI_CACHE_LINE_SIZE - offset;
+		flash_cache_line_t* line = &flash_cache[(tag / QSPI_CACHE_LINE_SIZE) & (QSPI_CACHE_LINES - 1)];
+		int i;
+
+		if(chunk > len - done)
+			chunk = len - done;
+
+		if(line->tag == tag)
+			flash_cache_stats.hits++;
+		else{
+			line->tag = -1;
+			if(flashReadQuadSPIBuffer(tag, line->data, QSPI_CACHE_LINE_SIZE, 0))
+				return -1;
+			line->tag = tag;
+			flash_cache_stats.misses++;
+		}
+
+		for(i = 0; i < chunk; i++)
+			data[done + i] = line->data[offset + i];
+		done += chunk;
+	}
+	return 0;
+}
+
+/** @fn void flashCacheInvalidate(int address, int len)
+ * @brief Drops the cached lines that overlap a range of the flash.
+ * @param int address --- Start of the range.
+ * @param int len --- Length of the range.
+ */
+void flashCacheInvalidate(int address, int len){
+	int i;
+
+	for(i = 0; i < QSPI_CACHE_LINES; i++){
+		int tag = flash_cache[i].tag;
+
+		if(tag != -1 && tag < address + len && tag + QSPI_CACHE_LINE_SIZE > address){
+			flash_cache[i].tag = -1;
+			flash_cache_stats.invalidations++;
+		}
+	}
+}
+
+/** @fn void flashCacheStats(flash_cache_stats_t* stats)
+ * @brief Copies the read cache counters.
+ * @param flash_cache_stats_t* stats --- Where to copy them.
+ */
+void flashCacheStats(flash_cache_stats_t* stats){
+	*stats = flash_cache_stats;
+}
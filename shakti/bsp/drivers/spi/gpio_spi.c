@@ -24,12 +24,23 @@
 @file   gpio_spi.c
 @brief  Contains the driver routines for GPIO based SPI interface.
 @detail The GPIO_SPI module driver supports SPI driver routines using GPIO lines as SPI lines.
+Built with CLINT_TIMER, delay is the time in microseconds each half of an
+sclk period is held for, timed by udelay(). Without it delay stays the
+delay_loop() count it always was.
 */
 
 #include "platform.h"
 #include "gpio.h"
 #include "gpio_spi.h"
 
+#ifdef CLINT_TIMER
+#include "clint_timer.h"
+#define GPIO_SPI_DELAY(delay)	udelay(delay)
+#else
+extern void delay_loop(unsigned long , unsigned long);
+#define GPIO_SPI_DELAY(delay)	delay_loop(delay, delay)
+#endif
+
 /** @fn static void writebyte(unsigned char writeData, unsigned char delay)
  * @brief Writes a byte
  * @details This function writes a byte into SPI Slave device using GPIO lines.
@@ -56,19 +67,19 @@ static void writebyte(unsigned char writeData, unsigned char delay)
 
         if (k == 0) {
 			write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(SPI_MOSI)) );
-			delay_loop(delay, delay);
+			GPIO_SPI_DELAY(delay);
 		}
 		else {
 			write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | SPI_MOSI) );
-			delay_loop(delay, delay);
+			GPIO_SPI_DELAY(delay);
 		}
 
-        //delay_loop(delay,delay);
+        //GPIO_SPI_DELAY(delay);
         // making sck up 
 		//write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | SPI_SCLK));
         // sck down
         write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(SPI_SCLK)) );
-        //delay_loop(delay, delay);
+        //GPIO_SPI_DELAY(delay);
 		++j;
 	}
         // MAKE SS PIN high after transfer of a byte
@@ -91,7 +102,7 @@ unsigned char readbyte(unsigned char delay)
 	readData = read_word(GPIO_DATA_REG);
 	while (j < 8) {
 		write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) | SPI_SCLK) );
-		delay_loop(delay, delay);
+		GPIO_SPI_DELAY(delay);
 
 		readGpioData = read_word(GPIO_DATA_REG)  & SPI_MISO;
 
@@ -103,10 +114,10 @@ unsigned char readbyte(unsigned char delay)
         readData = readData << 1;
 		readData = readData | bitValue;
 		
-        delay_loop(delay, delay);
+        GPIO_SPI_DELAY(delay);
 
 		write_word(GPIO_DATA_REG, (read_word(GPIO_DATA_REG) & ~(SPI_SCLK)));
-		delay_loop(delay, delay);
+		GPIO_SPI_DELAY(delay);
 		++j;
 	}
 	return readData;
@@ -134,7 +145,11 @@ int config()
     {
     writebyte(writeData,delay);
     printf("%d\n",writeData);
+#ifdef CLINT_TIMER
+    udelay(1000);
+#else
     delay_loop(100,120);
+#endif
     }
 }
 
@@ -0,0 +1,542 @@
+/***************************************************************************
+ * Project                               :  shakti devt board
+ * Name of the file                      :  spi_flash_block.c
+ * Brief Description of file             :  Block layer over the spi flash drivers.
+ * Name of Author                        :
+ * Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+ * @file spi_flash_block.c
+ * @brief Block layer over the spi flash drivers.
+ * @detail Reads and writes any byte range of the flash through a small write
+ * back cache of pages. A dirty page reaches the flash as one page program
+ * covering the bytes that changed. NOR flash can only clear bits, so a page
+ * that needs a bit set again has its sector read back, erased and rewritten
+ * when a sector buffer was given to flash_block_init(), and fails otherwise.
+ * flash_block_erase() queues erases, which run before the first program into
+ * their sector, or at the next sync. Once a sector is erased, its pages are
+ * programmed without first being read, until they have been programmed once.
+ * Reads of whole pages that are not cached go straight to the flash in one
+ * call.
+ */
+
+#include <string.h>
+#include "spi_flash_block.h"
+
+/**
+ * @fn static uint32_t sector_of(flash_block_t* dev, uint32_t address)
+ * @brief returns the start of the sector holding an address
+ */
+static uint32_t sector_of(flash_block_t* dev, uint32_t address)
+{
+	return address & ~(dev->ops->sector_size - 1);
+}
+
+/**
+ * @fn static int in_range(flash_block_t* dev, uint32_t address, uint32_t len)
+ * @brief checks that a byte range lies inside the flash
+ */
+static int in_range(flash_block_t* dev, uint32_t address, uint32_t len)
+{
+	return address <= dev->ops->size && len <= dev->ops->size - address;
+}
+
+/**
+ * @fn static int erase_slot(flash_block_t* dev, uint32_t sector)
+ * @brief returns the erase slot of a sector, or -1 if it has none
+ */
+static int erase_slot(flash_block_t* dev, uint32_t sector)
+{
+	int i;
+
+	for (i = 0; i < FLASH_BLOCK_ERASE_SLOTS; i++)
+	{
+		if (dev->erases[i].sector == sector)
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+ * @fn static int page_erased(flash_block_t* dev, uint32_t page)
+ * @brief tells whether a page is known to read as erased
+ * @details True when the erase of its sector is queued, or has run and the
+ *          page has not been programmed since.
+ */
+static int page_erased(flash_block_t* dev, uint32_t page)
+{
+	int slot = erase_slot(dev, sector_of(dev, page));
+	uint32_t index;
+
+	if (slot < 0)
+		return 0;
+
+	index = (page - dev->erases[slot].sector) / FLASH_BLOCK_PAGE_SIZE;
+	return !dev->erases[slot].erased || !(dev->erases[slot].programmed[index / 32] & (1U << (index % 32)));
+}
+
+/**
+ * @fn static flash_block_line_t* find_line(flash_block_t* dev, uint32_t page)
+ * @brief returns the cache line holding a page, or NULL
+ */
+static flash_block_line_t* find_line(flash_block_t* dev, uint32_t page)
+{
+	int i;
+
+	for (i = 0; i < FLASH_BLOCK_CACHE_PAGES; i++)
+	{
+		if (dev->lines[i].address == page)
+			return &dev->lines[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * @fn static int read_flash(flash_block_t* dev, uint32_t address, uint8_t* data, uint32_t len)
+ * @brief reads bytes from the flash and counts the read
+ */
+static int read_flash(flash_block_t* dev, uint32_t address, uint8_t* data, uint32_t len)
+{
+	dev->stats.reads++;
+	dev->stats.read_bytes += len;
+
+	return dev->ops->read(address, data, len);
+}
+
+/**
+ * @fn static int program_page(flash_block_t* dev, uint32_t page, const uint8_t* data, const uint8_t* old)
+ * @brief programs the bytes of a page that differ from what the flash holds
+ * @details One program covers the first to the last changed byte. Bytes in
+ *          between that did not change are programmed with their own value,
+ *          which leaves them as they are. The page is marked programmed in
+ *          the erase slot of its sector.
+ * @param old --- What the page holds now, or NULL if it is erased
+ */
+static int program_page(flash_block_t* dev, uint32_t page, const uint8_t* data, const uint8_t* old)
+{
+	int first = -1;
+	int last = -1;
+	int slot;
+	int i;
+
+	for (i = 0; i < FLASH_BLOCK_PAGE_SIZE; i++)
+	{
+		if (data[i] != (old ? old[i] : 0xFF))
+		{
+			if (first < 0)
+				first = i;
+			last = i;
+		}
+	}
+
+	if (first < 0)
+		return 0;
+
+	slot = erase_slot(dev, sector_of(dev, page));
+	if (slot >= 0)
+	{
+		uint32_t index = (page - dev->erases[slot].sector) / FLASH_BLOCK_PAGE_SIZE;
+
+		dev->erases[slot].programmed[index / 32] |= 1U << (index % 32);
+	}
+
+	dev->stats.programs++;
+	dev->stats.program_bytes += last - first + 1;
+
+	return dev->ops->program(page + first, data + first, last - first + 1);
+}
+
+/**
+ * @fn static int run_erase(flash_block_t* dev, int slot)
+ * @brief carries out a queued erase
+ * @details Erases the sector and programs the dirty pages cached for it. The
+ *          slot then tracks which pages have been programmed since.
+ */
+static int run_erase(flash_block_t* dev, int slot)
+{
+	flash_block_erase_t* erase = &dev->erases[slot];
+	int ret = 0;
+	int i;
+
+	dev->stats.erases++;
+	if (dev->ops->erase(erase->sector))
+	{
+		erase->sector = FLASH_BLOCK_NO_PAGE;
+		return -1;
+	}
+
+	erase->erased = 1;
+	memset(erase->programmed, 0, sizeof(erase->programmed));
+
+	for (i = 0; i < FLASH_BLOCK_CACHE_PAGES; i++)
+	{
+		flash_block_line_t* line = &dev->lines[i];
+
+		if (line->dirty && sector_of(dev, line->address) == erase->sector)
+		{
+			if (program_page(dev, line->address, line->data, NULL))
+				ret = -1;
+			line->dirty = 0;
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * @fn static int rewrite_sector(flash_block_t* dev, uint32_t sector)
+ * @brief erases a sector and writes it back with its dirty pages merged in
+ */
+static int rewrite_sector(flash_block_t* dev, uint32_t sector)
+{
+	uint32_t size = dev->ops->sector_size;
+	uint32_t offset;
+	int ret = 0;
+	int i;
+
+	if (!dev->sector_buf)
+	{
+		dev->stats.need_erase++;
+		return -1;
+	}
+
+	/* The rewrite programs every page, so the slot would learn nothing. */
+	i = erase_slot(dev, sector);
+	if (i >= 0)
+		dev->erases[i].sector = FLASH_BLOCK_NO_PAGE;
+
+	if (read_flash(dev, sector, dev->sector_buf, size))
+		return -1;
+
+	for (i = 0; i < FLASH_BLOCK_CACHE_PAGES; i++)
+	{
+		flash_block_line_t* line = &dev->lines[i];
+
+		if (line->dirty && sector_of(dev, line->address) == sector)
+		{
+			memcpy(dev->sector_buf + (line->address - sector), line->data, FLASH_BLOCK_PAGE_SIZE);
+			line->dirty = 0;
+		}
+	}
+
+	dev->stats.sector_rewrites++;
+	dev->stats.erases++;
+	if (dev->ops->erase(sector))
+		return -1;
+
+	for (offset = 0; offset < size; offset += FLASH_BLOCK_PAGE_SIZE)
+	{
+		if (program_page(dev, sector + offset, dev->sector_buf + offset, NULL))
+			ret = -1;
+	}
+
+	return ret;
+}
+
+/**
+ * @fn static int write_back(flash_block_t* dev, flash_block_line_t* line)
+ * @brief writes a dirty cache line to the flash
+ */
+static int write_back(flash_block_t* dev, flash_block_line_t* line)
+{
+	uint8_t now[FLASH_BLOCK_PAGE_SIZE];
+	uint32_t sector = sector_of(dev, line->address);
+	int slot = erase_slot(dev, sector);
+	int i;
+
+	if (slot >= 0 && !dev->erases[slot].erased)
+		return run_erase(dev, slot);
+
+	if (page_erased(dev, line->address))
+	{
+		line->dirty = 0;
+		return program_page(dev, line->address, line->data, NULL);
+	}
+
+	if (read_flash(dev, line->address, now, FLASH_BLOCK_PAGE_SIZE))
+		return -1;
+
+	for (i = 0; i < FLASH_BLOCK_PAGE_SIZE; i++)
+	{
+		if ((now[i] & line->data[i]) != line->data[i])
+			return rewrite_sector(dev, sector);
+	}
+
+	line->dirty = 0;
+	return program_page(dev, line->address, line->data, now);
+}
+
+/**
+ * @fn static flash_block_line_t* get_line(flash_block_t* dev, uint32_t page, int fill)
+ * @brief returns the cache line for a page, loading it on a miss
+ * @details The least recently used line is written back if dirty and reused.
+ * @param fill --- Zero when the caller overwrites the whole page
+ * @return the line, or NULL if the flash could not be read or written
+ */
+static flash_block_line_t* get_line(flash_block_t* dev, uint32_t page, int fill)
+{
+	flash_block_line_t* line = find_line(dev, page);
+	int i;
+
+	if (line)
+	{
+		dev->stats.cache_hits++;
+		line->used = ++dev->clock;
+		return line;
+	}
+
+	dev->stats.cache_misses++;
+	line = &dev->lines[0];
+	for (i = 1; i < FLASH_BLOCK_CACHE_PAGES; i++)
+	{
+		if (dev->lines[i].used < line->used)
+			line = &dev->lines[i];
+	}
+
+	if (line->dirty && write_back(dev, line))
+		return NULL;
+
+	line->address = FLASH_BLOCK_NO_PAGE;
+	if (fill)
+	{
+		if (page_erased(dev, page))
+			memset(line->data, 0xFF, FLASH_BLOCK_PAGE_SIZE);
+		else if (read_flash(dev, page, line->data, FLASH_BLOCK_PAGE_SIZE))
+			return NULL;
+	}
+
+	line->address = page;
+	line->used = ++dev->clock;
+	line->dirty = 0;
+	return line;
+}
+
+/**
+ * @fn void flash_block_init(flash_block_t* dev, const flash_block_ops_t* ops, uint8_t* sector_buf)
+ * @brief sets up a block device over a flash part
+ * @param dev --- Device to set up
+ * @param ops --- Geometry and calls of the part, such as w25q32_flash_ops
+ * @param sector_buf --- ops->sector_size bytes used to rewrite a sector, or NULL
+ */
+void flash_block_init(flash_block_t* dev, const flash_block_ops_t* ops, uint8_t* sector_buf)
+{
+	int i;
+
+	memset(dev, 0, sizeof(*dev));
+	dev->ops = ops;
+	dev->sector_buf = sector_buf;
+
+	for (i = 0; i < FLASH_BLOCK_CACHE_PAGES; i++)
+		dev->lines[i].address = FLASH_BLOCK_NO_PAGE;
+
+	for (i = 0; i < FLASH_BLOCK_ERASE_SLOTS; i++)
+		dev->erases[i].sector = FLASH_BLOCK_NO_PAGE;
+}
+
+/**
+ * @fn int flash_block_read(flash_block_t* dev, uint32_t address, uint8_t* data, uint32_t len)
+ * @brief reads a byte range, including writes not yet synced
+ * @param dev --- Block device
+ * @param address --- Flash address to read from
+ * @param data --- Buffer for the bytes
+ * @param len --- Number of bytes
+ * @return Zero on success else -1
+ */
+int flash_block_read(flash_block_t* dev, uint32_t address, uint8_t* data, uint32_t len)
+{
+	if (!in_range(dev, address, len))
+		return -1;
+
+	while (len)
+	{
+		uint32_t page = address & ~(FLASH_BLOCK_PAGE_SIZE - 1);
+		uint32_t offset = address - page;
+		uint32_t chunk = FLASH_BLOCK_PAGE_SIZE - offset;
+		flash_block_line_t* line = find_line(dev, page);
+
+		if (chunk > len)
+			chunk = len;
+
+		if (line)
+		{
+			dev->stats.cache_hits++;
+			line->used = ++dev->clock;
+			memcpy(data, line->data + offset, chunk);
+		}
+		else if (page_erased(dev, page))
+		{
+			memset(data, 0xFF, chunk);
+		}
+		else if (chunk == FLASH_BLOCK_PAGE_SIZE)
+		{
+			/* Read this and the following uncached pages in one go. */
+			uint32_t next = page + FLASH_BLOCK_PAGE_SIZE;
+
+			while (len - chunk >= FLASH_BLOCK_PAGE_SIZE && !find_line(dev, next) &&
+			       !page_erased(dev, next))
+			{
+				chunk += FLASH_BLOCK_PAGE_SIZE;
+				next += FLASH_BLOCK_PAGE_SIZE;
+			}
+
+			if (read_flash(dev, page, data, chunk))
+				return -1;
+		}
+		else
+		{
+			line = get_line(dev, page, 1);
+			if (!line)
+				return -1;
+			memcpy(data, line->data + offset, chunk);
+		}
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @fn int flash_block_write(flash_block_t* dev, uint32_t address, const uint8_t* data, uint32_t len)
+ * @brief writes a byte range into the cache
+ * @details The bytes reach the flash when their page is evicted or at the
+ *          next flash_block_sync().
+ * @param dev --- Block device
+ * @param address --- Flash address to write to
+ * @param data --- Bytes to write
+ * @param len --- Number of bytes
+ * @return Zero on success else -1
+ */
+int flash_block_write(flash_block_t* dev, uint32_t address, const uint8_t* data, uint32_t len)
+{
+	if (!in_range(dev, address, len))
+		return -1;
+
+	while (len)
+	{
+		uint32_t page = address & ~(FLASH_BLOCK_PAGE_SIZE - 1);
+		uint32_t offset = address - page;
+		uint32_t chunk = FLASH_BLOCK_PAGE_SIZE - offset;
+		flash_block_line_t* line;
+
+		if (chunk > len)
+			chunk = len;
+
+		line = get_line(dev, page, chunk != FLASH_BLOCK_PAGE_SIZE);
+		if (!line)
+			return -1;
+
+		memcpy(line->data + offset, data, chunk);
+		line->dirty = 1;
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @fn int flash_block_erase(flash_block_t* dev, uint32_t address, uint32_t len)
+ * @brief queues the erase of whole sectors
+ * @details The sectors read as erased straight away, and writes made after
+ *          this call are kept. Each erase runs before the first program into
+ *          its sector, or at the next sync. A slot is taken from a sector
+ *          erased earlier, or if every slot holds a queued erase, the erase
+ *          in the first slot runs now to make room.
+ * @param dev --- Block device
+ * @param address --- Start of the first sector
+ * @param len --- Length, a multiple of the sector size
+ * @return Zero on success else -1
+ */
+int flash_block_erase(flash_block_t* dev, uint32_t address, uint32_t len)
+{
+	uint32_t size = dev->ops->sector_size;
+	uint32_t sector;
+	int i;
+
+	if (!in_range(dev, address, len) || ((address | len) & (size - 1)))
+		return -1;
+
+	for (sector = address; sector - address < len; sector += size)
+	{
+		int slot;
+
+		for (i = 0; i < FLASH_BLOCK_CACHE_PAGES; i++)
+		{
+			flash_block_line_t* line = &dev->lines[i];
+
+			if (line->address != FLASH_BLOCK_NO_PAGE && sector_of(dev, line->address) == sector)
+			{
+				memset(line->data, 0xFF, FLASH_BLOCK_PAGE_SIZE);
+				line->dirty = 0;
+			}
+		}
+
+		slot = erase_slot(dev, sector);
+		if (slot < 0)
+			slot = erase_slot(dev, FLASH_BLOCK_NO_PAGE);
+		for (i = 0; slot < 0 && i < FLASH_BLOCK_ERASE_SLOTS; i++)
+		{
+			if (dev->erases[i].erased)
+				slot = i;
+		}
+		if (slot < 0)
+		{
+			slot = 0;
+			if (run_erase(dev, slot))
+				return -1;
+		}
+
+		dev->erases[slot].sector = sector;
+		dev->erases[slot].erased = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * @fn int flash_block_sync(flash_block_t* dev)
+ * @brief writes every dirty page and runs every queued erase
+ * @param dev --- Block device
+ * @return Zero on success else -1
+ */
+int flash_block_sync(flash_block_t* dev)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < FLASH_BLOCK_CACHE_PAGES; i++)
+	{
+		if (dev->lines[i].dirty && write_back(dev, &dev->lines[i]))
+			ret = -1;
+	}
+
+	for (i = 0; i < FLASH_BLOCK_ERASE_SLOTS; i++)
+	{
+		if (dev->erases[i].sector != FLASH_BLOCK_NO_PAGE && !dev->erases[i].erased && run_erase(dev, i))
+			ret = -1;
+	}
+
+	return ret;
+}
@@ -26,117 +26,123 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 @detail Configures SPI, flash device and then do all basic flash oerations.* 
 */
 #include "spi.h"
+#include "spi_flash_block.h"
 #include "utils.h"
-int* spi_cr1    = (int*) SPI_CR1;
-int* spi_cr2    = (int*) SPI_CR2;
-int* spi_sr     = (int*) SPI_SR ;
-int* spi_dr1    = (int*) SPI_DR1 ;
-int* spi_dr2    = (int*) SPI_DR2 ;
-int* spi_dr3    = (int*) SPI_DR3 ;
-int* spi_dr4    = (int*) SPI_DR4 ;
-int* spi_dr5    = (int*) SPI_DR5 ;
-int* spi_crcpr  = (int*) SPI_CRCPR;
-int* spi_rxcrcr = (int*) SPI_RXCRCR;
-int* spi_txcrcr = (int*) SPI_TXCRCR; 
+#include "log.h"
+uint32_t* spi_cr1    = (uint32_t*) SPI_CR1;
+uint32_t* spi_cr2    = (uint32_t*) SPI_CR2;
+uint32_t* spi_sr     = (uint32_t*) SPI_SR ;
+uint32_t* spi_dr1    = (uint32_t*) SPI_DR1;
+uint32_t* spi_dr2    = (uint32_t*) SPI_DR2;
+uint32_t* spi_dr3    = (uint32_t*) SPI_DR3;
+uint32_t* spi_dr4    = (uint32_t*) SPI_DR4;
+uint32_t* spi_dr5    = (uint32_t*) SPI_DR5;
+uint32_t* spi_crcpr  = (uint32_t*) SPI_CRCPR;
+uint32_t* spi_rxcrcr = (uint32_t*) SPI_RXCRCR;
+uint32_t* spi_txcrcr = (uint32_t*) SPI_TXCRCR;
 
 
 //By default, spi 0 is configured
 /**
- * @fn void configure_spi(int offset)
+ * @fn void configure_spi(uint32_t offset)
  * @brief assigns memory mapped addres value to SPI registers.
  * @details Takes the SPI Base address and then adds offset to each and every
  *          spi registers..
  * @param int* ---> offset value 
  */
-void configure_spi(int offset)	
+void configure_spi(uint32_t offset)	
 {
-	spi_cr1    = (int*) (SPI_CR1 + offset);
-	spi_cr2    = (int*) (SPI_CR2 + offset);
-	spi_sr     = (int*) (SPI_SR + offset);
-	spi_dr1    = (int*) (SPI_DR1 + offset);
-	spi_dr2    = (int*) (SPI_DR2 + offset);
-	spi_dr3    = (int*) (SPI_DR3 + offset);
-	spi_dr4    = (int*) (SPI_DR4 + offset);
-	spi_dr5    = (int*) (SPI_DR5 + offset);
-	spi_crcpr  = (int*) (SPI_CRCPR + offset);
-	spi_rxcrcr = (int*) (SPI_RXCRCR + offset);
-	spi_txcrcr = (int*) (SPI_TXCRCR + offset); 
+	spi_cr1    = (uint32_t*) (SPI_CR1 + offset);
+	spi_cr2    = (uint32_t*) (SPI_CR2 + offset);
+	spi_sr     = (uint32_t*) (SPI_SR + offset);
+	spi_dr1    = (uint32_t*) (SPI_DR1 + offset);
+	spi_dr2    = (uint32_t*) (SPI_DR2 + offset);
+	spi_dr3    = (uint32_t*) (SPI_DR3 + offset);
+	spi_dr4    = (uint32_t*) (SPI_DR4 + offset);
+	spi_dr5    = (uint32_t*) (SPI_DR5 + offset);
+	spi_crcpr  = (uint32_t*) (SPI_CRCPR + offset);
+	spi_rxcrcr = (uint32_t*) (SPI_RXCRCR + offset);
+	spi_txcrcr = (uint32_t*) (SPI_TXCRCR + offset); 
 }
 
+/* Build with SPI_EXTERNAL_REGS to supply set_spi() and get_spi() from
+   elsewhere, such as a model of the controller. */
+#ifndef SPI_EXTERNAL_REGS
 /**
- * @fn void set_spi(int* addr, int val)
+ * @fn void set_spi(uint32_t* addr, uint32_t val)
  * @brief to assign value to memory mapped spi register
  * @details writes the given value to given addres (SPI).
  * @param int* addr
  * @param int val
  */
-void set_spi(int* addr, int val)
+void set_spi(uint32_t* addr, uint32_t val)
 {
 	*addr = val;
 }
 
 /**
- * @fn int get_spi(int* addr)
+ * @fn uint32_t get_spi(uint32_t* addr)
  * @brief to get value for memory mapped spi register
  * @details Reads the SPI register value from passed address.
  * @param int* ---> address from where read has to happen
  * @return int ---> SPI Register read value.
  */
-int get_spi(int* addr)
+uint32_t get_spi(uint32_t* addr)
 {
 	return *addr;
 }
+#endif
 
-/** @fn void spi_init()
+/** @fn void spi_init(void)
  * @brief setting up baud rate and clock pole and phase 
  * @details Initialize the spi controller in Mode 3 (CPOL =1 & CPHA =1) with SCK= clk/16;
  */
-void spi_init()
+void spi_init(void)
 {
 	set_spi(spi_cr1, (SPI_BR(7)|SPI_CPHA|SPI_CPOL));
 }
 
-/** @fn void spi_tx_rx_start()
+/** @fn void spi_tx_rx_start(void)
  * @brief to start receiving data as soon as transmit state is complete
  * @details While receiving data from flash (reading Device ID, status register and reading flash)   
  *           in master mode use this function.
  * @warning Should be set before configuring the control register 1.
  */
-void spi_tx_rx_start()
+void spi_tx_rx_start(void)
 {
 	set_spi(spi_cr2, (SPI_RX_IMM_START));
 }
 
 
-/** @fn void spi_rx_enable()
+/** @fn void spi_rx_enable(void)
  * @brief to start receive state 
  * @details This is not in used when spi is in Master mode 
  */
-void spi_rx_enable()
+void spi_rx_enable(void)
 {
 	set_spi(spi_cr2, (SPI_RX_START));
 }
 
 /**
- * @fn int bitExtracted(int number, int k, int p) 
+ * @fn uint32_t bitExtracted(uint32_t number, uint32_t k, uint32_t p) 
  * @brief Extract the k number of bit from (p-1) position of 'number'
  * @details If one want to extract the k bits from (p-1) position in 32 bit "number".   
  * @param int (number (32 bit)), int (k (number of bits to be extracted)), 
  * @param int (p (position from where the bits to be extracted))
  * @return int (32 bit which have k bit from "number" and rest are zero)
  */
-int bitExtracted(int number, int k, int p) 
+uint32_t bitExtracted(uint32_t number, uint32_t k, uint32_t p) 
 {
 	return (((1 << k) - 1) & (number >> (p - 1))); 
 }
 
 /**
- * @fn int spi_rxne_enable()
+ * @fn uint32_t spi_rxne_enable(void)
  * @brief to check if receive buffer is empty or not
  * @details As soons as data come to receive buffer this bit is set.  
  * @return int (1: if there is data into the RxFIFO else 0)
  */
-int spi_rxne_enable()
+uint32_t spi_rxne_enable(void)
 {
 	int value = 0;
 
@@ -149,13 +155,13 @@ int spi_rxne_enable()
 }
 
 /**
- * @fn int spi_notbusy()
+ * @fn uint32_t spi_notbusy(void)
  * @brief to check if spi is ready for next transaction or busy with previous one
  * @details it read the status of bsy bit in spi_sr 
  * @warning One should check this bit before going to next transcation
  * @return int (0: SPI is busy in communication, 1: SPI nt busy)
  */
-int spi_notbusy()
+uint32_t spi_notbusy(void)
 {
 	int value = 0x80;
 
@@ -169,13 +175,13 @@ int spi_notbusy()
 }
 
 /**
- * @fn int flash_write_enable()
+ * @fn uint32_t flash_write_enable(void)
  * @brief to set the WEL (Write Enable Latch) bit in status register
  * @details Before modifying content of flash, one should enable the WEL bit first
  * @warning Without enabling this bit one cannot erase/write into the flash
  * @return int
  */
-int flash_write_enable()
+uint32_t flash_write_enable(void)
 {
 	set_spi(spi_dr1, 0x06000000);
 	set_spi(spi_dr5, 0x06);
@@ -185,12 +191,12 @@ int flash_write_enable()
 }
 
 /**
- * @fn int flash_clear_sr()
+ * @fn uint32_t flash_clear_sr(void)
  * @brief to reset the status register
  * @details It will reset the bits of status register
  * @return int
  */
-int flash_clear_sr()
+uint32_t flash_clear_sr(void)
 {
 	set_spi(spi_dr1,0x30000000);
 	set_spi(spi_dr5,0x30);
@@ -200,7 +206,7 @@ int flash_clear_sr()
 }
 
 /**
- * @fn int flash_cmd_addr(int command, int addr)
+ * @fn uint32_t flash_cmd_addr(uint32_t command, uint32_t addr)
  * @brief Use for sending 8bit of command + 32 bit of address 
  * @details Useful for function like erase
  * @warning to move data drom dr register to fifo there must be some data into spi_dr5 
@@ -208,7 +214,7 @@ int flash_clear_sr()
  * @param int (addr (address after the opcode))
  * @return int
  */
-int flash_cmd_addr(int command, int addr)
+uint32_t flash_cmd_addr(uint32_t command, uint32_t addr)
 {
 	printf("Erase dr1 \n");
 	set_spi(spi_dr1, ((command << 24) | (addr) ) );
@@ -220,7 +226,7 @@ int flash_cmd_addr(int command, int addr)
 }
 
 /**
- * @fn void flash_cmd_addr_data(int command, int addr, int data)
+ * @fn void flash_cmd_addr_data(uint32_t command, uint32_t addr, uint32_t data)
  * @brief useful for function like Write 
  * @details use for sending 8bit command +32bit of write address + 32 bit of write data
  * @warning to move data from data register to fifo there must be some data into spi_dr5
@@ -228,7 +234,7 @@ int flash_cmd_addr(int command, int addr)
  * @param int (addr(address after the opcode))
  * @param int (data (data after the address))
  */
-void flash_cmd_addr_data(int command, int addr, int data)
+void flash_cmd_addr_data(uint32_t command, uint32_t addr, uint32_t data)
 {
 #if 0
 	int address1 = bitExtracted(addr, 24, 9);
@@ -261,20 +267,20 @@ void flash_cmd_addr_data(int command, int addr, int data)
 }
 
 /**
- * @fn void flash_write(int address, int data)
+ * @fn void flash_write(uint32_t address, uint32_t data)
  * @brief  Write 4bytes of data from given address
  * @details flash_cmd_addr_data with opcode 12h.  
  * @warning before writing into the flash one should enable the WEL bit spi_sr by using write_enable()
  * @param int (addres (write address))
  * @param int(data (write data))
  */
-void flash_write(int address, int data)
+void flash_write(uint32_t address, uint32_t data)
 {
 	flash_cmd_addr_data(0x02, address,data);
 }
 
 /**
- * @fn int flash_cmd_to_read(int command, int addr)
+ * @fn uint32_t flash_cmd_to_read(uint32_t command, uint32_t addr)
  * @briefUse useful for function like read
  * @details for sending command of 8bit + read address of 32bit + 8bit of dummy cycle and receive 
  *          32bit value from flash 
@@ -284,7 +290,7 @@ void flash_write(int address, int data)
  * @param int (addr(read_address))
  * @return int 
  */
-int flash_cmd_to_read(int command, int addr)
+uint32_t flash_cmd_to_read(uint32_t command, uint32_t addr)
 {
 
 	int dr5;
@@ -302,20 +308,20 @@ int flash_cmd_to_read(int command, int addr)
 	 
 	if(spi_rxne_enable()) 
 	{
-		dr5 = *spi_dr5;
+		dr5 = get_spi(spi_dr5);
 	}
    // printf("Reading from dr5 %x \n", dr5);
 	return dr5;
 
 }
 
-/** @fn int flash_read(int address)
+/** @fn uint32_t flash_read(uint32_t address)
  * @brief read the 4bytes data from given address 
  * @details flash_cmd_to_read with opcode 0Bh for fast read
  * @param int (address (read address))
  * @return int 
  */
-int flash_read(int address)
+uint32_t flash_read(uint32_t address)
 {
 	int read_value = flash_cmd_to_read(0x0B,address);
 	
@@ -323,13 +329,13 @@ int flash_read(int address)
 }
 
 /**
- * @fn int flash_cmd_read(int command)
+ * @fn uint32_t flash_cmd_read(uint32_t command)
  * @brief usefull for reading status register
  * @details use for sending 8bit command and receive the 32bit of data
  * @param int command (opcode)
  * @return int  value (flash response to opcode)
  */
-int flash_cmd_read(int command)
+uint32_t flash_cmd_read(uint32_t command)
 {
 	int dr1, dr2, dr5;
 	set_spi(spi_dr1, command);
@@ -337,20 +343,20 @@ int flash_cmd_read(int command)
 	spi_tx_rx_start();
 	set_spi(spi_cr1, (SPI_BR(7)|SPI_TOTAL_BITS_TX(8)|SPI_TOTAL_BITS_RX(32)|SPI_SPE|SPI_CPHA|SPI_CPOL));
 	if(spi_rxne_enable()) {
-		dr5 = *spi_dr5;
+		dr5 = get_spi(spi_dr5);
 		}
 	
 	return dr5;
 }
 
 /**
- * @fn void flash_erase(int address)
+ * @fn void flash_erase(uint32_t address)
  * @brief Erase the flash
  * @details Erase the 64kb sector from given address 
  * @warning before erasing the flash one should enable the WEL bit spi_sr by using write_enable()
  * @param int (address (address from which data should erase))
  */
-void flash_erase(int address)
+void flash_erase(uint32_t address)
 {
 	printf("Cypress erase \n");
 	flash_cmd_addr(0xD8, address);
@@ -358,13 +364,13 @@ void flash_erase(int address)
 }
 
 /**
- * @fn int flash_status_register_read()
+ * @fn uint32_t flash_status_register_read(void)
  * @briefRead read status register of flash
  * @details  Using flash_cmd_read function with opcode 05h to check status of WIP(Write in progress) 
  *           and WEL(Write Enable Latch) bit.
  * @return int
  */
-int flash_status_register_read()
+uint32_t flash_status_register_read(void)
 {
 	int stat = 0x3;
 
@@ -385,7 +391,7 @@ int flash_status_register_read()
  * @warning to move data from data register to fifo there must be some data into spi_dr5
  * @return int
  */
-int flash_device_id()
+uint32_t flash_device_id(void)
 {
 	int dr1, dr2, dr3;
 	int val1, val2;
@@ -397,8 +403,8 @@ int flash_device_id()
 
 	if(spi_rxne_enable())
 	{
-		dr3 = *spi_dr5;
-		dr2 = *spi_dr2;
+		dr3 = get_spi(spi_dr5);
+		dr2 = get_spi(spi_dr2);
 	}
 
 	val1 = bitExtracted(dr3, 8, 17);
@@ -410,3 +416,198 @@ int flash_device_id()
 	return 1;	
 }
 
+
+/* Byte level calls for spi_flash_block.c. The part takes 3 byte addresses
+   and is erased in 4 KB sectors. */
+#define W25Q32_FLASH_SIZE	(4 * 1024 * 1024)
+#define W25Q32_SECTOR_SIZE	(4 * 1024)
+#define W25Q32_ADDR_BYTES	3
+
+/**
+ * @fn static int spi_transfer(const uint8_t* tx, uint32_t tx_len, uint32_t rx_len, uint32_t* rx)
+ * @brief sends up to 16 bytes from DR1..DR4 and receives up to 4 into DR5
+ * @details The bytes go out first byte first. The controller is polled for
+ *          the end of the transfer with no fixed delays.
+ * @param const uint8_t* (tx (bytes to send))
+ * @param uint32_t (tx_len (number of bytes to send))
+ * @param uint32_t (rx_len (number of bytes to receive))
+ * @param uint32_t* (rx (received bytes, the last one in the low byte))
+ * @return int (0 on success, -1 if the controller did not finish)
+ */
+static int spi_transfer(const uint8_t* tx, uint32_t tx_len, uint32_t rx_len, uint32_t* rx)
+{
+	uint32_t word[4] = { 0, 0, 0, 0 };
+	uint32_t i;
+
+	for (i = 0; i < tx_len; i++)
+		word[i / 4] |= (uint32_t) tx[i] << (24 - 8 * (i % 4));
+
+	set_spi(spi_dr1, word[0]);
+	set_spi(spi_dr2, word[1]);
+	set_spi(spi_dr3, word[2]);
+	set_spi(spi_dr4, word[3]);
+	set_spi(spi_dr5, 0);
+	if (rx_len)
+		spi_tx_rx_start();
+	set_spi(spi_cr1, (SPI_BR(7)|SPI_TOTAL_BITS_TX(tx_len * 8)|SPI_TOTAL_BITS_RX(rx_len * 8)|SPI_SPE|SPI_CPHA|SPI_CPOL));
+
+	for (i = 0; i < SPI_POLL_LIMIT; i++)
+	{
+		uint32_t sr = get_spi(spi_sr);
+
+		if (rx_len ? (sr & RXNE) : !(sr & SPI_BSY))
+		{
+			if (rx_len)
+				*rx = get_spi(spi_dr5);
+			return 0;
+		}
+	}
+
+	log_error("spi transfer timed out\n");
+	return -1;
+}
+
+/**
+ * @fn static uint32_t put_command(uint8_t* buf, uint8_t command, uint32_t address)
+ * @brief puts an opcode and a 3 byte address into a buffer
+ * @return uint32_t (number of bytes used)
+ */
+static uint32_t put_command(uint8_t* buf, uint8_t command, uint32_t address)
+{
+	uint32_t i;
+
+	buf[0] = command;
+	for (i = 0; i < W25Q32_ADDR_BYTES; i++)
+		buf[1 + i] = address >> (8 * (W25Q32_ADDR_BYTES - 1 - i));
+
+	return 1 + W25Q32_ADDR_BYTES;
+}
+
+/**
+ * @fn static int flash_wait_idle(void)
+ * @brief polls the status register until WIP clears
+ * @return int (0 on success, -1 on a controller time out)
+ */
+static int flash_wait_idle(void)
+{
+	uint8_t command = 0x05;
+	uint32_t status;
+
+	do
+	{
+		if (spi_transfer(&command, 1, 1, &status))
+			return -1;
+	} while (status & FLASH_STATUS_WIP);
+
+	return 0;
+}
+
+/**
+ * @fn static int flash_enable_write(void)
+ * @brief sets WEL with no fixed delays
+ * @return int (0 on success, -1 on a controller time out)
+ */
+static int flash_enable_write(void)
+{
+	uint8_t command = 0x06;
+
+	return spi_transfer(&command, 1, 0, NULL);
+}
+
+/**
+ * @fn int flash_read_bytes(uint32_t address, uint8_t* data, uint32_t len)
+ * @brief reads any number of bytes with the fast read (0Bh)
+ * @details Each transfer returns the 4 bytes DR5 can hold.
+ * @param uint32_t (address (read address))
+ * @param uint8_t* (data (buffer for the bytes))
+ * @param uint32_t (len (number of bytes))
+ * @return int (0 on success else -1)
+ */
+int flash_read_bytes(uint32_t address, uint8_t* data, uint32_t len)
+{
+	uint8_t buf[SPI_TX_BYTES_MAX];
+
+	while (len)
+	{
+		uint32_t chunk = len < SPI_RX_BYTES_MAX ? len : SPI_RX_BYTES_MAX;
+		uint32_t n = put_command(buf, 0x0B, address);
+		uint32_t word;
+		uint32_t i;
+
+		buf[n++] = 0;	/* dummy byte */
+		if (spi_transfer(buf, n, chunk, &word))
+			return -1;
+
+		for (i = 0; i < chunk; i++)
+			data[i] = word >> (8 * (chunk - 1 - i));
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @fn int flash_write_bytes(uint32_t address, const uint8_t* data, uint32_t len)
+ * @brief programs bytes inside one page with the page program (02h)
+ * @details Sends as many bytes as DR1..DR4 hold after the opcode and address,
+ *          and polls WIP after each program.
+ * @warning The bytes must be erased and must not cross a page boundary.
+ * @param uint32_t (address (write address))
+ * @param const uint8_t* (data (bytes to write))
+ * @param uint32_t (len (number of bytes))
+ * @return int (0 on success else -1)
+ */
+int flash_write_bytes(uint32_t address, const uint8_t* data, uint32_t len)
+{
+	uint8_t buf[SPI_TX_BYTES_MAX];
+
+	while (len)
+	{
+		uint32_t n = put_command(buf, 0x02, address);
+		uint32_t chunk = SPI_TX_BYTES_MAX - n;
+		uint32_t i;
+
+		if (chunk > len)
+			chunk = len;
+
+		for (i = 0; i < chunk; i++)
+			buf[n + i] = data[i];
+
+		if (flash_enable_write() || spi_transfer(buf, n + chunk, 0, NULL) || flash_wait_idle())
+			return -1;
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @fn int flash_erase_sector(uint32_t address)
+ * @brief erases the 4 KB sector holding an address (20h) and waits for it
+ * @param uint32_t (address (an address in the sector))
+ * @return int (0 on success else -1)
+ */
+int flash_erase_sector(uint32_t address)
+{
+	uint8_t buf[SPI_TX_BYTES_MAX];
+	uint32_t n = put_command(buf, 0x20, address);
+
+	if (flash_enable_write() || spi_transfer(buf, n, 0, NULL))
+		return -1;
+
+	return flash_wait_idle();
+}
+
+const flash_block_ops_t w25q32_flash_ops = {
+	W25Q32_FLASH_SIZE,
+	W25Q32_SECTOR_SIZE,
+	flash_read_bytes,
+	flash_write_bytes,
+	flash_erase_sector
+};
@@ -27,6 +27,7 @@
  */
 
 #include "spi.h"
+#include "spi_flash_block.h"
 #include "log.h"
 #include "utils.h"
 
@@ -65,6 +66,9 @@ void configure_spi(uint32_t offset)
 	spi_txcrcr = (uint32_t*) (SPI_TXCRCR + offset);
 }
 
+/* Build with SPI_EXTERNAL_REGS to supply set_spi() and get_spi() from
+   elsewhere, such as a model of the controller. */
+#ifndef SPI_EXTERNAL_REGS
 /**
  * @fn void set_spi(uint32_t* addr, uint32_t val)
  * @brief to assign value to memory mapped spi register
@@ -88,6 +92,7 @@ uint32_t get_spi(uint32_t* addr)
 {
 	return *addr;
 }
+#endif
 
 /** @fn void spi_init(void)
  * @brief setting up baud rate and clock pole and phase 
@@ -299,7 +304,7 @@ uint32_t flash_cmd_to_read(uint32_t command, uint32_t addr)
 
 	if(spi_rxne_enable()) 
 	{
-		dr5 = *spi_dr5;
+		dr5 = get_spi(spi_dr5);
 	}
 
 	return dr5;
@@ -333,7 +338,7 @@ uint32_t flash_cmd_read(uint32_t command)
 	spi_tx_rx_start();
 	set_spi(spi_cr1, (SPI_BR(7)|SPI_TOTAL_BITS_TX(8)|SPI_TOTAL_BITS_RX(32)|SPI_SPE|SPI_CPHA|SPI_CPOL));
 	if(spi_rxne_enable()) {
-		dr5 = *spi_dr5;
+		dr5 = get_spi(spi_dr5);
 	}
 	return dr5;
 }
@@ -391,7 +396,7 @@ uint32_t flash_device_id(void)
 
 	if(spi_rxne_enable())
 	{
-		dr3 = *spi_dr5;
+		dr3 = get_spi(spi_dr5);
 	}
 
 	val1 = bitExtracted(dr3, 8, 17);
@@ -402,3 +407,198 @@ uint32_t flash_device_id(void)
 
 	return 1;
 }
+
+/* Byte level calls for spi_flash_block.c. The part takes 4 byte addresses
+   and is erased in 64 KB sectors. */
+#define SPANSION_FLASH_SIZE	(32 * 1024 * 1024)
+#define SPANSION_SECTOR_SIZE	(64 * 1024)
+#define SPANSION_ADDR_BYTES	4
+
+/**
+ * @fn static int spi_transfer(const uint8_t* tx, uint32_t tx_len, uint32_t rx_len, uint32_t* rx)
+ * @brief sends up to 16 bytes from DR1..DR4 and receives up to 4 into DR5
+ * @details The bytes go out first byte first. The controller is polled for
+ *          the end of the transfer with no fixed delays.
+ * @param const uint8_t* (tx (bytes to send))
+ * @param uint32_t (tx_len (number of bytes to send))
+ * @param uint32_t (rx_len (number of bytes to receive))
+ * @param uint32_t* (rx (received bytes, the last one in the low byte))
+ * @return int (0 on success, -1 if the controller did not finish)
+ */
+static int spi_transfer(const uint8_t* tx, uint32_t tx_len, uint32_t rx_len, uint32_t* rx)
+{
+	uint32_t word[4] = { 0, 0, 0, 0 };
+	uint32_t i;
+
+	for (i = 0; i < tx_len; i++)
+		word[i / 4] |= (uint32_t) tx[i] << (24 - 8 * (i % 4));
+
+	set_spi(spi_dr1, word[0]);
+	set_spi(spi_dr2, word[1]);
+	set_spi(spi_dr3, word[2]);
+	set_spi(spi_dr4, word[3]);
+	set_spi(spi_dr5, 0);
+	if (rx_len)
+		spi_tx_rx_start();
+	set_spi(spi_cr1, (SPI_BR(7)|SPI_TOTAL_BITS_TX(tx_len * 8)|SPI_TOTAL_BITS_RX(rx_len * 8)|SPI_SPE|SPI_CPHA|SPI_CPOL));
+
+	for (i = 0; i < SPI_POLL_LIMIT; i++)
+	{
+		uint32_t sr = get_spi(spi_sr);
+
+		if (rx_len ? (sr & RXNE) : !(sr & SPI_BSY))
+		{
+			if (rx_len)
+				*rx = get_spi(spi_dr5);
+			return 0;
+		}
+	}
+
+	log_error("spi transfer timed out\n");
+	return -1;
+}
+
+/**
+ * @fn static uint32_t put_command(uint8_t* buf, uint8_t command, uint32_t address)
+ * @brief puts an opcode and a 4 byte address into a buffer
+ * @return uint32_t (number of bytes used)
+ */
+static uint32_t put_command(uint8_t* buf, uint8_t command, uint32_t address)
+{
+	uint32_t i;
+
+	buf[0] = command;
+	for (i = 0; i < SPANSION_ADDR_BYTES; i++)
+		buf[1 + i] = address >> (8 * (SPANSION_ADDR_BYTES - 1 - i));
+
+	return 1 + SPANSION_ADDR_BYTES;
+}
+
+/**
+ * @fn static int flash_wait_idle(void)
+ * @brief polls the status register until WIP clears
+ * @return int (0 on success, -1 on a controller time out)
+ */
+static int flash_wait_idle(void)
+{
+	uint8_t command = 0x05;
+	uint32_t status;
+
+	do
+	{
+		if (spi_transfer(&command, 1, 1, &status))
+			return -1;
+	} while (status & FLASH_STATUS_WIP);
+
+	return 0;
+}
+
+/**
+ * @fn static int flash_enable_write(void)
+ * @brief sets WEL with no fixed delays
+ * @return int (0 on success, -1 on a controller time out)
+ */
+static int flash_enable_write(void)
+{
+	uint8_t command = 0x06;
+
+	return spi_transfer(&command, 1, 0, NULL);
+}
+
+/**
+ * @fn int flash_read_bytes(uint32_t address, uint8_t* data, uint32_t len)
+ * @brief reads any number of bytes with the 4 byte fast read (0Ch)
+ * @details Each transfer returns the 4 bytes DR5 can hold.
+ * @param uint32_t (address (read address))
+ * @param uint8_t* (data (buffer for the bytes))
+ * @param uint32_t (len (number of bytes))
+ * @return int (0 on success else -1)
+ */
+int flash_read_bytes(uint32_t address, uint8_t* data, uint32_t len)
+{
+	uint8_t buf[SPI_TX_BYTES_MAX];
+
+	while (len)
+	{
+		uint32_t chunk = len < SPI_RX_BYTES_MAX ? len : SPI_RX_BYTES_MAX;
+		uint32_t n = put_command(buf, 0x0C, address);
+		uint32_t word;
+		uint32_t i;
+
+		buf[n++] = 0;	/* dummy byte */
+		if (spi_transfer(buf, n, chunk, &word))
+			return -1;
+
+		for (i = 0; i < chunk; i++)
+			data[i] = word >> (8 * (chunk - 1 - i));
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @fn int flash_write_bytes(uint32_t address, const uint8_t* data, uint32_t len)
+ * @brief programs bytes inside one page with the 4 byte page program (12h)
+ * @details Sends as many bytes as DR1..DR4 hold after the opcode and address,
+ *          and polls WIP after each program.
+ * @warning The bytes must be erased and must not cross a page boundary.
+ * @param uint32_t (address (write address))
+ * @param const uint8_t* (data (bytes to write))
+ * @param uint32_t (len (number of bytes))
+ * @return int (0 on success else -1)
+ */
+int flash_write_bytes(uint32_t address, const uint8_t* data, uint32_t len)
+{
+	uint8_t buf[SPI_TX_BYTES_MAX];
+
+	while (len)
+	{
+		uint32_t n = put_command(buf, 0x12, address);
+		uint32_t chunk = SPI_TX_BYTES_MAX - n;
+		uint32_t i;
+
+		if (chunk > len)
+			chunk = len;
+
+		for (i = 0; i < chunk; i++)
+			buf[n + i] = data[i];
+
+		if (flash_enable_write() || spi_transfer(buf, n + chunk, 0, NULL) || flash_wait_idle())
+			return -1;
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/**
+ * @fn int flash_erase_sector(uint32_t address)
+ * @brief erases the 64 KB sector holding an address (DCh) and waits for it
+ * @param uint32_t (address (an address in the sector))
+ * @return int (0 on success else -1)
+ */
+int flash_erase_sector(uint32_t address)
+{
+	uint8_t buf[SPI_TX_BYTES_MAX];
+	uint32_t n = put_command(buf, 0xDC, address);
+
+	if (flash_enable_write() || spi_transfer(buf, n, 0, NULL))
+		return -1;
+
+	return flash_wait_idle();
+}
+
+const flash_block_ops_t spansion_flash_ops = {
+	SPANSION_FLASH_SIZE,
+	SPANSION_SECTOR_SIZE,
+	flash_read_bytes,
+	flash_write_bytes,
+	flash_erase_sector
+};
@@ -31,6 +31,16 @@
 #include "gpio.h"
 #include "utils.h"
 
+#ifdef UART_BUFFERED
+#include "defines.h"
+#include "traps.h"
+#include "plic_driver.h"
+#ifdef UART_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+#endif
+
 uart_struct *uart_instance[MAX_UART_COUNT];
 
 #define RTS GPIO4
@@ -75,8 +85,14 @@ void uart_init()
 #undef getchar
 int getchar()
 {
-	while((uart_instance[0]->status & STS_RX_NOT_EMPTY) == 0); 
-	return (uart_instance[0]->rcv_reg);
+#ifdef UART_BUFFERED
+	uint8_t ch;
+
+	if (uart_read(uart_instance[0], &ch, 1, UART_WAIT_FOREVER) == 1)
+		return ch;
+#endif
+	while((uart_read_status(uart_instance[0]) & STS_RX_NOT_EMPTY) == 0); 
+	return (uart_read_rx(uart_instance[0]));
 }
 
 /**
@@ -90,9 +106,15 @@ int getchar()
 #undef putchar
 int putchar(int ch)
 {
-	while(uart_instance[0]->status & STS_TX_FULL);
+#ifdef UART_BUFFERED
+	uint8_t byte = (uint8_t) ch;
 
-	uart_instance[0]->tx_reg = ch;
+	if (uart_write(uart_instance[0], &byte, 1, UART_WAIT_FOREVER) == 1)
+		return 0;
+#endif
+	while(uart_read_status(uart_instance[0]) & STS_TX_FULL);
+
+	uart_write_tx(uart_instance[0], ch);
 
 	return 0;
 }
@@ -150,9 +172,9 @@ void set_uart_rx_threshold(uart_struct * instance, unsigned char rxthreshold)
  */
 uint32_t write_uart_character(uart_struct * instance, uint8_t prn_character)
 {
-	while(instance->status & STS_TX_FULL);
+	while(uart_read_status(instance) & STS_TX_FULL);
 
-	instance->tx_reg = prn_character;
+	uart_write_tx(instance, prn_character);
 
 	return 0;
 }
@@ -193,9 +215,9 @@ uint8_t read_uart_character(uart_struct * instance, char * prn_character)
 {
 	uint8_t temp = 0;
 
-	while ((instance->status & STS_RX_NOT_EMPTY) == 0);
+	while ((uart_read_status(instance) & STS_RX_NOT_EMPTY) == 0);
 
-	temp = instance->rcv_reg;
+	temp = uart_read_rx(instance);
 	*prn_character = temp;
 
 	return 1;
@@ -381,3 +403,494 @@ unsigned char uart2_isr()
 	return 0;
 }
 #endif
+
+#ifdef UART_BUFFERED
+/*
+   Interrupt driven transmit and receive.
+
+   Each buffered uart has a transmit ring filled by uart_write and a receive
+   ring emptied by uart_read. uart_buffered_isr moves bytes between the rings
+   and the uart's fifos: it is raised by RX_NOT_EMPTY whenever a byte arrives,
+   and by TX_EMPTY while the transmit ring has bytes to send. The task side
+   only touches a ring with mstatus.MIE clear, so a ring is never used by the
+   isr and a task at the same time.
+
+   With UART_FREERTOS a task that finds the ring full (or short of data) waits
+   on its task notification, which the isr gives once there is room for the
+   rest of the write, or enough data for the rest of the read, but no later
+   than when the ring is half empty, or half full. A uart can have
+   one writing and one reading task at a time. When a call cannot block,
+   because there is no scheduler running, or interrupts are disabled, or the
+   build is bare metal, it polls the uart instead, and a write only returns
+   once the ring has been sent.
+ */
+
+typedef struct
+{
+	uint8_t tx_buf[UART_TX_RING_SIZE];
+	uint8_t rx_buf[UART_RX_RING_SIZE];
+	volatile uint32_t tx_head;	/* bytes ever written to tx_buf */
+	volatile uint32_t tx_tail;	/* bytes ever sent from tx_buf */
+	volatile uint32_t rx_head;	/* bytes ever received into rx_buf */
+	volatile uint32_t rx_tail;	/* bytes ever read from rx_buf */
+	uint32_t tx_wanted;		/* room the waiting writer needs */
+	uint32_t rx_wanted;		/* bytes the waiting reader needs */
+#ifdef UART_FREERTOS
+	TaskHandle_t tx_waiter;
+	TaskHandle_t rx_waiter;
+#endif
+	uint8_t ien;			/* copy of the uart's ien register */
+	uint8_t enabled;
+	uart_buffer_stats_t stats;
+} uart_ring_t;
+
+static uart_ring_t uart_ring[MAX_UART_COUNT];
+
+/** @fn static uart_ring_t *uart_ring_of(uart_struct *instance)
+ * @brief returns the ring of a uart instance
+ * @param uart_struct* instance
+ * @return the ring, or NULL if the uart is not buffered
+ */
+static uart_ring_t *uart_ring_of(uart_struct *instance)
+{
+	uint32_t i;
+
+	for (i = 0; i < MAX_UART_COUNT; i++)
+	{
+		if (uart_instance[i] == instance)
+			return uart_ring[i].enabled ? &uart_ring[i] : NULL;
+	}
+
+	return NULL;
+}
+
+/** @fn static uintptr_t uart_irq_save(void)
+ * @brief disables interrupts
+ * @return nonzero if they were enabled
+ */
+static uintptr_t uart_irq_save(void)
+{
+	uintptr_t state = read_csr(mstatus) & MSTATUS_MIE;
+
+	clear_csr(mstatus, MSTATUS_MIE);
+
+	return state;
+}
+
+/** @fn static void uart_irq_restore(uintptr_t state)
+ * @brief enables interrupts again if uart_irq_save found them enabled
+ * @param uintptr_t state
+ */
+static void uart_irq_restore(uintptr_t state)
+{
+	if (state)
+		set_csr(mstatus, MSTATUS_MIE);
+}
+
+/** @fn static int uart_can_block(void)
+ * @brief tells whether the caller is a task that may wait
+ * @return nonzero if the caller can wait on its task notification
+ */
+static int uart_can_block(void)
+{
+#ifdef UART_FREERTOS
+	return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING &&
+	       (read_csr(mstatus) & MSTATUS_MIE);
+#else
+	return 0;
+#endif
+}
+
+/** @fn static void uart_tx_service(uart_struct *instance, uart_ring_t *ring)
+ * @brief moves bytes from the tx ring to the uart's fifo
+ * @details Fills the fifo until it is full or the ring is empty. The
+ *          TX_EMPTY interrupt is left enabled only while the ring has bytes.
+ *          Call with interrupts disabled.
+ * @param uart_struct* instance
+ * @param uart_ring_t* ring
+ */
+static void uart_tx_service(uart_struct *instance, uart_ring_t *ring)
+{
+	uint32_t tail = ring->tx_tail;
+	uint8_t ien;
+
+	while (tail != ring->tx_head && !(uart_read_status(instance) & STS_TX_FULL))
+	{
+		uart_write_tx(instance, ring->tx_buf[tail & (UART_TX_RING_SIZE - 1)]);
+		tail++;
+		ring->stats.tx_bytes++;
+	}
+	ring->tx_tail = tail;
+
+	ien = ring->ien;
+	if (tail == ring->tx_head)
+		ien &= ~(ENABLE_TX_EMPTY);
+	else
+		ien |= ENABLE_TX_EMPTY;
+
+	if (ien != ring->ien)
+	{
+		ring->ien = ien;
+		instance->ien = ien;
+	}
+}
+
+/** @fn static void uart_rx_service(uart_struct *instance, uart_ring_t *ring)
+ * @brief moves bytes from the uart's fifo to the rx ring
+ * @details Empties the fifo. Bytes that do not fit in the ring are dropped
+ *          and counted. Call with interrupts disabled.
+ * @param uart_struct* instance
+ * @param uart_ring_t* ring
+ */
+static void uart_rx_service(uart_struct *instance, uart_ring_t *ring)
+{
+	uint32_t head = ring->rx_head;
+	uint32_t status;
+
+	while ((status = uart_read_status(instance)) & STS_RX_NOT_EMPTY)
+	{
+		uint8_t ch = (uint8_t) uart_read_rx(instance);
+
+		if (status & OVERRUN)
+			ring->stats.rx_overruns++;
+
+		if (head - ring->rx_tail == UART_RX_RING_SIZE)
+		{
+			ring->stats.rx_overflows++;
+			continue;
+		}
+
+		ring->rx_buf[head & (UART_RX_RING_SIZE - 1)] = ch;
+		head++;
+		ring->stats.rx_bytes++;
+	}
+	ring->rx_head = head;
+
+	if (head - ring->rx_tail > ring->stats.rx_max_level)
+		ring->stats.rx_max_level = head - ring->rx_tail;
+}
+
+/** @fn int uart_enable_buffering(uart_struct * instance)
+ * @brief Function to make a uart interrupt driven.
+ * @details Empties the uart's rings, installs uart_buffered_isr for its
+ *          PLIC source and enables the source and the uart's RX_NOT_EMPTY
+ *          interrupt. plic_init must have been called. From then on
+ *          uart_write and uart_read use the rings, and for uart_instance[0]
+ *          so do putchar and getchar.
+ * @param uart instance
+ * @return Zero, or -1 if the instance is not a uart
+ */
+int uart_enable_buffering(uart_struct * instance)
+{
+	uart_ring_t *ring;
+	uint32_t interrupt_id;
+	uintptr_t state;
+	uint32_t i;
+
+	for (i = 0; i < MAX_UART_COUNT; i++)
+	{
+		if (uart_instance[i] == instance)
+			break;
+	}
+
+	if (i == MAX_UART_COUNT)
+		return -1;
+
+	ring = &uart_ring[i];
+	interrupt_id = PLIC_INTERRUPT_25 + i;
+
+	state = uart_irq_save();
+
+	ring->tx_head = ring->tx_tail = 0;
+	ring->rx_head = ring->rx_tail = 0;
+	ring->tx_wanted = ring->rx_wanted = 0;
+#ifdef UART_FREERTOS
+	ring->tx_waiter = ring->rx_waiter = NULL;
+#endif
+	ring->stats = (uart_buffer_stats_t) { 0 };
+	ring->ien = ENABLE_RX_NOT_EMPTY;
+	ring->enabled = 1;
+
+	instance->ien = ring->ien;
+	isr_table[interrupt_id] = uart_buffered_isr;
+	interrupt_enable(interrupt_id);
+
+	uart_irq_restore(state);
+
+	return 0;
+}
+
+/** @fn uint32_t uart_write(uart_struct * instance, const uint8_t * data, uint32_t len, uint32_t timeout)
+ * @brief Function to queue bytes for transmission on a buffered uart.
+ * @details Copies the bytes into the uart's tx ring, waiting for room when
+ *          it is full. A task waits on its notification for at most timeout
+ *          ticks, or for ever with UART_WAIT_FOREVER, and a timeout of 0
+ *          queues what fits without waiting. If the caller cannot block,
+ *          the uart is polled until every byte has been sent.
+ * @param uart instance
+ * @param bytes to send
+ * @param number of bytes
+ * @param timeout in ticks
+ * @return number of bytes queued, which is 0 if the uart is not buffered
+ */
+uint32_t uart_write(uart_struct * instance, const uint8_t * data, uint32_t len, uint32_t timeout)
+{
+	uart_ring_t *ring = uart_ring_of(instance);
+	uint32_t done = 0;
+	uintptr_t state;
+
+	if (ring == NULL)
+		return 0;
+
+	if (!uart_can_block())
+	{
+		state = uart_irq_save();
+
+		while (done < len)
+		{
+			if (ring->tx_head - ring->tx_tail == UART_TX_RING_SIZE)
+			{
+				uart_tx_service(instance, ring);
+				continue;
+			}
+			ring->tx_buf[ring->tx_head & (UART_TX_RING_SIZE - 1)] = data[done++];
+			ring->tx_head++;
+		}
+
+		while (ring->tx_tail != ring->tx_head)
+			uart_tx_service(instance, ring);
+
+		uart_irq_restore(state);
+		return done;
+	}
+
+#ifdef UART_FREERTOS
+	{
+		TickType_t ticks = (timeout == UART_WAIT_FOREVER) ? portMAX_DELAY : (TickType_t) timeout;
+		TimeOut_t time_out;
+
+		vTaskSetTimeOutState(&time_out);
+
+		for (;;)
+		{
+			uint32_t head;
+			uint32_t level;
+			int full;
+
+			state = uart_irq_save();
+
+			head = ring->tx_head;
+			while (done < len && head - ring->tx_tail < UART_TX_RING_SIZE)
+			{
+				ring->tx_buf[head & (UART_TX_RING_SIZE - 1)] = data[done++];
+				head++;
+			}
+			ring->tx_head = head;
+
+			level = head - ring->tx_tail;
+			if (level > ring->stats.tx_max_level)
+				ring->stats.tx_max_level = level;
+
+			/* Start the uart if it is idle; from then on the isr
+			   keeps it busy until the ring is empty. */
+			if (!(ring->ien & ENABLE_TX_EMPTY) && level != 0)
+				uart_tx_service(instance, ring);
+
+			full = (ring->tx_head - ring->tx_tail == UART_TX_RING_SIZE);
+			if (done < len && full)
+			{
+				ring->tx_wanted = len - done;
+				if (ring->tx_wanted > UART_TX_RING_SIZE / 2)
+					ring->tx_wanted = UART_TX_RING_SIZE / 2;
+				ring->tx_waiter = xTaskGetCurrentTaskHandle();
+			}
+
+			uart_irq_restore(state);
+
+			if (done == len)
+				break;
+
+			if (!full)
+				continue;
+
+			if (xTaskCheckForTimeOut(&time_out, &ticks) != pdFALSE)
+			{
+				ring->stats.tx_timeouts++;
+				break;
+			}
+
+			ulTaskNotifyTake(pdTRUE, ticks);
+		}
+
+		state = uart_irq_save();
+		ring->tx_waiter = NULL;
+		uart_irq_restore(state);
+	}
+#else
+	(void) timeout;
+#endif
+
+	return done;
+}
+
+/** @fn uint32_t uart_read(uart_struct * instance, uint8_t * data, uint32_t len, uint32_t timeout)
+ * @brief Function to read received bytes from a buffered uart.
+ * @details Copies bytes out of the uart's rx ring until len bytes have been
+ *          read. A task waits on its notification for at most timeout
+ *          ticks, or for ever with UART_WAIT_FOREVER. If the caller cannot
+ *          block, the uart is polled, and any timeout but 0 polls until
+ *          len bytes have arrived.
+ * @param uart instance
+ * @param buffer for the bytes
+ * @param number of bytes wanted
+ * @param timeout in ticks
+ * @return number of bytes read, which is 0 if the uart is not buffered
+ */
+uint32_t uart_read(uart_struct * instance, uint8_t * data, uint32_t len, uint32_t timeout)
+{
+	uart_ring_t *ring = uart_ring_of(instance);
+	uint32_t done = 0;
+	uintptr_t state;
+	int can_block;
+#ifdef UART_FREERTOS
+	TickType_t ticks = (timeout == UART_WAIT_FOREVER) ? portMAX_DELAY : (TickType_t) timeout;
+	TimeOut_t time_out;
+#endif
+
+	if (ring == NULL)
+		return 0;
+
+	can_block = uart_can_block();
+
+#ifdef UART_FREERTOS
+	vTaskSetTimeOutState(&time_out);
+#endif
+
+	for (;;)
+	{
+		uint32_t tail;
+
+		state = uart_irq_save();
+
+		if (!can_block)
+			uart_rx_service(instance, ring);
+
+		tail = ring->rx_tail;
+		while (done < len && tail != ring->rx_head)
+		{
+			data[done++] = ring->rx_buf[tail & (UART_RX_RING_SIZE - 1)];
+			tail++;
+		}
+		ring->rx_tail = tail;
+
+#ifdef UART_FREERTOS
+		if (can_block && done < len)
+		{
+			ring->rx_wanted = len - done;
+			if (ring->rx_wanted > UART_RX_RING_SIZE / 2)
+				ring->rx_wanted = UART_RX_RING_SIZE / 2;
+			ring->rx_waiter = xTaskGetCurrentTaskHandle();
+		}
+#endif
+
+		uart_irq_restore(state);
+
+		if (done == len)
+			break;
+
+		if (!can_block)
+		{
+			if (timeout == 0)
+			{
+				ring->stats.rx_timeouts++;
+				break;
+			}
+			continue;
+		}
+
+#ifdef UART_FREERTOS
+		if (xTaskCheckForTimeOut(&time_out, &ticks) != pdFALSE)
+		{
+			ring->stats.rx_timeouts++;
+			break;
+		}
+
+		ulTaskNotifyTake(pdTRUE, ticks);
+#endif
+	}
+
+#ifdef UART_FREERTOS
+	if (can_block)
+	{
+		state = uart_irq_save();
+		ring->rx_waiter = NULL;
+		uart_irq_restore(state);
+	}
+#endif
+
+	return done;
+}
+
+/** @fn void uart_get_buffer_stats(uart_struct * instance, uart_buffer_stats_t * stats)
+ * @brief Function to read the counters of a buffered uart.
+ * @param uart instance
+ * @param copy of the counters, zeroed if the uart is not buffered
+ */
+void uart_get_buffer_stats(uart_struct * instance, uart_buffer_stats_t * stats)
+{
+	uart_ring_t *ring = uart_ring_of(instance);
+	uintptr_t state;
+
+	if (ring == NULL)
+	{
+		*stats = (uart_buffer_stats_t) { 0 };
+		return;
+	}
+
+	state = uart_irq_save();
+	*stats = ring->stats;
+	uart_irq_restore(state);
+}
+
+/** @fn void uart_buffered_isr(uint32_t interrupt_id)
+ * @brief Function to service a buffered uart's interrupt.
+ * @details Installed in isr_table by uart_enable_buffering. Empties the rx
+ *          fifo into the rx ring, refills the tx fifo from the tx ring, and
+ *          wakes a task waiting for either ring.
+ * @param uint32_t interrupt_id
+ */
+void uart_buffered_isr(uint32_t interrupt_id)
+{
+	uint32_t i = interrupt_id - PLIC_INTERRUPT_25;
+	uart_ring_t *ring;
+#ifdef UART_FREERTOS
+	BaseType_t woken = pdFALSE;
+#endif
+
+	if (i >= MAX_UART_COUNT || !uart_ring[i].enabled)
+		return;
+
+	ring = &uart_ring[i];
+
+	uart_rx_service(uart_instance[i], ring);
+	uart_tx_service(uart_instance[i], ring);
+
+#ifdef UART_FREERTOS
+	if (ring->rx_waiter != NULL &&
+	    ring->rx_head - ring->rx_tail >= ring->rx_wanted)
+	{
+		vTaskNotifyGiveFromISR(ring->rx_waiter, &woken);
+		ring->rx_waiter = NULL;
+	}
+
+	if (ring->tx_waiter != NULL &&
+	    UART_TX_RING_SIZE - (ring->tx_head - ring->tx_tail) >= ring->tx_wanted)
+	{
+		vTaskNotifyGiveFromISR(ring->tx_waiter, &woken);
+		ring->tx_waiter = NULL;
+	}
+
+	portYIELD_FROM_ISR(woken);
+#endif
+}
+#endif
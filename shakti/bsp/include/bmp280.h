@@ -0,0 +1,165 @@
+/***************************************************************************
+ * Project                          : shakti devt board
+ * Name of the file                 : bmp280.h
+ * Brief Description of file        : Header to the bmp280 sensor driver
+ * Name of Author                   :
+ * Email ID                         :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+ * @file bmp280.h
+ * @brief Header to the bmp280 sensor driver
+ * @detail bmp280.c reads the calibration of a BMP280 once, in one 24 byte
+ * read, and each measurement as one 6 byte read. bmp280_compensate.c turns
+ * the readings into temperature and pressure with the datasheet's integer
+ * formulas. Building bmp280.c with BMP280_FREERTOS adds a task that samples
+ * the sensor in forced or normal mode and sends the samples to a queue.
+ */
+#ifndef BMP280_H
+#define BMP280_H
+
+#include <stdint.h>
+
+#define BMP280_I2C_ADDRESS	0xEC
+#define BMP280_CHIP_ID		0x58
+
+#define BMP280_REG_CALIB	0x88
+#define BMP280_REG_ID		0xD0
+#define BMP280_REG_RESET	0xE0
+#define BMP280_REG_STATUS	0xF3
+#define BMP280_REG_CTRL_MEAS	0xF4
+#define BMP280_REG_CONFIG	0xF5
+#define BMP280_REG_DATA		0xF7
+
+#define BMP280_CALIB_LEN	24
+#define BMP280_DATA_LEN		6
+#define BMP280_RESET_VALUE	0xB6
+#define BMP280_STATUS_MEASURING	0x08
+#define BMP280_STATUS_IM_UPDATE	0x01
+
+/* What the adc registers hold when a measurement was skipped or has not run */
+#define BMP280_ADC_NONE		0x80000
+
+/* Modes, for ctrl_meas */
+#define BMP280_MODE_SLEEP	0
+#define BMP280_MODE_FORCED	1
+#define BMP280_MODE_NORMAL	3
+
+/* Oversampling, for osrs_t and osrs_p */
+#define BMP280_OSRS_SKIP	0
+#define BMP280_OSRS_X1		1
+#define BMP280_OSRS_X2		2
+#define BMP280_OSRS_X4		3
+#define BMP280_OSRS_X8		4
+#define BMP280_OSRS_X16		5
+
+/* IIR filter coefficients */
+#define BMP280_FILTER_OFF	0
+#define BMP280_FILTER_2		1
+#define BMP280_FILTER_4		2
+#define BMP280_FILTER_8		3
+#define BMP280_FILTER_16	4
+
+/* Standby time between normal mode measurements */
+#define BMP280_STANDBY_0_5_MS	0
+#define BMP280_STANDBY_62_5_MS	1
+#define BMP280_STANDBY_125_MS	2
+#define BMP280_STANDBY_250_MS	3
+#define BMP280_STANDBY_500_MS	4
+#define BMP280_STANDBY_1000_MS	5
+#define BMP280_STANDBY_2000_MS	6
+#define BMP280_STANDBY_4000_MS	7
+
+#define BMP280_SUCCESS		0
+#define EBMP280_NO_DEVICE	-90
+#define EBMP280_BUSY		-91
+#define EBMP280_NO_DATA		-92
+#define EBMP280_CONFIG		-93
+
+/* Reads left to the status register's im_update bit after a reset */
+#ifndef BMP280_STATUS_POLLS
+#define BMP280_STATUS_POLLS	10
+#endif
+
+/* Trimming values, dig_T1 to dig_P9 */
+typedef struct
+{
+	uint16_t dig_T1;
+	int16_t dig_T2;
+	int16_t dig_T3;
+	uint16_t dig_P1;
+	int16_t dig_P2;
+	int16_t dig_P3;
+	int16_t dig_P4;
+	int16_t dig_P5;
+	int16_t dig_P6;
+	int16_t dig_P7;
+	int16_t dig_P8;
+	int16_t dig_P9;
+} bmp280_calib_t;
+
+typedef struct
+{
+	uint8_t mode;		/*! BMP280_MODE_FORCED or BMP280_MODE_NORMAL */
+	uint8_t osrs_t;
+	uint8_t osrs_p;
+	uint8_t filter;
+	uint8_t standby;	/*! normal mode only */
+	uint32_t period_ms;	/*! between samples of the task, 0 for as fast as the mode allows */
+} bmp280_config_t;
+
+typedef struct
+{
+	int32_t temperature;	/*! 0.01 degree Celsius */
+	uint32_t pressure;	/*! Pa, Q24.8 */
+	uint32_t tick;		/*! when the sample was read, for the task */
+} bmp280_sample_t;
+
+typedef struct
+{
+	uint32_t samples;
+	uint32_t errors;	/*! failed i2c transactions */
+	uint32_t not_ready;	/*! reads that found no measurement */
+	uint32_t dropped;	/*! samples the queue had no room for */
+} bmp280_stats_t;
+
+typedef struct
+{
+	void *i2c;		/*! i2c_struct of the bus */
+	uint8_t address;
+	bmp280_config_t config;
+	bmp280_calib_t calib;
+	bmp280_stats_t stats;
+	void *queue;		/*! QueueHandle_t the task sends to */
+	void *task;
+} bmp280_t;
+
+void bmp280_parse_calib(bmp280_calib_t *calib, const uint8_t raw[BMP280_CALIB_LEN]);
+int32_t bmp280_compensate_temperature(const bmp280_calib_t *calib, int32_t adc_T, int32_t *t_fine);
+uint32_t bmp280_compensate_pressure(const bmp280_calib_t *calib, int32_t adc_P, int32_t t_fine);
+uint32_t bmp280_compensate_pressure32(const bmp280_calib_t *calib, int32_t adc_P, int32_t t_fine);
+int bmp280_compensate(const bmp280_calib_t *calib, const uint8_t raw[BMP280_DATA_LEN], bmp280_sample_t *sample);
+
+uint32_t bmp280_measure_time_us(const bmp280_config_t *config);
+int bmp280_init(bmp280_t *dev, void *i2c, const bmp280_config_t *config);
+int bmp280_start_measurement(bmp280_t *dev);
+int bmp280_read_sample(bmp280_t *dev, bmp280_sample_t *sample);
+#ifdef BMP280_FREERTOS
+int bmp280_start_task(bmp280_t *dev, void *queue, unsigned long priority, unsigned short stack_depth);
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+/***************************************************************************
+ * Project                          : shakti devt board
+ * Name of the file                 : clint_timer.h
+ * Brief Description of file        : Header to the mtime based delays, sleeps and alarms
+ * Name of Author                   :
+ * Email ID                         :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+ * @file clint_timer.h
+ * @brief Header to the mtime based delays, sleeps and alarms
+ * @detail clint_timer.c times delays against the clint's mtime, which runs
+ * at CLINT_MTIME_HZ whatever the core clock is. timer_init() measures the
+ * core clock against it once, and delays of up to CLINT_TIMER_SPIN_US
+ * count mcycle instead. timer_sleep_us() lets other tasks run for the whole
+ * ticks of a sleep when built with CLINT_TIMER_FREERTOS. Alarms call a
+ * function once, from an interrupt, when mtime reaches a deadline.
+ */
+#ifndef CLINT_TIMER_H
+#define CLINT_TIMER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "platform.h"
+
+/* The rate mtime counts at, configTICK_CLOCK_HZ of the demos */
+#ifndef CLINT_MTIME_HZ
+#define CLINT_MTIME_HZ		500000
+#endif
+
+/* mtime ticks timer_init() counts mcycle over */
+#ifndef CLINT_TIMER_CALIBRATE_TICKS
+#define CLINT_TIMER_CALIBRATE_TICKS	500
+#endif
+
+/* Delays of up to this many us count mcycle instead of mtime */
+#ifndef CLINT_TIMER_SPIN_US
+#define CLINT_TIMER_SPIN_US	1000
+#endif
+
+typedef void (*timer_alarm_fn)(void *arg);
+
+typedef struct timer_alarm
+{
+	uint64_t deadline;		/*! mtime it is due at */
+	timer_alarm_fn fn;
+	void *arg;
+	struct timer_alarm *next;
+	uint8_t pending;
+} timer_alarm_t;
+
+typedef struct
+{
+	uint32_t fired;		/*! alarms called */
+	uint32_t max_late;	/*! most mtime ticks an alarm was called after its deadline */
+	uint32_t yields;	/*! vTaskDelay calls of timer_sleep_us */
+} timer_stats_t;
+
+void timer_init(void);
+uint64_t timer_now(void);
+uint32_t timer_cpu_hz(void);
+uint64_t timer_us_to_ticks(uint32_t us);
+
+void ndelay(uint32_t ns);
+void udelay(uint32_t us);
+void mdelay(uint32_t ms);
+void timer_sleep_us(uint32_t us);
+void timer_sleep_ms(uint32_t ms);
+
+void timer_alarm_init(timer_alarm_t *alarm, timer_alarm_fn fn, void *arg);
+void timer_alarm_start_at(timer_alarm_t *alarm, uint64_t deadline);
+void timer_alarm_start(timer_alarm_t *alarm, uint32_t us);
+int timer_alarm_cancel(timer_alarm_t *alarm);
+void timer_alarm_tick(void);
+void timer_get_stats(timer_stats_t *stats);
+
+#endif
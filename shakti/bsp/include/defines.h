@@ -39,8 +39,11 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define SREG sw
 #endif
 
+#define MSTATUS_MIE         0x00000008
 #define MSTATUS_MPP         0x00001800
 #define MSTATUS_FS          0x00006000
 
+#define MIE_MTIE            0x00000080
+
 #endif
 
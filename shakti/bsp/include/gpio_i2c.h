@@ -41,6 +41,10 @@ add a method to set the GPIO pins that are to be used  */
 #define I2C_WRITE 0
 #define I2C_READ 1
 
+/* Every delay argument below is in microseconds when the bsp is built with
+CLINT_TIMER=1, where it used to be a delay_loop() count; without CLINT_TIMER
+it is still a delay_loop() count. */
+
 // function prototype 
 void I2cInit();
 void I2cSendSlaveAddress(unsigned char , unsigned char , unsigned char );
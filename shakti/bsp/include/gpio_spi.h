@@ -41,6 +41,9 @@
 #define SPI_SS   1<<3 //4th bit
 #define SPI_ADC_IN 0xC0
 
+/* delay is in microseconds when the bsp is built with CLINT_TIMER=1, where it
+used to be a delay_loop() count; without CLINT_TIMER it is still a
+delay_loop() count. */
 // function prototype
  unsigned char readbyte(unsigned char delay);
  int config();
@@ -23,12 +23,16 @@
 /**
  * @file i2c.h
  * @brief  Header file for i2c
- * @detail this is the header file for i2c_driver.c
+ * @detail this is the header file for i2c_driver.c. Building with I2C_ASYNC
+ * adds i2c_transfer, which queues a write then read transaction and lets the
+ * i2c interrupt carry it out, blocking on the calling task's notification
+ * when I2C_FREERTOS is also defined.
  */
 
 #ifndef I2C_H
 #define I2C_H
 
+#include <stdint.h>
 #include "platform.h"
 
 #define ETIMEOUT -60
@@ -42,6 +46,7 @@
 #define EI2C_BUS_ERROR -2
 #define EI2C_PIN_ERROR -3
 #define EI2C_LRB_ERROR -4
+#define EI2C_BUSY -5
 
 #define I2C_PIN	0x80
 #define I2C_ESO	0x40
@@ -69,6 +74,7 @@
 #define I2C_IDLE          (I2C_PIN | I2C_ESO                  | I2C_ACK)
 #define I2C_NACK          (I2C_ESO  )
 #define I2C_STOP_ENI          (I2C_PIN | I2C_ESO | I2C_STO | I2C_ACK | I2C_ENI)
+#define I2C_NACK_ENI      (I2C_ESO | I2C_ENI)
 
 #define I2C_READ 1
 #define I2C_WRITE 0
@@ -84,8 +90,8 @@
 `define     SCL            8'h38
 */
 
-unsigned char i2c_complete_flag;
-unsigned int i2c_read_value;
+extern unsigned char i2c_complete_flag;
+extern unsigned int i2c_read_value;
 
 /* Struct to access I2C registers as 32 bit registers */
 typedef struct
@@ -123,6 +129,59 @@ typedef struct
 	unsigned int   scl_rsvd;
 } i2c_struct;
 
+/* Register accessors. A platform.h may define these to run the driver
+   against a model of the controller instead of the hardware. */
+#ifndef i2c_get_reg
+#define i2c_get_reg(instance, reg)	(*(volatile unsigned int *) &(instance)->reg)
+#endif
+#ifndef i2c_set_reg
+#define i2c_set_reg(instance, reg, val)	(*(volatile unsigned int *) &(instance)->reg = (val))
+#endif
+
+#ifdef I2C_ASYNC
+/* Timeout for i2c_transfer that never expires. */
+#define I2C_WAIT_FOREVER	0xFFFFFFFFU
+
+/* Status reads spent waiting for the bus to become free, and for each byte
+   of a transfer that is carried out by polling. */
+#ifndef I2C_POLL_LIMIT
+#define I2C_POLL_LIMIT	100000
+#endif
+
+/* A transaction for i2c_transfer: the slave's address for writing, reg,
+   write_len bytes of write_data, and then, if read_len is not zero, a
+   repeated start and read_len bytes read into read_data. The driver owns
+   the fields from next on while the transaction is queued. */
+typedef struct i2c_xfer
+{
+	unsigned char slave_address;	/*! 8 bit address, such as 0xEC */
+	unsigned char reg;		/*! first byte sent after the address */
+	const unsigned char *write_data;
+	unsigned int write_len;
+	unsigned char *read_data;
+	unsigned int read_len;
+	struct i2c_xfer *next;
+	void *waiter;			/*! task waiting on its notification */
+	volatile int result;
+	volatile unsigned char done;
+	unsigned char state;
+	unsigned int count;		/*! bytes moved in the current phase */
+} i2c_xfer_t;
+
+/* Counters kept for each asynchronous i2c controller */
+typedef struct
+{
+	unsigned int transfers;		/*! transactions completed, successfully or not */
+	unsigned int bytes;		/*! bytes written and read, addresses excluded */
+	unsigned int interrupts;	/*! calls to i2c_async_isr */
+	unsigned int polled;		/*! transactions carried out by polling */
+	unsigned int nacks;		/*! transactions ended by a slave's nack */
+	unsigned int timeouts;		/*! transactions that timed out */
+	unsigned int bus_errors;	/*! transactions that found the bus stuck */
+	unsigned int recoveries;	/*! times the controller was reset */
+} i2c_async_stats_t;
+#endif
+
 void i2c_init(void);
 int config_i2c(i2c_struct *,unsigned char prescale_div, unsigned char scl_div);
 int wait_till_I2c_bus_free(i2c_struct *);
@@ -143,6 +202,13 @@ int i2c_write_interrupt_data(i2c_struct * instance, unsigned char writeData,
 int i2c_read_data_nack(i2c_struct * instance, unsigned char *read_data, unsigned
 		       char delay);
 
+#ifdef I2C_ASYNC
+int i2c_enable_async(i2c_struct * instance);
+int i2c_transfer(i2c_struct * instance, i2c_xfer_t * xfer, unsigned int timeout);
+void i2c_get_async_stats(i2c_struct * instance, i2c_async_stats_t * stats);
+void i2c_async_isr(uint32_t interrupt_id);
+#endif
+
 extern i2c_struct *i2c_instance[MAX_I2C_COUNT];
 
 #endif
@@ -26,9 +26,14 @@
  * @detail This file is used for logging. There are 6 levels of logging.
  Level 0 is the most critical. Usually system stops after level 0 logging.
  Level 3 is the default level of logging.
+ The level is fixed at compile time by LOG_LEVEL, and a call above it
+ compiles to nothing. Code that runs in an interrupt or trap handler uses the
+ log_isr_ calls, which save the format and up to four arguments in a ring
+ instead of printing. log_isr_drain(), called from a task, prints them.
  */
 
 #include <stdarg.h>
+#include <stdint.h>
 
 // Log Levels
 #define TRACE 5
@@ -47,3 +52,53 @@ void log_debug(const char*fmt, ...);
 void log_warn(const char*fmt, ...);
 void log_error(const char*fmt, ...);
 void log_fatal(const char*fmt, ...);
+void log_isr_put(const char *fmt, uintptr_t arg0, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3);
+unsigned int log_isr_drain(void);
+
+/*Use -D compiler flag to set the LOG_LEVEL*/
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 3
+#endif
+
+/*
+   Calls above LOG_LEVEL become a statement the compiler removes, with the
+   arguments still type checked and counted as used.
+ */
+#define LOG_DISCARD(call)	do { if (0) call; } while (0)
+
+#if LOG_LEVEL < TRACE
+#define log_trace(...)		LOG_DISCARD(log_trace(__VA_ARGS__))
+#endif
+#if LOG_LEVEL < DEBUG
+#define log_debug(...)		LOG_DISCARD(log_debug(__VA_ARGS__))
+#endif
+#if LOG_LEVEL < INFO
+#define log_info(...)		LOG_DISCARD(log_info(__VA_ARGS__))
+#endif
+#if LOG_LEVEL < WARN
+#define log_warn(...)		LOG_DISCARD(log_warn(__VA_ARGS__))
+#endif
+#if LOG_LEVEL < ERROR
+#define log_error(...)		LOG_DISCARD(log_error(__VA_ARGS__))
+#endif
+
+/* Pads the arguments to four words for log_isr_put. */
+#define LOG_ISR_PUT(fmt, a0, a1, a2, a3, ...) \
+	log_isr_put(fmt, (uintptr_t) (a0), (uintptr_t) (a1), (uintptr_t) (a2), (uintptr_t) (a3))
+#define LOG_ISR(...)		LOG_ISR_PUT(__VA_ARGS__, 0, 0, 0, 0, 0)
+
+#if LOG_LEVEL >= TRACE
+#define log_isr_trace(...)	LOG_ISR(__VA_ARGS__)
+#else
+#define log_isr_trace(...)	LOG_DISCARD(LOG_ISR(__VA_ARGS__))
+#endif
+#if LOG_LEVEL >= DEBUG
+#define log_isr_debug(...)	LOG_ISR(__VA_ARGS__)
+#else
+#define log_isr_debug(...)	LOG_DISCARD(LOG_ISR(__VA_ARGS__))
+#endif
+#if LOG_LEVEL >= INFO
+#define log_isr_info(...)	LOG_ISR(__VA_ARGS__)
+#else
+#define log_isr_info(...)	LOG_DISCARD(LOG_ISR(__VA_ARGS__))
+#endif
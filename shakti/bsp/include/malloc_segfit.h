@@ -0,0 +1,57 @@
+/***************************************************************************
+ * Project               	   : shakti devt board
+ * Name of the file	           : malloc_segfit.h
+ * Brief Description of file       : Header file for the segregated-fit malloc.
+ * Name of Author    	           : 
+ * Email ID                        : 
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+@file malloc_segfit.h
+@brief Header file for the segregated-fit malloc.
+@detail This is the header file for malloc_segfit.c. The allocator also
+provides malloc(), free(), calloc() and realloc() unless it is built with
+SEGFIT_NO_LIBC_NAMES, in which case only the segfit_ names below exist.
+*/
+
+#ifndef MALLOC_SEGFIT_H
+#define MALLOC_SEGFIT_H
+
+#include <stddef.h>
+
+/* Heap statistics, named after the fields of mallinfo(). */
+struct segfit_info
+{
+	size_t arena;		/*! bytes obtained from m_sbrk */
+	size_t ordblks;		/*! number of free blocks */
+	size_t uordblks;	/*! bytes in allocated blocks, headers included */
+	size_t fordblks;	/*! bytes in free blocks */
+	size_t largest;		/*! size of the largest free block */
+	size_t usmblks;		/*! highest value uordblks has reached */
+	unsigned long mallocs;	/*! allocations made */
+	unsigned long frees;	/*! blocks freed */
+	unsigned long failures;	/*! allocations that returned NULL */
+	unsigned long search_steps; /*! free blocks examined by allocations */
+};
+
+void *segfit_malloc(size_t size);
+void segfit_free(void *ptr);
+void *segfit_calloc(size_t nmemb, size_t size);
+void *segfit_realloc(void *ptr, size_t size);
+void segfit_mallinfo(struct segfit_info *info);
+
+#endif
@@ -60,6 +60,26 @@
 
 #define PLIC_PENDING_SHIFT_PER_SOURCE   0
 
+/* The claim/complete register. A platform may define its own accessors. */
+#ifndef plic_claim_read
+#define plic_claim_read() \
+	(*(volatile uint32_t *) (PLIC_BASE_ADDRESS + PLIC_CLAIM_OFFSET))
+#define plic_claim_write(id) \
+	(*(volatile uint32_t *) (PLIC_BASE_ADDRESS + PLIC_CLAIM_OFFSET) = (id))
+#endif
+
+/*
+   Set PLIC_NESTING to 1 to let a source with a higher priority than the one
+   being serviced interrupt its handler. The threshold is raised to the
+   priority of the source being serviced while its handler runs with
+   interrupts enabled. Not for FreeRTOS builds: the port's trap handler
+   cannot be re-entered. log.c must be built with the same setting, since
+   log_isr_put then masks interrupts while it takes a slot in the ring.
+ */
+#ifndef PLIC_NESTING
+#define PLIC_NESTING 0
+#endif
+
 /* Enumerators */
 
 typedef enum
@@ -78,6 +98,8 @@ typedef struct
 	uint32_t priority; /*priority assigned to it*/
 	interrupt_status_e state; /*state of the interrupt*/
 	uint32_t count; /*number of times this interrupt occured*/
+	uint32_t max_cycles; /*longest run of its isr, in mcycle counts*/
+	uint64_t total_cycles; /*mcycle counts spent in its isr*/
 } interrupt_data_t;
 
 /* Platform Level Interrupt Controller (PLIC) table
@@ -85,6 +107,7 @@ typedef struct
 
 typedef void (*plic_fptr_t) (uint32_t);
 extern plic_fptr_t isr_table[PLIC_MAX_INTERRUPT_SRC];
+extern interrupt_data_t hart0_interrupt_matrix[PLIC_MAX_INTERRUPT_SRC];
 
 /* Function prototypes */
 
@@ -99,5 +122,6 @@ void set_interrupt_priority(uint32_t priority_value, uint32_t int_id);
 void configure_interrupt_pin(uint32_t pin);
 void plic_init(void);
 void configure_interrupt(uint32_t int_id);
+void plic_print_stats(void);
 
 #endif
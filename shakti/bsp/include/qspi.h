@@ -129,6 +129,40 @@
 #define THREEBYTE 0x2
 #define FOURBYTE  0x3
 
+//Micron N25Q geometry used by the bulk program, erase and read routines
+#define FLASH_PAGE_SIZE      256
+#define FLASH_SUBSECTOR_SIZE 4096
+
+//Dummy cycles of the quad I/O reads, as the Xip routines use them with the
+//volatile configuration 0x40 that deploy writes
+#ifndef QSPI_QUAD_READ_DUMMY
+#define QSPI_QUAD_READ_DUMMY 5
+#endif
+#ifndef QSPI_DDR_READ_DUMMY
+#define QSPI_DDR_READ_DUMMY  10
+#endif
+
+//Number of status register reads after which a qspi or flash wait gives up
+#ifndef QSPI_POLL_LIMIT
+#define QSPI_POLL_LIMIT 1000000
+#endif
+
+//Read cache in front of flashCachedRead: QSPI_CACHE_LINES lines of
+//QSPI_CACHE_LINE_SIZE bytes, direct mapped. Both must be powers of two.
+#ifndef QSPI_CACHE_LINES
+#define QSPI_CACHE_LINES 8
+#endif
+#ifndef QSPI_CACHE_LINE_SIZE
+#define QSPI_CACHE_LINE_SIZE 32
+#endif
+
+typedef struct
+{
+	unsigned int hits;          /*! reads served from the cache */
+	unsigned int misses;        /*! lines read from the flash */
+	unsigned int invalidations; /*! lines dropped because the flash under them was written */
+} flash_cache_stats_t;
+
 extern int* cr      ;
  extern int* dcr    ;
  extern int* sr     ; 
@@ -179,6 +213,13 @@ int flashReadFlagRegister(void);
 int flashWriteEnable(void);
 int flashEnable4ByteAddressingMode(void);
 int flash_Write_disable(void);
+int flashXipActive(void);
+int flashPageProgramQuadSPI(int address, const uint8_t* data, int len);
+int flashWriteQuadSPI(int address, const uint8_t* data, int len, int erase);
+int flashReadQuadSPIBuffer(int address, uint8_t* data, int len, int ddr);
+int flashCachedRead(int address, uint8_t* data, int len);
+void flashCacheInvalidate(int address, int len);
+void flashCacheStats(flash_cache_stats_t* stats);
 
 
 #endif
@@ -96,6 +96,18 @@
 #define SPI_CRCERR	(1 << 4)
 #define TXE		(1 << 1)
 #define RXNE		(1 << 0)
+#define SPI_BSY		(1 << 7)
+
+// one transfer sends from DR1..DR4 and receives into DR5
+#define SPI_TX_BYTES_MAX	16
+#define SPI_RX_BYTES_MAX	4
+
+#ifndef SPI_POLL_LIMIT
+#define SPI_POLL_LIMIT	1000000
+#endif
+
+// flash status register
+#define FLASH_STATUS_WIP	(1 << 0)
 
 // function prototype
 
@@ -122,5 +134,8 @@ uint32_t flash_read(uint32_t address);
 uint32_t flash_cmd_read(uint32_t command);
 uint32_t flash_status_register_read(void);
 uint32_t flash_device_id(void);
+int flash_read_bytes(uint32_t address, uint8_t* data, uint32_t len);
+int flash_write_bytes(uint32_t address, const uint8_t* data, uint32_t len);
+int flash_erase_sector(uint32_t address);
 
 #endif
@@ -0,0 +1,115 @@
+/***************************************************************************
+ * Project                          : shakti devt board
+ * Name of the file                 : spi_flash_block.h
+ * Brief Description of file        : Header to the spi flash block layer
+ * Name of Author                   :
+ * Email ID                         :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+ * @file spi_flash_block.h
+ * @brief Header to the spi flash block layer
+ * @detail A block device over the byte level calls of spi_flash_w25q32.c and
+ * spi_spansion.c. Writes go into a write back cache of flash pages and reach
+ * the flash on eviction or flash_block_sync(), one page program per dirty
+ * page. Erases are queued and carried out before the first program into
+ * their sector, and the pages of an erased sector are programmed without
+ * reading them first. Sectors of up to 64 KB are supported. The layer keeps
+ * no lock and should be used from one task.
+ */
+#ifndef SPI_FLASH_BLOCK_H
+#define SPI_FLASH_BLOCK_H
+
+#include <stdint.h>
+
+#define FLASH_BLOCK_PAGE_SIZE 256
+
+/* Pages held by the write back cache */
+#ifndef FLASH_BLOCK_CACHE_PAGES
+#define FLASH_BLOCK_CACHE_PAGES 4
+#endif
+
+/* Sectors whose erase is queued or has just run */
+#ifndef FLASH_BLOCK_ERASE_SLOTS
+#define FLASH_BLOCK_ERASE_SLOTS 4
+#endif
+
+/* Largest sector an erase slot can track, in pages: 64 KB */
+#define FLASH_BLOCK_SECTOR_PAGES_MAX 256
+
+#define FLASH_BLOCK_NO_PAGE 0xFFFFFFFFU
+
+/* Geometry and byte level calls of one flash part */
+typedef struct
+{
+	uint32_t size;
+	uint32_t sector_size;
+	int (*read)(uint32_t address, uint8_t* data, uint32_t len);
+	int (*program)(uint32_t address, const uint8_t* data, uint32_t len);
+	int (*erase)(uint32_t address);
+} flash_block_ops_t;
+
+typedef struct
+{
+	uint32_t cache_hits;
+	uint32_t cache_misses;
+	uint32_t reads;
+	uint32_t read_bytes;
+	uint32_t programs;
+	uint32_t program_bytes;
+	uint32_t erases;
+	uint32_t sector_rewrites;
+	uint32_t need_erase;
+} flash_block_stats_t;
+
+/* A sector to erase, or one erased since, with the pages programmed after */
+typedef struct
+{
+	uint32_t sector;
+	uint32_t erased;
+	uint32_t programmed[FLASH_BLOCK_SECTOR_PAGES_MAX / 32];
+} flash_block_erase_t;
+
+typedef struct
+{
+	uint32_t address;
+	uint32_t used;
+	uint8_t dirty;
+	uint8_t data[FLASH_BLOCK_PAGE_SIZE];
+} flash_block_line_t;
+
+typedef struct
+{
+	const flash_block_ops_t* ops;
+	uint8_t* sector_buf;
+	uint32_t clock;
+	flash_block_erase_t erases[FLASH_BLOCK_ERASE_SLOTS];
+	flash_block_line_t lines[FLASH_BLOCK_CACHE_PAGES];
+	flash_block_stats_t stats;
+} flash_block_t;
+
+/* Defined by whichever of the spi flash drivers is linked */
+extern const flash_block_ops_t w25q32_flash_ops;
+extern const flash_block_ops_t spansion_flash_ops;
+
+void flash_block_init(flash_block_t* dev, const flash_block_ops_t* ops, uint8_t* sector_buf);
+int flash_block_read(flash_block_t* dev, uint32_t address, uint8_t* data, uint32_t len);
+int flash_block_write(flash_block_t* dev, uint32_t address, const uint8_t* data, uint32_t len);
+int flash_block_erase(flash_block_t* dev, uint32_t address, uint32_t len);
+int flash_block_sync(flash_block_t* dev);
+
+#endif
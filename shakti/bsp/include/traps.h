@@ -127,4 +127,19 @@ void default_handler(uintptr_t cause, uintptr_t epc);
 unsigned int extract_ie_code(unsigned int num);
 uintptr_t handle_trap(uintptr_t cause, uintptr_t epc);
 
+/*
+   Access to control and status registers, e.g. read_csr(mcycle).
+   A platform may define its own before this file is included.
+ */
+#ifndef read_csr
+#define read_csr(reg) ({ uintptr_t __tmp; \
+	__asm__ volatile ("csrr %0, " #reg : "=r"(__tmp)); __tmp; })
+#define write_csr(reg, val) \
+	__asm__ volatile ("csrw " #reg ", %0" :: "rK"((uintptr_t) (val)))
+#define set_csr(reg, bit) \
+	__asm__ volatile ("csrs " #reg ", %0" :: "rK"((uintptr_t) (bit)))
+#define clear_csr(reg, bit) \
+	__asm__ volatile ("csrc " #reg ", %0" :: "rK"((uintptr_t) (bit)))
+#endif
+
 #endif
@@ -23,7 +23,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 /**
  * @file uart.h
  * @brief Header file for uart
- * @detail this is the header file for uart.c   
+ * @detail this is the header file for uart.c. Building with UART_BUFFERED
+ * adds the interrupt driven uart_write and uart_read, which block on the
+ * calling task's notification when UART_FREERTOS is also defined.
  */
 
 #ifndef UART_H
@@ -85,6 +87,45 @@ typedef struct
 #define PARITY(x) ( (x & 3)  << 3 ) /*! 00 --- No parity; 01 -Odd Parity; 10 - Even Parity;  11 - Unused */
 #define UART_TX_RX_LEN(x)       ( (x & 0x1F) << 5) /*! Maximum length 32 bits */
 
+/* Register accessors. A platform.h may define these to run the driver
+   against a model of the uart instead of the hardware. */
+#ifndef uart_read_status
+#define uart_read_status(instance)	((instance)->status)
+#endif
+#ifndef uart_write_tx
+#define uart_write_tx(instance, ch)	((instance)->tx_reg = (ch))
+#endif
+#ifndef uart_read_rx
+#define uart_read_rx(instance)	((instance)->rcv_reg)
+#endif
+
+#ifdef UART_BUFFERED
+/* Sizes of the transmit and receive rings kept for each uart. Both must be
+   powers of two. */
+#ifndef UART_TX_RING_SIZE
+#define UART_TX_RING_SIZE	256
+#endif
+#ifndef UART_RX_RING_SIZE
+#define UART_RX_RING_SIZE	128
+#endif
+
+/* Timeout for uart_write and uart_read that never expires. */
+#define UART_WAIT_FOREVER	0xFFFFFFFFU
+
+/* Counters kept for each buffered uart */
+typedef struct
+{
+	uint32_t tx_bytes;	/*! bytes moved from the tx ring to the uart */
+	uint32_t rx_bytes;	/*! bytes moved from the uart to the rx ring */
+	uint32_t rx_overflows;	/*! bytes dropped because the rx ring was full */
+	uint32_t rx_overruns;	/*! times the uart reported that its rx fifo overran */
+	uint32_t tx_timeouts;	/*! uart_write calls that timed out with the ring full */
+	uint32_t rx_timeouts;	/*! uart_read calls that timed out short of their length */
+	uint32_t tx_max_level;	/*! most bytes ever waiting in the tx ring */
+	uint32_t rx_max_level;	/*! most bytes ever waiting in the rx ring */
+} uart_buffer_stats_t;
+#endif
+
 extern uart_struct *uart_instance[MAX_UART_COUNT];
 extern unsigned char uart0_complete;
 extern unsigned char uart1_complete;
@@ -118,6 +159,14 @@ unsigned char uart1_isr(void);
 unsigned char uart2_isr(void);
 #endif
 
+#ifdef UART_BUFFERED
+int uart_enable_buffering(uart_struct * instance);
+uint32_t uart_write(uart_struct * instance, const uint8_t * data, uint32_t len, uint32_t timeout);
+uint32_t uart_read(uart_struct * instance, uint8_t * data, uint32_t len, uint32_t timeout);
+void uart_get_buffer_stats(uart_struct * instance, uart_buffer_stats_t * stats);
+void uart_buffered_isr(uint32_t interrupt_id);
+#endif
+
 int is_empty(void);
 
 #undef putchar
@@ -30,6 +30,8 @@
 #define UTIL_H
 #include <stdio.h>
 #include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
 
 /* function prototype */
 void waitfor(unsigned int secs);
@@ -43,5 +45,8 @@ void write_word(uint32_t *addr, unsigned long val);
 int int_to_string(int number, char str[], unsigned int afterpoint);
 void _printf_(const char *fmt, va_list ap);
 int printf(const char* fmt, ...);
+int vsnprintf(char *str, size_t size, const char *fmt, va_list ap);
+int snprintf(char *str, size_t size, const char *fmt, ...);
+int sprintf(char *str, const char *fmt, ...);
 
 #endif
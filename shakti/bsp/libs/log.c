@@ -29,17 +29,37 @@
 #include "log.h"
 #include "utils.h"
 
-/*Use -D compiler flag to set the LOG_LEVEL; default value is 1*/
-#ifndef LOG_LEVEL
-#define LOG_LEVEL 3 
+/* PLIC_NESTING is set on the command line, see plic_driver.h. */
+#if PLIC_NESTING
+#include "platform.h"
+#include "traps.h"
+#include "defines.h"
 #endif
 
+/* Number of interrupt logs held until log_isr_drain runs; a power of two. */
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 32
+#endif
+
+/* A log saved by an interrupt handler, printed later by log_isr_drain. */
+struct log_record
+{
+	const char *fmt;
+	uintptr_t arg[4];
+};
+
+static struct log_record log_ring[LOG_RING_SIZE];
+static volatile unsigned int log_ring_head;
+static volatile unsigned int log_ring_tail;
+static volatile unsigned int log_ring_dropped;
+static unsigned int log_ring_reported;
+
 /** @fn void log_trace(const char*fmt, ...)
  * @brief Function to print trace logs
  * @details This function print trace logs if the LOG_LEVEL allows trace logs
  * @param const char* (printf formatted arguments with format specifiers)
  */
-void log_trace(const char* fmt, ...)
+void (log_trace)(const char* fmt, ...)
 {
 	if (TRACE <= LOG_LEVEL) {
 		va_list ap;
@@ -56,7 +76,7 @@ void log_trace(const char* fmt, ...)
  * @details This function print info logs if the LOG_LEVEL allows info logs
  * @param const char* (printf formatted arguments with format specifiers)
  */
-void log_info(const char* fmt, ...)
+void (log_info)(const char* fmt, ...)
 {
 	if (INFO <= LOG_LEVEL) {
 		va_list ap;
@@ -73,7 +93,7 @@ void log_info(const char* fmt, ...)
  * @details This function print debug logs if the LOG_LEVEL allows debug logs
  * @param const char* (printf formatted arguments with format specifiers)
  */
-void log_debug(const char* fmt, ...)
+void (log_debug)(const char* fmt, ...)
 {
 	if (DEBUG <= LOG_LEVEL) {
 		va_list ap;
@@ -90,7 +110,7 @@ void log_debug(const char* fmt, ...)
  * @details This function print trace warn if the LOG_LEVEL allows warn logs
  * @param const char* (printf formatted arguments with format specifiers)
  */
-void log_warn(const char* fmt, ...)
+void (log_warn)(const char* fmt, ...)
 {
 	if (WARN <= LOG_LEVEL) {
 		va_list ap;
@@ -107,7 +127,7 @@ void log_warn(const char* fmt, ...)
  * @details This function print error logs if the LOG_LEVEL allows error logs
  * @param const char* (printf formatted arguments with format specifiers)
  */
-void log_error(const char* fmt, ...)
+void (log_error)(const char* fmt, ...)
 {
 	if (ERROR <= LOG_LEVEL) {
 		va_list ap;
@@ -124,7 +144,7 @@ void log_error(const char* fmt, ...)
  * @details This function print fatal logs if the LOG_LEVEL allows fatal logs
  * @param const char* (printf formatted arguments with format specifiers)
  */
-void log_fatal(const char* fmt, ...)
+void (log_fatal)(const char* fmt, ...)
 {
 	if (FATAL <= LOG_LEVEL) {
 		va_list ap;
@@ -138,3 +158,78 @@ void log_fatal(const char* fmt, ...)
 	log_info("\n panic \n");
 	while (1);
 }
+
+/** @fn void log_isr_put(const char *fmt, uintptr_t arg0, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3)
+ * @brief Function to save a log from an interrupt handler
+ * @details Saves the format and arguments in the ring without formatting
+ *  them. Use it through the log_isr_ macros, which pass unused arguments as 0.
+ *  Without PLIC_NESTING handlers do not nest, so there is a single writer.
+ *  With it a handler may be preempted by another that also logs, so
+ *  interrupts are masked from reading the head until it is moved on, and a
+ *  preempting handler waits that long at most. The log is dropped and
+ *  counted if the ring is full.
+ * @param const char* fmt - printf format, which must stay valid until printed
+ * @param uintptr_t arg0 to arg3 - arguments, each saved as a word
+ */
+void log_isr_put(const char *fmt, uintptr_t arg0, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3)
+{
+	unsigned int head;
+	struct log_record *record;
+#if PLIC_NESTING
+	uintptr_t mie = read_csr(mstatus) & MSTATUS_MIE;
+
+	clear_csr(mstatus, MSTATUS_MIE);
+#endif
+
+	head = log_ring_head;
+	if (head - log_ring_tail >= LOG_RING_SIZE) {
+		log_ring_dropped++;
+	} else {
+		record = &log_ring[head & (LOG_RING_SIZE - 1)];
+		record->fmt = fmt;
+		record->arg[0] = arg0;
+		record->arg[1] = arg1;
+		record->arg[2] = arg2;
+		record->arg[3] = arg3;
+
+		__sync_synchronize();
+		log_ring_head = head + 1;
+	}
+
+#if PLIC_NESTING
+	if (mie)
+		set_csr(mstatus, MSTATUS_MIE);
+#endif
+}
+
+/** @fn unsigned int log_isr_drain(void)
+ * @brief Function to print the logs saved by interrupt handlers
+ * @details Prints and removes every log in the ring, then the number of logs
+ *  dropped since the last call, if any. Call it from one task only.
+ * @return unsigned int - number of logs printed
+ */
+unsigned int log_isr_drain(void)
+{
+	unsigned int printed = 0;
+	unsigned int dropped;
+
+	while (log_ring_tail != log_ring_head) {
+		struct log_record record;
+
+		__sync_synchronize();
+		record = log_ring[log_ring_tail & (LOG_RING_SIZE - 1)];
+		__sync_synchronize();
+		log_ring_tail++;
+
+		printf(record.fmt, record.arg[0], record.arg[1], record.arg[2], record.arg[3]);
+		printed++;
+	}
+
+	dropped = log_ring_dropped - log_ring_reported;
+	if (dropped) {
+		log_ring_reported += dropped;
+		printf("\n%u interrupt logs dropped\n", dropped);
+	}
+
+	return printed;
+}
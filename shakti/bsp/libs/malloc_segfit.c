@@ -0,0 +1,505 @@
+/***************************************************************************
+ * Project               	   : shakti devt board
+ * Name of the file	           : malloc_segfit.c
+ * Brief Description of file       : Malloc using segregated free lists.
+ * Name of Author    	           :
+ * Email ID                        :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ***************************************************************************/
+/**
+@file malloc_segfit.c
+@brief Malloc using segregated free lists.
+@detail This replaces the first-fit malloc in malloc_firstfit.c. Every block
+carries its size in a header word, and a free block repeats it in a footer
+word, so that free() can merge a block with both of its neighbours at once.
+Free blocks are kept in one list per power of two of their size, with a bitmap
+of the lists that are not empty. An allocation searches only the list of its
+own size class, and otherwise takes the first block of the next larger class
+that is not empty. The heap is taken from m_sbrk() in SEGFIT_GROW_SIZE steps
+as it is needed.
+
+Build with SEGFIT_FREERTOS defined to make the functions safe to call from
+FreeRTOS tasks. They must not be called from interrupts.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "malloc_segfit.h"
+
+#ifdef SEGFIT_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#define segfit_lock()		vTaskSuspendAll()
+#define segfit_unlock()		((void) xTaskResumeAll())
+#else
+#define segfit_lock()
+#define segfit_unlock()
+#endif
+
+/* Bytes asked of m_sbrk at a time, unless an allocation needs more. */
+#ifndef SEGFIT_GROW_SIZE
+#define SEGFIT_GROW_SIZE	4096
+#endif
+
+char *m_sbrk(int nbytes);
+
+/* The payload alignment and the granule of every block size. */
+#define SEGFIT_ALIGN		(2 * sizeof(size_t))
+#define SEGFIT_HDR		sizeof(size_t)
+
+/* Flags kept in the low bits of the header word. */
+#define SEGFIT_INUSE		((size_t) 1)
+#define SEGFIT_PREV_INUSE	((size_t) 2)
+#define SEGFIT_FLAGS		(SEGFIT_INUSE | SEGFIT_PREV_INUSE)
+
+/* A free block must hold its header, both links and its footer. */
+#define SEGFIT_MIN_BLOCK	(4 * sizeof(size_t))
+#define SEGFIT_MIN_SHIFT	(sizeof(size_t) == 8 ? 5 : 4)
+#define SEGFIT_NBINS		32
+
+#define SEGFIT_ROUND_UP(x)	(((x) + SEGFIT_ALIGN - 1) & ~(SEGFIT_ALIGN - 1))
+
+/* The links are only present while the block is free. An allocated block's
+ * payload starts where next would be and runs up to the next header. */
+struct segfit_block
+{
+	size_t head;
+	struct segfit_block *next;
+	struct segfit_block *prev;
+};
+
+static struct segfit_block *bins[SEGFIT_NBINS];
+static uint32_t bin_map;
+
+/* Header that ends the most recent region, and the end of that region. */
+static struct segfit_block *epilogue;
+static char *heap_top;
+
+static struct segfit_info stats;
+
+/** @fn static size_t block_size(const struct segfit_block *block)
+ * @brief returns the size of a block
+ * @param const struct segfit_block *block - the block
+ * @return size in bytes, header included
+ */
+static size_t block_size(const struct segfit_block *block)
+{
+	return block->head & ~SEGFIT_FLAGS;
+}
+
+/** @fn static struct segfit_block *block_at(const struct segfit_block *block, size_t offset)
+ * @brief returns the block that starts offset bytes after another
+ * @param const struct segfit_block *block - the block
+ * @param size_t offset - distance in bytes
+ * @return pointer to the block at that address
+ */
+static struct segfit_block *block_at(const struct segfit_block *block, size_t offset)
+{
+	return (struct segfit_block *) ((uintptr_t) block + offset);
+}
+
+/** @fn static void set_footer(struct segfit_block *block)
+ * @brief copies a free block's size into its last word
+ * @param struct segfit_block *block - the free block
+ */
+static void set_footer(struct segfit_block *block)
+{
+	size_t size = block_size(block);
+
+	*(size_t *) ((uintptr_t) block + size - SEGFIT_HDR) = size;
+}
+
+/** @fn static unsigned int bin_index(size_t size)
+ * @brief returns the free list for blocks of a size
+ * @detail list i holds blocks from 2^(i + SEGFIT_MIN_SHIFT) bytes up to,
+ * but not including, twice that. The last list holds everything larger.
+ * @param size_t size - block size in bytes
+ * @return index into bins
+ */
+static unsigned int bin_index(size_t size)
+{
+	unsigned int log2 = (unsigned int) (8 * sizeof(unsigned long) - 1) -
+		(unsigned int) __builtin_clzl((unsigned long) size);
+	unsigned int bin = log2 - SEGFIT_MIN_SHIFT;
+
+	return bin < SEGFIT_NBINS ? bin : SEGFIT_NBINS - 1;
+}
+
+/** @fn static void bin_insert(struct segfit_block *block)
+ * @brief adds a free block to the head of its list
+ * @param struct segfit_block *block - the free block
+ */
+static void bin_insert(struct segfit_block *block)
+{
+	size_t size = block_size(block);
+	unsigned int bin = bin_index(size);
+
+	block->prev = NULL;
+	block->next = bins[bin];
+	if (block->next)
+		block->next->prev = block;
+	bins[bin] = block;
+	bin_map |= (uint32_t) 1 << bin;
+
+	stats.ordblks++;
+	stats.fordblks += size;
+}
+
+/** @fn static void bin_remove(struct segfit_block *block)
+ * @brief takes a free block out of its list
+ * @param struct segfit_block *block - the free block
+ */
+static void bin_remove(struct segfit_block *block)
+{
+	size_t size = block_size(block);
+	unsigned int bin = bin_index(size);
+
+	if (block->prev)
+		block->prev->next = block->next;
+	else
+		bins[bin] = block->next;
+	if (block->next)
+		block->next->prev = block->prev;
+	if (!bins[bin])
+		bin_map &= ~((uint32_t) 1 << bin);
+
+	stats.ordblks--;
+	stats.fordblks -= size;
+}
+
+/** @fn static void release_block(struct segfit_block *block)
+ * @brief merges a free block with its free neighbours and lists the result
+ * @detail the block's INUSE flag must already be clear. Neither neighbour
+ * can be free after this, so there are never two free blocks side by side.
+ * @param struct segfit_block *block - the free block
+ */
+static void release_block(struct segfit_block *block)
+{
+	size_t size = block_size(block);
+	struct segfit_block *next = block_at(block, size);
+
+	if (!(next->head & SEGFIT_INUSE)) {
+		bin_remove(next);
+		size += block_size(next);
+	}
+
+	if (!(block->head & SEGFIT_PREV_INUSE)) {
+		size_t prev_size = *((size_t *) block - 1);
+
+		block = (struct segfit_block *) ((uintptr_t) block - prev_size);
+		bin_remove(block);
+		size += prev_size;
+	}
+
+	block->head = size | (block->head & SEGFIT_PREV_INUSE);
+	set_footer(block);
+	block_at(block, size)->head &= ~SEGFIT_PREV_INUSE;
+	bin_insert(block);
+}
+
+/** @fn static int grow_heap(size_t size)
+ * @brief adds at least size bytes of free space from m_sbrk
+ * @detail if the new memory follows the last region, the old epilogue
+ * becomes the header of the new block, which then merges with any free block
+ * before it. Otherwise the memory starts a new region.
+ * @param size_t size - block size the caller needs
+ * @return 0 on success, -1 if m_sbrk has no more memory
+ */
+static int grow_heap(size_t size)
+{
+	size_t request = size > SEGFIT_GROW_SIZE ? size : SEGFIT_GROW_SIZE;
+	struct segfit_block *block;
+	size_t prev_flag;
+	char *base;
+	char *end;
+
+	/* Room to align the first header and for the new epilogue. */
+	request = SEGFIT_ROUND_UP(request + SEGFIT_ALIGN + SEGFIT_HDR);
+	if (request > INT32_MAX)
+		return -1;
+
+	base = m_sbrk((int) request);
+	if (base == (char *) -1)
+		return -1;
+	end = base + request;
+
+	if (epilogue && base == heap_top) {
+		block = epilogue;
+		prev_flag = epilogue->head & SEGFIT_PREV_INUSE;
+	} else {
+		/* Headers sit one word before an aligned payload. */
+		uintptr_t payload = SEGFIT_ROUND_UP((uintptr_t) base + SEGFIT_HDR);
+
+		block = (struct segfit_block *) (payload - SEGFIT_HDR);
+		prev_flag = SEGFIT_PREV_INUSE;
+	}
+
+	size = ((uintptr_t) end - SEGFIT_HDR - (uintptr_t) block) & ~(SEGFIT_ALIGN - 1);
+	block->head = size | prev_flag;
+	epilogue = block_at(block, size);
+	epilogue->head = SEGFIT_INUSE;
+	heap_top = end;
+	stats.arena += request;
+
+	release_block(block);
+	return 0;
+}
+
+/** @fn static struct segfit_block *find_block(size_t size)
+ * @brief takes a free block of at least size bytes out of the lists
+ * @detail blocks in the list for size may be too small, so that list is
+ * searched. Any block in a larger list is big enough, so the first one of
+ * the next list that is not empty is taken without a search.
+ * @param size_t size - block size needed
+ * @return the block, or NULL if none is large enough
+ */
+static struct segfit_block *find_block(size_t size)
+{
+	unsigned int bin = bin_index(size);
+	struct segfit_block *block;
+	uint32_t larger;
+
+	for (block = bins[bin]; block; block = block->next) {
+		stats.search_steps++;
+		if (block_size(block) >= size) {
+			bin_remove(block);
+			return block;
+		}
+	}
+
+	larger = bin + 1 < SEGFIT_NBINS ? bin_map & ~(((uint32_t) 2 << bin) - 1) : 0;
+	if (!larger)
+		return NULL;
+
+	block = bins[__builtin_ctz(larger)];
+	stats.search_steps++;
+	bin_remove(block);
+	return block;
+}
+
+/** @fn static void *allocate(size_t request)
+ * @brief allocates a block with the lock held
+ * @param size_t request - payload size in bytes
+ * @return pointer to the payload, or NULL on failure
+ */
+static void *allocate(size_t request)
+{
+	struct segfit_block *block;
+	size_t size;
+	size_t spare;
+
+	if (request == 0 || request > SIZE_MAX / 2) {
+		stats.failures++;
+		return NULL;
+	}
+
+	size = SEGFIT_ROUND_UP(request + SEGFIT_HDR);
+	if (size < SEGFIT_MIN_BLOCK)
+		size = SEGFIT_MIN_BLOCK;
+
+	block = find_block(size);
+	if (!block) {
+		if (grow_heap(size) != 0) {
+			stats.failures++;
+			return NULL;
+		}
+		block = find_block(size);
+	}
+
+	spare = block_size(block) - size;
+	if (spare >= SEGFIT_MIN_BLOCK) {
+		struct segfit_block *rest = block_at(block, size);
+
+		block->head = size | SEGFIT_INUSE | (block->head & SEGFIT_PREV_INUSE);
+		rest->head = spare | SEGFIT_PREV_INUSE;
+		set_footer(rest);
+		bin_insert(rest);
+	} else {
+		size = block_size(block);
+		block->head |= SEGFIT_INUSE;
+		block_at(block, size)->head |= SEGFIT_PREV_INUSE;
+	}
+
+	stats.mallocs++;
+	stats.uordblks += size;
+	if (stats.uordblks > stats.usmblks)
+		stats.usmblks = stats.uordblks;
+
+	return &block->next;
+}
+
+/** @fn static void deallocate(void *ptr)
+ * @brief frees a block with the lock held
+ * @param void *ptr - payload pointer returned by allocate, or NULL
+ */
+static void deallocate(void *ptr)
+{
+	struct segfit_block *block;
+
+	if (!ptr)
+		return;
+
+	block = (struct segfit_block *) ((uintptr_t) ptr - SEGFIT_HDR);
+	if (!(block->head & SEGFIT_INUSE))
+		return;
+
+	stats.frees++;
+	stats.uordblks -= block_size(block);
+
+	block->head &= ~SEGFIT_INUSE;
+	release_block(block);
+}
+
+/** @fn void *segfit_malloc(size_t size)
+ * @brief allocates memory from the heap
+ * @param size_t size - number of bytes needed
+ * @return pointer aligned to twice the register size, or NULL on failure
+ */
+void *segfit_malloc(size_t size)
+{
+	void *ptr;
+
+	segfit_lock();
+	ptr = allocate(size);
+	segfit_unlock();
+
+	return ptr;
+}
+
+/** @fn void segfit_free(void *ptr)
+ * @brief returns memory to the heap
+ * @detail the block is merged with free neighbours straight away. Freeing
+ * NULL does nothing, as does freeing a block that is already free.
+ * @param void *ptr - pointer returned by segfit_malloc, or NULL
+ */
+void segfit_free(void *ptr)
+{
+	segfit_lock();
+	deallocate(ptr);
+	segfit_unlock();
+}
+
+/** @fn void *segfit_calloc(size_t nmemb, size_t size)
+ * @brief allocates zeroed memory for an array
+ * @param size_t nmemb - number of elements
+ * @param size_t size - size of each element
+ * @return pointer to the memory, or NULL on failure or overflow
+ */
+void *segfit_calloc(size_t nmemb, size_t size)
+{
+	void *ptr;
+
+	if (size && nmemb > SIZE_MAX / size)
+		return NULL;
+
+	ptr = segfit_malloc(nmemb * size);
+	if (ptr)
+		memset(ptr, 0, nmemb * size);
+
+	return ptr;
+}
+
+/** @fn void *segfit_realloc(void *ptr, size_t size)
+ * @brief changes the size of an allocation
+ * @detail the block is kept if it is already large enough, otherwise the
+ * contents move to a new block.
+ * @param void *ptr - pointer returned by segfit_malloc, or NULL
+ * @param size_t size - new size in bytes
+ * @return pointer to the memory, or NULL on failure, which leaves ptr allocated
+ */
+void *segfit_realloc(void *ptr, size_t size)
+{
+	struct segfit_block *block;
+	size_t available;
+	void *moved;
+
+	if (!ptr)
+		return segfit_malloc(size);
+
+	if (size == 0) {
+		segfit_free(ptr);
+		return NULL;
+	}
+
+	segfit_lock();
+
+	block = (struct segfit_block *) ((uintptr_t) ptr - SEGFIT_HDR);
+	available = block_size(block) - SEGFIT_HDR;
+	if (size <= available) {
+		segfit_unlock();
+		return ptr;
+	}
+
+	moved = allocate(size);
+	if (moved) {
+		memcpy(moved, ptr, available);
+		deallocate(ptr);
+	}
+
+	segfit_unlock();
+	return moved;
+}
+
+/** @fn void segfit_mallinfo(struct segfit_info *info)
+ * @brief copies out the heap statistics
+ * @detail largest is found from the highest free list that is not empty,
+ * which is the only one searched.
+ * @param struct segfit_info *info - filled in with the statistics
+ */
+void segfit_mallinfo(struct segfit_info *info)
+{
+	struct segfit_block *block;
+
+	segfit_lock();
+
+	*info = stats;
+	info->largest = 0;
+	if (bin_map) {
+		block = bins[31 - __builtin_clz(bin_map)];
+		for (; block; block = block->next)
+			if (block_size(block) > info->largest)
+				info->largest = block_size(block);
+	}
+
+	segfit_unlock();
+}
+
+#ifndef SEGFIT_NO_LIBC_NAMES
+/* The C library's malloc must not be linked as well, so all four of its
+ * allocation functions are replaced together. */
+#include <stdlib.h>
+
+void *malloc(size_t size)
+{
+	return segfit_malloc(size);
+}
+
+void free(void *ptr)
+{
+	segfit_free(ptr);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	return segfit_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	return segfit_realloc(ptr, size);
+}
+#endif
@@ -25,215 +25,983 @@
 @file printf.c
 @brief Print based command and control by uart
 @detail This file hosts a list of routines that helps in displaying variable's
-value based on there data type. Currently, shakti-sdk supports few formatting options.
+value based on there data type. One formatter serves printf, _printf_ and the
+string calls. It takes the flags - + space # and 0, a width and a precision
+(either may be *), the length modifiers hh h l ll z j and t, and the
+conversions d i u o x X c s p f F and %. Decimal digits come two at a time
+from a table, with divides by constants the compiler turns into multiplies;
+on rv32, 64 bit values are split by long division on 16 bit halves, so no
+libgcc divide is called. %f reads the bits of the double and converts them
+with integer arithmetic only, exactly, rounding half to even as glibc does.
+printf and _printf_ gather their output in a buffer on the stack and hand it
+to the uart in blocks.
 */
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdarg.h>
 #include "utils.h"
 #include "uart.h"
 
-/** @fn  static inline void itoa (unsigned long long int number, unsigned base)
- * @brief integer to string conversion
- * @param unsigned long long int
- * @param unsigned
+/* Bytes printf and _printf_ gather before writing them to the uart */
+#ifndef PRINTF_BUF_SIZE
+#define PRINTF_BUF_SIZE 64
+#endif
+
+#define FMT_LEFT	0x01	/* - */
+#define FMT_PLUS	0x02	/* + */
+#define FMT_SPACE	0x04	/* space */
+#define FMT_ALT		0x08	/* # */
+#define FMT_ZERO	0x10	/* 0 */
+
+/* Length modifiers */
+enum { LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_Z, LEN_J, LEN_T };
+
+/* Where the formatter's characters go */
+typedef struct
+{
+	char *buf;
+	size_t size;		/* room in buf */
+	size_t pos;		/* characters waiting in buf */
+	size_t count;		/* characters produced, kept or not */
+	void (*flush)(const char *s, size_t len);	/* NULL for a string */
+} fmt_out_t;
+
+typedef struct
+{
+	unsigned int flags;
+	int width;
+	int precision;		/* -1 if not given */
+} fmt_spec_t;
+
+/* The fraction of a double, bits / 2^shift when it fits, else in limbs */
+typedef struct
+{
+	uint64_t bits;
+	int shift;		/* 0 for the limbs */
+	int len;		/* limbs in use; 1 or 0 for bits, whether it is not 0 */
+	uint32_t limb[34];	/* most significant first; 2^-1074 needs 1074 bits */
+} fmt_frac_t;
+
+static const char digit_pairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const char hex_lower[] = "0123456789abcdef";
+static const char hex_upper[] = "0123456789ABCDEF";
+
+/** @fn static void fmt_putc(fmt_out_t *out, char c)
+ * @brief adds one character to the output
+ * @details A string output drops what does not fit and still counts it.
+ */
+static inline void fmt_putc(fmt_out_t *out, char c)
+{
+	if (out->pos >= out->size && out->flush)
+	{
+		out->flush(out->buf, out->pos);
+		out->pos = 0;
+	}
+
+	if (out->pos < out->size)
+		out->buf[out->pos++] = c;
+
+	out->count++;
+}
+
+/** @fn static void fmt_fill(fmt_out_t *out, const char *s, char c, size_t len)
+ * @brief adds len characters from s, or len copies of c if s is NULL
+ * @details Copies as much as the buffer has room for at a time, keeping
+ *          the position in a local rather than in out.
+ */
+static void fmt_fill(fmt_out_t *out, const char *s, char c, size_t len)
+{
+	size_t pos, room, i;
+	char *dst;
+
+	out->count += len;
+
+	while (len)
+	{
+		pos = out->pos;
+		room = out->size - pos;
+
+		if (room == 0)
+		{
+			if (!out->flush)
+				return;
+			out->flush(out->buf, pos);
+			out->pos = 0;
+			continue;
+		}
+
+		if (room > len)
+			room = len;
+
+		dst = out->buf + pos;
+		if (s)
+		{
+			for (i = 0; i < room; i++)
+				dst[i] = s[i];
+			s += room;
+		}
+		else
+			for (i = 0; i < room; i++)
+				dst[i] = c;
+
+		out->pos = pos + room;
+		len -= room;
+	}
+}
+
+/** @fn static void fmt_write(fmt_out_t *out, const char *s, size_t len)
+ * @brief adds len characters to the output
+ */
+static inline void fmt_write(fmt_out_t *out, const char *s, size_t len)
+{
+	if (len)
+		fmt_fill(out, s, 0, len);
+}
+
+/** @fn static void fmt_pad(fmt_out_t *out, char c, int n)
+ * @brief adds n copies of c to the output
  */
+static inline void fmt_pad(fmt_out_t *out, char c, int n)
+{
+	if (n > 0)
+		fmt_fill(out, NULL, c, (size_t) n);
+}
 
-static inline void itoa (unsigned long long int number, unsigned base)
+/** @fn static char *fmt_u32(char *end, uint32_t n)
+ * @brief writes n in decimal, ending just before end
+ * @return the first digit
+ */
+static char *fmt_u32(char *end, uint32_t n)
 {
-	int i = 0;
-	unsigned int intermediate = 0;
-	unsigned int digits[sizeof(number)*8];
+	uint32_t q;
+
+	while (n >= 100)
+	{
+		q = n / 100;
+		end -= 2;
+		end[0] = digit_pairs[2 * (n - q * 100)];
+		end[1] = digit_pairs[2 * (n - q * 100) + 1];
+		n = q;
+	}
+
+	if (n >= 10)
+	{
+		end -= 2;
+		end[0] = digit_pairs[2 * n];
+		end[1] = digit_pairs[2 * n + 1];
+	}
+	else
+		*--end = (char) ('0' + n);
 
-	while (1) {
-		digits[i] = number % base;
+	return end;
+}
 
-		if (number < base)
-			break;
+/** @fn static char *fmt_u32_8(char *end, uint32_t n)
+ * @brief writes n, below 10^8, as exactly 8 decimal digits
+ */
+static char *fmt_u32_8(char *end, uint32_t n)
+{
+	uint32_t q;
+	int i;
 
-		number /= base;
-		i++;
+	for (i = 0; i < 4; i++)
+	{
+		q = n / 100;
+		end -= 2;
+		end[0] = digit_pairs[2 * (n - q * 100)];
+		end[1] = digit_pairs[2 * (n - q * 100) + 1];
+		n = q;
 	}
-	i++;
-	while (i-- > 0)
+
+	return end;
+}
+
+#if __riscv_xlen == 32
+/** @fn static uint64_t fmt_div_1e4(uint64_t n, uint32_t *rem)
+ * @brief divides n by 10000 a 16 bit half word at a time
+ * @details Each step divides a value below 10000 * 2^16 by a constant,
+ *          which fits 32 bits, where n / 10000 would call __udivdi3.
+ */
+static uint64_t fmt_div_1e4(uint64_t n, uint32_t *rem)
+{
+	uint32_t r = 0, cur, q;
+	uint64_t quot = 0;
+	int shift;
+
+	for (shift = 48; shift >= 0; shift -= 16)
 	{
-		if (digits[i] >= 10)
-			intermediate = 'a' - 10;
-		else
-			intermediate = '0';
+		cur = (r << 16) | (uint32_t) ((n >> shift) & 0xFFFF);
+		q = cur / 10000;
+		r = cur - q * 10000;
+		quot |= (uint64_t) q << shift;
+	}
+
+	*rem = r;
+	return quot;
+}
+#endif
 
-		putchar(digits[i] + intermediate);
+/** @fn static char *fmt_u64(char *end, uint64_t n)
+ * @brief writes n in decimal, ending just before end
+ * @details Splits off 8 digits at a time while n does not fit 32 bits.
+ * @return the first digit
+ */
+static char *fmt_u64(char *end, uint64_t n)
+{
+	uint32_t low;
+#if __riscv_xlen == 32
+	uint32_t high;
+#endif
+
+	while (n > 0xFFFFFFFFU)
+	{
+#if __riscv_xlen == 32
+		n = fmt_div_1e4(n, &low);
+		n = fmt_div_1e4(n, &high);
+		low += high * 10000;
+#else
+		low = (uint32_t) (n % 100000000);
+		n /= 100000000;
+#endif
+		end = fmt_u32_8(end, low);
 	}
+
+	return fmt_u32(end, (uint32_t) n);
 }
 
-/** @fn void _printf_(const char *fmt, va_list ap)
- * @brief Handles the input stream of characters to print on screen
- * @details Identifies the type of format string, number of arguments and prints the right characer on screen
- * @param const char * fmt - formatting strings
- * @param const va_list ap - arg list
+/** @fn static char *fmt_pow2(char *end, uint64_t n, unsigned int shift, const char *digits)
+ * @brief writes n in base 8 or 16, ending just before end
  */
-void _printf_(const char *fmt, va_list ap)
+static char *fmt_pow2(char *end, uint64_t n, unsigned int shift, const char *digits)
 {
-	register const char* p;
-	const char* last_fmt;
-	register int ch;
-	unsigned long long num;
-	int base, lflag, i;
-	float float_num = 0;
-	char float_arr[30] = {'\0'};
-	int backtothebeginning;
-
-	for (;;) {
-		for (;(ch = *(unsigned char *) fmt) != '%'; fmt++) {
-			if (ch == '\0')
-				return;
-			putchar(ch);
+	unsigned int mask = (1U << shift) - 1;
+
+	do
+	{
+		*--end = digits[n & mask];
+		n >>= shift;
+	} while (n);
+
+	return end;
+}
+
+/** @fn static void fmt_field(fmt_out_t *out, const fmt_spec_t *spec, const char *prefix, int prefix_len, int zeros, const char *digits, int len)
+ * @brief writes a prefix, zeros and digits padded out to the width
+ * @details The 0 flag pads with zeros between the prefix and the digits.
+ */
+static void fmt_field(fmt_out_t *out, const fmt_spec_t *spec, const char *prefix,
+		      int prefix_len, int zeros, const char *digits, int len)
+{
+	int pad = spec->width - prefix_len - zeros - len;
+
+	if ((spec->flags & (FMT_ZERO | FMT_LEFT)) == FMT_ZERO && pad > 0)
+	{
+		zeros += pad;
+		pad = 0;
+	}
+
+	if (!(spec->flags & FMT_LEFT))
+		fmt_pad(out, ' ', pad);
+
+	fmt_write(out, prefix, (size_t) prefix_len);
+	fmt_pad(out, '0', zeros);
+	fmt_write(out, digits, (size_t) len);
+
+	if (spec->flags & FMT_LEFT)
+		fmt_pad(out, ' ', pad);
+}
+
+/** @fn static void fmt_integer(fmt_out_t *out, fmt_spec_t *spec, uint64_t n, int negative, char conv)
+ * @brief formats an integer conversion
+ * @param uint64_t n --- the magnitude
+ * @param int negative --- for d and i
+ * @param char conv --- d, u, o, x, X, or p
+ */
+static void fmt_integer(fmt_out_t *out, fmt_spec_t *spec, uint64_t n, int negative, char conv)
+{
+	char buf[24];
+	char *end = buf + sizeof(buf);
+	char *digits = end;
+	char prefix[2];
+	int prefix_len = 0;
+	int len, zeros;
+
+	if (spec->precision >= 0)
+		spec->flags &= ~FMT_ZERO;
+	else
+		spec->precision = 1;
+
+	if (n != 0 || spec->precision != 0)
+	{
+		if (conv == 'x' || conv == 'p')
+			digits = fmt_pow2(end, n, 4, hex_lower);
+		else if (conv == 'X')
+			digits = fmt_pow2(end, n, 4, hex_upper);
+		else if (conv == 'o')
+			digits = fmt_pow2(end, n, 3, hex_lower);
+		else
+			digits = fmt_u64(end, n);
+	}
+
+	/* a bare %d, %u or %x, the usual case, needs no field */
+	if (spec->flags == 0 && spec->width == 0 && spec->precision == 1)
+	{
+		if (negative)
+			*--digits = '-';
+		fmt_write(out, digits, (size_t) (end - digits));
+		return;
+	}
+
+	len = (int) (end - digits);
+	zeros = spec->precision > len ? spec->precision - len : 0;
+
+	if (conv == 'd')
+	{
+		if (negative)
+			prefix[prefix_len++] = '-';
+		else if (spec->flags & FMT_PLUS)
+			prefix[prefix_len++] = '+';
+		else if (spec->flags & FMT_SPACE)
+			prefix[prefix_len++] = ' ';
+	}
+	else if (spec->flags & FMT_ALT)
+	{
+		if (conv == 'o' && zeros == 0 && (len == 0 || digits[0] != '0'))
+			zeros = 1;
+		else if (conv != 'o' && conv != 'u' && n != 0)
+		{
+			prefix[prefix_len++] = '0';
+			prefix[prefix_len++] = conv == 'X' ? 'X' : 'x';
 		}
-		fmt++;
+	}
 
-		// Process a %-escape sequence
-		last_fmt = fmt;
-		lflag = 0;
+	fmt_field(out, spec, prefix, prefix_len, zeros, digits, len);
+}
 
-		backtothebeginning = 0;
-		for (;;) {
+/** @fn static int fmt_frac_digit(fmt_frac_t *frac)
+ * @brief multiplies the fraction by 10
+ * @return the digit that moves above the point
+ */
+static int fmt_frac_digit(fmt_frac_t *frac)
+{
+	uint64_t t;
+	uint32_t carry = 0;
+	int i;
 
-			switch (ch = *(unsigned char *) fmt++) {
+	if (frac->shift)
+	{
+		t = frac->bits * 10;
+		frac->bits = t & ((1ULL << frac->shift) - 1);
+		frac->len = frac->bits != 0;
+		return (int) (t >> frac->shift);
+	}
 
-				// long flag (doubled for long long)
-				case 'l':
-					lflag++;
-					backtothebeginning = 1;
-					break;
+	for (i = frac->len - 1; i >= 0; i--)
+	{
+		t = (uint64_t) frac->limb[i] * 10 + carry;
+		frac->limb[i] = (uint32_t) t;
+		carry = (uint32_t) (t >> 32);
+	}
 
-					// character
-				case 'c':
-					putchar(va_arg(ap, int));
-					break;
+	while (frac->len > 0 && frac->limb[frac->len - 1] == 0)
+		frac->len--;
 
-					// string
-				case 's':
-					if ((p = va_arg(ap, char *)) == NULL)
-						p = "(null)";
-					for (; (ch = *p) != '\0' ;) {
-						putchar(ch);
-						p++;
-					}
-					break;
+	return (int) carry;
+}
 
-					// (signed) decimal
-				case 'd':
-					base = 10;
+/** @fn static void fmt_frac_copy(fmt_frac_t *dst, const fmt_frac_t *src)
+ * @brief copies a fraction and only the limbs it uses
+ */
+static void fmt_frac_copy(fmt_frac_t *dst, const fmt_frac_t *src)
+{
+	int i;
 
-					if (lflag >= 2)
-						num = va_arg(ap, long long);
-					else if (lflag ==1)
-						num = va_arg(ap, long);
-					else
-						num = va_arg(ap, int);
+	dst->bits = src->bits;
+	dst->shift = src->shift;
+	dst->len = src->len;
 
-					if ((long long) num < 0) {
-						putchar('-');
-						num = -(long long) num;
-					}
+	if (!src->shift)
+		for (i = 0; i < src->len; i++)
+			dst->limb[i] = src->limb[i];
+}
 
-					itoa( num, base);
+/** @fn static int fmt_frac_round_up(const fmt_frac_t *frac, int last_odd)
+ * @brief decides the rounding from what is left of the fraction
+ * @param int last_odd --- whether the last digit printed is odd, for a tie
+ */
+static int fmt_frac_round_up(const fmt_frac_t *frac, int last_odd)
+{
+	uint64_t half;
 
-					break;
+	if (frac->shift)
+	{
+		half = 1ULL << (frac->shift - 1);
+		return frac->bits > half || (frac->bits == half && last_odd);
+	}
 
-				case 'f':
-					float_num =  va_arg(ap, double);
+	if (frac->len == 0 || frac->limb[0] < 0x80000000U)
+		return 0;
 
-					ftoa(float_num, float_arr, 6);
+	if (frac->limb[0] > 0x80000000U || frac->len > 1)
+		return 1;
 
-					for( i = 0; float_arr[i] != '\0'; i++)
-					{
-						putchar(float_arr[i]);
-						if(i > 29) break;
-					}
-					break;
+	return last_odd;
+}
 
-					// unsigned decimal
-				case 'u':
-					base = 10;
+/** @fn static void fmt_float_emit(fmt_out_t *out, const fmt_spec_t *spec, char sign, const char *digits, int len, const fmt_frac_t *frac, int round_at)
+ * @brief writes a %f field
+ * @param const fmt_frac_t* frac --- the fraction, or NULL for none
+ * @param int round_at --- the fraction digit the rounding adds one to,
+ *        digits after it print as zeros; spec->precision for no rounding
+ */
+static void fmt_float_emit(fmt_out_t *out, const fmt_spec_t *spec, char sign, const char *digits,
+			   int len, const fmt_frac_t *frac, int round_at)
+{
+	fmt_frac_t f;
+	int point = spec->precision > 0 || (spec->flags & FMT_ALT);
+	int total = (sign ? 1 : 0) + len + point + spec->precision;
+	int pad = spec->width - total;
+	int zeros = 0;
+	int i, d;
+
+	if ((spec->flags & (FMT_ZERO | FMT_LEFT)) == FMT_ZERO && pad > 0)
+	{
+		zeros = pad;
+		pad = 0;
+	}
 
-					if (lflag >= 2)
-						num = va_arg(ap, unsigned long long);
-					else if (lflag)
-						num = va_arg(ap, unsigned long);
-					else
-						num = va_arg(ap, unsigned int);
+	if (!(spec->flags & FMT_LEFT))
+		fmt_pad(out, ' ', pad);
 
-					itoa( num, base);
+	if (sign)
+		fmt_putc(out, sign);
 
-					break;
+	fmt_pad(out, '0', zeros);
+	fmt_write(out, digits, (size_t) len);
 
-					// (unsigned) octal
-				case 'o':
-					// should do something with padding so it's always 3 octits
-					base = 8;
+	if (point)
+		fmt_putc(out, '.');
 
-					if (lflag >= 2)
-						num = va_arg(ap, unsigned long long);
-					else if (lflag)
-						num = va_arg(ap, unsigned long);
-					else
-						num = va_arg(ap, unsigned int);
+	if (frac)
+	{
+		fmt_frac_copy(&f, frac);
 
-					itoa( num, base);
+		for (i = 0; i < spec->precision; i++)
+		{
+			if (i > round_at)
+			{
+				fmt_putc(out, '0');
+				continue;
+			}
 
-					break;
+			d = f.len ? fmt_frac_digit(&f) : 0;
+			fmt_putc(out, (char) ('0' + d + (i == round_at)));
+		}
+	}
+	else
+		fmt_pad(out, '0', spec->precision);
 
-				case 'x':
-					base = 16;
+	if (spec->flags & FMT_LEFT)
+		fmt_pad(out, ' ', pad);
+}
 
-					if (lflag >= 2)
-						num = va_arg(ap, unsigned long long);
-					else if (lflag)
-						num = va_arg(ap, unsigned long);
-					else
-						num = va_arg(ap, unsigned int);
+/** @fn static void fmt_float_big(fmt_out_t *out, const fmt_spec_t *spec, char sign, uint64_t mant, int shift)
+ * @brief writes mant * 2^shift, a whole number above 2^64
+ * @details Long division by 10^4 on 16 bit half words, as fmt_div_1e4.
+ *          Kept apart so only this case needs the 312 byte digit buffer.
+ */
+static void __attribute__((noinline)) fmt_float_big(fmt_out_t *out, const fmt_spec_t *spec,
+						   char sign, uint64_t mant, int shift)
+{
+	uint16_t limb[64];	/* 53 + 971 bits */
+	char buf[312];
+	char *end = buf + sizeof(buf);
+	char *digits = end;
+	uint32_t r, cur, q;
+	int top, i;
 
-					itoa( num, base);
+	for (i = 0; i < 64; i++)
+		limb[i] = 0;
 
-					break;
+	i = shift / 16;
+	limb[i++] = (uint16_t) (mant << (shift % 16));
+	mant >>= 16 - shift % 16;
 
-					// escaped '%' character
-				case '%':
-					putchar(ch);
-					break;
+	while (mant)
+	{
+		limb[i++] = (uint16_t) mant;
+		mant >>= 16;
+	}
 
-					// unrecognized escape sequence - just print it literally
-				default:
-					putchar('%');
-					fmt = last_fmt;
-					break;
+	top = i - 1;
+
+	while (top >= 0)
+	{
+		r = 0;
+
+		for (i = top; i >= 0; i--)
+		{
+			cur = (r << 16) | limb[i];
+			q = cur / 10000;
+			r = cur - q * 10000;
+			limb[i] = (uint16_t) q;
+		}
+
+		while (top >= 0 && limb[top] == 0)
+			top--;
+
+		q = r / 100;
+		digits -= 4;
+		digits[0] = digit_pairs[2 * q];
+		digits[1] = digit_pairs[2 * q + 1];
+		digits[2] = digit_pairs[2 * (r - q * 100)];
+		digits[3] = digit_pairs[2 * (r - q * 100) + 1];
+	}
+
+	while (*digits == '0')
+		digits++;
+
+	fmt_float_emit(out, spec, sign, digits, (int) (end - digits), NULL, spec->precision);
+}
+
+/** @fn static void fmt_float(fmt_out_t *out, fmt_spec_t *spec, uint64_t bits, char conv)
+ * @brief formats %f and %F from the bits of a double
+ * @details A pass over the fraction finds the rounding and the digit it
+ *          lands on; the digits are made again as they are written, so the
+ *          precision has no limit and no buffer is needed for them.
+ */
+static void fmt_float(fmt_out_t *out, fmt_spec_t *spec, uint64_t bits, char conv)
+{
+	fmt_frac_t frac, scan;
+	char buf[24];
+	char *end = buf + sizeof(buf);
+	char *digits;
+	char sign = 0;
+	int exponent = (int) ((bits >> 52) & 0x7FF);
+	uint64_t mant = bits & 0xFFFFFFFFFFFFFULL;
+	uint64_t ipart, fbits;
+	int shift, round_at, i, d, last;
+
+	if (bits >> 63)
+		sign = '-';
+	else if (spec->flags & FMT_PLUS)
+		sign = '+';
+	else if (spec->flags & FMT_SPACE)
+		sign = ' ';
+
+	if (spec->precision < 0)
+		spec->precision = 6;
+
+	if (exponent == 0x7FF)
+	{
+		spec->flags &= ~FMT_ZERO;
+		fmt_field(out, spec, &sign, sign ? 1 : 0, 0,
+			  mant ? (conv == 'F' ? "NAN" : "nan") : (conv == 'F' ? "INF" : "inf"), 3);
+		return;
+	}
+
+	/* value = mant * 2^-shift */
+	if (exponent == 0)
+		shift = 1074;
+	else
+	{
+		mant |= 1ULL << 52;
+		shift = 1075 - exponent;
+	}
+
+	if (shift < -11)
+	{
+		fmt_float_big(out, spec, sign, mant, -shift);
+		return;
+	}
+
+	if (shift <= 0)
+	{
+		ipart = mant << -shift;
+		fbits = 0;
+	}
+	else if (shift < 64)
+	{
+		ipart = mant >> shift;
+		fbits = mant & ((1ULL << shift) - 1);
+	}
+	else
+	{
+		ipart = 0;
+		fbits = mant;
+	}
+
+	/* fbits * 2^-shift; times 10 fits 64 bits up to 2^-60 */
+	frac.bits = fbits;
+	frac.shift = 0;
+	frac.len = 0;
+
+	if (fbits && shift <= 60)
+	{
+		frac.shift = shift;
+		frac.len = 1;
+	}
+	else if (fbits)
+	{
+		/* bit shift - 1 is the top bit of limb[0] */
+		frac.len = (shift + 31) / 32;
+		for (i = 0; i < frac.len; i++)
+			frac.limb[i] = 0;
+
+		i = frac.len - 1;
+		d = frac.len * 32 - shift;
+		if (d)
+		{
+			frac.limb[i--] = (uint32_t) (fbits << d);
+			fbits >>= 32 - d;
+		}
+
+		while (fbits)
+		{
+			frac.limb[i--] = (uint32_t) fbits;
+			fbits >>= 32;
+		}
+
+		while (frac.limb[frac.len - 1] == 0)
+			frac.len--;
+	}
+
+	/* the last digit the rounding leaves below 9 takes the carry */
+	fmt_frac_copy(&scan, &frac);
+	round_at = spec->precision;
+	last = -1;
+	d = (int) (ipart & 1);
+
+	for (i = 0; i < spec->precision && scan.len; i++)
+	{
+		d = fmt_frac_digit(&scan);
+		if (d != 9)
+			last = i;
+	}
+
+	if (i < spec->precision)
+	{
+		d = 0;
+		last = spec->precision - 1;
+	}
+
+	if (fmt_frac_round_up(&scan, d & 1))
+	{
+		round_at = last;
+		if (last < 0)
+			ipart++;
+	}
+
+	digits = fmt_u64(end, ipart);
+	fmt_float_emit(out, spec, sign, digits, (int) (end - digits), &frac, round_at);
+}
+
+/** @fn static void fmt_format(fmt_out_t *out, const char *fmt, va_list ap)
+ * @brief formats fmt and its arguments to out
+ */
+static void fmt_format(fmt_out_t *out, const char *fmt, va_list ap)
+{
+	const char *last_fmt;
+	const char *s;
+	fmt_spec_t spec;
+	union { double d; uint64_t u; } real;
+	uint64_t num;
+	int64_t snum;
+	int len, n;
+	char c;
+
+	for (;;)
+	{
+		for (s = fmt; *fmt != '%' && *fmt != '\0'; fmt++)
+			;
+		fmt_write(out, s, (size_t) (fmt - s));
+		if (*fmt++ == '\0')
+			return;
+
+		// Process a %-escape sequence
+		last_fmt = fmt;
+		spec.flags = 0;
+		spec.width = 0;
+		spec.precision = -1;
+		len = LEN_NONE;
+
+		for (;; fmt++)
+		{
+			if (*fmt == '-')
+				spec.flags |= FMT_LEFT;
+			else if (*fmt == '+')
+				spec.flags |= FMT_PLUS;
+			else if (*fmt == ' ')
+				spec.flags |= FMT_SPACE;
+			else if (*fmt == '#')
+				spec.flags |= FMT_ALT;
+			else if (*fmt == '0')
+				spec.flags |= FMT_ZERO;
+			else
+				break;
+		}
+
+		if (*fmt == '*')
+		{
+			spec.width = va_arg(ap, int);
+			if (spec.width < 0)
+			{
+				spec.flags |= FMT_LEFT;
+				spec.width = -spec.width;
 			}
+			fmt++;
+		}
+		else
+			for (; *fmt >= '0' && *fmt <= '9'; fmt++)
+				spec.width = spec.width * 10 + (*fmt - '0');
+
+		if (*fmt == '.')
+		{
+			fmt++;
+			spec.precision = 0;
 
-			if (backtothebeginning)
+			if (*fmt == '*')
 			{
-				backtothebeginning = 0;
-				continue;
+				n = va_arg(ap, int);
+				spec.precision = n < 0 ? -1 : n;
+				fmt++;
 			}
 			else
+				for (; *fmt >= '0' && *fmt <= '9'; fmt++)
+					spec.precision = spec.precision * 10 + (*fmt - '0');
+		}
+
+		switch (*fmt)
+		{
+			case 'h':
+				len = fmt[1] == 'h' ? LEN_HH : LEN_H;
+				break;
+			case 'l':
+				len = fmt[1] == 'l' ? LEN_LL : LEN_L;
+				break;
+			case 'z':
+				len = LEN_Z;
+				break;
+			case 'j':
+				len = LEN_J;
+				break;
+			case 't':
+				len = LEN_T;
+				break;
+		}
+
+		if (len != LEN_NONE)
+			fmt += (len == LEN_HH || len == LEN_LL) ? 2 : 1;
+
+		switch (c = *fmt++)
+		{
+			// character
+			case 'c':
+				c = (char) va_arg(ap, int);
+				spec.flags &= ~FMT_ZERO;
+				fmt_field(out, &spec, NULL, 0, 0, &c, 1);
+				break;
+
+			// string
+			case 's':
+				if ((s = va_arg(ap, const char *)) == NULL)
+					s = "(null)";
+				for (n = 0; (spec.precision < 0 || n < spec.precision) && s[n]; n++)
+					;
+				spec.flags &= ~FMT_ZERO;
+				fmt_field(out, &spec, NULL, 0, 0, s, n);
+				break;
+
+			// (signed) decimal
+			case 'd':
+			case 'i':
+				switch (len)
+				{
+					case LEN_HH: snum = (signed char) va_arg(ap, int); break;
+					case LEN_H: snum = (short) va_arg(ap, int); break;
+					case LEN_L: snum = va_arg(ap, long); break;
+					case LEN_LL: snum = va_arg(ap, long long); break;
+					case LEN_Z: snum = (ptrdiff_t) va_arg(ap, size_t); break;
+					case LEN_J: snum = va_arg(ap, intmax_t); break;
+					case LEN_T: snum = va_arg(ap, ptrdiff_t); break;
+					default: snum = va_arg(ap, int); break;
+				}
+				num = snum < 0 ? 0 - (uint64_t) snum : (uint64_t) snum;
+				fmt_integer(out, &spec, num, snum < 0, 'd');
+				break;
+
+			// unsigned decimal, octal and hexadecimal
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				switch (len)
+				{
+					case LEN_HH: num = (unsigned char) va_arg(ap, unsigned int); break;
+					case LEN_H: num = (unsigned short) va_arg(ap, unsigned int); break;
+					case LEN_L: num = va_arg(ap, unsigned long); break;
+					case LEN_LL: num = va_arg(ap, unsigned long long); break;
+					case LEN_Z: num = va_arg(ap, size_t); break;
+					case LEN_J: num = va_arg(ap, uintmax_t); break;
+					case LEN_T: num = (size_t) va_arg(ap, ptrdiff_t); break;
+					default: num = va_arg(ap, unsigned int); break;
+				}
+				fmt_integer(out, &spec, num, 0, c);
+				break;
+
+			// pointer, as glibc prints it
+			case 'p':
+				num = (uintptr_t) va_arg(ap, void *);
+				if (num == 0)
+				{
+					spec.flags &= ~FMT_ZERO;
+					fmt_field(out, &spec, NULL, 0, 0, "(nil)", 5);
+					break;
+				}
+				spec.flags |= FMT_ALT;
+				fmt_integer(out, &spec, num, 0, 'p');
+				break;
+
+			case 'f':
+			case 'F':
+				real.d = va_arg(ap, double);
+				fmt_float(out, &spec, real.u, c);
+				break;
+
+			// escaped '%' character
+			case '%':
+				fmt_putc(out, '%');
+				break;
+
+			// unrecognized escape sequence - just print it literally
+			default:
+				fmt_putc(out, '%');
+				fmt = last_fmt;
 				break;
 		}
 	}
 }
 
+/** @fn static void printf_flush(const char *s, size_t len)
+ * @brief writes out what printf has gathered
+ * @details With a buffered uart the block goes to its transmit ring in one
+ *          call; what that does not take goes out a character at a time.
+ */
+static void printf_flush(const char *s, size_t len)
+{
+#ifdef UART_BUFFERED
+	uint32_t sent = uart_write(uart_instance[0], (const uint8_t *) s, (uint32_t) len, UART_WAIT_FOREVER);
+
+	s += sent;
+	len -= sent;
+#endif
+
+	while (len--)
+		putchar(*s++);
+}
+
+/** @fn static int printf_uart(const char *fmt, va_list ap)
+ * @brief formats to the uart through a buffer on the stack
+ * @return the number of characters written
+ */
+static int printf_uart(const char *fmt, va_list ap)
+{
+	char buf[PRINTF_BUF_SIZE];
+	fmt_out_t out = { buf, sizeof(buf), 0, 0, printf_flush };
+
+	fmt_format(&out, fmt, ap);
+
+	if (out.pos)
+		printf_flush(buf, out.pos);
+
+	return (int) out.count;
+}
+
+/** @fn void _printf_(const char *fmt, va_list ap)
+ * @brief Handles the input stream of characters to print on screen
+ * @details Identifies the type of format string, number of arguments and prints the right characer on screen
+ * @param const char * fmt - formatting strings
+ * @param const va_list ap - arg list
+ */
+void _printf_(const char *fmt, va_list ap)
+{
+	printf_uart(fmt, ap);
+}
+
 /** @fn int printf(const char* fmt, ...)
  * @brief function to print characters on file
  * @details prints the characters on terminal
  * @param const char*
- * @return int
+ * @return int - the number of characters printed
  */
 int printf(const char* fmt, ...)
 {
 	va_list ap;
+	int n;
+
 	va_start(ap, fmt);
+	n = printf_uart(fmt, ap);
+	va_end(ap);
+
+	return n;
+}
+
+/** @fn int vsnprintf(char *str, size_t size, const char *fmt, va_list ap)
+ * @brief formats to a string
+ * @details Writes at most size - 1 characters and a terminating nul, when
+ *          size is not 0.
+ * @return the length the whole string would have, as C's vsnprintf
+ */
+int vsnprintf(char *str, size_t size, const char *fmt, va_list ap)
+{
+	fmt_out_t out = { str, size ? size - 1 : 0, 0, 0, NULL };
+
+	fmt_format(&out, fmt, ap);
 
-	_printf_(fmt, ap);
+	if (size)
+		str[out.pos] = '\0';
 
+	return (int) out.count;
+}
+
+/** @fn int snprintf(char *str, size_t size, const char *fmt, ...)
+ * @brief formats to a string of size bytes, as vsnprintf
+ */
+int snprintf(char *str, size_t size, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(str, size, fmt, ap);
 	va_end(ap);
-	return 0;// incorrect return value, but who cares, anyway?
+
+	return n;
+}
+
+/** @fn int sprintf(char *str, const char *fmt, ...)
+ * @brief formats to a string the caller has made room for
+ */
+int sprintf(char *str, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(str, SIZE_MAX, fmt, ap);
+	va_end(ap);
+
+	return n;
 }
@@ -64,6 +64,7 @@ char * m_sbrk (nbytes)
 	if(heap_ptr>end_of_heap)
 	{
 		log_error("\nMemory allocation error: Insufficient Space");
+		heap_ptr = base;
 		return -1;
 	}
 	return base;
@@ -29,7 +29,9 @@ used to achieve higher level objectives.
 
 #include "log.h"
 #include "utils.h"
-#include "string.h"
+#ifdef CLINT_TIMER
+#include "clint_timer.h"
+#endif
 
 /** @fn  void waitfor(unsigned int secs)
  * @brief stall the process for given time
@@ -43,10 +45,21 @@ void waitfor(unsigned int secs)
 
 /** @fn void delay(unsigned long count)
  * @brief  sleeps for number of "count"
+ * @details With CLINT_TIMER count is in milliseconds, timed by mtime, and a
+ *          task sleeps through it. Without, it is a million loop turns each.
  * @param unsigned long (number of count)
  */
 void delay(unsigned long count)
 {
+#ifdef CLINT_TIMER
+	while (count > 1000000)
+	{
+		timer_sleep_ms(1000000);
+		count -= 1000000;
+	}
+
+	timer_sleep_ms(count);
+#else
 	unsigned long cntr1 = count *1000;
 	unsigned long tmpCntr;
 
@@ -54,6 +67,7 @@ void delay(unsigned long count)
 		tmpCntr = 1000;
 		while (tmpCntr--);
 	}
+#endif
 }
 
 /** @fn float pow_10(unsigned int y)
@@ -97,9 +111,10 @@ void reverse(char *str, int length)
 /** @fn int int_to_string(int number, char str[], int afterpoint)
  * @brief convert decimal numbers to string
  * @details Takes num as input and converts it to string.
- *	    The converted string is stored in str. The
- *          position of last character in the str is returned.
- *          This function is tailored to support ftoa.
+ *	    The converted string is stored in str, with zeros in front
+ *          to make at least afterpoint digits. 0 with afterpoint 0 is
+ *          the empty string. The position of last character in the str
+ *          is returned.
  * @param int number
  * @param char str[]
  * @param int afterpoint
@@ -107,100 +122,21 @@ void reverse(char *str, int length)
  */
 int int_to_string(int number, char str[], unsigned int afterpoint)
 {
-	uint32_t i = 0;
-
-	/*extract each digit and put into str[i]*/
-
-	while (number != 0)
-	{
-		str[i] = ((number%10) + '0');
-		i++;
-		number = number/10;
-	}
-
-	/*insert 0 after the numbers, if count of digits less than afterpoint*/
-
-	while (i < afterpoint)
-	{
-		str[i] = '0';
-		i++;
-	}
-
-	/*
-	   zeroth digit is in oth position in array,
-	   To read digits properly, reverse array
-	 */
-	reverse(str, i);
-	str[i] = '\0';
-
-	return i;
+	return sprintf(str, "%.*d", (int) afterpoint, number);
 }
+
 /** @fn void ftoa(float n, char *res, int afterpoint)
  * @brief converts float to string
- * @details Split floating number into fpart and ipart
- *          Finally merge it into one float number.
- *          Return a string, which has the float value.
+ * @details Rounds n to afterpoint digits after the point, as %f does.
+ *          The digits come from the bits of n with integer arithmetic,
+ *          so no soft float is called but the widening to double.
  * @param float (floating point number - n)
  * @param char* (float in string - res)
  * @param int (precision - afterpoint)
  */
 void ftoa(float n, char *res, unsigned int afterpoint)
 {
-	int i=0;
-	char temp[30]={'\0'};
-	n += 0.0000001;
-
-	// Extract integer part
-	int ipart = (int)n;
-
-	// Extract floating part
-	float fpart = (float) (n - (float)ipart);
-	int j=0;
-
-	if(n < (0/1))
-	{
-		res[j]='-';
-		j=1;
-	}
-
-	if (ipart == 0)
-	{
-		res[j]='0';
-		j=j+1;
-	}
-	else{
-		if (ipart <0)
-		{
-			ipart =(-1)*ipart;
-		}
-
-		i = int_to_string(ipart, temp, 0);
-
-		strcpy(res+j,temp);
-	}
-
-	i = i+j;
-
-	// check for display option after point
-	if (afterpoint != 0)
-	{
-		res[i] = '.';// add dot
-
-		if (fpart < 0/1)
-		{
-
-			fpart = (-1)*fpart;
-
-		}
-		else if (fpart == 0/1)
-		{
-			fpart = fpart;
-		}
-
-		fpart = fpart * pow_10( afterpoint);
-
-		int_to_string((int)fpart, res + i + 1, afterpoint);
-	}
+	sprintf(res, "%.*f", (int) afterpoint, (double) n);
 }
 
 /** @fn void delay_loop(unsigned long cntr1, unsigned long cntr2)
@@ -43,9 +43,9 @@ Email id: sathya281@gmail.com
  */
 
 /*! Core Local Interruptor CLINT */
-#define CLINT_BASE 0x020000000
-#define MTIME      CLINT_BASE + 0xBFF8
-#define MTIMECMP   CLINT_BASE + 0x4000
+#define CLINT_BASE 0x02000000
+#define MTIME      (CLINT_BASE + 0xBFF8)
+#define MTIMECMP   (CLINT_BASE + 0x4000)
 
 #define CLOCK_FREQUENCY 50000000
 
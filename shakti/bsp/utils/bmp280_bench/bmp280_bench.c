@@ -0,0 +1,336 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  bmp280_bench.c
+* Brief Description of file             :  Checks and times the bmp280 integer compensation.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file bmp280_bench.c
+@brief Checks and times the bmp280 integer compensation.
+@detail A host program that runs bsp/drivers/i2c/bmp280_compensate.c,
+built unchanged, against reference vectors and against the datasheet's
+double precision formulas, which are written out here.
+
+The reference vectors are the datasheet's example: its trimming values with
+adc_T 519888 and adc_P 415148, which compensate to t_fine 128422, 25.08 C,
+and 25767233 / 256 = 100653.25 Pa in 64 bit or 100656 Pa in 32 bit
+integers, against 100653.26 Pa from the double formulas. The sweep then
+runs readings from -40 to 85 C and 300 to 1100 hPa through the integer and
+the double formulas for two sets of trimming values, and checks that they
+agree to within 0.01 C, 0.6 Pa in 64 bit and 8 Pa in 32 bit integers. The
+sensor's own noise is about 1.3 Pa at x1 oversampling.
+
+The 32 bit pressure formula as the demos had it, with the pressure held
+in a signed variable, is run through the same sweep to compare.
+
+The timings are of the same sweep, per sample. The host has an FPU, so the
+double formulas run at hardware speed here; on the E class cores they are
+soft float library calls, and the integer formulas' lead is much larger.
+*/
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include "sim_check.h"
+#include "bmp280.h"
+
+#define ADC_T_MIN	300000
+#define ADC_T_MAX	700000
+#define ADC_T_STEP	499
+#define ADC_P_MIN	150000
+#define ADC_P_MAX	700000
+#define ADC_P_STEP	997
+#define TIMING_ROUNDS	20
+
+/* The datasheet's example trimming values, dig_T1 to dig_P9 */
+static const uint8_t datasheet_raw[BMP280_CALIB_LEN] =
+{
+	0x70, 0x6b, 0x43, 0x67, 0x18, 0xfc,
+	0x7d, 0x8e, 0x43, 0xd6, 0xd0, 0x0b, 0x27, 0x0b, 0x8c, 0x00,
+	0xf9, 0xff, 0x8c, 0x3c, 0xf8, 0xc6, 0x70, 0x17
+};
+
+/* A second set, with every value moved within the range seen across parts */
+static const bmp280_calib_t second_calib =
+{
+	28009, 25654, 50,
+	38165, -10587, 3024, 7003, -204, -7, 15500, -14600, 6000
+};
+
+typedef struct
+{
+	int32_t adc_T;
+	int32_t adc_P;
+} reading_t;
+
+#define MAX_READINGS	400000
+
+static reading_t readings[MAX_READINGS];
+static unsigned int reading_count;
+static volatile uint32_t sink;
+static volatile double dsink;
+
+/** @fn static double temperature_double(const bmp280_calib_t *c, int32_t adc_T, int32_t *t_fine)
+ * @brief the datasheet's bmp280_compensate_T_double, in degrees Celsius
+ */
+static double temperature_double(const bmp280_calib_t *c, int32_t adc_T, int32_t *t_fine)
+{
+	double var1, var2;
+
+	var1 = (((double) adc_T) / 16384.0 - ((double) c->dig_T1) / 1024.0) * ((double) c->dig_T2);
+	var2 = ((((double) adc_T) / 131072.0 - ((double) c->dig_T1) / 8192.0) *
+		(((double) adc_T) / 131072.0 - ((double) c->dig_T1) / 8192.0)) * ((double) c->dig_T3);
+	*t_fine = (int32_t) (var1 + var2);
+
+	return (var1 + var2) / 5120.0;
+}
+
+/** @fn static double pressure_double(const bmp280_calib_t *c, int32_t adc_P, int32_t t_fine)
+ * @brief the datasheet's bmp280_compensate_P_double, in Pa
+ */
+static double pressure_double(const bmp280_calib_t *c, int32_t adc_P, int32_t t_fine)
+{
+	double var1, var2, p;
+
+	var1 = ((double) t_fine / 2.0) - 64000.0;
+	var2 = var1 * var1 * ((double) c->dig_P6) / 32768.0;
+	var2 = var2 + var1 * ((double) c->dig_P5) * 2.0;
+	var2 = (var2 / 4.0) + (((double) c->dig_P4) * 65536.0);
+	var1 = (((double) c->dig_P3) * var1 * var1 / 524288.0 + ((double) c->dig_P2) * var1) / 524288.0;
+	var1 = (1.0 + var1 / 32768.0) * ((double) c->dig_P1);
+
+	if (var1 == 0.0)
+		return 0;
+
+	p = 1048576.0 - (double) adc_P;
+	p = (p - (var2 / 4096.0)) * 6250.0 / var1;
+	var1 = ((double) c->dig_P9) * p * p / 2147483648.0;
+	var2 = p * ((double) c->dig_P8) / 32768.0;
+
+	return p + (var1 + var2 + ((double) c->dig_P7)) / 16.0;
+}
+
+/** @fn static uint32_t pressure_demo(const bmp280_calib_t *c, int32_t adc_P, int32_t t_fine)
+ * @brief the pressure formula of the demos' read_bmp280_values, in Pa
+ * @details Its p is signed, so p < (int32_t) 0x80000000 never holds and the
+ *          coarser branch always runs.
+ */
+static uint32_t pressure_demo(const bmp280_calib_t *c, int32_t adc_P, int32_t t_fine)
+{
+	int32_t var1, var2;
+	int32_t p;
+
+	var1 = (((int32_t)t_fine) / 2) - (int32_t)64000;
+	var2 = (((var1/4) * (var1/4)) / 2048 ) * ((int32_t)c->dig_P6);
+	var2 = var2 + ((var1 * ((int32_t)c->dig_P5)) * 2);
+	var2 = (var2/4) + (((int32_t)c->dig_P4) * 65536);
+	var1 = ((((int32_t)c->dig_P3 * (((var1/4) * (var1/4)) / 8192 )) / 8) + ((((int32_t)c->dig_P2) * var1)/2)) / 262144;
+	var1 =((((32768 + var1)) * ((int32_t)c->dig_P1)) / 32768);
+
+	if (var1 == 0)
+		return 0;
+
+	p = (((uint32_t)(((int32_t)1048576) - adc_P) - (var2 / 4096))) * 3125;
+
+	if (p < (int32_t) 0x80000000)
+		p = (p * 2) / ((uint32_t)var1);
+	else
+		p = (p / (uint32_t)var1) * 2;
+
+	var1 = (((int32_t)c->dig_P9) * ((int32_t)(((p/8) * (p/8)) / 8192))) / 4096;
+	var2 = (((int32_t)(p/4)) * ((int32_t)c->dig_P8)) / 8192;
+
+	return (uint32_t)((int32_t)p + ((var1 + var2 + (int32_t)c->dig_P7)/16));
+}
+
+/** @fn static void collect(const bmp280_calib_t *c)
+ * @brief gathers the readings of the sweep that lie in the sensor's range
+ */
+static void collect(const bmp280_calib_t *c)
+{
+	int32_t adc_T, adc_P, t_fine;
+	double t, p;
+
+	reading_count = 0;
+
+	for (adc_T = ADC_T_MIN; adc_T < ADC_T_MAX; adc_T += ADC_T_STEP)
+	{
+		t = temperature_double(c, adc_T, &t_fine);
+		if (t < -40.0 || t > 85.0)
+			continue;
+
+		for (adc_P = ADC_P_MIN; adc_P < ADC_P_MAX; adc_P += ADC_P_STEP)
+		{
+			p = pressure_double(c, adc_P, t_fine);
+			if (p < 30000.0 || p > 110000.0 || reading_count == MAX_READINGS)
+				continue;
+
+			readings[reading_count].adc_T = adc_T;
+			readings[reading_count].adc_P = adc_P;
+			reading_count++;
+		}
+	}
+}
+
+/** @fn static void test_reference(void)
+ * @brief checks the datasheet's example
+ */
+static void test_reference(void)
+{
+	bmp280_calib_t c;
+	bmp280_sample_t sample;
+	int32_t t_fine;
+	int32_t t;
+	uint8_t raw[BMP280_DATA_LEN] = { 0x65, 0x5a, 0xc0, 0x7e, 0xed, 0x00 };
+	uint8_t none[BMP280_DATA_LEN] = { 0x80, 0x00, 0x00, 0x80, 0x00, 0x00 };
+
+	bmp280_parse_calib(&c, datasheet_raw);
+	check(c.dig_T1 == 27504 && c.dig_T2 == 26435 && c.dig_T3 == -1000 && c.dig_P1 == 36477 &&
+	      c.dig_P2 == -10685 && c.dig_P3 == 3024 && c.dig_P4 == 2855 && c.dig_P5 == 140 &&
+	      c.dig_P6 == -7 && c.dig_P7 == 15500 && c.dig_P8 == -14600 && c.dig_P9 == 6000,
+	      "bmp280_parse_calib decodes the datasheet's trimming values");
+
+	t = bmp280_compensate_temperature(&c, 519888, &t_fine);
+	check(t == 2508 && t_fine == 128422, "adc_T 519888 is 25.08 C, t_fine 128422 (%d, %d)", t, t_fine);
+	check(bmp280_compensate_pressure(&c, 415148, t_fine) == 25767233,
+	      "adc_P 415148 is 25767233 / 256 Pa in 64 bit integers (%u)",
+	      bmp280_compensate_pressure(&c, 415148, t_fine));
+	check(bmp280_compensate_pressure32(&c, 415148, t_fine) == 100656,
+	      "and 100656 Pa in 32 bit integers (%u)", bmp280_compensate_pressure32(&c, 415148, t_fine));
+	check(fabs(temperature_double(&c, 519888, &t_fine) - 25.0825) < 0.0001 && t_fine == 128422 &&
+	      fabs(pressure_double(&c, 415148, t_fine) - 100653.258) < 0.001,
+	      "against 25.0825 C and 100653.258 Pa from the double formulas");
+
+	check(bmp280_compensate(&c, raw, &sample) == BMP280_SUCCESS && sample.temperature == 2508 &&
+	      sample.pressure == 25767233, "bmp280_compensate decodes the 6 adc bytes");
+	check(bmp280_compensate(&c, none, &sample) == EBMP280_NO_DATA,
+	      "and refuses the registers' reset value");
+
+	c.dig_P1 = 0;
+	check(bmp280_compensate_pressure(&c, 415148, 128422) == 0 &&
+	      bmp280_compensate_pressure32(&c, 415148, 128422) == 0,
+	      "a dig_P1 of zero gives 0 rather than dividing by zero");
+}
+
+/** @fn static void test_sweep(const char *name, const bmp280_calib_t *c)
+ * @brief compares the integer and double formulas over the sensor's range
+ */
+static void test_sweep(const char *name, const bmp280_calib_t *c)
+{
+	double t_err = 0, p64_err = 0, p32_err = 0, demo_err = 0;
+	unsigned int i;
+
+	collect(c);
+
+	for (i = 0; i < reading_count; i++)
+	{
+		int32_t t_fine, t_fine_double;
+		double t = temperature_double(c, readings[i].adc_T, &t_fine_double);
+		double p;
+		int32_t t_int = bmp280_compensate_temperature(c, readings[i].adc_T, &t_fine);
+		double e;
+
+		p = pressure_double(c, readings[i].adc_P, t_fine_double);
+
+		e = fabs(t_int / 100.0 - t);
+		if (e > t_err)
+			t_err = e;
+
+		e = fabs(bmp280_compensate_pressure(c, readings[i].adc_P, t_fine) / 256.0 - p);
+		if (e > p64_err)
+			p64_err = e;
+
+		e = fabs((double) bmp280_compensate_pressure32(c, readings[i].adc_P, t_fine) - p);
+		if (e > p32_err)
+			p32_err = e;
+
+		e = fabs((double) pressure_demo(c, readings[i].adc_P, t_fine) - p);
+		if (e > demo_err)
+			demo_err = e;
+	}
+
+	check(reading_count > 10000, "%s: %u readings from -40 to 85 C, 300 to 1100 hPa", name, reading_count);
+	check(t_err <= 0.01, "%s: temperature within 0.01 C of the double formula (%.4f)", name, t_err);
+	check(p64_err <= 0.6, "%s: 64 bit pressure within 0.6 Pa (%.3f)", name, p64_err);
+	check(p32_err <= 8.0, "%s: 32 bit pressure within 8 Pa (%.3f)", name, p32_err);
+	printf("  the demos' 32 bit pressure is within %.3f Pa\n", demo_err);
+}
+
+/** @fn static double now_ns(void)
+ * @brief returns the monotonic clock in ns
+ */
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** @fn static void time_formulas(const bmp280_calib_t *c)
+ * @brief times a sample's compensation with each formula
+ */
+static void time_formulas(const bmp280_calib_t *c)
+{
+	double start, ns_64, ns_32, ns_double;
+	unsigned int i, round;
+	int32_t t_fine;
+
+	collect(c);
+
+	start = now_ns();
+	for (round = 0; round < TIMING_ROUNDS; round++)
+		for (i = 0; i < reading_count; i++)
+			sink = (uint32_t) bmp280_compensate_temperature(c, readings[i].adc_T, &t_fine) +
+			       bmp280_compensate_pressure(c, readings[i].adc_P, t_fine);
+	ns_64 = (now_ns() - start) / (TIMING_ROUNDS * reading_count);
+
+	start = now_ns();
+	for (round = 0; round < TIMING_ROUNDS; round++)
+		for (i = 0; i < reading_count; i++)
+			sink = (uint32_t) bmp280_compensate_temperature(c, readings[i].adc_T, &t_fine) +
+			       bmp280_compensate_pressure32(c, readings[i].adc_P, t_fine);
+	ns_32 = (now_ns() - start) / (TIMING_ROUNDS * reading_count);
+
+	start = now_ns();
+	for (round = 0; round < TIMING_ROUNDS; round++)
+		for (i = 0; i < reading_count; i++)
+			dsink = temperature_double(c, readings[i].adc_T, &t_fine) +
+				pressure_double(c, readings[i].adc_P, t_fine);
+	ns_double = (now_ns() - start) / (TIMING_ROUNDS * reading_count);
+
+	printf("  per sample on this host: 64 bit %.1f ns, 32 bit %.1f ns, double %.1f ns (with an FPU)\n",
+	       ns_64, ns_32, ns_double);
+}
+
+int main(void)
+{
+	bmp280_calib_t c;
+
+	test_reference();
+
+	bmp280_parse_calib(&c, datasheet_raw);
+	test_sweep("datasheet", &c);
+	test_sweep("second", &second_calib);
+	time_formulas(&c);
+
+	return check_summary();
+}
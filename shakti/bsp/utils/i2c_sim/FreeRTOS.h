@@ -0,0 +1,34 @@
+/* Host stand-in for the parts of the FreeRTOS API that i2c_driver.c and
+ * bmp280.c use. The calls are implemented in i2c_sim.c, whose tasks are
+ * coroutines that switch only when one waits on its notification. */
+#ifndef I2C_SIM_FREERTOS_H
+#define I2C_SIM_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint64_t TickType_t;
+typedef long BaseType_t;
+typedef void *TaskHandle_t;
+typedef struct
+{
+	TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+#define pdFALSE			((BaseType_t) 0)
+#define pdTRUE			((BaseType_t) 1)
+#define portMAX_DELAY		((TickType_t) ~(TickType_t) 0)
+#define taskSCHEDULER_SUSPENDED	((BaseType_t) 0)
+#define taskSCHEDULER_NOT_STARTED	((BaseType_t) 1)
+#define taskSCHEDULER_RUNNING	((BaseType_t) 2)
+#define portYIELD_FROM_ISR(x)	((void) (x))
+#define pdMS_TO_TICKS(ms)	((TickType_t) (ms))	/* 1 kHz tick */
+
+BaseType_t xTaskGetSchedulerState(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken);
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+void vTaskSetTimeOutState(TimeOut_t *pxTimeOut);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *pxTimeOut, TickType_t *pxTicksToWait);
+
+#endif
@@ -0,0 +1,1363 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  i2c_sim.c
+* Brief Description of file             :  Host simulation of the i2c controller and a BMP280.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file i2c_sim.c
+@brief Host simulation of the i2c controller and a BMP280.
+@detail Runs bsp/drivers/i2c/i2c_driver.c against a model of its PCF8584
+style controller with a BMP280 on the bus, both through the polled calls
+the demos use and through the interrupt driven i2c_transfer.
+
+Time is counted in cycles of a 50 MHz core with a 100 kHz bus, so a byte
+and its ack take 4500 cycles. The core spends cycles on each register
+access, on each turn of waitfor()'s loop, on taking an interrupt and on a
+task blocking and being woken; the rest of the time it is free. Writing
+the data register, or reading it while receiving, puts a byte on the wire,
+and PIN falls when the byte is over. The interrupt is level triggered from
+PIN and ENI. The BMP280 acks its address, takes register and value pairs
+when written, and sends registers from the last one written when read. A
+soft reset clears its adc registers and sets im_update for a few status
+reads; writing a mode to ctrl_meas fills the adc registers at once, and a
+forced mode measurement then returns the sensor to sleep.
+Faults can be injected: address nacks, a bus error, a slave holding SDA
+low for a while or for good, and a controller that never finishes a byte.
+
+The tasks are coroutines that switch only when one waits on its
+notification. When all of them are waiting, time jumps to the end of the
+byte on the wire or to the next timeout.
+
+bsp/drivers/i2c/bmp280.c is run against the same BMP280, whose readings
+are the datasheet's example, so the sample must be 25.08 C and
+25767233 / 256 = 100653.25 Pa, where the floating point formulas give
+100653.27 Pa.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "sim_check.h"
+#include "i2c.h"
+#include "defines.h"
+#include "plic_driver.h"
+#include "utils.h"
+#include "FreeRTOS.h"
+#include "bmp280.h"
+
+#define BIT_CYCLES	500	/* 100 kHz scl from a 50 MHz core */
+#define BYTE_CYCLES	(9 * BIT_CYCLES)
+#define START_CYCLES	BIT_CYCLES
+#define STOP_CYCLES	BIT_CYCLES
+#define REG_CYCLES	10	/* a register access from the core */
+#define WAITFOR_CYCLES	3	/* a turn of waitfor()'s loop */
+#define ISR_CYCLES	150	/* trap entry and exit, plic claim and complete */
+#define SWITCH_CYCLES	400	/* a task blocking and being woken */
+#define TICK_CYCLES	50000	/* 1 ms */
+#define NEVER		UINT64_MAX
+
+#define BUS		1	/* the demos' bmp280 is on i2c_instance[1] */
+#define SLAVE		0xEC
+#define CALIB_REG	0x88
+#define CALIB_LEN	24
+#define VALUES_REG	0xF7
+#define MAX_TASKS	3
+#define STACK_SIZE	(256 * 1024)
+
+uint32_t i2c_sim_regs[MAX_I2C_COUNT * I2C_OFFSET / 4];
+
+typedef struct
+{
+	unsigned int prescale;
+	unsigned int scl;
+	unsigned int control;
+	unsigned int data;
+	int pin;
+	int lrb;
+	int ber;
+	int master;		/* the controller holds the bus */
+	int receiving;		/* master receiver after address+R */
+	int repstart;		/* the next data write follows a repeated start */
+	int busy;		/* a byte is on the wire */
+	int rx;			/* the byte on the wire is coming in */
+	int address_byte;	/* the byte on the wire is an address */
+	uint64_t done_at;
+	uint64_t free_at;	/* the bus is free from here after a STOP */
+	int hang;		/* bytes never end */
+	int ber_next;		/* the next byte ends in a bus error */
+	unsigned int resets;
+	unsigned int bad_accesses;
+} sim_i2c_t;
+
+enum { SL_IDLE, SL_ADDRESS, SL_POINTER, SL_DATA, SL_READ, SL_DONE, SL_IGNORE };
+
+typedef struct
+{
+	uint8_t regs[256];
+	int state;
+	uint8_t pointer;
+	unsigned int nack_address;	/* addresses still to nack */
+	unsigned int im_update;		/* status reads still to show im_update */
+	unsigned int measurements;
+	uint64_t stuck_until;		/* SDA is held low until then */
+	unsigned int resets;
+	unsigned int protocol_errors;
+} sim_bmp280_t;
+
+typedef struct
+{
+	ucontext_t ctx;
+	void (*fn)(void);
+	char *stack;
+	uint32_t notify;
+	int blocked;
+	int finished;
+	uint64_t wake_tick;
+} sim_task_t;
+
+typedef struct
+{
+	uint64_t now;
+	uint64_t cpu;
+} sim_mark_t;
+
+/* BMP280 datasheet's example trimming values, dig_T1 to dig_P9 */
+static const uint8_t calib[CALIB_LEN] =
+{
+	0x70, 0x6b, 0x43, 0x67, 0x18, 0xfc,
+	0x7d, 0x8e, 0x43, 0xd6, 0xd0, 0x0b, 0x27, 0x0b, 0x8c, 0x00,
+	0xf9, 0xff, 0x8c, 0x3c, 0xf8, 0xc6, 0x70, 0x17
+};
+/* adc_P 415148, adc_T 519888 */
+static const uint8_t values[6] = { 0x65, 0x5a, 0xc0, 0x7e, 0xed, 0x00 };
+/* 0x80000 in both, as after a reset */
+static const uint8_t no_values[6] = { 0x80, 0x00, 0x00, 0x80, 0x00, 0x00 };
+
+static sim_i2c_t ctrl[MAX_I2C_COUNT];
+static sim_bmp280_t slave;
+static uint64_t now;
+static uint64_t cpu_cycles;
+static uint32_t plic_enabled;
+static uintptr_t mstatus = MSTATUS_MIE;
+static int in_isr;
+static BaseType_t scheduler_state = taskSCHEDULER_NOT_STARTED;
+
+static sim_task_t tasks[MAX_TASKS];
+static int task_count;
+static int current = -1;
+static ucontext_t sched_ctx;
+
+static unsigned int isr_calls;
+static unsigned int waits;
+static unsigned int storms;
+static unsigned int kernel_misuse;
+
+/* Stand-ins for what i2c_driver.c uses from plic_driver.c and log.c. */
+plic_fptr_t isr_table[PLIC_MAX_INTERRUPT_SRC];
+void interrupt_enable(uint32_t interrupt_id) { plic_enabled |= 1u << interrupt_id; }
+
+void _printf_(const char *fmt, va_list ap)
+{
+	vprintf(fmt, ap);
+}
+
+static void cpu(uint64_t cycles);
+
+/** @fn static void slave_start(unsigned int n)
+ * @brief tells the slave on bus n about a START or a repeated start
+ */
+static void slave_start(unsigned int n)
+{
+	if (n == BUS)
+		slave.state = SL_ADDRESS;
+}
+
+/** @fn static void slave_stop(unsigned int n)
+ * @brief tells the slave on bus n about a STOP
+ */
+static void slave_stop(unsigned int n)
+{
+	if (n == BUS)
+		slave.state = SL_IDLE;
+}
+
+/** @fn static void slave_write_reg(uint8_t value)
+ * @brief writes the slave's register at its pointer
+ */
+static void slave_write_reg(uint8_t value)
+{
+	slave.regs[slave.pointer] = value;
+
+	if (slave.pointer == 0xE0 && value == 0xB6)
+	{
+		slave.regs[0xF4] = 0;
+		slave.regs[0xF5] = 0;
+		memcpy(slave.regs + VALUES_REG, no_values, sizeof(no_values));
+		slave.im_update = 2;
+		slave.resets++;
+	}
+
+	if (slave.pointer == 0xF4 && (value & 3))
+	{
+		memcpy(slave.regs + VALUES_REG, values, sizeof(values));
+		if ((value & 3) != 3)
+			slave.regs[0xF4] &= 0xFC;
+		slave.measurements++;
+	}
+}
+
+/** @fn static int slave_receive(unsigned int n, uint8_t byte, int address)
+ * @brief hands a byte to the slave on bus n
+ * @return nonzero if the slave acks it
+ */
+static int slave_receive(unsigned int n, uint8_t byte, int address)
+{
+	if (n != BUS)
+		return 0;
+
+	if (address)
+	{
+		if (slave.state != SL_ADDRESS)
+			slave.protocol_errors++;
+
+		if ((byte & 0xFE) != SLAVE || slave.nack_address)
+		{
+			if ((byte & 0xFE) == SLAVE)
+				slave.nack_address--;
+			slave.state = SL_IGNORE;
+			return 0;
+		}
+
+		slave.state = (byte & 1) ? SL_READ : SL_POINTER;
+		return 1;
+	}
+
+	switch (slave.state)
+	{
+	case SL_POINTER:
+		slave.pointer = byte;
+		slave.state = SL_DATA;
+		return 1;
+	case SL_DATA:
+		slave_write_reg(byte);
+		slave.state = SL_POINTER;
+		return 1;
+	case SL_IGNORE:
+		return 0;
+	default:
+		slave.protocol_errors++;
+		return 0;
+	}
+}
+
+/** @fn static uint8_t slave_send(unsigned int n)
+ * @brief takes a byte from the slave on bus n
+ */
+static uint8_t slave_send(unsigned int n)
+{
+	if (n != BUS || slave.state == SL_IGNORE)
+		return 0xFF;
+
+	if (slave.state != SL_READ)
+	{
+		slave.protocol_errors++;
+		return 0xFF;
+	}
+
+	if (slave.pointer == 0xF3 && slave.im_update)
+	{
+		slave.im_update--;
+		slave.pointer++;
+		return 0x01;
+	}
+
+	return slave.regs[slave.pointer++];
+}
+
+/** @fn static int bus_free(unsigned int n)
+ * @brief tells whether bus n is free, as BB reports it
+ */
+static int bus_free(unsigned int n)
+{
+	sim_i2c_t *c = &ctrl[n];
+
+	return !c->master && now >= c->free_at && (n != BUS || now >= slave.stuck_until);
+}
+
+/** @fn static int raised(unsigned int n)
+ * @brief tells whether controller n is raising its interrupt
+ */
+static int raised(unsigned int n)
+{
+	sim_i2c_t *c = &ctrl[n];
+
+	return (c->control & I2C_ENI) && (c->control & I2C_ESO) && !c->pin;
+}
+
+/** @fn static void begin_byte(sim_i2c_t *c, int rx, uint8_t byte, int address, uint64_t extra)
+ * @brief puts a byte on the wire
+ */
+static void begin_byte(sim_i2c_t *c, int rx, uint8_t byte, int address, uint64_t extra)
+{
+	if (!rx)
+		c->data = byte;
+	c->rx = rx;
+	c->address_byte = address;
+	c->busy = 1;
+	c->pin = 1;
+	c->done_at = c->hang ? NEVER : now + extra + BYTE_CYCLES;
+}
+
+/** @fn static void update(void)
+ * @brief ends the bytes whose time is up
+ */
+static void update(void)
+{
+	unsigned int n;
+
+	for (n = 0; n < MAX_I2C_COUNT; n++)
+	{
+		sim_i2c_t *c = &ctrl[n];
+
+		if (!c->busy || now < c->done_at)
+			continue;
+
+		c->busy = 0;
+		c->pin = 0;
+
+		if (c->ber_next)
+		{
+			c->ber_next = 0;
+			c->ber = 1;
+			continue;
+		}
+
+		if (c->rx)
+		{
+			c->data = slave_send(n);
+			if (!(c->control & I2C_ACK) && n == BUS && slave.state == SL_READ)
+				slave.state = SL_DONE;
+			c->lrb = 0;
+		}
+		else
+		{
+			int ack = slave_receive(n, (uint8_t) c->data, c->address_byte);
+
+			c->lrb = !ack;
+			if (c->address_byte && ack && (c->data & 1))
+				c->receiving = 1;
+		}
+	}
+}
+
+/** @fn static void take_interrupts(void)
+ * @brief runs the isr of every controller raising its interrupt, while MIE
+ *        is set
+ */
+static void take_interrupts(void)
+{
+	unsigned int n;
+
+	if (in_isr || !(mstatus & MSTATUS_MIE))
+		return;
+
+	for (n = 0; n < MAX_I2C_COUNT; n++)
+	{
+		uint32_t id = PLIC_INTERRUPT_23 + n;
+
+		if (!(plic_enabled & (1u << id)) || !raised(n))
+			continue;
+
+		in_isr = 1;
+		mstatus &= ~MSTATUS_MIE;
+		isr_calls++;
+		cpu(ISR_CYCLES);
+		isr_table[id](id);
+		mstatus |= MSTATUS_MIE;
+		in_isr = 0;
+
+		/* The interrupt is level triggered, so an isr that leaves it
+		   raised would be entered again straight away. */
+		if (raised(n))
+			storms++;
+	}
+}
+
+/** @fn static void cpu(uint64_t cycles)
+ * @brief lets the core spend cycles, taking interrupts when they are enabled
+ */
+static void cpu(uint64_t cycles)
+{
+	now += cycles;
+	cpu_cycles += cycles;
+	update();
+	take_interrupts();
+}
+
+void waitfor(unsigned int secs)
+{
+	cpu((uint64_t) secs * WAITFOR_CYCLES);
+}
+
+/** @fn static unsigned int index_of(const void *instance)
+ * @brief returns the number of the controller whose registers are at instance
+ */
+static unsigned int index_of(const void *instance)
+{
+	return (unsigned int) (((uintptr_t) instance - (uintptr_t) i2c_sim_regs) / I2C_OFFSET);
+}
+
+/** @fn static void write_control(unsigned int n, unsigned int val)
+ * @brief writes the control register of controller n
+ */
+static void write_control(unsigned int n, unsigned int val)
+{
+	sim_i2c_t *c = &ctrl[n];
+
+	c->control = val;
+
+	/* Turning the serial interface off resets the controller. */
+	if (!(val & I2C_ESO))
+	{
+		if (c->master)
+			slave_stop(n);
+		c->master = c->receiving = c->repstart = c->busy = 0;
+		c->pin = 1;
+		c->lrb = 0;
+		c->ber = 0;
+		c->resets++;
+		return;
+	}
+
+	if (val & I2C_PIN)
+		c->pin = 1;
+
+	if ((val & I2C_STA) && (val & I2C_STO))
+	{
+		c->bad_accesses++;
+		return;
+	}
+
+	if (val & I2C_STA)
+	{
+		if (val & I2C_PIN)
+		{
+			if (c->master || !bus_free(n))
+			{
+				c->bad_accesses++;
+				return;
+			}
+			c->master = 1;
+			c->receiving = 0;
+			slave_start(n);
+			begin_byte(c, 0, (uint8_t) c->data, 1, START_CYCLES);
+		}
+		else
+		{
+			if (!c->master || c->busy)
+			{
+				c->bad_accesses++;
+				return;
+			}
+			c->repstart = 1;
+			c->receiving = 0;
+		}
+	}
+	else if ((val & I2C_STO) && c->master)
+	{
+		c->busy = 0;
+		c->master = c->receiving = c->repstart = 0;
+		slave_stop(n);
+		c->free_at = now + STOP_CYCLES;
+	}
+}
+
+unsigned int i2c_sim_read(const void *instance, size_t offset)
+{
+	unsigned int n = index_of(instance);
+	sim_i2c_t *c = &ctrl[n];
+	unsigned int val;
+
+	cpu(REG_CYCLES);
+
+	switch (offset)
+	{
+	case offsetof(i2c_struct, prescale):
+		return c->prescale;
+	case offsetof(i2c_struct, control):
+		return c->control;
+	case offsetof(i2c_struct, scl):
+		return c->scl;
+	case offsetof(i2c_struct, status):
+		return (c->pin ? I2C_PIN : 0) | (c->ber ? I2C_BER : 0) |
+		       (c->lrb ? I2C_LRB : 0) | (bus_free(n) ? I2C_BB : 0);
+	case offsetof(i2c_struct, data):
+		val = c->data;
+		/* Reading the data register of a master receiver clocks in
+		   the next byte. */
+		if (c->master && c->receiving)
+		{
+			if (c->busy)
+				c->bad_accesses++;
+			else
+				begin_byte(c, 1, 0, 0, 0);
+		}
+		return val;
+	default:
+		c->bad_accesses++;
+		return 0;
+	}
+}
+
+void i2c_sim_write(const void *instance, size_t offset, unsigned int val)
+{
+	unsigned int n = index_of(instance);
+	sim_i2c_t *c = &ctrl[n];
+
+	cpu(REG_CYCLES);
+
+	switch (offset)
+	{
+	case offsetof(i2c_struct, prescale):
+		c->prescale = val;
+		break;
+	case offsetof(i2c_struct, scl):
+		c->scl = val;
+		break;
+	case offsetof(i2c_struct, control):
+		write_control(n, val);
+		break;
+	case offsetof(i2c_struct, data):
+		if (!c->master)
+		{
+			c->data = val & 0xFF;
+			break;
+		}
+		if (c->busy || (c->receiving && !c->repstart))
+		{
+			c->bad_accesses++;
+			break;
+		}
+		if (c->repstart)
+		{
+			c->repstart = 0;
+			slave_start(n);
+			begin_byte(c, 0, (uint8_t) val, 1, START_CYCLES);
+		}
+		else
+			begin_byte(c, 0, (uint8_t) val, 0, 0);
+		break;
+	default:
+		c->bad_accesses++;
+		break;
+	}
+}
+
+uintptr_t sim_csr_read(int csr)
+{
+	(void) csr;
+	return mstatus;
+}
+
+void sim_csr_set(int csr, uintptr_t bits)
+{
+	int enabling = (bits & MSTATUS_MIE) && !(mstatus & MSTATUS_MIE);
+
+	(void) csr;
+	mstatus |= bits;
+
+	/* An interrupt that became pending while they were disabled is taken
+	   as soon as they are enabled again. */
+	if (enabling)
+		take_interrupts();
+}
+
+void sim_csr_clear(int csr, uintptr_t bits)
+{
+	(void) csr;
+	mstatus &= ~bits;
+}
+
+/** @fn static uint64_t ticks(void)
+ * @brief returns the kernel's tick count
+ */
+static uint64_t ticks(void)
+{
+	return now / TICK_CYCLES;
+}
+
+/** @fn static void kernel_call(void)
+ * @brief checks that a task level kernel call is made from a task with
+ *        interrupts enabled, as its critical section would enable them
+ */
+static void kernel_call(void)
+{
+	if (in_isr || current < 0 || !(mstatus & MSTATUS_MIE))
+		kernel_misuse++;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+	return scheduler_state;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return current < 0 ? NULL : (TaskHandle_t) &tasks[current];
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+	sim_task_t *t;
+	uint32_t count;
+
+	kernel_call();
+	if (current < 0)
+		return 0;
+
+	t = &tasks[current];
+	if (t->notify == 0 && xTicksToWait != 0)
+	{
+		waits++;
+		t->blocked = 1;
+		t->wake_tick = (xTicksToWait == portMAX_DELAY) ? NEVER : ticks() + xTicksToWait;
+		cpu(SWITCH_CYCLES);
+		swapcontext(&t->ctx, &sched_ctx);
+	}
+
+	count = t->notify;
+	t->notify = (xClearCountOnExit || count == 0) ? 0 : count - 1;
+
+	return count;
+}
+
+/** @fn static void notify(TaskHandle_t task)
+ * @brief gives a task's notification
+ */
+static void notify(TaskHandle_t task)
+{
+	sim_task_t *t = (sim_task_t *) task;
+
+	if (t < tasks || t >= tasks + task_count)
+	{
+		kernel_misuse++;
+		return;
+	}
+
+	t->notify++;
+	t->blocked = 0;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	if (!in_isr)
+		kernel_misuse++;
+
+	notify(xTaskToNotify);
+	*pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+	kernel_call();
+	notify(xTaskToNotify);
+
+	return pdTRUE;
+}
+
+void vTaskSetTimeOutState(TimeOut_t *pxTimeOut)
+{
+	pxTimeOut->xTimeOnEntering = ticks();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *pxTimeOut, TickType_t *pxTicksToWait)
+{
+	TickType_t elapsed = ticks() - pxTimeOut->xTimeOnEntering;
+
+	kernel_call();
+
+	if (*pxTicksToWait == portMAX_DELAY)
+		return pdFALSE;
+
+	if (elapsed < *pxTicksToWait)
+	{
+		*pxTicksToWait -= elapsed;
+		pxTimeOut->xTimeOnEntering = ticks();
+		return pdFALSE;
+	}
+
+	*pxTicksToWait = 0;
+	return pdTRUE;
+}
+
+/** @fn static void task_entry(void)
+ * @brief runs the current task's function
+ */
+static void task_entry(void)
+{
+	tasks[current].fn();
+	tasks[current].finished = 1;
+}
+
+/** @fn static void add_task(void (*fn)(void))
+ * @brief creates a task for run_tasks
+ */
+static void add_task(void (*fn)(void))
+{
+	sim_task_t *t = &tasks[task_count++];
+
+	memset(t, 0, sizeof(*t));
+	t->fn = fn;
+	t->stack = malloc(STACK_SIZE);
+	getcontext(&t->ctx);
+	t->ctx.uc_stack.ss_sp = t->stack;
+	t->ctx.uc_stack.ss_size = STACK_SIZE;
+	t->ctx.uc_link = &sched_ctx;
+	makecontext(&t->ctx, task_entry, 0);
+}
+
+/** @fn static int idle(void)
+ * @brief lets time pass while every task waits
+ * @return zero if nothing would ever wake a task
+ */
+static int idle(void)
+{
+	uint64_t next = NEVER;
+	unsigned int n;
+	int i;
+
+	for (n = 0; n < MAX_I2C_COUNT; n++)
+	{
+		if (ctrl[n].busy && ctrl[n].done_at < next)
+			next = ctrl[n].done_at;
+	}
+
+	for (i = 0; i < task_count; i++)
+	{
+		if (!tasks[i].finished && tasks[i].wake_tick != NEVER &&
+		    tasks[i].wake_tick * TICK_CYCLES < next)
+			next = tasks[i].wake_tick * TICK_CYCLES;
+	}
+
+	if (next == NEVER)
+		return 0;
+
+	if (next > now)
+		now = next;
+
+	update();
+	take_interrupts();
+
+	for (i = 0; i < task_count; i++)
+	{
+		if (tasks[i].blocked && tasks[i].wake_tick != NEVER && ticks() >= tasks[i].wake_tick)
+			tasks[i].blocked = 0;
+	}
+
+	return 1;
+}
+
+/** @fn static void run_tasks(void)
+ * @brief runs the tasks added until they have all returned
+ */
+static void run_tasks(void)
+{
+	int last = -1;
+	int i;
+
+	scheduler_state = taskSCHEDULER_RUNNING;
+
+	for (;;)
+	{
+		int next = -1;
+		int left = 0;
+
+		for (i = 1; i <= task_count; i++)
+		{
+			int k = (last + i) % task_count;
+
+			if (tasks[k].finished)
+				continue;
+			left++;
+			if (!tasks[k].blocked && next < 0)
+				next = k;
+		}
+
+		if (left == 0)
+			break;
+
+		if (next >= 0)
+		{
+			current = last = next;
+			swapcontext(&sched_ctx, &tasks[next].ctx);
+			current = -1;
+			continue;
+		}
+
+		if (!idle())
+		{
+			printf("every task waits for ever\n");
+			exit(1);
+		}
+	}
+
+	for (i = 0; i < task_count; i++)
+		free(tasks[i].stack);
+	task_count = 0;
+	scheduler_state = taskSCHEDULER_NOT_STARTED;
+}
+
+/** @fn static void check_misuse(void)
+ * @brief checks that nothing was done that the controller, the slave or
+ *        the kernel would not allow
+ */
+static void check_misuse(void)
+{
+	unsigned int bad = 0;
+	unsigned int n;
+
+	for (n = 0; n < MAX_I2C_COUNT; n++)
+	{
+		bad += ctrl[n].bad_accesses;
+		ctrl[n].bad_accesses = 0;
+	}
+
+	check(bad == 0 && slave.protocol_errors == 0 && storms == 0 && kernel_misuse == 0,
+	      "no misuse (controller %u, slave %u, storms %u, kernel %u)",
+	      bad, slave.protocol_errors, storms, kernel_misuse);
+	slave.protocol_errors = storms = kernel_misuse = 0;
+}
+
+/** @fn static void mark(sim_mark_t *m)
+ * @brief notes the time and the core's cycles
+ */
+static void mark(sim_mark_t *m)
+{
+	m->now = now;
+	m->cpu = cpu_cycles;
+}
+
+/** @fn static void xfer_init(i2c_xfer_t *xfer, unsigned char reg, unsigned char *buf, unsigned int len)
+ * @brief sets up a register read of the bmp280
+ */
+static void xfer_init(i2c_xfer_t *xfer, unsigned char reg, unsigned char *buf, unsigned int len)
+{
+	memset(xfer, 0, sizeof(*xfer));
+	xfer->slave_address = SLAVE;
+	xfer->reg = reg;
+	xfer->read_data = buf;
+	xfer->read_len = len;
+}
+
+/** @fn static i2c_async_stats_t stats(void)
+ * @brief returns the counters of the bmp280's controller
+ */
+static i2c_async_stats_t stats(void)
+{
+	i2c_async_stats_t s;
+
+	i2c_get_async_stats(i2c_instance[BUS], &s);
+	return s;
+}
+
+/** @fn static short demo_read16(i2c_struct *instance, unsigned char reg)
+ * @brief read_bmp280_values16 from the demos' main.c, with their delay
+ */
+static short demo_read16(i2c_struct *instance, unsigned char reg)
+{
+	unsigned char read_buf[2] = { 0 };
+	unsigned char temp = 0;
+
+	i2c_send_slave_address(instance, SLAVE, I2C_WRITE, 800);
+	i2c_write_data(instance, reg, 100);
+	i2c_set_reg(instance, control, I2C_STOP);
+
+	i2c_send_slave_address(instance, SLAVE, I2C_READ, 800);
+	i2c_read_data(instance, &temp, 100);
+	i2c_read_data(instance, &read_buf[0], 100);
+	i2c_set_reg(instance, control, I2C_NACK);
+	i2c_read_data(instance, &read_buf[1], 100);
+	i2c_set_reg(instance, control, I2C_STOP);
+
+	return (short) ((read_buf[1] << 8) | read_buf[0]);
+}
+
+/** @fn static void reset(void)
+ * @brief puts the controllers, the bmp280 and the hart back to their start
+ */
+static void reset(void)
+{
+	memset(ctrl, 0, sizeof(ctrl));
+	memset(&slave, 0, sizeof(slave));
+	memcpy(slave.regs + CALIB_REG, calib, CALIB_LEN);
+	memcpy(slave.regs + VALUES_REG, values, sizeof(values));
+	slave.regs[0xD0] = 0x58;
+	memset(isr_table, 0, sizeof(isr_table));
+	plic_enabled = 0;
+	mstatus = MSTATUS_MIE;
+	now = cpu_cycles = 0;
+	i2c_init();
+}
+
+static uint64_t polled_cycles;
+
+/** @fn static void test_polled(void)
+ * @brief reads the calibration as the demos do, to compare against
+ */
+static void test_polled(void)
+{
+	sim_mark_t m;
+	uint8_t buf[CALIB_LEN];
+	int i;
+
+	check(config_i2c(i2c_instance[BUS], 0x1F, 0x91) == 0, "config_i2c finds the controller idle");
+
+	mark(&m);
+	for (i = 0; i < CALIB_LEN; i += 2)
+	{
+		short v = demo_read16(i2c_instance[BUS], (unsigned char) (CALIB_REG + i));
+
+		buf[i] = (uint8_t) v;
+		buf[i + 1] = (uint8_t) (v >> 8);
+	}
+	polled_cycles = cpu_cycles - m.cpu;
+
+	check(memcmp(buf, calib, CALIB_LEN) == 0,
+	      "the demos' 12 polled 16 bit reads return the calibration");
+	printf("  polled: %llu cycles (%llu us), all of them busy\n",
+	       (unsigned long long) polled_cycles, (unsigned long long) (polled_cycles / 50));
+	check_misuse();
+}
+
+static sim_mark_t task_mark;
+static uint64_t task_busy;
+static uint64_t task_elapsed;
+static int task_result;
+static uint8_t task_buf[CALIB_LEN];
+
+/** @fn static void task_calibration(void)
+ * @brief reads the calibration in one transaction
+ */
+static void task_calibration(void)
+{
+	i2c_xfer_t xfer;
+
+	xfer_init(&xfer, CALIB_REG, task_buf, CALIB_LEN);
+	mark(&task_mark);
+	task_result = i2c_transfer(i2c_instance[BUS], &xfer, 100);
+	task_busy = cpu_cycles - task_mark.cpu;
+	task_elapsed = now - task_mark.now;
+}
+
+/** @fn static void task_calibration16(void)
+ * @brief reads the calibration in 12 two byte transactions
+ */
+static void task_calibration16(void)
+{
+	i2c_xfer_t xfer;
+	int i;
+
+	mark(&task_mark);
+	task_result = 0;
+	for (i = 0; i < CALIB_LEN; i += 2)
+	{
+		xfer_init(&xfer, (unsigned char) (CALIB_REG + i), task_buf + i, 2);
+		task_result |= i2c_transfer(i2c_instance[BUS], &xfer, 100);
+	}
+	task_busy = cpu_cycles - task_mark.cpu;
+	task_elapsed = now - task_mark.now;
+}
+
+/** @fn static void test_calibration(void)
+ * @brief measures the core's time spent on an interrupt driven calibration read
+ */
+static void test_calibration(void)
+{
+	i2c_async_stats_t before;
+	i2c_async_stats_t after;
+	unsigned int irqs = isr_calls;
+
+	check(i2c_enable_async(i2c_instance[BUS]) == 0, "i2c_enable_async takes the controller");
+
+	memset(task_buf, 0, sizeof(task_buf));
+	before = stats();
+	add_task(task_calibration);
+	run_tasks();
+	after = stats();
+
+	check(task_result == I2C_SUCCESS && memcmp(task_buf, calib, CALIB_LEN) == 0,
+	      "a 24 byte i2c_transfer returns the calibration");
+	check(after.interrupts - before.interrupts == 3 + CALIB_LEN && isr_calls - irqs == 3 + CALIB_LEN &&
+	      after.bytes - before.bytes == 1 + CALIB_LEN && after.transfers - before.transfers == 1,
+	      "with one interrupt per byte on the wire (%u)", after.interrupts - before.interrupts);
+	printf("  interrupt driven: %llu cycles (%llu us), %llu busy, %llu free (%llu%%)\n",
+	       (unsigned long long) task_elapsed, (unsigned long long) (task_elapsed / 50),
+	       (unsigned long long) task_busy, (unsigned long long) (task_elapsed - task_busy),
+	       (unsigned long long) ((task_elapsed - task_busy) * 100 / task_elapsed));
+	check(task_busy * 10 < task_elapsed, "the core is free for over 90%% of the transaction");
+	check(task_busy * 100 < polled_cycles,
+	      "and busy for under 1%% of the polled read's cycles (%llu against %llu)",
+	      (unsigned long long) task_busy, (unsigned long long) polled_cycles);
+
+	memset(task_buf, 0, sizeof(task_buf));
+	add_task(task_calibration16);
+	run_tasks();
+	check(task_result == I2C_SUCCESS && memcmp(task_buf, calib, CALIB_LEN) == 0,
+	      "12 two byte transactions return the calibration");
+	printf("  12 transactions: %llu cycles (%llu us), %llu busy\n",
+	       (unsigned long long) task_elapsed, (unsigned long long) (task_elapsed / 50),
+	       (unsigned long long) task_busy);
+	check_misuse();
+}
+
+/** @fn static void task_registers(void)
+ * @brief writes and reads single registers and reads the adc values
+ */
+static void task_registers(void)
+{
+	static const unsigned char ctrl_meas[1] = { 0x27 };
+	unsigned char id = 0;
+	unsigned char buf[6] = { 0 };
+	i2c_xfer_t xfer;
+
+	memset(&xfer, 0, sizeof(xfer));
+	xfer.slave_address = SLAVE;
+	xfer.reg = 0xF4;
+	xfer.write_data = ctrl_meas;
+	xfer.write_len = 1;
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS && slave.regs[0xF4] == 0x27,
+	      "a write transaction sets ctrl_meas");
+
+	xfer_init(&xfer, 0xD0, &id, 1);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS && id == 0x58,
+	      "a one byte read returns the chip id");
+
+	xfer_init(&xfer, VALUES_REG, buf, sizeof(buf));
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS &&
+	      memcmp(buf, values, sizeof(values)) == 0, "a six byte read returns the adc values");
+}
+
+/** @fn static void task_faults(void)
+ * @brief runs transactions into nacks, a bus error and a stuck bus
+ */
+static void task_faults(void)
+{
+	i2c_async_stats_t s = stats();
+	unsigned char buf[CALIB_LEN];
+	i2c_xfer_t xfer;
+	int result;
+
+	slave.nack_address = 1;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == EREMOTEIO && stats().nacks == s.nacks + 1,
+	      "an address nack ends the transaction with EREMOTEIO");
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS && memcmp(buf, calib, CALIB_LEN) == 0,
+	      "and the next one goes through");
+
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	xfer.slave_address = 0xEE;
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == EREMOTEIO,
+	      "a missing slave ends the transaction with EREMOTEIO");
+
+	s = stats();
+	ctrl[BUS].ber_next = 1;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	result = i2c_transfer(i2c_instance[BUS], &xfer, 100);
+	check(result == EI2C_BUS_ERROR && stats().recoveries == s.recoveries + 1,
+	      "a bus error resets the controller and ends the transaction (%d)", result);
+
+	s = stats();
+	slave.stuck_until = now + 5 * TICK_CYCLES;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS && stats().recoveries == s.recoveries &&
+	      memcmp(buf, calib, CALIB_LEN) == 0, "a bus held for 5 ms is waited for");
+
+	s = stats();
+	slave.stuck_until = now + 30 * TICK_CYCLES;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS && stats().recoveries == s.recoveries + 1,
+	      "a bus held for 30 ms is reset and then waited for");
+
+	s = stats();
+	slave.stuck_until = NEVER;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	result = i2c_transfer(i2c_instance[BUS], &xfer, 100);
+	check(result == EI2C_BUS_ERROR && stats().bus_errors == s.bus_errors + 1,
+	      "a bus held for good fails with EI2C_BUS_ERROR (%d)", result);
+	slave.stuck_until = 0;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS, "and works once it is let go");
+
+	s = stats();
+	ctrl[BUS].hang = 1;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	result = i2c_transfer(i2c_instance[BUS], &xfer, 5);
+	check(result == ETIMEDOUT && stats().timeouts == s.timeouts + 1 &&
+	      stats().recoveries == s.recoveries + 1 && ticks() >= 5,
+	      "a byte that never ends times the transaction out and resets the controller (%d)", result);
+	ctrl[BUS].hang = 0;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS && memcmp(buf, calib, CALIB_LEN) == 0,
+	      "after which transactions go through again");
+}
+
+/** @fn static void test_single_task(void)
+ * @brief runs register and fault transactions from one task
+ */
+static void test_single_task(void)
+{
+	add_task(task_registers);
+	run_tasks();
+	check_misuse();
+
+	add_task(task_faults);
+	run_tasks();
+	check_misuse();
+}
+
+static int order[MAX_TASKS];
+static int finished;
+static int results[MAX_TASKS];
+static uint8_t buf_a[CALIB_LEN];
+static uint8_t buf_b[6];
+static uint8_t buf_c[2];
+
+/** @fn static void task_a(void)
+ * @brief reads the calibration while task_b and task_c queue behind it
+ */
+static void task_a(void)
+{
+	i2c_xfer_t xfer;
+
+	xfer_init(&xfer, CALIB_REG, buf_a, CALIB_LEN);
+	results[0] = i2c_transfer(i2c_instance[BUS], &xfer, I2C_WAIT_FOREVER);
+	order[finished++] = 0;
+}
+
+/** @fn static void task_b(void)
+ * @brief reads the adc values from behind task_a
+ */
+static void task_b(void)
+{
+	i2c_xfer_t xfer;
+
+	xfer_init(&xfer, VALUES_REG, buf_b, sizeof(buf_b));
+	results[1] = i2c_transfer(i2c_instance[BUS], &xfer, 100);
+	order[finished++] = 1;
+}
+
+/** @fn static void task_c(void)
+ * @brief gives up on a read queued behind task_a and task_b
+ */
+static void task_c(void)
+{
+	i2c_xfer_t xfer;
+
+	xfer_init(&xfer, CALIB_REG, buf_c, sizeof(buf_c));
+	results[2] = i2c_transfer(i2c_instance[BUS], &xfer, 1);
+	order[finished++] = 2;
+}
+
+/** @fn static void task_polling(void)
+ * @brief tries a transaction with interrupts disabled while task_a's runs
+ */
+static void task_polling(void)
+{
+	i2c_xfer_t xfer;
+
+	xfer_init(&xfer, VALUES_REG, buf_b, sizeof(buf_b));
+	clear_csr(mstatus, MSTATUS_MIE);
+	results[1] = i2c_transfer(i2c_instance[BUS], &xfer, 100);
+	set_csr(mstatus, MSTATUS_MIE);
+}
+
+/** @fn static void test_tasks(void)
+ * @brief queues transactions from several tasks
+ */
+static void test_tasks(void)
+{
+	i2c_async_stats_t s = stats();
+
+	memset(buf_a, 0, sizeof(buf_a));
+	memset(buf_b, 0, sizeof(buf_b));
+	finished = 0;
+	add_task(task_a);
+	add_task(task_b);
+	add_task(task_c);
+	run_tasks();
+
+	check(results[0] == I2C_SUCCESS && memcmp(buf_a, calib, CALIB_LEN) == 0 &&
+	      results[1] == I2C_SUCCESS && memcmp(buf_b, values, sizeof(values)) == 0,
+	      "two tasks' transactions run one after the other");
+	check(results[2] == ETIMEDOUT && order[0] == 2 && order[1] == 0 && order[2] == 1,
+	      "a third one times out while queued");
+	check(stats().recoveries == s.recoveries && stats().timeouts == s.timeouts + 1 &&
+	      stats().transfers == s.transfers + 3, "without touching the running transaction");
+	check_misuse();
+
+	finished = 0;
+	add_task(task_a);
+	add_task(task_polling);
+	run_tasks();
+	check(results[0] == I2C_SUCCESS && results[1] == EI2C_BUSY,
+	      "a caller that cannot block is turned away while a transaction is queued");
+	check_misuse();
+}
+
+static bmp280_t sensor;
+
+/** @fn static void task_bmp280(void)
+ * @brief runs the bmp280 driver in forced and normal mode
+ */
+static void task_bmp280(void)
+{
+	bmp280_config_t config = { BMP280_MODE_FORCED, BMP280_OSRS_X1, BMP280_OSRS_X1,
+				   BMP280_FILTER_OFF, BMP280_STANDBY_0_5_MS, 0 };
+	i2c_async_stats_t s = stats();
+	bmp280_sample_t sample = { 0 };
+	unsigned int resets = slave.resets;
+	unsigned int measurements;
+	sim_mark_t m;
+	int result;
+
+	config.osrs_p = BMP280_OSRS_SKIP;
+	check(bmp280_init(&sensor, i2c_instance[BUS], &config) == EBMP280_CONFIG &&
+	      stats().transfers == s.transfers, "bmp280_init refuses a skipped pressure measurement");
+	config.osrs_p = BMP280_OSRS_X1;
+
+	s = stats();
+	result = bmp280_init(&sensor, i2c_instance[BUS], &config);
+	check(result == BMP280_SUCCESS && slave.resets == resets + 1 && slave.im_update == 0 &&
+	      stats().transfers == s.transfers + 8,
+	      "bmp280_init resets the sensor and waits out im_update (%d, %u transactions)",
+	      result, stats().transfers - s.transfers);
+	check(sensor.calib.dig_T1 == 27504 && sensor.calib.dig_T2 == 26435 && sensor.calib.dig_T3 == -1000 &&
+	      sensor.calib.dig_P1 == 36477 && sensor.calib.dig_P2 == -10685 && sensor.calib.dig_P3 == 3024 &&
+	      sensor.calib.dig_P4 == 2855 && sensor.calib.dig_P5 == 140 && sensor.calib.dig_P6 == -7 &&
+	      sensor.calib.dig_P7 == 15500 && sensor.calib.dig_P8 == -14600 && sensor.calib.dig_P9 == 6000,
+	      "and decodes the calibration");
+	check(slave.regs[0xF4] == 0x24 && slave.regs[0xF5] == 0x00,
+	      "and leaves the sensor asleep with x1 oversampling (0x%02x)", slave.regs[0xF4]);
+	check(bmp280_measure_time_us(&config) == 6425, "a x1 measurement takes up to 6.4 ms");
+
+	check(bmp280_read_sample(&sensor, &sample) == EBMP280_NO_DATA && sensor.stats.not_ready == 1,
+	      "a sample read before a measurement finds no data");
+
+	measurements = slave.measurements;
+	check(bmp280_start_measurement(&sensor) == BMP280_SUCCESS && slave.measurements == measurements + 1 &&
+	      slave.regs[0xF4] == 0x24, "bmp280_start_measurement forces one measurement");
+
+	s = stats();
+	mark(&m);
+	result = bmp280_read_sample(&sensor, &sample);
+	check(result == BMP280_SUCCESS && stats().transfers == s.transfers + 1 &&
+	      stats().bytes == s.bytes + 1 + BMP280_DATA_LEN,
+	      "a sample is read in one 6 byte transaction (%d)", result);
+	check(sample.temperature == 2508 && sample.pressure == 25767233,
+	      "and compensates to 25.08 C and 100653.25 Pa (%d, %u/256)",
+	      sample.temperature, sample.pressure);
+	printf("  sample: %llu cycles (%llu us), %llu busy\n",
+	       (unsigned long long) (now - m.now), (unsigned long long) ((now - m.now) / 50),
+	       (unsigned long long) (cpu_cycles - m.cpu));
+
+	config.mode = BMP280_MODE_NORMAL;
+	config.osrs_t = BMP280_OSRS_X2;
+	config.osrs_p = BMP280_OSRS_X16;
+	config.filter = BMP280_FILTER_16;
+	config.standby = BMP280_STANDBY_62_5_MS;
+	result = bmp280_init(&sensor, i2c_instance[BUS], &config);
+	check(result == BMP280_SUCCESS && slave.regs[0xF4] == 0x57 && slave.regs[0xF5] == 0x30,
+	      "in normal mode the sensor is left measuring (0x%02x, 0x%02x)",
+	      slave.regs[0xF4], slave.regs[0xF5]);
+	check(bmp280_measure_time_us(&config) == 43225, "a x2, x16 measurement takes up to 43.2 ms");
+	s = stats();
+	check(bmp280_start_measurement(&sensor) == BMP280_SUCCESS && stats().transfers == s.transfers &&
+	      bmp280_read_sample(&sensor, &sample) == BMP280_SUCCESS && sample.temperature == 2508,
+	      "and samples are read without starting a measurement");
+
+	slave.regs[0xD0] = 0x60;
+	check(bmp280_init(&sensor, i2c_instance[BUS], &config) == EBMP280_NO_DEVICE,
+	      "a chip id other than 0x58 is refused");
+	slave.regs[0xD0] = 0x58;
+
+	slave.nack_address = 1;
+	check(bmp280_init(&sensor, i2c_instance[BUS], &config) == EREMOTEIO,
+	      "an i2c error is passed on");
+
+	check(bmp280_init(&sensor, i2c_instance[BUS], &config) == BMP280_SUCCESS, "after which it works");
+	slave.nack_address = 1;
+	check(bmp280_read_sample(&sensor, &sample) == EREMOTEIO && sensor.stats.errors == 1 &&
+	      sensor.stats.samples == 0, "and a failed sample read is counted");
+}
+
+/** @fn static void test_bmp280(void)
+ * @brief runs the bmp280 driver from a task
+ */
+static void test_bmp280(void)
+{
+	add_task(task_bmp280);
+	run_tasks();
+	check_misuse();
+}
+
+/** @fn static void test_no_scheduler(void)
+ * @brief runs transactions before the scheduler starts
+ */
+static void test_no_scheduler(void)
+{
+	i2c_async_stats_t s = stats();
+	unsigned int irqs = isr_calls;
+	uint8_t buf[CALIB_LEN] = { 0 };
+	i2c_xfer_t xfer;
+
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == I2C_SUCCESS &&
+	      memcmp(buf, calib, CALIB_LEN) == 0 && stats().polled == s.polled + 1 && isr_calls == irqs,
+	      "without a scheduler the transaction is carried out by polling");
+
+	ctrl[BUS].hang = 1;
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[BUS], &xfer, 100) == ETIMEDOUT && stats().timeouts == s.timeouts + 1,
+	      "and times out after I2C_POLL_LIMIT reads of PIN");
+	ctrl[BUS].hang = 0;
+
+	xfer_init(&xfer, CALIB_REG, buf, CALIB_LEN);
+	check(i2c_transfer(i2c_instance[0], &xfer, 100) == ENXIO,
+	      "a controller that is not asynchronous is refused");
+	check_misuse();
+}
+
+int main(void)
+{
+	reset();
+
+	test_polled();
+	test_calibration();
+	test_single_task();
+	test_tasks();
+	test_bmp280();
+	test_no_scheduler();
+
+	return check_summary();
+}
@@ -0,0 +1,27 @@
+/* Host stand-in for the SoC platform.h. It takes the vajra memory map and
+ * moves the i2c controllers' registers and mstatus into i2c_sim.c. */
+#ifndef I2C_SIM_PLATFORM_H
+#define I2C_SIM_PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../third_party/vajra/platform.h"
+
+extern uint32_t i2c_sim_regs[];
+#undef I2C0_BASE
+#define I2C0_BASE ((uintptr_t) i2c_sim_regs)
+
+unsigned int i2c_sim_read(const void *instance, size_t offset);
+void i2c_sim_write(const void *instance, size_t offset, unsigned int val);
+#define i2c_get_reg(instance, reg)	i2c_sim_read(instance, offsetof(i2c_struct, reg))
+#define i2c_set_reg(instance, reg, val)	i2c_sim_write(instance, offsetof(i2c_struct, reg), (unsigned int) (val))
+
+enum { SIM_CSR_mstatus };
+uintptr_t sim_csr_read(int csr);
+void sim_csr_set(int csr, uintptr_t bits);
+void sim_csr_clear(int csr, uintptr_t bits);
+#define read_csr(reg)		sim_csr_read(SIM_CSR_##reg)
+#define set_csr(reg, bit)	sim_csr_set(SIM_CSR_##reg, (uintptr_t) (bit))
+#define clear_csr(reg, bit)	sim_csr_clear(SIM_CSR_##reg, (uintptr_t) (bit))
+
+#endif
@@ -0,0 +1,3 @@
+/* malloc_firstfit.c calls m_sbrk() without a declaration, which on a 64-bit
+ * host would truncate the pointer it returns. */
+char *m_sbrk();
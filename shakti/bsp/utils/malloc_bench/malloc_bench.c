@@ -0,0 +1,573 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  malloc_bench.c
+* Brief Description of file             :  Compares the first-fit and segregated-fit mallocs.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file malloc_bench.c
+@brief Compares the first-fit and segregated-fit mallocs.
+@detail A host program that replays the same allocation traces against
+bsp/libs/malloc_firstfit.c and bsp/libs/malloc_segfit.c, both built unchanged
+for the host with m_sbrk() serving a fixed arena. For each trace it prints how
+many free blocks the allocations examined, how many allocations failed, and
+the fragmentation of the free space, which is one minus the largest free block
+over all the free bytes. Each allocator runs in a child process so that all
+of them start from an empty heap.
+
+The first fit in bsp/libs damages its list when it splits a block, so its
+row only reports where that happened. The firstfit* row is the same code
+with firstfit_split.patch applied, which mends the split and nothing else,
+and is the baseline segfit is measured against.
+
+First-fit counts a step for each block its search loop passes over and one
+for the block it takes. The bench walks the list itself before each call to
+count them, in the order the loop does. It keeps a single list of every
+block, so the list is also walked after every call to check that it still
+lies inside the arena. A run stops at the first operation that finds the
+list or an allocation's contents damaged. Trace files hold one operation per
+line, either "m <slot> <size>" or "f <slot>".
+*/
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "malloc_segfit.h"
+
+#define ARENA_SIZE	BENCH_ARENA
+#define GUARD_SIZE	(64 * 1024)
+#define MAX_SLOTS	4096
+#define MAX_OPS		200000
+
+void *firstfit_malloc(size_t size);
+void firstfit_free(void *ptr);
+void *firstfit_fixed_malloc(size_t size);
+void firstfit_fixed_free(void *ptr);
+char *m_sbrk(int nbytes);
+void log_trace(const char *fmt, ...);
+void log_info(const char *fmt, ...);
+void log_debug(const char *fmt, ...);
+void log_warn(const char *fmt, ...);
+void log_error(const char *fmt, ...);
+void log_fatal(const char *fmt, ...);
+
+/* The first-fit block header, as declared in malloc_firstfit.c. */
+struct Header
+{
+	size_t size;
+	int free;
+	struct Header* next;
+};
+extern struct Header *global_base;
+extern struct Header *firstfit_fixed_base;
+
+enum allocator
+{
+	FIRSTFIT,
+	FIRSTFIT_FIXED,
+	SEGFIT,
+	ALLOCATORS
+};
+
+static const char *const allocator_names[ALLOCATORS] = { "firstfit", "firstfit*", "segfit" };
+
+struct op
+{
+	char kind;
+	unsigned int slot;
+	size_t size;
+};
+
+struct result
+{
+	unsigned long mallocs;
+	unsigned long failures;
+	unsigned long steps;
+	unsigned long max_steps;
+	double frag_sum;
+	unsigned long frag_samples;
+	double frag_end;
+	unsigned long corrupt_at;
+};
+
+static struct op trace[MAX_OPS];
+static unsigned int trace_len;
+
+static union {
+	long double align;
+	char bytes[ARENA_SIZE + GUARD_SIZE];
+} arena;
+static size_t arena_used;
+
+static size_t overrun;
+static unsigned int rng_state;
+
+/** @fn char *m_sbrk(int nbytes)
+ * @brief host stand-in for sys_brk.c, serving the arena
+ * @param int nbytes - bytes to add
+ * @return start of the new bytes, or -1 if the arena is full
+ */
+char *m_sbrk(int nbytes)
+{
+	char *base = arena.bytes + arena_used;
+
+	if (nbytes < 0 || arena_used + (size_t) nbytes > ARENA_SIZE)
+		return (char *) -1;
+
+	arena_used += (size_t) nbytes;
+	return base;
+}
+
+void log_debug(const char *fmt, ...) { (void) fmt; }
+void log_trace(const char *fmt, ...) { (void) fmt; }
+void log_info(const char *fmt, ...) { (void) fmt; }
+void log_warn(const char *fmt, ...) { (void) fmt; }
+void log_error(const char *fmt, ...) { (void) fmt; }
+void log_fatal(const char *fmt, ...) { (void) fmt; }
+
+/** @fn static unsigned int rng(void)
+ * @brief returns the next number of a linear congruential generator
+ * @return 15 random bits
+ */
+static unsigned int rng(void)
+{
+	rng_state = rng_state * 1103515245u + 12345u;
+	return (rng_state >> 16) & 0x7fff;
+}
+
+/** @fn static size_t random_size(size_t min, size_t max)
+ * @brief returns a size with a roughly uniform logarithm
+ * @param size_t min - smallest size
+ * @param size_t max - largest size
+ * @return size in bytes
+ */
+static size_t random_size(size_t min, size_t max)
+{
+	size_t size = min << (rng() % 8);
+
+	size += rng() % size;
+	return size > max ? max : size;
+}
+
+/** @fn static void add_op(char kind, unsigned int slot, size_t size)
+ * @brief appends an operation to the trace
+ * @param char kind - 'm' or 'f'
+ * @param unsigned int slot - slot allocated or freed
+ * @param size_t size - bytes to allocate
+ */
+static void add_op(char kind, unsigned int slot, size_t size)
+{
+	if (trace_len < MAX_OPS) {
+		trace[trace_len].kind = kind;
+		trace[trace_len].slot = slot;
+		trace[trace_len].size = size;
+		trace_len++;
+	}
+}
+
+/** @fn static void make_random(unsigned int ops, unsigned int slots)
+ * @brief random sizes, each freed at a random later time
+ * @param unsigned int ops - number of allocations
+ * @param unsigned int slots - number of live slots
+ */
+static void make_random(unsigned int ops, unsigned int slots)
+{
+	static char live[MAX_SLOTS];
+	unsigned int i;
+
+	memset(live, 0, sizeof(live));
+	for (i = 0; i < ops; i++) {
+		unsigned int slot = rng() % slots;
+
+		if (live[slot])
+			add_op('f', slot, 0);
+		add_op('m', slot, random_size(8, 2048));
+		live[slot] = 1;
+	}
+}
+
+/** @fn static void make_fragment(unsigned int rounds, unsigned int slots)
+ * @brief fills the heap with small blocks, frees every other one, then asks for larger ones
+ * @param unsigned int rounds - number of times to repeat
+ * @param unsigned int slots - number of slots
+ */
+static void make_fragment(unsigned int rounds, unsigned int slots)
+{
+	unsigned int half = slots / 2;
+	unsigned int r, i;
+
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < half; i++)
+			add_op('m', i, 32 + rng() % 64);
+		for (i = 0; i < half; i += 2)
+			add_op('f', i, 0);
+		for (i = half; i < slots; i++)
+			add_op('m', i, 256 + rng() % 256);
+		for (i = 1; i < half; i += 2)
+			add_op('f', i, 0);
+		for (i = half; i < slots; i++)
+			add_op('f', i, 0);
+	}
+}
+
+/** @fn static void make_mixed(unsigned int ops, unsigned int slots)
+ * @brief short lived small blocks among long lived large ones
+ * @param unsigned int ops - number of allocations
+ * @param unsigned int slots - number of slots; a quarter are long lived
+ */
+static void make_mixed(unsigned int ops, unsigned int slots)
+{
+	static char live[MAX_SLOTS];
+	unsigned int quarter = slots / 4;
+	unsigned int i;
+
+	memset(live, 0, sizeof(live));
+	for (i = 0; i < ops; i++) {
+		unsigned int slot;
+		size_t size;
+
+		if (rng() % 16 == 0) {
+			slot = rng() % quarter;
+			size = random_size(512, 4096);
+		} else {
+			slot = quarter + rng() % (slots - quarter);
+			size = random_size(8, 128);
+		}
+		if (live[slot])
+			add_op('f', slot, 0);
+		add_op('m', slot, size);
+		live[slot] = 1;
+	}
+}
+
+/** @fn static int load_trace(const char *path)
+ * @brief reads a trace file
+ * @param const char *path - file of "m <slot> <size>" and "f <slot>" lines
+ * @return 0 on success, -1 if the file cannot be read or is malformed
+ */
+static int load_trace(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[128];
+	unsigned int number = 0;
+
+	if (!file) {
+		perror(path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		unsigned int slot;
+		unsigned long size;
+
+		number++;
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		if (sscanf(line, "m %u %lu", &slot, &size) == 2 && slot < MAX_SLOTS)
+			add_op('m', slot, size);
+		else if (sscanf(line, "f %u", &slot) == 1 && slot < MAX_SLOTS)
+			add_op('f', slot, 0);
+		else {
+			fprintf(stderr, "%s:%u: bad line\n", path, number);
+			fclose(file);
+			return -1;
+		}
+	}
+
+	fclose(file);
+	return 0;
+}
+
+/** @fn static unsigned long firstfit_steps(struct Header *base, size_t size)
+ * @brief counts the blocks first-fit's search examines for an allocation
+ * @detail one for each block find_free_block() passes over and one for the
+ * block it takes, if there is one
+ * @param struct Header *base - start of the list
+ * @param size_t size - bytes requested
+ * @return steps
+ */
+static unsigned long firstfit_steps(struct Header *base, size_t size)
+{
+	unsigned long steps = 0;
+	struct Header *block;
+
+	for (block = base; block; block = block->next) {
+		steps++;
+		if (block->free && block->size >= size)
+			break;
+		if (steps > ARENA_SIZE / sizeof(struct Header))
+			break;
+	}
+
+	/* The first call makes the heap and takes its only block. */
+	return base ? steps : 1;
+}
+
+/** @fn static double firstfit_fragmentation(struct Header *base)
+ * @brief walks the first-fit list and measures its free space
+ * @detail also records in overrun how far past the arena the blocks reach.
+ * The first block's size leaves out its own header and each split rounds the
+ * new block's address up without shrinking it, so the list claims a little
+ * more than the arena. The guard after the arena takes that overlap.
+ * @param struct Header *base - start of the list
+ * @return fragmentation, or -1 if the list has left the arena and its guard
+ */
+static double firstfit_fragmentation(struct Header *base)
+{
+	char *start = arena.bytes;
+	char *end = arena.bytes + ARENA_SIZE;
+	size_t total = 0;
+	size_t largest = 0;
+	struct Header *block;
+	unsigned int count = 0;
+
+	for (block = base; block; block = block->next) {
+		char *p = (char *) block;
+
+		if (p < start || p >= end || ++count > ARENA_SIZE / sizeof(struct Header))
+			return -1;
+		if (block->size > (size_t) (end - p) + GUARD_SIZE / 2)
+			return -1;
+		if (p + sizeof(struct Header) + block->size > end + overrun)
+			overrun = (size_t) (p + sizeof(struct Header) + block->size - end);
+		if (block->free) {
+			total += block->size;
+			if (block->size > largest)
+				largest = block->size;
+		}
+	}
+
+	return total ? 1.0 - (double) largest / (double) total : 0.0;
+}
+
+/** @fn static double segfit_fragmentation(void)
+ * @brief measures the segregated-fit free space
+ * @return fragmentation
+ */
+static double segfit_fragmentation(void)
+{
+	struct segfit_info info;
+
+	segfit_mallinfo(&info);
+	return info.fordblks ? 1.0 - (double) info.largest / (double) info.fordblks : 0.0;
+}
+
+/** @fn static struct Header *firstfit_base(enum allocator a)
+ * @brief returns the start of a first-fit list
+ * @param enum allocator a - FIRSTFIT or FIRSTFIT_FIXED
+ * @return first block, or NULL before the first allocation
+ */
+static struct Header *firstfit_base(enum allocator a)
+{
+	return a == FIRSTFIT ? global_base : firstfit_fixed_base;
+}
+
+/** @fn static double fragmentation(enum allocator a)
+ * @brief measures an allocator's free space
+ * @param enum allocator a - allocator
+ * @return fragmentation, or -1 if a first-fit list is damaged
+ */
+static double fragmentation(enum allocator a)
+{
+	return a == SEGFIT ? segfit_fragmentation() : firstfit_fragmentation(firstfit_base(a));
+}
+
+/** @fn static void replay(enum allocator a, struct result *res)
+ * @brief replays the trace against one allocator
+ * @detail every allocation is filled with its slot number, which is checked
+ * when it is freed.
+ * @param enum allocator a - allocator
+ * @param struct result *res - filled in with the counts
+ */
+static void replay(enum allocator a, struct result *res)
+{
+	static unsigned char *ptrs[MAX_SLOTS];
+	static size_t sizes[MAX_SLOTS];
+	unsigned int i;
+	double frag;
+
+	memset(res, 0, sizeof(*res));
+
+	/* Give segregated fit the whole arena as one block, as first fit takes it. */
+	if (a == SEGFIT)
+		segfit_free(segfit_malloc(1));
+
+	for (i = 0; i < trace_len; i++) {
+		struct op *op = &trace[i];
+		unsigned long steps = 0;
+
+		if (ptrs[op->slot]) {
+			size_t j;
+
+			for (j = 0; j < sizes[op->slot]; j++)
+				if (ptrs[op->slot][j] != (unsigned char) op->slot) {
+					res->corrupt_at = i + 1;
+					return;
+				}
+			if (a == SEGFIT)
+				segfit_free(ptrs[op->slot]);
+			else if (a == FIRSTFIT_FIXED)
+				firstfit_fixed_free(ptrs[op->slot]);
+			else
+				firstfit_free(ptrs[op->slot]);
+			ptrs[op->slot] = NULL;
+		}
+
+		if (op->kind == 'm') {
+			unsigned char *p;
+
+			if (a == SEGFIT) {
+				struct segfit_info info;
+
+				segfit_mallinfo(&info);
+				steps = info.search_steps;
+				p = segfit_malloc(op->size);
+				segfit_mallinfo(&info);
+				steps = info.search_steps - steps;
+			} else {
+				steps = firstfit_steps(firstfit_base(a), op->size);
+				if (a == FIRSTFIT_FIXED)
+					p = firstfit_fixed_malloc(op->size);
+				else
+					p = firstfit_malloc(op->size);
+			}
+
+			res->mallocs++;
+			res->steps += steps;
+			if (steps > res->max_steps)
+				res->max_steps = steps;
+			if (!p)
+				res->failures++;
+			else if (a != SEGFIT && fragmentation(a) < 0) {
+				res->corrupt_at = i + 1;
+				return;
+			} else {
+				memset(p, (unsigned char) op->slot, op->size);
+				ptrs[op->slot] = p;
+				sizes[op->slot] = op->size;
+			}
+		}
+
+		if (i % 64 == 63) {
+			frag = fragmentation(a);
+			res->frag_sum += frag;
+			res->frag_samples++;
+		}
+	}
+
+	res->frag_end = fragmentation(a);
+}
+
+/** @fn static void run(const char *name)
+ * @brief replays the trace against every allocator and prints a line for each
+ * @param const char *name - name of the trace
+ */
+static void run(const char *name)
+{
+	int a;
+
+	for (a = 0; a < ALLOCATORS; a++) {
+		struct result res;
+		pid_t pid;
+		int status;
+
+		fflush(stdout);
+		pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			exit(1);
+		}
+		if (pid == 0) {
+			replay((enum allocator) a, &res);
+			printf("%-10s %-9s %8lu %8lu %10.2f %8lu %9.3f %9.3f",
+				name, allocator_names[a], res.mallocs,
+				res.failures, res.mallocs ? (double) res.steps / (double) res.mallocs : 0.0,
+				res.max_steps, res.frag_samples ? res.frag_sum / (double) res.frag_samples : 0.0,
+				res.frag_end);
+			if (res.corrupt_at)
+				printf("  heap corrupt at op %lu", res.corrupt_at);
+			if (overrun)
+				printf("  overran arena by %zu bytes", overrun);
+			printf("\n");
+			exit(0);
+		}
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status))
+			printf("%-10s %-9s crashed\n", name, allocator_names[a]);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int ops = 20000;
+	unsigned int slots = 256;
+	unsigned int seed = 1;
+	int i;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = (unsigned int) strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc)
+			ops = (unsigned int) strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--slots") == 0 && i + 1 < argc)
+			slots = (unsigned int) strtoul(argv[++i], NULL, 0);
+		else {
+			fprintf(stderr, "usage: %s [--seed n] [--ops n] [--slots n] [trace...]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (slots < 4 || slots > MAX_SLOTS || ops > MAX_OPS / 2) {
+		fprintf(stderr, "slots must be 4 to %u and ops at most %u\n", MAX_SLOTS, MAX_OPS / 2);
+		return 2;
+	}
+
+	printf("arena %u bytes, seed %u\n", ARENA_SIZE, seed);
+	printf("%-10s %-9s %8s %8s %10s %8s %9s %9s\n", "trace", "malloc",
+		"mallocs", "failed", "avg steps", "max", "avg frag", "end frag");
+
+	if (i < argc) {
+		for (; i < argc; i++) {
+			trace_len = 0;
+			if (load_trace(argv[i]) != 0)
+				return 1;
+			run(argv[i]);
+		}
+		return 0;
+	}
+
+	rng_state = seed;
+	trace_len = 0;
+	make_random(ops, slots);
+	run("random");
+
+	trace_len = 0;
+	make_fragment(ops / slots + 1, slots);
+	run("fragment");
+
+	trace_len = 0;
+	make_mixed(ops, slots);
+	run("mixed");
+
+	return 0;
+}
@@ -0,0 +1,2 @@
+/* Host stand-in for the SoC platform.h, which malloc_firstfit.c includes but
+ * does not use. */
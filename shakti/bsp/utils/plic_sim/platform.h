@@ -0,0 +1,28 @@
+/* Host stand-in for the SoC platform.h. It takes the vajra memory map and
+ * moves the PLIC, mcycle, mepc and mstatus into plic_sim.c. */
+#ifndef PLIC_SIM_PLATFORM_H
+#define PLIC_SIM_PLATFORM_H
+
+#include <stdint.h>
+#include "../../third_party/vajra/platform.h"
+
+extern uint32_t plic_sim_regs[];
+#undef PLIC_BASE_ADDRESS
+#define PLIC_BASE_ADDRESS ((uintptr_t) plic_sim_regs)
+
+uint32_t plic_sim_claim(void);
+void plic_sim_complete(uint32_t id);
+#define plic_claim_read()	plic_sim_claim()
+#define plic_claim_write(id)	plic_sim_complete(id)
+
+enum { SIM_CSR_mcycle, SIM_CSR_mepc, SIM_CSR_mstatus };
+uintptr_t sim_csr_read(int csr);
+void sim_csr_write(int csr, uintptr_t value);
+void sim_csr_set(int csr, uintptr_t bits);
+void sim_csr_clear(int csr, uintptr_t bits);
+#define read_csr(reg)		sim_csr_read(SIM_CSR_##reg)
+#define write_csr(reg, val)	sim_csr_write(SIM_CSR_##reg, (uintptr_t) (val))
+#define set_csr(reg, bit)	sim_csr_set(SIM_CSR_##reg, (uintptr_t) (bit))
+#define clear_csr(reg, bit)	sim_csr_clear(SIM_CSR_##reg, (uintptr_t) (bit))
+
+#endif
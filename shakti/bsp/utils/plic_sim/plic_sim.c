@@ -0,0 +1,481 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  plic_sim.c
+* Brief Description of file             :  Host simulation of the PLIC for plic_driver.c.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file plic_sim.c
+@brief Host simulation of the PLIC for plic_driver.c.
+@detail Runs mach_plic_handler from bsp/drivers/plic/plic_driver.c against a
+simulated PLIC and hart. The PLIC's priority, enable and threshold registers
+are plain memory. Claims return the highest priority pending source that is
+enabled and above the threshold, with ties going to the lowest id. A claimed
+source is not offered again until it is completed. The hart takes an
+external interrupt whenever mstatus.MIE is set and a source can be claimed,
+so with PLIC_NESTING a handler that enables interrupts is preempted as it
+would be on the board. mcycle only advances by the cost each isr declares.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_check.h"
+#include "plic_driver.h"
+#include "defines.h"
+#include "log.h"
+
+#define MAX_EVENTS	256
+
+uint32_t plic_sim_regs[(PLIC_CLAIM_OFFSET + 4) / 4];
+
+static uint32_t pending;
+static uint32_t claimed;
+static uintptr_t mcycle;
+static uintptr_t mepc;
+static uintptr_t mstatus = MSTATUS_MIE;
+static unsigned int traps;
+static unsigned int bad_mepc;
+
+/* What each source's isr costs and raises, and the order they ran in. */
+static uint32_t isr_cost[PLIC_MAX_INTERRUPT_SRC];
+static uint32_t isr_raises[PLIC_MAX_INTERRUPT_SRC];
+static int events[MAX_EVENTS];
+static unsigned int event_count;
+
+static void take_interrupts(void);
+
+/* Stand-ins for what plic_driver.c uses from traps.c and other drivers. */
+mtrap_fptr_t mcause_interrupt_table[MAX_INTERRUPT_VALUE];
+uint32_t pwm_check_continuous_mode(uint32_t module_number) { (void) module_number; return 1; }
+uint32_t set_pwm_control_register(uint32_t module_number, uint32_t value) { (void) module_number; return value; }
+unsigned long read_word(uint32_t *addr) { (void) addr; return 0; }
+void write_word(uint32_t *addr, unsigned long val) { (void) addr; (void) val; }
+
+void _printf_(const char *fmt, va_list ap)
+{
+	vprintf(fmt, ap);
+}
+
+/** @fn static uint32_t priority_of(uint32_t id)
+ * @brief reads a source's priority register
+ */
+static uint32_t priority_of(uint32_t id)
+{
+	return plic_sim_regs[(PLIC_PRIORITY_OFFSET >> 2) + id];
+}
+
+/** @fn static int enabled(uint32_t id)
+ * @brief reads a source's enable bit
+ */
+static int enabled(uint32_t id)
+{
+	const uint8_t *enable = (const uint8_t *) plic_sim_regs + PLIC_ENABLE_OFFSET;
+
+	return (enable[id >> 3] >> (id & 7)) & 1;
+}
+
+/** @fn static uint32_t best_pending(void)
+ * @brief returns the source a claim would return now, or 0
+ */
+static uint32_t best_pending(void)
+{
+	uint32_t threshold = plic_sim_regs[PLIC_THRESHOLD_OFFSET >> 2];
+	uint32_t best = 0;
+	uint32_t id;
+
+	for (id = 1; id < PLIC_MAX_INTERRUPT_SRC; id++)
+	{
+		if (!(pending & (1u << id)) || (claimed & (1u << id)) || !enabled(id))
+			continue;
+		if (priority_of(id) <= threshold)
+			continue;
+		if (best == 0 || priority_of(id) > priority_of(best))
+			best = id;
+	}
+
+	return best;
+}
+
+uint32_t plic_sim_claim(void)
+{
+	uint32_t id = best_pending();
+
+	if (id)
+	{
+		pending &= ~(1u << id);
+		claimed |= 1u << id;
+	}
+
+	return id;
+}
+
+void plic_sim_complete(uint32_t id)
+{
+	claimed &= ~(1u << id);
+}
+
+uintptr_t sim_csr_read(int csr)
+{
+	switch (csr)
+	{
+		case SIM_CSR_mcycle:
+			return mcycle;
+		case SIM_CSR_mepc:
+			return mepc;
+		default:
+			return mstatus;
+	}
+}
+
+void sim_csr_write(int csr, uintptr_t value)
+{
+	if (csr == SIM_CSR_mepc)
+		mepc = value;
+	else if (csr == SIM_CSR_mstatus)
+	{
+		mstatus = value;
+		take_interrupts();
+	}
+}
+
+void sim_csr_set(int csr, uintptr_t bits)
+{
+	sim_csr_write(csr, sim_csr_read(csr) | bits);
+}
+
+void sim_csr_clear(int csr, uintptr_t bits)
+{
+	sim_csr_write(csr, sim_csr_read(csr) & ~bits);
+}
+
+/** @fn static void take_interrupts(void)
+ * @brief traps into mach_plic_handler while interrupts are enabled and a source is claimable
+ * @details mepc is given a new value for every trap and checked on the way
+ *          out, as mret would use it.
+ */
+static void take_interrupts(void)
+{
+	while ((mstatus & MSTATUS_MIE) && best_pending())
+	{
+		uintptr_t saved_mstatus = mstatus;
+		uintptr_t trap_mepc = 0x80000000u + 4 * ++traps;
+
+		mstatus &= ~MSTATUS_MIE;
+		mepc = trap_mepc;
+
+		mach_plic_handler(MACH_EXTERNAL_INTERRUPT, trap_mepc);
+
+		if (mepc != trap_mepc)
+			bad_mepc++;
+		mstatus = saved_mstatus;
+	}
+}
+
+/** @fn static void raise(uint32_t id)
+ * @brief makes a source pending, as its device would
+ */
+static void raise(uint32_t id)
+{
+	pending |= 1u << id;
+	take_interrupts();
+}
+
+/** @fn static void sim_isr(uint32_t id)
+ * @brief isr installed for every source
+ * @details Logs its start and end, spends isr_cost[id] cycles and raises
+ *          the sources in isr_raises[id] halfway through.
+ */
+static void sim_isr(uint32_t id)
+{
+	uint32_t raises = isr_raises[id];
+	uint32_t other;
+
+	if (event_count < MAX_EVENTS)
+		events[event_count++] = (int) id;
+
+	mcycle += isr_cost[id] / 2;
+	for (other = 1; other < PLIC_MAX_INTERRUPT_SRC; other++)
+		if (raises & (1u << other))
+			raise(other);
+	mcycle += isr_cost[id] - isr_cost[id] / 2;
+
+	if (event_count < MAX_EVENTS)
+		events[event_count++] = -(int) id;
+}
+
+/** @fn static void reset(void)
+ * @brief sets up the PLIC as plic_init does and clears the simulation
+ */
+static void reset(void)
+{
+	uint32_t id;
+
+	memset(plic_sim_regs, 0, sizeof(plic_sim_regs));
+	pending = 0;
+	claimed = 0;
+	mcycle = 0;
+	mstatus = MSTATUS_MIE;
+	traps = 0;
+	bad_mepc = 0;
+	event_count = 0;
+	memset(isr_cost, 0, sizeof(isr_cost));
+	memset(isr_raises, 0, sizeof(isr_raises));
+
+	plic_init();
+
+	for (id = 1; id < PLIC_MAX_INTERRUPT_SRC; id++)
+	{
+		isr_table[id] = sim_isr;
+		isr_cost[id] = 100 + id;
+		interrupt_enable(id);
+	}
+}
+
+/** @fn static int events_are(int n, ...)
+ * @brief compares the isr log with the expected starts (+id) and ends (-id)
+ */
+static int events_are(int n, ...)
+{
+	va_list ap;
+	int i;
+	int same = (unsigned int) n == event_count;
+
+	va_start(ap, n);
+	for (i = 0; i < n && same; i++)
+		same = events[i] == va_arg(ap, int);
+	va_end(ap);
+
+	return same;
+}
+
+static void test_burst_order(void)
+{
+	reset();
+	set_interrupt_priority(PLIC_PRIORITY_3, 5);
+	set_interrupt_priority(PLIC_PRIORITY_6, 9);
+	set_interrupt_priority(PLIC_PRIORITY_4, 12);
+	set_interrupt_priority(PLIC_PRIORITY_6, 20);
+
+	mstatus = 0;
+	pending = (1u << 5) | (1u << 9) | (1u << 12) | (1u << 20);
+	sim_csr_set(SIM_CSR_mstatus, MSTATUS_MIE);
+
+	check(events_are(8, 9, -9, 20, -20, 12, -12, 5, -5),
+	      "a burst of four is served highest priority first, ties by id");
+	check(traps == 1, "the burst is served in one trap (%u)", traps);
+	check(hart0_interrupt_matrix[9].count == 1 && hart0_interrupt_matrix[5].count == 1,
+	      "each source is counted once");
+}
+
+static void test_back_to_back(void)
+{
+	reset();
+	isr_raises[5] = 1u << 7;
+
+	raise(5);
+
+	check(events_are(4, 5, -5, 7, -7), "a source raised by an isr follows it");
+	check(traps == 1, "without another trap (%u)", traps);
+}
+
+static void test_masked(void)
+{
+	reset();
+	set_interrupt_priority(PLIC_PRIORITY_2, 3);
+	interrupt_disable(4);
+
+	raise(3);
+	raise(4);
+	raise(6);
+
+	check(events_are(2, 6, -6), "sources at the threshold or disabled are not served");
+	check(pending == ((1u << 3) | (1u << 4)), "and stay pending");
+}
+
+static void test_preemption(void)
+{
+	reset();
+	set_interrupt_priority(PLIC_PRIORITY_3, 5);
+	set_interrupt_priority(PLIC_PRIORITY_6, 9);
+	isr_raises[5] = 1u << 9;
+
+	raise(5);
+
+#if PLIC_NESTING
+	check(events_are(4, 5, 9, -9, -5), "a higher priority source preempts an isr");
+	check(traps == 2, "in a nested trap (%u)", traps);
+	check(hart0_interrupt_matrix[5].max_cycles == isr_cost[5] + isr_cost[9],
+	      "the preempted isr's cycles include the nested one");
+#else
+	check(events_are(4, 5, -5, 9, -9), "a higher priority source waits for the isr");
+	check(traps == 1, "in the same trap (%u)", traps);
+#endif
+
+	reset();
+	set_interrupt_priority(PLIC_PRIORITY_6, 9);
+	set_interrupt_priority(PLIC_PRIORITY_3, 12);
+	isr_raises[9] = 1u << 12;
+	isr_raises[12] = 1u << 13;
+
+	raise(9);
+
+	check(events_are(6, 9, -9, 12, -12, 13, -13),
+	      "lower and equal priority sources never preempt");
+	check(plic_sim_regs[PLIC_THRESHOLD_OFFSET >> 2] == PLIC_PRIORITY_2,
+	      "the threshold is restored");
+	check(bad_mepc == 0, "mepc is restored for every trap");
+}
+
+/** @fn static void logging_isr(uint32_t id)
+ * @brief isr that saves a log at its start and end
+ * @details Source 5 makes source 9 pending while it is about to log, as
+ *          if 9's device had interrupted log_isr_put.
+ */
+static void logging_isr(uint32_t id)
+{
+	if (event_count < MAX_EVENTS)
+		events[event_count++] = (int) id;
+
+	log_isr_info("isr %u start\n", id);
+	if (id == 5)
+		pending |= 1u << 9;
+	log_isr_info("isr %u end\n", id);
+
+	if (event_count < MAX_EVENTS)
+		events[event_count++] = -(int) id;
+}
+
+static void test_logging(void)
+{
+	reset();
+	set_interrupt_priority(PLIC_PRIORITY_3, 5);
+	set_interrupt_priority(PLIC_PRIORITY_6, 9);
+	isr_table[5] = logging_isr;
+	isr_table[9] = logging_isr;
+	log_isr_drain();
+
+	raise(5);
+
+#if PLIC_NESTING
+	check(events_are(4, 5, 9, -9, -5),
+	      "a source that arrives during log_isr_put preempts once it returns");
+#else
+	check(events_are(4, 5, -5, 9, -9), "a source that arrives during log_isr_put waits for the isr");
+#endif
+	check(log_isr_drain() == 4, "and every log is kept");
+	check(mstatus & MSTATUS_MIE, "interrupts are enabled again");
+}
+
+static void test_cycles(void)
+{
+	reset();
+	raise(8);
+	isr_cost[8] = 500;
+	raise(8);
+	raise(10);
+
+	check(hart0_interrupt_matrix[8].count == 2 &&
+	      hart0_interrupt_matrix[8].total_cycles == 108 + 500 &&
+	      hart0_interrupt_matrix[8].max_cycles == 500,
+	      "count, total and max cycles of a source (%u, %u, %u)",
+	      hart0_interrupt_matrix[8].count,
+	      (uint32_t) hart0_interrupt_matrix[8].total_cycles,
+	      hart0_interrupt_matrix[8].max_cycles);
+	check(hart0_interrupt_matrix[10].count == 1 &&
+	      hart0_interrupt_matrix[10].total_cycles == 110,
+	      "and of another");
+}
+
+static void test_random_bursts(void)
+{
+	static const uint32_t priorities[] = {
+		PLIC_PRIORITY_3, PLIC_PRIORITY_4, PLIC_PRIORITY_5,
+		PLIC_PRIORITY_6, PLIC_PRIORITY_7
+	};
+	uint32_t raised[PLIC_MAX_INTERRUPT_SRC] = { 0 };
+	unsigned int round, bad_order = 0, bad_traps = 0, bad_counts = 0;
+	uint32_t id;
+
+	reset();
+	srand(1);
+
+	for (round = 0; round < 1000; round++)
+	{
+		uint32_t burst = 0;
+		unsigned int i;
+
+		for (id = 1; id < PLIC_MAX_INTERRUPT_SRC; id++)
+			set_interrupt_priority(priorities[rand() % 5], id);
+		for (id = 1; id < PLIC_MAX_INTERRUPT_SRC; id++)
+			if (rand() % 4 == 0)
+				burst |= 1u << id;
+		if (!burst)
+			continue;
+
+		for (id = 1; id < PLIC_MAX_INTERRUPT_SRC; id++)
+			if (burst & (1u << id))
+				raised[id]++;
+
+		event_count = 0;
+		traps = 0;
+		mstatus = 0;
+		pending = burst;
+		sim_csr_set(SIM_CSR_mstatus, MSTATUS_MIE);
+
+		if (traps != 1)
+			bad_traps++;
+		for (i = 2; i < event_count; i += 2)
+		{
+			uint32_t a = (uint32_t) events[i - 2];
+			uint32_t b = (uint32_t) events[i];
+
+			if (priority_of(a) < priority_of(b) ||
+			    (priority_of(a) == priority_of(b) && a > b))
+				bad_order++;
+		}
+	}
+
+	for (id = 1; id < PLIC_MAX_INTERRUPT_SRC; id++)
+		if (hart0_interrupt_matrix[id].count != raised[id])
+			bad_counts++;
+
+	check(bad_order == 0, "1000 random bursts are served in priority order (%u wrong)", bad_order);
+	check(bad_traps == 0, "each in one trap (%u wrong)", bad_traps);
+	check(bad_counts == 0, "and every source is counted once per raise (%u wrong)", bad_counts);
+}
+
+int main(void)
+{
+	printf("plic_driver.c with PLIC_NESTING %d\n", PLIC_NESTING);
+
+	test_burst_order();
+	test_back_to_back();
+	test_masked();
+	test_preemption();
+	test_logging();
+	test_cycles();
+	test_random_bursts();
+
+	plic_print_stats();
+
+	return check_summary();
+}
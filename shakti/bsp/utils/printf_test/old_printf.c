@@ -0,0 +1,378 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  old_printf.c
+* Brief Description of file             :  The printf and ftoa printf_test times against.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file old_printf.c
+@brief The printf and ftoa printf_test times against.
+@detail _printf_ from bsp/libs/printf.c and ftoa from bsp/libs/util.c as
+they were before the formatter, with the names prefixed old_. Each
+character goes to old_putchar, which printf_test.c counts.
+*/
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+int old_putchar(int ch);
+void old_printf_(const char *fmt, va_list ap);
+static void ftoa(float n, char *res, unsigned int afterpoint);
+
+#define putchar old_putchar
+#define _printf_ old_printf_
+
+/** @fn  static inline void itoa (unsigned long long int number, unsigned base)
+ * @brief integer to string conversion
+ * @param unsigned long long int
+ * @param unsigned
+ */
+
+static inline void itoa (unsigned long long int number, unsigned base)
+{
+	int i = 0;
+	unsigned int intermediate = 0;
+	unsigned int digits[sizeof(number)*8];
+
+	while (1) {
+		digits[i] = number % base;
+
+		if (number < base)
+			break;
+
+		number /= base;
+		i++;
+	}
+	i++;
+	while (i-- > 0)
+	{
+		if (digits[i] >= 10)
+			intermediate = 'a' - 10;
+		else
+			intermediate = '0';
+
+		putchar(digits[i] + intermediate);
+	}
+}
+
+/** @fn void _printf_(const char *fmt, va_list ap)
+ * @brief Handles the input stream of characters to print on screen
+ * @details Identifies the type of format string, number of arguments and prints the right characer on screen
+ * @param const char * fmt - formatting strings
+ * @param const va_list ap - arg list
+ */
+void _printf_(const char *fmt, va_list ap)
+{
+	register const char* p;
+	const char* last_fmt;
+	register int ch;
+	unsigned long long num;
+	int base, lflag, i;
+	float float_num = 0;
+	char float_arr[30] = {'\0'};
+	int backtothebeginning;
+
+	for (;;) {
+		for (;(ch = *(unsigned char *) fmt) != '%'; fmt++) {
+			if (ch == '\0')
+				return;
+			putchar(ch);
+		}
+		fmt++;
+
+		// Process a %-escape sequence
+		last_fmt = fmt;
+		lflag = 0;
+
+		backtothebeginning = 0;
+		for (;;) {
+
+			switch (ch = *(unsigned char *) fmt++) {
+
+				// long flag (doubled for long long)
+				case 'l':
+					lflag++;
+					backtothebeginning = 1;
+					break;
+
+					// character
+				case 'c':
+					putchar(va_arg(ap, int));
+					break;
+
+					// string
+				case 's':
+					if ((p = va_arg(ap, char *)) == NULL)
+						p = "(null)";
+					for (; (ch = *p) != '\0' ;) {
+						putchar(ch);
+						p++;
+					}
+					break;
+
+					// (signed) decimal
+				case 'd':
+					base = 10;
+
+					if (lflag >= 2)
+						num = va_arg(ap, long long);
+					else if (lflag ==1)
+						num = va_arg(ap, long);
+					else
+						num = va_arg(ap, int);
+
+					if ((long long) num < 0) {
+						putchar('-');
+						num = -(long long) num;
+					}
+
+					itoa( num, base);
+
+					break;
+
+				case 'f':
+					float_num =  va_arg(ap, double);
+
+					ftoa(float_num, float_arr, 6);
+
+					for( i = 0; float_arr[i] != '\0'; i++)
+					{
+						putchar(float_arr[i]);
+						if(i > 29) break;
+					}
+					break;
+
+					// unsigned decimal
+				case 'u':
+					base = 10;
+
+					if (lflag >= 2)
+						num = va_arg(ap, unsigned long long);
+					else if (lflag)
+						num = va_arg(ap, unsigned long);
+					else
+						num = va_arg(ap, unsigned int);
+
+					itoa( num, base);
+
+					break;
+
+					// (unsigned) octal
+				case 'o':
+					// should do something with padding so it's always 3 octits
+					base = 8;
+
+					if (lflag >= 2)
+						num = va_arg(ap, unsigned long long);
+					else if (lflag)
+						num = va_arg(ap, unsigned long);
+					else
+						num = va_arg(ap, unsigned int);
+
+					itoa( num, base);
+
+					break;
+
+				case 'x':
+					base = 16;
+
+					if (lflag >= 2)
+						num = va_arg(ap, unsigned long long);
+					else if (lflag)
+						num = va_arg(ap, unsigned long);
+					else
+						num = va_arg(ap, unsigned int);
+
+					itoa( num, base);
+
+					break;
+
+					// escaped '%' character
+				case '%':
+					putchar(ch);
+					break;
+
+					// unrecognized escape sequence - just print it literally
+				default:
+					putchar('%');
+					fmt = last_fmt;
+					break;
+			}
+
+			if (backtothebeginning)
+			{
+				backtothebeginning = 0;
+				continue;
+			}
+			else
+				break;
+		}
+	}
+}
+
+
+/** @fn float pow_10(unsigned int y)
+ * @brief generate different powers of 10
+ * @param unsigned int y
+ * @return return result in float 
+ */
+static float pow_10(unsigned int y)
+{
+	unsigned int x=1;
+
+	for (unsigned int i=0; i <y; i++)
+	{
+		x *= 10;
+	}
+
+	return ((float) x);
+}
+/** @fn void reverse(char *str, int length)
+ * @brief reverse a string and store in the same string
+ * @param char *str
+ * @param int length
+ */
+static void reverse(char *str, int length)
+{
+	int i = 0;
+	int j = length - 1;
+	char tmp;
+
+	while (i<j)
+	{
+		tmp = str[i];
+		str[i] = str[j];
+		str[j] = tmp;
+
+		i++;
+		j--;
+	}
+}
+
+/** @fn int int_to_string(int number, char str[], int afterpoint)
+ * @brief convert decimal numbers to string
+ * @details Takes num as input and converts it to string.
+ *	    The converted string is stored in str. The
+ *          position of last character in the str is returned.
+ *          This function is tailored to support ftoa.
+ * @param int number
+ * @param char str[]
+ * @param int afterpoint
+ * @return int
+ */
+static int int_to_string(int number, char str[], unsigned int afterpoint)
+{
+	uint32_t i = 0;
+
+	/*extract each digit and put into str[i]*/
+
+	while (number != 0)
+	{
+		str[i] = ((number%10) + '0');
+		i++;
+		number = number/10;
+	}
+
+	/*insert 0 after the numbers, if count of digits less than afterpoint*/
+
+	while (i < afterpoint)
+	{
+		str[i] = '0';
+		i++;
+	}
+
+	/*
+	   zeroth digit is in oth position in array,
+	   To read digits properly, reverse array
+	 */
+	reverse(str, i);
+	str[i] = '\0';
+
+	return i;
+}
+/** @fn void ftoa(float n, char *res, int afterpoint)
+ * @brief converts float to string
+ * @details Split floating number into fpart and ipart
+ *          Finally merge it into one float number.
+ *          Return a string, which has the float value.
+ * @param float (floating point number - n)
+ * @param char* (float in string - res)
+ * @param int (precision - afterpoint)
+ */
+static void ftoa(float n, char *res, unsigned int afterpoint)
+{
+	int i=0;
+	char temp[30]={'\0'};
+	n += 0.0000001;
+
+	// Extract integer part
+	int ipart = (int)n;
+
+	// Extract floating part
+	float fpart = (float) (n - (float)ipart);
+	int j=0;
+
+	if(n < (0/1))
+	{
+		res[j]='-';
+		j=1;
+	}
+
+	if (ipart == 0)
+	{
+		res[j]='0';
+		j=j+1;
+	}
+	else{
+		if (ipart <0)
+		{
+			ipart =(-1)*ipart;
+		}
+
+		i = int_to_string(ipart, temp, 0);
+
+		strcpy(res+j,temp);
+	}
+
+	i = i+j;
+
+	// check for display option after point
+	if (afterpoint != 0)
+	{
+		res[i] = '.';// add dot
+
+		if (fpart < 0/1)
+		{
+
+			fpart = (-1)*fpart;
+
+		}
+		else if (fpart == 0/1)
+		{
+			fpart = fpart;
+		}
+
+		fpart = fpart * pow_10( afterpoint);
+
+		int_to_string((int)fpart, res + i + 1, afterpoint);
+	}
+}
@@ -0,0 +1,618 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  printf_test.c
+* Brief Description of file             :  Checks bsp printf against glibc and times it.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file printf_test.c
+@brief Checks bsp printf against glibc and times it.
+@detail A host program that runs bsp/libs/printf.c and util.c, built
+unchanged with their calls renamed bsp_, against the host's glibc. A table
+of formats covers each flag, width, precision, length and conversion, and
+the edges: 0 with precision 0, the extremes of each integer type, %f of
+ties, of the largest and smallest doubles, of inf and nan, and carries out
+of the fraction. Random formats and values then run through both, the
+doubles drawn from all bit patterns as well as from short decimals and
+halves, which are the ties. snprintf is checked at every size around a
+string's length. printf is checked through a buffered uart that takes all,
+part or none of each block.
+
+The Makefile also builds printf_test32, with printf.c built as for rv32,
+to run the long division that stands in for 64 bit divides there.
+
+The timings compare, per call: printf before this formatter, with its
+character at a time output, printf and snprintf now, and glibc's
+snprintf. Cycles are the host's time stamp counter. The host has an FPU, so
+the old %f, which converted through float math, runs at hardware speed
+here; on the E class cores it is soft float library calls. So are the old
+printf's per digit divides by a variable base, which on rv32 call libgcc
+for each 64 bit divide and remainder. The fastest of several runs is shown.
+*/
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#include "sim_check.h"
+#include "uart.h"
+
+#ifndef TEST_XLEN
+#define TEST_XLEN 64
+#endif
+
+#define FUZZ_INTS	300000
+#define FUZZ_DOUBLES	300000
+#define SHOW_FAILS	5
+#define BENCH_CALLS	100000
+#define BENCH_RUNS	7
+
+#define PRINTF_LIKE(f, a) __attribute__((format(printf, f, a)))
+
+int bsp_printf(const char *fmt, ...) PRINTF_LIKE(1, 2);
+int bsp_snprintf(char *str, size_t size, const char *fmt, ...) PRINTF_LIKE(3, 4);
+int bsp_sprintf(char *str, const char *fmt, ...) PRINTF_LIKE(2, 3);
+int bsp_vsnprintf(char *str, size_t size, const char *fmt, va_list ap);
+void _printf_(const char *fmt, va_list ap);
+void ftoa(float n, char *res, unsigned int afterpoint);
+int int_to_string(int number, char str[], unsigned int afterpoint);
+void old_printf_(const char *fmt, va_list ap);
+
+/* What the stand-in uart does with a block */
+enum { UART_TAKES_ALL, UART_TAKES_PART, UART_TAKES_NONE };
+
+uart_struct *uart_instance[1];
+
+static int uart_mode;
+static int uart_counting;	/* count only, for the timings */
+static char captured[8192];
+static size_t captured_len;
+static unsigned int write_calls, putchar_calls;
+static unsigned long sink;
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+/** @fn uint32_t uart_write(uart_struct *instance, const uint8_t *data, uint32_t len, uint32_t timeout)
+ * @brief takes all of a block, the first 10 bytes or none, by uart_mode
+ */
+uint32_t uart_write(uart_struct *instance, const uint8_t *data, uint32_t len, uint32_t timeout)
+{
+	uint32_t n = len;
+
+	(void) instance;
+	(void) timeout;
+
+	if (uart_mode == UART_TAKES_PART && n > 10)
+		n = 10;
+	else if (uart_mode == UART_TAKES_NONE)
+		n = 0;
+
+	write_calls++;
+	if (uart_counting)
+		sink += n;
+	else if (captured_len + n <= sizeof(captured))
+	{
+		memcpy(captured + captured_len, data, n);
+		captured_len += n;
+	}
+
+	return n;
+}
+
+/** @fn int test_putchar(int ch)
+ * @brief the polled fallback of printf.c
+ */
+int test_putchar(int ch)
+{
+	putchar_calls++;
+	if (uart_counting)
+		sink++;
+	else if (captured_len < sizeof(captured))
+		captured[captured_len++] = (char) ch;
+
+	return ch;
+}
+
+/** @fn int old_putchar(int ch)
+ * @brief the output of the old printf
+ */
+int old_putchar(int ch)
+{
+	sink += (unsigned int) ch;
+	return ch;
+}
+
+/** @fn static uint64_t rng(void)
+ * @brief xorshift64*, seeded the same on every run
+ */
+static uint64_t rng(void)
+{
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/* A format run through both, and how many differed */
+static unsigned int compared, mismatched;
+
+/** @fn static void same(const char *fmt, int got_n, const char *got, int want_n, const char *want)
+ * @brief compares bsp's output and return value to glibc's
+ */
+static void same(const char *fmt, int got_n, const char *got, int want_n, const char *want)
+{
+	compared++;
+
+	if (got_n == want_n && strcmp(got, want) == 0)
+		return;
+
+	if (mismatched++ < SHOW_FAILS)
+		printf("  \"%s\": got \"%s\" (%d), glibc \"%s\" (%d)\n", fmt, got, got_n, want, want_n);
+}
+
+#define SAME(fmt, ...) \
+	do { \
+		char got_[512], want_[512]; \
+		int got_n_ = bsp_snprintf(got_, sizeof(got_), fmt, __VA_ARGS__); \
+		int want_n_ = snprintf(want_, sizeof(want_), fmt, __VA_ARGS__); \
+		same(fmt, got_n_, got_, want_n_, want_); \
+	} while (0)
+
+/** @fn static void test_table(void)
+ * @brief checks fixed formats against glibc
+ */
+static void test_table(void)
+{
+	char got[64];
+	const char *fmt;
+	int n;
+
+	compared = mismatched = 0;
+
+	SAME("plain text%s", "");
+	SAME("%d %i %d %d", 0, 42, -42, INT_MIN);
+	SAME("%d %d", INT_MAX, -1);
+	SAME("%u %u %u", 0U, 1U, UINT_MAX);
+	SAME("%5d|%-5d|%05d|%+d|% d|%+d|% d", 42, 42, 42, 42, 42, -42, -42);
+	SAME("%+05d|%-+5d|% 05d|%-05d", 42, 42, 42, 42);
+	SAME("%.0d|%.0u|%.0x|%#.0x|%#.0o|%5.0d|", 0, 0U, 0U, 0U, 0U, 0);
+	SAME("%.5d|%.5d|%8.5d|%-8.5d|%08.5d", 42, -42, 42, 42, 42);
+	SAME("%x %X %#x %#X %#x %o %#o %#o", 0xdeadbeefU, 0xdeadbeefU, 255U, 255U, 0U, 8U, 8U, 0U);
+	SAME("%#10x|%#-10x|%#010x|%#.6x|%#010o|%#.5o", 255U, 255U, 255U, 255U, 8U, 8U);
+	SAME("%#u %#d", 5U, 5);
+	SAME("%hhd %hhu %hhx %hd %hu %hx", 300, 300, 511, 70000, 70000, 0x12345);
+	SAME("%hhd %hd", -129, -32769);
+	SAME("%ld %lu %lx", LONG_MIN, ULONG_MAX, ULONG_MAX);
+	SAME("%lld %llu %llx %llo", LLONG_MIN, ULLONG_MAX, ULLONG_MAX, ULLONG_MAX);
+	SAME("%lld %llu", 9999999999999999LL, 100000000ULL);
+	SAME("%llu %llu %llu", 4294967295ULL, 4294967296ULL, 10000000000000000000ULL);
+	SAME("%zu %zd %zx", (size_t) 123456, (ptrdiff_t) -5, SIZE_MAX);
+	SAME("%jd %ju %td %tu", INTMAX_MIN, UINTMAX_MAX, (ptrdiff_t) -7, (ptrdiff_t) 7);
+	SAME("%*d|%-*d|%*d|%.*d|%.*d|%*.*d", 6, 42, 6, 42, -6, 42, 4, 7, -1, 7, 8, 3, 9);
+	SAME("%c%c%c|%3c|%-3c|", 'a', 'b', 0x100 + 'c', 'x', 'y');
+	SAME("%s|%10s|%-10s|%.2s|%10.3s|%.0s|%.10s", "hello", "hello", "hello", "hello", "hello", "hello", "hi");
+	SAME("%s %5s", (char *) NULL, (char *) NULL);
+	SAME("%p %p %20p %-20p|", (void *) 0x1234, (void *) &n, (void *) 0x1234, (void *) 0x1234);
+	SAME("%p %10p %-10p|", (void *) NULL, (void *) NULL, (void *) NULL);
+	SAME("100%% %5%|%s", "");
+	SAME("%f %f %f %f", 0.0, -0.0, 1.0, -1.5);
+	SAME("%f %F %f", 3.14159265358979, 2.5, 1e-7);
+	SAME("%.0f %.0f %.0f %.0f %.0f %.0f", 0.5, 1.5, 2.5, 3.5, -0.5, -2.5);
+	SAME("%.1f %.1f %.1f %.1f", 0.25, 0.35, 0.05, 0.15);
+	SAME("%.2f %.2f %.2f %.3f", 1.005, 2.675, 1.125, 1.0005);
+	SAME("%.0f %.1f %.2f %.3f", 9.5, 9.95, 9.995, 99.9995);
+	SAME("%.0f %.1f %.5f", 999999.5, 0.96, 0.999999);
+	SAME("%f %.0f %.3f", 4294967295.5, 18446744073709549568.0, 18446744073709551616.0);
+	SAME("%f", 1e300);
+	SAME("%.20f", DBL_MAX);
+	SAME("%.10f %f", 123456789012345678.0, 9007199254740993.0);
+	SAME("%.300f", DBL_MIN);
+	SAME("%.330f", 4.9406564584124654e-324);
+	SAME("%.1080f", 4.9406564584124654e-324);
+	SAME("%f %.0f %.17f", DBL_EPSILON, DBL_EPSILON, 0.1);
+	SAME("%.50f %.60f", 0.1, 1.0 / 3.0);
+	SAME("%10.3f|%-10.3f|%010.3f|%+.3f|% .3f|%+010.2f", 3.14159, 3.14159, -3.14159, 3.14159, 3.14159, 2.5);
+	SAME("%#.0f %#.0f %#5.0f|%#f", 1.0, 0.0, 2.0, 1.0);
+	SAME("%*.*f|%.*f|%.*f", 12, 4, 2.71828, -1, 2.71828, 0, 2.71828);
+	SAME("%f %F %f %F", INFINITY, INFINITY, -INFINITY, -INFINITY);
+	SAME("%f %F %f %F", NAN, NAN, -NAN, -NAN);
+	SAME("%10f|%-10f|%010f|%+f|% f|%+F|%010.3F|%.3f", INFINITY, NAN, -INFINITY, INFINITY, NAN, NAN, INFINITY, NAN);
+	SAME("%lf %hf", 0.125, 0.375);
+	SAME("t %d.%02d C p %lu.%02lu Pa", 25, 8, 100653UL, 26UL);
+	check(mismatched == 0, "%u fixed formats match glibc (%u differ)", compared, mismatched);
+
+	/* glibc's handling of a bad conversion differs; these keep the old printf's */
+	fmt = "%y|%";
+	n = bsp_snprintf(got, sizeof(got), fmt, 1);
+	check(n == 4 && strcmp(got, "%y|%") == 0, "unknown conversions print literally (\"%s\")", got);
+	fmt = "%5.2k %lq";
+	n = bsp_snprintf(got, sizeof(got), fmt, 1);
+	check(n == 9 && strcmp(got, "%5.2k %lq") == 0, "with their flags and lengths (\"%s\")", got);
+}
+
+/** @fn static void test_integers(void)
+ * @brief random integer formats against glibc
+ */
+static void test_integers(void)
+{
+	static const char *const lengths[] = { "hh", "h", "", "l", "ll", "z", "j", "t" };
+	static const char convs[] = "diuoxX";
+	char fmt[48], *p;
+	uint64_t v;
+	unsigned int i;
+	int len;
+
+	compared = mismatched = 0;
+
+	for (i = 0; i < FUZZ_INTS; i++)
+	{
+		uint64_t r = rng();
+
+		p = fmt;
+		*p++ = '%';
+		if (r & 1) *p++ = '-';
+		if (r & 2) *p++ = '+';
+		if (r & 4) *p++ = ' ';
+		if (r & 8) *p++ = '#';
+		if (r & 16) *p++ = '0';
+		if (r & 32)
+			p += sprintf(p, "%u", (unsigned int) (r >> 8) % 30);
+		if (r & 64)
+			p += sprintf(p, ".%u", (unsigned int) (r >> 16) % 25);
+		len = (int) ((r >> 24) % 8);
+		p += sprintf(p, "%s%c", lengths[len], convs[(r >> 32) % 6]);
+
+		/* values of every size, with the small ones and 0 common */
+		v = rng() >> (rng() % 64);
+		if ((r >> 40) % 8 == 0)
+			v = 0;
+
+		switch (len)
+		{
+			case 0: case 1: case 2: SAME(fmt, (int) v); break;
+			case 3: SAME(fmt, (long) v); break;
+			case 4: SAME(fmt, (long long) v); break;
+			case 5: SAME(fmt, (size_t) v); break;
+			case 6: SAME(fmt, (intmax_t) v); break;
+			default: SAME(fmt, (ptrdiff_t) v); break;
+		}
+	}
+
+	check(mismatched == 0, "%u random integer formats match glibc (%u differ)", compared, mismatched);
+}
+
+/** @fn static double random_double(void)
+ * @brief a double from any bit pattern, or a short decimal, or a tie
+ */
+static double random_double(void)
+{
+	uint64_t r = rng();
+	union { double d; uint64_t u; } v;
+
+	switch (r % 8)
+	{
+		case 0:
+		case 1:
+			v.u = rng();
+			return v.d;
+		case 2:
+			/* subnormals and the smallest normals */
+			v.u = (rng() >> 11) | ((r >> 8) & 1 ? 0x8000000000000000ULL : 0);
+			return v.d;
+		case 3:
+			return (double) (int64_t) (rng() >> (r % 64)) / pow(10, (double) ((r >> 8) % 10));
+		case 4:
+			/* halves, quarters and so on, exact ties at some precision */
+			return ldexp((double) (rng() >> (12 + (r >> 8) % 50)), -(int) ((r >> 16) % 20));
+		case 5:
+			return (double) (rng() % 100000) + 0.5;
+		case 6:
+			return ldexp((double) (rng() >> 11), (int) ((r >> 8) % 2100) - 1100);
+		default:
+			return (double) (rng() % 1000000) / 1000.0;
+	}
+}
+
+/** @fn static void test_doubles(void)
+ * @brief random %f formats against glibc
+ */
+static void test_doubles(void)
+{
+	char fmt[48], *p;
+	unsigned int i;
+	double d;
+
+	compared = mismatched = 0;
+
+	for (i = 0; i < FUZZ_DOUBLES; i++)
+	{
+		uint64_t r = rng();
+
+		p = fmt;
+		*p++ = '%';
+		if (r & 1) *p++ = '-';
+		if (r & 2) *p++ = '+';
+		if (r & 4) *p++ = ' ';
+		if (r & 8) *p++ = '#';
+		if (r & 16) *p++ = '0';
+		if (r & 32)
+			p += sprintf(p, "%u", (unsigned int) (r >> 8) % 40);
+		if (r & 64)
+			p += sprintf(p, ".%u", (unsigned int) ((r >> 16) % 8 ? (r >> 24) % 21 : (r >> 24) % 120));
+		p += sprintf(p, "%c", (r >> 32) & 1 ? 'F' : 'f');
+
+		d = random_double();
+		{
+			/* the largest doubles print 309 digits and a fraction */
+			char got[1024], want[1024];
+			int got_n = bsp_snprintf(got, sizeof(got), fmt, d);
+			int want_n = snprintf(want, sizeof(want), fmt, d);
+
+			same(fmt, got_n, got, want_n, want);
+		}
+	}
+
+	check(mismatched == 0, "%u random %%f formats match glibc (%u differ)", compared, mismatched);
+}
+
+/** @fn static void test_sizes(void)
+ * @brief snprintf at every size around the length
+ */
+static void test_sizes(void)
+{
+	static const struct { const char *fmt; double d; } cases[] =
+	{
+		{ "%f", 3.14159 }, { "%.0f", 1e22 }, { "%-12.3f|", -2.5 }, { "abc%+08.2fxyz", 1.999 },
+	};
+	char got[80], want[80];
+	unsigned int bad = 0, runs = 0;
+	size_t size, k;
+	int got_n, want_n;
+	unsigned int c;
+
+	for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+	{
+		for (size = 0; size < 40; size++)
+		{
+			memset(got, 'Z', sizeof(got));
+			memset(want, 'Z', sizeof(want));
+			got_n = bsp_snprintf(got, size, cases[c].fmt, cases[c].d);
+			want_n = snprintf(want, size, cases[c].fmt, cases[c].d);
+			runs++;
+
+			if (got_n != want_n || memcmp(got, want, sizeof(got)) != 0)
+				bad++;
+		}
+	}
+
+	for (size = 0; size < 20; size++)
+	{
+		memset(got, 'Z', sizeof(got));
+		got_n = bsp_snprintf(got, size, "%s=%d", "value", 1234567);
+		for (k = size; k < sizeof(got); k++)
+			if (got[k] != 'Z')
+				bad++;
+		if (got_n != 13 || (size && strlen(got) != (size > 14 ? 13 : size - 1)))
+			bad++;
+		runs++;
+	}
+
+	check(bad == 0, "snprintf keeps to every size from 0 up, and returns the full length (%u runs)", runs);
+
+	got_n = bsp_snprintf(NULL, 0, "%d %s", 123, "abc");
+	check(got_n == 7, "snprintf(NULL, 0) returns the length (%d)", got_n);
+	got_n = bsp_sprintf(got, "%05.1f|%x", 2.25, 0xabcU);
+	check(got_n == 9 && strcmp(got, "002.2|abc") == 0, "sprintf (\"%s\")", got);
+}
+
+/** @fn static int call_printf_(const char *fmt, ...)
+ * @brief calls _printf_, as log.c does
+ */
+static void call_printf_(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	_printf_(fmt, ap);
+	va_end(ap);
+}
+
+/** @fn static void test_printf(void)
+ * @brief printf's blocks to a uart that takes all, part or none of them
+ */
+static void test_printf(void)
+{
+	static const char *const modes[] = { "all", "10 bytes", "none" };
+	char want[1024];
+	int mode, got_n, want_n, i;
+	unsigned int blocks;
+
+	for (mode = UART_TAKES_ALL; mode <= UART_TAKES_NONE; mode++)
+	{
+		uart_mode = mode;
+		captured_len = 0;
+		write_calls = putchar_calls = 0;
+
+		got_n = bsp_printf("%s %d %08.3f %llx %-20s|", "The quick brown fox", -12345, 3.14159,
+				   0x123456789abcdefULL, "jumps over the lazy dog, many times over");
+		for (i = 0; i < 10; i++)
+			got_n += bsp_printf("line %d of %d\n", i, 10);
+		want_n = snprintf(want, sizeof(want), "%s %d %08.3f %llx %-20s|", "The quick brown fox", -12345,
+				  3.14159, 0x123456789abcdefULL, "jumps over the lazy dog, many times over");
+		for (i = 0; i < 10; i++)
+			want_n += snprintf(want + want_n, sizeof(want) - (size_t) want_n, "line %d of %d\n", i, 10);
+
+		blocks = 2 + 10;	/* 93 characters, then 10 short lines */
+		check(got_n == want_n && captured_len == (size_t) want_n && memcmp(captured, want, captured_len) == 0 &&
+		      write_calls == blocks &&
+		      putchar_calls == (mode == UART_TAKES_ALL ? 0 : want_n - (mode == UART_TAKES_PART ? 10 * blocks : 0)),
+		      "printf to a uart that takes %s of each block: %d characters, %u uart_write and %u putchar calls",
+		      modes[mode], got_n, write_calls, putchar_calls);
+	}
+
+	uart_mode = UART_TAKES_ALL;
+	captured_len = 0;
+	call_printf_("%s=%u\n", "_printf_", 42U);
+	check(captured_len == 12 && memcmp(captured, "_printf_=42\n", 12) == 0, "_printf_ writes through the same buffer");
+}
+
+/** @fn static void test_util(void)
+ * @brief ftoa and int_to_string, now over the formatter
+ */
+static void test_util(void)
+{
+	char s[64];
+	int n;
+
+	ftoa(3.14159f, s, 3);
+	check(strcmp(s, "3.142") == 0, "ftoa(3.14159, 3) rounds (\"%s\")", s);
+	ftoa(-0.5f, s, 2);
+	check(strcmp(s, "-0.50") == 0, "ftoa(-0.5, 2) (\"%s\")", s);
+	ftoa(25.08f, s, 0);
+	check(strcmp(s, "25") == 0, "ftoa(25.08, 0) has no point (\"%s\")", s);
+	ftoa(0.1f, s, 10);
+	check(strcmp(s, "0.1000000015") == 0, "ftoa(0.1, 10) prints the float's value (\"%s\")", s);
+	n = int_to_string(5, s, 3);
+	check(n == 3 && strcmp(s, "005") == 0, "int_to_string(5, 3) (\"%s\")", s);
+	n = int_to_string(0, s, 0);
+	check(n == 0 && s[0] == '\0', "int_to_string(0, 0) is empty, as before");
+	n = int_to_string(123456, s, 2);
+	check(n == 6 && strcmp(s, "123456") == 0, "int_to_string(123456, 2) (\"%s\")", s);
+}
+
+/** @fn static double now_ns(void)
+ * @brief returns the monotonic clock in ns
+ */
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** @fn static uint64_t ticks(void)
+ * @brief the time stamp counter, or 0 without one
+ */
+static uint64_t ticks(void)
+{
+#ifdef HAVE_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/** @fn static void old_printf(const char *fmt, ...)
+ * @brief calls the old _printf_
+ */
+static void old_printf(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	old_printf_(fmt, ap);
+	va_end(ap);
+}
+
+/* Times BENCH_CALLS calls of one expression, BENCH_RUNS times, and prints the
+   fastest run's ns and cycles per call */
+#define TIME(label, expr) \
+	do { \
+		double best_ns_ = 1e30, best_ticks_ = 1e30, start_; \
+		uint64_t t0_; \
+		unsigned int i_, run_; \
+		for (run_ = 0; run_ < BENCH_RUNS; run_++) \
+		{ \
+			start_ = now_ns(); \
+			t0_ = ticks(); \
+			for (i_ = 0; i_ < BENCH_CALLS; i_++) \
+				expr; \
+			if ((double) (ticks() - t0_) < best_ticks_) \
+				best_ticks_ = (double) (ticks() - t0_); \
+			if (now_ns() - start_ < best_ns_) \
+				best_ns_ = now_ns() - start_; \
+		} \
+		printf("  %-9s %7.1f ns %7.0f cycles", label, best_ns_ / BENCH_CALLS, \
+		       best_ticks_ / BENCH_CALLS); \
+	} while (0)
+
+#define BENCH(fmt, ...) \
+	do { \
+		char buf_[128]; \
+		printf("%-22s\n", "\"" fmt "\":"); \
+		TIME("old", old_printf(fmt, __VA_ARGS__)); \
+		TIME("printf", bsp_printf(fmt, __VA_ARGS__)); \
+		printf("\n"); \
+		TIME("snprintf", bsp_snprintf(buf_, sizeof(buf_), fmt, __VA_ARGS__)); \
+		TIME("glibc", snprintf(buf_, sizeof(buf_), fmt, __VA_ARGS__)); \
+		printf("\n"); \
+	} while (0)
+
+/** @fn static void bench(void)
+ * @brief times the old and new printf, per call
+ */
+static void bench(void)
+{
+	volatile int i = -123456;
+	volatile unsigned int u = 4000000000U;
+	volatile unsigned long long ull = 18446744073709551615ULL;
+	volatile unsigned long ul = 100653UL;
+	volatile double small = 3.14159, large = 12345.678;
+
+	uart_counting = 1;
+	uart_mode = UART_TAKES_ALL;
+	printf("per call on this host, the uart a counter:\n");
+	BENCH("%d", i);
+	BENCH("%u", u);
+	BENCH("%x", u);
+	BENCH("%llu", ull);
+	BENCH("%f", small);
+	BENCH("%f", large);
+	BENCH("temp %d press %lu tick %u\n", i, ul, u);
+	uart_counting = 0;
+}
+
+int main(int argc, char **argv)
+{
+	(void) argv;
+
+	printf("printf.c built for xlen %d\n", TEST_XLEN);
+	test_table();
+	test_integers();
+	test_doubles();
+	test_sizes();
+	test_printf();
+	test_util();
+
+	/* make run times the 64 bit build only */
+	if (argc > 1)
+		bench();
+
+	return check_summary();
+}
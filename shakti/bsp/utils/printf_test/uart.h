@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for bsp/include/uart.h, found first through -I. when
+ * bsp/libs/printf.c is built for printf_test. It declares only what
+ * printf.c uses; printf_test.c defines them and records the output.
+ */
+#ifndef PRINTF_TEST_UART_H
+#define PRINTF_TEST_UART_H
+
+#include <stdint.h>
+
+#define UART_WAIT_FOREVER	0xFFFFFFFFU
+
+typedef struct uart_struct uart_struct;
+
+extern uart_struct *uart_instance[];
+
+uint32_t uart_write(uart_struct *instance, const uint8_t *data, uint32_t len, uint32_t timeout);
+
+#undef putchar
+#define putchar test_putchar
+int test_putchar(int ch);
+
+#endif
@@ -0,0 +1,798 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  qspi_sim.c
+* Brief Description of file             :  Host simulation of the qspi flash for qspi_micron.c.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file qspi_sim.c
+@brief Host simulation of the qspi flash for qspi_micron.c.
+@detail Runs bsp/drivers/qspi/qspi_micron.c, built with QSPI_EXTERNAL_REGS,
+against a model of the qspi controller and a Micron N25Q flash behind it.
+
+The controller has a 32 byte fifo, which may be filled before a write
+command is set up. An indirect command starts when CCR is written, or when
+AR is written if the command has an address. Bytes move
+between the fifo and the flash as time passes: 8 bytes for each read of SR,
+and 1 for every 8 cycles of waitfor(). TCF is set when the last byte has
+moved and stays set until FCR clears it. FTF is set when the fifo has room
+for a threshold of bytes (writes) or holds a threshold (reads). In memory
+mapped mode the flash reads through the STARTMM window.
+
+The flash erases to 0xFF and programming can only clear bits. Program and
+erase need the write enable latch, clear it, and leave the flash busy for a
+few status register reads. A page program wraps at the end of its page.
+
+The model counts every command by kind, and every misuse: fifo overflow and
+underflow, a command started before the last completed, reads or programs
+while the flash is busy, programs without write enable, and programs that
+would need to set a bit that is clear.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_check.h"
+#include "qspi.h"
+#include "utils.h"
+
+#define FLASH_SIZE	(1 << 20)
+#define FIFO_DEPTH	32
+#define BYTES_PER_SR_READ	8
+#define CYCLES_PER_BYTE	8
+#define PROGRAM_POLLS	3
+#define ERASE_POLLS	20
+#define FLASH_ID	0x9d189d18
+
+enum { CMD_ENABLE, CMD_PROGRAM, CMD_ERASE, CMD_STATUS, CMD_READ, CMD_OTHER, CMD_KINDS };
+
+static const char *const cmd_names[CMD_KINDS] = {
+	"write enable", "program", "erase", "status", "read", "other"
+};
+
+typedef struct
+{
+	unsigned long cmds[CMD_KINDS];
+	unsigned long program_bytes;
+	unsigned long read_bytes;
+	unsigned long dr_accesses;
+	unsigned long sr_reads;
+	unsigned long mmap_reads;
+	unsigned long wait_cycles;
+} bus_count_t;
+
+typedef struct
+{
+	unsigned int fifo_overflow;
+	unsigned int fifo_underflow;
+	unsigned int overlap;
+	unsigned int busy_access;
+	unsigned int no_write_enable;
+	unsigned int unerased;
+	unsigned int out_of_range;
+	unsigned int mmap_off;
+} misuse_t;
+
+static uint8_t flash[FLASH_SIZE];
+static int wel;
+static int busy_polls;
+
+static uint32_t reg_cr, reg_dcr, reg_dlr, reg_ccr, reg_ar;
+static int tcf;
+static uint8_t fifo[FIFO_DEPTH];
+static int fifo_level;
+
+/* The command in progress */
+static int active;
+static int cmd_write;
+static int cmd_instr;
+static uint32_t cmd_addr;
+static int cmd_len;
+static int cmd_moved;
+static uint8_t cmd_buf[FLASH_PAGE_SIZE + FIFO_DEPTH];
+
+static bus_count_t bus;
+static misuse_t misuse;
+
+/* Stand-in for what qspi_micron.c uses from log.c. */
+void _printf_(const char *fmt, va_list ap)
+{
+	vprintf(fmt, ap);
+}
+
+static void advance(int bytes);
+
+/** @fn static int is_memory_read(int instr)
+ * @brief tells whether an instruction reads the flash array
+ */
+static int is_memory_read(int instr)
+{
+	switch (instr)
+	{
+	case 0x03: case 0x0B: case 0x0C: case 0x0E: case 0x13:
+	case 0x3B: case 0x6B: case 0xBB: case 0xBE: case 0xEB:
+	case 0xEC: case 0xEE:
+		return 1;
+	}
+	return 0;
+}
+
+/** @fn static int is_program(int instr)
+ * @brief tells whether an instruction is a page program
+ */
+static int is_program(int instr)
+{
+	return instr == 0x02 || instr == 0x12 || instr == 0x32 || instr == 0x34;
+}
+
+/** @fn static int is_erase(int instr)
+ * @brief tells whether an instruction erases
+ */
+static int is_erase(int instr)
+{
+	return instr == 0x20 || instr == 0x21 || instr == 0xD8 || instr == 0xDC;
+}
+
+/** @fn static int in_range(uint32_t addr, int len)
+ * @brief checks that a flash range lies inside the modelled part
+ */
+static int in_range(uint32_t addr, int len)
+{
+	if (addr + (uint32_t) len > FLASH_SIZE)
+	{
+		misuse.out_of_range++;
+		return 0;
+	}
+	return 1;
+}
+
+/** @fn static void complete(void)
+ * @brief ends the command in progress
+ */
+static void complete(void)
+{
+	active = 0;
+	tcf = 1;
+}
+
+/** @fn static void execute_write(void)
+ * @brief carries out a write command once all its bytes have arrived
+ */
+static void execute_write(void)
+{
+	int i;
+
+	if (is_program(cmd_instr))
+	{
+		uint32_t page = cmd_addr & ~(uint32_t) (FLASH_PAGE_SIZE - 1);
+
+		bus.cmds[CMD_PROGRAM]++;
+		bus.program_bytes += (unsigned long) cmd_len;
+		if (busy_polls)
+			misuse.busy_access++;
+		else if (!wel)
+			misuse.no_write_enable++;
+		else if (in_range(page, FLASH_PAGE_SIZE))
+		{
+			for (i = 0; i < cmd_len; i++)
+			{
+				uint32_t at = page + ((cmd_addr + (uint32_t) i) & (FLASH_PAGE_SIZE - 1));
+
+				if (cmd_buf[i] & ~flash[at])
+					misuse.unerased++;
+				flash[at] &= cmd_buf[i];
+			}
+			busy_polls = PROGRAM_POLLS;
+		}
+		wel = 0;
+	}
+	else
+		bus.cmds[CMD_OTHER]++;
+
+	complete();
+}
+
+/** @fn static void start(void)
+ * @brief starts the command set up in CCR, AR and DLR
+ */
+static void start(void)
+{
+	int fmode = (reg_ccr >> 26) & 3;
+	int dmode = (reg_ccr >> 24) & 3;
+	int i;
+
+	if (active)
+		misuse.overlap++;
+
+	active = 1;
+	cmd_instr = reg_ccr & 0xFF;
+	cmd_addr = reg_ar;
+	cmd_len = dmode ? (int) reg_dlr : 0;
+	cmd_moved = 0;
+	cmd_write = (fmode == CCR_FMODE_INDWR);
+	/* Bytes written to DR before the command are kept for it. */
+	if (!cmd_write)
+		fifo_level = 0;
+
+	if (cmd_write && cmd_len == 0)
+	{
+		if (cmd_instr == 0x06)
+		{
+			bus.cmds[CMD_ENABLE]++;
+			wel = !busy_polls;
+		}
+		else if (cmd_instr == 0x04)
+		{
+			bus.cmds[CMD_OTHER]++;
+			wel = 0;
+		}
+		else if (is_erase(cmd_instr))
+		{
+			uint32_t size = (cmd_instr == 0x20 || cmd_instr == 0x21) ? FLASH_SUBSECTOR_SIZE : 65536;
+			uint32_t base = cmd_addr & ~(size - 1);
+
+			bus.cmds[CMD_ERASE]++;
+			if (busy_polls)
+				misuse.busy_access++;
+			else if (!wel)
+				misuse.no_write_enable++;
+			else if (in_range(base, (int) size))
+			{
+				memset(flash + base, 0xFF, size);
+				busy_polls = ERASE_POLLS;
+			}
+			wel = 0;
+		}
+		else
+			bus.cmds[CMD_OTHER]++;
+		complete();
+		return;
+	}
+
+	if (cmd_write)
+		return;
+
+	/* A read: work out the bytes the flash will send. */
+	if (cmd_instr == 0x05)
+	{
+		bus.cmds[CMD_STATUS]++;
+		memset(cmd_buf, (busy_polls ? 3 : 0) | (wel ? 2 : 0), sizeof(cmd_buf));
+		if (busy_polls)
+			busy_polls--;
+	}
+	else if (cmd_instr == 0x90 || cmd_instr == 0x9E)
+	{
+		uint32_t id = FLASH_ID;
+
+		bus.cmds[CMD_OTHER]++;
+		for (i = 0; i < (int) sizeof(cmd_buf); i++)
+			cmd_buf[i] = (uint8_t) (id >> ((i & 3) * 8));
+	}
+	else if (is_memory_read(cmd_instr))
+	{
+		bus.cmds[CMD_READ]++;
+		bus.read_bytes += (unsigned long) cmd_len;
+		if (busy_polls)
+			misuse.busy_access++;
+	}
+	else
+	{
+		bus.cmds[CMD_OTHER]++;
+		memset(cmd_buf, 0, sizeof(cmd_buf));
+	}
+
+	advance(0);
+}
+
+/** @fn static void advance(int bytes)
+ * @brief lets time for a number of bytes pass on the bus
+ */
+static void advance(int bytes)
+{
+	if (!active)
+		return;
+
+	if (cmd_write)
+	{
+		while (bytes-- > 0 && fifo_level > 0)
+		{
+			if (cmd_moved < (int) sizeof(cmd_buf))
+				cmd_buf[cmd_moved] = fifo[0];
+			cmd_moved++;
+			memmove(fifo, fifo + 1, (size_t) --fifo_level);
+		}
+		if (cmd_moved >= cmd_len)
+			execute_write();
+		return;
+	}
+
+	while (bytes-- > 0 && cmd_moved < cmd_len && fifo_level < FIFO_DEPTH)
+	{
+		uint8_t byte;
+
+		if (is_memory_read(cmd_instr))
+			byte = in_range(cmd_addr + (uint32_t) cmd_moved, 1) ? flash[cmd_addr + (uint32_t) cmd_moved] : 0;
+		else
+			byte = cmd_buf[cmd_moved % (int) sizeof(cmd_buf)];
+		fifo[fifo_level++] = byte;
+		cmd_moved++;
+	}
+	if (cmd_moved >= cmd_len)
+		complete();
+}
+
+/** @fn static int threshold(void)
+ * @brief returns the fifo threshold set in CR
+ */
+static int threshold(void)
+{
+	return (int) ((reg_cr >> 8) & 0x1F) + 1;
+}
+
+void set_qspi_shakti32(int* addr, int val)
+{
+	uint32_t value = (uint32_t) val;
+
+	if (addr == cr)
+	{
+		reg_cr = value & ~(uint32_t) CR_ABORT;
+		if (value & CR_ABORT)
+		{
+			active = 0;
+			fifo_level = 0;
+			reg_ccr = 0;
+		}
+	}
+	else if (addr == dcr)
+		reg_dcr = value;
+	else if (addr == dlr)
+		reg_dlr = value;
+	else if (addr == fcr)
+	{
+		if (value & FCR_CTCF)
+			tcf = 0;
+	}
+	else if (addr == ccr)
+	{
+		reg_ccr = value;
+		if (((value >> 26) & 3) != CCR_FMODE_MMAPD && ((value >> 10) & 3) == NDATA)
+			start();
+	}
+	else if (addr == ar)
+	{
+		reg_ar = value;
+		if (((reg_ccr >> 26) & 3) != CCR_FMODE_MMAPD && ((reg_ccr >> 10) & 3) != NDATA)
+			start();
+	}
+	else if (addr == dr)
+	{
+		int i;
+
+		bus.dr_accesses++;
+		for (i = 0; i < 4; i++)
+		{
+			if ((active && !cmd_write) || fifo_level == FIFO_DEPTH)
+			{
+				misuse.fifo_overflow++;
+				break;
+			}
+			if (active && cmd_moved + fifo_level >= cmd_len)
+				break;
+			fifo[fifo_level++] = (uint8_t) (value >> (i * 8));
+		}
+	}
+}
+
+void set_qspi_shakti16(int16_t* addr, int16_t val)
+{
+	(void) addr;
+	(void) val;
+	misuse.fifo_overflow++;
+}
+
+void set_qspi_shakti8(char* addr, char val)
+{
+	if ((int*) addr != dr)
+	{
+		set_qspi_shakti32((int*) addr, (uint8_t) val);
+		return;
+	}
+
+	bus.dr_accesses++;
+	if ((active && !cmd_write) || fifo_level == FIFO_DEPTH)
+		misuse.fifo_overflow++;
+	else if (!active || cmd_moved + fifo_level < cmd_len)
+		fifo[fifo_level++] = (uint8_t) val;
+}
+
+int get_qspi_shakti(int* addr)
+{
+	uintptr_t at = (uintptr_t) addr;
+
+	if (at >= STARTMM && at <= ENDMM)
+	{
+		uint32_t offset = (uint32_t) (at - STARTMM);
+		uint32_t word = 0;
+		int i;
+
+		bus.mmap_reads++;
+		if (((reg_ccr >> 26) & 3) != CCR_FMODE_MMAPD)
+		{
+			misuse.mmap_off++;
+			return 0;
+		}
+		if (!in_range(offset, 4))
+			return 0;
+		for (i = 0; i < 4; i++)
+			word |= (uint32_t) flash[offset + (uint32_t) i] << (i * 8);
+		return (int) word;
+	}
+
+	if (addr == sr)
+	{
+		int free_bytes;
+		uint32_t value = 0;
+
+		bus.sr_reads++;
+		advance(BYTES_PER_SR_READ);
+		free_bytes = FIFO_DEPTH - fifo_level;
+		if (tcf)
+			value |= SR_TCF;
+		if (active && (cmd_write ? free_bytes >= threshold() : fifo_level >= threshold()))
+			value |= SR_FTF;
+		return (int) (value | SR_FLEVEL((uint32_t) fifo_level));
+	}
+
+	if (addr == dr)
+	{
+		uint32_t word = 0;
+		int i;
+
+		bus.dr_accesses++;
+		if (fifo_level == 0)
+		{
+			misuse.fifo_underflow++;
+			return 0;
+		}
+		for (i = 0; i < 4 && fifo_level > 0; i++)
+		{
+			word |= (uint32_t) fifo[0] << (i * 8);
+			memmove(fifo, fifo + 1, (size_t) --fifo_level);
+		}
+		return (int) word;
+	}
+
+	if (addr == cr)
+		return (int) reg_cr;
+	if (addr == dcr)
+		return (int) reg_dcr;
+	if (addr == ccr)
+		return (int) reg_ccr;
+	if (addr == dlr)
+		return (int) reg_dlr;
+	if (addr == ar)
+		return (int) reg_ar;
+	return 0;
+}
+
+void waitfor(unsigned int secs)
+{
+	bus.wait_cycles += secs;
+	advance((int) (secs / CYCLES_PER_BYTE));
+}
+
+/** @fn static void check_misuse(void)
+ * @brief checks that nothing was done that the hardware would not allow
+ */
+static void check_misuse(void)
+{
+	check(misuse.fifo_overflow == 0 && misuse.fifo_underflow == 0 && misuse.overlap == 0 &&
+	      misuse.busy_access == 0 && misuse.no_write_enable == 0 && misuse.unerased == 0 &&
+	      misuse.out_of_range == 0 && misuse.mmap_off == 0,
+	      "no misuse (fifo %u/%u, overlap %u, busy %u, wel %u, unerased %u, range %u, mmap %u)",
+	      misuse.fifo_overflow, misuse.fifo_underflow, misuse.overlap, misuse.busy_access,
+	      misuse.no_write_enable, misuse.unerased, misuse.out_of_range, misuse.mmap_off);
+	memset(&misuse, 0, sizeof(misuse));
+}
+
+/** @fn static void print_bus(const char *what)
+ * @brief prints and clears the bus counts
+ */
+static void print_bus(const char *what)
+{
+	int i;
+
+	printf("  %s:", what);
+	for (i = 0; i < CMD_KINDS; i++)
+		printf(" %s %lu,", cmd_names[i], bus.cmds[i]);
+	printf(" sr reads %lu, dr accesses %lu, waitfor cycles %lu\n",
+	       bus.sr_reads, bus.dr_accesses, bus.wait_cycles);
+}
+
+/** @fn static unsigned long total_cmds(void)
+ * @brief returns the number of commands sent since the counts were cleared
+ */
+static unsigned long total_cmds(void)
+{
+	unsigned long total = 0;
+	int i;
+
+	for (i = 0; i < CMD_KINDS; i++)
+		total += bus.cmds[i];
+	return total;
+}
+
+/** @fn static void fill(uint8_t *buf, int len, unsigned int seed)
+ * @brief fills a buffer with a pattern that differs for each seed
+ */
+static void fill(uint8_t *buf, int len, unsigned int seed)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (uint8_t) (i * 31 + seed * 7 + (i >> 8));
+}
+
+/** @fn static void reset(void)
+ * @brief erases the flash and resets the controller and counts
+ */
+static void reset(void)
+{
+	memset(flash, 0xFF, sizeof(flash));
+	wel = 0;
+	busy_polls = 0;
+	reg_ccr = reg_ar = reg_dlr = 0;
+	tcf = 0;
+	active = 0;
+	fifo_level = 0;
+	memset(&bus, 0, sizeof(bus));
+	memset(&misuse, 0, sizeof(misuse));
+
+	qspi_init(27,0,3,1,15,1);
+	flashCacheInvalidate(0, FLASH_SIZE);
+}
+
+static void test_deploy(void)
+{
+	static uint8_t data[FLASH_SUBSECTOR_SIZE];
+	unsigned long old_cmds, old_cycles;
+	int words[4];
+	int i;
+
+	fill(data, sizeof(data), 1);
+
+	/* The way deploy programmed the flash before: 16 bytes at a time. */
+	reset();
+	memset(flash, 0, FLASH_SUBSECTOR_SIZE);
+	eraseSector(0x21, 0);
+	for (i = 0; i < (int) sizeof(data); i += 16)
+	{
+		memcpy(words, data + i, 16);
+		pageProgramQuadSPI(words[0], words[1], words[2], words[3], i);
+	}
+	check(memcmp(flash, data, sizeof(data)) == 0, "16 byte programs write 4 KB");
+	print_bus("16 byte programs");
+	old_cmds = total_cmds();
+	old_cycles = bus.wait_cycles;
+	check_misuse();
+
+	reset();
+	memset(flash, 0, FLASH_SUBSECTOR_SIZE);
+	check(flashWriteQuadSPI(0, data, sizeof(data), 1) == 0 &&
+	      memcmp(flash, data, sizeof(data)) == 0, "flashWriteQuadSPI writes the same 4 KB");
+	print_bus("page programs");
+	check(bus.cmds[CMD_PROGRAM] == sizeof(data) / FLASH_PAGE_SIZE && bus.cmds[CMD_ERASE] == 1,
+	      "with %lu page programs and %lu erase", bus.cmds[CMD_PROGRAM], bus.cmds[CMD_ERASE]);
+	check(total_cmds() * 8 < old_cmds && bus.wait_cycles == 0,
+	      "%lu commands against %lu, and no waitfor (%lu cycles before)",
+	      total_cmds(), old_cmds, old_cycles);
+	check_misuse();
+}
+
+static void test_write_ranges(void)
+{
+	static uint8_t data[10000];
+	static uint8_t shadow[3 * FLASH_SUBSECTOR_SIZE];
+	uint32_t base = 0x10000;
+	int page_programs;
+
+	reset();
+	fill(data, sizeof(data), 2);
+
+	/* Leave old data where the write goes, for the erase to clear. */
+	memset(flash + base, 0x5A, sizeof(shadow));
+	check(flashWriteQuadSPI((int) base, data, sizeof(data), 1) == 0 &&
+	      memcmp(flash + base, data, sizeof(data)) == 0,
+	      "10000 bytes over old data are erased ahead and written");
+	memset(shadow, 0xFF, sizeof(shadow));
+	check(memcmp(flash + base + sizeof(data), shadow, sizeof(shadow) - sizeof(data)) == 0,
+	      "the rest of the last subsector is left erased");
+	check(bus.cmds[CMD_ERASE] == 3, "three subsectors are erased (%lu)", bus.cmds[CMD_ERASE]);
+	check_misuse();
+
+	memset(&bus, 0, sizeof(bus));
+	page_programs = (0x2345 % FLASH_PAGE_SIZE + 700 + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
+	check(flashWriteQuadSPI(0x2345, data, 700, 0) == 0 &&
+	      memcmp(flash + 0x2345, data, 700) == 0 && flash[0x2344] == 0xFF && flash[0x2345 + 700] == 0xFF,
+	      "700 bytes from 0x2345 are split at page boundaries");
+	check(bus.cmds[CMD_PROGRAM] == (unsigned long) page_programs && bus.cmds[CMD_ERASE] == 0,
+	      "in %lu page programs, without erasing", bus.cmds[CMD_PROGRAM]);
+	check_misuse();
+
+	memset(&bus, 0, sizeof(bus));
+	check(flashPageProgramQuadSPI(0x30F0, data, 32) == -1 && total_cmds() == 0,
+	      "a page program across a page boundary is refused");
+	check(flashPageProgramQuadSPI(0x3000, data, 0) == -1 && total_cmds() == 0,
+	      "and so is an empty one");
+	check_misuse();
+}
+
+static void test_reads(void)
+{
+	static uint8_t buf[600];
+	int bad = 0;
+	int len;
+
+	reset();
+	fill(flash, FLASH_SIZE, 3);
+
+	for (len = 1; len <= 300; len += 7)
+	{
+		int ddr;
+
+		for (ddr = 0; ddr < 2; ddr++)
+		{
+			uint32_t addr = (uint32_t) (len * 37 + ddr * 3);
+
+			memset(buf, 0, sizeof(buf));
+			memset(&bus, 0, sizeof(bus));
+			if (flashReadQuadSPIBuffer((int) addr, buf, len, ddr) != 0 ||
+			    memcmp(buf, flash + addr, (size_t) len) != 0 || buf[len] != 0 ||
+			    bus.cmds[CMD_READ] != 1 || total_cmds() != 1)
+				bad++;
+		}
+	}
+	check(bad == 0, "quad and DDR reads of 1 to 300 bytes each take one command (%d wrong)", bad);
+	check_misuse();
+}
+
+static void test_cache(void)
+{
+	uint8_t config[64];
+	uint8_t again[64];
+	uint8_t update[16];
+	flash_cache_stats_t before, after;
+
+	reset();
+	fill(flash, FLASH_SIZE, 4);
+	flashCacheStats(&before);
+
+	flashCachedRead(0x3010, config, sizeof(config));
+	memset(&bus, 0, sizeof(bus));
+	flashCachedRead(0x3010, again, sizeof(again));
+	flashCacheStats(&after);
+
+	check(memcmp(config, flash + 0x3010, sizeof(config)) == 0 &&
+	      memcmp(again, config, sizeof(config)) == 0, "a cached read returns the flash");
+	check(total_cmds() == 0 && after.hits - before.hits == 3,
+	      "and a second read is served from the cache (%lu commands)", total_cmds());
+
+	fill(update, sizeof(update), 5);
+	flashWriteQuadSPI(0x3000, flash + 0x3000, 0x20, 1);
+	flashWriteQuadSPI(0x3020, update, sizeof(update), 0);
+	flashCacheStats(&after);
+	flashCachedRead(0x3010, again, sizeof(again));
+
+	check(memcmp(again, flash + 0x3010, sizeof(again)) == 0 && memcmp(again + 0x10, update, sizeof(update)) == 0,
+	      "writes drop the lines under them (%u invalidated)", after.invalidations - before.invalidations);
+	check_misuse();
+}
+
+static void test_random(void)
+{
+	static uint8_t shadow[16 * FLASH_SUBSECTOR_SIZE];
+	static uint8_t buf[2 * FLASH_PAGE_SIZE];
+	flash_cache_stats_t stats;
+	int bad = 0;
+	int round;
+
+	reset();
+	srand(1);
+	memset(shadow, 0xFF, sizeof(shadow));
+
+	for (round = 0; round < 3000; round++)
+	{
+		int len = rand() % (int) sizeof(buf) + 1;
+		int addr = rand() % ((int) sizeof(shadow) - len);
+
+		switch (rand() % 4)
+		{
+		case 0:
+			/* Rewrite a whole subsector. */
+			addr &= ~(FLASH_SUBSECTOR_SIZE - 1);
+			fill(buf, len, (unsigned int) round);
+			memset(shadow + addr, 0xFF, FLASH_SUBSECTOR_SIZE);
+			memcpy(shadow + addr, buf, (size_t) len);
+			if (flashWriteQuadSPI(addr, buf, len, 1))
+				bad++;
+			break;
+		case 1:
+			if (flashReadQuadSPIBuffer(addr, buf, len, rand() % 2) ||
+			    memcmp(buf, shadow + addr, (size_t) len) != 0)
+				bad++;
+			break;
+		default:
+			len = len % 48 + 1;
+			if (flashCachedRead(addr, buf, len) || memcmp(buf, shadow + addr, (size_t) len) != 0)
+				bad++;
+			break;
+		}
+	}
+
+	flashCacheStats(&stats);
+	check(bad == 0 && memcmp(flash, shadow, sizeof(shadow)) == 0,
+	      "3000 random writes, reads and cached reads agree with a copy (%d wrong)", bad);
+	printf("  cache: %u hits, %u misses, %u invalidations\n", stats.hits, stats.misses, stats.invalidations);
+	check_misuse();
+}
+
+static void test_xip(void)
+{
+	uint8_t data[100];
+	uint8_t buf[100];
+	int word;
+
+	reset();
+	fill(flash, FLASH_SIZE, 6);
+
+	flashQuadSPIXip(0x40, &word);
+	memset(&bus, 0, sizeof(bus));
+
+	check(flashXipActive(), "the controller is in XIP mode");
+	check(flashReadQuadSPIBuffer(0x123, buf, sizeof(buf), 0) == 0 &&
+	      memcmp(buf, flash + 0x123, sizeof(buf)) == 0 && total_cmds() == 0 && bus.mmap_reads > 0,
+	      "reads go through the memory mapped window");
+
+	fill(data, sizeof(data), 7);
+	check(flashWriteQuadSPI(0x2000, data, sizeof(data), 1) == -1 && total_cmds() == 0,
+	      "writes are refused");
+	check_misuse();
+
+	micron_disable_xip_volatile(0,0);
+	check(!flashXipActive() && flashWriteQuadSPI(0x2000, data, sizeof(data), 1) == 0 &&
+	      memcmp(flash + 0x2000, data, sizeof(data)) == 0, "and allowed once XIP is left");
+	check_misuse();
+}
+
+int main(void)
+{
+	printf("qspi_micron.c with a %d line read cache of %d bytes each\n",
+	       QSPI_CACHE_LINES, QSPI_CACHE_LINE_SIZE);
+
+	test_deploy();
+	test_write_ranges();
+	test_reads();
+	test_cache();
+	test_random();
+	test_xip();
+
+	return check_summary();
+}
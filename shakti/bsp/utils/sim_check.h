@@ -0,0 +1,70 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  sim_check.h
+* Brief Description of file             :  Check reporting shared by the host simulations.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file sim_check.h
+@brief Check reporting shared by the host simulations.
+@detail Each check prints "ok" or "FAIL" and a description. A simulation
+ends by returning check_summary() from main(), which prints the number of
+failed checks and makes it the exit status, so make run stops at the first
+simulation that fails. Include it from the one file that holds main().
+*/
+
+#ifndef SIM_CHECK_H
+#define SIM_CHECK_H
+
+#include <stdarg.h>
+#include <stdio.h>
+
+static unsigned int check_failures;
+
+/** @fn static void check(int ok, const char *fmt, ...)
+ * @brief prints the result of a check
+ * @param int ok - nonzero if the check passed
+ * @param const char *fmt - printf format describing it
+ */
+static void check(int ok, const char *fmt, ...)
+{
+	va_list ap;
+
+	printf("%s ", ok ? "ok  " : "FAIL");
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	printf("\n");
+
+	if (!ok)
+		check_failures++;
+}
+
+/** @fn static int check_summary(void)
+ * @brief prints the number of failed checks
+ * @return the number of failed checks
+ */
+static int check_summary(void)
+{
+	printf("%u failed\n", check_failures);
+	return (int) check_failures;
+}
+
+#endif
@@ -0,0 +1,622 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  spi_flash_sim.c
+* Brief Description of file             :  Host simulation of the spi flash block layer.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file spi_flash_sim.c
+@brief Host simulation of the spi flash block layer.
+@detail Runs bsp/drivers/spi/spi_flash_block.c over spi_flash_w25q32.c
+(FLASH_W25Q32) or spi_spansion.c (FLASH_SPANSION), both built with
+SPI_EXTERNAL_REGS, against a model of the spi controller and a NOR flash.
+
+A transfer starts when CR1 is written with SPE set. It sends the first bytes
+of DR1..DR4, first byte in the top of DR1, and shifts the bytes it receives
+into DR5. It takes one tick per bit: each read of SR is 8 ticks and waitfor(n)
+is n ticks. BSY is set until it ends, when RXNE is set if bytes were received.
+
+The flash erases to 0xFF and programming can only clear bits. Program and
+erase need the write enable latch, clear it, and keep WIP set for a few
+status reads. A program wraps at the end of its 256 byte page.
+
+The model counts transfers by kind and every misuse: a transfer started while
+the controller is busy, programs or erases without write enable, anything but
+a status read while the flash is busy, a program that would need to set a bit
+that is clear, and addresses past the end of the flash.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_check.h"
+#include "spi.h"
+#include "spi_flash_block.h"
+#include "utils.h"
+
+#if defined(FLASH_W25Q32)
+#define PART		"W25Q32"
+#define FLASH_SIZE	(4 * 1024 * 1024)
+#define ADDR_BYTES	3
+#define OP_PROGRAM	0x02
+#define OP_READ		0x03
+#define OP_FAST_READ	0x0B
+#define OP_ERASE_4K	0x20
+#define OP_ERASE_64K	0xD8
+#define PART_OPS	w25q32_flash_ops
+#elif defined(FLASH_SPANSION)
+#define PART		"Spansion"
+#define FLASH_SIZE	(32 * 1024 * 1024)
+#define ADDR_BYTES	4
+#define OP_PROGRAM	0x12
+#define OP_READ		0x13
+#define OP_FAST_READ	0x0C
+#define OP_ERASE_4K	0x21
+#define OP_ERASE_64K	0xDC
+#define PART_OPS	spansion_flash_ops
+#else
+#error "Build with FLASH_W25Q32 or FLASH_SPANSION"
+#endif
+
+#define PAGE_SIZE	256
+#define PROGRAM_POLLS	3
+#define ERASE_POLLS	30
+
+/* The register pointers of the driver */
+extern uint32_t *spi_cr1, *spi_sr;
+extern uint32_t *spi_dr1, *spi_dr2, *spi_dr3, *spi_dr4, *spi_dr5;
+
+enum { XFER_ENABLE, XFER_PROGRAM, XFER_ERASE, XFER_STATUS, XFER_READ, XFER_OTHER, XFER_KINDS };
+
+static const char *const xfer_names[XFER_KINDS] = {
+	"write enable", "program", "erase", "status", "read", "other"
+};
+
+typedef struct
+{
+	unsigned long xfers[XFER_KINDS];
+	unsigned long ticks;
+} bus_count_t;
+
+typedef struct
+{
+	unsigned int overlap;
+	unsigned int no_write_enable;
+	unsigned int busy_access;
+	unsigned int unerased;
+	unsigned int out_of_range;
+} misuse_t;
+
+static uint8_t *flash;
+static int wel;
+static int busy_polls;
+
+static uint32_t reg_dr[5];
+static unsigned long xfer_end;
+static int xfer_rx;
+static int rxne;
+
+static bus_count_t bus;
+static misuse_t misuse;
+
+/* Stand-in for what the drivers use from log.c. */
+void _printf_(const char *fmt, va_list ap)
+{
+	vprintf(fmt, ap);
+}
+
+/** @fn static int in_range(uint32_t addr, uint32_t len)
+ * @brief checks that a flash range lies inside the modelled part
+ */
+static int in_range(uint32_t addr, uint32_t len)
+{
+	if (addr > FLASH_SIZE || len > FLASH_SIZE - addr)
+	{
+		misuse.out_of_range++;
+		return 0;
+	}
+	return 1;
+}
+
+/** @fn static uint32_t get_address(const uint8_t *tx)
+ * @brief returns the address that follows the opcode
+ */
+static uint32_t get_address(const uint8_t *tx)
+{
+	uint32_t addr = 0;
+	int i;
+
+	for (i = 0; i < ADDR_BYTES; i++)
+		addr = (addr << 8) | tx[1 + i];
+	return addr;
+}
+
+/** @fn static int writable(void)
+ * @brief checks that a program or erase may start, and clears WEL
+ */
+static int writable(void)
+{
+	int ok = 1;
+
+	if (busy_polls)
+	{
+		misuse.busy_access++;
+		ok = 0;
+	}
+	else if (!wel)
+	{
+		misuse.no_write_enable++;
+		ok = 0;
+	}
+	wel = 0;
+	return ok;
+}
+
+/** @fn static void transfer(int tx_len, int rx_len)
+ * @brief carries out one transfer on the flash
+ */
+static void transfer(int tx_len, int rx_len)
+{
+	uint8_t tx[20];
+	uint8_t rx[32];
+	int i;
+
+	memset(rx, 0, sizeof(rx));
+	for (i = 0; i < 20; i++)
+		tx[i] = (uint8_t) (reg_dr[i / 4] >> (24 - 8 * (i % 4)));
+
+	if (tx_len == 0)
+		return;
+
+	if (busy_polls && tx[0] != 0x05)
+		misuse.busy_access++;
+
+	switch (tx[0])
+	{
+	case 0x06:
+		bus.xfers[XFER_ENABLE]++;
+		wel = !busy_polls;
+		break;
+	case 0x04:
+		bus.xfers[XFER_OTHER]++;
+		wel = 0;
+		break;
+	case 0x05:
+		bus.xfers[XFER_STATUS]++;
+		memset(rx, (busy_polls ? 1 : 0) | (wel ? 2 : 0), sizeof(rx));
+		if (busy_polls)
+			busy_polls--;
+		break;
+	case 0x9F:
+		bus.xfers[XFER_OTHER]++;
+		rx[0] = 0xEF;
+		rx[1] = 0x40;
+		rx[2] = 0x16;
+		break;
+	case OP_PROGRAM:
+	{
+		uint32_t addr = get_address(tx);
+		uint32_t page = addr & ~(uint32_t) (PAGE_SIZE - 1);
+
+		bus.xfers[XFER_PROGRAM]++;
+		if (writable() && in_range(page, PAGE_SIZE))
+		{
+			for (i = 1 + ADDR_BYTES; i < tx_len; i++)
+			{
+				uint8_t *at = flash + page + ((addr + (uint32_t) (i - 1 - ADDR_BYTES)) & (PAGE_SIZE - 1));
+
+				if (tx[i] & ~*at)
+					misuse.unerased++;
+				*at &= tx[i];
+			}
+			busy_polls = PROGRAM_POLLS;
+		}
+		break;
+	}
+	case OP_ERASE_4K:
+	case OP_ERASE_64K:
+	{
+		uint32_t size = tx[0] == OP_ERASE_4K ? 4096 : 65536;
+		uint32_t base = get_address(tx) & ~(size - 1);
+
+		bus.xfers[XFER_ERASE]++;
+		if (writable() && in_range(base, size))
+		{
+			memset(flash + base, 0xFF, size);
+			busy_polls = ERASE_POLLS;
+		}
+		break;
+	}
+	case OP_READ:
+	case OP_FAST_READ:
+	{
+		uint32_t addr = get_address(tx);
+
+		bus.xfers[XFER_READ]++;
+		if (in_range(addr, (uint32_t) rx_len))
+			memcpy(rx, flash + addr, (size_t) rx_len);
+		break;
+	}
+	default:
+		bus.xfers[XFER_OTHER]++;
+		break;
+	}
+
+	if (rx_len)
+	{
+		reg_dr[4] = 0;
+		for (i = 0; i < rx_len; i++)
+			reg_dr[4] = (reg_dr[4] << 8) | rx[i];
+	}
+}
+
+void set_spi(uint32_t* addr, uint32_t val)
+{
+	if (addr == spi_dr1 || addr == spi_dr2 || addr == spi_dr3 || addr == spi_dr4 || addr == spi_dr5)
+	{
+		reg_dr[addr - spi_dr1] = val;
+		return;
+	}
+
+	if (addr == spi_cr1 && (val & SPI_SPE))
+	{
+		int tx_bits = (int) ((val >> 16) & 0xFF);
+		int rx_bits = (int) ((val >> 24) & 0xFF);
+
+		if (bus.ticks < xfer_end)
+			misuse.overlap++;
+		xfer_end = bus.ticks + (unsigned long) (tx_bits + rx_bits);
+		xfer_rx = rx_bits > 0;
+		rxne = 0;
+		transfer(tx_bits / 8, rx_bits / 8);
+	}
+}
+
+uint32_t get_spi(uint32_t* addr)
+{
+	if (addr == spi_sr)
+	{
+		uint32_t sr = 0;
+
+		bus.ticks += 8;
+		if (bus.ticks < xfer_end)
+			sr |= SPI_BSY;
+		else if (xfer_rx)
+		{
+			rxne = 1;
+			xfer_rx = 0;
+		}
+		if (rxne)
+			sr |= RXNE;
+		return sr;
+	}
+
+	if (addr == spi_dr5)
+	{
+		rxne = 0;
+		return reg_dr[4];
+	}
+
+	if (addr == spi_dr1 || addr == spi_dr2 || addr == spi_dr3 || addr == spi_dr4)
+		return reg_dr[addr - spi_dr1];
+	return 0;
+}
+
+void waitfor(unsigned int secs)
+{
+	bus.ticks += secs;
+}
+
+/** @fn static void check_misuse(void)
+ * @brief checks that nothing was done that the flash would not allow
+ */
+static void check_misuse(void)
+{
+	check(misuse.overlap == 0 && misuse.no_write_enable == 0 && misuse.busy_access == 0 &&
+	      misuse.unerased == 0 && misuse.out_of_range == 0,
+	      "no misuse (overlap %u, wel %u, busy %u, unerased %u, range %u)",
+	      misuse.overlap, misuse.no_write_enable, misuse.busy_access, misuse.unerased,
+	      misuse.out_of_range);
+	memset(&misuse, 0, sizeof(misuse));
+}
+
+/** @fn static unsigned long total_xfers(void)
+ * @brief returns the transfers made since the counts were cleared
+ */
+static unsigned long total_xfers(void)
+{
+	unsigned long total = 0;
+	int i;
+
+	for (i = 0; i < XFER_KINDS; i++)
+		total += bus.xfers[i];
+	return total;
+}
+
+/** @fn static void print_bus(const char *what)
+ * @brief prints the bus counts
+ */
+static void print_bus(const char *what)
+{
+	int i;
+
+	printf("  %s:", what);
+	for (i = 0; i < XFER_KINDS; i++)
+		printf(" %s %lu,", xfer_names[i], bus.xfers[i]);
+	printf(" ticks %lu\n", bus.ticks);
+}
+
+/** @fn static void clear_bus(void)
+ * @brief clears the bus counts, keeping the time of the transfer in progress
+ */
+static void clear_bus(void)
+{
+	unsigned long left = xfer_end > bus.ticks ? xfer_end - bus.ticks : 0;
+
+	memset(&bus, 0, sizeof(bus));
+	xfer_end = left;
+}
+
+/** @fn static void fill(uint8_t *buf, uint32_t len, unsigned int seed)
+ * @brief fills a buffer with a pattern that differs for each seed
+ */
+static void fill(uint8_t *buf, uint32_t len, unsigned int seed)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (uint8_t) (i * 13 + seed * 101 + (i >> 8) + (i >> 16));
+}
+
+/** @fn static void reset(void)
+ * @brief erases the flash and clears the counts
+ */
+static void reset(void)
+{
+	memset(flash, 0xFF, FLASH_SIZE);
+	wel = 0;
+	busy_polls = 0;
+	xfer_end = 0;
+	xfer_rx = 0;
+	rxne = 0;
+	memset(&bus, 0, sizeof(bus));
+	memset(&misuse, 0, sizeof(misuse));
+}
+
+static void test_record(void)
+{
+	static uint8_t record[4096];
+	static uint8_t back[4096];
+	flash_block_t dev;
+	uint32_t base = 0x20000;
+	unsigned long old_xfers, old_ticks;
+	uint32_t i;
+
+	fill(record, sizeof(record), 1);
+
+	/* A 4 KB record one word at a time, as the uploader writes. */
+	reset();
+	flash_write_enable();
+	flash_erase(base);
+	flash_status_register_read();
+	for (i = 0; i < sizeof(record); i += 4)
+	{
+		uint32_t word = (uint32_t) record[i] << 24 | (uint32_t) record[i + 1] << 16 |
+				(uint32_t) record[i + 2] << 8 | record[i + 3];
+
+		flash_write_enable();
+		flash_write(base + i, word);
+		flash_status_register_read();
+	}
+	check(memcmp(flash + base, record, sizeof(record)) == 0, "word writes store the record");
+	print_bus("word writes");
+	old_xfers = total_xfers();
+	old_ticks = bus.ticks;
+	check_misuse();
+
+	reset();
+	flash_block_init(&dev, &PART_OPS, NULL);
+	check(flash_block_erase(&dev, base, PART_OPS.sector_size) == 0 &&
+	      flash_block_write(&dev, base, record, sizeof(record)) == 0 &&
+	      flash_block_sync(&dev) == 0 && memcmp(flash + base, record, sizeof(record)) == 0,
+	      "the block layer stores the same record");
+	print_bus("block layer");
+	check(dev.stats.programs == sizeof(record) / FLASH_BLOCK_PAGE_SIZE && dev.stats.erases == 1 &&
+	      dev.stats.reads == 0, "with %u page programs, %u erase and no reads",
+	      dev.stats.programs, dev.stats.erases);
+	check(total_xfers() * 2 < old_xfers && bus.ticks * 4 < old_ticks,
+	      "in %lu transfers and %lu ticks, against %lu and %lu", total_xfers(), bus.ticks,
+	      old_xfers, old_ticks);
+	check_misuse();
+
+	clear_bus();
+	for (i = 0; i < sizeof(back); i += 4)
+	{
+		uint32_t word = flash_read(base + i);
+
+		back[i] = (uint8_t) (word >> 24);
+		back[i + 1] = (uint8_t) (word >> 16);
+		back[i + 2] = (uint8_t) (word >> 8);
+		back[i + 3] = (uint8_t) word;
+	}
+	check(memcmp(back, record, sizeof(record)) == 0, "word reads return the record");
+	print_bus("word reads");
+	old_ticks = bus.ticks;
+
+	clear_bus();
+	memset(back, 0, sizeof(back));
+	flash_block_init(&dev, &PART_OPS, NULL);
+	check(flash_block_read(&dev, base, back, sizeof(back)) == 0 &&
+	      memcmp(back, record, sizeof(record)) == 0 && dev.stats.reads == 1,
+	      "a block read of the record is one bulk read");
+	print_bus("block read");
+	check(bus.ticks < old_ticks, "in %lu ticks against %lu", bus.ticks, old_ticks);
+	check_misuse();
+}
+
+static void test_coalescing(void)
+{
+	static uint8_t data[4096];
+	flash_block_t dev;
+	uint32_t i;
+
+	reset();
+	fill(data, sizeof(data), 2);
+	flash_block_init(&dev, &PART_OPS, NULL);
+
+	/* 64 byte appends into an erased area fill the pages before they go out */
+	for (i = 0; i < sizeof(data); i += 64)
+		flash_block_write(&dev, 0x1000 + i, data + i, 64);
+	check(flash_block_sync(&dev) == 0 && memcmp(flash + 0x1000, data, sizeof(data)) == 0,
+	      "64 byte appends reach the flash");
+	check(dev.stats.programs == sizeof(data) / FLASH_BLOCK_PAGE_SIZE,
+	      "as %u page programs", dev.stats.programs);
+	check_misuse();
+
+	/* Clearing bits needs no erase */
+	flash_block_init(&dev, &PART_OPS, NULL);
+	memset(data, 0, 16);
+	check(flash_block_write(&dev, 0x1010, data, 16) == 0 && flash_block_sync(&dev) == 0 &&
+	      dev.stats.erases == 0 && flash[0x1010] == 0 && flash[0x101F] == 0,
+	      "writes that only clear bits are programmed in place");
+
+	/* Setting bits needs an erase, which needs a sector buffer */
+	memset(data, 0xA5, 16);
+	check(flash_block_write(&dev, 0x1010, data, 16) == 0 && flash_block_sync(&dev) == -1 &&
+	      dev.stats.need_erase > 0 && flash[0x1010] == 0,
+	      "writes that set bits fail without a sector buffer");
+	check(flash_block_erase(&dev, 0x1010 & ~(PART_OPS.sector_size - 1), PART_OPS.sector_size) == 0 &&
+	      flash_block_sync(&dev) == 0 &&
+	      flash[0x1010] == 0xFF, "an erase drops the failed write");
+	check_misuse();
+}
+
+static void test_erase_queue(void)
+{
+	static uint8_t data[3 * FLASH_BLOCK_PAGE_SIZE];
+	uint8_t byte;
+	flash_block_t dev;
+	uint32_t sector = PART_OPS.sector_size;
+
+	reset();
+	memset(flash + sector, 0, 2 * sector);
+	flash_block_init(&dev, &PART_OPS, NULL);
+
+	check(flash_block_erase(&dev, sector, 2 * sector) == 0 && total_xfers() == 0,
+	      "an erase is queued");
+	check(flash_block_read(&dev, sector + 5, &byte, 1) == 0 && byte == 0xFF && dev.stats.reads == 0,
+	      "its sectors read as erased without touching the flash");
+
+	fill(data, sizeof(data), 3);
+	check(flash_block_write(&dev, sector + 100, data, sizeof(data)) == 0 &&
+	      flash_block_sync(&dev) == 0, "a write into the first sector syncs");
+	check(memcmp(flash + sector + 100, data, sizeof(data)) == 0 && flash[sector + 99] == 0xFF &&
+	      flash[2 * sector] == 0xFF && flash[3 * sector - 1] == 0xFF && dev.stats.erases == 2 &&
+	      dev.stats.reads == 0, "and both sectors are erased once, with no reads");
+	check(flash_block_erase(&dev, sector + 1, sector) == -1 && flash_block_erase(&dev, FLASH_SIZE, sector) == -1,
+	      "unaligned erases and erases past the end are refused");
+	check(flash_block_write(&dev, FLASH_SIZE - 4, data, 8) == -1 && flash_block_read(&dev, FLASH_SIZE, data, 1) == -1,
+	      "and so are accesses past the end");
+	check_misuse();
+}
+
+static void test_random(int with_buffer)
+{
+	static uint8_t shadow[8 * 65536];
+	static uint8_t buf[3000];
+	uint8_t *sector_buf = with_buffer ? malloc(PART_OPS.sector_size) : NULL;
+	uint32_t area = sizeof(shadow);
+	flash_block_t dev;
+	int bad = 0;
+	int round;
+
+	reset();
+	srand(with_buffer + 7);
+	memset(shadow, 0xFF, sizeof(shadow));
+	flash_block_init(&dev, &PART_OPS, sector_buf);
+
+	for (round = 0; round < 4000; round++)
+	{
+		uint32_t len = (uint32_t) rand() % sizeof(buf) + 1;
+		uint32_t addr = (uint32_t) rand() % (area - len);
+		uint32_t i;
+
+		switch (rand() % 10)
+		{
+		case 0:
+			addr &= ~(PART_OPS.sector_size - 1);
+			if (flash_block_erase(&dev, addr, PART_OPS.sector_size))
+				bad++;
+			memset(shadow + addr, 0xFF, PART_OPS.sector_size);
+			break;
+		case 1:
+			if (flash_block_sync(&dev) || memcmp(flash, shadow, area) != 0)
+				bad++;
+			break;
+		case 2: case 3: case 4:
+			fill(buf, len, (unsigned int) round);
+			if (!with_buffer)
+			{
+				/* Without a sector buffer, only clear bits. */
+				for (i = 0; i < len; i++)
+					buf[i] &= shadow[addr + i];
+			}
+			if (flash_block_write(&dev, addr, buf, len))
+				bad++;
+			memcpy(shadow + addr, buf, len);
+			break;
+		default:
+			if (rand() % 2)
+				len = len % 40 + 1;
+			if (flash_block_read(&dev, addr, buf, len) || memcmp(buf, shadow + addr, len) != 0)
+				bad++;
+			break;
+		}
+	}
+
+	if (flash_block_sync(&dev) || memcmp(flash, shadow, area) != 0)
+		bad++;
+	check(bad == 0, "4000 random writes, erases, reads and syncs %s a sector buffer agree with a copy (%d wrong)",
+	      with_buffer ? "with" : "without", bad);
+	printf("  %u hits, %u misses, %u programs, %u erases, %u sector rewrites\n",
+	       dev.stats.cache_hits, dev.stats.cache_misses, dev.stats.programs, dev.stats.erases,
+	       dev.stats.sector_rewrites);
+	check_misuse();
+	free(sector_buf);
+}
+
+int main(void)
+{
+	flash = malloc(FLASH_SIZE);
+	if (!flash)
+		return 1;
+
+	printf("%s, %u byte sectors, %d cached pages\n", PART, PART_OPS.sector_size, FLASH_BLOCK_CACHE_PAGES);
+
+	test_record();
+	test_coalescing();
+	test_erase_queue();
+	test_random(0);
+	test_random(1);
+
+	free(flash);
+	return check_summary();
+}
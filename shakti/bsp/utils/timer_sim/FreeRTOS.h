@@ -0,0 +1,21 @@
+/* Host stand-in for the parts of the FreeRTOS API that clint_timer.c uses.
+ * The calls are implemented in timer_sim.c, whose kernel ticks at 500 Hz
+ * as the demos' does. */
+#ifndef TIMER_SIM_FREERTOS_H
+#define TIMER_SIM_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+
+#define configTICK_RATE_HZ		((TickType_t) 500)
+#define taskSCHEDULER_SUSPENDED		((BaseType_t) 0)
+#define taskSCHEDULER_NOT_STARTED	((BaseType_t) 1)
+#define taskSCHEDULER_RUNNING		((BaseType_t) 2)
+
+BaseType_t xTaskGetSchedulerState(void);
+void vTaskDelay(const TickType_t xTicksToDelay);
+void vApplicationTickHook(void);
+
+#endif
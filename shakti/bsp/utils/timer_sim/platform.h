@@ -0,0 +1,29 @@
+/* Host stand-in for the SoC platform.h. It takes the vajra memory map and
+ * moves the clint's mtime and mtimecmp, mcycle, mstatus and mie into
+ * timer_sim.c. */
+#ifndef TIMER_SIM_PLATFORM_H
+#define TIMER_SIM_PLATFORM_H
+
+#include <stdint.h>
+#include "../../third_party/vajra/platform.h"
+
+uint32_t clint_sim_read32(uintptr_t addr);
+void clint_sim_write32(uintptr_t addr, uint32_t value);
+uint64_t clint_sim_read64(uintptr_t addr);
+void clint_sim_write64(uintptr_t addr, uint64_t value);
+#define clint_read32(addr)		clint_sim_read32((uintptr_t) (addr))
+#define clint_write32(addr, value)	clint_sim_write32((uintptr_t) (addr), (value))
+#define clint_read64(addr)		clint_sim_read64((uintptr_t) (addr))
+#define clint_write64(addr, value)	clint_sim_write64((uintptr_t) (addr), (value))
+
+enum { SIM_CSR_mcycle, SIM_CSR_mstatus, SIM_CSR_mie };
+uintptr_t sim_csr_read(int csr);
+void sim_csr_write(int csr, uintptr_t value);
+void sim_csr_set(int csr, uintptr_t bits);
+void sim_csr_clear(int csr, uintptr_t bits);
+#define read_csr(reg)		sim_csr_read(SIM_CSR_##reg)
+#define write_csr(reg, val)	sim_csr_write(SIM_CSR_##reg, (uintptr_t) (val))
+#define set_csr(reg, bit)	sim_csr_set(SIM_CSR_##reg, (uintptr_t) (bit))
+#define clear_csr(reg, bit)	sim_csr_clear(SIM_CSR_##reg, (uintptr_t) (bit))
+
+#endif
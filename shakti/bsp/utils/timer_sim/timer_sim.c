@@ -0,0 +1,666 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  timer_sim.c
+* Brief Description of file             :  Host simulation of the clint and core for clint_timer.c.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file timer_sim.c
+@brief Host simulation of the clint and core for clint_timer.c.
+@detail Runs bsp/drivers/clint/clint_timer.c against a simulated core at
+48 MHz, not the 50 MHz of CLOCK_FREQUENCY, so that timer_init() has to
+measure it. mtime counts at CLINT_MTIME_HZ from the core's cycles. Time
+only passes as the driver works: each clint access costs CLINT_COST cycles
+and each csr access one. A clint read samples mtime as it starts, so two
+32 bit reads of it can tear as on the board.
+
+Bare metal, the machine timer interrupt is taken whenever mstatus.MIE and
+mie.MTIE are set and mtime has reached mtimecmp. With CLINT_TIMER_FREERTOS
+a kernel ticks at 500 Hz, calling vApplicationTickHook(), and vTaskDelay()
+passes time until the tick that wakes the caller as another task would.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim_check.h"
+#include "clint_timer.h"
+#include "defines.h"
+#include "traps.h"
+#ifdef CLINT_TIMER_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
+#define SIM_CPU_HZ		48000000
+#define CYCLES_PER_TICK		(SIM_CPU_HZ / CLINT_MTIME_HZ)
+#define CLINT_COST		12
+#define KERNEL_TICK		(CLINT_MTIME_HZ / 500)	/* mtime ticks per kernel tick */
+
+#ifdef CLINT_TIMER_FREERTOS
+#define MODE			"FreeRTOS"
+#define ALARM_LATE_MAX		(KERNEL_TICK + 1)
+#define SPIN_WHEN		"before the scheduler starts"
+#else
+#define MODE			"bare metal"
+#define ALARM_LATE_MAX		1
+#define SPIN_WHEN		"in a bare metal build"
+#endif
+
+mtrap_fptr_t mcause_interrupt_table[MAX_INTERRUPT_VALUE];
+
+static uint64_t cycles;
+static uint64_t mtime_base;		/* mtime at cycle 0 */
+static uint64_t mtimecmp = UINT64_MAX;
+static uintptr_t mstatus = MSTATUS_MIE;
+static uintptr_t mie;
+static int in_trap;
+static unsigned int timer_traps;
+static unsigned int cmp_writes;
+
+#ifdef CLINT_TIMER_FREERTOS
+static BaseType_t scheduler = taskSCHEDULER_NOT_STARTED;
+static uint64_t next_kernel_tick;	/* mtime of the next tick */
+static uint32_t kernel_ticks;
+static uint64_t blocked_cycles;
+#endif
+
+static uint64_t sim_mtime(void)
+{
+	return mtime_base + cycles / CYCLES_PER_TICK;
+}
+
+/** @fn static void take_interrupts(void)
+ * @brief takes the interrupts that are raised and enabled
+ */
+static void take_interrupts(void)
+{
+	if (in_trap || !(mstatus & MSTATUS_MIE))
+		return;
+
+#ifdef CLINT_TIMER_FREERTOS
+	while (scheduler == taskSCHEDULER_RUNNING && sim_mtime() >= next_kernel_tick)
+	{
+		next_kernel_tick += KERNEL_TICK;
+		kernel_ticks++;
+
+		in_trap = 1;
+		mstatus &= ~MSTATUS_MIE;
+		vApplicationTickHook();
+		mstatus |= MSTATUS_MIE;
+		in_trap = 0;
+	}
+#endif
+
+	while ((mie & MIE_MTIE) && sim_mtime() >= mtimecmp)
+	{
+		if (++timer_traps > 10000000)
+		{
+			printf("the timer interrupt is never cleared\n");
+			exit(1);
+		}
+
+		in_trap = 1;
+		mstatus &= ~MSTATUS_MIE;
+		mcause_interrupt_table[MACH_TIMER_INTERRUPT](MACH_TIMER_INTERRUPT, 0);
+		mstatus |= MSTATUS_MIE;
+		in_trap = 0;
+	}
+}
+
+static void advance(uint64_t n)
+{
+	cycles += n;
+	take_interrupts();
+}
+
+static uint64_t clint_value(uintptr_t addr)
+{
+	if ((addr & ~(uintptr_t) 7) == MTIME)
+		return sim_mtime();
+	if ((addr & ~(uintptr_t) 7) == MTIMECMP)
+		return mtimecmp;
+
+	printf("clint access to %#lx\n", (unsigned long) addr);
+	exit(1);
+}
+
+uint32_t clint_sim_read32(uintptr_t addr)
+{
+	uint64_t value = clint_value(addr);
+
+	advance(CLINT_COST);
+
+	return addr & 4 ? (uint32_t) (value >> 32) : (uint32_t) value;
+}
+
+uint64_t clint_sim_read64(uintptr_t addr)
+{
+	uint64_t value = clint_value(addr);
+
+	advance(CLINT_COST);
+
+	return value;
+}
+
+void clint_sim_write32(uintptr_t addr, uint32_t value)
+{
+	if (addr == MTIMECMP)
+		mtimecmp = (mtimecmp & 0xFFFFFFFF00000000ULL) | value;
+	else if (addr == MTIMECMP + 4)
+		mtimecmp = (mtimecmp & 0xFFFFFFFFULL) | ((uint64_t) value << 32);
+	else
+	{
+		printf("clint write to %#lx\n", (unsigned long) addr);
+		exit(1);
+	}
+
+	cmp_writes++;
+	advance(CLINT_COST);
+}
+
+void clint_sim_write64(uintptr_t addr, uint64_t value)
+{
+	if (addr != MTIMECMP)
+	{
+		printf("clint write to %#lx\n", (unsigned long) addr);
+		exit(1);
+	}
+
+	mtimecmp = value;
+	cmp_writes++;
+	advance(CLINT_COST);
+}
+
+uintptr_t sim_csr_read(int csr)
+{
+	uintptr_t value;
+
+	switch (csr)
+	{
+		case SIM_CSR_mcycle:
+			value = (uintptr_t) cycles;
+			break;
+		case SIM_CSR_mie:
+			value = mie;
+			break;
+		default:
+			value = mstatus;
+			break;
+	}
+
+	advance(1);
+
+	return value;
+}
+
+void sim_csr_write(int csr, uintptr_t value)
+{
+	if (csr == SIM_CSR_mie)
+		mie = value;
+	else if (csr == SIM_CSR_mstatus)
+		mstatus = value;
+
+	advance(1);
+}
+
+void sim_csr_set(int csr, uintptr_t bits)
+{
+	sim_csr_write(csr, sim_csr_read(csr) | bits);
+}
+
+void sim_csr_clear(int csr, uintptr_t bits)
+{
+	sim_csr_write(csr, sim_csr_read(csr) & ~bits);
+}
+
+#ifdef CLINT_TIMER_FREERTOS
+BaseType_t xTaskGetSchedulerState(void)
+{
+	return scheduler;
+}
+
+/** @fn void vTaskDelay(const TickType_t xTicksToDelay)
+ * @brief passes time until the tick that wakes the caller
+ */
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+	uint32_t wake = kernel_ticks + xTicksToDelay;
+	uint64_t start = cycles;
+
+	if (!(mstatus & MSTATUS_MIE) || scheduler != taskSCHEDULER_RUNNING)
+	{
+		printf("vTaskDelay() where it cannot block\n");
+		exit(1);
+	}
+
+	while ((int32_t) (kernel_ticks - wake) < 0)
+		advance(CYCLES_PER_TICK / 4);
+
+	blocked_cycles += cycles - start;
+}
+
+void vApplicationTickHook(void)
+{
+	timer_alarm_tick();
+}
+
+static void start_scheduler(void)
+{
+	scheduler = taskSCHEDULER_RUNNING;
+	next_kernel_tick = (sim_mtime() / KERNEL_TICK + 1) * KERNEL_TICK;
+}
+#endif
+
+/** @fn static void idle_until(uint64_t mtime)
+ * @brief passes time as an idle loop would, until mtime
+ */
+static void idle_until(uint64_t mtime)
+{
+	while (sim_mtime() < mtime)
+		advance(8);
+}
+
+static void test_conversions(void)
+{
+	check(timer_us_to_ticks(0) == 0 && timer_us_to_ticks(1) == 1 &&
+	      timer_us_to_ticks(2) == 1 && timer_us_to_ticks(3) == 2 &&
+	      timer_us_to_ticks(1000000) == 500000 &&
+	      timer_us_to_ticks(UINT32_MAX) == 2147483648ULL,
+	      "microseconds convert to mtime ticks rounding up");
+}
+
+static void test_calibration(void)
+{
+	uint32_t lo = UINT32_MAX, hi = 0, hz;
+	int phase;
+
+	check(timer_cpu_hz() == CLOCK_FREQUENCY,
+	      "before timer_init() the clock is the nominal %u Hz", timer_cpu_hz());
+
+	for (phase = 0; phase < 2 * CYCLES_PER_TICK; phase += 7)
+	{
+		advance(phase);
+		timer_init();
+		hz = timer_cpu_hz();
+		if (hz < lo)
+			lo = hz;
+		if (hz > hi)
+			hi = hz;
+	}
+
+	check(lo >= SIM_CPU_HZ && hi <= SIM_CPU_HZ + SIM_CPU_HZ / 500,
+	      "timer_init() measures the 48 MHz core at %u to %u Hz, never under", lo, hi);
+	check(mstatus & MSTATUS_MIE, "and enables interrupts again");
+
+#ifdef CLINT_TIMER_FREERTOS
+	check(mcause_interrupt_table[MACH_TIMER_INTERRUPT] == NULL && mie == 0 &&
+	      cmp_writes == 0, "and leaves mtimecmp and the timer interrupt to the kernel");
+#else
+	check(mcause_interrupt_table[MACH_TIMER_INTERRUPT] != NULL && (mie & MIE_MTIE) &&
+	      mtimecmp == UINT64_MAX, "and takes the timer interrupt, with nothing due");
+#endif
+}
+
+static void test_ndelay(void)
+{
+	static const uint32_t ns[] = { 0, 1, 20, 21, 100, 999, 1000, 12345, 250000, 1000000 };
+	unsigned int i, phase, bad = 0;
+	uint64_t start, took, need, worst = 0;
+
+	for (phase = 0; phase < 5; phase++)
+	{
+		for (i = 0; i < sizeof(ns) / sizeof(ns[0]); i++)
+		{
+			advance(phase);
+			need = ((uint64_t) ns[i] * SIM_CPU_HZ + 999999999) / 1000000000;
+			start = cycles;
+			ndelay(ns[i]);
+			took = cycles - start;
+
+			if (took < need || took > need + need / 500 + 8)
+				bad++;
+			else if (took - need > worst)
+				worst = took - need;
+		}
+	}
+
+	check(bad == 0, "ndelay() is never short and at most 0.2%% and 8 cycles long "
+	      "(%u wrong, at most %u cycles over)", bad, (unsigned int) worst);
+}
+
+static void test_udelay(void)
+{
+	static const uint32_t us[] = { 0, 1, 2, 10, 100, 999, 1000, 1001, 1500, 2000,
+				       12345, 100000 };
+	static const uint32_t ms[] = { 1, 3, 10 };
+	unsigned int i, phase, bad = 0;
+	uint64_t start, took, need;
+
+	for (phase = 0; phase < CYCLES_PER_TICK; phase += 13)
+	{
+		for (i = 0; i < sizeof(us) / sizeof(us[0]); i++)
+		{
+			advance(phase);
+			need = (uint64_t) us[i] * (SIM_CPU_HZ / 1000000);
+			start = cycles;
+			udelay(us[i]);
+			took = cycles - start;
+
+			if (took < need || took > need + need / 500 + 2 * CYCLES_PER_TICK + 64)
+				bad++;
+		}
+
+		for (i = 0; i < sizeof(ms) / sizeof(ms[0]); i++)
+		{
+			advance(phase);
+			need = (uint64_t) ms[i] * (SIM_CPU_HZ / 1000);
+			start = cycles;
+			mdelay(ms[i]);
+			took = cycles - start;
+
+			if (took < need || took > need + 2 * CYCLES_PER_TICK + 64)
+				bad++;
+		}
+	}
+
+	check(bad == 0, "udelay() and mdelay() are never short and at most two mtime "
+	      "ticks long (%u wrong)", bad);
+}
+
+static void test_sleep(void)
+{
+	timer_stats_t before, after;
+	uint64_t start, took;
+
+	timer_get_stats(&before);
+	start = cycles;
+	timer_sleep_us(5000);
+	took = cycles - start;
+	timer_get_stats(&after);
+
+	check(took >= 5000ULL * 48 && took <= 5000ULL * 48 + 2 * CYCLES_PER_TICK + 64 &&
+	      after.yields == before.yields,
+	      "timer_sleep_us() spins %s", SPIN_WHEN);
+
+#ifdef CLINT_TIMER_FREERTOS
+	uint64_t blocked;
+
+	start_scheduler();
+
+	timer_get_stats(&before);
+	blocked = blocked_cycles;
+	start = cycles;
+	timer_sleep_us(10000);
+	took = cycles - start;
+	blocked = blocked_cycles - blocked;
+	timer_get_stats(&after);
+
+	check(took >= 10000ULL * 48 && took <= 10000ULL * 48 + 2 * CYCLES_PER_TICK + 200,
+	      "a task's 10 ms timer_sleep_us() takes %u us", (unsigned int) (took / 48));
+	check(after.yields > before.yields && took - blocked <= KERNEL_TICK * CYCLES_PER_TICK + 200,
+	      "and sleeps through %u us of it in %u vTaskDelay() calls",
+	      (unsigned int) (blocked / 48), after.yields - before.yields);
+
+	timer_get_stats(&before);
+	start = cycles;
+	timer_sleep_ms(7);
+	took = cycles - start;
+	timer_get_stats(&after);
+	check(took >= 7000ULL * 48 && took <= 7000ULL * 48 + 2 * CYCLES_PER_TICK + 200 &&
+	      after.yields > before.yields, "timer_sleep_ms(7) sleeps too");
+
+	timer_get_stats(&before);
+	timer_sleep_us(800);
+	clear_csr(mstatus, MSTATUS_MIE);
+	timer_sleep_us(5000);
+	set_csr(mstatus, MSTATUS_MIE);
+	timer_get_stats(&after);
+	check(after.yields == before.yields,
+	      "but spins below a tick's worth and with interrupts disabled");
+#endif
+}
+
+struct record
+{
+	timer_alarm_t alarm;
+	int id;
+	int calls;
+	uint64_t at;
+	uint64_t period;
+	int repeat;
+};
+
+static int order[64];
+static unsigned int order_count;
+
+static void record_alarm(void *arg)
+{
+	struct record *rec = arg;
+
+	rec->calls++;
+	rec->at = sim_mtime();
+	if (order_count < sizeof(order) / sizeof(order[0]))
+		order[order_count++] = rec->id;
+
+	if (rec->repeat > 1)
+	{
+		rec->repeat--;
+		timer_alarm_start_at(&rec->alarm, rec->alarm.deadline + rec->period);
+	}
+}
+
+static void test_alarm_order(void)
+{
+	static const uint32_t us[] = { 3000, 1000, 2000, 1000, 5000 };
+	struct record rec[5];
+	timer_stats_t before, after;
+	unsigned int i, late_bad = 0;
+	uint64_t deadline[5];
+	int cancelled, again;
+
+	timer_get_stats(&before);
+	order_count = 0;
+
+	for (i = 0; i < 5; i++)
+	{
+		rec[i].id = i;
+		rec[i].calls = 0;
+		rec[i].repeat = 0;
+		timer_alarm_init(&rec[i].alarm, record_alarm, &rec[i]);
+		timer_alarm_start(&rec[i].alarm, us[i]);
+		deadline[i] = rec[i].alarm.deadline;
+	}
+
+	cancelled = timer_alarm_cancel(&rec[4].alarm);
+	again = timer_alarm_cancel(&rec[4].alarm);
+	idle_until(deadline[4] + 2 * KERNEL_TICK);
+
+	for (i = 0; i < 4; i++)
+		if (rec[i].calls != 1 || rec[i].at < deadline[i] ||
+		    rec[i].at - deadline[i] > ALARM_LATE_MAX)
+			late_bad++;
+
+	timer_get_stats(&after);
+
+	check(order_count == 4 && order[0] == 1 && order[1] == 3 && order[2] == 2 &&
+	      order[3] == 0, "alarms are called by deadline, ties in the order started");
+	check(late_bad == 0, "each once, no earlier than its deadline and at most %u ticks "
+	      "after", ALARM_LATE_MAX);
+	check(cancelled == 1 && again == 0 && rec[4].calls == 0,
+	      "a cancelled alarm is not called, and a second cancel returns 0");
+	check(after.fired - before.fired == 4, "the stats count 4 alarms");
+}
+
+static void test_alarm_periodic(void)
+{
+	struct record rec = { .id = 7, .period = 500, .repeat = 5 };
+	uint64_t first;
+
+	order_count = 0;
+	timer_alarm_init(&rec.alarm, record_alarm, &rec);
+	timer_alarm_start(&rec.alarm, 1000);
+	first = rec.alarm.deadline;
+	idle_until(first + 5 * 500 + 2 * KERNEL_TICK);
+
+	check(rec.calls == 5 && rec.alarm.deadline == first + 4 * 500 && !rec.alarm.pending &&
+	      rec.at - rec.alarm.deadline <= ALARM_LATE_MAX,
+	      "an alarm started again from its function runs 5 times without drift");
+}
+
+static void test_alarm_past_and_moved(void)
+{
+	struct record past = { .id = 1 }, moved = { .id = 2 };
+	uint64_t deadline;
+
+	order_count = 0;
+	timer_alarm_init(&past.alarm, record_alarm, &past);
+	clear_csr(mstatus, MSTATUS_MIE);
+	timer_alarm_start_at(&past.alarm, sim_mtime() - 100);
+	advance(10 * CYCLES_PER_TICK);
+	check(past.calls == 0, "an alarm whose deadline has passed waits for interrupts");
+	deadline = sim_mtime();
+	set_csr(mstatus, MSTATUS_MIE);
+	idle_until(deadline + 2 * KERNEL_TICK);
+	check(past.calls == 1 && past.at - deadline <= ALARM_LATE_MAX,
+	      "and is then called within %u ticks", ALARM_LATE_MAX);
+
+	timer_alarm_init(&moved.alarm, record_alarm, &moved);
+	timer_alarm_start(&moved.alarm, 1000);
+	timer_alarm_start(&moved.alarm, 3000);
+	deadline = moved.alarm.deadline;
+	idle_until(deadline + 2 * KERNEL_TICK);
+	check(moved.calls == 1 && moved.at >= deadline,
+	      "an alarm started again while pending is moved, not doubled");
+}
+
+static void test_alarm_random(void)
+{
+	struct record rec[8];
+	uint64_t deadline[8], last;
+	unsigned int round, i, bad = 0, fired = 0;
+	int started[8];
+
+	srand(50);
+
+	for (round = 0; round < 200; round++)
+	{
+		order_count = 0;
+		last = sim_mtime();
+
+		for (i = 0; i < 8; i++)
+		{
+			rec[i].id = i;
+			rec[i].calls = 0;
+			rec[i].repeat = 0;
+			timer_alarm_init(&rec[i].alarm, record_alarm, &rec[i]);
+			started[i] = rand() % 4 != 0;
+			if (started[i])
+			{
+				timer_alarm_start(&rec[i].alarm, rand() % 6000);
+				deadline[i] = rec[i].alarm.deadline;
+			}
+		}
+
+		for (i = 0; i < 8; i++)
+			if (started[i] && rand() % 5 == 0)
+				started[i] = !timer_alarm_cancel(&rec[i].alarm);
+
+		idle_until(sim_mtime() + 3000 + 2 * KERNEL_TICK);
+
+		for (i = 0; i < 8; i++)
+		{
+			if (rec[i].calls != started[i])
+				bad++;
+			else if (started[i] && (rec[i].at < deadline[i] ||
+						rec[i].at - deadline[i] > ALARM_LATE_MAX))
+				bad++;
+			fired += rec[i].calls;
+		}
+
+		for (i = 0; i < order_count; i++)
+		{
+			if (deadline[order[i]] < last)
+				bad++;
+			last = deadline[order[i]];
+		}
+	}
+
+	check(bad == 0, "200 rounds of random starts and cancels call %u alarms in order "
+	      "and on time (%u wrong)", fired, bad);
+#ifdef CLINT_TIMER_FREERTOS
+	check(cmp_writes == 0, "the kernel's mtimecmp is never written");
+#else
+	check(mtimecmp == UINT64_MAX, "with nothing pending mtimecmp is left at its maximum");
+#endif
+}
+
+static void test_mtime_carry(void)
+{
+	unsigned int i, bad = 0, torn = 0;
+	uint64_t before, now, after;
+	uint32_t hi, lo;
+
+#ifdef CLINT_TIMER_FREERTOS
+	scheduler = taskSCHEDULER_NOT_STARTED;
+#endif
+
+	for (i = 0; i < 4 * CYCLES_PER_TICK; i++)
+	{
+		advance(1);
+		mtime_base = 0xFFFFFFFFULL - cycles / CYCLES_PER_TICK;
+		before = sim_mtime();
+		now = timer_now();
+		after = sim_mtime();
+		if (now < before || now > after)
+			bad++;
+	}
+
+	for (i = 0; i < CYCLES_PER_TICK; i++)
+	{
+		advance(1);
+		mtime_base = 0xFFFFFFFFULL - cycles / CYCLES_PER_TICK;
+		hi = clint_sim_read32(MTIME + 4);
+		lo = clint_sim_read32(MTIME);
+		if ((((uint64_t) hi << 32) | lo) < 0xFFFFFFFFULL)
+			torn++;
+	}
+
+	check(bad == 0, "timer_now() reads mtime whole as its low word carries "
+	      "(%u wrong, where a high then low read tore %u times)", bad, torn);
+}
+
+int main(void)
+{
+	printf("clint_timer.c, %d bit, %s\n", __riscv_xlen, MODE);
+
+	test_conversions();
+	test_calibration();
+	test_ndelay();
+	test_udelay();
+	test_sleep();
+	test_alarm_order();
+	test_alarm_periodic();
+	test_alarm_past_and_moved();
+	test_alarm_random();
+	test_mtime_carry();
+
+	return check_summary();
+}
@@ -0,0 +1,32 @@
+/* Host stand-in for the parts of the FreeRTOS API that uart.c uses. The
+ * calls are implemented in uart_sim.c, where a task that waits lets the
+ * simulated uarts run until it is notified or its timeout passes. */
+#ifndef UART_SIM_FREERTOS_H
+#define UART_SIM_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint64_t TickType_t;
+typedef long BaseType_t;
+typedef void *TaskHandle_t;
+typedef struct
+{
+	TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+#define pdFALSE			((BaseType_t) 0)
+#define pdTRUE			((BaseType_t) 1)
+#define portMAX_DELAY		((TickType_t) ~(TickType_t) 0)
+#define taskSCHEDULER_SUSPENDED	((BaseType_t) 0)
+#define taskSCHEDULER_NOT_STARTED	((BaseType_t) 1)
+#define taskSCHEDULER_RUNNING	((BaseType_t) 2)
+#define portYIELD_FROM_ISR(x)	((void) (x))
+
+BaseType_t xTaskGetSchedulerState(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken);
+void vTaskSetTimeOutState(TimeOut_t *pxTimeOut);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *pxTimeOut, TickType_t *pxTicksToWait);
+
+#endif
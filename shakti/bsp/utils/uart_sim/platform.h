@@ -0,0 +1,28 @@
+/* Host stand-in for the SoC platform.h. It takes the vajra memory map and
+ * moves the uarts' registers and mstatus into uart_sim.c. */
+#ifndef UART_SIM_PLATFORM_H
+#define UART_SIM_PLATFORM_H
+
+#include <stdint.h>
+#include "../../third_party/vajra/platform.h"
+
+extern uint32_t uart_sim_regs[];
+#undef UART0_START
+#define UART0_START ((uintptr_t) uart_sim_regs)
+
+uint32_t uart_sim_status(const void *instance);
+void uart_sim_write_tx(const void *instance, uint32_t ch);
+uint32_t uart_sim_read_rx(const void *instance);
+#define uart_read_status(instance)	uart_sim_status(instance)
+#define uart_write_tx(instance, ch)	uart_sim_write_tx(instance, (uint32_t) (ch))
+#define uart_read_rx(instance)	uart_sim_read_rx(instance)
+
+enum { SIM_CSR_mstatus };
+uintptr_t sim_csr_read(int csr);
+void sim_csr_set(int csr, uintptr_t bits);
+void sim_csr_clear(int csr, uintptr_t bits);
+#define read_csr(reg)		sim_csr_read(SIM_CSR_##reg)
+#define set_csr(reg, bit)	sim_csr_set(SIM_CSR_##reg, (uintptr_t) (bit))
+#define clear_csr(reg, bit)	sim_csr_clear(SIM_CSR_##reg, (uintptr_t) (bit))
+
+#endif
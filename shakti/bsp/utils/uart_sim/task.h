@@ -0,0 +1,2 @@
+/* Host stand-in for task.h; everything is in the stand-in FreeRTOS.h. */
+#include "FreeRTOS.h"
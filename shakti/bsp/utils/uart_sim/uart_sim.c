@@ -0,0 +1,743 @@
+/***************************************************************************
+* Project           			:  shakti devt board
+* Name of the file	     		:  uart_sim.c
+* Brief Description of file             :  Host simulation of the uarts for uart.c.
+* Name of Author    	                :
+* Email ID                              :
+
+ Copyright (C) 2019  IIT Madras. All rights reserved.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+***************************************************************************/
+/**
+@file uart_sim.c
+@brief Host simulation of the uarts for uart.c.
+@detail Runs the buffered uart_write, uart_read and uart_buffered_isr from
+bsp/drivers/uart/uart.c against a model of the uart registers. Each uart has
+16 byte tx and rx fifos. Time passes in character times: in each one a uart
+sends a byte from its tx fifo to the wire and takes the next byte of its
+input into its rx fifo, or flags an overrun if the fifo is full. The status
+register is computed from the fifos, and the interrupt is level triggered
+from the status and ien. The hart takes an interrupt whenever mstatus.MIE is
+set and a uart's interrupt is raised.
+
+There is a single task. When it waits on its notification the uarts run
+until the isr notifies it or its timeout passes. A tick is 20 character
+times. Polling the status register from outside the isr takes an eighth
+of a character time, and enabling interrupts sometimes lets one pass, so
+interrupts also arrive at the points where the driver enables them.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_check.h"
+#include "uart.h"
+#include "defines.h"
+#include "plic_driver.h"
+#include "FreeRTOS.h"
+
+#define FIFO_DEPTH	16
+#define CHARS_PER_TICK	20
+#define WIRE_SIZE	65536
+#define INPUT_SIZE	65536
+#define MAX_WAIT_TICKS	1000000
+#define TASK_READS_PER_CHAR	8
+
+uint32_t uart_sim_regs[MAX_UART_COUNT * UART_OFFSET / 4];
+
+typedef struct
+{
+	uint8_t tx_fifo[FIFO_DEPTH];
+	unsigned int tx_count;
+	uint8_t rx_fifo[FIFO_DEPTH];
+	unsigned int rx_count;
+	int overrun;
+	int tx_stalled;
+	uint8_t wire[WIRE_SIZE];	/* bytes the uart has sent */
+	unsigned int wire_len;
+	uint8_t input[INPUT_SIZE];	/* bytes arriving at the uart */
+	unsigned int input_len;
+	unsigned int input_pos;
+	unsigned int hw_dropped;	/* arrived while the rx fifo was full */
+} sim_uart_t;
+
+static sim_uart_t sim_uart[MAX_UART_COUNT];
+static uint32_t plic_enabled;
+static uintptr_t mstatus = MSTATUS_MIE;
+static int in_isr;
+static BaseType_t scheduler_state = taskSCHEDULER_RUNNING;
+static TickType_t ticks;
+static uint32_t notify_count;
+
+static unsigned int isr_calls;
+static unsigned int waits;
+static unsigned int task_reg_accesses;
+static unsigned int storms;
+static unsigned int bad_accesses;
+
+/* Stand-ins for what uart.c uses from plic_driver.c and utils.c. */
+plic_fptr_t isr_table[PLIC_MAX_INTERRUPT_SRC];
+void interrupt_enable(uint32_t interrupt_id) { plic_enabled |= 1u << interrupt_id; }
+unsigned long read_word(uint32_t *addr) { (void) addr; return 0; }
+void write_word(uint32_t *addr, unsigned long val) { (void) addr; (void) val; }
+
+static void take_interrupts(void);
+
+/** @fn static unsigned int index_of(const void *instance)
+ * @brief returns the number of the uart whose registers are at instance
+ */
+static unsigned int index_of(const void *instance)
+{
+	return (unsigned int) (((uintptr_t) instance - (uintptr_t) uart_sim_regs) / UART_OFFSET);
+}
+
+/** @fn static uart_struct *regs_of(unsigned int n)
+ * @brief returns the registers of uart n
+ */
+static uart_struct *regs_of(unsigned int n)
+{
+	return (uart_struct *) ((uintptr_t) uart_sim_regs + n * UART_OFFSET);
+}
+
+/** @fn static uint32_t status_of(unsigned int n)
+ * @brief computes the status register of uart n
+ */
+static uint32_t status_of(unsigned int n)
+{
+	sim_uart_t *u = &sim_uart[n];
+	uint32_t status = 0;
+
+	if (u->tx_count == 0)
+		status |= STS_TX_EMPTY;
+	if (u->tx_count == FIFO_DEPTH)
+		status |= STS_TX_FULL;
+	if (u->rx_count != 0)
+		status |= STS_RX_NOT_EMPTY;
+	if (u->rx_count == FIFO_DEPTH)
+		status |= STS_RX_FULL;
+	if (u->overrun)
+		status |= OVERRUN;
+
+	return status;
+}
+
+/** @fn static int raised(unsigned int n)
+ * @brief tells whether uart n is raising its interrupt
+ */
+static int raised(unsigned int n)
+{
+	uint32_t status = status_of(n);
+	uint8_t ien = regs_of(n)->ien;
+
+	return ((ien & ENABLE_TX_EMPTY) && (status & STS_TX_EMPTY)) ||
+	       ((ien & ENABLE_RX_NOT_EMPTY) && (status & STS_RX_NOT_EMPTY)) ||
+	       ((ien & ENABLE_RX_FULL) && (status & STS_RX_FULL)) ||
+	       ((ien & ENABLE_OVERRUN) && (status & OVERRUN));
+}
+
+/** @fn static void step(void)
+ * @brief lets one character time pass on every uart
+ */
+static void step(void)
+{
+	unsigned int n;
+
+	for (n = 0; n < MAX_UART_COUNT; n++)
+	{
+		sim_uart_t *u = &sim_uart[n];
+
+		if (u->tx_count != 0 && !u->tx_stalled)
+		{
+			if (u->wire_len < WIRE_SIZE)
+				u->wire[u->wire_len++] = u->tx_fifo[0];
+			memmove(u->tx_fifo, u->tx_fifo + 1, --u->tx_count);
+		}
+
+		if (u->input_pos < u->input_len)
+		{
+			if (u->rx_count < FIFO_DEPTH)
+				u->rx_fifo[u->rx_count++] = u->input[u->input_pos];
+			else
+			{
+				u->overrun = 1;
+				u->hw_dropped++;
+			}
+			u->input_pos++;
+		}
+	}
+}
+
+uint32_t uart_sim_status(const void *instance)
+{
+	unsigned int n = index_of(instance);
+	uint32_t status;
+
+	/* Polling is slow next to the core but not to the line: a character
+	   time passes for every few reads. */
+	if (!in_isr && ++task_reg_accesses % TASK_READS_PER_CHAR == 0)
+		step();
+
+	status = status_of(n);
+	sim_uart[n].overrun = 0;
+
+	return status;
+}
+
+void uart_sim_write_tx(const void *instance, uint32_t ch)
+{
+	sim_uart_t *u = &sim_uart[index_of(instance)];
+
+	if (!in_isr)
+		task_reg_accesses++;
+
+	if (u->tx_count == FIFO_DEPTH)
+	{
+		bad_accesses++;
+		return;
+	}
+	u->tx_fifo[u->tx_count++] = (uint8_t) ch;
+}
+
+uint32_t uart_sim_read_rx(const void *instance)
+{
+	sim_uart_t *u = &sim_uart[index_of(instance)];
+	uint8_t ch;
+
+	if (!in_isr)
+		task_reg_accesses++;
+
+	if (u->rx_count == 0)
+	{
+		bad_accesses++;
+		return 0;
+	}
+	ch = u->rx_fifo[0];
+	memmove(u->rx_fifo, u->rx_fifo + 1, --u->rx_count);
+
+	return ch;
+}
+
+uintptr_t sim_csr_read(int csr)
+{
+	(void) csr;
+	return mstatus;
+}
+
+void sim_csr_set(int csr, uintptr_t bits)
+{
+	int enabling = (bits & MSTATUS_MIE) && !(mstatus & MSTATUS_MIE);
+
+	(void) csr;
+	mstatus |= bits;
+
+	/* An interrupt that became pending while they were disabled is taken
+	   as soon as they are enabled again, and sometimes one arrives then. */
+	if (enabling && !in_isr)
+	{
+		if (rand() % 4 == 0)
+			step();
+		take_interrupts();
+	}
+}
+
+void sim_csr_clear(int csr, uintptr_t bits)
+{
+	(void) csr;
+	mstatus &= ~bits;
+}
+
+/** @fn static void take_interrupts(void)
+ * @brief runs the isr of every uart raising its interrupt, while MIE is set
+ */
+static void take_interrupts(void)
+{
+	unsigned int n;
+
+	if (in_isr || !(mstatus & MSTATUS_MIE))
+		return;
+
+	for (n = 0; n < MAX_UART_COUNT; n++)
+	{
+		uint32_t id = PLIC_INTERRUPT_25 + n;
+
+		if (!(plic_enabled & (1u << id)) || !raised(n))
+			continue;
+
+		in_isr = 1;
+		mstatus &= ~MSTATUS_MIE;
+		isr_calls++;
+		isr_table[id](id);
+		mstatus |= MSTATUS_MIE;
+		in_isr = 0;
+
+		/* The interrupt is level triggered, so an isr that leaves it
+		   raised would be entered again straight away. */
+		if (raised(n))
+			storms++;
+	}
+}
+
+/** @fn static void run_chars(unsigned int count)
+ * @brief lets count character times pass, taking interrupts when they are
+ *        enabled. Stops early if the task is notified.
+ */
+static void run_chars(unsigned int count)
+{
+	static unsigned int chars;
+
+	while (count-- && notify_count == 0)
+	{
+		step();
+		take_interrupts();
+		if (++chars % CHARS_PER_TICK == 0)
+			ticks++;
+	}
+}
+
+/** @fn static void run_ticks(TickType_t count)
+ * @brief lets count ticks pass, taking interrupts when they are enabled
+ */
+static void run_ticks(TickType_t count)
+{
+	TickType_t end = ticks + count;
+
+	while (ticks < end)
+	{
+		run_chars(1);
+		notify_count = 0;
+	}
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+	return scheduler_state;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return (TaskHandle_t) &notify_count;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+	TickType_t start = ticks;
+	uint32_t count;
+
+	waits++;
+
+	/* The task runs again as soon as the isr notifies it. */
+	while (notify_count == 0)
+	{
+		if (xTicksToWait != portMAX_DELAY && ticks - start >= xTicksToWait)
+			return 0;
+		if (ticks - start == MAX_WAIT_TICKS)
+		{
+			printf("the task was never woken\n");
+			exit(1);
+		}
+		run_chars(1);
+	}
+
+	count = notify_count;
+	notify_count = xClearCountOnExit ? 0 : count - 1;
+
+	return count;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	if (xTaskToNotify != (TaskHandle_t) &notify_count || !in_isr)
+		bad_accesses++;
+
+	notify_count++;
+	*pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+void vTaskSetTimeOutState(TimeOut_t *pxTimeOut)
+{
+	pxTimeOut->xTimeOnEntering = ticks;
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *pxTimeOut, TickType_t *pxTicksToWait)
+{
+	TickType_t elapsed = ticks - pxTimeOut->xTimeOnEntering;
+
+	if (*pxTicksToWait == portMAX_DELAY)
+		return pdFALSE;
+
+	if (elapsed < *pxTicksToWait)
+	{
+		*pxTicksToWait -= elapsed;
+		pxTimeOut->xTimeOnEntering = ticks;
+		return pdFALSE;
+	}
+
+	*pxTicksToWait = 0;
+	return pdTRUE;
+}
+
+/** @fn static void feed(unsigned int n, const uint8_t *data, unsigned int len)
+ * @brief queues bytes to arrive at uart n, one per character time
+ */
+static void feed(unsigned int n, const uint8_t *data, unsigned int len)
+{
+	sim_uart_t *u = &sim_uart[n];
+
+	memcpy(u->input + u->input_len, data, len);
+	u->input_len += len;
+}
+
+/** @fn static void fill(uint8_t *buf, unsigned int len, unsigned int seed)
+ * @brief fills a buffer with a pattern that differs for each seed
+ */
+static void fill(uint8_t *buf, unsigned int len, unsigned int seed)
+{
+	unsigned int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (uint8_t) (i * 7 + seed * 13 + (i >> 8));
+}
+
+/** @fn static void reset(void)
+ * @brief puts the uarts, the hart and the counters back to their start
+ */
+static void reset(void)
+{
+	memset(sim_uart, 0, sizeof(sim_uart));
+	memset(uart_sim_regs, 0, sizeof(uart_sim_regs));
+	memset(isr_table, 0, sizeof(isr_table));
+	plic_enabled = 0;
+	mstatus = MSTATUS_MIE;
+	in_isr = 0;
+	scheduler_state = taskSCHEDULER_RUNNING;
+	notify_count = 0;
+	isr_calls = waits = task_reg_accesses = storms = bad_accesses = 0;
+
+	uart_init();
+	uart_enable_buffering(uart_instance[0]);
+}
+
+/** @fn static void check_model(void)
+ * @brief checks that the driver only used the uarts as the hardware allows
+ */
+static void check_model(void)
+{
+	check(storms == 0 && bad_accesses == 0,
+	      "the isr leaves no interrupt raised and no fifo is misused (%u, %u)",
+	      storms, bad_accesses);
+}
+
+static void test_write(void)
+{
+	static uint8_t data[4000];
+	uart_buffer_stats_t stats;
+	uint32_t n;
+
+	reset();
+	fill(data, sizeof(data), 1);
+
+	n = uart_write(uart_instance[0], data, sizeof(data), UART_WAIT_FOREVER);
+	run_ticks(20);
+	uart_get_buffer_stats(uart_instance[0], &stats);
+
+	check(n == sizeof(data) && sim_uart[0].wire_len == sizeof(data) &&
+	      memcmp(sim_uart[0].wire, data, sizeof(data)) == 0,
+	      "4000 written bytes are sent in order");
+	check(task_reg_accesses <= 2 * FIFO_DEPTH + 1, "the task only starts the uart (%u register accesses)",
+	      task_reg_accesses);
+	check(waits <= sizeof(data) / (UART_TX_RING_SIZE / 2) + 1,
+	      "the writer waits %u times, once per half ring", waits);
+	check(isr_calls <= sizeof(data) / FIFO_DEPTH + 2,
+	      "the isr runs %u times, once per fifo", isr_calls);
+	check(stats.tx_bytes == sizeof(data) && stats.tx_max_level == UART_TX_RING_SIZE &&
+	      stats.tx_timeouts == 0, "tx counters are %u bytes, %u peak, %u timeouts",
+	      stats.tx_bytes, stats.tx_max_level, stats.tx_timeouts);
+	check(!(regs_of(0)->ien & ENABLE_TX_EMPTY), "TX_EMPTY is disabled once the ring is sent");
+	check_model();
+}
+
+static void test_putchar(void)
+{
+	const char *text = "Temperature Value:25.12\n";
+	const char *c;
+
+	reset();
+
+	for (c = text; *c; c++)
+		putchar(*c);
+
+	check(waits == 0, "putchar queues without waiting");
+	run_ticks(2);
+	check(sim_uart[0].wire_len == strlen(text) &&
+	      memcmp(sim_uart[0].wire, text, strlen(text)) == 0, "and the text is sent");
+	check_model();
+}
+
+static void test_write_timeout(void)
+{
+	static uint8_t data[1000];
+	uart_buffer_stats_t stats;
+	TickType_t start;
+	uint32_t n;
+
+	reset();
+	fill(data, sizeof(data), 2);
+	sim_uart[0].tx_stalled = 1;
+
+	start = ticks;
+	n = uart_write(uart_instance[0], data, sizeof(data), 10);
+	uart_get_buffer_stats(uart_instance[0], &stats);
+
+	check(n == UART_TX_RING_SIZE + FIFO_DEPTH && ticks - start == 10,
+	      "a stalled uart takes %u bytes before a 10 tick timeout (%u ticks)",
+	      n, (unsigned int) (ticks - start));
+	check(stats.tx_timeouts == 1, "the timeout is counted");
+
+	n = uart_write(uart_instance[0], data, 1, 0);
+	check(n == 0, "a write with no timeout does not wait");
+
+	sim_uart[0].tx_stalled = 0;
+	run_ticks(20);
+	check(sim_uart[0].wire_len == UART_TX_RING_SIZE + FIFO_DEPTH &&
+	      memcmp(sim_uart[0].wire, data, sim_uart[0].wire_len) == 0,
+	      "the queued bytes are sent once it resumes");
+	check_model();
+}
+
+static void test_read(void)
+{
+	uint8_t data[300];
+	uint8_t got[300];
+	uart_buffer_stats_t stats;
+	uint32_t n;
+
+	reset();
+	fill(data, sizeof(data), 3);
+	feed(0, data, sizeof(data));
+
+	n = uart_read(uart_instance[0], got, sizeof(got), 1000);
+	uart_get_buffer_stats(uart_instance[0], &stats);
+
+	check(n == sizeof(data) && memcmp(got, data, sizeof(data)) == 0,
+	      "300 received bytes are read in order");
+	check(waits <= sizeof(data) / (UART_RX_RING_SIZE / 2) + 1,
+	      "the reader waits %u times, once per half ring", waits);
+	check(stats.rx_bytes == sizeof(data) && stats.rx_overflows == 0 && stats.rx_overruns == 0,
+	      "rx counters are %u bytes, %u overflows, %u overruns",
+	      stats.rx_bytes, stats.rx_overflows, stats.rx_overruns);
+	check_model();
+}
+
+static void test_read_timeout(void)
+{
+	uint8_t got[10];
+	uart_buffer_stats_t stats;
+	TickType_t start = ticks;
+	uint32_t n;
+
+	reset();
+	start = ticks;
+	n = uart_read(uart_instance[0], got, sizeof(got), 5);
+	uart_get_buffer_stats(uart_instance[0], &stats);
+
+	check(n == 0 && ticks - start == 5 && stats.rx_timeouts == 1,
+	      "a read with nothing to read times out after 5 ticks (%u)",
+	      (unsigned int) (ticks - start));
+
+	feed(0, (const uint8_t *) "abc", 3);
+	n = uart_read(uart_instance[0], got, sizeof(got), 5);
+	check(n == 3 && memcmp(got, "abc", 3) == 0, "and a short read returns what came");
+	check_model();
+}
+
+static void test_rx_overflow(void)
+{
+	uint8_t data[300];
+	uint8_t got[300];
+	uart_buffer_stats_t stats;
+	uint32_t n;
+
+	reset();
+	fill(data, sizeof(data), 4);
+	feed(0, data, sizeof(data));
+	run_ticks(sizeof(data) / CHARS_PER_TICK + 1);
+
+	n = uart_read(uart_instance[0], got, sizeof(got), 0);
+	uart_get_buffer_stats(uart_instance[0], &stats);
+
+	check(n == UART_RX_RING_SIZE && memcmp(got, data, n) == 0,
+	      "an unread ring keeps the first %u bytes", n);
+	check(stats.rx_overflows == sizeof(data) - UART_RX_RING_SIZE && stats.rx_max_level == UART_RX_RING_SIZE,
+	      "and counts the %u it dropped", stats.rx_overflows);
+	check(sim_uart[0].hw_dropped == 0, "the fifo itself never overran");
+	check_model();
+}
+
+static void test_overrun(void)
+{
+	uint8_t data[40];
+	uint8_t got[40];
+	uart_buffer_stats_t stats;
+	uint32_t n;
+
+	reset();
+	fill(data, sizeof(data), 5);
+	feed(0, data, sizeof(data));
+
+	/* Keep interrupts off while the bytes arrive, as a long critical
+	   section would. */
+	sim_csr_clear(SIM_CSR_mstatus, MSTATUS_MIE);
+	run_ticks(3);
+	sim_csr_set(SIM_CSR_mstatus, MSTATUS_MIE);
+
+	n = uart_read(uart_instance[0], got, sizeof(got), 0);
+	uart_get_buffer_stats(uart_instance[0], &stats);
+
+	check(n == FIFO_DEPTH && memcmp(got, data, n) == 0, "the fifo keeps %u bytes", n);
+	check(stats.rx_overruns == 1, "and the isr counts the overrun it reports");
+	check_model();
+}
+
+static void test_polled(void)
+{
+	static uint8_t data[600];
+	uint32_t n;
+
+	reset();
+	fill(data, sizeof(data), 6);
+
+	scheduler_state = taskSCHEDULER_NOT_STARTED;
+	n = uart_write(uart_instance[0], data, sizeof(data), UART_WAIT_FOREVER);
+	check(n == sizeof(data) && sim_uart[0].wire_len + sim_uart[0].tx_count == sizeof(data) &&
+	      waits == 0, "before the scheduler starts a write is polled out (%u sent)",
+	      sim_uart[0].wire_len);
+
+	scheduler_state = taskSCHEDULER_RUNNING;
+	run_ticks(2);
+	sim_csr_clear(SIM_CSR_mstatus, MSTATUS_MIE);
+	n = uart_write(uart_instance[0], data, 100, 0);
+	check(n == 100 && waits == 0 && sim_uart[0].tx_count + sim_uart[0].wire_len == sizeof(data) + 100,
+	      "and so is a write with interrupts disabled");
+	sim_csr_set(SIM_CSR_mstatus, MSTATUS_MIE);
+	run_ticks(10);
+
+	check(sim_uart[0].wire_len == sizeof(data) + 100 &&
+	      memcmp(sim_uart[0].wire, data, sizeof(data)) == 0 &&
+	      memcmp(sim_uart[0].wire + sizeof(data), data, 100) == 0, "both are sent in order");
+	check_model();
+}
+
+static void test_second_uart(void)
+{
+	uint8_t data[200];
+	uint8_t got[200];
+	uint32_t n;
+
+	reset();
+	fill(data, sizeof(data), 7);
+
+	check(uart_write(uart_instance[1], data, 1, 0) == 0, "an unbuffered uart is refused");
+
+	uart_enable_buffering(uart_instance[1]);
+	feed(1, data, sizeof(data));
+	n = uart_write(uart_instance[1], data, sizeof(data), UART_WAIT_FOREVER);
+	n += uart_read(uart_instance[1], got, sizeof(got), 100);
+	run_ticks(20);
+
+	check(n == 2 * sizeof(data) && memcmp(got, data, sizeof(data)) == 0 &&
+	      sim_uart[1].wire_len == sizeof(data) && memcmp(sim_uart[1].wire, data, sizeof(data)) == 0,
+	      "uart 1 sends and receives on its own source");
+	check(sim_uart[0].wire_len == 0, "without touching uart 0");
+	check_model();
+}
+
+static void test_random(void)
+{
+	static uint8_t sent[INPUT_SIZE];
+	static uint8_t data[INPUT_SIZE];
+	static uint8_t got[INPUT_SIZE];
+	unsigned int sent_len = 0;
+	unsigned int got_len = 0;
+	uart_buffer_stats_t stats;
+	unsigned int i, j;
+	int round;
+
+	reset();
+	srand(1);
+	fill(data, 20000, 8);
+	feed(0, data, 20000);
+
+	for (round = 0; round < 2000; round++)
+	{
+		uint32_t len = (uint32_t) (rand() % 200);
+		uint32_t timeout = (uint32_t) (rand() % 4);
+
+		if (rand() % 2)
+		{
+			if (sent_len + len > sizeof(sent))
+				continue;
+			fill(sent + sent_len, len, (unsigned int) round);
+			sent_len += uart_write(uart_instance[0], sent + sent_len, len, timeout);
+		}
+		else
+		{
+			if (got_len + len > sizeof(got))
+				continue;
+			got_len += uart_read(uart_instance[0], got + got_len, len, timeout);
+		}
+	}
+
+	while (sim_uart[0].input_pos < sim_uart[0].input_len)
+		got_len += uart_read(uart_instance[0], got + got_len, sizeof(got) - got_len, 1);
+	got_len += uart_read(uart_instance[0], got + got_len, sizeof(got) - got_len, 0);
+	run_ticks(200);
+	uart_get_buffer_stats(uart_instance[0], &stats);
+
+	/* The one task also writes, so it sometimes reads too late and the
+	   ring overflows. What it does read must still be in order. */
+	for (i = 0, j = 0; i < got_len && j < 20000; j++)
+	{
+		if (got[i] == data[j])
+			i++;
+	}
+
+	check(sim_uart[0].wire_len == sent_len && memcmp(sim_uart[0].wire, sent, sent_len) == 0,
+	      "random writes send all %u bytes they queued, in order", sent_len);
+	check(got_len + stats.rx_overflows == 20000 && i == got_len && sim_uart[0].hw_dropped == 0,
+	      "random reads receive %u bytes in order, and %u are counted as dropped",
+	      got_len, stats.rx_overflows);
+	check_model();
+}
+
+int main(void)
+{
+	printf("uart.c with a %u byte tx ring and a %u byte rx ring\n",
+	       UART_TX_RING_SIZE, UART_RX_RING_SIZE);
+
+	test_write();
+	test_putchar();
+	test_write_timeout();
+	test_read();
+	test_read_timeout();
+	test_rx_overflow();
+	test_overrun();
+	test_polled();
+	test_second_uart();
+	test_random();
+
+	return check_summary();
+}
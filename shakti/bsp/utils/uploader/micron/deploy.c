@@ -32,7 +32,6 @@
 #include "flashdata.h"
 
 #define DEBUG 1
-#define ERASE 1024
 
 extern int  status;
 
@@ -67,22 +66,16 @@ void deploy()
 	status = wait_for_wip();
 	printf("\t qspi write  status register %08x\n",status);
 
-	for(i=0;i<= write_data[0];i+=4)
-	{
-		if(i%ERASE==0)
-		{
-			eraseSector(0x21, write_address);
-		}
-
-		printf("%x %x %x %x %d\n", write_data[i], write_data[i+1],
-		       write_data[i+2], write_data[i+3], write_address);
-
-		pageProgramQuadSPI(write_data[i], write_data[i+1],
-				   write_data[i+2], write_data[i+3],
-				   write_address);
-		write_address+=16;
+	/* write_data[0] holds the word count, rounded up to whole 16 byte groups */
+	size_byte = (write_data[0]/4 + 1) * 16;
+
+	if(flashWriteQuadSPI(write_address, (const uint8_t*) write_data, size_byte, 1)){
+		printf("\t Flash write failed\n");
+		return -1;
 	}
 
+	printf("\t %d bytes written to flash\n", size_byte);
+
 #if DEBUG
 	waitfor(400);
 
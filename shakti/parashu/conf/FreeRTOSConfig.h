@@ -89,7 +89,9 @@ extern uint32_t SystemCoreClock;
 
 #define configUSE_PREEMPTION			1
 #define configUSE_IDLE_HOOK				0
+#ifndef configUSE_TICK_HOOK
 #define configUSE_TICK_HOOK				0
+#endif
 #define configCPU_CLOCK_HZ			( ( unsigned long ) 50000000 )
 #define configTICK_CLOCK_HZ			( ( unsigned long ) 500000 )
 #define configTICK_RATE_HZ			( ( TickType_t ) 500 )
@@ -1,5 +1,6 @@
 #include "FreeRTOS.h"
 #include "task.h"
+#include "log.h"
 //#include "uart.h"
 #include "utils.h"
 #include "gpio.h"
@@ -23,12 +24,14 @@ void vApplicationIdleHook( void );
 void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName );
 
 void vTaskgpio(__attribute__((unused)) void *pvParameters);
+void vTasklog(__attribute__((unused)) void *pvParameters);
 
 /*-----------------------------------------------------------*/
 
 int main( void )
 {
 	xTaskCreate(vTaskgpio,"Task 1",500,NULL,1,NULL);
+	xTaskCreate(vTasklog,"Log",500,NULL,tskIDLE_PRIORITY,NULL);
 
 	/* Task scheduledd with help of clint */
 	vTaskStartScheduler();
@@ -63,6 +66,22 @@ void vTaskgpio(__attribute__((unused)) void *pvParameters)
 		/* Delay for a period. */
 	}
 }
+/*-----------------------------------------------------------*/
+
+/*
+   Print the logs that interrupt handlers save with the log_isr_ calls, so
+   that no handler waits on the uart.
+ */
+void vTasklog(__attribute__((unused)) void *pvParameters)
+{
+	const TickType_t xDelay100ms = pdMS_TO_TICKS(100);
+
+	for( ;; )
+	{
+		log_isr_drain();
+		vTaskDelay(xDelay100ms);
+	}
+}
 
 void vApplicationMallocFailedHook( void )
 {
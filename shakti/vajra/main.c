@@ -9,6 +9,15 @@
 #include "spi.h"
 #include <stdint.h> 
 #include "i2c.h"
+#ifdef BMP280_SERVICE
+#include "bmp280.h"
+#endif
+#ifdef CLINT_TIMER
+#include "clint_timer.h"
+#endif
+#if defined(UART_BUFFERED) || defined(I2C_ASYNC)
+#include "plic_driver.h"
+#endif
 
 #define I2C i2c_instance[1]
 
@@ -35,6 +44,7 @@
 #define BMP280_REG_DIG_P7 0x9A
 #define BMP280_REG_DIG_P8 0x9C
 #define BMP280_REG_DIG_P9 0x9E
+#define BMP280_CALIB_LEN 24
 
 uint32_t gpress = 0;
 uint32_t gtemp = 0;
@@ -71,6 +81,31 @@ int write_bmp280_register(i2c_struct*, uint32_t, unsigned char, uint32_t);
 int read_bmp280_values(i2c_struct*, uint32_t, uint32_t*, uint32_t*, uint32_t);
 short read_bmp280_values16(i2c_struct*, uint32_t, uint32_t);
 int read_bmp280_register(i2c_struct*, uint32_t, uint32_t*, uint32_t);
+#ifdef I2C_ASYNC
+int read_bmp280_block(i2c_struct*, uint32_t, unsigned char*, uint32_t);
+
+/** @fn int read_bmp280_block(i2c_struct *instance, uint32_t reg_offset, unsigned char *buf, uint32_t len)
+ * @brief Reads consecutive registers of the bmp280 in one transaction.
+ * @details The transaction is queued with i2c_transfer, and the task sleeps
+ * until the i2c interrupt has carried it out, or for at most 100 ms.
+ * @param i2c_struct *instance  It uses i2c_instance[1].
+ * @param uint32_t reg_offset  First register to read.
+ * @param unsigned char *buf  Buffer for the register values.
+ * @param uint32_t len  Number of registers to read.
+ * @return Zero on success, else the error from i2c_transfer.
+ */
+int read_bmp280_block(i2c_struct *instance, uint32_t reg_offset, unsigned char *buf, uint32_t len)
+{
+	i2c_xfer_t xfer = { 0 };
+
+	xfer.slave_address = BMP280_SLAVE_ADDRESS;
+	xfer.reg = (unsigned char) reg_offset;
+	xfer.read_data = buf;
+	xfer.read_len = len;
+
+	return i2c_transfer(instance, &xfer, pdMS_TO_TICKS(100));
+}
+#endif
 
  /** @fn int read_bmp280_register(i2c_struct *instance, uint32_t reg_offset, uint32_t *readTemp, uint32_t delay) 
  * @brief It helps to read the register value of the bmp280.
@@ -129,6 +164,11 @@ int read_bmp280_values(i2c_struct * instance, uint32_t reg_offset,
 	int32_t temp;
 	int32_t p;
 
+#ifdef I2C_ASYNC
+	(void) delay;
+	if (read_bmp280_block(instance, reg_offset, read_buf, sizeof(read_buf)))
+		return -1;
+#else
 	//Writes the slave address for write
 	i2c_send_slave_address(instance, BMP280_SLAVE_ADDRESS, I2C_WRITE, 800);
 
@@ -156,6 +196,7 @@ int read_bmp280_values(i2c_struct * instance, uint32_t reg_offset,
 	i2c_read_data(instance, &read_buf[5], delay);
 
 	instance->control = I2C_STOP;
+#endif
 	adc_P = ((read_buf[0] << 12) | (read_buf[1] << 4) | (read_buf[2] >> 4));
 	adc_T = ((read_buf[3] << 12) | (read_buf[4] << 4) | (read_buf[5] >> 4));
 
@@ -277,7 +318,15 @@ void vApplicationIdleHook( void );
  */
 void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName );
 
+#ifdef CLINT_TIMER
+/*
+ * FreeRTOS hook called from each tick, enabled by make CLINT_TIMER=1.
+ */
+void vApplicationTickHook( void );
+#endif
+
 void vTaskgpio(__attribute__((unused)) void *pvParameters);
+void vTasklog(__attribute__((unused)) void *pvParameters);
 void vTaskspiwrite(__attribute__((unused)) void *pvParameters);
 void vTaskbmp280(__attribute__((unused)) void *pvParameters);
 /*-----------------------------------------------------------*/
@@ -290,10 +339,26 @@ int main(void)
 	   Based on temperature, we control the gpio pin.
 	 */
 
+#if defined(UART_BUFFERED) || defined(I2C_ASYNC)
+	plic_init();
+#endif
+#ifdef UART_BUFFERED
+	/* Let the uart interrupt send what the tasks print */
+	uart_enable_buffering(uart_instance[0]);
+#endif
+#ifdef CLINT_TIMER
+	/* Measure the core clock for ndelay() before any task runs */
+	timer_init();
+#endif
+
 	printf("FREERTOS starting\n");
+#ifdef CLINT_TIMER
+	printf("Core clock %u Hz\n", (unsigned int) timer_cpu_hz());
+#endif
 
 	xTaskCreate(vTaskbmp280,"Task 3",500,NULL,1,NULL);
 	xTaskCreate(vTaskgpio,"Task 1",500,NULL,1,NULL);
+	xTaskCreate(vTasklog,"Log",500,NULL,tskIDLE_PRIORITY,NULL);
 	xTaskCreate(vTaskspiwrite,"Task 2",500,NULL,1,NULL);
 
 	printf("Task scheduler started\n");	/* Task scheduledd with help of
@@ -304,6 +369,54 @@ int main(void)
 	return 0;
 }
 /*-----------------------------------------------------------*/
+#ifdef BMP280_SERVICE
+static bmp280_t bmp280;
+
+void vTaskbmp280(__attribute__((unused)) void *pvParameters )
+{
+	/* Forced mode at x1 every 10 ms, as the polled loop below */
+	const bmp280_config_t config = { BMP280_MODE_FORCED, BMP280_OSRS_X1, BMP280_OSRS_X1,
+					 BMP280_FILTER_OFF, BMP280_STANDBY_0_5_MS, 10 };
+	QueueHandle_t samples = xQueueCreate(4, sizeof(bmp280_sample_t));
+	bmp280_sample_t sample;
+	int temp;
+
+	i2c_init();
+
+	//Initialises I2C Controller
+	if(samples == NULL || config_i2c(I2C, PRESCALER_COUNT,SCLK_COUNT))
+	{
+		log_error("\tSomething Wrong In Initialization\n");
+		vTaskDelete(NULL);
+	}
+
+#ifdef I2C_ASYNC
+	/* Let the i2c interrupt carry out the transactions */
+	i2c_enable_async(I2C);
+#endif
+
+	if (bmp280_init(&bmp280, I2C, &config) ||
+	    bmp280_start_task(&bmp280, samples, tskIDLE_PRIORITY + 2, 500))
+	{
+		printf("\n Device Not detected");
+		vTaskDelete(NULL);
+	}
+
+	/* The sampling task measures; this one publishes the samples */
+	for( ;; )
+	{
+		xQueueReceive(samples, &sample, portMAX_DELAY);
+
+		gtemp = sample.temperature;
+		gpress = sample.pressure >> 8;
+
+		temp = sample.temperature < 0 ? -sample.temperature : sample.temperature;
+		printf("\nTemperature Value:%s%d.%d%d °C", sample.temperature < 0 ? "-" : "",
+		       temp / 100, (temp / 10) % 10, temp % 10);
+		printf("\nThe Pressure Value:%u Pa", (unsigned int) gpress);
+	}
+}
+#else
 void vTaskbmp280(__attribute__((unused)) void *pvParameters )
 {
 	const TickType_t xDelay1000ms = pdMS_TO_TICKS( 10 );
@@ -322,6 +435,11 @@ void vTaskbmp280(__attribute__((unused)) void *pvParameters )
 	else
 		log_info("\tIntilization BMP280_STATUS_REGISTER Happened Fine\n");
 
+#ifdef I2C_ASYNC
+	/* Let the i2c interrupt carry out the transactions */
+	i2c_enable_async(I2C);
+#endif
+
 	write_bmp280_register(I2C, BMP280_CONFIG_REGISTER, 0xC0, delay);
 	write_bmp280_register(I2C, BMP280_CTRL_MEANS, 0x27, delay);
 
@@ -337,6 +455,33 @@ void vTaskbmp280(__attribute__((unused)) void *pvParameters )
 	write_bmp280_register(I2C, BMP280_RESET_REGISTER, 0xB6, delay);
 	read_bmp280_register(I2C, BMP280_RESET_REGISTER, &tempReadValue, delay);
 
+#ifdef I2C_ASYNC
+	{
+		/* dig_T1 to dig_P9 in one 24 byte read, least significant
+		   byte first */
+		unsigned char calib[BMP280_CALIB_LEN];
+
+		if (read_bmp280_block(I2C, BMP280_REG_DIG_T1, calib, BMP280_CALIB_LEN))
+		{
+			log_error("\nCalibration read failed.");
+			return;
+		}
+
+		bmp280_calib_dig_T1 = (uint16_t) ((calib[1] << 8) | calib[0]);
+		bmp280_calib_dig_T2 = (int16_t) ((calib[3] << 8) | calib[2]);
+		bmp280_calib_dig_T3 = (int16_t) ((calib[5] << 8) | calib[4]);
+
+		bmp280_calib_dig_P1 = (uint16_t) ((calib[7] << 8) | calib[6]);
+		bmp280_calib_dig_P2 = (int16_t) ((calib[9] << 8) | calib[8]);
+		bmp280_calib_dig_P3 = (int16_t) ((calib[11] << 8) | calib[10]);
+		bmp280_calib_dig_P4 = (int16_t) ((calib[13] << 8) | calib[12]);
+		bmp280_calib_dig_P5 = (int16_t) ((calib[15] << 8) | calib[14]);
+		bmp280_calib_dig_P6 = (int16_t) ((calib[17] << 8) | calib[16]);
+		bmp280_calib_dig_P7 = (int16_t) ((calib[19] << 8) | calib[18]);
+		bmp280_calib_dig_P8 = (int16_t) ((calib[21] << 8) | calib[20]);
+		bmp280_calib_dig_P9 = (int16_t) ((calib[23] << 8) | calib[22]);
+	}
+#else
 	bmp280_calib_dig_T1 = read_bmp280_values16(I2C, BMP280_REG_DIG_T1, delay);
 	bmp280_calib_dig_T2 = read_bmp280_values16(I2C, BMP280_REG_DIG_T2, delay);
 	bmp280_calib_dig_T3 = read_bmp280_values16(I2C, BMP280_REG_DIG_T3, delay);
@@ -350,6 +495,7 @@ void vTaskbmp280(__attribute__((unused)) void *pvParameters )
 	bmp280_calib_dig_P7 = read_bmp280_values16(I2C, BMP280_REG_DIG_P7, delay);
 	bmp280_calib_dig_P8 = read_bmp280_values16(I2C, BMP280_REG_DIG_P8, delay);
 	bmp280_calib_dig_P9 = read_bmp280_values16(I2C, BMP280_REG_DIG_P9, delay);
+#endif
 
 	/* As per most tasks, this task is implemented in an infinite loop. */
 	for( ;; )
@@ -376,6 +522,7 @@ void vTaskbmp280(__attribute__((unused)) void *pvParameters )
 		/* Delay for a period. */
 	}
 }
+#endif
 
 static void spi_write(void)
 {
@@ -446,6 +593,22 @@ void vTaskgpio(__attribute__((unused)) void *pvParameters)
 		/* Delay for a period. */
 	}
 }
+/*-----------------------------------------------------------*/
+
+/*
+   Print the logs that interrupt handlers save with the log_isr_ calls, so
+   that no handler waits on the uart.
+ */
+void vTasklog(__attribute__((unused)) void *pvParameters)
+{
+	const TickType_t xDelay100ms = pdMS_TO_TICKS(100);
+
+	for( ;; )
+	{
+		log_isr_drain();
+		vTaskDelay(xDelay100ms);
+	}
+}
 
 /*-----------------------------------------------------------*/
 
@@ -492,3 +655,13 @@ void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName )
 	for( ;; );
 }
 /*-----------------------------------------------------------*/
+
+#ifdef CLINT_TIMER
+void vApplicationTickHook( void )
+{
+	/* The kernel's tick owns mtimecmp, so the timer alarms are run from here */
+	timer_alarm_tick();
+}
+/*-----------------------------------------------------------*/
+#endif
+